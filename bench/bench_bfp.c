@@ -0,0 +1,176 @@
+/*
+bench_bfp
+- Times multiplying and adding a million values with a big dynamic range (magnitudes from 2^-7 to 2^7, changing
+  slowly, like a spectrum), in nanoseconds per value: plain Q15.16 (`int64_t` products, rounded half up) vs. block
+  floating point with 32-bit and 16-bit mantissas and 32-value blocks.
+- Also prints each one's RMS relative error against doubles: Q15.16 loses most of the small values, while the
+  blocks keep nearly their mantissas' full precision everywhere.
+*/
+
+// For clock_gettime() when compiling with -std=c99.
+#define _POSIX_C_SOURCE 200112L
+
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "fixed_point_bfp.h"
+
+#define NUM_VALUES (1 << 20)
+#define NUM_PASSES 20
+#define BLOCK_SIZE 32
+
+static double a[NUM_VALUES];
+static double b[NUM_VALUES];
+static double exact[NUM_VALUES];
+static double result[NUM_VALUES];
+static int32_t fixed_a[NUM_VALUES];
+static int32_t fixed_b[NUM_VALUES];
+static int32_t fixed_out[NUM_VALUES];
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec*1e9 + (double)ts.tv_nsec;
+}
+
+static void print_result(const char * name, double start, int num_passes, uint32_t checksum)
+{
+    printf("%-40s %7.3f ns/value  (checksum %08x)\n", name,
+           (now_ns() - start)/((double)NUM_VALUES*num_passes), checksum);
+}
+
+static void print_error(const char * name)
+{
+    double sum = 0;
+    for (size_t i = 0; i < NUM_VALUES; i++)
+    {
+        double error = (result[i] - exact[i])/exact[i];
+        sum += error*error;
+    }
+    printf("%-40s %.3e RMS relative error\n", name, sqrt(sum/NUM_VALUES));
+}
+
+static uint32_t checksum_of(const int32_t * values, size_t n)
+{
+    uint32_t checksum = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        checksum += (uint32_t)values[i] ^ (uint32_t)i;
+    }
+    return checksum;
+}
+
+static uint32_t checksum_of_bfp(const fixed_bfp_t * bfp)
+{
+    uint32_t checksum = checksum_of((const int32_t *)bfp->exponents, bfp->num_blocks/2);
+    if (bfp->mantissa_bits == 32)
+    {
+        return checksum + checksum_of(bfp->mantissas32, bfp->size);
+    }
+    return checksum + checksum_of((const int32_t *)bfp->mantissas16, bfp->size/2);
+}
+
+static void run_q16(bool add)
+{
+    for (size_t i = 0; i < NUM_VALUES; i++)
+    {
+        fixed_a[i] = (int32_t)floor(a[i]*(1 << FRACTION_BITS) + 0.5);
+        fixed_b[i] = (int32_t)floor(b[i]*(1 << FRACTION_BITS) + 0.5);
+    }
+    double start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        if (add)
+        {
+            for (size_t i = 0; i < NUM_VALUES; i++)
+            {
+                fixed_out[i] = fixed_a[i] + fixed_b[i];
+            }
+        }
+        else
+        {
+            for (size_t i = 0; i < NUM_VALUES; i++)
+            {
+                // (int64_t / 2^16 by multiplying, to stay clear of right-shifting negative numbers.)
+                int64_t product = (int64_t)fixed_a[i]*fixed_b[i] + ((int64_t)1 << (FRACTION_BITS - 1));
+                fixed_out[i] = (int32_t)((product - (product & 0xFFFF))/(1 << FRACTION_BITS));
+            }
+        }
+    }
+    print_result(add ? "Q15.16 add" : "Q15.16 mul", start, NUM_PASSES, checksum_of(fixed_out, NUM_VALUES));
+    for (size_t i = 0; i < NUM_VALUES; i++)
+    {
+        result[i] = fixed_out[i]/(double)(1 << FRACTION_BITS);
+    }
+    print_error(add ? "Q15.16 add" : "Q15.16 mul");
+}
+
+static int run_bfp(unsigned mantissa_bits, bool add)
+{
+    fixed_bfp_t bfp_a;
+    fixed_bfp_t bfp_b;
+    fixed_bfp_t bfp_out;
+    if (!fixed_bfp_init(&bfp_a, NUM_VALUES, BLOCK_SIZE, mantissa_bits, NULL)
+        || !fixed_bfp_init(&bfp_b, NUM_VALUES, BLOCK_SIZE, mantissa_bits, NULL)
+        || !fixed_bfp_init(&bfp_out, NUM_VALUES, BLOCK_SIZE, mantissa_bits, NULL))
+    {
+        fprintf(stderr, "fixed_bfp_init() failed\n");
+        return 1;
+    }
+    fixed_bfp_from_double(&bfp_a, a);
+    fixed_bfp_from_double(&bfp_b, b);
+
+    char name[64];
+    snprintf(name, sizeof(name), "block floating point %u-bit %s", mantissa_bits, add ? "add" : "mul");
+    double start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        if (add)
+        {
+            fixed_bfp_add(&bfp_out, &bfp_a, &bfp_b);
+        }
+        else
+        {
+            fixed_bfp_mul(&bfp_out, &bfp_a, &bfp_b);
+        }
+    }
+    print_result(name, start, NUM_PASSES, checksum_of_bfp(&bfp_out));
+    fixed_bfp_to_double(&bfp_out, result);
+    print_error(name);
+
+    fixed_bfp_free(&bfp_a);
+    fixed_bfp_free(&bfp_b);
+    fixed_bfp_free(&bfp_out);
+    return 0;
+}
+
+int main(void)
+{
+    uint64_t seed = 12345;
+    for (size_t i = 0; i < NUM_VALUES; i++)
+    {
+        seed = seed*6364136223846793005ull + 1442695040888963407ull;
+        // A magnitude that sweeps from 2^-7 to 2^7 and back every 4096 values, times noise in [0.5, 1.5), with a
+        // random sign. b follows a at about 1/3 of its magnitude, so their sums don't cancel out to nearly 0.
+        double magnitude = ldexp(1.0, (int)(7*sin((double)i*(6.283185307179586/4096))));
+        double noise = 0.5 + (double)(seed >> 11)/9007199254740992.0;
+        a[i] = (seed & 1 ? -1 : 1)*magnitude*noise;
+        b[i] = a[i]*(0.25 + 0.125*noise);
+    }
+
+    for (int add = 0; add <= 1; add++)
+    {
+        for (size_t i = 0; i < NUM_VALUES; i++)
+        {
+            exact[i] = add ? a[i] + b[i] : a[i]*b[i];
+        }
+        run_q16(add);
+        if (run_bfp(32, add) != 0 || run_bfp(16, add) != 0)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
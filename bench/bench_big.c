@@ -0,0 +1,113 @@
+/*
+bench_big
+- Times fixed_point_big's multi-limb arithmetic, in nanoseconds per operation: schoolbook vs. Karatsuba multiplication
+  at several sizes (to pick FIXED_BIG_KARATSUBA_LIMBS), and 256-bit (Q128.128) rounded multiply, divide, and
+  formatting.
+*/
+
+// For clock_gettime() when compiling with -std=c99.
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <time.h>
+
+#include "fixed_point_big.h"
+
+#define NUM_VALUES 64
+
+static uint32_t a[NUM_VALUES][FIXED_BIG_MAX_LIMBS];
+static uint32_t b[NUM_VALUES][FIXED_BIG_MAX_LIMBS];
+static uint32_t product[2*FIXED_BIG_MAX_LIMBS];
+static char text[FIXED_BIG_FORMAT_LEN(FIXED_BIG_MAX_LIMBS, 40)];
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec*1e9 + (double)ts.tv_nsec;
+}
+
+static void print_result(const char * name, size_t num_limbs, double start, int num_ops, uint32_t checksum)
+{
+    printf("%-28s %2zu limbs %9.1f ns/op  (checksum %08x)\n", name, num_limbs, (now_ns() - start)/num_ops,
+           checksum);
+}
+
+int main(void)
+{
+    uint64_t seed = 12345;
+    for (size_t i = 0; i < NUM_VALUES; i++)
+    {
+        for (size_t j = 0; j < FIXED_BIG_MAX_LIMBS; j++)
+        {
+            seed = seed*6364136223846793005ull + 1442695040888963407ull;
+            a[i][j] = (uint32_t)(seed >> 32);
+            seed = seed*6364136223846793005ull + 1442695040888963407ull;
+            b[i][j] = (uint32_t)(seed >> 32);
+        }
+    }
+
+    static const size_t sizes[] = {4, 8, 16, 24, 32};
+    for (size_t size = 0; size < sizeof(sizes)/sizeof(sizes[0]); size++)
+    {
+        size_t num_limbs = sizes[size];
+        int num_ops = (int)(4000000 / (num_limbs*num_limbs));
+
+        uint32_t checksum = 0;
+        double start = now_ns();
+        for (int op = 0; op < num_ops; op++)
+        {
+            fixed_big_mul_schoolbook(product, a[op % NUM_VALUES], b[op % NUM_VALUES], num_limbs);
+            checksum += product[num_limbs];
+        }
+        print_result("fixed_big_mul_schoolbook()", num_limbs, start, num_ops, checksum);
+
+        checksum = 0;
+        start = now_ns();
+        for (int op = 0; op < num_ops; op++)
+        {
+            fixed_big_mul_karatsuba(product, a[op % NUM_VALUES], b[op % NUM_VALUES], num_limbs);
+            checksum += product[num_limbs];
+        }
+        print_result("fixed_big_mul_karatsuba()", num_limbs, start, num_ops, checksum);
+    }
+
+    // Q128.128, as in a settlement calculation's intermediates. Keep the operands' whole parts small, so the
+    // products and quotients don't just saturate.
+    size_t num_limbs = 8;
+    for (size_t i = 0; i < NUM_VALUES; i++)
+    {
+        a[i][5] = a[i][6] = a[i][7] = 0;
+        b[i][5] = b[i][6] = b[i][7] = 0;
+    }
+    int num_ops = 200000;
+    uint32_t out[8];
+
+    uint32_t checksum = 0;
+    double start = now_ns();
+    for (int op = 0; op < num_ops; op++)
+    {
+        fixed_big_mul(out, a[op % NUM_VALUES], b[op % NUM_VALUES], num_limbs, 128, FIXED_ROUND_HALF_EVEN);
+        checksum += out[0];
+    }
+    print_result("fixed_big_mul() Q128.128", num_limbs, start, num_ops, checksum);
+
+    checksum = 0;
+    start = now_ns();
+    for (int op = 0; op < num_ops; op++)
+    {
+        fixed_big_div(out, a[op % NUM_VALUES], b[op % NUM_VALUES], num_limbs, 128, FIXED_ROUND_HALF_EVEN);
+        checksum += out[0];
+    }
+    print_result("fixed_big_div() Q128.128", num_limbs, start, num_ops, checksum);
+
+    checksum = 0;
+    start = now_ns();
+    for (int op = 0; op < num_ops / 10; op++)
+    {
+        checksum += (uint32_t)fixed_big_format(a[op % NUM_VALUES], num_limbs, 128, 40, text);
+        checksum += (uint32_t)text[10];
+    }
+    print_result("fixed_big_format() 40 digits", num_limbs, start, num_ops / 10, checksum);
+    return 0;
+}
@@ -0,0 +1,135 @@
+/*
+bench_codec
+- Times encoding and decoding streams of fixed-point numbers with fixed_point_codec, in nanoseconds per value, vs.
+  copying the raw 4-byte values with memcpy(), and reports how much smaller the encoded streams are, for 2 kinds of
+  data: prices that move in ticks of 0.01, and a slowly drifting sensor reading with a little noise.
+*/
+
+// For clock_gettime() when compiling with -std=c99.
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "fixed_point.h"
+#include "fixed_point_codec.h"
+
+#define NUM_VALUES (1 << 20)
+#define NUM_PASSES 20
+
+static fixed_point_t values[NUM_VALUES];
+static fixed_point_t decoded[NUM_VALUES];
+static uint32_t seed = 12345;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec*1e9 + (double)ts.tv_nsec;
+}
+
+static uint32_t random_u16(void)
+{
+    seed = seed*1664525 + 1013904223;
+    return seed >> 16;
+}
+
+static void print_result(const char * name, double start, double count, uint32_t checksum)
+{
+    printf("  %-38s %7.3f ns/value  (checksum %08x)\n", name, (now_ns() - start)/count, (unsigned)checksum);
+}
+
+static bool run(const char * name, uint8_t * encoded, size_t max_size)
+{
+    printf("%s:\n", name);
+    size_t size = 0;
+    double start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        size = fixed_codec_encode(values, NUM_VALUES, encoded, max_size);
+    }
+    print_result("fixed_codec_encode()", start, (double)NUM_VALUES*NUM_PASSES, (uint32_t)size);
+    printf("  %-38s %7.3f bytes/value (%.2fx smaller than raw)\n", "encoded size", (double)size/NUM_VALUES,
+           (double)NUM_VALUES*sizeof(fixed_point_t)/(double)size);
+
+    uint32_t checksum = 0;
+    start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        memcpy(decoded, values, sizeof(values));
+        checksum += decoded[pass];
+    }
+    print_result("memcpy() of the raw values", start, (double)NUM_VALUES*NUM_PASSES, checksum);
+
+    fixed_codec_reader_t reader;
+    if (!fixed_codec_open(&reader, encoded, size))
+    {
+        printf("Failed to open the encoded stream.\n");
+        return false;
+    }
+    checksum = 0;
+    start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        fixed_codec_decode(&reader, decoded);
+        checksum += decoded[pass];
+    }
+    print_result("fixed_codec_decode()", start, (double)NUM_VALUES*NUM_PASSES, checksum);
+    if (memcmp(decoded, values, sizeof(values)) != 0)
+    {
+        printf("Decoded values don't match!\n");
+        return false;
+    }
+
+    // Random access: decode single blocks in a scattered order.
+    fixed_point_t block[FIXED_CODEC_BLOCK_VALUES];
+    checksum = 0;
+    start = now_ns();
+    for (uint32_t i = 0; i < NUM_PASSES*reader.num_blocks; i++)
+    {
+        uint32_t block_index = ((random_u16() << 16) | random_u16()) % reader.num_blocks;
+        checksum += (uint32_t)fixed_codec_decode_block(&reader, block_index, block) + block[i % 128];
+    }
+    print_result("fixed_codec_decode_block(), random", start, (double)NUM_VALUES*NUM_PASSES, checksum);
+    return true;
+}
+
+int main(void)
+{
+    size_t max_size = fixed_codec_max_encoded_size(NUM_VALUES);
+    uint8_t * encoded = (uint8_t *)malloc(max_size);
+    if (encoded == NULL)
+    {
+        printf("Out of memory.\n");
+        return 1;
+    }
+
+    // A price starting at 100.00 that moves in ticks of 0.01: unchanged half the time, else up or down 1 to 3 ticks.
+    // A tick is 655.36 in Q16.16, so every delta is a multiple of ~655, which caps how small these can get.
+    int64_t cents = 10000;
+    for (size_t i = 0; i < NUM_VALUES; i++)
+    {
+        uint32_t r = random_u16();
+        cents += (r & 1) ? 0 : (int64_t)((r >> 2) % 3 + 1)*((r & 2) ? 1 : -1);
+        cents = cents < 100 ? 100 : cents;
+        values[i] = (fixed_point_t)((cents << FRACTION_BITS)/100);
+    }
+    bool ok = run("prices in ticks of 0.01", encoded, max_size);
+
+    // A reading around 25.0 (ex: degrees C) whose rate of change drifts slowly, plus up to +/-4/65536 of noise.
+    int64_t reading = (int64_t)25 << FRACTION_BITS;
+    int64_t rate = 0;
+    for (size_t i = 0; i < NUM_VALUES; i++)
+    {
+        rate += (int64_t)(random_u16() % 3) - 1;
+        rate = rate > 64 ? 64 : rate < -64 ? -64 : rate;
+        reading += rate;
+        values[i] = (fixed_point_t)(reading + (int64_t)(random_u16() % 9) - 4);
+    }
+    ok = run("drifting sensor reading", encoded, max_size) && ok;
+
+    free(encoded);
+    return ok ? 0 : 1;
+}
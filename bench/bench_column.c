@@ -0,0 +1,114 @@
+/*
+bench_column
+- Times the bulk column operators and the batch formatter against plain one-number-at-a-time loops, in nanoseconds
+  per number.
+- Build it with one of the release presets (see CMakePresets.json) for meaningful numbers, ex:
+      cmake --preset release && cmake --build --preset release && ./build/release/bench_column
+*/
+
+// For clock_gettime() when compiling with -std=c99.
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "fixed_point.h"
+#include "fixed_point_column.h"
+#include "fixed_point_format.h"
+
+#define NUM_VALUES (1 << 16)
+#define NUM_REPS 200
+#define NUM_DIGITS_AFTER_DECIMAL 3
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec*1e9 + (double)ts.tv_nsec;
+}
+
+static void print_result(const char * name, double start_ns, double end_ns, uint32_t checksum)
+{
+    printf("%-40s %7.3f ns/number  (checksum %08x)\n", name,
+           (end_ns - start_ns)/((double)NUM_VALUES*NUM_REPS), (unsigned)checksum);
+}
+
+int main(void)
+{
+    fixed_column_t a;
+    fixed_column_t b;
+    fixed_column_t out;
+    if (!fixed_column_init(&a, NUM_VALUES, NULL) || !fixed_column_init(&b, NUM_VALUES, NULL)
+        || !fixed_column_init(&out, NUM_VALUES, NULL))
+    {
+        fprintf(stderr, "Out of memory.\n");
+        return 1;
+    }
+
+    // Fill with reproducible pseudo-random values in 0 to ~255.99 (so products don't overflow).
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < NUM_VALUES; i++)
+    {
+        seed = seed*1664525 + 1013904223;
+        fixed_column_push(&a, seed >> 8);
+        seed = seed*1664525 + 1013904223;
+        fixed_column_push(&b, seed >> 8);
+    }
+
+    char * text = (char *)malloc((size_t)NUM_VALUES*FIXED_FORMAT_MAX_LEN);
+    if (text == NULL)
+    {
+        fprintf(stderr, "Out of memory.\n");
+        return 1;
+    }
+
+    uint32_t checksum = 0;
+    double start = now_ns();
+    for (int rep = 0; rep < NUM_REPS; rep++)
+    {
+        for (size_t i = 0; i < NUM_VALUES; i++)
+        {
+            out.data[i] = (fixed_point_t)(((uint64_t)a.data[i]*b.data[i] + FRACTION_DIVISOR/2) >> FRACTION_BITS);
+        }
+        checksum += out.data[rep];
+    }
+    print_result("a*b, scalar loop", start, now_ns(), checksum);
+
+    checksum = 0;
+    start = now_ns();
+    for (int rep = 0; rep < NUM_REPS; rep++)
+    {
+        fixed_column_mul(&out, &a, &b);
+        checksum += out.data[rep];
+    }
+    print_result("a*b, fixed_column_mul()", start, now_ns(), checksum);
+
+    checksum = 0;
+    start = now_ns();
+    for (int rep = 0; rep < NUM_REPS; rep++)
+    {
+        char * p = text;
+        for (size_t i = 0; i < NUM_VALUES; i++)
+        {
+            p += fixed_format(a.data[i], NUM_DIGITS_AFTER_DECIMAL, p);
+        }
+        checksum += (uint32_t)(p - text) + (uint8_t)text[rep];
+    }
+    print_result("format, fixed_format() loop", start, now_ns(), checksum);
+
+    checksum = 0;
+    start = now_ns();
+    for (int rep = 0; rep < NUM_REPS; rep++)
+    {
+        size_t len = fixed_format_batch(a.data, NUM_VALUES, NUM_DIGITS_AFTER_DECIMAL, text, NULL);
+        checksum += (uint32_t)len + (uint8_t)text[rep];
+    }
+    print_result("format, fixed_format_batch()", start, now_ns(), checksum);
+
+    free(text);
+    fixed_column_free(&out);
+    fixed_column_free(&b);
+    fixed_column_free(&a);
+    return 0;
+}
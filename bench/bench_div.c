@@ -0,0 +1,97 @@
+/*
+bench_div
+- Times fixed-point division by one repeated divisor: a plain divide per number (fixed_div()) vs. computing the
+  divisor's reciprocal once and multiplying by it (fixed_div_batch()), in nanoseconds per number.
+*/
+
+// For clock_gettime() when compiling with -std=c99.
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "fixed_point.h"
+#include "fixed_point_div.h"
+
+#define NUM_VALUES (1 << 16)
+#define NUM_REPS 200
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec*1e9 + (double)ts.tv_nsec;
+}
+
+static void print_result(const char * name, double start_ns, double end_ns, uint32_t checksum)
+{
+    printf("%-40s %7.3f ns/number  (checksum %08x)\n", name,
+           (end_ns - start_ns)/((double)NUM_VALUES*NUM_REPS), (unsigned)checksum);
+}
+
+int main(void)
+{
+    fixed_point_t * a = (fixed_point_t *)malloc(NUM_VALUES*sizeof(fixed_point_t));
+    fixed_point_t * out = (fixed_point_t *)malloc(NUM_VALUES*sizeof(fixed_point_t));
+    if (a == NULL || out == NULL)
+    {
+        fprintf(stderr, "Out of memory.\n");
+        return 1;
+    }
+
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < NUM_VALUES; i++)
+    {
+        seed = seed*1664525 + 1013904223;
+        a[i] = seed >> 4;
+    }
+    // 3.14159 as a fixed-point number
+    const fixed_point_t b = (3 << FRACTION_BITS) + 9279;
+
+    uint32_t checksum = 0;
+    double start = now_ns();
+    for (int rep = 0; rep < NUM_REPS; rep++)
+    {
+        for (size_t i = 0; i < NUM_VALUES; i++)
+        {
+            out[i] = fixed_div(a[i], b);
+        }
+        checksum += out[rep];
+    }
+    print_result("a/b, fixed_div() loop", start, now_ns(), checksum);
+
+    checksum = 0;
+    start = now_ns();
+    for (int rep = 0; rep < NUM_REPS; rep++)
+    {
+        fixed_div_batch(out, a, NUM_VALUES, b);
+        checksum += out[rep];
+    }
+    print_result("a/b, fixed_div_batch()", start, now_ns(), checksum);
+
+    checksum = 0;
+    start = now_ns();
+    for (int rep = 0; rep < NUM_REPS; rep++)
+    {
+        for (size_t i = 0; i < NUM_VALUES; i++)
+        {
+            out[i] = (fixed_point_t)(((uint64_t)a[i] + 7/2) / 7);
+        }
+        checksum += out[rep];
+    }
+    print_result("a/7, (a + 7/2)/7 loop (constant 7)", start, now_ns(), checksum);
+
+    checksum = 0;
+    start = now_ns();
+    for (int rep = 0; rep < NUM_REPS; rep++)
+    {
+        fixed_div_int_batch(out, a, NUM_VALUES, 7);
+        checksum += out[rep];
+    }
+    print_result("a/7, fixed_div_int_batch()", start, now_ns(), checksum);
+
+    free(out);
+    free(a);
+    return 0;
+}
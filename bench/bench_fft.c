@@ -0,0 +1,192 @@
+/*
+bench_fft
+- Times forward FFTs of Q15 and Q31 complex data at 1024 points (fits in L1) and 2^16 points (doesn't), in
+  nanoseconds per point per transform, with the plan's twiddle tables made once up front.
+- Also prints each one's signal-to-noise ratio against a double-precision DFT of the same input: a full-scale
+  cosine plus a small one 60 dB down, the kind of spectrum the per-pass scaling has to keep both of.
+*/
+
+// For clock_gettime() when compiling with -std=c99.
+#define _POSIX_C_SOURCE 200112L
+
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "fixed_point_fft.h"
+
+#define MAX_LOG2_SIZE 16
+#define MAX_SIZE (1 << MAX_LOG2_SIZE)
+#define NUM_POINTS (1 << 22) // points transformed per timing: many small FFTs, or a few big ones
+
+static double input_re[MAX_SIZE];
+static double input_im[MAX_SIZE];
+static double exact_re[MAX_SIZE];
+static double exact_im[MAX_SIZE];
+static fixed_complex_q15_t data15[MAX_SIZE];
+static fixed_complex_q31_t data31[MAX_SIZE];
+static int32_t result_re[MAX_SIZE];
+static int32_t result_im[MAX_SIZE];
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec*1e9 + (double)ts.tv_nsec;
+}
+
+static void print_result(const char * name, double start, uint32_t checksum)
+{
+    printf("%-40s %7.3f ns/point  (checksum %08x)\n", name, (now_ns() - start)/NUM_POINTS, checksum);
+}
+
+// The input, and its forward transform by a plain radix-2 FFT in doubles (twiddles from cos() and sin()).
+static void make_input(size_t size)
+{
+    const double pi = 3.14159265358979323846;
+    for (size_t i = 0; i < size; i++)
+    {
+        double phase = 2*pi*(double)i/(double)size;
+        input_re[i] = 0.998*cos(phase*37) + 0.001*cos(phase*(double)(size/3) + 1);
+        input_im[i] = 0.998*sin(phase*37);
+        exact_re[i] = input_re[i];
+        exact_im[i] = input_im[i];
+    }
+    for (size_t i = 0, reversed = 0; i < size; i++)
+    {
+        if (i < reversed)
+        {
+            double swap_re = exact_re[i], swap_im = exact_im[i];
+            exact_re[i] = exact_re[reversed];
+            exact_im[i] = exact_im[reversed];
+            exact_re[reversed] = swap_re;
+            exact_im[reversed] = swap_im;
+        }
+        size_t bit = size >> 1;
+        while ((reversed & bit) != 0)
+        {
+            reversed ^= bit;
+            bit >>= 1;
+        }
+        reversed |= bit;
+    }
+    for (size_t span = 1; span < size; span *= 2)
+    {
+        for (size_t i = 0; i < size; i += 2*span)
+        {
+            for (size_t j = 0; j < span; j++)
+            {
+                double w_re = cos(pi*(double)j/(double)span), w_im = -sin(pi*(double)j/(double)span);
+                double * a_re = exact_re + i + j, * a_im = exact_im + i + j;
+                double * b_re = a_re + span, * b_im = a_im + span;
+                double t_re = *b_re*w_re - *b_im*w_im, t_im = *b_re*w_im + *b_im*w_re;
+                *b_re = *a_re - t_re;
+                *b_im = *a_im - t_im;
+                *a_re += t_re;
+                *a_im += t_im;
+            }
+        }
+    }
+}
+
+// result_re and result_im (scaled by 2^shift / 2^fraction_bits) vs. exact_re and exact_im, in dB.
+static void print_snr(const char * name, size_t size, unsigned shift, unsigned fraction_bits)
+{
+    double scale = ldexp(1, (int)shift - (int)fraction_bits), signal = 0, noise = 0;
+    for (size_t i = 0; i < size; i++)
+    {
+        double error_re = result_re[i]*scale - exact_re[i], error_im = result_im[i]*scale - exact_im[i];
+        signal += exact_re[i]*exact_re[i] + exact_im[i]*exact_im[i];
+        noise += error_re*error_re + error_im*error_im;
+    }
+    printf("%-40s %7.1f dB SNR  (shift %u)\n", name, 10*log10(signal/noise), shift);
+}
+
+static bool run(unsigned log2_size, fixed_arena_t * arena)
+{
+    size_t size = (size_t)1 << log2_size;
+    size_t num_ffts = NUM_POINTS/size;
+    fixed_fft_t fft15, fft31;
+    if (!fixed_fft_init(&fft15, size, 16, arena) || !fixed_fft_init(&fft31, size, 32, arena))
+    {
+        fprintf(stderr, "fixed_fft_init(%zu) failed\n", size);
+        return false;
+    }
+    make_input(size);
+    char name[64];
+
+    // Q15. Every transform starts from the same input, so copy it in each time (timed too: it's a small part).
+    static fixed_complex_q15_t input15[MAX_SIZE];
+    for (size_t i = 0; i < size; i++)
+    {
+        input15[i].re = (fixed_q15_t)lrint(input_re[i]*32768);
+        input15[i].im = (fixed_q15_t)lrint(input_im[i]*32768);
+    }
+    uint32_t checksum = 0;
+    unsigned shift = 0;
+    double start = now_ns();
+    for (size_t n = 0; n < num_ffts; n++)
+    {
+        for (size_t i = 0; i < size; i++)
+        {
+            data15[i] = input15[i];
+        }
+        fixed_fft_q15(&fft15, data15, false, &shift);
+        checksum += (uint32_t)data15[n & (size - 1)].re + shift;
+    }
+    snprintf(name, sizeof name, "fixed_fft_q15 (%zu points)", size);
+    print_result(name, start, checksum);
+    for (size_t i = 0; i < size; i++)
+    {
+        result_re[i] = data15[i].re;
+        result_im[i] = data15[i].im;
+    }
+    print_snr(name, size, shift, 15);
+
+    // Q31
+    static fixed_complex_q31_t input31[MAX_SIZE];
+    for (size_t i = 0; i < size; i++)
+    {
+        input31[i].re = (fixed_q31_t)llrint(input_re[i]*2147483648.0);
+        input31[i].im = (fixed_q31_t)llrint(input_im[i]*2147483648.0);
+    }
+    checksum = 0;
+    start = now_ns();
+    for (size_t n = 0; n < num_ffts; n++)
+    {
+        for (size_t i = 0; i < size; i++)
+        {
+            data31[i] = input31[i];
+        }
+        fixed_fft_q31(&fft31, data31, false, &shift);
+        checksum += (uint32_t)data31[n & (size - 1)].re + shift;
+    }
+    snprintf(name, sizeof name, "fixed_fft_q31 (%zu points)", size);
+    print_result(name, start, checksum);
+    for (size_t i = 0; i < size; i++)
+    {
+        result_re[i] = data31[i].re;
+        result_im[i] = data31[i].im;
+    }
+    print_snr(name, size, shift, 31);
+
+    fixed_fft_free(&fft31);
+    fixed_fft_free(&fft15);
+    return true;
+}
+
+int main(void)
+{
+    static fixed_arena_t arena;
+    if (!fixed_arena_init(&arena, (size_t)4 << 20))
+    {
+        fprintf(stderr, "fixed_arena_init() failed\n");
+        return 1;
+    }
+    if (!run(10, &arena) || !run(MAX_LOG2_SIZE, &arena))
+    {
+        return 1;
+    }
+    fixed_arena_free(&arena);
+    return 0;
+}
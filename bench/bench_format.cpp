@@ -0,0 +1,378 @@
+/*
+bench_format
+- Times printing fixed-point numbers as manual "floats" with 0 to 9 digits after the decimal, in nanoseconds per
+  value: the library's fixed_format() and fixed_format_batch() vs. the tutorial's rounding printf ladder ("rounded
+  price (manual float, rounded to N digits after decimal)" in main(), done with snprintf()), snprintf() and fprintf()
+  of the value as a double, std::to_chars(double), and {fmt} (if CMake found it).
+- Each is timed on random values, and on worst-case ones: 5 whole number digits, with fractions that round up and
+  carry all the way into the whole number part (ex: 65535.99999 --> "65536.000").
+- Every time is the fastest of NUM_REPEATS runs, which filters out most of the noise from other processes.
+- Regression tracking:
+  - `--json FILE` writes every result to FILE as JSON.
+  - `--baseline FILE` compares the library's results against FILE (written by an earlier `--json` run on the same
+    machine), and exits with status 1 if any got more than `--threshold PERCENT` (default 10) slower. The other
+    contenders aren't checked: they measure the C library, not this one.
+  - The `bench_format_baseline` and `bench_format_check` CMake targets run these 2 steps.
+*/
+
+#include <charconv>
+#include <string>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+#ifdef FIXED_POINT_HAVE_FMT
+#include <fmt/format.h>
+#endif
+
+#include "fixed_point_format.h"
+
+#define NUM_VALUES 4096
+#define NUM_PASSES 8
+#define NUM_REPEATS 7
+// Room for the longest any contender prints one value, plus its null.
+#define MAX_LEN 32
+#define DEFAULT_THRESHOLD_PERCENT 10.0
+
+// Print `n` values with `digits` digits after the decimal into `out`, back-to-back. Returns the number of chars.
+typedef size_t (*format_fn)(const fixed_point_t * values, size_t n, uint8_t digits, char * out);
+
+typedef struct contender_s
+{
+    const char * name;
+    format_fn format;
+    bool check_regressions; // one of ours, rather than the C/C++ library's
+} contender_t;
+
+typedef struct result_s
+{
+    std::string name;
+    int digits;
+    std::string values;
+    double ns_per_value;
+} result_t;
+
+static FILE * dev_null;
+static const uint32_t POWERS_OF_10[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec*1e9 + (double)ts.tv_nsec;
+}
+
+static size_t format_fixed_format(const fixed_point_t * values, size_t n, uint8_t digits, char * out)
+{
+    size_t len = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        len += fixed_format(values[i], digits, out + len);
+    }
+    return len;
+}
+
+static size_t format_fixed_format_batch(const fixed_point_t * values, size_t n, uint8_t digits, char * out)
+{
+    return fixed_format_batch(values, n, digits, out, NULL);
+}
+
+// The tutorial's ladder: add the rounding addend FRACTION_DIVISOR/(2*10^digits), then print the whole number part and
+// the first `digits` digits of the fraction separately. (The addend truncates to 0 from 5 digits on, so past that it
+// doesn't actually round; it's timed as written.)
+static size_t format_printf_ladder(const fixed_point_t * values, size_t n, uint8_t digits, char * out)
+{
+    fixed_point_t addend = FRACTION_DIVISOR/(2*POWERS_OF_10[digits]);
+    size_t len = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        fixed_point_t rounded = values[i] + addend;
+        if (digits == 0)
+        {
+            len += (size_t)snprintf(out + len, MAX_LEN, "%u", rounded >> FRACTION_BITS);
+        }
+        else
+        {
+            len += (size_t)snprintf(out + len, MAX_LEN, "%u.%0*llu", rounded >> FRACTION_BITS, (int)digits,
+                                    (unsigned long long)((uint64_t)(rounded & FRACTION_MASK)*POWERS_OF_10[digits]
+                                                         / FRACTION_DIVISOR));
+        }
+    }
+    return len;
+}
+
+static size_t format_snprintf_double(const fixed_point_t * values, size_t n, uint8_t digits, char * out)
+{
+    size_t len = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        len += (size_t)snprintf(out + len, MAX_LEN, "%.*f", (int)digits, (double)values[i]/FRACTION_DIVISOR);
+    }
+    return len;
+}
+
+// fprintf() to /dev/null: what printf() costs, minus the terminal.
+static size_t format_fprintf_double(const fixed_point_t * values, size_t n, uint8_t digits, char * out)
+{
+    size_t len = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        len += (size_t)fprintf(dev_null, "%.*f", (int)digits, (double)values[i]/FRACTION_DIVISOR);
+    }
+    out[0] = (char)len;
+    return len;
+}
+
+static size_t format_to_chars_double(const fixed_point_t * values, size_t n, uint8_t digits, char * out)
+{
+    char * end = out;
+    for (size_t i = 0; i < n; i++)
+    {
+        end = std::to_chars(end, end + MAX_LEN, (double)values[i]/FRACTION_DIVISOR, std::chars_format::fixed,
+                            digits).ptr;
+    }
+    return (size_t)(end - out);
+}
+
+#ifdef FIXED_POINT_HAVE_FMT
+static size_t format_fmt_double(const fixed_point_t * values, size_t n, uint8_t digits, char * out)
+{
+    char * end = out;
+    for (size_t i = 0; i < n; i++)
+    {
+        end = fmt::format_to(end, "{:.{}f}", (double)values[i]/FRACTION_DIVISOR, digits);
+    }
+    return (size_t)(end - out);
+}
+#endif
+
+static const contender_t CONTENDERS[] = {
+    {"fixed_format", format_fixed_format, true},
+    {"fixed_format_batch", format_fixed_format_batch, true},
+    {"printf_ladder", format_printf_ladder, false},
+    {"snprintf_double", format_snprintf_double, false},
+    {"fprintf_double", format_fprintf_double, false},
+    {"to_chars_double", format_to_chars_double, false},
+#ifdef FIXED_POINT_HAVE_FMT
+    {"fmt_double", format_fmt_double, false},
+#endif
+};
+#define NUM_CONTENDERS (sizeof(CONTENDERS)/sizeof(CONTENDERS[0]))
+
+// The fastest of NUM_REPEATS runs, in ns per value.
+static double time_contender(const contender_t * contender, const fixed_point_t * values, uint8_t digits,
+                             char * out, uint32_t * checksum)
+{
+    double best = 0.0;
+    for (int repeat = 0; repeat < NUM_REPEATS; repeat++)
+    {
+        double start = now_ns();
+        for (int pass = 0; pass < NUM_PASSES; pass++)
+        {
+            *checksum += (uint32_t)contender->format(values, NUM_VALUES, digits, out) + (uint8_t)out[pass];
+        }
+        double ns_per_value = (now_ns() - start)/((double)NUM_VALUES*NUM_PASSES);
+        best = repeat == 0 || ns_per_value < best ? ns_per_value : best;
+    }
+    return best;
+}
+
+static bool write_json(const char * path, const std::vector<result_t> & results)
+{
+    FILE * file = fopen(path, "w");
+    if (file == NULL)
+    {
+        perror(path);
+        return false;
+    }
+    // One result per line, which is what read_json() expects.
+    fprintf(file, "{\n  \"benchmark\": \"bench_format\",\n  \"unit\": \"ns/value\",\n  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        fprintf(file, "    {\"name\": \"%s\", \"digits\": %d, \"values\": \"%s\", \"ns_per_value\": %.3f}%s\n",
+                results[i].name.c_str(), results[i].digits, results[i].values.c_str(), results[i].ns_per_value,
+                i + 1 < results.size() ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    return fclose(file) == 0;
+}
+
+// Read back a file written by write_json().
+static bool read_json(const char * path, std::vector<result_t> * results)
+{
+    FILE * file = fopen(path, "r");
+    if (file == NULL)
+    {
+        perror(path);
+        return false;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        char name[64];
+        char values[64];
+        result_t result;
+        if (sscanf(line, " {\"name\": \"%63[^\"]\", \"digits\": %d, \"values\": \"%63[^\"]\", \"ns_per_value\": %lf",
+                   name, &result.digits, values, &result.ns_per_value) == 4)
+        {
+            result.name = name;
+            result.values = values;
+            results->push_back(result);
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+// Whether a result is one of the library's, and so checked against the baseline.
+static bool is_checked(const result_t & result)
+{
+    for (size_t i = 0; i < NUM_CONTENDERS; i++)
+    {
+        if (result.name == CONTENDERS[i].name)
+        {
+            return CONTENDERS[i].check_regressions;
+        }
+    }
+    return false;
+}
+
+// Returns the number of results more than `threshold_percent` slower than their baseline.
+static int compare_to_baseline(const std::vector<result_t> & results, const std::vector<result_t> & baseline,
+                               double threshold_percent)
+{
+    int num_regressions = 0;
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        if (!is_checked(results[i]))
+        {
+            continue;
+        }
+        const result_t * old = NULL;
+        for (size_t j = 0; j < baseline.size() && old == NULL; j++)
+        {
+            if (baseline[j].name == results[i].name && baseline[j].digits == results[i].digits
+                && baseline[j].values == results[i].values)
+            {
+                old = &baseline[j];
+            }
+        }
+        if (old == NULL)
+        {
+            printf("(not in the baseline: %s, %d digits, %s values)\n", results[i].name.c_str(), results[i].digits,
+                   results[i].values.c_str());
+            continue;
+        }
+        double change_percent = (results[i].ns_per_value/old->ns_per_value - 1.0)*100.0;
+        if (change_percent > threshold_percent)
+        {
+            printf("REGRESSION: %s, %d digits, %s values: %.3f --> %.3f ns/value (%+.1f%%, limit +%.1f%%)\n",
+                   results[i].name.c_str(), results[i].digits, results[i].values.c_str(), old->ns_per_value,
+                   results[i].ns_per_value, change_percent, threshold_percent);
+            num_regressions++;
+        }
+    }
+    return num_regressions;
+}
+
+int main(int argc, char ** argv)
+{
+    const char * json_path = NULL;
+    const char * baseline_path = NULL;
+    double threshold_percent = DEFAULT_THRESHOLD_PERCENT;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+        {
+            json_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc)
+        {
+            baseline_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc)
+        {
+            threshold_percent = atof(argv[++i]);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--json FILE] [--baseline FILE] [--threshold PERCENT]\n", argv[0]);
+            return 2;
+        }
+    }
+    // Read the baseline first, so a missing one fails right away instead of after the whole run.
+    std::vector<result_t> baseline;
+    if (baseline_path != NULL && !read_json(baseline_path, &baseline))
+    {
+        fprintf(stderr, "No baseline to compare against; record one first with --json (or bench_format_baseline).\n");
+        return 2;
+    }
+    dev_null = fopen("/dev/null", "w");
+    if (dev_null == NULL)
+    {
+        perror("/dev/null");
+        return 2;
+    }
+
+    // Random values, and worst cases: whole number parts 10000 to 65535, and fractions within 1/65536 of 1, which
+    // round up (at every digit count) and carry into the whole number part.
+    std::vector<fixed_point_t> random_values(NUM_VALUES);
+    std::vector<fixed_point_t> worst_values(NUM_VALUES);
+    uint64_t seed = 12345;
+    for (size_t i = 0; i < NUM_VALUES; i++)
+    {
+        seed = seed*6364136223846793005ull + 1442695040888963407ull;
+        random_values[i] = (fixed_point_t)(seed >> 32);
+        worst_values[i] = (fixed_point_t)((10000 + (seed >> 33) % 55535) << FRACTION_BITS) | FRACTION_MASK;
+    }
+    std::vector<char> out(NUM_VALUES*MAX_LEN + NUM_PASSES);
+
+    std::vector<result_t> results;
+    uint32_t checksum = 0;
+    for (int set = 0; set < 2; set++)
+    {
+        const char * values_name = set == 0 ? "random" : "worst";
+        const fixed_point_t * values = set == 0 ? random_values.data() : worst_values.data();
+        printf("%s values, ns/value by digits after the decimal:\n", values_name);
+        printf("%-20s", "");
+        for (int digits = 0; digits <= FIXED_FORMAT_MAX_DIGITS; digits++)
+        {
+            printf(" %7d", digits);
+        }
+        printf("\n");
+        for (size_t i = 0; i < NUM_CONTENDERS; i++)
+        {
+            printf("%-20s", CONTENDERS[i].name);
+            for (int digits = 0; digits <= FIXED_FORMAT_MAX_DIGITS; digits++)
+            {
+                result_t result;
+                result.name = CONTENDERS[i].name;
+                result.digits = digits;
+                result.values = values_name;
+                result.ns_per_value = time_contender(&CONTENDERS[i], values, (uint8_t)digits, out.data(), &checksum);
+                results.push_back(result);
+                printf(" %7.2f", result.ns_per_value);
+                fflush(stdout);
+            }
+            printf("\n");
+        }
+        printf("\n");
+    }
+    printf("(checksum %08x)\n", checksum);
+    fclose(dev_null);
+
+    if (json_path != NULL && !write_json(json_path, results))
+    {
+        return 2;
+    }
+    if (baseline_path != NULL)
+    {
+        int num_regressions = compare_to_baseline(results, baseline, threshold_percent);
+        printf("%d regression%s over +%.1f%% vs. %s\n", num_regressions, num_regressions == 1 ? "" : "s",
+               threshold_percent, baseline_path);
+        return num_regressions > 0 ? 1 : 0;
+    }
+    return 0;
+}
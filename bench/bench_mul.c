@@ -0,0 +1,193 @@
+/*
+bench_mul
+- Times a filter-style multiply-accumulate (`acc[i] = round(acc[i] + x[i]*h[i])`) in nanoseconds per value, in Q15, Q31,
+  and Q16.16: written out as separate C expressions (widen, multiply, add the 1/2, shift, add, saturate), with the
+  fixed_point_mul scalar functions, and with its batch functions.
+- Build with `-DFIXED_POINT_NATIVE=ON` to let the batch functions use SSSE3/AVX2.
+*/
+
+// For clock_gettime() when compiling with -std=c99.
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <time.h>
+
+#include "fixed_point_mul.h"
+
+#define NUM_VALUES 4096
+#define NUM_PASSES 20000
+
+static fixed_q15_t x15[NUM_VALUES], h15[NUM_VALUES], acc15[NUM_VALUES];
+static fixed_q31_t x31[NUM_VALUES], h31[NUM_VALUES], acc31[NUM_VALUES];
+static fixed_point_t x16[NUM_VALUES], h16[NUM_VALUES], acc16[NUM_VALUES];
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec*1e9 + (double)ts.tv_nsec;
+}
+
+static void print_result(const char * name, double start, uint32_t checksum)
+{
+    printf("%-40s %7.3f ns/value  (checksum %08x)\n", name,
+           (now_ns() - start)/((double)NUM_VALUES*NUM_PASSES), checksum);
+}
+
+static void init_values(void)
+{
+    uint64_t seed = 12345;
+    for (size_t i = 0; i < NUM_VALUES; i++)
+    {
+        seed = seed*6364136223846793005ull + 1442695040888963407ull;
+        x15[i] = (fixed_q15_t)(seed >> 48);
+        h15[i] = (fixed_q15_t)(seed >> 32);
+        acc15[i] = 0;
+        x31[i] = (fixed_q31_t)(seed >> 32);
+        h31[i] = (fixed_q31_t)seed;
+        acc31[i] = 0;
+        // Small enough that the Q16.16 accumulators don't wrap around too soon.
+        x16[i] = (fixed_point_t)(seed >> 48);
+        h16[i] = (fixed_point_t)(seed >> 16) & FRACTION_MASK;
+        acc16[i] = 0;
+    }
+}
+
+static uint32_t checksum_q15(void)
+{
+    uint32_t checksum = 0;
+    for (size_t i = 0; i < NUM_VALUES; i++)
+    {
+        checksum = checksum*31 + (uint16_t)acc15[i];
+    }
+    return checksum;
+}
+
+static uint32_t checksum_q31(void)
+{
+    uint32_t checksum = 0;
+    for (size_t i = 0; i < NUM_VALUES; i++)
+    {
+        checksum = checksum*31 + (uint32_t)acc31[i];
+    }
+    return checksum;
+}
+
+static uint32_t checksum_q16(void)
+{
+    uint32_t checksum = 0;
+    for (size_t i = 0; i < NUM_VALUES; i++)
+    {
+        checksum = checksum*31 + acc16[i];
+    }
+    return checksum;
+}
+
+int main(void)
+{
+    init_values();
+    double start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        // Flip the sign of the "filter" every pass, so the accumulators go up and down instead of saturating.
+        for (size_t i = 0; i < NUM_VALUES; i++)
+        {
+            int32_t product = ((int32_t)x15[i]*h15[i] + (1 << 14)) >> 15;
+            int32_t sum = acc15[i] + product;
+            acc15[i] = (fixed_q15_t)(sum > INT16_MAX ? INT16_MAX : sum < INT16_MIN ? INT16_MIN : sum);
+        }
+        x15[pass % NUM_VALUES] = (fixed_q15_t)-x15[pass % NUM_VALUES];
+    }
+    print_result("Q15: separate expressions", start, checksum_q15());
+
+    init_values();
+    start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        for (size_t i = 0; i < NUM_VALUES; i++)
+        {
+            acc15[i] = fixed_q15_mul_add_round(x15[i], h15[i], acc15[i]);
+        }
+        x15[pass % NUM_VALUES] = (fixed_q15_t)-x15[pass % NUM_VALUES];
+    }
+    print_result("Q15: fixed_q15_mul_add_round()", start, checksum_q15());
+
+    init_values();
+    start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        fixed_q15_mul_add_round_batch(acc15, x15, h15, acc15, NUM_VALUES);
+        x15[pass % NUM_VALUES] = (fixed_q15_t)-x15[pass % NUM_VALUES];
+    }
+    print_result("Q15: fixed_q15_mul_add_round_batch()", start, checksum_q15());
+
+    init_values();
+    start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        for (size_t i = 0; i < NUM_VALUES; i++)
+        {
+            int64_t product = ((int64_t)x31[i]*h31[i] + ((int64_t)1 << 30)) >> 31;
+            int64_t sum = acc31[i] + product;
+            acc31[i] = (fixed_q31_t)(sum > INT32_MAX ? INT32_MAX : sum < INT32_MIN ? INT32_MIN : sum);
+        }
+        x31[pass % NUM_VALUES] = -x31[pass % NUM_VALUES];
+    }
+    print_result("Q31: separate expressions", start, checksum_q31());
+
+    init_values();
+    start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        for (size_t i = 0; i < NUM_VALUES; i++)
+        {
+            acc31[i] = fixed_q31_mul_add_round(x31[i], h31[i], acc31[i]);
+        }
+        x31[pass % NUM_VALUES] = -x31[pass % NUM_VALUES];
+    }
+    print_result("Q31: fixed_q31_mul_add_round()", start, checksum_q31());
+
+    init_values();
+    start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        fixed_q31_mul_add_round_batch(acc31, x31, h31, acc31, NUM_VALUES);
+        x31[pass % NUM_VALUES] = -x31[pass % NUM_VALUES];
+    }
+    print_result("Q31: fixed_q31_mul_add_round_batch()", start, checksum_q31());
+
+    init_values();
+    start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        for (size_t i = 0; i < NUM_VALUES; i++)
+        {
+            uint64_t product = (uint64_t)x16[i]*h16[i];
+            acc16[i] += (fixed_point_t)((product + FRACTION_DIVISOR/2) >> FRACTION_BITS);
+        }
+        x16[pass % NUM_VALUES] ^= 1;
+    }
+    print_result("Q16.16: separate expressions", start, checksum_q16());
+
+    init_values();
+    start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        for (size_t i = 0; i < NUM_VALUES; i++)
+        {
+            acc16[i] = fixed_mul_add_round(x16[i], h16[i], acc16[i]);
+        }
+        x16[pass % NUM_VALUES] ^= 1;
+    }
+    print_result("Q16.16: fixed_mul_add_round()", start, checksum_q16());
+
+    init_values();
+    start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        fixed_mul_add_round_batch(acc16, x16, h16, acc16, NUM_VALUES);
+        x16[pass % NUM_VALUES] ^= 1;
+    }
+    print_result("Q16.16: fixed_mul_add_round_batch()", start, checksum_q16());
+    return 0;
+}
@@ -0,0 +1,148 @@
+/*
+bench_pipeline
+- Times a file-to-file conversion job (a binary column of `fixed_point_t` formatted to text, one number per line) done
+  the usual way, alternating blocking reads, converting, and blocking writes, vs. with fixed_pipeline_run()
+  overlapping them, in nanoseconds per value.
+- The files are temporary files in /tmp, so this mostly measures the page cache rather than a disk; the overlap helps
+  more the slower the I/O is.
+*/
+
+// For mkstemp() and clock_gettime() when compiling with -std=c99.
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "fixed_point_format.h"
+#include "fixed_point_pipeline.h"
+
+#define NUM_VALUES (4*1024*1024)
+#define CHUNK_VALUES (64*1024)
+#define DIGITS 3
+// The most chars one value takes: the number, plus its '\n'.
+#define MAX_LINE_LEN FIXED_FORMAT_MAX_LEN
+
+static fixed_point_t chunk[CHUNK_VALUES];
+static char text[CHUNK_VALUES*MAX_LINE_LEN];
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec*1e9 + (double)ts.tv_nsec;
+}
+
+static void print_result(const char * name, double start, uint64_t bytes_written)
+{
+    printf("%-40s %7.3f ns/value  (%llu bytes written)\n", name, (now_ns() - start)/NUM_VALUES,
+           (unsigned long long)bytes_written);
+}
+
+// Format a chunk of values, one per line.
+static size_t format_lines(const fixed_point_t * values, size_t n, char * out)
+{
+    size_t len = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        len += fixed_format(values[i], DIGITS, out + len);
+        out[len++] = '\n';
+    }
+    return len;
+}
+
+static size_t convert(void * context, const uint8_t * in, size_t in_size, uint8_t * out, size_t out_capacity)
+{
+    (void)context;
+    (void)out_capacity;
+    // `in` is only byte-aligned as far as the pipeline knows, so copy the values out.
+    fixed_point_t values[1024];
+    size_t len = 0;
+    for (size_t offset = 0; offset < in_size; offset += sizeof(values))
+    {
+        size_t size = in_size - offset < sizeof(values) ? in_size - offset : sizeof(values);
+        memcpy(values, in + offset, size);
+        len += format_lines(values, size / sizeof(fixed_point_t), (char *)out + len);
+    }
+    return len;
+}
+
+static int make_temp_file(void)
+{
+    char path[] = "/tmp/bench_pipeline_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd >= 0)
+    {
+        unlink(path);
+    }
+    return fd;
+}
+
+int main(void)
+{
+    int in_fd = make_temp_file();
+    int out_fd = make_temp_file();
+    if (in_fd < 0 || out_fd < 0)
+    {
+        perror("mkstemp");
+        return 1;
+    }
+    uint64_t seed = 12345;
+    for (size_t i = 0; i < NUM_VALUES; i += CHUNK_VALUES)
+    {
+        for (size_t j = 0; j < CHUNK_VALUES; j++)
+        {
+            seed = seed*6364136223846793005ull + 1442695040888963407ull;
+            chunk[j] = (fixed_point_t)(seed >> 40);
+        }
+        if (write(in_fd, chunk, sizeof(chunk)) != (ssize_t)sizeof(chunk))
+        {
+            perror("write");
+            return 1;
+        }
+    }
+
+    double start = now_ns();
+    lseek(in_fd, 0, SEEK_SET);
+    lseek(out_fd, 0, SEEK_SET);
+    uint64_t bytes_written = 0;
+    ssize_t num_bytes;
+    while ((num_bytes = read(in_fd, chunk, sizeof(chunk))) > 0)
+    {
+        size_t len = format_lines(chunk, (size_t)num_bytes / sizeof(fixed_point_t), text);
+        bytes_written += (uint64_t)write(out_fd, text, len);
+    }
+    print_result("read, format, write, repeat", start, bytes_written);
+
+    static const unsigned num_workers[] = {1, 2, 4};
+    for (size_t i = 0; i < sizeof(num_workers)/sizeof(num_workers[0]); i++)
+    {
+        fixed_pipeline_config_t config;
+        fixed_pipeline_config_init(&config, convert, NULL);
+        config.chunk_size = sizeof(chunk);
+        config.out_chunk_size = CHUNK_VALUES*MAX_LINE_LEN;
+        config.record_size = sizeof(fixed_point_t);
+        config.num_workers = num_workers[i];
+
+        start = now_ns();
+        lseek(in_fd, 0, SEEK_SET);
+        lseek(out_fd, 0, SEEK_SET);
+        fixed_pipeline_stats_t stats;
+        if (!fixed_pipeline_run(&config, in_fd, out_fd, &stats))
+        {
+            perror("fixed_pipeline_run");
+            return 1;
+        }
+        char name[64];
+        snprintf(name, sizeof(name), "fixed_pipeline_run(), %u worker%s", num_workers[i],
+                 num_workers[i] > 1 ? "s" : "");
+        print_result(name, start, stats.bytes_written);
+        printf("    stalls: reader %llu, workers %llu, writer %llu\n", (unsigned long long)stats.reader_stalls,
+               (unsigned long long)stats.worker_stalls, (unsigned long long)stats.writer_stalls);
+    }
+    close(in_fd);
+    close(out_fd);
+    return 0;
+}
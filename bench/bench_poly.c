@@ -0,0 +1,126 @@
+/*
+bench_poly
+- Times evaluating an ADC calibration cubic (c0 + c1*x + c2*x^2 + c3*x^3, for 12-bit readings) in double-precision
+  floating point vs. in fixed point with fixed_point_poly, in nanoseconds per value.
+*/
+
+// For clock_gettime() when compiling with -std=c99.
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <time.h>
+
+#include "fixed_point_poly.h"
+
+#define NUM_VALUES 4096
+#define NUM_PASSES 4000
+
+static const double coefficients[] = {-12.5, 0.0485, -2.1e-6, 3.3e-10};
+
+static fixed_point_t readings[NUM_VALUES];
+static double doubles[NUM_VALUES];
+static int32_t results[NUM_VALUES];
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec*1e9 + (double)ts.tv_nsec;
+}
+
+static void print_result(const char * name, double start, uint32_t checksum)
+{
+    printf("%-40s %7.3f ns/value  (checksum %08x)\n", name,
+           (now_ns() - start)/((double)NUM_VALUES*NUM_PASSES), checksum);
+}
+
+static uint32_t checksum_results(void)
+{
+    uint32_t checksum = 0;
+    for (size_t i = 0; i < NUM_VALUES; i++)
+    {
+        checksum = checksum*31 + (uint32_t)results[i];
+    }
+    return checksum;
+}
+
+int main(void)
+{
+    // 12-bit ADC readings (0 to 4095), in Q16.16.
+    uint64_t seed = 12345;
+    for (size_t i = 0; i < NUM_VALUES; i++)
+    {
+        seed = seed*6364136223846793005ull + 1442695040888963407ull;
+        readings[i] = (fixed_point_t)((seed >> 52) << FRACTION_BITS);
+        doubles[i] = (double)(seed >> 52);
+    }
+
+    fixed_poly_t horner;
+    fixed_poly_t estrin;
+    fixed_poly_init(&horner, coefficients, 3, 4095u << FRACTION_BITS, FRACTION_BITS, FIXED_POLY_HORNER);
+    fixed_poly_init(&estrin, coefficients, 3, 4095u << FRACTION_BITS, FRACTION_BITS, FIXED_POLY_ESTRIN);
+    printf("error bound: %.3f LSB (Horner), %.3f LSB (Estrin)\n", horner.error_bound, estrin.error_bound);
+
+    uint32_t checksum = 0;
+    double start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        // Vary the input per pass, or the compiler hoists the whole loop out.
+        doubles[pass % NUM_VALUES] += 1.0/FRACTION_DIVISOR;
+        for (size_t i = 0; i < NUM_VALUES; i++)
+        {
+            double x = doubles[i];
+            double y = ((coefficients[3]*x + coefficients[2])*x + coefficients[1])*x + coefficients[0];
+            results[i] = (int32_t)(y*FRACTION_DIVISOR);
+        }
+        checksum += checksum_results();
+    }
+    print_result("double Horner", start, checksum);
+
+    checksum = 0;
+    start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        readings[pass % NUM_VALUES] ^= 1;
+        for (size_t i = 0; i < NUM_VALUES; i++)
+        {
+            results[i] = fixed_poly_eval(&horner, readings[i]);
+        }
+        checksum += checksum_results();
+    }
+    print_result("fixed_poly_eval() Horner", start, checksum);
+
+    checksum = 0;
+    start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        readings[pass % NUM_VALUES] ^= 1;
+        for (size_t i = 0; i < NUM_VALUES; i++)
+        {
+            results[i] = fixed_poly_eval(&estrin, readings[i]);
+        }
+        checksum += checksum_results();
+    }
+    print_result("fixed_poly_eval() Estrin", start, checksum);
+
+    checksum = 0;
+    start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        readings[pass % NUM_VALUES] ^= 1;
+        fixed_poly_eval_batch(&horner, readings, results, NUM_VALUES);
+        checksum += checksum_results();
+    }
+    print_result("fixed_poly_eval_batch() Horner", start, checksum);
+
+    checksum = 0;
+    start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        readings[pass % NUM_VALUES] ^= 1;
+        fixed_poly_eval_batch(&estrin, readings, results, NUM_VALUES);
+        checksum += checksum_results();
+    }
+    print_result("fixed_poly_eval_batch() Estrin", start, checksum);
+    return 0;
+}
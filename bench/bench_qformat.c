@@ -0,0 +1,130 @@
+/*
+bench_qformat
+- Times converting a million numbers whose format is only known at run time (here, 12 or 13 fraction bits, as if
+  read from a file's header) to Q15.16, and multiplying them, in nanoseconds per value: a plain loop that decides
+  which way to shift, and shifts by a variable amount, for every number, vs. fixed_qformat_to_fixed() and
+  fixed_qformat_mul_round() with a specialized (12-bit) and a generic (13-bit) kernel table.
+*/
+
+// For clock_gettime() when compiling with -std=c99.
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <time.h>
+
+#include "fixed_point_qformat.h"
+
+#define NUM_VALUES (1 << 20)
+#define NUM_PASSES 20
+
+static int32_t a[NUM_VALUES];
+static int32_t b[NUM_VALUES];
+static int32_t out[NUM_VALUES];
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec*1e9 + (double)ts.tv_nsec;
+}
+
+static void print_result(const char * name, double start, int num_passes, uint32_t checksum)
+{
+    printf("%-40s %7.3f ns/value  (checksum %08x)\n", name,
+           (now_ns() - start)/((double)NUM_VALUES*num_passes), checksum);
+}
+
+static uint32_t checksum_of(const int32_t * values)
+{
+    uint32_t checksum = 0;
+    for (size_t i = 0; i < NUM_VALUES; i++)
+    {
+        checksum += (uint32_t)values[i] ^ (uint32_t)i;
+    }
+    return checksum;
+}
+
+// What a generic reader does without this module: every number checks which way to shift, and by how much.
+// (Rounding half up, and saturating, like fixed_qformat_to_fixed().)
+static int32_t plain_to_fixed(int32_t x, unsigned fraction_bits)
+{
+    if (fraction_bits > FRACTION_BITS)
+    {
+        unsigned shift = fraction_bits - FRACTION_BITS;
+        return (int32_t)(((int64_t)x + ((int64_t)1 << (shift - 1))) >> shift);
+    }
+    int64_t y = (int64_t)x * ((int64_t)1 << (FRACTION_BITS - fraction_bits));
+    return y > INT32_MAX ? INT32_MAX : y < INT32_MIN ? INT32_MIN : (int32_t)y;
+}
+
+int main(void)
+{
+    uint64_t seed = 12345;
+    for (size_t i = 0; i < NUM_VALUES; i++)
+    {
+        seed = seed*6364136223846793005ull + 1442695040888963407ull;
+        // Up to +-2^20, so at 12 or 13 fraction bits, nothing saturates.
+        a[i] = (int32_t)(seed >> 43) - (1 << 20);
+        b[i] = (int32_t)((seed >> 11) & 0x1FFFFF) - (1 << 20);
+    }
+
+    const unsigned formats[] = {12, 13};
+    for (size_t f = 0; f < sizeof(formats)/sizeof(formats[0]); f++)
+    {
+        // Read at run time, so the compiler can't specialize the plain loop either.
+        volatile unsigned fraction_bits_from_file = formats[f];
+        unsigned fraction_bits = fraction_bits_from_file;
+        fixed_qformat_t format;
+        fixed_qformat_init(&format, fraction_bits);
+        const char * kind = format.specialized ? "specialized" : "generic";
+        char name[64];
+
+        uint32_t checksum = 0;
+        double start = now_ns();
+        for (int pass = 0; pass < NUM_PASSES; pass++)
+        {
+            for (size_t i = 0; i < NUM_VALUES; i++)
+            {
+                out[i] = plain_to_fixed(a[i], fraction_bits);
+            }
+            checksum += checksum_of(out);
+        }
+        snprintf(name, sizeof(name), "Q%u to Q16: plain loop", fraction_bits);
+        print_result(name, start, NUM_PASSES, checksum);
+
+        checksum = 0;
+        start = now_ns();
+        for (int pass = 0; pass < NUM_PASSES; pass++)
+        {
+            fixed_qformat_to_fixed(&format, out, a, NUM_VALUES);
+            checksum += checksum_of(out);
+        }
+        snprintf(name, sizeof(name), "Q%u to Q16: fixed_qformat (%s)", fraction_bits, kind);
+        print_result(name, start, NUM_PASSES, checksum);
+
+        checksum = 0;
+        start = now_ns();
+        for (int pass = 0; pass < NUM_PASSES; pass++)
+        {
+            for (size_t i = 0; i < NUM_VALUES; i++)
+            {
+                int64_t product = ((int64_t)a[i]*b[i] + ((int64_t)1 << (fraction_bits - 1))) >> fraction_bits;
+                out[i] = product > INT32_MAX ? INT32_MAX : product < INT32_MIN ? INT32_MIN : (int32_t)product;
+            }
+            checksum += checksum_of(out);
+        }
+        snprintf(name, sizeof(name), "Q%u a*b: plain loop", fraction_bits);
+        print_result(name, start, NUM_PASSES, checksum);
+
+        checksum = 0;
+        start = now_ns();
+        for (int pass = 0; pass < NUM_PASSES; pass++)
+        {
+            fixed_qformat_mul_round(&format, out, a, b, NUM_VALUES);
+            checksum += checksum_of(out);
+        }
+        snprintf(name, sizeof(name), "Q%u a*b: fixed_qformat (%s)", fraction_bits, kind);
+        print_result(name, start, NUM_PASSES, checksum);
+    }
+    return 0;
+}
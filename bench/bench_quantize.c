@@ -0,0 +1,155 @@
+/*
+bench_quantize
+- Times quantizing floats to fixed-point: the plain scalar loop, alone and with a separate statistics pass, vs.
+  fixed_quantize_f32() (which also rounds exactly, saturates, and gathers per-block statistics in the same pass), and
+  dequantizing back, in nanoseconds per value.
+*/
+
+// For clock_gettime() when compiling with -std=c99.
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <time.h>
+
+#include "fixed_point_quantize.h"
+
+#define NUM_VALUES 4096
+#define NUM_PASSES 4000
+
+static float values[NUM_VALUES];
+static double doubles[NUM_VALUES];
+static fixed_point_t quantized[NUM_VALUES];
+static float dequantized[NUM_VALUES];
+static fixed_quantize_stats_t stats[FIXED_QUANTIZE_NUM_BLOCKS(NUM_VALUES)];
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec*1e9 + (double)ts.tv_nsec;
+}
+
+static void print_result(const char * name, double start, uint32_t checksum)
+{
+    printf("%-40s %7.3f ns/value  (checksum %08x)\n", name,
+           (now_ns() - start)/((double)NUM_VALUES*NUM_PASSES), checksum);
+}
+
+static uint32_t checksum_quantized(void)
+{
+    uint32_t checksum = 0;
+    for (size_t i = 0; i < NUM_VALUES; i++)
+    {
+        checksum = checksum*31 + quantized[i];
+    }
+    return checksum;
+}
+
+int main(void)
+{
+    // Sensor-like readings: mostly 0 to ~1000, with a few negative and out-of-range ones to clip.
+    uint64_t seed = 12345;
+    for (size_t i = 0; i < NUM_VALUES; i++)
+    {
+        seed = seed*6364136223846793005ull + 1442695040888963407ull;
+        values[i] = (float)((double)(seed >> 40)/16777216.0*1000.0);
+        if ((seed >> 20) % 64 == 0)
+        {
+            values[i] = (seed >> 26) % 2 ? -values[i] : values[i]*100.0f;
+        }
+        doubles[i] = values[i];
+    }
+
+    uint32_t checksum = 0;
+    double start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        // Vary the input per pass, or the compiler hoists the whole loop out.
+        float bias = (float)(pass & 1)/FRACTION_DIVISOR;
+        for (size_t i = 0; i < NUM_VALUES; i++)
+        {
+            // The usual scalar conversion: no saturation (negative and huge values are undefined behavior), and no
+            // statistics.
+            float scaled = (values[i] + bias)*FRACTION_DIVISOR + 0.5f;
+            quantized[i] = scaled > 0.0f && scaled < 4294967040.0f ? (fixed_point_t)scaled : 0;
+        }
+        checksum += checksum_quantized();
+    }
+    print_result("scalar (x*FRACTION_DIVISOR + 0.5)", start, checksum);
+
+    checksum = 0;
+    start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        float bias = (float)(pass & 1)/FRACTION_DIVISOR;
+        // The same, plus a second pass for the min, max, and number of values that clip.
+        float min = values[0];
+        float max = values[0];
+        uint32_t clipped = 0;
+        for (size_t i = 0; i < NUM_VALUES; i++)
+        {
+            float value = values[i] + bias;
+            min = value < min ? value : min;
+            max = value > max ? value : max;
+            clipped += value < 0.0f || value >= 65536.0f;
+        }
+        for (size_t i = 0; i < NUM_VALUES; i++)
+        {
+            float scaled = (values[i] + bias)*FRACTION_DIVISOR + 0.5f;
+            quantized[i] = scaled > 0.0f ? scaled < 4294967040.0f ? (fixed_point_t)scaled : UINT32_MAX : 0;
+        }
+        checksum += checksum_quantized() + clipped + (uint32_t)(max - min);
+    }
+    print_result("scalar + separate statistics pass", start, checksum);
+
+    checksum = 0;
+    start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        values[pass % NUM_VALUES] += 1.0f;
+        fixed_quantize_f32(values, quantized, NUM_VALUES, FIXED_ROUND_HALF_UP, true, stats);
+        checksum += checksum_quantized() + stats[0].clipped_low;
+    }
+    print_result("fixed_quantize_f32() half up + stats", start, checksum);
+
+    checksum = 0;
+    start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        values[pass % NUM_VALUES] -= 1.0f;
+        fixed_quantize_f32(values, quantized, NUM_VALUES, FIXED_ROUND_HALF_EVEN, true, stats);
+        checksum += checksum_quantized() + stats[0].clipped_low;
+    }
+    print_result("fixed_quantize_f32() half even + stats", start, checksum);
+
+    checksum = 0;
+    start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        doubles[pass % NUM_VALUES] += 1.0;
+        fixed_quantize_f64(doubles, quantized, NUM_VALUES, FIXED_ROUND_HALF_UP, true, stats);
+        checksum += checksum_quantized() + stats[0].clipped_low;
+    }
+    print_result("fixed_quantize_f64() half up + stats", start, checksum);
+
+    // Subtract out the cost of the checksums, which every loop above pays.
+    checksum = 0;
+    start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        quantized[pass % NUM_VALUES] += 1;
+        checksum += checksum_quantized();
+    }
+    print_result("(checksum loop alone)", start, checksum);
+
+    checksum = 0;
+    start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        quantized[pass % NUM_VALUES] += 1;
+        fixed_dequantize_f32(quantized, dequantized, NUM_VALUES);
+        checksum += (uint32_t)dequantized[pass % NUM_VALUES];
+    }
+    print_result("fixed_dequantize_f32()", start, checksum);
+    return 0;
+}
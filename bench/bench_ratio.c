@@ -0,0 +1,89 @@
+/*
+bench_ratio
+- Times getting a scaling plan for a runtime times/divide pair: rebuilding it every time with fixed_ratio_plan_init()
+  vs. looking it up in the shared, lock-free plan cache, from 1 thread and from several threads at once, in
+  nanoseconds per plan.
+*/
+
+// For clock_gettime() and pthreads when compiling with -std=c99.
+#define _POSIX_C_SOURCE 200112L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "fixed_point.h"
+#include "fixed_point_ratio.h"
+
+#define NUM_RATIOS 64
+#define NUM_LOOKUPS_PER_THREAD 2000000
+#define MAX_THREADS 8
+
+static uint32_t ratio_times[NUM_RATIOS];
+static uint32_t ratio_divides[NUM_RATIOS];
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec*1e9 + (double)ts.tv_nsec;
+}
+
+// Scale one price by each ratio in turn, getting each plan from the default cache.
+static void * cached_lookups(void * checksum_out)
+{
+    fixed_point_t price = 10 << FRACTION_BITS;
+    uint32_t checksum = 0;
+    for (int i = 0; i < NUM_LOOKUPS_PER_THREAD; i++)
+    {
+        const fixed_ratio_plan_t * plan = fixed_ratio_plan_get(ratio_times[i % NUM_RATIOS],
+                                                               ratio_divides[i % NUM_RATIOS], 32);
+        checksum += fixed_ratio_apply32(plan, price);
+    }
+    *(uint32_t *)checksum_out = checksum;
+    return NULL;
+}
+
+int main(void)
+{
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < NUM_RATIOS; i++)
+    {
+        seed = seed*1664525 + 1013904223;
+        ratio_times[i] = (seed >> 16) + 1;
+        seed = seed*1664525 + 1013904223;
+        ratio_divides[i] = (seed >> 16) + 1;
+    }
+
+    fixed_point_t price = 10 << FRACTION_BITS;
+    uint32_t checksum = 0;
+    double start = now_ns();
+    for (int i = 0; i < NUM_LOOKUPS_PER_THREAD; i++)
+    {
+        fixed_ratio_plan_t plan;
+        fixed_ratio_plan_init(&plan, ratio_times[i % NUM_RATIOS], ratio_divides[i % NUM_RATIOS], 32);
+        checksum += fixed_ratio_apply32(&plan, price);
+    }
+    printf("%-40s %7.3f ns/plan  (checksum %08x)\n", "rebuild plan every time, 1 thread",
+           (now_ns() - start)/NUM_LOOKUPS_PER_THREAD, (unsigned)checksum);
+
+    for (int num_threads = 1; num_threads <= MAX_THREADS; num_threads *= 2)
+    {
+        pthread_t threads[MAX_THREADS];
+        uint32_t checksums[MAX_THREADS];
+        start = now_ns();
+        for (int t = 0; t < num_threads; t++)
+        {
+            pthread_create(&threads[t], NULL, cached_lookups, &checksums[t]);
+        }
+        for (int t = 0; t < num_threads; t++)
+        {
+            pthread_join(threads[t], NULL);
+        }
+        char name[64];
+        snprintf(name, sizeof(name), "cached lookup, %d thread(s)", num_threads);
+        printf("%-40s %7.3f ns/plan  (checksum %08x)\n", name,
+               (now_ns() - start)/((double)NUM_LOOKUPS_PER_THREAD*num_threads), (unsigned)checksums[0]);
+    }
+    return 0;
+}
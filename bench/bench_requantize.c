@@ -0,0 +1,132 @@
+/*
+bench_requantize
+- Times requantizing a million Q1.31 audio samples to Q1.15, in nanoseconds per sample: a plain `>> 16` (rounds
+  down), the tutorial's `+ 1/2` addend (rounds ties up), and a plain error-feedback loop, vs. fixed_requantize_i16()
+  in each of its modes.
+*/
+
+// For clock_gettime() when compiling with -std=c99.
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <time.h>
+
+#include "fixed_point_requantize.h"
+
+#define NUM_VALUES (1 << 20)
+#define NUM_PASSES 20
+#define SHIFT 16
+
+static int32_t samples[NUM_VALUES];
+static int16_t outputs[NUM_VALUES];
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec*1e9 + (double)ts.tv_nsec;
+}
+
+static void print_result(const char * name, double start, int num_passes, uint32_t checksum)
+{
+    printf("%-40s %7.3f ns/value  (checksum %08x)\n", name,
+           (now_ns() - start)/((double)NUM_VALUES*num_passes), checksum);
+}
+
+static uint32_t checksum_of(const int16_t * values)
+{
+    uint32_t checksum = 0;
+    for (size_t i = 0; i < NUM_VALUES; i++)
+    {
+        checksum += (uint32_t)(values[i] ^ (int16_t)i);
+    }
+    return checksum;
+}
+
+static int16_t clamp_to_int16(int64_t value)
+{
+    return (int16_t)(value < INT16_MIN ? INT16_MIN : value > INT16_MAX ? INT16_MAX : value);
+}
+
+int main(void)
+{
+    // A triangle wave at about a quarter of full scale (so nothing clips), plus a few output steps of noise.
+    uint64_t seed = 12345;
+    for (size_t i = 0; i < NUM_VALUES; i++)
+    {
+        seed = seed*6364136223846793005ull + 1442695040888963407ull;
+        int32_t wave = (int32_t)(i % 1024 < 512 ? i % 512 : 512 - i % 512) - 256;
+        samples[i] = wave*(1 << 22) + (int32_t)(seed >> 46) - (1 << 17);
+    }
+
+    uint32_t checksum = 0;
+    double start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        for (size_t i = 0; i < NUM_VALUES; i++)
+        {
+            // Arithmetic right shift is implementation-defined for negatives, but it's what everyone writes.
+            outputs[i] = (int16_t)(samples[i] >> SHIFT);
+        }
+        checksum += checksum_of(outputs);
+    }
+    print_result("plain >> (round down)", start, NUM_PASSES, checksum);
+
+    checksum = 0;
+    start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        for (size_t i = 0; i < NUM_VALUES; i++)
+        {
+            outputs[i] = clamp_to_int16(((int64_t)samples[i] + (1 << (SHIFT - 1))) >> SHIFT);
+        }
+        checksum += checksum_of(outputs);
+    }
+    print_result("+ 1/2 addend (round half up)", start, NUM_PASSES, checksum);
+
+    checksum = 0;
+    start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        int64_t error = 0;
+        for (size_t i = 0; i < NUM_VALUES; i++)
+        {
+            int64_t value = samples[i] + error;
+            int64_t rounded = (value + (1 << (SHIFT - 1))) >> SHIFT;
+            error = value - rounded*(1 << SHIFT);
+            outputs[i] = clamp_to_int16(rounded);
+        }
+        checksum += checksum_of(outputs);
+    }
+    print_result("plain error-feedback loop", start, NUM_PASSES, checksum);
+
+    static const struct
+    {
+        fixed_requantize_mode_t mode;
+        const char * name;
+    } modes[] =
+    {
+        {FIXED_REQUANTIZE_HALF_EVEN, "fixed_requantize_i16(), half even"},
+        {FIXED_REQUANTIZE_STOCHASTIC, "fixed_requantize_i16(), stochastic"},
+        {FIXED_REQUANTIZE_ERROR_FEEDBACK, "fixed_requantize_i16(), error feedback"},
+        {FIXED_REQUANTIZE_NOISE_SHAPE_2, "fixed_requantize_i16(), 2nd-order shaping"},
+    };
+    for (size_t m = 0; m < sizeof(modes)/sizeof(modes[0]); m++)
+    {
+        fixed_requantize_t requantize;
+        if (!fixed_requantize_init(&requantize, SHIFT, modes[m].mode, 1))
+        {
+            fprintf(stderr, "fixed_requantize_init() failed.\n");
+            return 1;
+        }
+        checksum = 0;
+        start = now_ns();
+        for (int pass = 0; pass < NUM_PASSES; pass++)
+        {
+            fixed_requantize_i16(&requantize, outputs, samples, NUM_VALUES);
+            checksum += checksum_of(outputs);
+        }
+        print_result(modes[m].name, start, NUM_PASSES, checksum);
+    }
+    return 0;
+}
@@ -0,0 +1,158 @@
+/*
+bench_sort
+- Times sorting a million Q16.16 prices (like an order book's), in nanoseconds per value: std::sort() and qsort() of
+  the prices converted to double, vs. fixed_sort() on 1 and 4 threads, and fixed_sort_pairs() with an index payload.
+- Every sort's scratch buffer comes from the thread's scratch arena; it prints how many times that had to allocate.
+- Then times looking up a million random prices in the sorted array: std::lower_bound(), fixed_lower_bound(), and
+  fixed_eytzinger_lower_bound().
+*/
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+#include "fixed_point_sort.h"
+
+#define NUM_VALUES (1 << 20)
+#define NUM_PASSES 5
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec*1e9 + (double)ts.tv_nsec;
+}
+
+static void print_result(const char * name, double start, int num_passes, uint32_t checksum)
+{
+    printf("%-40s %7.3f ns/value  (checksum %08x)\n", name,
+           (now_ns() - start)/((double)NUM_VALUES*num_passes), checksum);
+}
+
+static int compare_doubles(const void * a, const void * b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+int main(void)
+{
+    // Prices between 90.0 and 110.0, so the top byte is always 0 and fixed_sort() skips that pass.
+    std::vector<fixed_point_t> prices(NUM_VALUES);
+    uint64_t seed = 12345;
+    for (size_t i = 0; i < NUM_VALUES; i++)
+    {
+        seed = seed*6364136223846793005ull + 1442695040888963407ull;
+        prices[i] = (90u << FRACTION_BITS) + (fixed_point_t)((seed >> 32) % (20u << FRACTION_BITS));
+    }
+    std::vector<fixed_point_t> values(NUM_VALUES);
+    std::vector<double> doubles(NUM_VALUES);
+    std::vector<uint32_t> payloads(NUM_VALUES);
+
+    uint32_t checksum = 0;
+    double start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        for (size_t i = 0; i < NUM_VALUES; i++)
+        {
+            doubles[i] = (double)prices[i]/FRACTION_DIVISOR;
+        }
+        std::sort(doubles.begin(), doubles.end());
+        checksum += (uint32_t)(doubles[NUM_VALUES/2]*FRACTION_DIVISOR);
+    }
+    print_result("double + std::sort()", start, NUM_PASSES, checksum);
+
+    checksum = 0;
+    start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        for (size_t i = 0; i < NUM_VALUES; i++)
+        {
+            doubles[i] = (double)prices[i]/FRACTION_DIVISOR;
+        }
+        qsort(doubles.data(), NUM_VALUES, sizeof(doubles[0]), compare_doubles);
+        checksum += (uint32_t)(doubles[NUM_VALUES/2]*FRACTION_DIVISOR);
+    }
+    print_result("double + qsort()", start, NUM_PASSES, checksum);
+
+    checksum = 0;
+    start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        values = prices;
+        std::sort(values.begin(), values.end());
+        checksum += values[NUM_VALUES/2];
+    }
+    print_result("std::sort()", start, NUM_PASSES, checksum);
+
+    // The scratch buffers come from this thread's arena, which only allocates the first time (and for pairs, once
+    // more to grow); every other pass reuses it.
+    uint64_t heap_allocations = fixed_arena_heap_allocations();
+    const unsigned thread_counts[] = {1, 4};
+    for (unsigned num_threads : thread_counts)
+    {
+        checksum = 0;
+        start = now_ns();
+        for (int pass = 0; pass < NUM_PASSES; pass++)
+        {
+            values = prices;
+            fixed_sort(values.data(), NUM_VALUES, num_threads, fixed_arena_thread());
+            checksum += values[NUM_VALUES/2];
+        }
+        char name[64];
+        snprintf(name, sizeof(name), "fixed_sort(), %u thread%s", num_threads, num_threads == 1 ? "" : "s");
+        print_result(name, start, NUM_PASSES, checksum);
+    }
+
+    checksum = 0;
+    start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        values = prices;
+        for (size_t i = 0; i < NUM_VALUES; i++)
+        {
+            payloads[i] = (uint32_t)i;
+        }
+        fixed_sort_pairs(values.data(), payloads.data(), NUM_VALUES, 1, fixed_arena_thread());
+        checksum += values[NUM_VALUES/2] + payloads[NUM_VALUES/2];
+    }
+    print_result("fixed_sort_pairs()", start, NUM_PASSES, checksum);
+    printf("heap allocations for scratch in %d passes: %llu\n", 3*NUM_PASSES,
+           (unsigned long long)(fixed_arena_heap_allocations() - heap_allocations));
+
+    // Searches: every price is looked up in the sorted array.
+    std::vector<fixed_point_t> sorted = prices;
+    fixed_sort(sorted.data(), NUM_VALUES, 1, NULL);
+    std::vector<fixed_point_t> tree(NUM_VALUES + 1);
+    std::vector<size_t> ranks(NUM_VALUES + 1);
+    fixed_eytzinger_build(tree.data(), ranks.data(), sorted.data(), NUM_VALUES);
+
+    checksum = 0;
+    start = now_ns();
+    for (size_t i = 0; i < NUM_VALUES; i++)
+    {
+        checksum += (uint32_t)(std::lower_bound(sorted.begin(), sorted.end(), prices[i]) - sorted.begin());
+    }
+    print_result("std::lower_bound()", start, 1, checksum);
+
+    checksum = 0;
+    start = now_ns();
+    for (size_t i = 0; i < NUM_VALUES; i++)
+    {
+        checksum += (uint32_t)fixed_lower_bound(sorted.data(), NUM_VALUES, prices[i]);
+    }
+    print_result("fixed_lower_bound()", start, 1, checksum);
+
+    checksum = 0;
+    start = now_ns();
+    for (size_t i = 0; i < NUM_VALUES; i++)
+    {
+        checksum += (uint32_t)ranks[fixed_eytzinger_lower_bound(tree.data(), NUM_VALUES, prices[i])];
+    }
+    print_result("fixed_eytzinger_lower_bound()", start, 1, checksum);
+    return 0;
+}
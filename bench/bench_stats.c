@@ -0,0 +1,135 @@
+/*
+bench_stats
+- Times aggregating a million Q16.16 readings, in nanoseconds per reading: mean, variance, min, and max by converting
+  each reading to double first, vs. fixed_stats_add() (exact integer sums), on 1 and 4 threads; and the p50, p99, and
+  p99.9 percentiles by sorting the doubles with qsort() vs. fixed_stats_percentiles()' radix select.
+*/
+
+// For clock_gettime() when compiling with -std=c99.
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "fixed_point_stats.h"
+
+#define NUM_VALUES (1 << 20)
+#define NUM_PASSES 20
+#define NUM_PERCENTILE_PASSES 3
+
+static fixed_point_t readings[NUM_VALUES];
+static double doubles[NUM_VALUES];
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec*1e9 + (double)ts.tv_nsec;
+}
+
+static void print_result(const char * name, double start, int num_passes, uint32_t checksum)
+{
+    printf("%-40s %7.3f ns/value  (checksum %08x)\n", name,
+           (now_ns() - start)/((double)NUM_VALUES*num_passes), checksum);
+}
+
+static int compare_doubles(const void * a, const void * b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+int main(void)
+{
+    // Sensor-like readings: around 1000.0, +- 64.
+    uint64_t seed = 12345;
+    for (size_t i = 0; i < NUM_VALUES; i++)
+    {
+        seed = seed*6364136223846793005ull + 1442695040888963407ull;
+        readings[i] = (1000u << FRACTION_BITS) - (64u << FRACTION_BITS) + (fixed_point_t)(seed >> 41);
+    }
+
+    uint32_t checksum = 0;
+    double start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        readings[pass] ^= 1;
+        double sum = 0.0;
+        double sum_squares = 0.0;
+        double min = 1e300;
+        double max = -1e300;
+        for (size_t i = 0; i < NUM_VALUES; i++)
+        {
+            double x = (double)readings[i]/FRACTION_DIVISOR;
+            sum += x;
+            sum_squares += x*x;
+            min = x < min ? x : min;
+            max = x > max ? x : max;
+        }
+        double mean = sum/NUM_VALUES;
+        double variance = sum_squares/NUM_VALUES - mean*mean;
+        checksum += (uint32_t)(mean*FRACTION_DIVISOR) + (uint32_t)(variance*FRACTION_DIVISOR) + (uint32_t)min
+                    + (uint32_t)max;
+    }
+    print_result("double: mean, variance, min, max", start, NUM_PASSES, checksum);
+
+    checksum = 0;
+    start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        readings[pass] ^= 1;
+        fixed_stats_t stats;
+        fixed_stats_init(&stats);
+        fixed_stats_add(&stats, readings, NUM_VALUES);
+        checksum += fixed_stats_mean(&stats) + (uint32_t)fixed_stats_variance(&stats, false) + stats.min + stats.max;
+    }
+    print_result("fixed_stats_add()", start, NUM_PASSES, checksum);
+
+    checksum = 0;
+    start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        readings[pass] ^= 1;
+        fixed_stats_t stats;
+        fixed_stats_init(&stats);
+        fixed_stats_add_parallel(&stats, readings, NUM_VALUES, 4);
+        checksum += fixed_stats_mean(&stats) + (uint32_t)fixed_stats_variance(&stats, false) + stats.min + stats.max;
+    }
+    print_result("fixed_stats_add_parallel(), 4 threads", start, NUM_PASSES, checksum);
+
+    const fixed_point_t percents[] = {50u << FRACTION_BITS, 99u << FRACTION_BITS,
+                                      (fixed_point_t)(99.9*FRACTION_DIVISOR)};
+    checksum = 0;
+    start = now_ns();
+    for (int pass = 0; pass < NUM_PERCENTILE_PASSES; pass++)
+    {
+        readings[pass] ^= 1;
+        for (size_t i = 0; i < NUM_VALUES; i++)
+        {
+            doubles[i] = (double)readings[i]/FRACTION_DIVISOR;
+        }
+        qsort(doubles, NUM_VALUES, sizeof(doubles[0]), compare_doubles);
+        for (size_t k = 0; k < 3; k++)
+        {
+            // The nearest rank, like fixed_stats_percentiles(): ceil(percent/100 * n), 1-based.
+            uint64_t rank = ((uint64_t)percents[k]*NUM_VALUES + (100u << FRACTION_BITS) - 1)/(100u << FRACTION_BITS);
+            checksum += (uint32_t)(doubles[rank - 1]*FRACTION_DIVISOR);
+        }
+    }
+    print_result("double + qsort(): 3 percentiles", start, NUM_PERCENTILE_PASSES, checksum);
+
+    checksum = 0;
+    start = now_ns();
+    for (int pass = 0; pass < NUM_PERCENTILE_PASSES; pass++)
+    {
+        readings[pass] ^= 1;
+        fixed_point_t out[3];
+        fixed_stats_percentiles(readings, NUM_VALUES, percents, 3, out, 1, fixed_arena_thread());
+        checksum += out[0] + out[1] + out[2];
+    }
+    print_result("fixed_stats_percentiles(): 3 percentiles", start, NUM_PERCENTILE_PASSES, checksum);
+    return 0;
+}
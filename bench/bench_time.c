@@ -0,0 +1,117 @@
+/*
+bench_time
+- Times converting large nanosecond timestamps: to Q32.32 seconds and back, and to the ticks of a 19.2 MHz timer,
+  vs. the naive `ns*to_hz/from_hz` (which overflows) and exact scaling with hardware divides, in nanoseconds per
+  conversion.
+*/
+
+// For clock_gettime() when compiling with -std=c99.
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <time.h>
+
+#include "fixed_point_time.h"
+
+#define NUM_TIMESTAMPS 4096
+#define NUM_PASSES 2000
+
+static uint64_t timestamps[NUM_TIMESTAMPS];
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec*1e9 + (double)ts.tv_nsec;
+}
+
+static void print_result(const char * name, double start, uint64_t checksum)
+{
+    printf("%-40s %7.3f ns/conversion  (checksum %016llx)\n", name,
+           (now_ns() - start)/((double)NUM_TIMESTAMPS*NUM_PASSES), (unsigned long long)checksum);
+}
+
+int main(void)
+{
+    // Nanoseconds since 1970, around late 2023, with a spread of ~11 days.
+    uint64_t seed = 12345;
+    for (size_t i = 0; i < NUM_TIMESTAMPS; i++)
+    {
+        seed = seed*6364136223846793005ull + 1442695040888963407ull;
+        timestamps[i] = 1700000000000000000ull + (seed >> 24);
+    }
+    fixed_clock_scaler_t ns_to_timer;
+    fixed_clock_scaler_init(&ns_to_timer, FIXED_TIME_NS_PER_SECOND, 19200000);
+
+    uint64_t checksum = 0;
+    double start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        for (size_t i = 0; i < NUM_TIMESTAMPS; i++)
+        {
+            checksum += (timestamps[i] + pass)*19200000/FIXED_TIME_NS_PER_SECOND;
+        }
+    }
+    print_result("naive ns*hz/10^9 (overflows!)", start, checksum);
+
+    checksum = 0;
+    start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        for (size_t i = 0; i < NUM_TIMESTAMPS; i++)
+        {
+            // Exact too, but with 2 divide instructions: q*times + round(r*times/divide), where ns == q*divide + r.
+            uint64_t ns = timestamps[i] + pass;
+            checksum += ns/ns_to_timer.divide*ns_to_timer.times
+                + (ns%ns_to_timer.divide*ns_to_timer.times + ns_to_timer.divide/2)/ns_to_timer.divide;
+        }
+    }
+    print_result("exact, with hardware divides", start, checksum);
+
+    checksum = 0;
+    start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        for (size_t i = 0; i < NUM_TIMESTAMPS; i++)
+        {
+            checksum += fixed_clock_scale(&ns_to_timer, (timestamps[i] + pass));
+        }
+    }
+    print_result("fixed_clock_scale() ns -> 19.2 MHz", start, checksum);
+
+    checksum = 0;
+    start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        for (size_t i = 0; i < NUM_TIMESTAMPS; i++)
+        {
+            checksum += fixed_time_from_ns((timestamps[i] + pass));
+        }
+    }
+    print_result("fixed_time_from_ns()", start, checksum);
+
+    checksum = 0;
+    start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        for (size_t i = 0; i < NUM_TIMESTAMPS; i++)
+        {
+            checksum += fixed_time_to_ns((timestamps[i] + pass));
+        }
+    }
+    print_result("fixed_time_to_ns()", start, checksum);
+
+    fixed_tick_rate_t timer;
+    fixed_tick_rate_init(&timer, 19200000);
+    checksum = 0;
+    start = now_ns();
+    for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+        for (size_t i = 0; i < NUM_TIMESTAMPS; i++)
+        {
+            checksum += fixed_time_from_ticks((timestamps[i] + pass) >> 6, &timer);
+        }
+    }
+    print_result("fixed_time_from_ticks() at 19.2 MHz", start, checksum);
+    return 0;
+}
@@ -0,0 +1,109 @@
+/*
+bench_tune
+- Times every exact scaling strategy of fixed_point_tune.h on a grid of value widths and batch sizes, in nanoseconds
+  per value, and prints the tuner's pick for each (which times them again, its own way).
+- With a path argument (ex: `bench_tune /var/tmp/fixed_point_tune`), the tuner's rankings are saved there: the
+  offline way to tune a machine before running the real program with the same cache file.
+*/
+
+// For clock_gettime() when compiling with -std=c99.
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <time.h>
+
+#include "fixed_point_tune.h"
+
+#define MAX_BATCH_SIZE (1 << 16)
+#define NUM_VALUES (1 << 22) // values scaled per timing: many small batches, or a few big ones
+
+static fixed_point_t values32[MAX_BATCH_SIZE];
+static fixed_point_t out32[MAX_BATCH_SIZE];
+static uint64_t values64[MAX_BATCH_SIZE];
+static uint64_t out64[MAX_BATCH_SIZE];
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec*1e9 + (double)ts.tv_nsec;
+}
+
+static void print_result(const char * name, double start, uint32_t checksum)
+{
+    printf("%-40s %7.3f ns/value  (checksum %08x)\n", name, (now_ns() - start)/NUM_VALUES, checksum);
+}
+
+// Time each strategy that's exact for times/divide on batches of `batch_size` `width`-bit values, then ask the tuner.
+static void run(fixed_tuner_t * tuner, uint32_t times, uint32_t divide, uint8_t width, size_t batch_size)
+{
+    uint64_t mask = width >= 64 ? UINT64_MAX : ((uint64_t)1 << width) - 1;
+    uint64_t state = 0x2545F4914F6CDD1DULL;
+    for (size_t i = 0; i < batch_size; i++)
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        values64[i] = state & mask;
+        values32[i] = (fixed_point_t)values64[i];
+    }
+    char name[64];
+    for (unsigned s = 0; s < FIXED_SCALE_NUM_STRATEGIES; s++)
+    {
+        fixed_scaler_t scaler;
+        if (!fixed_scaler_init(&scaler, times, divide, width, (fixed_scale_strategy_t)s, NULL))
+        {
+            continue;
+        }
+        uint32_t checksum = 0;
+        double start = now_ns();
+        for (size_t n = 0; n < NUM_VALUES/batch_size; n++)
+        {
+            if (width <= 32)
+            {
+                fixed_scaler_apply_batch(&scaler, out32, values32, batch_size);
+                checksum += out32[n & (batch_size - 1)];
+            }
+            else
+            {
+                fixed_scaler_apply_batch64(&scaler, out64, values64, batch_size);
+                checksum += (uint32_t)out64[n & (batch_size - 1)];
+            }
+        }
+        snprintf(name, sizeof name, "%-6s (%u bits, batches of %zu)", fixed_scale_strategy_name(scaler.strategy),
+                 width, batch_size);
+        print_result(name, start, checksum);
+        fixed_scaler_free(&scaler);
+    }
+    fixed_scale_strategy_t pick = fixed_tuner_pick(tuner, times, divide, width, batch_size);
+    printf("%-40s %s\n", "  tuner's pick", fixed_scale_strategy_name(pick));
+}
+
+int main(int argc, char ** argv)
+{
+    fixed_tuner_t * tuner = fixed_tuner_open(argc > 1 ? argv[1] : NULL);
+    if (tuner == NULL)
+    {
+        fprintf(stderr, "fixed_tuner_open() failed\n");
+        return 1;
+    }
+    printf("%s\n", fixed_tuner_cpu_model(tuner));
+    static const uint8_t widths[] = {16, 32, 48, 64};
+    static const size_t batch_sizes[] = {16, 1024, MAX_BATCH_SIZE};
+    for (size_t w = 0; w < sizeof widths/sizeof widths[0]; w++)
+    {
+        for (size_t b = 0; b < sizeof batch_sizes/sizeof batch_sizes[0]; b++)
+        {
+            // A 19.2 MHz tick count to nanoseconds (reduces to 625/12), like fixed_point_time.h's conversions.
+            run(tuner, 1000000000, 19200000, widths[w], batch_sizes[b]);
+        }
+    }
+    if (argc > 1 && !fixed_tuner_save(tuner))
+    {
+        fprintf(stderr, "fixed_tuner_save(\"%s\") failed\n", argv[1]);
+        fixed_tuner_close(tuner);
+        return 1;
+    }
+    fixed_tuner_close(tuner);
+    return 0;
+}
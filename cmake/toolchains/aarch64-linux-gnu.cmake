@@ -0,0 +1,20 @@
+# Cross-compile for 64-bit ARM Linux (AArch64) with the GNU cross toolchain, and run the tests under QEMU user mode.
+# - On Debian/Ubuntu: `apt install gcc-aarch64-linux-gnu g++-aarch64-linux-gnu qemu-user`.
+# - Then `cmake --preset cross-aarch64 && cmake --build --preset cross-aarch64 && ctest --preset cross-aarch64`.
+#   test_round's checksum then proves AArch64 rounds exactly like x86-64.
+
+set(CMAKE_SYSTEM_NAME Linux)
+set(CMAKE_SYSTEM_PROCESSOR aarch64)
+
+set(CMAKE_C_COMPILER aarch64-linux-gnu-gcc)
+set(CMAKE_CXX_COMPILER aarch64-linux-gnu-g++)
+
+# Find the target's libraries (ex: libm) and headers in its sysroot, never the build machine's.
+set(CMAKE_FIND_ROOT_PATH /usr/aarch64-linux-gnu)
+set(CMAKE_FIND_ROOT_PATH_MODE_PROGRAM NEVER)
+set(CMAKE_FIND_ROOT_PATH_MODE_LIBRARY ONLY)
+set(CMAKE_FIND_ROOT_PATH_MODE_INCLUDE ONLY)
+set(CMAKE_FIND_ROOT_PATH_MODE_PACKAGE ONLY)
+
+# ctest runs every test through this (see the Tests section of CMakeLists.txt).
+set(CMAKE_CROSSCOMPILING_EMULATOR qemu-aarch64 -L /usr/aarch64-linux-gnu)
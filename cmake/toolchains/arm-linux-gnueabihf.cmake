@@ -0,0 +1,22 @@
+# Cross-compile for 32-bit ARM Linux (ARMv7, hard-float) with the GNU cross toolchain, and run the tests under QEMU
+# user mode.
+# - On Debian/Ubuntu: `apt install gcc-arm-linux-gnueabihf g++-arm-linux-gnueabihf qemu-user`.
+# - Then `cmake --preset cross-armhf && cmake --build --preset cross-armhf && ctest --preset cross-armhf`.
+#   test_round's checksum then proves 32-bit ARM (no 64-bit divide instruction, no `__int128`) rounds exactly like
+#   x86-64.
+
+set(CMAKE_SYSTEM_NAME Linux)
+set(CMAKE_SYSTEM_PROCESSOR arm)
+
+set(CMAKE_C_COMPILER arm-linux-gnueabihf-gcc)
+set(CMAKE_CXX_COMPILER arm-linux-gnueabihf-g++)
+
+# Find the target's libraries (ex: libm) and headers in its sysroot, never the build machine's.
+set(CMAKE_FIND_ROOT_PATH /usr/arm-linux-gnueabihf)
+set(CMAKE_FIND_ROOT_PATH_MODE_PROGRAM NEVER)
+set(CMAKE_FIND_ROOT_PATH_MODE_LIBRARY ONLY)
+set(CMAKE_FIND_ROOT_PATH_MODE_INCLUDE ONLY)
+set(CMAKE_FIND_ROOT_PATH_MODE_PACKAGE ONLY)
+
+# ctest runs every test through this (see the Tests section of CMakeLists.txt).
+set(CMAKE_CROSSCOMPILING_EMULATOR qemu-arm -L /usr/arm-linux-gnueabihf)
@@ -0,0 +1,81 @@
+/*
+fixed_point
+- The fixed-point type and constants shared by the fixed_point_math tutorial and the helper modules built on top of it.
+- The tutorial's basic operations (converting to and from whole numbers, splitting off the fraction, and the
+  `price *= 3; price /= 7;` arithmetic) are inline functions below, so fixed_point_math.cpp's main() is just a demo of
+  them, and other code can call them instead of copying the expressions out of it.
+- Everything here (and in the fixed_point_*.h/.c modules) compiles as both C99 and C++, exactly like
+  fixed_point_math.cpp does.
+- None of it does I/O or keeps hidden state: every function works only on its arguments (and on the objects they
+  point to), so all of it is reentrant and callable from any number of threads at once, as long as threads don't
+  write to the same object. The only process-wide state is documented where it lives, and is thread-safe: the
+  allocation counter and per-thread scratch arenas in fixed_point_arena.h, and the shared plan cache in
+  fixed_point_ratio.h. The only I/O is fixed_point_tune.h's tuner, which reads and writes the cache file it's given
+  (and reads the CPU model, on non-x86 machines, from /proc/cpuinfo).
+- In C++14 and later, the inline functions in the module headers are marked FIXED_CONSTEXPR, so anything computed with
+  them (lookup tables, calibration constants, formatted strings) can be a `constexpr` constant, computed at compile
+  time and placed in read-only data, with no startup code and no static initialization order to worry about. In C,
+  FIXED_CONSTEXPR is nothing, and the macros meant for constant initializers (ex: FIXED_FROM_DECIMAL()) do the same.
+
+References:
+- https://stackoverflow.com/questions/10067510/fixed-point-arithmetic-in-c-programming
+*/
+
+#ifndef FIXED_POINT_H
+#define FIXED_POINT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Define our fixed point type.
+typedef uint32_t fixed_point_t;
+
+#define BITS_PER_BYTE 8
+
+#define FRACTION_BITS 16 // 1 << 16 = 2^16 = 65536
+#define FRACTION_DIVISOR (1 << FRACTION_BITS)
+#define FRACTION_MASK (FRACTION_DIVISOR - 1) // 65535 (all LSB set, all MSB clear)
+
+// What's left for the whole number, and the biggest whole number that fits.
+#define WHOLE_NUM_BITS ((unsigned)sizeof(fixed_point_t)*BITS_PER_BYTE - FRACTION_BITS)
+#define MAX_WHOLE_NUM ((fixed_point_t)(((uint64_t)1 << WHOLE_NUM_BITS) - 1))
+
+// `constexpr` where the language has it with loops and local variables (C++14), and nothing in C.
+#if defined(__cplusplus) && __cplusplus >= 201402L
+#define FIXED_CONSTEXPR constexpr
+#else
+#define FIXED_CONSTEXPR
+#endif
+
+/// @brief      A whole number (0 to MAX_WHOLE_NUM) as a fixed-point number. Bigger ones keep their low bits.
+static inline FIXED_CONSTEXPR fixed_point_t fixed_from_int(uint32_t whole)
+{
+    return (fixed_point_t)(whole << FRACTION_BITS);
+}
+
+/// @brief      The whole-number part (truncated).
+static inline FIXED_CONSTEXPR uint32_t fixed_to_int(fixed_point_t value)
+{
+    return value >> FRACTION_BITS;
+}
+
+/// @brief      The fractional part, in units of 1/FRACTION_DIVISOR.
+static inline FIXED_CONSTEXPR uint32_t fixed_fraction(fixed_point_t value)
+{
+    return value & FRACTION_MASK;
+}
+
+/// @brief      `value * times`, like the tutorial's `price *= 3` (results that don't fit keep their low 32 bits).
+static inline FIXED_CONSTEXPR fixed_point_t fixed_mul_int(fixed_point_t value, uint32_t times)
+{
+    return value * times;
+}
+
+/// @brief      `value / divide`, truncated, like the tutorial's `price /= 7`. `divide` must not be 0. (For
+///             rounded division, see fixed_div_round_u32() in fixed_point_round.h and fixed_point_div.h.)
+static inline FIXED_CONSTEXPR fixed_point_t fixed_div_int_truncate(fixed_point_t value, uint32_t divide)
+{
+    return value / divide;
+}
+
+#endif // FIXED_POINT_H
@@ -0,0 +1,283 @@
+/*
+fixed_point_arena
+- See fixed_point_arena.h.
+- Uses the GCC/Clang `__atomic` builtins and `__thread` (like fixed_point_ratio.c), plus a pthread key to free each
+  thread's scratch arena when the thread exits.
+*/
+
+// For posix_memalign() and pthreads when compiling with -std=c99.
+#define _POSIX_C_SOURCE 200112L
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "fixed_point_arena.h"
+
+// Every heap block any arena has allocated. Only ever incremented, so relaxed atomics are enough.
+static uint64_t heap_allocations = 0;
+
+static __thread fixed_arena_t thread_arena;
+static pthread_key_t thread_arena_key;
+static pthread_once_t thread_arena_key_once = PTHREAD_ONCE_INIT;
+
+static void free_thread_arena(void * arena)
+{
+    fixed_arena_free((fixed_arena_t *)arena);
+}
+
+static void create_thread_arena_key(void)
+{
+    pthread_key_create(&thread_arena_key, free_thread_arena);
+}
+
+static void * allocate_block(size_t capacity, size_t alignment)
+{
+    void * buffer = NULL;
+    // (posix_memalign() needs at least a pointer's alignment.)
+    alignment = alignment > sizeof(void *) ? alignment : sizeof(void *);
+    if (capacity == 0 || posix_memalign(&buffer, alignment, capacity) != 0)
+    {
+        return NULL;
+    }
+    __atomic_fetch_add(&heap_allocations, 1, __ATOMIC_RELAXED);
+    return buffer;
+}
+
+// Replace an empty growable arena's buffer with one of at least `capacity` bytes: at least twice the old size, so a
+// run of growing batches only reallocates O(log n) times.
+static bool grow(fixed_arena_t * arena, size_t capacity)
+{
+    if (!arena->grows || arena->used != 0)
+    {
+        return false;
+    }
+    size_t doubled = arena->capacity > SIZE_MAX / 2 ? SIZE_MAX : arena->capacity * 2;
+    capacity = capacity > doubled ? capacity : doubled;
+    capacity = capacity > FIXED_ARENA_THREAD_MIN_CAPACITY ? capacity : FIXED_ARENA_THREAD_MIN_CAPACITY;
+    void * buffer = allocate_block(capacity, FIXED_ARENA_ALIGNMENT);
+    if (buffer == NULL)
+    {
+        return false;
+    }
+    if (arena->owns_buffer)
+    {
+        free(arena->buffer);
+    }
+    arena->buffer = (uint8_t *)buffer;
+    arena->capacity = capacity;
+    arena->owns_buffer = true;
+    return true;
+}
+
+/// @brief      Create an arena with its own `capacity`-byte block of heap memory (FIXED_ARENA_ALIGNMENT-aligned).
+///             This is the only heap allocation the arena ever makes.
+/// @return     true on success; false if the memory could not be allocated (the arena is then empty, but still safe
+///             to use and to free; every allocation from it will simply fail).
+bool fixed_arena_init(fixed_arena_t * arena, size_t capacity)
+{
+    fixed_arena_init_buffer(arena, NULL, 0);
+    void * buffer = allocate_block(capacity, FIXED_ARENA_ALIGNMENT);
+    if (buffer == NULL)
+    {
+        return false;
+    }
+    fixed_arena_init_buffer(arena, buffer, capacity);
+    arena->owns_buffer = true;
+    return true;
+}
+
+/// @brief      Create an arena on top of memory you already own. fixed_arena_free() will NOT free it.
+void fixed_arena_init_buffer(fixed_arena_t * arena, void * buffer, size_t capacity)
+{
+    arena->buffer = (uint8_t *)buffer;
+    arena->capacity = buffer == NULL ? 0 : capacity;
+    arena->used = 0;
+    arena->owns_buffer = false;
+    arena->grows = false;
+}
+
+static void * try_alloc(fixed_arena_t * arena, size_t size, size_t alignment)
+{
+    // Align the actual address, not just the offset, since a caller-provided buffer may not be aligned itself.
+    uintptr_t base = (uintptr_t)arena->buffer;
+    uintptr_t start = (base + arena->used + (alignment - 1)) & ~(uintptr_t)(alignment - 1);
+    size_t offset = (size_t)(start - base);
+
+    if (arena->buffer == NULL || offset > arena->capacity || size > arena->capacity - offset)
+    {
+        return NULL;
+    }
+    arena->used = offset + size;
+    return arena->buffer + offset;
+}
+
+// Zero-byte allocations that don't fit in the arena's buffer point in here instead (aligned), so they never make an
+// arena grow.
+static uint8_t zero_size_block[2 * FIXED_ARENA_ALIGNMENT];
+
+// A `alignment`-aligned pointer for a zero-byte allocation: the arena's next free byte if it's in the buffer, else
+// `zero_size_block`. Uses none of the arena.
+static void * zero_size_alloc(const fixed_arena_t * arena, size_t alignment)
+{
+    uintptr_t base = (uintptr_t)arena->buffer;
+    uintptr_t start = (base + arena->used + (alignment - 1)) & ~(uintptr_t)(alignment - 1);
+    if (arena->buffer != NULL && (size_t)(start - base) <= arena->capacity)
+    {
+        return arena->buffer + (start - base);
+    }
+    if (alignment > FIXED_ARENA_ALIGNMENT)
+    {
+        return NULL;
+    }
+    base = (uintptr_t)zero_size_block;
+    return zero_size_block + (((base + (alignment - 1)) & ~(uintptr_t)(alignment - 1)) - base);
+}
+
+/// @brief      Allocate `size` bytes from the arena.
+/// @param[in]  alignment   Must be a power of 2. 0 means FIXED_ARENA_ALIGNMENT.
+/// @return     The memory, or NULL if the arena doesn't have enough room left (and, for a thread's scratch arena,
+///             couldn't grow: it only grows while nothing is allocated from it). A zero-byte allocation never uses or
+///             grows the arena: it's an aligned pointer that must not be dereferenced (NULL only if its alignment is
+///             over FIXED_ARENA_ALIGNMENT and the arena's buffer has no room to align in).
+void * fixed_arena_alloc(fixed_arena_t * arena, size_t size, size_t alignment)
+{
+    if (alignment == 0)
+    {
+        alignment = FIXED_ARENA_ALIGNMENT;
+    }
+    if (size == 0)
+    {
+        return zero_size_alloc(arena, alignment);
+    }
+
+    void * memory = try_alloc(arena, size, alignment);
+    // (The new buffer is FIXED_ARENA_ALIGNMENT-aligned, so only bigger alignments need room to align in.)
+    if (memory == NULL && size <= SIZE_MAX - alignment
+        && grow(arena, size + (alignment > FIXED_ARENA_ALIGNMENT ? alignment : 0)))
+    {
+        memory = try_alloc(arena, size, alignment);
+    }
+    return memory;
+}
+
+/// @brief      Allocate `size` bytes from `arena`, or from the heap if `arena` is NULL (what a NULL arena argument
+///             means everywhere in these modules). Heap blocks count in fixed_arena_heap_allocations().
+/// @param[in]  alignment   Must be a power of 2. 0 means FIXED_ARENA_ALIGNMENT.
+/// @return     The memory, or NULL if there isn't enough. Give it back with fixed_arena_free_or_heap().
+void * fixed_arena_alloc_or_heap(fixed_arena_t * arena, size_t size, size_t alignment)
+{
+    if (arena != NULL)
+    {
+        return fixed_arena_alloc(arena, size, alignment);
+    }
+    // (At least 1 byte, so that success is never NULL.)
+    return allocate_block(size == 0 ? 1 : size, alignment == 0 ? FIXED_ARENA_ALIGNMENT : alignment);
+}
+
+/// @brief      Free memory from fixed_arena_alloc_or_heap() with the same `arena`: heap memory is freed, and arena
+///             memory is left for the arena's next reset.
+void fixed_arena_free_or_heap(fixed_arena_t * arena, void * memory)
+{
+    if (arena == NULL)
+    {
+        free(memory);
+    }
+}
+
+/// @brief      Release everything allocated from the arena at once, keeping the memory for reuse.
+void fixed_arena_reset(fixed_arena_t * arena)
+{
+    arena->used = 0;
+}
+
+/// @brief      Free the arena's memory if fixed_arena_init() (or growing) allocated it. The arena is left empty. A
+///             thread's scratch arena stays usable, and grows again when next needed, so this is how to give its
+///             memory back after an unusually big batch.
+void fixed_arena_free(fixed_arena_t * arena)
+{
+    bool grows = arena->grows;
+    if (arena->owns_buffer)
+    {
+        free(arena->buffer);
+    }
+    fixed_arena_init_buffer(arena, NULL, 0);
+    arena->grows = grows;
+}
+
+/// @brief      How much of the arena is in use, to pass to fixed_arena_release() later.
+size_t fixed_arena_mark(const fixed_arena_t * arena)
+{
+    return arena->used;
+}
+
+/// @brief      Release everything allocated from the arena since fixed_arena_mark() returned `mark`, and nothing
+///             before it. Like fixed_arena_reset(), but nestable: a batch can take scratch memory from an arena its
+///             caller is also using, and give back exactly what it took.
+void fixed_arena_release(fixed_arena_t * arena, size_t mark)
+{
+    if (mark < arena->used)
+    {
+        arena->used = mark;
+    }
+}
+
+/// @brief      Make sure a thread's scratch arena has at least `capacity` bytes, so batches that fit never allocate
+///             (ex: before a real-time loop). Only grows while the arena is empty.
+/// @return     true if the arena now has at least `capacity` bytes.
+bool fixed_arena_reserve(fixed_arena_t * arena, size_t capacity)
+{
+    return arena->capacity >= capacity || grow(arena, capacity);
+}
+
+/// @brief      This thread's scratch arena (see fixed_point_arena.h), to pass to batch kernels as their scratch
+///             arena. If you allocate from it yourself, give the memory back with fixed_arena_mark() and
+///             fixed_arena_release() rather than fixed_arena_reset(), which would also free a caller's.
+/// @return     The arena; never NULL (but allocating from it fails if it can't grow).
+fixed_arena_t * fixed_arena_thread(void)
+{
+    if (!thread_arena.grows)
+    {
+        pthread_once(&thread_arena_key_once, create_thread_arena_key);
+        // Without the destructor the buffer would leak when the thread exits, so only grow once it's registered.
+        thread_arena.grows = pthread_setspecific(thread_arena_key, &thread_arena) == 0;
+    }
+    return &thread_arena;
+}
+
+/// @brief      The total number of heap blocks all arenas (including every thread's scratch arena) have allocated so
+///             far. For tests: once warmed up, a loop of batches should leave this unchanged.
+uint64_t fixed_arena_heap_allocations(void)
+{
+    return __atomic_load_n(&heap_allocations, __ATOMIC_RELAXED);
+}
+
+/// @brief      Get `size` bytes (FIXED_ARENA_ALIGNMENT-aligned) of scratch memory for one call of a batch kernel, from
+///             `arena`, or from the heap if `arena` is NULL. If `arena` is this thread's scratch arena
+///             (fixed_arena_thread()) and it's full and can't grow because the caller is using it too, falls back to
+///             the heap. Give the memory back with fixed_scratch_end().
+/// @return     The memory, or NULL if there isn't enough (then there's nothing to give back).
+void * fixed_scratch_begin(fixed_scratch_t * scratch, fixed_arena_t * arena, size_t size)
+{
+    scratch->arena = arena;
+    scratch->mark = arena != NULL ? fixed_arena_mark(arena) : 0;
+    scratch->heap = NULL;
+    void * memory = arena != NULL ? fixed_arena_alloc(arena, size, 0) : NULL;
+    if (memory == NULL && (arena == NULL || arena == &thread_arena))
+    {
+        // (At least 1 byte, so that success is never a NULL `heap`.)
+        scratch->heap = allocate_block(size == 0 ? 1 : size, FIXED_ARENA_ALIGNMENT);
+        memory = scratch->heap;
+    }
+    return memory;
+}
+
+/// @brief      Give back the memory from fixed_scratch_begin(), and everything allocated from the arena since.
+void fixed_scratch_end(fixed_scratch_t * scratch)
+{
+    free(scratch->heap);
+    scratch->heap = NULL;
+    if (scratch->arena != NULL)
+    {
+        fixed_arena_release(scratch->arena, scratch->mark);
+    }
+}
@@ -0,0 +1,80 @@
+/*
+fixed_point_arena
+- A tiny "bump" (arena) allocator for fixed-point scratch and column storage.
+- Allocating is just rounding an offset up to the requested alignment and adding the size; nothing is freed
+  individually. Instead, the whole arena is reset at once (ex: once per batch), so there is no per-allocation
+  malloc()/free() cost and no fragmentation.
+- The backing memory is either a buffer you already own (a static array, a stack array, etc.) or one block allocated
+  once on the heap by fixed_arena_init().
+- Every thread also gets its own scratch arena, fixed_arena_thread(), for the batch kernels that need temporary
+  memory (ex: fixed_sort(), fixed_stats_percentiles()): pass it as their arena instead of NULL (which, as for every
+  arena argument in these modules, means the heap), and they stop calling malloc() and free() every time. It starts
+  empty and grows (to the biggest batch so far) only when it's empty, so nothing allocated from it
+  ever moves; after the first few batches it has room for all of them, and a batch costs no heap allocations at all.
+  Each kernel gives back what it took before returning (fixed_scratch_begin() / fixed_scratch_end()), so it's safe
+  to call them while you have scratch allocated from it yourself; if it's then too full and can't grow, they fall
+  back to the heap for that call. It's freed when the thread exits.
+- fixed_arena_alloc_or_heap() is how the modules that keep storage (columns, BFP arrays, FFT plans, scalers) take it
+  from their arena, or from the heap when it's NULL.
+- fixed_arena_heap_allocations() counts every heap block any arena has allocated, and every one that
+  fixed_arena_alloc_or_heap() took in place of an arena, so a test can check that a loop of batches doesn't allocate
+  once it's warmed up.
+*/
+
+#ifndef FIXED_POINT_ARENA_H
+#define FIXED_POINT_ARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Default alignment of every arena allocation: one cache line, which is also a whole number of SIMD registers for
+// every vector width up to AVX-512.
+#define FIXED_ARENA_ALIGNMENT 64
+
+typedef struct fixed_arena_s
+{
+    uint8_t * buffer;
+    size_t capacity; // bytes
+    size_t used;     // bytes
+    bool owns_buffer;
+    bool grows;      // whether it replaces its buffer with a bigger one when it's empty and too small (thread arenas)
+} fixed_arena_t;
+
+// The smallest buffer a thread's scratch arena allocates.
+#define FIXED_ARENA_THREAD_MIN_CAPACITY (64 * 1024)
+
+// One batch kernel call's scratch memory: see fixed_scratch_begin().
+typedef struct fixed_scratch_s
+{
+    fixed_arena_t * arena; // where it came from
+    size_t mark;           // the arena's fixed_arena_mark() before
+    void * heap;           // non-NULL if it came from the heap instead
+} fixed_scratch_t;
+
+bool fixed_arena_init(fixed_arena_t * arena, size_t capacity);
+void fixed_arena_init_buffer(fixed_arena_t * arena, void * buffer, size_t capacity);
+void * fixed_arena_alloc(fixed_arena_t * arena, size_t size, size_t alignment);
+void * fixed_arena_alloc_or_heap(fixed_arena_t * arena, size_t size, size_t alignment);
+void fixed_arena_free_or_heap(fixed_arena_t * arena, void * memory);
+void fixed_arena_reset(fixed_arena_t * arena);
+void fixed_arena_free(fixed_arena_t * arena);
+
+size_t fixed_arena_mark(const fixed_arena_t * arena);
+void fixed_arena_release(fixed_arena_t * arena, size_t mark);
+bool fixed_arena_reserve(fixed_arena_t * arena, size_t capacity);
+fixed_arena_t * fixed_arena_thread(void);
+uint64_t fixed_arena_heap_allocations(void);
+
+void * fixed_scratch_begin(fixed_scratch_t * scratch, fixed_arena_t * arena, size_t size);
+void fixed_scratch_end(fixed_scratch_t * scratch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIXED_POINT_ARENA_H
@@ -0,0 +1,738 @@
+/*
+fixed_point_bfp
+- See fixed_point_bfp.h.
+- Every operation works one block at a time, on the block's mantissas widened to `int32_t` in a small array on the
+  stack ("lanes"), and ends with store_block(), which normalizes them and writes them back at the storage's width.
+*/
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE4_1__)
+#include <smmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+#include "fixed_point_bfp.h"
+
+#define SIGN_BIT 0x80000000u
+
+// -----------------------------------------------------------------------------------------------------------------
+// Lanes: a block's values as int32_t. `count` is always a multiple of 8.
+// -----------------------------------------------------------------------------------------------------------------
+
+// A uint32_t's bits as an int32_t, without the implementation-defined conversion of values over INT32_MAX.
+static int32_t to_signed(uint32_t x)
+{
+    return x <= INT32_MAX ? (int32_t)x : -(int32_t)(~x) - 1;
+}
+
+static uint32_t magnitude_mask_one(int32_t x)
+{
+    return (uint32_t)x ^ (x < 0 ? UINT32_MAX : 0);
+}
+
+// The leading-zero scan: the smallest `bits` such that every value is in [-2^bits, 2^bits), or -1 if they're all 0.
+// ORs together each value XOR its sign (which is the value for non-negative ones, and -value - 1 for negative ones),
+// then counts the leading zeros of that once. (-1 XOR its sign is 0 too, so the values themselves are ORed together
+// as well, to tell all zeros from zeros and -1s.)
+static int magnitude_bits(const int32_t * lanes, size_t count)
+{
+    uint32_t mask = 0;
+    uint32_t nonzero = 0;
+    size_t i = 0;
+#if defined(__AVX2__)
+    __m256i mask8 = _mm256_setzero_si256();
+    __m256i nonzero8 = _mm256_setzero_si256();
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(lanes + i));
+        mask8 = _mm256_or_si256(mask8, _mm256_xor_si256(x, _mm256_srai_epi32(x, 31)));
+        nonzero8 = _mm256_or_si256(nonzero8, x);
+    }
+    // (Both ORs reduced at once: the masks in the low 64 bits, the values in the high 64 bits.)
+    __m128i mask4 = _mm_or_si128(_mm256_castsi256_si128(mask8), _mm256_extracti128_si256(mask8, 1));
+    __m128i nonzero4 = _mm_or_si128(_mm256_castsi256_si128(nonzero8), _mm256_extracti128_si256(nonzero8, 1));
+    mask4 = _mm_or_si128(_mm_unpacklo_epi64(mask4, nonzero4), _mm_unpackhi_epi64(mask4, nonzero4));
+    mask4 = _mm_or_si128(mask4, _mm_shuffle_epi32(mask4, _MM_SHUFFLE(2, 3, 0, 1)));
+    mask |= (uint32_t)_mm_cvtsi128_si32(mask4);
+    nonzero |= (uint32_t)_mm_cvtsi128_si32(_mm_unpackhi_epi64(mask4, mask4));
+#elif defined(__SSE2__)
+    __m128i mask4 = _mm_setzero_si128();
+    __m128i nonzero4 = _mm_setzero_si128();
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *)(lanes + i));
+        mask4 = _mm_or_si128(mask4, _mm_xor_si128(x, _mm_srai_epi32(x, 31)));
+        nonzero4 = _mm_or_si128(nonzero4, x);
+    }
+    // (Both ORs reduced at once: the masks in the low 64 bits, the values in the high 64 bits.)
+    mask4 = _mm_or_si128(_mm_unpacklo_epi64(mask4, nonzero4), _mm_unpackhi_epi64(mask4, nonzero4));
+    mask4 = _mm_or_si128(mask4, _mm_shuffle_epi32(mask4, _MM_SHUFFLE(2, 3, 0, 1)));
+    mask |= (uint32_t)_mm_cvtsi128_si32(mask4);
+    nonzero |= (uint32_t)_mm_cvtsi128_si32(_mm_unpackhi_epi64(mask4, mask4));
+#endif
+    for (; i < count; i++)
+    {
+        mask |= magnitude_mask_one(lanes[i]);
+        nonzero |= (uint32_t)lanes[i];
+    }
+    return nonzero == 0 ? -1 : mask == 0 ? 0 : 32 - __builtin_clz(mask);
+}
+
+// `x / 2^shift` (shift 1 to 31), rounded half up: the floor (biased to be non-negative first, since right-shifting a
+// negative number is implementation-defined in C), plus the highest bit shifted out.
+static int32_t shift_right_round_one(int32_t x, unsigned shift)
+{
+    int32_t floored = (int32_t)(((uint32_t)x ^ SIGN_BIT) >> shift) - (int32_t)(SIGN_BIT >> shift);
+    return floored + (int32_t)(((uint32_t)x >> (shift - 1)) & 1);
+}
+
+#if defined(__SSE2__) && !defined(__AVX2__)
+
+static __m128i clamp_epi32(__m128i y, __m128i lo, __m128i hi)
+{
+#if defined(__SSE4_1__)
+    return _mm_min_epi32(_mm_max_epi32(y, lo), hi);
+#else
+    __m128i low = _mm_cmplt_epi32(y, lo);
+    y = _mm_or_si128(_mm_andnot_si128(low, y), _mm_and_si128(low, lo));
+    __m128i high = _mm_cmpgt_epi32(y, hi);
+    return _mm_or_si128(_mm_andnot_si128(high, y), _mm_and_si128(high, hi));
+#endif
+}
+
+#endif
+
+static int32_t max_lane(const int32_t * lanes, size_t count)
+{
+    int32_t max = INT32_MIN;
+    size_t i = 0;
+#if defined(__AVX2__)
+    __m256i max8 = _mm256_set1_epi32(INT32_MIN);
+    for (; i + 8 <= count; i += 8)
+    {
+        max8 = _mm256_max_epi32(max8, _mm256_loadu_si256((const __m256i *)(lanes + i)));
+    }
+    __m128i max4 = _mm_max_epi32(_mm256_castsi256_si128(max8), _mm256_extracti128_si256(max8, 1));
+    max4 = _mm_max_epi32(max4, _mm_shuffle_epi32(max4, _MM_SHUFFLE(1, 0, 3, 2)));
+    max4 = _mm_max_epi32(max4, _mm_shuffle_epi32(max4, _MM_SHUFFLE(2, 3, 0, 1)));
+    max = _mm_cvtsi128_si32(max4);
+#elif defined(__SSE4_1__)
+    __m128i max4 = _mm_set1_epi32(INT32_MIN);
+    for (; i + 4 <= count; i += 4)
+    {
+        max4 = _mm_max_epi32(max4, _mm_loadu_si128((const __m128i *)(lanes + i)));
+    }
+    max4 = _mm_max_epi32(max4, _mm_shuffle_epi32(max4, _MM_SHUFFLE(1, 0, 3, 2)));
+    max4 = _mm_max_epi32(max4, _mm_shuffle_epi32(max4, _MM_SHUFFLE(2, 3, 0, 1)));
+    max = _mm_cvtsi128_si32(max4);
+#endif
+    for (; i < count; i++)
+    {
+        max = lanes[i] > max ? lanes[i] : max;
+    }
+    return max;
+}
+
+// lanes[i] = round(lanes[i] / 2^shift), rounded half up, then clamped to [-hi - 1, hi]. `shift` >= 1.
+static void shift_right_round(int32_t * lanes, size_t count, unsigned shift, int32_t hi)
+{
+    if (shift >= 32)
+    {
+        // Every int32_t rounds to 0: even INT32_MIN / 2^32 is only -1/2, which rounds up.
+        memset(lanes, 0, count * sizeof(int32_t));
+        return;
+    }
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m128i SHIFT = _mm_cvtsi32_si128((int)shift);
+    const __m128i HALF_SHIFT = _mm_cvtsi32_si128((int)shift - 1);
+    const __m256i ONE = _mm256_set1_epi32(1);
+    const __m256i HI = _mm256_set1_epi32(hi);
+    const __m256i LO = _mm256_set1_epi32(-hi - 1);
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(lanes + i));
+        __m256i half = _mm256_and_si256(_mm256_srl_epi32(x, HALF_SHIFT), ONE);
+        __m256i y = _mm256_add_epi32(_mm256_sra_epi32(x, SHIFT), half);
+        _mm256_storeu_si256((__m256i *)(lanes + i), _mm256_min_epi32(_mm256_max_epi32(y, LO), HI));
+    }
+#elif defined(__SSE2__)
+    const __m128i SHIFT = _mm_cvtsi32_si128((int)shift);
+    const __m128i HALF_SHIFT = _mm_cvtsi32_si128((int)shift - 1);
+    const __m128i ONE = _mm_set1_epi32(1);
+    const __m128i HI = _mm_set1_epi32(hi);
+    const __m128i LO = _mm_set1_epi32(-hi - 1);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *)(lanes + i));
+        __m128i half = _mm_and_si128(_mm_srl_epi32(x, HALF_SHIFT), ONE);
+        __m128i y = _mm_add_epi32(_mm_sra_epi32(x, SHIFT), half);
+        _mm_storeu_si128((__m128i *)(lanes + i), clamp_epi32(y, LO, HI));
+    }
+#endif
+    for (; i < count; i++)
+    {
+        int32_t y = shift_right_round_one(lanes[i], shift);
+        lanes[i] = y > hi ? hi : y < -hi - 1 ? -hi - 1 : y;
+    }
+}
+
+// lanes[i] = lanes[i] * 2^shift, saturated to [INT32_MIN, INT32_MAX]. `shift` >= 1.
+static void shift_left_saturate(int32_t * lanes, size_t count, unsigned shift)
+{
+    if (shift >= 32)
+    {
+        // Only 0 fits.
+        for (size_t i = 0; i < count; i++)
+        {
+            lanes[i] = lanes[i] > 0 ? INT32_MAX : lanes[i] < 0 ? INT32_MIN : 0;
+        }
+        return;
+    }
+    int32_t limit = (int32_t)(SIGN_BIT >> shift);
+    for (size_t i = 0; i < count; i++)
+    {
+        int32_t x = lanes[i];
+        lanes[i] = x >= limit ? INT32_MAX : x < -limit ? INT32_MIN : to_signed((uint32_t)x << shift);
+    }
+}
+
+// A memcpy() of a block, which is short, and a multiple of 8 values: copying it with vector moves is much faster than
+// calling memcpy(), whose size isn't known at compile time.
+static void copy_lanes(int32_t * out, const int32_t * in, size_t count)
+{
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 8 <= count; i += 8)
+    {
+        _mm256_storeu_si256((__m256i *)(out + i), _mm256_loadu_si256((const __m256i *)(in + i)));
+    }
+#elif defined(__SSE2__)
+    for (; i + 4 <= count; i += 4)
+    {
+        _mm_storeu_si128((__m128i *)(out + i), _mm_loadu_si128((const __m128i *)(in + i)));
+    }
+#endif
+    for (; i < count; i++)
+    {
+        out[i] = in[i];
+    }
+}
+
+// out[i] = a[i] + b[i], or a[i] - b[i]. Can't overflow: normalized mantissas (and aligned ones, which are smaller)
+// have a bit of headroom.
+static void add_lanes(int32_t * out, const int32_t * a, const int32_t * b, size_t count, bool subtract)
+{
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i va = _mm256_loadu_si256((const __m256i *)(a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i *)(b + i));
+        _mm256_storeu_si256((__m256i *)(out + i), subtract ? _mm256_sub_epi32(va, vb) : _mm256_add_epi32(va, vb));
+    }
+#elif defined(__SSE2__)
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+        _mm_storeu_si128((__m128i *)(out + i), subtract ? _mm_sub_epi32(va, vb) : _mm_add_epi32(va, vb));
+    }
+#endif
+    for (; i < count; i++)
+    {
+        out[i] = subtract ? a[i] - b[i] : a[i] + b[i];
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------
+// Blocks
+// -----------------------------------------------------------------------------------------------------------------
+
+// The largest normalized mantissa; they're all in [-TOP - 1, TOP].
+static int32_t top_mantissa(const fixed_bfp_t * bfp)
+{
+    return (int32_t)((1u << (bfp->mantissa_bits - 2)) - 1);
+}
+
+static void load_block(const fixed_bfp_t * bfp, size_t block, int32_t * lanes)
+{
+    size_t start = block * bfp->block_size;
+    if (bfp->mantissa_bits == 32)
+    {
+        copy_lanes(lanes, bfp->mantissas32 + start, bfp->block_size);
+        return;
+    }
+    const int16_t * mantissas = bfp->mantissas16 + start;
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 8 <= bfp->block_size; i += 8)
+    {
+        __m256i x = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(mantissas + i)));
+        _mm256_storeu_si256((__m256i *)(lanes + i), x);
+    }
+#elif defined(__SSE2__)
+    for (; i + 8 <= bfp->block_size; i += 8)
+    {
+        // Sign-extended by putting each int16_t in the top half of an int32_t, then shifting it back down.
+        __m128i x = _mm_loadu_si128((const __m128i *)(mantissas + i));
+        _mm_storeu_si128((__m128i *)(lanes + i), _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16));
+        _mm_storeu_si128((__m128i *)(lanes + i + 4), _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16));
+    }
+#endif
+    for (; i < bfp->block_size; i++)
+    {
+        lanes[i] = mantissas[i];
+    }
+}
+
+static void store_zero_block(fixed_bfp_t * bfp, size_t block)
+{
+    size_t start = block * bfp->block_size;
+    if (bfp->mantissa_bits == 32)
+    {
+        memset(bfp->mantissas32 + start, 0, bfp->block_size * sizeof(int32_t));
+    }
+    else
+    {
+        memset(bfp->mantissas16 + start, 0, bfp->block_size * sizeof(int16_t));
+    }
+    bfp->exponents[block] = FIXED_BFP_ZERO_EXPONENT;
+}
+
+// Normalize a block's values, `lanes[i] * 2^exponent`, and store them as block number `block`.
+static void store_block(fixed_bfp_t * bfp, size_t block, int32_t * lanes, int64_t exponent)
+{
+    size_t count = bfp->block_size;
+    int bits = magnitude_bits(lanes, count);
+    if (bits < 0)
+    {
+        store_zero_block(bfp, block);
+        return;
+    }
+
+    // Shift so the biggest one has exactly the top bits: down (rounding) if it's too big, up (exactly) if too small.
+    int32_t top = top_mantissa(bfp);
+    int64_t shift = (int64_t)bits - (int64_t)(bfp->mantissa_bits - 2);
+    if (shift > 0 && max_lane(lanes, count) >= ((int64_t)1 << bits) - ((int64_t)1 << (shift - 1)))
+    {
+        // Rounding the biggest one up would carry into the next bit (ex: 2*top + 1 / 2 rounds to top + 1), so shift
+        // one more. (Only positive ones can: the most negative ones round to exactly -top - 1.)
+        shift++;
+    }
+    exponent += shift;
+    if (exponent > FIXED_BFP_MAX_EXPONENT)
+    {
+        // Too big for any exponent: saturate.
+        for (size_t i = 0; i < count; i++)
+        {
+            lanes[i] = lanes[i] > 0 ? top : lanes[i] < 0 ? -top - 1 : 0;
+        }
+        exponent = FIXED_BFP_MAX_EXPONENT;
+        shift = 0;
+    }
+    bool underflow = exponent < FIXED_BFP_MIN_EXPONENT;
+    if (underflow)
+    {
+        // Too small: shift down further, to the smallest exponent (like floating point's gradual underflow).
+        shift += FIXED_BFP_MIN_EXPONENT - exponent;
+        exponent = FIXED_BFP_MIN_EXPONENT;
+    }
+    if (shift > 0)
+    {
+        shift_right_round(lanes, count, shift > 32 ? 32 : (unsigned)shift, top);
+        // (Only underflowing can round every value to 0; otherwise the biggest one still has all the top bits.)
+        if (underflow && magnitude_bits(lanes, count) < 0)
+        {
+            store_zero_block(bfp, block);
+            return;
+        }
+    }
+    else if (shift < 0)
+    {
+        shift_left_saturate(lanes, count, (unsigned)-shift);
+    }
+
+    size_t start = block * bfp->block_size;
+    if (bfp->mantissa_bits == 32)
+    {
+        copy_lanes(bfp->mantissas32 + start, lanes, count);
+    }
+    else
+    {
+        // (The values fit, so packing's saturation never kicks in.)
+        int16_t * mantissas = bfp->mantissas16 + start;
+        size_t i = 0;
+#if defined(__SSE2__)
+        for (; i + 8 <= count; i += 8)
+        {
+            __m128i low = _mm_loadu_si128((const __m128i *)(lanes + i));
+            __m128i high = _mm_loadu_si128((const __m128i *)(lanes + i + 4));
+            _mm_storeu_si128((__m128i *)(mantissas + i), _mm_packs_epi32(low, high));
+        }
+#endif
+        for (; i < count; i++)
+        {
+            mantissas[i] = (int16_t)lanes[i];
+        }
+    }
+    bfp->exponents[block] = (int16_t)exponent;
+}
+
+// The number of values of block number `block` that are in the array (the rest of the last block is padding).
+static size_t values_in_block(const fixed_bfp_t * bfp, size_t block)
+{
+    size_t start = block * bfp->block_size;
+    return bfp->size - start < bfp->block_size ? bfp->size - start : bfp->block_size;
+}
+
+static bool same_shape(const fixed_bfp_t * a, const fixed_bfp_t * b)
+{
+    return a->size == b->size && a->block_size == b->block_size && a->mantissa_bits == b->mantissa_bits;
+}
+
+// -----------------------------------------------------------------------------------------------------------------
+// Public functions
+// -----------------------------------------------------------------------------------------------------------------
+
+/// @brief      Create a block floating point array of `size` values, all 0.
+/// @param[in]  block_size      Values per block: a multiple of 8 from FIXED_BFP_MIN_BLOCK_SIZE to
+///                             FIXED_BFP_MAX_BLOCK_SIZE. Smaller blocks follow the data's range more closely; bigger
+///                             ones store fewer exponents.
+/// @param[in]  mantissa_bits   16 or 32.
+/// @param[in]  arena           Where to get the storage from, or NULL to use the heap. Arena-backed arrays must not
+///                             outlive the next fixed_arena_reset() of their arena.
+/// @return     false if an argument is out of range, or the storage could not be allocated.
+bool fixed_bfp_init(fixed_bfp_t * bfp, size_t size, unsigned block_size, unsigned mantissa_bits,
+                    fixed_arena_t * arena)
+{
+    memset(bfp, 0, sizeof(*bfp));
+    if (block_size < FIXED_BFP_MIN_BLOCK_SIZE || block_size > FIXED_BFP_MAX_BLOCK_SIZE || block_size % 8 != 0
+        || (mantissa_bits != 16 && mantissa_bits != 32))
+    {
+        return false;
+    }
+    size_t num_blocks = size / block_size + (size % block_size != 0);
+    size_t mantissa_size = mantissa_bits / 8;
+    if (num_blocks > (SIZE_MAX - FIXED_ARENA_ALIGNMENT) / (block_size * mantissa_size + sizeof(int16_t)))
+    {
+        return false;
+    }
+    // One allocation: the mantissas, then the exponents.
+    size_t mantissa_bytes = num_blocks * block_size * mantissa_size;
+    size_t num_bytes = mantissa_bytes + num_blocks * sizeof(int16_t);
+    void * memory = fixed_arena_alloc_or_heap(arena, num_bytes, FIXED_ARENA_ALIGNMENT);
+    if (memory == NULL)
+    {
+        return false;
+    }
+    memset(memory, 0, mantissa_bytes);
+
+    bfp->mantissas32 = mantissa_bits == 32 ? (int32_t *)memory : NULL;
+    bfp->mantissas16 = mantissa_bits == 16 ? (int16_t *)memory : NULL;
+    bfp->exponents = (int16_t *)((uint8_t *)memory + mantissa_bytes);
+    bfp->size = size;
+    bfp->num_blocks = num_blocks;
+    bfp->block_size = (uint8_t)block_size;
+    bfp->mantissa_bits = (uint8_t)mantissa_bits;
+    bfp->arena = arena;
+    for (size_t block = 0; block < num_blocks; block++)
+    {
+        bfp->exponents[block] = FIXED_BFP_ZERO_EXPONENT;
+    }
+    return true;
+}
+
+/// @brief      Free a heap-backed array's storage. Arena-backed storage is given back by resetting the arena.
+void fixed_bfp_free(fixed_bfp_t * bfp)
+{
+    fixed_arena_free_or_heap(bfp->arena, bfp->mantissas32 != NULL ? (void *)bfp->mantissas32
+                                                                   : (void *)bfp->mantissas16);
+    memset(bfp, 0, sizeof(*bfp));
+}
+
+/// @brief      Set the array's `size` values from `in`, which have `fraction_bits` fraction bits. Exact, unless a
+///             block's values need more bits than its mantissas have (then they're rounded half up).
+void fixed_bfp_from_int32(fixed_bfp_t * bfp, const int32_t * in, unsigned fraction_bits)
+{
+    int32_t lanes[FIXED_BFP_MAX_BLOCK_SIZE];
+    for (size_t block = 0; block < bfp->num_blocks; block++)
+    {
+        size_t count = values_in_block(bfp, block);
+        memcpy(lanes, in + block * bfp->block_size, count * sizeof(int32_t));
+        memset(lanes + count, 0, (bfp->block_size - count) * sizeof(int32_t));
+        store_block(bfp, block, lanes, -(int64_t)fraction_bits);
+    }
+}
+
+/// @brief      Write the array's `size` values to `out`, with `fraction_bits` fraction bits: rounded half up, and
+///             saturated to [INT32_MIN, INT32_MAX].
+void fixed_bfp_to_int32(const fixed_bfp_t * bfp, int32_t * out, unsigned fraction_bits)
+{
+    int32_t lanes[FIXED_BFP_MAX_BLOCK_SIZE];
+    for (size_t block = 0; block < bfp->num_blocks; block++)
+    {
+        size_t count = values_in_block(bfp, block);
+        int32_t * values = out + block * bfp->block_size;
+        if (bfp->exponents[block] == FIXED_BFP_ZERO_EXPONENT)
+        {
+            memset(values, 0, count * sizeof(int32_t));
+            continue;
+        }
+        load_block(bfp, block, lanes);
+        int32_t shift = -(bfp->exponents[block] + (int32_t)fraction_bits);
+        if (shift > 0)
+        {
+            shift_right_round(lanes, bfp->block_size, shift > 32 ? 32 : (unsigned)shift, INT32_MAX);
+        }
+        else if (shift < 0)
+        {
+            shift_left_saturate(lanes, bfp->block_size, -shift > 32 ? 32 : (unsigned)-shift);
+        }
+        memcpy(values, lanes, count * sizeof(int32_t));
+    }
+}
+
+/// @brief      Set the array's `size` values from doubles, each rounded half up to its block's mantissa. NaNs become
+///             0, and infinities the biggest number.
+void fixed_bfp_from_double(fixed_bfp_t * bfp, const double * in)
+{
+    int32_t lanes[FIXED_BFP_MAX_BLOCK_SIZE];
+    double values[FIXED_BFP_MAX_BLOCK_SIZE];
+    for (size_t block = 0; block < bfp->num_blocks; block++)
+    {
+        size_t count = values_in_block(bfp, block);
+        double max = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            double x = in[block * bfp->block_size + i];
+            x = x != x ? 0 : x > DBL_MAX ? DBL_MAX : x < -DBL_MAX ? -DBL_MAX : x;
+            values[i] = x;
+            max = fabs(x) > max ? fabs(x) : max;
+        }
+        if (max == 0)
+        {
+            store_zero_block(bfp, block);
+            continue;
+        }
+        // max = fraction * 2^max_exponent, fraction in [0.5, 1): scale so it's just under 2^(mantissa_bits - 2).
+        int max_exponent;
+        frexp(max, &max_exponent);
+        int exponent = max_exponent - (bfp->mantissa_bits - 2);
+        int32_t top = top_mantissa(bfp);
+        for (;;)
+        {
+            // Exact: scaling by a power of 2, and the scaled value has at most 30 bits before the point. Rounded by
+            // comparing the part below the point, since adding 1/2 first can round (ex: 0.5 - 2^-54 + 0.5 is 1).
+            bool carried = false;
+            for (size_t i = 0; i < count; i++)
+            {
+                double scaled = ldexp(values[i], -exponent);
+                double floored = floor(scaled);
+                lanes[i] = (int32_t)floored + (scaled - floored >= 0.5);
+                carried |= lanes[i] > top;
+            }
+            if (!carried)
+            {
+                break;
+            }
+            // The biggest one rounded up past the top (ex: top + 3/4): round them all again, from the values, one bit
+            // coarser, so each is rounded only once (store_block() would round the rounded ones a second time).
+            exponent++;
+        }
+        memset(lanes + count, 0, (bfp->block_size - count) * sizeof(int32_t));
+        store_block(bfp, block, lanes, exponent);
+    }
+}
+
+/// @brief      Write the array's `size` values to `out` as doubles (exactly).
+void fixed_bfp_to_double(const fixed_bfp_t * bfp, double * out)
+{
+    int32_t lanes[FIXED_BFP_MAX_BLOCK_SIZE];
+    for (size_t block = 0; block < bfp->num_blocks; block++)
+    {
+        size_t count = values_in_block(bfp, block);
+        double scale = bfp->exponents[block] == FIXED_BFP_ZERO_EXPONENT ? 0 : ldexp(1.0, bfp->exponents[block]);
+        load_block(bfp, block, lanes);
+        for (size_t i = 0; i < count; i++)
+        {
+            out[block * bfp->block_size + i] = lanes[i] * scale;
+        }
+    }
+}
+
+static bool add_or_sub(fixed_bfp_t * out, const fixed_bfp_t * a, const fixed_bfp_t * b, bool subtract)
+{
+    if (!same_shape(out, a) || !same_shape(out, b))
+    {
+        return false;
+    }
+    int32_t lanes_a[FIXED_BFP_MAX_BLOCK_SIZE];
+    int32_t lanes_b[FIXED_BFP_MAX_BLOCK_SIZE];
+    for (size_t block = 0; block < out->num_blocks; block++)
+    {
+        // Align both to the bigger exponent. (A zero block's exponent is below every other, so it's the one shifted:
+        // to all zeros, which it already is.)
+        int32_t exponent_a = a->exponents[block];
+        int32_t exponent_b = b->exponents[block];
+        int32_t exponent = exponent_a > exponent_b ? exponent_a : exponent_b;
+        load_block(a, block, lanes_a);
+        load_block(b, block, lanes_b);
+        if (exponent_a < exponent)
+        {
+            shift_right_round(lanes_a, a->block_size, exponent - exponent_a > 32 ? 32 : exponent - exponent_a,
+                              INT32_MAX);
+        }
+        if (exponent_b < exponent)
+        {
+            shift_right_round(lanes_b, b->block_size, exponent - exponent_b > 32 ? 32 : exponent - exponent_b,
+                              INT32_MAX);
+        }
+        add_lanes(lanes_a, lanes_a, lanes_b, out->block_size, subtract);
+        store_block(out, block, lanes_a, exponent);
+    }
+    return true;
+}
+
+/// @brief      `a + b`, element-wise.
+bool fixed_bfp_add(fixed_bfp_t * out, const fixed_bfp_t * a, const fixed_bfp_t * b)
+{
+    return add_or_sub(out, a, b, false);
+}
+
+/// @brief      `a - b`, element-wise.
+bool fixed_bfp_sub(fixed_bfp_t * out, const fixed_bfp_t * a, const fixed_bfp_t * b)
+{
+    return add_or_sub(out, a, b, true);
+}
+
+/// @brief      `a * b`, element-wise: the exact 64-bit products, with the exponents added, rounded once to the
+///             mantissas' width.
+bool fixed_bfp_mul(fixed_bfp_t * out, const fixed_bfp_t * a, const fixed_bfp_t * b)
+{
+    if (!same_shape(out, a) || !same_shape(out, b))
+    {
+        return false;
+    }
+    int32_t lanes_a[FIXED_BFP_MAX_BLOCK_SIZE];
+    int32_t lanes_b[FIXED_BFP_MAX_BLOCK_SIZE];
+    int64_t products[FIXED_BFP_MAX_BLOCK_SIZE];
+    size_t count = out->block_size;
+    for (size_t block = 0; block < out->num_blocks; block++)
+    {
+        if (a->exponents[block] == FIXED_BFP_ZERO_EXPONENT || b->exponents[block] == FIXED_BFP_ZERO_EXPONENT)
+        {
+            store_zero_block(out, block);
+            continue;
+        }
+        load_block(a, block, lanes_a);
+        load_block(b, block, lanes_b);
+        uint64_t mask = 0;
+        size_t i = 0;
+#if defined(__AVX2__)
+        __m256i mask4 = _mm256_setzero_si256();
+        for (; i + 8 <= count; i += 8)
+        {
+            __m256i va = _mm256_loadu_si256((const __m256i *)(lanes_a + i));
+            __m256i vb = _mm256_loadu_si256((const __m256i *)(lanes_b + i));
+            __m256i even = _mm256_mul_epi32(va, vb);
+            __m256i odd = _mm256_mul_epi32(_mm256_srli_epi64(va, 32), _mm256_srli_epi64(vb, 32));
+            // The 64-bit leading-zero scan; AVX2 has no 64-bit arithmetic shift, so the signs come from a compare.
+            __m256i even_sign = _mm256_cmpgt_epi64(_mm256_setzero_si256(), even);
+            __m256i odd_sign = _mm256_cmpgt_epi64(_mm256_setzero_si256(), odd);
+            mask4 = _mm256_or_si256(mask4, _mm256_or_si256(_mm256_xor_si256(even, even_sign),
+                                                           _mm256_xor_si256(odd, odd_sign)));
+            // Back in order: even lanes 0, 2, 4, 6 and odd lanes 1, 3, 5, 7 of a and b.
+            __m256i low = _mm256_unpacklo_epi64(even, odd);
+            __m256i high = _mm256_unpackhi_epi64(even, odd);
+            _mm256_storeu_si256((__m256i *)(products + i), _mm256_permute2x128_si256(low, high, 0x20));
+            _mm256_storeu_si256((__m256i *)(products + i + 4), _mm256_permute2x128_si256(low, high, 0x31));
+        }
+        uint64_t masks[4];
+        _mm256_storeu_si256((__m256i *)masks, mask4);
+        mask = masks[0] | masks[1] | masks[2] | masks[3];
+#endif
+        for (; i < count; i++)
+        {
+            products[i] = (int64_t)lanes_a[i] * lanes_b[i];
+            mask |= (uint64_t)products[i] ^ (products[i] < 0 ? UINT64_MAX : 0);
+        }
+
+        // Round once to the mantissa width, then let store_block() check the exponent's range. If rounding the biggest
+        // product up carries into the next bit, round again from the products with one more bit of shift.
+        unsigned bits = mask == 0 ? 0 : 64 - (unsigned)__builtin_clzll(mask);
+        int32_t top = top_mantissa(out);
+        int shift = (int)bits - (out->mantissa_bits - 2);
+        shift = shift < 0 ? 0 : shift;
+        for (;;)
+        {
+            bool carried = false;
+            i = 0;
+#if defined(__AVX2__)
+            // 8 at a time: the same rounding with 64-bit logical shifts, then the low halves, back in order.
+            const __m128i SHIFT = _mm_cvtsi32_si128(shift);
+            const __m256i SIGN = _mm256_set1_epi64x(shift > 0 ? INT64_MIN : 0);
+            const __m256i HALF = _mm256_set1_epi64x(shift > 0 ? (int64_t)1 << (shift - 1) : 0);
+            const __m256i OFFSET = _mm256_set1_epi64x(shift > 0 ? (int64_t)1 << (63 - shift) : 0);
+            const __m256i TOP64 = _mm256_set1_epi64x(top);
+            const __m256i TOP32 = _mm256_set1_epi32(top);
+            const __m256i LOW_HALVES = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+            __m256i carried8 = _mm256_setzero_si256();
+            for (; i + 8 <= count; i += 8)
+            {
+                __m256i y0 = _mm256_loadu_si256((const __m256i *)(products + i));
+                __m256i y1 = _mm256_loadu_si256((const __m256i *)(products + i + 4));
+                y0 = _mm256_add_epi64(_mm256_xor_si256(y0, SIGN), HALF);
+                y0 = _mm256_sub_epi64(_mm256_srl_epi64(y0, SHIFT), OFFSET);
+                y1 = _mm256_add_epi64(_mm256_xor_si256(y1, SIGN), HALF);
+                y1 = _mm256_sub_epi64(_mm256_srl_epi64(y1, SHIFT), OFFSET);
+                carried8 = _mm256_or_si256(carried8, _mm256_or_si256(_mm256_cmpgt_epi64(y0, TOP64),
+                                                                     _mm256_cmpgt_epi64(y1, TOP64)));
+                __m256i y = _mm256_permute2x128_si256(_mm256_permutevar8x32_epi32(y0, LOW_HALVES),
+                                                      _mm256_permutevar8x32_epi32(y1, LOW_HALVES), 0x20);
+                _mm256_storeu_si256((__m256i *)(lanes_a + i), _mm256_min_epi32(y, TOP32));
+            }
+            carried = !_mm256_testz_si256(carried8, carried8);
+#endif
+            for (; i < count; i++)
+            {
+                int64_t y = products[i];
+                if (shift > 0)
+                {
+                    // Rounded half up; biased to be non-negative first, like shift_right_round_one().
+                    y = (int64_t)(((uint64_t)y + ((uint64_t)1 << 63) + ((uint64_t)1 << (shift - 1))) >> shift)
+                        - ((int64_t)1 << (63 - shift));
+                }
+                carried |= y > top;
+                lanes_a[i] = (int32_t)(y > top ? top : y);
+            }
+            if (!carried)
+            {
+                break;
+            }
+            shift++;
+        }
+        store_block(out, block, lanes_a, (int64_t)a->exponents[block] + b->exponents[block] + shift);
+    }
+    return true;
+}
+
+/// @brief      Renormalize every block, after changing the mantissas directly (ex: an in-place FFT stage). The
+///             mantissas may be any `int16_t` or `int32_t`, not just normalized ones.
+void fixed_bfp_normalize(fixed_bfp_t * bfp)
+{
+    int32_t lanes[FIXED_BFP_MAX_BLOCK_SIZE];
+    for (size_t block = 0; block < bfp->num_blocks; block++)
+    {
+        load_block(bfp, block, lanes);
+        // (An all-zero block's exponent may have been left at FIXED_BFP_ZERO_EXPONENT; any exponent in range works.)
+        int32_t exponent = bfp->exponents[block];
+        store_block(bfp, block, lanes, exponent == FIXED_BFP_ZERO_EXPONENT ? FIXED_BFP_MIN_EXPONENT : exponent);
+    }
+}
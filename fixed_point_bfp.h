@@ -0,0 +1,77 @@
+/*
+fixed_point_bfp
+- Block floating point: arrays of integer mantissas where each block of 16 to 64 values shares one exponent, so
+  value i is `mantissa[i] * 2^exponent[i / block_size]`.
+- A single `FRACTION_BITS` for a whole array has to cover its biggest value, so data with a big dynamic range (ex: a
+  spectrum, with peaks 60 dB above the noise floor) loses most of the small values' bits. The tutorial works around
+  this one value at a time, by slicing off and scaling parts of a number by hand. Here each block gets its own scale
+  instead: nearly the relative accuracy of floating point, while the mantissas are still plain integers that SIMD can
+  add, subtract, and multiply 8 or 16 at a time.
+- Mantissas are 32 bits (`int32_t`) or 16 bits (`int16_t`, ex: to feed Q15 kernels, or to halve the memory).
+- Every operation ends by *normalizing* each block: its biggest mantissa is shifted up (or, rounded half up, down)
+  until it uses all but the top 2 bits of the mantissa, and the exponent is adjusted to match. The shift is found by
+  a leading-zero scan: OR-ing together every `x ^ (x >> 31)` in the block (SIMD), then one count-leading-zeros
+  instruction. The spare bit of headroom means adding or subtracting 2 normalized blocks can't overflow.
+- Adding and subtracting first align each pair of blocks to the bigger exponent (rounding the smaller block's
+  mantissas half up). Multiplying is exact up to the final normalization.
+- An all-zero block has the exponent FIXED_BFP_ZERO_EXPONENT. Exponents stay within [FIXED_BFP_MIN_EXPONENT,
+  FIXED_BFP_MAX_EXPONENT]: blocks too small for that become zero, and blocks too big saturate.
+- FFT-style kernels that update the mantissas in place (ex: butterfly stages, which can grow a block by a bit or two
+  per stage) call fixed_bfp_normalize() afterward, to renormalize every block.
+*/
+
+#ifndef FIXED_POINT_BFP_H
+#define FIXED_POINT_BFP_H
+
+#include <stddef.h>
+
+#include "fixed_point.h"
+#include "fixed_point_arena.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FIXED_BFP_MIN_BLOCK_SIZE 16
+#define FIXED_BFP_MAX_BLOCK_SIZE 64
+// Exponents range over [FIXED_BFP_MIN_EXPONENT, FIXED_BFP_MAX_EXPONENT]; an all-zero block's is the one below that.
+#define FIXED_BFP_MIN_EXPONENT (-16384)
+#define FIXED_BFP_MAX_EXPONENT 16383
+#define FIXED_BFP_ZERO_EXPONENT (FIXED_BFP_MIN_EXPONENT - 1)
+
+typedef struct fixed_bfp_s
+{
+    int32_t * mantissas32; // the mantissas, if `mantissa_bits` is 32 (else NULL)
+    int16_t * mantissas16; // the mantissas, if `mantissa_bits` is 16 (else NULL)
+    int16_t * exponents;   // one per block
+    size_t size;           // the number of values; the last block is padded with zeros
+    size_t num_blocks;
+    uint8_t block_size;    // values per block: a multiple of 8, from FIXED_BFP_MIN_BLOCK_SIZE to FIXED_BFP_MAX_...
+    uint8_t mantissa_bits; // 16 or 32
+    fixed_arena_t * arena; // where the storage came from; NULL if from the heap
+} fixed_bfp_t;
+
+bool fixed_bfp_init(fixed_bfp_t * bfp, size_t size, unsigned block_size, unsigned mantissa_bits,
+                    fixed_arena_t * arena);
+void fixed_bfp_free(fixed_bfp_t * bfp);
+
+// Conversions. `fraction_bits` is the other array's format: 0 to 31 fraction bits in an `int32_t` (ex: FRACTION_BITS
+// for a signed Q15.16). Converting back rounds half up and saturates.
+void fixed_bfp_from_int32(fixed_bfp_t * bfp, const int32_t * in, unsigned fraction_bits);
+void fixed_bfp_to_int32(const fixed_bfp_t * bfp, int32_t * out, unsigned fraction_bits);
+void fixed_bfp_from_double(fixed_bfp_t * bfp, const double * in);
+void fixed_bfp_to_double(const fixed_bfp_t * bfp, double * out);
+
+// Element-wise arithmetic. All 3 must have the same size, block size, and mantissa bits (else these return false
+// without changing `out`); `out` may be the same as `a` and/or `b`.
+bool fixed_bfp_add(fixed_bfp_t * out, const fixed_bfp_t * a, const fixed_bfp_t * b);
+bool fixed_bfp_sub(fixed_bfp_t * out, const fixed_bfp_t * a, const fixed_bfp_t * b);
+bool fixed_bfp_mul(fixed_bfp_t * out, const fixed_bfp_t * a, const fixed_bfp_t * b);
+
+void fixed_bfp_normalize(fixed_bfp_t * bfp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIXED_POINT_BFP_H
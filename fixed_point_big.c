@@ -0,0 +1,497 @@
+/*
+fixed_point_big
+- See fixed_point_big.h.
+*/
+
+#include <string.h>
+
+#include "fixed_point_big.h"
+
+// Room for the widest temporary: a double-width product, or a numerator shifted left by up to its own width, plus a
+// limb.
+#define MAX_WIDE_LIMBS (2*FIXED_BIG_MAX_LIMBS + 1)
+// 10^FIXED_BIG_MAX_DIGITS < 2^426, so scaling by it adds at most 14 limbs.
+#define MAX_SCALED_LIMBS (FIXED_BIG_MAX_LIMBS + 14)
+#define ONE_BILLION 1000000000u
+
+static void set_largest(uint32_t * out, size_t num_limbs)
+{
+    memset(out, 0xff, num_limbs*sizeof(uint32_t));
+}
+
+// a += b, where a has at least as many limbs as b. Returns the carry out of a's top limb.
+static uint32_t add_to(uint32_t * a, size_t a_limbs, const uint32_t * b, size_t b_limbs)
+{
+    uint64_t carry = 0;
+    size_t i = 0;
+    for (; i < b_limbs; i++)
+    {
+        uint64_t sum = (uint64_t)a[i] + b[i] + carry;
+        a[i] = (uint32_t)sum;
+        carry = sum >> 32;
+    }
+    for (; carry && i < a_limbs; i++)
+    {
+        carry = ++a[i] == 0;
+    }
+    return (uint32_t)carry;
+}
+
+// a -= b, where a has at least as many limbs as b. Returns the borrow out of a's top limb.
+static uint32_t sub_from(uint32_t * a, size_t a_limbs, const uint32_t * b, size_t b_limbs)
+{
+    uint32_t borrow = 0;
+    size_t i = 0;
+    for (; i < b_limbs; i++)
+    {
+        // Wraps below 0 (mod 2^64) when it borrows, which sets the top half.
+        uint64_t difference = (uint64_t)a[i] - b[i] - borrow;
+        a[i] = (uint32_t)difference;
+        borrow = (difference >> 32) != 0;
+    }
+    for (; borrow && i < a_limbs; i++)
+    {
+        borrow = a[i]-- == 0;
+    }
+    return borrow;
+}
+
+static bool is_zero(const uint32_t * a, size_t num_limbs)
+{
+    for (size_t i = 0; i < num_limbs; i++)
+    {
+        if (a[i] != 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// out = a << shift, where out has `out_limbs` limbs (enough to hold the result) and a has `a_limbs`.
+static void shift_left(uint32_t * out, size_t out_limbs, const uint32_t * a, size_t a_limbs, unsigned shift)
+{
+    size_t limb_shift = shift / 32;
+    unsigned bit_shift = shift % 32;
+    memset(out, 0, out_limbs*sizeof(uint32_t));
+    for (size_t i = 0; i < a_limbs && i + limb_shift < out_limbs; i++)
+    {
+        uint64_t shifted = (uint64_t)a[i] << bit_shift;
+        out[i + limb_shift] |= (uint32_t)shifted;
+        if (i + limb_shift + 1 < out_limbs)
+        {
+            out[i + limb_shift + 1] |= (uint32_t)(shifted >> 32);
+        }
+    }
+}
+
+// fixed_round_up_needed() takes the remainder and the rest (the divisor minus the remainder), but all it does with
+// them is compare them, so this passes it a stand-in pair that compares the same way: `comparison` is < 0, 0, or > 0
+// as the remainder is less than, equal to, or more than the rest.
+static int round_up_needed(bool quotient_is_odd, int comparison, fixed_round_mode_t mode)
+{
+    return fixed_round_up_needed(quotient_is_odd, (uint64_t)(comparison + 1), 1, mode);
+}
+
+// out = a >> shift, rounded per `mode`, where a has `a_limbs` limbs and out has `out_limbs`. Returns false (and
+// saturates out) if the result doesn't fit.
+static bool round_shift_right(uint32_t * out, size_t out_limbs, const uint32_t * a, size_t a_limbs, unsigned shift,
+                              fixed_round_mode_t mode)
+{
+    size_t limb_shift = shift / 32;
+    unsigned bit_shift = shift % 32;
+    uint32_t result[MAX_WIDE_LIMBS] = {0};
+    size_t result_limbs = a_limbs > limb_shift ? a_limbs - limb_shift : 0;
+    for (size_t i = 0; i < result_limbs; i++)
+    {
+        uint64_t pair = a[i + limb_shift];
+        if (i + limb_shift + 1 < a_limbs)
+        {
+            pair |= (uint64_t)a[i + limb_shift + 1] << 32;
+        }
+        result[i] = (uint32_t)(pair >> bit_shift);
+    }
+
+    // Compare the bits shifted out with one half: look at the top one, then whether any below it are set.
+    int comparison = -1;
+    if (shift > 0)
+    {
+        unsigned half_bit = shift - 1;
+        bool half_set = half_bit / 32 < a_limbs && (a[half_bit / 32] >> (half_bit % 32)) & 1;
+        bool below_set = false;
+        for (size_t i = 0; i < half_bit / 32 && i < a_limbs && !below_set; i++)
+        {
+            below_set = a[i] != 0;
+        }
+        if (half_bit / 32 < a_limbs && half_bit % 32 > 0)
+        {
+            below_set = below_set || (a[half_bit / 32] & (((uint32_t)1 << (half_bit % 32)) - 1)) != 0;
+        }
+        comparison = !half_set ? -1 : below_set ? 1 : 0;
+    }
+    uint32_t carry = 0;
+    if (round_up_needed(result[0] & 1, comparison, mode))
+    {
+        uint32_t one = 1;
+        result_limbs = result_limbs > out_limbs ? result_limbs : out_limbs;
+        carry = add_to(result, result_limbs, &one, 1);
+    }
+
+    if (carry || (result_limbs > out_limbs && !is_zero(result + out_limbs, result_limbs - out_limbs)))
+    {
+        set_largest(out, out_limbs);
+        return false;
+    }
+    memcpy(out, result, out_limbs*sizeof(uint32_t));
+    return true;
+}
+
+/// @brief      Compare 2 numbers with the same number of limbs (and fraction bits).
+/// @return     < 0, 0, or > 0 as a is less than, equal to, or greater than b.
+int fixed_big_cmp(const uint32_t * a, const uint32_t * b, size_t num_limbs)
+{
+    for (size_t i = num_limbs; i-- > 0;)
+    {
+        if (a[i] != b[i])
+        {
+            return a[i] < b[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+/// @brief      out = value / 2^value_fraction_bits, rounded half up if out has fewer fraction bits than that.
+///             Ex: `fixed_big_set(out, 8, 128, price, FRACTION_BITS)` for a fixed_point_t price.
+bool fixed_big_set(uint32_t * out, size_t num_limbs, unsigned fraction_bits, uint64_t value,
+                   unsigned value_fraction_bits)
+{
+    uint32_t value_limbs[2] = {(uint32_t)value, (uint32_t)(value >> 32)};
+    if (fraction_bits >= value_fraction_bits)
+    {
+        uint32_t shifted[FIXED_BIG_MAX_LIMBS + 3];
+        size_t shifted_limbs = num_limbs + 3;
+        shift_left(shifted, shifted_limbs, value_limbs, 2, fraction_bits - value_fraction_bits);
+        if (!is_zero(shifted + num_limbs, shifted_limbs - num_limbs))
+        {
+            set_largest(out, num_limbs);
+            return false;
+        }
+        memcpy(out, shifted, num_limbs*sizeof(uint32_t));
+        return true;
+    }
+    return round_shift_right(out, num_limbs, value_limbs, 2, value_fraction_bits - fraction_bits,
+                             FIXED_ROUND_HALF_UP);
+}
+
+/// @brief      out = a + b.
+bool fixed_big_add(uint32_t * out, const uint32_t * a, const uint32_t * b, size_t num_limbs)
+{
+    uint32_t sum[FIXED_BIG_MAX_LIMBS];
+    memcpy(sum, a, num_limbs*sizeof(uint32_t));
+    if (add_to(sum, num_limbs, b, num_limbs))
+    {
+        set_largest(out, num_limbs);
+        return false;
+    }
+    memcpy(out, sum, num_limbs*sizeof(uint32_t));
+    return true;
+}
+
+/// @brief      out = a - b.
+bool fixed_big_sub(uint32_t * out, const uint32_t * a, const uint32_t * b, size_t num_limbs)
+{
+    uint32_t difference[FIXED_BIG_MAX_LIMBS];
+    memcpy(difference, a, num_limbs*sizeof(uint32_t));
+    if (sub_from(difference, num_limbs, b, num_limbs))
+    {
+        memset(out, 0, num_limbs*sizeof(uint32_t));
+        return false;
+    }
+    memcpy(out, difference, num_limbs*sizeof(uint32_t));
+    return true;
+}
+
+/// @brief      The exact 2*num_limbs-limb product of 2 num_limbs-limb integers, by schoolbook long multiplication.
+///             `out` must not overlap a or b.
+void fixed_big_mul_schoolbook(uint32_t * out, const uint32_t * a, const uint32_t * b, size_t num_limbs)
+{
+    memset(out, 0, 2*num_limbs*sizeof(uint32_t));
+    for (size_t i = 0; i < num_limbs; i++)
+    {
+        uint64_t carry = 0;
+        for (size_t j = 0; j < num_limbs; j++)
+        {
+            // (2^32 - 1)^2 + 2*(2^32 - 1) = 2^64 - 1, so this can't overflow.
+            uint64_t column = (uint64_t)a[i] * b[j] + out[i + j] + carry;
+            out[i + j] = (uint32_t)column;
+            carry = column >> 32;
+        }
+        out[i + num_limbs] = (uint32_t)carry;
+    }
+}
+
+/// @brief      The same as fixed_big_mul_schoolbook(), by Karatsuba multiplication: one level of it, with the 3
+///             half-size products done by fixed_big_mul_wide() (so Karatsuba again down to FIXED_BIG_KARATSUBA_LIMBS).
+/// @details    With a = a1*B + a0 and b = b1*B + b0 (B = 2^(32*half)), a*b = a1*b1*B^2 + (a1*b0 + a0*b1)*B + a0*b0,
+///             and the middle term is (a0 + a1)*(b0 + b1) - a1*b1 - a0*b0: 3 half-size multiplies instead of 4.
+void fixed_big_mul_karatsuba(uint32_t * out, const uint32_t * a, const uint32_t * b, size_t num_limbs)
+{
+    // Splitting fewer than 4 limbs doesn't make the (half + 1)-limb sums below any smaller.
+    if (num_limbs < 4)
+    {
+        fixed_big_mul_schoolbook(out, a, b, num_limbs);
+        return;
+    }
+    size_t low = num_limbs / 2;
+    size_t high = num_limbs - low;
+
+    // a0*b0 goes in out's bottom 2*low limbs, and a1*b1 in its top 2*high limbs.
+    fixed_big_mul_wide(out, a, b, low);
+    fixed_big_mul_wide(out + 2*low, a + low, b + low, high);
+
+    // The sums have 1 more limb than the high halves, for the carry.
+    uint32_t a_sum[FIXED_BIG_MAX_LIMBS/2 + 1] = {0};
+    uint32_t b_sum[FIXED_BIG_MAX_LIMBS/2 + 1] = {0};
+    memcpy(a_sum, a + low, high*sizeof(uint32_t));
+    memcpy(b_sum, b + low, high*sizeof(uint32_t));
+    a_sum[high] = add_to(a_sum, high, a, low);
+    b_sum[high] = add_to(b_sum, high, b, low);
+    uint32_t middle[FIXED_BIG_MAX_LIMBS + 2];
+    fixed_big_mul_wide(middle, a_sum, b_sum, high + 1);
+    sub_from(middle, 2*high + 2, out, 2*low);
+    sub_from(middle, 2*high + 2, out + 2*low, 2*high);
+
+    // The middle term is a1*b0 + a0*b1 < 2^(32*(low + high + 1)), so any limbs of it past that are 0 (and the sum,
+    // being the exact product, fits in out).
+    size_t middle_limbs = low + high + 1 < 2*high + 2 ? low + high + 1 : 2*high + 2;
+    add_to(out + low, 2*num_limbs - low, middle, middle_limbs);
+}
+
+/// @brief      The exact 2*num_limbs-limb product of 2 num_limbs-limb integers, by whichever of schoolbook and
+///             Karatsuba multiplication is faster for that size. `out` must not overlap a or b.
+void fixed_big_mul_wide(uint32_t * out, const uint32_t * a, const uint32_t * b, size_t num_limbs)
+{
+    if (num_limbs < FIXED_BIG_KARATSUBA_LIMBS)
+    {
+        fixed_big_mul_schoolbook(out, a, b, num_limbs);
+    }
+    else
+    {
+        fixed_big_mul_karatsuba(out, a, b, num_limbs);
+    }
+}
+
+/// @brief      out = a * b, rounded per `mode`: the exact product, shifted right by `fraction_bits`.
+bool fixed_big_mul(uint32_t * out, const uint32_t * a, const uint32_t * b, size_t num_limbs, unsigned fraction_bits,
+                   fixed_round_mode_t mode)
+{
+    uint32_t product[2*FIXED_BIG_MAX_LIMBS];
+    fixed_big_mul_wide(product, a, b, num_limbs);
+    return round_shift_right(out, num_limbs, product, 2*num_limbs, fraction_bits, mode);
+}
+
+// Divide `numerator` (`numerator_limbs` limbs) in place by a 1-limb `divisor`. Returns the remainder.
+static uint32_t divmod_small(uint32_t * numerator, size_t numerator_limbs, uint32_t divisor)
+{
+    uint64_t remainder = 0;
+    for (size_t i = numerator_limbs; i-- > 0;)
+    {
+        uint64_t current = (remainder << 32) | numerator[i];
+        numerator[i] = (uint32_t)(current / divisor);
+        remainder = current % divisor;
+    }
+    return (uint32_t)remainder;
+}
+
+// Knuth's algorithm D (The Art of Computer Programming, vol. 2, 4.3.1): long division one limb at a time, like on
+// paper, guessing each quotient limb from the top 2 limbs of what's left and the top limb of the divisor.
+// quotient (numerator_limbs - divisor_limbs + 1 limbs) = numerator / divisor, remainder (divisor_limbs limbs) =
+// numerator % divisor, where numerator_limbs >= divisor_limbs >= 2 and the divisor's top limb isn't 0.
+static void divmod_knuth(uint32_t * quotient, uint32_t * remainder, const uint32_t * numerator,
+                         size_t numerator_limbs, const uint32_t * divisor, size_t divisor_limbs)
+{
+    // Shift both left until the divisor's top bit is set, which makes each guess at most 2 too big.
+    unsigned shift = 0;
+    while (!(divisor[divisor_limbs - 1] << shift & 0x80000000u))
+    {
+        shift++;
+    }
+    uint32_t u[MAX_WIDE_LIMBS + 1];
+    uint32_t v[FIXED_BIG_MAX_LIMBS];
+    shift_left(v, divisor_limbs, divisor, divisor_limbs, shift);
+    shift_left(u, numerator_limbs + 1, numerator, numerator_limbs, shift);
+
+    uint64_t v_top = v[divisor_limbs - 1];
+    uint64_t v_next = v[divisor_limbs - 2];
+    for (size_t j = numerator_limbs - divisor_limbs + 1; j-- > 0;)
+    {
+        // Guess, then fix the guess with the next limb, which leaves it at most 1 too big.
+        uint64_t top = ((uint64_t)u[j + divisor_limbs] << 32) | u[j + divisor_limbs - 1];
+        uint64_t guess = top / v_top;
+        uint64_t guess_remainder = top % v_top;
+        while (guess >> 32 || guess * v_next > ((guess_remainder << 32) | u[j + divisor_limbs - 2]))
+        {
+            guess--;
+            guess_remainder += v_top;
+            if (guess_remainder >> 32)
+            {
+                break;
+            }
+        }
+
+        // u -= guess*v, at this limb.
+        uint64_t carry = 0;
+        uint32_t borrow = 0;
+        for (size_t i = 0; i < divisor_limbs; i++)
+        {
+            uint64_t product = guess * v[i] + carry;
+            carry = product >> 32;
+            uint64_t difference = (uint64_t)u[i + j] - (uint32_t)product - borrow;
+            u[i + j] = (uint32_t)difference;
+            borrow = (difference >> 32) != 0;
+        }
+        uint64_t difference = (uint64_t)u[j + divisor_limbs] - carry - borrow;
+        u[j + divisor_limbs] = (uint32_t)difference;
+
+        // Went negative: the guess was 1 too big (rare), so add a v back.
+        if (difference >> 32)
+        {
+            guess--;
+            u[j + divisor_limbs] += add_to(u + j, divisor_limbs, v, divisor_limbs);
+        }
+        quotient[j] = (uint32_t)guess;
+    }
+
+    // Undo the shift to get the remainder.
+    for (size_t i = 0; i < divisor_limbs; i++)
+    {
+        remainder[i] = (uint32_t)((((uint64_t)u[i + 1] << 32) | u[i]) >> shift);
+    }
+}
+
+/// @brief      out = a / b, rounded per `mode`: `(a << fraction_bits) / b`, rounded from the remainder.
+bool fixed_big_div(uint32_t * out, const uint32_t * a, const uint32_t * b, size_t num_limbs, unsigned fraction_bits,
+                   fixed_round_mode_t mode)
+{
+    size_t divisor_limbs = num_limbs;
+    while (divisor_limbs > 0 && b[divisor_limbs - 1] == 0)
+    {
+        divisor_limbs--;
+    }
+    if (divisor_limbs == 0)
+    {
+        set_largest(out, num_limbs);
+        return false;
+    }
+
+    uint32_t numerator[MAX_WIDE_LIMBS];
+    size_t numerator_limbs = num_limbs + (fraction_bits + 31) / 32;
+    shift_left(numerator, numerator_limbs, a, num_limbs, fraction_bits);
+    // Dropping its leading zero limbs makes the long division shorter. (It keeps at least as many as the divisor has,
+    // as divmod_knuth() requires.)
+    while (numerator_limbs > divisor_limbs && numerator[numerator_limbs - 1] == 0)
+    {
+        numerator_limbs--;
+    }
+
+    uint32_t quotient[MAX_WIDE_LIMBS] = {0};
+    uint32_t remainder[FIXED_BIG_MAX_LIMBS] = {0};
+    if (divisor_limbs == 1)
+    {
+        memcpy(quotient, numerator, numerator_limbs*sizeof(uint32_t));
+        remainder[0] = divmod_small(quotient, numerator_limbs, b[0]);
+    }
+    else
+    {
+        divmod_knuth(quotient, remainder, numerator, numerator_limbs, b, divisor_limbs);
+    }
+
+    // Round from the remainder: compare it with the rest, b - remainder.
+    uint32_t rest[FIXED_BIG_MAX_LIMBS];
+    memcpy(rest, b, divisor_limbs*sizeof(uint32_t));
+    sub_from(rest, divisor_limbs, remainder, divisor_limbs);
+    if (round_up_needed(quotient[0] & 1, fixed_big_cmp(remainder, rest, divisor_limbs), mode))
+    {
+        uint32_t one = 1;
+        if (add_to(quotient, numerator_limbs, &one, 1))
+        {
+            set_largest(out, num_limbs);
+            return false;
+        }
+    }
+    if (numerator_limbs > num_limbs && !is_zero(quotient + num_limbs, numerator_limbs - num_limbs))
+    {
+        set_largest(out, num_limbs);
+        return false;
+    }
+    memcpy(out, quotient, num_limbs*sizeof(uint32_t));
+    return true;
+}
+
+/// @brief      Print a number as a manual "float" into `out`, with `num_digits_after_decimal` (0 to
+///             FIXED_BIG_MAX_DIGITS) digits after the decimal, rounded half up; ex: "1234.5679".
+/// @details    `out` must hold FIXED_BIG_FORMAT_LEN(num_limbs, num_digits_after_decimal) chars. With at least
+///             `fraction_bits` digits, the result is exactly the number's value (1/2^n has exactly n digits).
+/// @return     The length of the string (not counting the null).
+size_t fixed_big_format(const uint32_t * a, size_t num_limbs, unsigned fraction_bits,
+                        uint8_t num_digits_after_decimal, char * out)
+{
+    if (num_digits_after_decimal > FIXED_BIG_MAX_DIGITS)
+    {
+        num_digits_after_decimal = FIXED_BIG_MAX_DIGITS;
+    }
+
+    // a*10^digits, then rounded to an integer: the number to print, with the '.' `digits` from the right.
+    uint32_t scaled[MAX_SCALED_LIMBS] = {0};
+    size_t scaled_limbs = num_limbs;
+    memcpy(scaled, a, num_limbs*sizeof(uint32_t));
+    for (unsigned digits = num_digits_after_decimal; digits > 0;)
+    {
+        uint32_t power = 1;
+        for (; digits > 0 && power < ONE_BILLION; digits--)
+        {
+            power *= 10;
+        }
+        uint64_t carry = 0;
+        for (size_t i = 0; i < scaled_limbs; i++)
+        {
+            uint64_t product = (uint64_t)scaled[i] * power + carry;
+            scaled[i] = (uint32_t)product;
+            carry = product >> 32;
+        }
+        if (carry)
+        {
+            scaled[scaled_limbs++] = (uint32_t)carry;
+        }
+    }
+    round_shift_right(scaled, scaled_limbs, scaled, scaled_limbs, fraction_bits, FIXED_ROUND_HALF_UP);
+
+    // Its digits, least significant first, 9 at a time.
+    char digits[10*MAX_SCALED_LIMBS + FIXED_BIG_MAX_DIGITS + 1];
+    size_t num_digits = 0;
+    while (!is_zero(scaled, scaled_limbs) || num_digits <= num_digits_after_decimal)
+    {
+        uint32_t chunk = divmod_small(scaled, scaled_limbs, ONE_BILLION);
+        for (int i = 0; i < 9; i++, chunk /= 10)
+        {
+            digits[num_digits++] = (char)('0' + chunk % 10);
+        }
+    }
+    // Drop the leading zeros, but keep at least one digit before the '.'.
+    while (num_digits > (size_t)num_digits_after_decimal + 1 && digits[num_digits - 1] == '0')
+    {
+        num_digits--;
+    }
+
+    size_t len = 0;
+    for (size_t i = num_digits; i-- > 0;)
+    {
+        out[len++] = digits[i];
+        if (i == num_digits_after_decimal && i > 0)
+        {
+            out[len++] = '.';
+        }
+    }
+    out[len] = '\0';
+    return len;
+}
@@ -0,0 +1,154 @@
+/*
+fixed_point_big
+- Arbitrary-precision (but fixed-size) unsigned fixed-point numbers, for when 32 or 64 bits aren't enough: ex: exact
+  256-bit intermediates in a settlement calculation, where every product and quotient must be reproducible to the
+  last bit.
+- A number is an array of 32-bit "limbs", least significant first, with a caller-chosen number of fraction bits. The
+  caller owns the storage (normally a local array, or the C++ `bigfixed` type below), and nothing here allocates on
+  the heap; temporaries are fixed-size local arrays.
+- Multiplying is the tutorial's "split long multiplication into smaller multiplications" idea (approaches 2 to 8),
+  taken to many pieces: each 32x32 = 64-bit partial product is added into its column, with the carry going to the
+  next (schoolbook, O(n^2)). From FIXED_BIG_KARATSUBA_LIMBS limbs up, Karatsuba's trick splits each number in 2 halves
+  and gets the product from 3 half-size products instead of 4 (O(n^1.58)).
+- Dividing is limb-by-limb long division (Knuth's algorithm D), with the quotient rounded from the remainder per
+  fixed_round_mode_t, so it never overflows and ties are exact.
+- Formatting is the tutorial's manual "float": scale by 10^digits, round, and print as an integer with a '.' put in.
+  Every digit is exact.
+- The C++ `bigfixed<Limbs, FracBits>` wraps all this in a value type with operators.
+*/
+
+#ifndef FIXED_POINT_BIG_H
+#define FIXED_POINT_BIG_H
+
+#include <stddef.h>
+
+#include "fixed_point.h"
+#include "fixed_point_round.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The most limbs (32 bits each) a number may have: 1024 bits.
+#define FIXED_BIG_MAX_LIMBS 32
+// fixed_big_mul_wide() uses Karatsuba multiplication at and above this many limbs, and schoolbook below. Karatsuba's
+// extra additions cost more than the multiplies they save on smaller numbers (see bench_big). Must be at least 4.
+#define FIXED_BIG_KARATSUBA_LIMBS 32
+// The most digits after the decimal fixed_big_format() prints.
+#define FIXED_BIG_MAX_DIGITS 128
+// The most characters fixed_big_format() writes for a number with `num_limbs` limbs, *including* the terminating
+// null: 10 whole number digits per limb (2^32 < 10^10), the '.', the digits after it, and the '\0'.
+#define FIXED_BIG_FORMAT_LEN(num_limbs, num_digits_after_decimal) \
+    (10*(num_limbs) + 1 + (num_digits_after_decimal) + 1)
+
+// In all of these, `num_limbs` is 1 to FIXED_BIG_MAX_LIMBS, and `fraction_bits` is less than 32*num_limbs. `out` may
+// be the same array as an input, except in the 3 that return the double-width product (fixed_big_mul_schoolbook(),
+// fixed_big_mul_karatsuba(), and fixed_big_mul_wide()). The bool functions return false if the exact result didn't
+// fit (then `out` is saturated: to 0 for a subtraction that went negative, else to the largest number), or on
+// division by zero.
+int fixed_big_cmp(const uint32_t * a, const uint32_t * b, size_t num_limbs);
+bool fixed_big_set(uint32_t * out, size_t num_limbs, unsigned fraction_bits, uint64_t value,
+                   unsigned value_fraction_bits);
+bool fixed_big_add(uint32_t * out, const uint32_t * a, const uint32_t * b, size_t num_limbs);
+bool fixed_big_sub(uint32_t * out, const uint32_t * a, const uint32_t * b, size_t num_limbs);
+void fixed_big_mul_schoolbook(uint32_t * out, const uint32_t * a, const uint32_t * b, size_t num_limbs);
+void fixed_big_mul_karatsuba(uint32_t * out, const uint32_t * a, const uint32_t * b, size_t num_limbs);
+void fixed_big_mul_wide(uint32_t * out, const uint32_t * a, const uint32_t * b, size_t num_limbs);
+bool fixed_big_mul(uint32_t * out, const uint32_t * a, const uint32_t * b, size_t num_limbs, unsigned fraction_bits,
+                   fixed_round_mode_t mode);
+bool fixed_big_div(uint32_t * out, const uint32_t * a, const uint32_t * b, size_t num_limbs, unsigned fraction_bits,
+                   fixed_round_mode_t mode);
+size_t fixed_big_format(const uint32_t * a, size_t num_limbs, unsigned fraction_bits,
+                        uint8_t num_digits_after_decimal, char * out);
+
+#ifdef __cplusplus
+}
+
+/// @brief      An unsigned fixed-point number with `Limbs` 32-bit limbs, `FracBits` of which are after the binary
+///             point: ex: `bigfixed<8, 128>` is Q128.128. A plain array inside, so it lives wherever it is declared
+///             (usually the stack), and copies are just memcpy()s.
+/// @details    The arithmetic operators round half up and saturate (to 0 or the largest number) when a result
+///             doesn't fit, as does division by zero; use the C functions directly to find out when that happens.
+template <int Limbs, int FracBits>
+struct bigfixed
+{
+    static_assert(Limbs >= 1 && Limbs <= FIXED_BIG_MAX_LIMBS, "bigfixed must have 1 to FIXED_BIG_MAX_LIMBS limbs");
+    static_assert(FracBits >= 0 && FracBits < 32*Limbs, "bigfixed must have fewer fraction bits than bits");
+
+    uint32_t limbs[Limbs]; // least significant first
+
+    /// @brief      `value / 2^value_fraction_bits`: ex: from_scaled(price, FRACTION_BITS) for a Q16.16 price.
+    static bigfixed from_scaled(uint64_t value, unsigned value_fraction_bits)
+    {
+        bigfixed result;
+        fixed_big_set(result.limbs, Limbs, FracBits, value, value_fraction_bits);
+        return result;
+    }
+    static bigfixed from_int(uint64_t value) { return from_scaled(value, 0); }
+    static bigfixed from_fixed(fixed_point_t value) { return from_scaled(value, FRACTION_BITS); }
+
+    /// @brief      Print with `num_digits_after_decimal` (0 to FIXED_BIG_MAX_DIGITS) digits after the decimal, rounded
+    ///             half up, into `out`, which must hold FIXED_BIG_FORMAT_LEN(Limbs, num_digits_after_decimal) chars.
+    /// @return     The length of the string (not counting the null).
+    size_t format(uint8_t num_digits_after_decimal, char * out) const
+    {
+        return fixed_big_format(limbs, Limbs, FracBits, num_digits_after_decimal, out);
+    }
+
+    bigfixed mul(const bigfixed & b, fixed_round_mode_t mode) const
+    {
+        bigfixed result;
+        fixed_big_mul(result.limbs, limbs, b.limbs, Limbs, FracBits, mode);
+        return result;
+    }
+    bigfixed div(const bigfixed & b, fixed_round_mode_t mode) const
+    {
+        bigfixed result;
+        fixed_big_div(result.limbs, limbs, b.limbs, Limbs, FracBits, mode);
+        return result;
+    }
+
+    friend bigfixed operator+(const bigfixed & a, const bigfixed & b)
+    {
+        bigfixed result;
+        fixed_big_add(result.limbs, a.limbs, b.limbs, Limbs);
+        return result;
+    }
+    friend bigfixed operator-(const bigfixed & a, const bigfixed & b)
+    {
+        bigfixed result;
+        fixed_big_sub(result.limbs, a.limbs, b.limbs, Limbs);
+        return result;
+    }
+    friend bigfixed operator*(const bigfixed & a, const bigfixed & b) { return a.mul(b, FIXED_ROUND_HALF_UP); }
+    friend bigfixed operator/(const bigfixed & a, const bigfixed & b) { return a.div(b, FIXED_ROUND_HALF_UP); }
+    bigfixed & operator+=(const bigfixed & b) { return *this = *this + b; }
+    bigfixed & operator-=(const bigfixed & b) { return *this = *this - b; }
+    bigfixed & operator*=(const bigfixed & b) { return *this = *this * b; }
+    bigfixed & operator/=(const bigfixed & b) { return *this = *this / b; }
+
+    friend bool operator==(const bigfixed & a, const bigfixed & b) { return cmp(a, b) == 0; }
+    friend bool operator!=(const bigfixed & a, const bigfixed & b) { return cmp(a, b) != 0; }
+    friend bool operator<(const bigfixed & a, const bigfixed & b) { return cmp(a, b) < 0; }
+    friend bool operator<=(const bigfixed & a, const bigfixed & b) { return cmp(a, b) <= 0; }
+    friend bool operator>(const bigfixed & a, const bigfixed & b) { return cmp(a, b) > 0; }
+    friend bool operator>=(const bigfixed & a, const bigfixed & b) { return cmp(a, b) >= 0; }
+
+private:
+    static int cmp(const bigfixed & a, const bigfixed & b) { return fixed_big_cmp(a.limbs, b.limbs, Limbs); }
+};
+
+/// @brief      The exact product of 2 bigfixeds, twice as wide, so nothing is rounded or lost: ex: 2 Q64.64 numbers
+///             (`bigfixed<4, 64>`) multiply to a Q128.128 (`bigfixed<8, 128>`).
+template <int Limbs, int FracBits>
+inline bigfixed<2*Limbs, 2*FracBits> fixed_big_mul_exact(const bigfixed<Limbs, FracBits> & a,
+                                                          const bigfixed<Limbs, FracBits> & b)
+{
+    bigfixed<2*Limbs, 2*FracBits> result;
+    fixed_big_mul_wide(result.limbs, a.limbs, b.limbs, Limbs);
+    return result;
+}
+
+#endif
+
+#endif // FIXED_POINT_BIG_H
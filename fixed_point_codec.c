@@ -0,0 +1,531 @@
+/*
+fixed_point_codec
+- See fixed_point_codec.h.
+*/
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "fixed_point_codec.h"
+
+// A block's encoding byte: bit 0 says how its slots are stored, bit 1 whether they are deltas or delta-of-deltas.
+#define ENCODING_PACKED 1
+#define ENCODING_DELTA_OF_DELTA 2
+
+// Encoding, bits per value, first value, first delta.
+#define BLOCK_HEADER_SIZE 10
+// Plus the smallest slot, for bit-packed blocks.
+#define PACKED_HEADER_SIZE (BLOCK_HEADER_SIZE + 4)
+// A 32-bit varint takes at most 5 bytes.
+#define MAX_VARINT_SIZE 5
+// The bit-packed slots are 4 lanes of 32 values each.
+#define NUM_LANES 4
+#define SLOTS_PER_LANE (FIXED_CODEC_BLOCK_VALUES / NUM_LANES)
+
+// Bit-packing all 128 slots at 32 bits each is the most any block can take, since varints are only used when smaller.
+#define MAX_BLOCK_SIZE (PACKED_HEADER_SIZE + FIXED_CODEC_BLOCK_VALUES*4)
+
+// Little-endian reads and writes, one byte at a time, so the format is the same on every machine.
+static void put_u16(uint8_t * out, uint16_t value)
+{
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+}
+
+static void put_u32(uint8_t * out, uint32_t value)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        out[i] = (uint8_t)(value >> (8*i));
+    }
+}
+
+static void put_u64(uint8_t * out, uint64_t value)
+{
+    put_u32(out, (uint32_t)value);
+    put_u32(out + 4, (uint32_t)(value >> 32));
+}
+
+static uint16_t get_u16(const uint8_t * in)
+{
+    return (uint16_t)(in[0] | (in[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t * in)
+{
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+static uint64_t get_u64(const uint8_t * in)
+{
+    return get_u32(in) | ((uint64_t)get_u32(in + 4) << 32);
+}
+
+// Zigzag: 0, -1, 1, -2, 2, ... => 0, 1, 2, 3, 4, ..., so that small negative numbers are small too. The signed
+// number is passed around as its 2's complement bits in a uint32_t.
+static uint32_t zigzag_encode(uint32_t value)
+{
+    return (value << 1) ^ ((uint32_t)0 - (value >> 31));
+}
+
+static uint32_t zigzag_decode(uint32_t value)
+{
+    return (value >> 1) ^ ((uint32_t)0 - (value & 1));
+}
+
+static size_t varint_size(uint32_t value)
+{
+    return (size_t)1 + (value >= (1u << 7)) + (value >= (1u << 14)) + (value >= (1u << 21)) + (value >= (1u << 28));
+}
+
+// Read one varint of up to MAX_VARINT_SIZE bytes from the `available` bytes at `in`.
+// Returns its size in bytes, or 0 if it's cut short or too long.
+static size_t get_varint(const uint8_t * in, size_t available, uint32_t * value)
+{
+#if defined(__GNUC__)
+    if (available >= 8)
+    {
+        // Branch-free: the varint ends at the first byte whose top bit is clear, so find it with a count of trailing
+        // zeros instead of testing each byte in turn (which mispredicts when sizes vary), then gather the 7-bit
+        // groups of all 5 possible bytes at once, with the bytes past the end masked off.
+        uint64_t bytes = get_u64(in);
+        uint64_t ends = ~bytes & 0x8080808080808080ull;
+        size_t size = ends == 0 ? 9 : (size_t)__builtin_ctzll(ends)/8 + 1;
+        if (size > MAX_VARINT_SIZE)
+        {
+            return 0;
+        }
+        bytes &= ((uint64_t)1 << (8*size)) - 1;
+        *value = (uint32_t)((bytes & 0x7F) | ((bytes >> 1) & (0x7Full << 7)) | ((bytes >> 2) & (0x7Full << 14))
+                            | ((bytes >> 3) & (0x7Full << 21)) | ((bytes >> 4) & (0x7Full << 28)));
+        return size;
+    }
+#endif
+    uint32_t result = 0;
+    for (size_t size = 0; size < MAX_VARINT_SIZE && size < available; size++)
+    {
+        result |= (uint32_t)(in[size] & 0x7F) << (7*size);
+        if (in[size] < 0x80)
+        {
+            *value = result;
+            return size + 1;
+        }
+    }
+    return 0;
+}
+
+static size_t put_varint(uint8_t * out, uint32_t value)
+{
+    size_t size = 0;
+    while (value >= 0x80)
+    {
+        out[size++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[size++] = (uint8_t)value;
+    return size;
+}
+
+// The number of bits needed to hold `value`: 0 for 0, 32 for 0x80000000 and up.
+static uint8_t bit_width(uint32_t value)
+{
+    uint8_t width = 0;
+    while (value != 0)
+    {
+        width++;
+        value >>= 1;
+    }
+    return width;
+}
+
+static uint32_t width_mask(uint8_t width)
+{
+    return width >= 32 ? UINT32_MAX : ((uint32_t)1 << width) - 1;
+}
+
+/// @brief      The most bytes fixed_codec_encode() can need for `num_values` values.
+size_t fixed_codec_max_encoded_size(size_t num_values)
+{
+    size_t num_blocks = (num_values + FIXED_CODEC_BLOCK_VALUES - 1) / FIXED_CODEC_BLOCK_VALUES;
+    return FIXED_CODEC_HEADER_SIZE + num_blocks*(8 + MAX_BLOCK_SIZE);
+}
+
+// A block's slots are either its deltas (order 1) or its delta-of-deltas (order 2), whichever packs smaller; ex:
+// delta-of-deltas for a steady trend, but plain deltas for a random walk, where delta-of-deltas are twice as wide.
+// The first `order` slots are always 0, since the first value (and, for order 2, the first delta) is stored as-is.
+// So decoding is just `order` prefix sums over all 128 slots, starting from delta = first delta and
+// value = first value - first delta (the first delta is stored as 0 for order 1).
+typedef struct block_slots_s
+{
+    uint32_t slots[FIXED_CODEC_BLOCK_VALUES];
+    uint32_t reference; // the smallest slot, as a signed number
+    uint8_t width;      // the bits needed for the largest slot minus the reference
+    size_t varints_size;
+} block_slots_t;
+
+// Convert the bits of a signed number in a uint32_t to a uint32_t that sorts the same way: -2^31 => 0, 0 => 2^31.
+static uint32_t sortable(uint32_t value)
+{
+    return value ^ 0x80000000u;
+}
+
+// Fill in candidates[0] with the block's deltas, and candidates[1] with its delta-of-deltas, in one pass.
+static void compute_slots(const fixed_point_t * values, size_t n, block_slots_t * candidates)
+{
+    // Over the real slots (`order` to n - 1) only: the smallest and largest slot, as signed numbers.
+    uint32_t smallest[2] = {UINT32_MAX, UINT32_MAX};
+    uint32_t largest[2] = {0, 0};
+    size_t varints_size[2] = {0, 0};
+    memset(candidates[0].slots, 0, sizeof(candidates[0].slots));
+    memset(candidates[1].slots, 0, sizeof(candidates[1].slots));
+    uint32_t previous_delta = n > 1 ? values[1] - values[0] : 0;
+    for (size_t i = 1; i < n; i++)
+    {
+        uint32_t delta = values[i] - values[i - 1];
+        uint32_t delta_of_delta = delta - previous_delta;
+        previous_delta = delta;
+        candidates[0].slots[i] = delta;
+        smallest[0] = sortable(delta) < smallest[0] ? sortable(delta) : smallest[0];
+        largest[0] = sortable(delta) > largest[0] ? sortable(delta) : largest[0];
+        varints_size[0] += varint_size(zigzag_encode(delta));
+        if (i >= 2)
+        {
+            candidates[1].slots[i] = delta_of_delta;
+            smallest[1] = sortable(delta_of_delta) < smallest[1] ? sortable(delta_of_delta) : smallest[1];
+            largest[1] = sortable(delta_of_delta) > largest[1] ? sortable(delta_of_delta) : largest[1];
+            varints_size[1] += varint_size(zigzag_encode(delta_of_delta));
+        }
+    }
+    for (int order = 1; order <= 2; order++)
+    {
+        block_slots_t * block = &candidates[order - 1];
+        bool any_slots = n > (size_t)order;
+        block->reference = any_slots ? sortable(smallest[order - 1]) : 0;
+        block->width = any_slots ? bit_width(largest[order - 1] - smallest[order - 1]) : 0;
+        block->varints_size = varints_size[order - 1];
+    }
+}
+
+// Encode one block of 1 to 128 values into `out`, which has room for MAX_BLOCK_SIZE bytes.
+static size_t encode_block(const fixed_point_t * values, size_t n, uint8_t * out)
+{
+    // Try all 4 ways (order 1 or 2, varints or bit-packed), and keep the smallest. But varints decode one at a time
+    // (each one's position depends on the size of the one before it), several times slower than SIMD unpacking, so
+    // they are only used when they save at least a quarter of the block; ex: when a few outliers would make every
+    // bit-packed slot wide. Ties go to delta-of-deltas.
+    block_slots_t candidates[2];
+    int packed_order = 2;
+    int varint_order = 2;
+    size_t packed_size = SIZE_MAX;
+    size_t varint_block_size = SIZE_MAX;
+    compute_slots(values, n, candidates);
+    for (int order = 2; order >= 1; order--)
+    {
+        const block_slots_t * candidate = &candidates[order - 1];
+        size_t size = PACKED_HEADER_SIZE + (size_t)NUM_LANES*4*candidate->width;
+        if (size < packed_size)
+        {
+            packed_order = order;
+            packed_size = size;
+        }
+        size = BLOCK_HEADER_SIZE + candidate->varints_size;
+        if (size < varint_block_size)
+        {
+            varint_order = order;
+            varint_block_size = size;
+        }
+    }
+    bool best_packed = 4*varint_block_size > 3*packed_size;
+    int best_order = best_packed ? packed_order : varint_order;
+    size_t best_size = best_packed ? packed_size : varint_block_size;
+    const block_slots_t * best = &candidates[best_order - 1];
+
+    out[0] = (uint8_t)((best_packed ? ENCODING_PACKED : 0) | (best_order == 2 ? ENCODING_DELTA_OF_DELTA : 0));
+    out[1] = best_packed ? best->width : 0;
+    put_u32(out + 2, values[0]);
+    put_u32(out + 6, best_order == 2 && n > 1 ? values[1] - values[0] : 0);
+    if (!best_packed)
+    {
+        size_t size = BLOCK_HEADER_SIZE;
+        for (size_t i = (size_t)best_order; i < n; i++)
+        {
+            size += put_varint(out + size, zigzag_encode(best->slots[i]));
+        }
+        return size;
+    }
+
+    put_u32(out + BLOCK_HEADER_SIZE, best->reference);
+    // Slot i goes in lane i % 4, at bit (i/4)*width of that lane. Word w of lane l is u32 number w*4 + l, so that
+    // word w of all 4 lanes is one 16-byte SIMD load. The unused slots (the first `order`, and past n) get offset 0.
+    uint32_t words[FIXED_CODEC_BLOCK_VALUES] = {0};
+    uint8_t width = best->width;
+    for (size_t i = (size_t)best_order; i < n && width > 0; i++)
+    {
+        uint32_t offset = best->slots[i] - best->reference;
+        size_t bit = (i / NUM_LANES)*width;
+        size_t word = bit / 32;
+        size_t shift = bit % 32;
+        words[word*NUM_LANES + i % NUM_LANES] |= offset << shift;
+        if (shift + width > 32)
+        {
+            words[(word + 1)*NUM_LANES + i % NUM_LANES] |= offset >> (32 - shift);
+        }
+    }
+    for (size_t i = 0; i < (size_t)NUM_LANES*width; i++)
+    {
+        put_u32(out + PACKED_HEADER_SIZE + 4*i, words[i]);
+    }
+    return best_size;
+}
+
+/// @brief      Encode `num_values` fixed-point numbers into `out`.
+/// @return     The number of bytes written, or 0 if `out_size` is too small (fixed_codec_max_encoded_size() bytes
+///             is always enough).
+size_t fixed_codec_encode(const fixed_point_t * values, size_t num_values, uint8_t * out, size_t out_size)
+{
+    size_t num_blocks = (num_values + FIXED_CODEC_BLOCK_VALUES - 1) / FIXED_CODEC_BLOCK_VALUES;
+    size_t size = FIXED_CODEC_HEADER_SIZE + 8*num_blocks;
+    if (num_blocks > UINT32_MAX || out_size < size)
+    {
+        return 0;
+    }
+
+    memcpy(out, "FXPC", 4);
+    out[4] = FIXED_CODEC_VERSION;
+    out[5] = FRACTION_BITS;
+    put_u16(out + 6, FIXED_CODEC_BLOCK_VALUES);
+    put_u64(out + 8, num_values);
+    put_u32(out + 16, (uint32_t)num_blocks);
+    put_u32(out + 20, 0);
+
+    uint8_t block[MAX_BLOCK_SIZE];
+    for (size_t b = 0; b < num_blocks; b++)
+    {
+        size_t first = b*FIXED_CODEC_BLOCK_VALUES;
+        size_t n = num_values - first < FIXED_CODEC_BLOCK_VALUES ? num_values - first : FIXED_CODEC_BLOCK_VALUES;
+        // Encode into a scratch block first, so a too-small `out` is caught before writing past it.
+        size_t block_size = encode_block(values + first, n, block);
+        if (out_size - size < block_size)
+        {
+            return 0;
+        }
+        put_u64(out + FIXED_CODEC_HEADER_SIZE + 8*b, size);
+        memcpy(out + size, block, block_size);
+        size += block_size;
+    }
+    return size;
+}
+
+/// @brief      Parse and check the header of an encoded stream.
+/// @return     false if `data` isn't an encoded stream this version can read, or is cut short.
+bool fixed_codec_open(fixed_codec_reader_t * reader, const uint8_t * data, size_t size)
+{
+    if (size < FIXED_CODEC_HEADER_SIZE || memcmp(data, "FXPC", 4) != 0 || data[4] != FIXED_CODEC_VERSION
+        || get_u16(data + 6) != FIXED_CODEC_BLOCK_VALUES)
+    {
+        return false;
+    }
+    reader->data = data;
+    reader->size = size;
+    reader->fraction_bits = data[5];
+    reader->num_values = get_u64(data + 8);
+    reader->num_blocks = get_u32(data + 16);
+    uint64_t expected_blocks = reader->num_values / FIXED_CODEC_BLOCK_VALUES
+        + (reader->num_values % FIXED_CODEC_BLOCK_VALUES != 0);
+    return reader->num_blocks == expected_blocks
+        && (size - FIXED_CODEC_HEADER_SIZE)/8 >= reader->num_blocks;
+}
+
+#if defined(__SSE2__)
+
+// Unpack 4 slots (one from each lane), at bit `bit` of each lane, from the 4-lane words at `words`.
+static __m128i unpack_4(const uint8_t * words, size_t bit, uint8_t width, __m128i mask)
+{
+    size_t word = bit / 32;
+    int shift = (int)(bit % 32);
+    __m128i slots = _mm_srl_epi32(_mm_loadu_si128((const __m128i *)(words + 16*word)), _mm_cvtsi32_si128(shift));
+    if (shift + width > 32)
+    {
+        __m128i next = _mm_loadu_si128((const __m128i *)(words + 16*(word + 1)));
+        slots = _mm_or_si128(slots, _mm_sll_epi32(next, _mm_cvtsi32_si128(32 - shift)));
+    }
+    return _mm_and_si128(slots, mask);
+}
+
+// The running sum of the 4 lanes of `x`, plus the last lane of `carry` (which holds the previous running sum).
+static __m128i prefix_sum_4(__m128i x, __m128i carry)
+{
+    x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+    x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+    return _mm_add_epi32(x, _mm_shuffle_epi32(carry, _MM_SHUFFLE(3, 3, 3, 3)));
+}
+
+// Turn 4 slots back into 4 values, and store them.
+static void integrate_4(__m128i slots, int order, __m128i * delta, __m128i * value, fixed_point_t * out)
+{
+    if (order == 2)
+    {
+        *delta = prefix_sum_4(slots, *delta);
+        slots = *delta;
+    }
+    *value = prefix_sum_4(slots, *value);
+    _mm_storeu_si128((__m128i *)out, *value);
+}
+
+// Decode 128 bit-packed slots straight into values, 4 at a time, with no scratch array in between.
+static void decode_packed(const uint8_t * words, uint8_t width, uint32_t reference, int order, uint32_t first_value,
+                          uint32_t first_delta, fixed_point_t * out)
+{
+    __m128i mask = _mm_set1_epi32((int)width_mask(width));
+    __m128i reference_4 = _mm_set1_epi32((int)reference);
+    __m128i delta = _mm_set1_epi32((int)first_delta);
+    __m128i value = _mm_set1_epi32((int)(first_value - first_delta));
+    for (size_t i = 0; i < SLOTS_PER_LANE; i++)
+    {
+        __m128i slots = width == 0 ? reference_4 : _mm_add_epi32(unpack_4(words, i*width, width, mask), reference_4);
+        if (i == 0)
+        {
+            // The first `order` slots are always 0.
+            slots = _mm_and_si128(slots, order == 2 ? _mm_set_epi32(-1, -1, 0, 0) : _mm_set_epi32(-1, -1, -1, 0));
+        }
+        integrate_4(slots, order, &delta, &value, out + NUM_LANES*i);
+    }
+}
+
+// Turn 128 unpacked slots back into values.
+static void decode_slots(const uint32_t * slots, int order, uint32_t first_value, uint32_t first_delta,
+                         fixed_point_t * out)
+{
+    __m128i delta = _mm_set1_epi32((int)first_delta);
+    __m128i value = _mm_set1_epi32((int)(first_value - first_delta));
+    for (size_t i = 0; i < FIXED_CODEC_BLOCK_VALUES; i += NUM_LANES)
+    {
+        integrate_4(_mm_loadu_si128((const __m128i *)(slots + i)), order, &delta, &value, out + i);
+    }
+}
+
+#else // __SSE2__
+
+static void decode_slots(const uint32_t * slots, int order, uint32_t first_value, uint32_t first_delta,
+                         fixed_point_t * out)
+{
+    uint32_t delta = first_delta;
+    uint32_t value = first_value - first_delta;
+    for (size_t i = 0; i < FIXED_CODEC_BLOCK_VALUES; i++)
+    {
+        delta = order == 2 ? delta + slots[i] : slots[i];
+        value += delta;
+        out[i] = value;
+    }
+}
+
+static void decode_packed(const uint8_t * words, uint8_t width, uint32_t reference, int order, uint32_t first_value,
+                          uint32_t first_delta, fixed_point_t * out)
+{
+    uint32_t slots[FIXED_CODEC_BLOCK_VALUES];
+    uint32_t mask = width_mask(width);
+    for (size_t i = 0; i < FIXED_CODEC_BLOCK_VALUES; i++)
+    {
+        uint32_t slot = 0;
+        if (width > 0)
+        {
+            size_t bit = (i / NUM_LANES)*width;
+            size_t word = bit / 32;
+            size_t shift = bit % 32;
+            slot = get_u32(words + 4*(word*NUM_LANES + i % NUM_LANES)) >> shift;
+            if (shift + width > 32)
+            {
+                slot |= get_u32(words + 4*((word + 1)*NUM_LANES + i % NUM_LANES)) << (32 - shift);
+            }
+        }
+        // The first `order` slots are always 0.
+        slots[i] = i < (size_t)order ? 0 : (slot & mask) + reference;
+    }
+    decode_slots(slots, order, first_value, first_delta, out);
+}
+
+#endif // __SSE2__
+
+/// @brief      Decode block number `block_index` on its own (random access).
+/// @param[out] out     Room for FIXED_CODEC_BLOCK_VALUES values.
+/// @return     The number of values decoded (FIXED_CODEC_BLOCK_VALUES for all but the last block), or 0 if
+///             `block_index` is out of range or the block is corrupt.
+size_t fixed_codec_decode_block(const fixed_codec_reader_t * reader, uint32_t block_index, fixed_point_t * out)
+{
+    if (block_index >= reader->num_blocks)
+    {
+        return 0;
+    }
+    uint64_t first = (uint64_t)block_index*FIXED_CODEC_BLOCK_VALUES;
+    size_t n = reader->num_values - first < FIXED_CODEC_BLOCK_VALUES ? (size_t)(reader->num_values - first)
+                                                                    : FIXED_CODEC_BLOCK_VALUES;
+    uint64_t start = get_u64(reader->data + FIXED_CODEC_HEADER_SIZE + 8*(size_t)block_index);
+    if (start > reader->size || reader->size - start < BLOCK_HEADER_SIZE)
+    {
+        return 0;
+    }
+    const uint8_t * block = reader->data + start;
+    size_t available = reader->size - (size_t)start;
+    uint8_t encoding = block[0];
+    int order = (encoding & ENCODING_DELTA_OF_DELTA) ? 2 : 1;
+    uint32_t first_value = get_u32(block + 2);
+    uint32_t first_delta = get_u32(block + 6);
+    if (encoding > (ENCODING_PACKED | ENCODING_DELTA_OF_DELTA))
+    {
+        return 0;
+    }
+
+    // The last block may be short; decode it into scratch space so as not to write past `out`.
+    fixed_point_t scratch[FIXED_CODEC_BLOCK_VALUES];
+    fixed_point_t * values = n == FIXED_CODEC_BLOCK_VALUES ? out : scratch;
+    if (encoding & ENCODING_PACKED)
+    {
+        uint8_t width = block[1];
+        if (width > 32 || available < PACKED_HEADER_SIZE + (size_t)NUM_LANES*4*width)
+        {
+            return 0;
+        }
+        decode_packed(block + PACKED_HEADER_SIZE, width, get_u32(block + BLOCK_HEADER_SIZE), order, first_value,
+                      first_delta, values);
+    }
+    else
+    {
+        // The first `order` slots, and any past n, are 0.
+        uint32_t slots[FIXED_CODEC_BLOCK_VALUES] = {0};
+        size_t position = BLOCK_HEADER_SIZE;
+        for (size_t i = (size_t)order; i < n; i++)
+        {
+            size_t size = get_varint(block + position, available - position, &slots[i]);
+            if (size == 0)
+            {
+                return 0;
+            }
+            position += size;
+            slots[i] = zigzag_decode(slots[i]);
+        }
+        decode_slots(slots, order, first_value, first_delta, values);
+    }
+    if (values != out)
+    {
+        memcpy(out, values, n*sizeof(values[0]));
+    }
+    return n;
+}
+
+/// @brief      Decode every value in the stream.
+/// @param[out] out     Room for `reader->num_values` values.
+/// @return     false if any block is corrupt.
+bool fixed_codec_decode(const fixed_codec_reader_t * reader, fixed_point_t * out)
+{
+    for (uint32_t b = 0; b < reader->num_blocks; b++)
+    {
+        if (fixed_codec_decode_block(reader, b, out + (size_t)b*FIXED_CODEC_BLOCK_VALUES) == 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,72 @@
+/*
+fixed_point_codec
+- A compact serialization format for streams of `fixed_point_t` (ex: prices, or sensor readings), instead of writing
+  them out as raw 4-byte words.
+- Neighboring values in such streams are close together, and often change at a steady-ish rate, so what gets
+  stored is each value's delta-of-delta: how much its change differs from the previous value's change. Those are
+  mostly tiny numbers near 0, which take a handful of bits each instead of 32. (For data that moves like a random
+  walk, plain deltas are half as wide as delta-of-deltas, so each block uses whichever is smaller.)
+- Values are stored in blocks of FIXED_CODEC_BLOCK_VALUES (128). Each block stores its delta(-of-delta)s one of 2
+  ways:
+  - Frame-of-reference bit-packing: the block's smallest one is subtracted from all of them, and each offset is
+    stored in exactly as many bits as the largest one needs. The bits are laid out as 4 interleaved lanes (value i
+    goes in lane i % 4), so SSE2 decodes 4 values per instruction with no per-value branches, and the prefix sums
+    that turn them back into values are SIMD too.
+  - Zigzag varints: the sign is moved into the lowest bit (0, -1, 1, -2, ... => 0, 1, 2, 3, ...), then 7 bits are
+    stored per byte, with the top bit meaning "more bytes follow". Good when a few outliers are much bigger than the
+    rest, but slower to decode, so only used when it makes the block at least 25% smaller.
+- Every block stands alone, and a block index follows the header, so any block can be decoded without decoding the
+  ones before it (random access).
+- The header records FRACTION_BITS, so a reader can tell what Q format the values were written in.
+
+Format, all little-endian:
+    header (24 bytes):
+        "FXPC", u8 version (1), u8 fraction bits, u16 values per block (128), u64 number of values,
+        u32 number of blocks, u32 reserved (0)
+    block index: one u64 byte offset (from the start of the header) per block
+    blocks, each:
+        u8 encoding (bit 0: 1 = bit-packed, 0 = varints; bit 1: 1 = delta-of-deltas, 0 = deltas),
+        u8 bits per value (bit-packed only), u32 first value,
+        u32 first delta (the second value minus the first; delta-of-deltas only, else 0), then
+        varints:    the zigzagged deltas of values 2 to n, or delta-of-deltas of values 3 to n
+        bit-packed: u32 smallest delta(-of-delta), then 4*bits u32 words of bit-packed offsets from it, for all
+                    128 slots (the first 1 or 2 slots, and any past n, are unused)
+*/
+
+#ifndef FIXED_POINT_CODEC_H
+#define FIXED_POINT_CODEC_H
+
+#include <stddef.h>
+
+#include "fixed_point.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FIXED_CODEC_VERSION 1
+#define FIXED_CODEC_BLOCK_VALUES 128
+#define FIXED_CODEC_HEADER_SIZE 24
+
+// A parsed, validated encoded stream. Fill it in with fixed_codec_open(). It points into the encoded bytes, which
+// must outlive it.
+typedef struct fixed_codec_reader_s
+{
+    const uint8_t * data;
+    size_t size;
+    uint8_t fraction_bits; // the FRACTION_BITS the values were written with
+    uint64_t num_values;
+    uint32_t num_blocks;
+} fixed_codec_reader_t;
+
+size_t fixed_codec_max_encoded_size(size_t num_values);
+size_t fixed_codec_encode(const fixed_point_t * values, size_t num_values, uint8_t * out, size_t out_size);
+bool fixed_codec_open(fixed_codec_reader_t * reader, const uint8_t * data, size_t size);
+size_t fixed_codec_decode_block(const fixed_codec_reader_t * reader, uint32_t block_index, fixed_point_t * out);
+bool fixed_codec_decode(const fixed_codec_reader_t * reader, fixed_point_t * out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIXED_POINT_CODEC_H
@@ -0,0 +1,406 @@
+/*
+fixed_point_column
+- See fixed_point_column.h.
+*/
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "fixed_point_column.h"
+#include "fixed_point_div.h"
+#include "fixed_point_format.h"
+
+// Round a number of elements up to a whole number of SIMD widths.
+static size_t padded_size(size_t size)
+{
+    return (size + FIXED_COLUMN_PAD - 1) & ~(size_t)(FIXED_COLUMN_PAD - 1);
+}
+
+/// @brief      Create an empty column with room for at least `capacity` numbers.
+/// @param[in]  arena   Where to get the storage from, or NULL to use the heap. Arena-backed columns must not outlive
+///                     the next fixed_arena_reset() of their arena.
+/// @return     true on success; false if the storage could not be allocated.
+bool fixed_column_init(fixed_column_t * column, size_t capacity, fixed_arena_t * arena)
+{
+    column->data = NULL;
+    column->size = 0;
+    column->capacity = 0;
+    column->arena = arena;
+    return fixed_column_reserve(column, capacity);
+}
+
+/// @brief      Free a heap-backed column's storage. Arena-backed storage is given back by resetting the arena.
+void fixed_column_free(fixed_column_t * column)
+{
+    fixed_arena_free_or_heap(column->arena, column->data);
+    column->data = NULL;
+    column->size = 0;
+    column->capacity = 0;
+}
+
+/// @brief      Make sure the column has room for at least `capacity` numbers, moving it if needed.
+bool fixed_column_reserve(fixed_column_t * column, size_t capacity)
+{
+    capacity = padded_size(capacity == 0 ? 1 : capacity);
+    if (capacity <= column->capacity)
+    {
+        return true;
+    }
+
+    fixed_point_t * data = (fixed_point_t *)fixed_arena_alloc_or_heap(column->arena, capacity * sizeof(fixed_point_t),
+                                                                      FIXED_COLUMN_ALIGNMENT);
+    if (data == NULL)
+    {
+        return false;
+    }
+    // Copy over the old numbers, and zero everything after them, which keeps the padding at zero.
+    if (column->size > 0)
+    {
+        memcpy(data, column->data, column->size * sizeof(fixed_point_t));
+    }
+    memset(data + column->size, 0, (capacity - column->size) * sizeof(fixed_point_t));
+    fixed_arena_free_or_heap(column->arena, column->data);
+    column->data = data;
+    column->capacity = capacity;
+    return true;
+}
+
+/// @brief      Grow or shrink the column to exactly `size` numbers. New numbers are 0.
+bool fixed_column_resize(fixed_column_t * column, size_t size)
+{
+    if (!fixed_column_reserve(column, size))
+    {
+        return false;
+    }
+    // Zero whatever got cut off, to keep the padding at zero.
+    if (size < column->size)
+    {
+        memset(column->data + size, 0, (column->size - size) * sizeof(fixed_point_t));
+    }
+    column->size = size;
+    return true;
+}
+
+/// @brief      Append one number to the end of the column, doubling its capacity if it is full.
+bool fixed_column_push(fixed_column_t * column, fixed_point_t value)
+{
+    if (column->size == column->capacity && !fixed_column_reserve(column, column->capacity * 2))
+    {
+        return false;
+    }
+    column->data[column->size++] = value;
+    return true;
+}
+
+// Common checks and setup for the bulk operators. Returns the number of elements the kernels should process: the
+// whole padded size, since the padding is zero in the inputs and every kernel maps zero to zero.
+static bool prepare_output(fixed_column_t * out, const fixed_column_t * a, const fixed_column_t * b, size_t * n)
+{
+    if (b != NULL && a->size != b->size)
+    {
+        return false;
+    }
+    if (out != a && out != b && !fixed_column_resize(out, a->size))
+    {
+        return false;
+    }
+    *n = padded_size(a->size);
+    return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------------
+// Kernels. Each one processes `n` numbers, where `n` is a multiple of FIXED_COLUMN_PAD and all pointers are
+// FIXED_COLUMN_ALIGNMENT-aligned. `out` may alias an input.
+// -----------------------------------------------------------------------------------------------------------------
+
+#if defined(__SSE2__)
+
+// Unsigned 32-bit "a < b" per lane. SSE2 only has a *signed* compare, so flip the sign bits first.
+static __m128i cmplt_epu32(__m128i a, __m128i b)
+{
+    const __m128i SIGN = _mm_set1_epi32((int)0x80000000);
+    return _mm_cmplt_epi32(_mm_xor_si128(a, SIGN), _mm_xor_si128(b, SIGN));
+}
+
+// 32x32 = 64-bit multiply of all 4 lanes, plus `addend`, then `>> shift`, keeping the low 32 bits of each lane.
+// SSE2's _mm_mul_epu32() only multiplies the even lanes, so do the odd lanes separately and then interleave.
+static __m128i mul_add_shift_epu32(__m128i a, __m128i b, __m128i addend, int shift)
+{
+    const __m128i LOW32 = _mm_set_epi32(0, -1, 0, -1);
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    even = _mm_srli_epi64(_mm_add_epi64(even, addend), shift);
+    odd = _mm_srli_epi64(_mm_add_epi64(odd, addend), shift);
+    return _mm_or_si128(_mm_and_si128(even, LOW32), _mm_slli_epi64(odd, 32));
+}
+
+static void kernel_add(fixed_point_t * out, const fixed_point_t * a, const fixed_point_t * b, size_t n)
+{
+    for (size_t i = 0; i < n; i += 4)
+    {
+        __m128i va = _mm_load_si128((const __m128i *)(a + i));
+        __m128i vb = _mm_load_si128((const __m128i *)(b + i));
+        _mm_store_si128((__m128i *)(out + i), _mm_add_epi32(va, vb));
+    }
+}
+
+static void kernel_sub(fixed_point_t * out, const fixed_point_t * a, const fixed_point_t * b, size_t n)
+{
+    for (size_t i = 0; i < n; i += 4)
+    {
+        __m128i va = _mm_load_si128((const __m128i *)(a + i));
+        __m128i vb = _mm_load_si128((const __m128i *)(b + i));
+        _mm_store_si128((__m128i *)(out + i), _mm_sub_epi32(va, vb));
+    }
+}
+
+static void kernel_mul(fixed_point_t * out, const fixed_point_t * a, const fixed_point_t * b, size_t n)
+{
+    const __m128i HALF = _mm_set1_epi64x(FRACTION_DIVISOR/2);
+    for (size_t i = 0; i < n; i += 4)
+    {
+        __m128i va = _mm_load_si128((const __m128i *)(a + i));
+        __m128i vb = _mm_load_si128((const __m128i *)(b + i));
+        _mm_store_si128((__m128i *)(out + i), mul_add_shift_epu32(va, vb, HALF, FRACTION_BITS));
+    }
+}
+
+static void kernel_mul_int(fixed_point_t * out, const fixed_point_t * a, uint32_t times, size_t n)
+{
+    const __m128i TIMES = _mm_set1_epi32((int)times);
+    const __m128i ZERO = _mm_setzero_si128();
+    for (size_t i = 0; i < n; i += 4)
+    {
+        __m128i va = _mm_load_si128((const __m128i *)(a + i));
+        _mm_store_si128((__m128i *)(out + i), mul_add_shift_epu32(va, TIMES, ZERO, 0));
+    }
+}
+
+static void kernel_round_whole(fixed_point_t * out, const fixed_point_t * a, size_t n)
+{
+    const __m128i HALF = _mm_set1_epi32(FRACTION_DIVISOR/2);
+    const __m128i WHOLE_MASK = _mm_set1_epi32((int)~(uint32_t)FRACTION_MASK);
+    for (size_t i = 0; i < n; i += 4)
+    {
+        __m128i va = _mm_load_si128((const __m128i *)(a + i));
+        __m128i sum = _mm_add_epi32(va, HALF);
+        // Saturate (all bits set) wherever adding the 1/2 wrapped around.
+        __m128i overflowed = cmplt_epu32(sum, va);
+        _mm_store_si128((__m128i *)(out + i), _mm_or_si128(_mm_and_si128(sum, WHOLE_MASK), overflowed));
+    }
+}
+
+#else // __SSE2__
+
+static void kernel_add(fixed_point_t * out, const fixed_point_t * a, const fixed_point_t * b, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        out[i] = a[i] + b[i];
+    }
+}
+
+static void kernel_sub(fixed_point_t * out, const fixed_point_t * a, const fixed_point_t * b, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        out[i] = a[i] - b[i];
+    }
+}
+
+static void kernel_mul(fixed_point_t * out, const fixed_point_t * a, const fixed_point_t * b, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        out[i] = (fixed_point_t)(((uint64_t)a[i] * b[i] + FRACTION_DIVISOR/2) >> FRACTION_BITS);
+    }
+}
+
+static void kernel_mul_int(fixed_point_t * out, const fixed_point_t * a, uint32_t times, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        out[i] = a[i] * times;
+    }
+}
+
+static void kernel_round_whole(fixed_point_t * out, const fixed_point_t * a, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        fixed_point_t sum = a[i] + FRACTION_DIVISOR/2;
+        out[i] = sum < a[i] ? UINT32_MAX : (sum & ~(fixed_point_t)FRACTION_MASK);
+    }
+}
+
+#endif // __SSE2__
+
+// There is no SIMD integer divide, so division is done one number at a time.
+static void kernel_div(fixed_point_t * out, const fixed_point_t * a, const fixed_point_t * b, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        // Integer rounding during the divide: (a + b/2)/b. Saturate on overflow and on divide-by-zero.
+        uint64_t quotient = b[i] == 0 ? UINT32_MAX : (((uint64_t)a[i] << FRACTION_BITS) + b[i]/2) / b[i];
+        out[i] = quotient > UINT32_MAX ? UINT32_MAX : (fixed_point_t)quotient;
+    }
+}
+
+
+// -----------------------------------------------------------------------------------------------------------------
+// Bulk operators
+// -----------------------------------------------------------------------------------------------------------------
+
+/// @brief      out = a + b, per number. Wraps around on overflow, just like `price += 10 << FRACTION_BITS` does.
+bool fixed_column_add(fixed_column_t * out, const fixed_column_t * a, const fixed_column_t * b)
+{
+    size_t n;
+    if (!prepare_output(out, a, b, &n))
+    {
+        return false;
+    }
+    kernel_add(out->data, a->data, b->data, n);
+    return true;
+}
+
+/// @brief      out = a - b, per number. Wraps around on underflow.
+bool fixed_column_sub(fixed_column_t * out, const fixed_column_t * a, const fixed_column_t * b)
+{
+    size_t n;
+    if (!prepare_output(out, a, b, &n))
+    {
+        return false;
+    }
+    kernel_sub(out->data, a->data, b->data, n);
+    return true;
+}
+
+/// @brief      out = a * b, per number, for two fixed-point numbers: `(a*b + FRACTION_DIVISOR/2) >> FRACTION_BITS`,
+///             ie: the product rounded to the nearest 1/FRACTION_DIVISOR. Keeps the low 32 bits on overflow.
+bool fixed_column_mul(fixed_column_t * out, const fixed_column_t * a, const fixed_column_t * b)
+{
+    size_t n;
+    if (!prepare_output(out, a, b, &n))
+    {
+        return false;
+    }
+    kernel_mul(out->data, a->data, b->data, n);
+    return true;
+}
+
+/// @brief      out = a / b, per number, for two fixed-point numbers, rounded to the nearest 1/FRACTION_DIVISOR.
+///             Results that don't fit, and division by zero, saturate to UINT32_MAX.
+bool fixed_column_div(fixed_column_t * out, const fixed_column_t * a, const fixed_column_t * b)
+{
+    size_t n;
+    if (!prepare_output(out, a, b, &n))
+    {
+        return false;
+    }
+    // Only divide the real numbers; the padding would be 0/0.
+    kernel_div(out->data, a->data, b->data, a->size);
+    memset(out->data + a->size, 0, (n - a->size) * sizeof(fixed_point_t));
+    return true;
+}
+
+/// @brief      out = a * times, per number, ie: `price *= 3`. Wraps around on overflow.
+bool fixed_column_mul_int(fixed_column_t * out, const fixed_column_t * a, uint32_t times)
+{
+    size_t n;
+    if (!prepare_output(out, a, NULL, &n))
+    {
+        return false;
+    }
+    kernel_mul_int(out->data, a->data, times, n);
+    return true;
+}
+
+/// @brief      out = a / divide, per number, ie: `price /= 7`, but with integer rounding: (a + divide/2)/divide.
+/// @return     false if `divide` is 0.
+bool fixed_column_div_int(fixed_column_t * out, const fixed_column_t * a, uint32_t divide)
+{
+    size_t n;
+    if (divide == 0 || !prepare_output(out, a, NULL, &n))
+    {
+        return false;
+    }
+    // One divisor for the whole column, so divide by multiplying by its reciprocal instead.
+    fixed_div_int_batch(out->data, a->data, n, divide);
+    return true;
+}
+
+/// @brief      Round each number to `num_digits_after_decimal` decimal digits, giving the fixed-point number
+///             nearest to that rounded decimal (ex: 219.857131 at 2 digits --> the closest fixed-point number to
+///             219.86). Results too large to represent saturate to UINT32_MAX.
+bool fixed_column_round(fixed_column_t * out, const fixed_column_t * a, uint8_t num_digits_after_decimal)
+{
+    size_t n;
+    if (!prepare_output(out, a, NULL, &n))
+    {
+        return false;
+    }
+    if (num_digits_after_decimal == 0)
+    {
+        // Rounding to a whole number is just the tutorial's "add FRACTION_DIVISOR/2 and drop the fraction bits",
+        // which vectorizes.
+        kernel_round_whole(out->data, a->data, n);
+        return true;
+    }
+    if (num_digits_after_decimal > FIXED_FORMAT_MAX_DIGITS)
+    {
+        num_digits_after_decimal = FIXED_FORMAT_MAX_DIGITS;
+    }
+    uint64_t pow10 = 1;
+    for (uint8_t i = 0; i < num_digits_after_decimal; i++)
+    {
+        pow10 *= 10;
+    }
+    for (size_t i = 0; i < a->size; i++)
+    {
+        uint64_t decimal = fixed_round_to_decimal(a->data[i], num_digits_after_decimal);
+        uint64_t rounded = ((decimal << FRACTION_BITS) + pow10/2) / pow10;
+        out->data[i] = rounded > UINT32_MAX ? UINT32_MAX : (fixed_point_t)rounded;
+    }
+    return true;
+}
+
+/// @brief      Print every number in the column as a "float" (see fixed_format()), with `separator` between them
+///             (ex: '\n' or ','), into one contiguous, null-terminated buffer.
+/// @return     The number of chars written, not counting the terminating null, or 0 if `out_size` is too small. A
+///             buffer of `a->size * FIXED_FORMAT_MAX_LEN` chars is always big enough.
+size_t fixed_column_format(const fixed_column_t * a, uint8_t num_digits_after_decimal, char separator,
+                           char * out, size_t out_size)
+{
+    char number[FIXED_FORMAT_MAX_LEN];
+    size_t num_chars = 0;
+
+    for (size_t i = 0; i < a->size; i++)
+    {
+        size_t len = fixed_format(a->data[i], num_digits_after_decimal, number);
+        // +1 for the separator or the terminating null.
+        if (num_chars + len + 1 > out_size)
+        {
+            return 0;
+        }
+        if (i > 0)
+        {
+            out[num_chars - 1] = separator;
+        }
+        memcpy(out + num_chars, number, len);
+        num_chars += len + 1;
+    }
+    if (a->size == 0)
+    {
+        if (out_size == 0)
+        {
+            return 0;
+        }
+        out[0] = '\0';
+        return 0;
+    }
+    out[num_chars - 1] = '\0';
+    return num_chars - 1;
+}
@@ -0,0 +1,58 @@
+/*
+fixed_point_column
+- A "column" of fixed-point numbers: one contiguous, 64-byte-aligned array of `fixed_point_t` (structure-of-arrays
+  storage) plus bulk +, -, *, /, rounding, and formatting operators that run on the whole column at once.
+- Keeping the numbers contiguous (instead of inside an array of structs) is what lets the `>> FRACTION_BITS` and
+  `& FRACTION_MASK` work run on 4+ values per instruction in SIMD registers.
+- The storage is always padded up to a whole number of SIMD widths (FIXED_COLUMN_PAD elements), and the padding is
+  always kept at zero, so the SIMD kernels never need a scalar "leftovers" loop at the end.
+- Storage comes either from the heap or from a fixed_arena_t (see fixed_point_arena.h).
+*/
+
+#ifndef FIXED_POINT_COLUMN_H
+#define FIXED_POINT_COLUMN_H
+
+#include <stddef.h>
+
+#include "fixed_point.h"
+#include "fixed_point_arena.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FIXED_COLUMN_ALIGNMENT FIXED_ARENA_ALIGNMENT
+// Columns always have room for a multiple of this many numbers (16 for a 32-bit fixed_point_t).
+#define FIXED_COLUMN_PAD (FIXED_COLUMN_ALIGNMENT / sizeof(fixed_point_t))
+
+typedef struct fixed_column_s
+{
+    fixed_point_t * data; // FIXED_COLUMN_ALIGNMENT-aligned
+    size_t size;          // number of numbers in the column
+    size_t capacity;      // number of numbers there is room for; always a multiple of FIXED_COLUMN_PAD
+    fixed_arena_t * arena; // where `data` came from; NULL if from the heap
+} fixed_column_t;
+
+bool fixed_column_init(fixed_column_t * column, size_t capacity, fixed_arena_t * arena);
+void fixed_column_free(fixed_column_t * column);
+bool fixed_column_reserve(fixed_column_t * column, size_t capacity);
+bool fixed_column_resize(fixed_column_t * column, size_t size);
+bool fixed_column_push(fixed_column_t * column, fixed_point_t value);
+
+// Bulk operators. `out` may be the same column as `a` and/or `b`. `out` is resized to the size of the inputs.
+// All return false (leaving `out` unchanged) if the input sizes differ or `out` can't be resized.
+bool fixed_column_add(fixed_column_t * out, const fixed_column_t * a, const fixed_column_t * b);
+bool fixed_column_sub(fixed_column_t * out, const fixed_column_t * a, const fixed_column_t * b);
+bool fixed_column_mul(fixed_column_t * out, const fixed_column_t * a, const fixed_column_t * b);
+bool fixed_column_div(fixed_column_t * out, const fixed_column_t * a, const fixed_column_t * b);
+bool fixed_column_mul_int(fixed_column_t * out, const fixed_column_t * a, uint32_t times);
+bool fixed_column_div_int(fixed_column_t * out, const fixed_column_t * a, uint32_t divide);
+bool fixed_column_round(fixed_column_t * out, const fixed_column_t * a, uint8_t num_digits_after_decimal);
+size_t fixed_column_format(const fixed_column_t * a, uint8_t num_digits_after_decimal, char separator,
+                           char * out, size_t out_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIXED_POINT_COLUMN_H
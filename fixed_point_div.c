@@ -0,0 +1,230 @@
+/*
+fixed_point_div
+- See fixed_point_div.h.
+*/
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "fixed_point_div.h"
+#include "fixed_point_round.h"
+
+// Seeds for the reciprocal: RECIPROCAL_SEED[i] = round(2^24/(256 + i + 0.5)), which is 1/x in Q1.15 for the x in
+// [0.5, 1) whose top 9 bits are 1, i (ie: x = (256 + i)/512), taken at the middle of that range. Good to ~9 bits.
+static const uint16_t RECIPROCAL_SEED[256] =
+{
+    65408, 65154, 64902, 64652, 64404, 64158, 63913, 63671, 63430, 63191, 62954, 62719,
+    62485, 62253, 62023, 61795, 61568, 61343, 61119, 60897, 60677, 60458, 60241, 60026,
+    59812, 59599, 59388, 59179, 58971, 58764, 58559, 58356, 58153, 57952, 57753, 57555,
+    57358, 57163, 56968, 56776, 56584, 56394, 56205, 56017, 55831, 55646, 55462, 55279,
+    55098, 54917, 54738, 54560, 54383, 54207, 54033, 53859, 53687, 53516, 53346, 53177,
+    53009, 52842, 52676, 52511, 52347, 52184, 52022, 51862, 51702, 51543, 51385, 51228,
+    51072, 50917, 50763, 50610, 50458, 50306, 50156, 50007, 49858, 49710, 49563, 49417,
+    49272, 49128, 48985, 48842, 48700, 48559, 48419, 48280, 48141, 48003, 47867, 47730,
+    47595, 47460, 47326, 47193, 47061, 46929, 46798, 46668, 46539, 46410, 46282, 46155,
+    46028, 45902, 45777, 45652, 45528, 45405, 45283, 45161, 45040, 44919, 44799, 44680,
+    44561, 44443, 44326, 44209, 44093, 43977, 43862, 43748, 43634, 43521, 43408, 43296,
+    43185, 43074, 42963, 42854, 42744, 42636, 42528, 42420, 42313, 42207, 42101, 41996,
+    41891, 41786, 41683, 41579, 41476, 41374, 41272, 41171, 41070, 40970, 40870, 40771,
+    40672, 40574, 40476, 40378, 40281, 40185, 40089, 39993, 39898, 39804, 39709, 39616,
+    39522, 39429, 39337, 39245, 39153, 39062, 38971, 38881, 38791, 38702, 38613, 38524,
+    38436, 38348, 38260, 38173, 38087, 38000, 37915, 37829, 37744, 37659, 37575, 37491,
+    37407, 37324, 37241, 37159, 37077, 36995, 36914, 36833, 36752, 36672, 36592, 36512,
+    36433, 36354, 36275, 36197, 36119, 36041, 35964, 35887, 35810, 35734, 35658, 35583,
+    35507, 35432, 35358, 35283, 35209, 35136, 35062, 34989, 34916, 34844, 34771, 34700,
+    34628, 34557, 34486, 34415, 34344, 34274, 34204, 34135, 34065, 33996, 33928, 33859,
+    33791, 33723, 33655, 33588, 33521, 33454, 33387, 33321, 33255, 33189, 33124, 33059,
+    32994, 32929, 32864, 32800,
+};
+
+// Whether (2^32 + reciprocal)*normalized > 2^64 - 1, ie: whether `reciprocal` is too big. `reciprocal` may be up to
+// 2^32 here, so that `reciprocal + 1` can be tested too.
+static bool reciprocal_too_big(uint64_t reciprocal, uint32_t normalized)
+{
+    // (2^32 + reciprocal)*normalized = normalized*2^32 + reciprocal*normalized. Add up just the part above bit 32.
+    return (uint64_t)normalized + ((reciprocal * normalized) >> 32) > UINT32_MAX;
+}
+
+// Compute floor((2^64 - 1)/normalized) - 2^32 without a divide, for a `normalized` with its top bit set.
+static uint32_t compute_reciprocal(uint32_t normalized)
+{
+    // Think of `normalized` as the number d = normalized/2^32 in [0.5, 1). We want 1/d, in (1, 2].
+
+    // 1. Table seed: x0 ~= 1/d in Q1.15, good to ~9 bits.
+    uint64_t x0 = RECIPROCAL_SEED[(normalized >> 23) - 256];
+
+    // 2. Newton-Raphson: x1 = x0*(2 - d*x0) = x0 + x0*(1 - d*x0). Each iteration doubles the number of good bits.
+    // Using just the top 16 bits of d here limits this one to ~16 good bits, which is all the next step needs.
+    // x1 is in Q1.31. The error terms are kept as magnitudes to avoid right-shifting negative numbers.
+    uint64_t d_times_x0 = (uint64_t)(normalized >> 16) * x0; // ~= 2^31 (1.0 in Q1.31)
+    uint64_t x1 = x0 << 16;
+    if (d_times_x0 <= (1ULL << 31))
+    {
+        x1 += (x0 * ((1ULL << 31) - d_times_x0)) >> 15;
+    }
+    else
+    {
+        x1 -= (x0 * (d_times_x0 - (1ULL << 31))) >> 15;
+    }
+
+    // 3. Another Newton-Raphson iteration, with all 32 bits of d this time, for ~30 good bits. x2 is in Q1.31 too.
+    // The products are pre-shifted so they fit in 64 bits: x1 < 2^33 and the error is < 2^50.
+    uint64_t d_times_x1 = (uint64_t)normalized * x1; // ~= 2^63 (1.0 in Q1.63)
+    uint64_t x2 = x1;
+    if (d_times_x1 <= (1ULL << 63))
+    {
+        x2 += ((x1 >> 1) * (((1ULL << 63) - d_times_x1) >> 18)) >> 44;
+    }
+    else
+    {
+        x2 -= ((x1 >> 1) * ((d_times_x1 - (1ULL << 63)) >> 18)) >> 44;
+    }
+
+    // 4. Convert to the form we want, 2^64/normalized - 2^32, and clamp it to a 32-bit number.
+    uint64_t x = x2 << 1;
+    uint64_t reciprocal = x < (1ULL << 32) ? 0 : x - (1ULL << 32);
+    if (reciprocal > UINT32_MAX)
+    {
+        reciprocal = UINT32_MAX;
+    }
+
+    // 5. It's now within a couple of units of the exact answer. Step it there, testing it by multiplying back.
+    while (reciprocal_too_big(reciprocal, normalized))
+    {
+        reciprocal--;
+    }
+    while (!reciprocal_too_big(reciprocal + 1, normalized))
+    {
+        reciprocal++;
+    }
+    return (uint32_t)reciprocal;
+}
+
+/// @brief      Precompute everything needed to divide by `divisor` quickly and exactly, with fixed_div_recip()
+///             (when `divisor` is a fixed-point number) or fixed_div_int_recip() (when it is a plain integer).
+/// @return     true on success; false if `divisor` is 0. `recip` is then still usable: every result saturates to
+///             UINT32_MAX, just like fixed_div() by 0.
+bool fixed_recip_init(fixed_recip_t * recip, uint32_t divisor)
+{
+    recip->divisor = divisor;
+    recip->normalized = 0;
+    recip->reciprocal = 0;
+    recip->shift = 0;
+    if (divisor == 0)
+    {
+        return false;
+    }
+
+    uint32_t normalized = divisor;
+    while ((normalized & 0x80000000) == 0)
+    {
+        normalized <<= 1;
+        recip->shift++;
+    }
+    recip->normalized = normalized;
+    recip->reciprocal = compute_reciprocal(normalized);
+    return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------------
+// Batch division by one divisor
+// -----------------------------------------------------------------------------------------------------------------
+
+#if defined(__SSE2__)
+
+// Unsigned 32-bit a < b, per lane. SSE2 only has a signed compare, so flip the sign bits first.
+static __m128i cmplt_epu32(__m128i a, __m128i b)
+{
+    const __m128i SIGN = _mm_set1_epi32((int)0x80000000);
+    return _mm_cmplt_epi32(_mm_xor_si128(a, SIGN), _mm_xor_si128(b, SIGN));
+}
+
+// The truncated quotients of 2 numerators at once, one per 64-bit lane of `u`, already shifted left by the divisor's
+// `shift`, as in fixed_recip_div_round(). Only the low 32 bits of each 64-bit lane of the result are meaningful.
+static __m128i div_2_lanes(__m128i u, __m128i reciprocal, __m128i normalized)
+{
+    const __m128i ONE_SHL_32 = _mm_set_epi32(1, 0, 1, 0);
+
+    // product = reciprocal*u1 + ((u1 + 1) << 32 | u0) = reciprocal*u1 + u + 2^32, per 64-bit lane.
+    __m128i product = _mm_add_epi64(_mm_add_epi64(_mm_mul_epu32(_mm_srli_epi64(u, 32), reciprocal), u), ONE_SHL_32);
+    __m128i quotient = _mm_srli_epi64(product, 32);
+    // remainder = u0 - quotient*normalized, mod 2^32 (only the low 32 bits of each lane are used from here on).
+    __m128i remainder = _mm_sub_epi32(u, _mm_mul_epu32(quotient, normalized));
+
+    __m128i too_big = cmplt_epu32(product, remainder);
+    quotient = _mm_add_epi32(quotient, too_big);
+    remainder = _mm_add_epi32(remainder, _mm_and_si128(too_big, normalized));
+    // quotient += (remainder >= normalized), ie: quotient + 1 - (remainder < normalized).
+    __m128i too_small = cmplt_epu32(remainder, normalized);
+    return _mm_add_epi32(_mm_sub_epi32(quotient, _mm_set1_epi32(-1)), too_small);
+}
+
+// out[i] = round((a[i] << numerator_shift) / divisor), saturated, 4 numbers at a time. `numerator_shift` is 0 to 16.
+static void div_batch(fixed_point_t * out, const fixed_point_t * a, size_t n, const fixed_recip_t * recip,
+                      int numerator_shift)
+{
+    // Round with (a + b/2)/b, like fixed_recip_div_round() does. Pre-shift the b/2 by the divisor's `shift` too.
+    const uint32_t half = recip->divisor/2;
+    const __m128i half_shifted = _mm_set1_epi64x((long long)((uint64_t)half << recip->shift));
+    const __m128i total_shift = _mm_cvtsi32_si128(numerator_shift + recip->shift);
+    const __m128i reciprocal = _mm_set1_epi32((int)recip->reciprocal);
+    const __m128i normalized = _mm_set1_epi32((int)recip->normalized);
+    const __m128i ZERO = _mm_setzero_si128();
+
+    // The quotient doesn't fit in 32 bits when (a << numerator_shift) + b/2 >= divisor*2^32, ie: when a >= this
+    // threshold. (This also saturates everything when the divisor is 0.)
+    uint64_t threshold = ((((uint64_t)recip->divisor << 32) - half) + (1ULL << numerator_shift) - 1) >> numerator_shift;
+    const __m128i overflow_threshold = _mm_set1_epi32((int)(threshold > UINT32_MAX ? UINT32_MAX : threshold));
+    const __m128i overflow_possible = _mm_set1_epi32(threshold > UINT32_MAX ? 0 : -1);
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128i values = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i u_lo = _mm_add_epi64(_mm_sll_epi64(_mm_unpacklo_epi32(values, ZERO), total_shift), half_shifted);
+        __m128i u_hi = _mm_add_epi64(_mm_sll_epi64(_mm_unpackhi_epi32(values, ZERO), total_shift), half_shifted);
+        __m128i q_lo = div_2_lanes(u_lo, reciprocal, normalized);
+        __m128i q_hi = div_2_lanes(u_hi, reciprocal, normalized);
+        __m128i quotients = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(q_lo), _mm_castsi128_ps(q_hi),
+                                                            _MM_SHUFFLE(2, 0, 2, 0)));
+        __m128i overflow = _mm_andnot_si128(cmplt_epu32(values, overflow_threshold), overflow_possible);
+        _mm_storeu_si128((__m128i *)(out + i), _mm_or_si128(quotients, overflow));
+    }
+    for (; i < n; i++)
+    {
+        out[i] = fixed_recip_div_round((uint64_t)a[i] << numerator_shift, recip);
+    }
+}
+
+#else
+
+static void div_batch(fixed_point_t * out, const fixed_point_t * a, size_t n, const fixed_recip_t * recip,
+                      int numerator_shift)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        out[i] = fixed_recip_div_round((uint64_t)a[i] << numerator_shift, recip);
+    }
+}
+
+#endif // __SSE2__
+
+/// @brief      out[i] = a[i] / b for n fixed-point numbers and one fixed-point divisor, computing b's reciprocal
+///             once and reusing it for every division. Same results as fixed_div(). `out` may be the same as `a`.
+void fixed_div_batch(fixed_point_t * out, const fixed_point_t * a, size_t n, fixed_point_t b)
+{
+    fixed_recip_t recip;
+    fixed_recip_init(&recip, b);
+    div_batch(out, a, n, &recip, FRACTION_BITS);
+}
+
+/// @brief      out[i] = a[i] / divide for n fixed-point numbers and one integer divisor (ie: `price /= 7` on every
+///             number), rounded half up, reusing one reciprocal. Division by zero saturates to UINT32_MAX. `out` may
+///             be the same as `a`.
+void fixed_div_int_batch(fixed_point_t * out, const fixed_point_t * a, size_t n, uint32_t divide)
+{
+    fixed_recip_t recip;
+    fixed_recip_init(&recip, divide);
+    div_batch(out, a, n, &recip, 0);
+}
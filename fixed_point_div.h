@@ -0,0 +1,152 @@
+/*
+fixed_point_div
+- Division of one fixed-point number by another (`a / b`, both Q16.16), and of a fixed-point number by an integer
+  (`price /= 7`), rounded to the nearest result with the tutorial's round-half-up `(a + b/2)/b` rule.
+- Dividing two fixed-point numbers needs `(a << FRACTION_BITS) / b`: a 64-by-32-bit divide, which is slow in hardware
+  and is a (much slower) software routine on MCUs without a divide instruction.
+- So, when dividing by the same divisor more than once, compute its reciprocal once (`fixed_recip_init()`), then each
+  division by it (`fixed_div_recip()`, `fixed_div_int_recip()`) takes just 2 multiplies and a few adds and compares,
+  with no divide instruction at all. This is the Möller-Granlund "division by invariant integers using a normalized
+  reciprocal" method (udiv_qrnnd_preinv in GMP), which gives the *exact* quotient and remainder.
+- Even computing the reciprocal uses no divide: it starts from a 256-entry table seed (~9 bits), doubles the bits of
+  precision twice with Newton-Raphson iterations, and then corrects the last bit or two exactly.
+- The results are bit-for-bit identical to plain division with remainder-based rounding, for every input.
+*/
+
+#ifndef FIXED_POINT_DIV_H
+#define FIXED_POINT_DIV_H
+
+#include <stddef.h>
+
+#include "fixed_point.h"
+#include "fixed_point_round.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A divisor plus its precomputed normalized reciprocal. Fill it in with fixed_recip_init().
+typedef struct fixed_recip_s
+{
+    uint32_t divisor;    // the divisor itself; 0 means "divide by zero", which saturates every result
+    uint32_t normalized; // `divisor << shift`, so its top bit is set
+    uint32_t reciprocal; // floor((2^64 - 1)/normalized) - 2^32
+    uint8_t shift;       // the number of leading zero bits in `divisor`
+} fixed_recip_t;
+
+bool fixed_recip_init(fixed_recip_t * recip, uint32_t divisor);
+void fixed_div_batch(fixed_point_t * out, const fixed_point_t * a, size_t n, fixed_point_t b);
+void fixed_div_int_batch(fixed_point_t * out, const fixed_point_t * a, size_t n, uint32_t divide);
+
+/// @brief      a / b for two fixed-point numbers, using a plain hardware (or software) divide. Use this for one-off
+///             divisions, where computing a reciprocal first wouldn't pay off.
+/// @details    Rounded to the nearest 1/FRACTION_DIVISOR from the remainder, which is the tutorial's
+///             `(a + b/2)/b` rule, without the overflow. Results that don't fit, and division by zero, saturate to
+///             UINT32_MAX.
+static inline FIXED_CONSTEXPR fixed_point_t fixed_div(fixed_point_t a, fixed_point_t b)
+{
+    uint64_t numerator = (uint64_t)a << FRACTION_BITS;
+    if (b == 0 || (numerator >> 32) >= b)
+    {
+        return UINT32_MAX;
+    }
+    uint64_t rounded = fixed_div_round_u64(numerator, b, FIXED_ROUND_HALF_UP);
+    return rounded > UINT32_MAX ? UINT32_MAX : (fixed_point_t)rounded;
+}
+
+/// @brief      Divide a 64-bit `numerator` by a precomputed divisor, truncating, with no divide instruction.
+/// @details    `numerator` must be less than `divisor*2^32` (ie: the quotient must fit in 32 bits), and the divisor
+///             must not be 0.
+/// @param[out] remainder   Gets `numerator % divisor`.
+/// @return     `numerator / divisor`.
+static inline FIXED_CONSTEXPR uint32_t fixed_recip_divmod(uint64_t numerator, const fixed_recip_t * recip,
+                                                          uint32_t * remainder)
+{
+    // Scale the numerator up by the same amount as the divisor. Since numerator < divisor*2^32, this can't overflow,
+    // and the quotient stays the same. Its top 32 bits are now less than the normalized divisor, as required.
+    uint64_t u = numerator << recip->shift;
+    uint32_t u1 = (uint32_t)(u >> 32);
+    uint32_t u0 = (uint32_t)u;
+
+    // Estimate the quotient from the reciprocal: q ~= u1*(2^32 + reciprocal)/2^32, plus a little. The estimate is
+    // at most 1 too small or 1 too large, which the remainder checks below fix. All math here is mod 2^32 or 2^64.
+    uint64_t product = (uint64_t)recip->reciprocal * u1 + ((((uint64_t)u1 + 1) << 32) | u0);
+    uint32_t quotient = (uint32_t)(product >> 32);
+    uint32_t r = u0 - quotient * recip->normalized;
+    // This first correction is needed about half the time, unpredictably, so do it without a branch.
+    uint32_t too_big_mask = (uint32_t)0 - (uint32_t)(r > (uint32_t)product);
+    quotient += too_big_mask;
+    r += too_big_mask & recip->normalized;
+    // This second one is rare.
+    if (r >= recip->normalized)
+    {
+        quotient++;
+        r -= recip->normalized;
+    }
+
+    // The remainder got scaled up along with the numerator; undo that.
+    *remainder = r >> recip->shift;
+    return quotient;
+}
+
+/// @brief      Divide any 64-bit `numerator` by a precomputed (non-zero) divisor, truncating, with no divide
+///             instruction: long division in 2 steps of 32 bits each, like on paper.
+/// @param[out] remainder   Gets `numerator % divisor`.
+/// @return     `numerator / divisor`.
+static inline FIXED_CONSTEXPR uint64_t fixed_recip_divmod_u64(uint64_t numerator, const fixed_recip_t * recip,
+                                                              uint32_t * remainder)
+{
+    // Most numerators (ex: nanosecond timestamps divided into seconds) have a quotient that fits in 32 bits, which
+    // takes just one step.
+    if ((numerator >> 32) < recip->divisor)
+    {
+        return fixed_recip_divmod(numerator, recip, remainder);
+    }
+    // The high half is < 2^32 <= divisor*2^32, and (remainder of the high half) << 32 | low half is
+    // < divisor*2^32, so both steps meet fixed_recip_divmod()'s requirement.
+    uint32_t quotient_hi = fixed_recip_divmod(numerator >> 32, recip, remainder);
+    uint32_t quotient_lo = fixed_recip_divmod(((uint64_t)*remainder << 32) | (uint32_t)numerator, recip, remainder);
+    return ((uint64_t)quotient_hi << 32) | quotient_lo;
+}
+
+/// @brief      Divide a 64-bit `numerator` by a precomputed divisor, rounding half up, with no divide instruction.
+/// @return     The rounded quotient; or UINT32_MAX if it doesn't fit in 32 bits, or if the divisor is 0.
+static inline FIXED_CONSTEXPR uint32_t fixed_recip_div_round(uint64_t numerator, const fixed_recip_t * recip)
+{
+    // The quotient fits in 32 bits only if numerator < divisor*2^32. This also catches a divisor of 0.
+    if ((numerator >> 32) >= recip->divisor)
+    {
+        return UINT32_MAX;
+    }
+    // Round with the tutorial's `(a + b/2)/b` rule, so only a truncating divide is needed after this. It is exact
+    // for odd divisors too (see "fixed_point_round.h"), and it can't overflow here since numerator < divisor*2^32.
+    numerator += recip->divisor/2;
+    if ((numerator >> 32) >= recip->divisor)
+    {
+        return UINT32_MAX;
+    }
+    uint32_t remainder = 0;
+    return fixed_recip_divmod(numerator, recip, &remainder);
+}
+
+/// @brief      a / b for two fixed-point numbers, where `recip` was made from `b` with fixed_recip_init().
+///             Rounded to the nearest 1/FRACTION_DIVISOR. Results that don't fit, and division by zero, saturate to
+///             UINT32_MAX. Identical to fixed_div(a, b).
+static inline FIXED_CONSTEXPR fixed_point_t fixed_div_recip(fixed_point_t a, const fixed_recip_t * recip)
+{
+    return fixed_recip_div_round((uint64_t)a << FRACTION_BITS, recip);
+}
+
+/// @brief      a / divide for a fixed-point number and an integer (ie: `price /= 7`), where `recip` was made from
+///             `divide` with fixed_recip_init(). Rounded half up: identical to `(a + divide/2)/divide` (done without
+///             overflow). Division by zero saturates to UINT32_MAX.
+static inline FIXED_CONSTEXPR fixed_point_t fixed_div_int_recip(fixed_point_t a, const fixed_recip_t * recip)
+{
+    return fixed_recip_div_round(a, recip);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIXED_POINT_DIV_H
@@ -0,0 +1,613 @@
+/*
+fixed_point_fft
+- See fixed_point_fft.h.
+*/
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <string.h>
+
+#include "fixed_point_fft.h"
+
+#define SIGN_BIT 0x80000000u
+#define SIGN_BIT_64 ((uint64_t)1 << 63)
+
+// -----------------------------------------------------------------------------------------------------------------
+// Twiddle factors, with integers only
+// -----------------------------------------------------------------------------------------------------------------
+
+// 1 and pi/4 in unsigned Q2.62.
+#define ONE_Q62 ((uint64_t)1 << 62)
+#define PI_OVER_4_Q62 UINT64_C(3622009729038561421)
+
+// `(a * b) >> shift` (shift 1 to 63), for a 128-bit product that fits 64 bits after the shift: the product from
+// 32-bit halves, since C has no 128-bit type.
+static uint64_t mul_shift(uint64_t a, uint64_t b, unsigned shift)
+{
+    uint64_t low = (a & 0xFFFFFFFF) * (b & 0xFFFFFFFF);
+    uint64_t middle1 = (a >> 32) * (b & 0xFFFFFFFF);
+    uint64_t middle2 = (a & 0xFFFFFFFF) * (b >> 32);
+    uint64_t carry = (low >> 32) + (middle1 & 0xFFFFFFFF) + (middle2 & 0xFFFFFFFF);
+    uint64_t product_low = (low & 0xFFFFFFFF) | (carry << 32);
+    uint64_t product_high = (a >> 32) * (b >> 32) + (middle1 >> 32) + (middle2 >> 32) + (carry >> 32);
+    return (product_high << (64 - shift)) | (product_low >> shift);
+}
+
+// sin() and cos() of `2*pi * k / 2^20`, for k in [0, 2^17] (an angle in [0, pi/4]), in Q2.62, from their Taylor
+// series. Each term is the one before times angle^2 / (n*(n + 1)), so they shrink fast: about 12 reach 0.
+static void sin_cos_octant(uint64_t k, uint64_t * sin, uint64_t * cos)
+{
+    uint64_t angle = mul_shift(PI_OVER_4_Q62, k, FIXED_FFT_MAX_LOG2_SIZE - 3);
+    uint64_t angle_squared = mul_shift(angle, angle, 62);
+
+    uint64_t term = angle;
+    *sin = angle;
+    for (uint64_t n = 2; term != 0; n += 2)
+    {
+        term = mul_shift(term, angle_squared, 62) / (n * (n + 1));
+        *sin = n % 4 == 2 ? *sin - term : *sin + term;
+    }
+    term = ONE_Q62;
+    *cos = ONE_Q62;
+    for (uint64_t n = 1; term != 0; n += 2)
+    {
+        term = mul_shift(term, angle_squared, 62) / (n * (n + 1));
+        *cos = n % 4 == 1 ? *cos - term : *cos + term;
+    }
+}
+
+// `e^(-2*pi*i * k / size)` for k in [0, size/2), in Q2.62.
+static void unit_root(size_t k, unsigned log2_size, int64_t * re, int64_t * im)
+{
+    // The angle in units of 2*pi / 2^20, in [0, pi). Angles over pi/2 use cos(pi/2 + x) = -sin(x) and
+    // sin(pi/2 + x) = cos(x); angles over pi/4 (after that), cos(pi/2 - x) = sin(x) and sin(pi/2 - x) = cos(x).
+    const uint64_t EIGHTH = (uint64_t)1 << (FIXED_FFT_MAX_LOG2_SIZE - 3);
+    const uint64_t QUARTER = (uint64_t)1 << (FIXED_FFT_MAX_LOG2_SIZE - 2);
+    uint64_t angle = (uint64_t)k << (FIXED_FFT_MAX_LOG2_SIZE - log2_size);
+    bool second_quadrant = angle > QUARTER;
+    uint64_t reduced = second_quadrant ? angle - QUARTER : angle;
+    uint64_t sin;
+    uint64_t cos;
+    if (reduced <= EIGHTH)
+    {
+        sin_cos_octant(reduced, &sin, &cos);
+    }
+    else
+    {
+        sin_cos_octant(QUARTER - reduced, &cos, &sin);
+    }
+    *re = second_quadrant ? -(int64_t)sin : (int64_t)cos;
+    *im = second_quadrant ? -(int64_t)cos : -(int64_t)sin;
+}
+
+// A Q2.62 number in [-1, 1] as a Q15 or Q31 one (`bits` 15 or 31), rounded half away from zero (so the table is
+// symmetric), and clamped to +-(2^bits - 1) (so negating a twiddle factor never overflows).
+static int32_t round_q62(int64_t x, unsigned bits)
+{
+    uint64_t magnitude = x < 0 ? (uint64_t)0 - (uint64_t)x : (uint64_t)x;
+    uint64_t rounded = (magnitude + ((uint64_t)1 << (61 - bits))) >> (62 - bits);
+    uint64_t max = ((uint64_t)1 << bits) - 1;
+    rounded = rounded > max ? max : rounded;
+    return x < 0 ? -(int32_t)rounded : (int32_t)rounded;
+}
+
+// -----------------------------------------------------------------------------------------------------------------
+// Passes shared by both widths
+// -----------------------------------------------------------------------------------------------------------------
+
+static uint32_t magnitude_mask(int32_t x)
+{
+    return (uint32_t)x ^ (x < 0 ? UINT32_MAX : 0);
+}
+
+// How far to scale down the next pass's outputs, from the OR of magnitude_mask() of its inputs: enough that an input
+// in [-2^bits, 2^bits) can't grow past the sample type, since a pass makes values at most 4 times bigger.
+static unsigned pass_shift(uint32_t mask, unsigned sample_bits)
+{
+    unsigned bits = mask == 0 ? 0 : 32 - (unsigned)__builtin_clz(mask);
+    return bits > sample_bits - 3 ? bits - (sample_bits - 3) : 0;
+}
+
+// `x / 2^shift` (shift 0 to 2), rounded half up. Biased to be non-negative first, since right-shifting a negative
+// number is implementation-defined in C.
+static int32_t scale_down(int32_t x, unsigned shift)
+{
+    if (shift == 0)
+    {
+        return x;
+    }
+    uint32_t biased = (uint32_t)x + SIGN_BIT + ((uint32_t)1 << (shift - 1));
+    return (int32_t)(biased >> shift) - (int32_t)(SIGN_BIT >> shift);
+}
+
+static int64_t scale_down_64(int64_t x, unsigned shift)
+{
+    if (shift == 0)
+    {
+        return x;
+    }
+    uint64_t biased = (uint64_t)x + SIGN_BIT_64 + ((uint64_t)1 << (shift - 1));
+    return (int64_t)(biased >> shift) - (int64_t)(SIGN_BIT_64 >> shift);
+}
+
+// The radix-4 pass's scale_down(), saturated: its outputs can reach 4 * (2^bits - 1) + 2 (ex: (x0 - x1) + (x2 - x3)
+// with x0 and x2 the biggest numbers, and x1 and x3 the smallest), which, for inputs at full scale, rounds to one over
+// the biggest sample.
+static int32_t first_pass_q15_output(int32_t x, unsigned shift)
+{
+    x = scale_down(x, shift);
+    return x > INT16_MAX ? INT16_MAX : x;
+}
+
+static int64_t first_pass_q31_output(int64_t x, unsigned shift)
+{
+    x = scale_down_64(x, shift);
+    return x > INT32_MAX ? INT32_MAX : x;
+}
+
+// Put `data` in bit-reversed order: swap each element with the one whose index has its bits reversed. `reversed`
+// counts up with the carry going the other way: adding 1 to i flips its bits up to its lowest 0 bit, so it flips
+// that many top bits of `reversed` (found with one count-trailing-zeros, not a loop). Element i is in place once
+// step i is done, so this also returns the OR of magnitude_mask() of every element, for the first pass's shift.
+#define BIT_REVERSE(NAME, COMPLEX) \
+    static uint32_t NAME(COMPLEX * data, size_t size) \
+    { \
+        uint32_t mask = 0; \
+        size_t reversed = 0; \
+        for (size_t i = 0; i < size; i++) \
+        { \
+            if (i < reversed) \
+            { \
+                COMPLEX swap = data[i]; \
+                data[i] = data[reversed]; \
+                data[reversed] = swap; \
+            } \
+            mask |= magnitude_mask(data[i].re) | magnitude_mask(data[i].im); \
+            reversed ^= size - (size >> ((unsigned)__builtin_ctzll((unsigned long long)i + 1) + 1)); \
+        } \
+        return mask; \
+    }
+
+// The first 2 stages as one radix-4 pass (or, for size 2, the only stage): their twiddle factors are 1, and -i
+// (forward) or i (inverse), so they're just additions, done in WIDE (so 4 full-scale values can't overflow), then
+// scaled down by `shift`. Returns the OR of magnitude_mask() of the outputs.
+#define FIRST_PASSES(NAME, COMPLEX, WIDE, SCALE_DOWN) \
+    static uint32_t NAME(COMPLEX * data, size_t size, bool inverse, unsigned shift) \
+    { \
+        uint32_t mask = 0; \
+        if (size == 2) \
+        { \
+            WIDE re0 = data[0].re, im0 = data[0].im, re1 = data[1].re, im1 = data[1].im; \
+            data[0].re = (int32_t)SCALE_DOWN(re0 + re1, shift); \
+            data[0].im = (int32_t)SCALE_DOWN(im0 + im1, shift); \
+            data[1].re = (int32_t)SCALE_DOWN(re0 - re1, shift); \
+            data[1].im = (int32_t)SCALE_DOWN(im0 - im1, shift); \
+            return magnitude_mask(data[0].re) | magnitude_mask(data[0].im) | magnitude_mask(data[1].re) \
+                   | magnitude_mask(data[1].im); \
+        } \
+        for (size_t i = 0; i < size; i += 4) \
+        { \
+            COMPLEX * x = data + i; \
+            WIDE re0 = (WIDE)x[0].re + x[1].re, im0 = (WIDE)x[0].im + x[1].im; \
+            WIDE re1 = (WIDE)x[0].re - x[1].re, im1 = (WIDE)x[0].im - x[1].im; \
+            WIDE re2 = (WIDE)x[2].re + x[3].re, im2 = (WIDE)x[2].im + x[3].im; \
+            /* x[2] - x[3], times -i (forward: (re, im) -> (im, -re)) or i (inverse: (re, im) -> (-im, re)) */ \
+            WIDE re3 = (WIDE)x[2].im - x[3].im, im3 = (WIDE)x[3].re - x[2].re; \
+            if (inverse) \
+            { \
+                re3 = -re3; \
+                im3 = -im3; \
+            } \
+            x[0].re = (int32_t)SCALE_DOWN(re0 + re2, shift); \
+            x[0].im = (int32_t)SCALE_DOWN(im0 + im2, shift); \
+            x[1].re = (int32_t)SCALE_DOWN(re1 + re3, shift); \
+            x[1].im = (int32_t)SCALE_DOWN(im1 + im3, shift); \
+            x[2].re = (int32_t)SCALE_DOWN(re0 - re2, shift); \
+            x[2].im = (int32_t)SCALE_DOWN(im0 - im2, shift); \
+            x[3].re = (int32_t)SCALE_DOWN(re1 - re3, shift); \
+            x[3].im = (int32_t)SCALE_DOWN(im1 - im3, shift); \
+            for (size_t k = 0; k < 4; k++) \
+            { \
+                mask |= magnitude_mask(x[k].re) | magnitude_mask(x[k].im); \
+            } \
+        } \
+        return mask; \
+    }
+
+BIT_REVERSE(bit_reverse_q15, fixed_complex_q15_t)
+BIT_REVERSE(bit_reverse_q31, fixed_complex_q31_t)
+FIRST_PASSES(first_passes_q15, fixed_complex_q15_t, int32_t, first_pass_q15_output)
+FIRST_PASSES(first_passes_q31, fixed_complex_q31_t, int64_t, first_pass_q31_output)
+
+#if defined(__SSE2__)
+
+// first_passes_q15() for sizes 4 and up: one radix-4 butterfly at a time, its 4 complex numbers as 8 32-bit lanes.
+// Bit-identical: `psrad` rounds like scale_down(), and `packssdw` saturates like first_pass_q15_output().
+static uint32_t radix4_pass_q15(fixed_complex_q15_t * data, size_t size, bool inverse, unsigned shift)
+{
+    const __m128i NEGATE_HIGH = _mm_set_epi32(-1, -1, 0, 0);
+    // x2 - x3 times -i (forward: (re, im) -> (im, -re)) or i (inverse: (-im, re)), once its halves are swapped.
+    const __m128i NEGATE_ROTATED = inverse ? _mm_set_epi32(0, -1, 0, 0) : _mm_set_epi32(-1, 0, 0, 0);
+    const __m128i HALF = _mm_set1_epi32(shift == 0 ? 0 : 1 << (shift - 1));
+    const __m128i SHIFT = _mm_cvtsi32_si128((int)shift);
+    __m128i mask8 = _mm_setzero_si128();
+    for (size_t i = 0; i < size; i += 4)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *)(data + i));
+        // Sign-extended: x0 and x1's (re, im, re, im), then x2 and x3's.
+        __m128i x01 = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+        __m128i x23 = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+        // (x0 + x1, x0 - x1) and (x2 + x3, x2 - x3)
+        __m128i second = _mm_shuffle_epi32(x01, _MM_SHUFFLE(3, 2, 3, 2));
+        __m128i sum_diff01 = _mm_add_epi32(_mm_shuffle_epi32(x01, _MM_SHUFFLE(1, 0, 1, 0)),
+                                           _mm_sub_epi32(_mm_xor_si128(second, NEGATE_HIGH), NEGATE_HIGH));
+        second = _mm_shuffle_epi32(x23, _MM_SHUFFLE(3, 2, 3, 2));
+        __m128i sum_diff23 = _mm_add_epi32(_mm_shuffle_epi32(x23, _MM_SHUFFLE(1, 0, 1, 0)),
+                                           _mm_sub_epi32(_mm_xor_si128(second, NEGATE_HIGH), NEGATE_HIGH));
+        sum_diff23 = _mm_shuffle_epi32(sum_diff23, _MM_SHUFFLE(2, 3, 1, 0));
+        sum_diff23 = _mm_sub_epi32(_mm_xor_si128(sum_diff23, NEGATE_ROTATED), NEGATE_ROTATED);
+        __m128i y01 = _mm_sra_epi32(_mm_add_epi32(_mm_add_epi32(sum_diff01, sum_diff23), HALF), SHIFT);
+        __m128i y23 = _mm_sra_epi32(_mm_add_epi32(_mm_sub_epi32(sum_diff01, sum_diff23), HALF), SHIFT);
+        __m128i y = _mm_packs_epi32(y01, y23);
+        _mm_storeu_si128((__m128i *)(data + i), y);
+        mask8 = _mm_or_si128(mask8, _mm_xor_si128(y, _mm_srai_epi16(y, 15)));
+    }
+    mask8 = _mm_or_si128(mask8, _mm_shuffle_epi32(mask8, _MM_SHUFFLE(1, 0, 3, 2)));
+    mask8 = _mm_or_si128(mask8, _mm_shuffle_epi32(mask8, _MM_SHUFFLE(2, 3, 0, 1)));
+    uint32_t mask = (uint32_t)_mm_cvtsi128_si32(mask8);
+    return (mask | mask >> 16) & 0xFFFF;
+}
+
+#endif
+
+// -----------------------------------------------------------------------------------------------------------------
+// Radix-2 passes: for each group of 2*span values, a = x[j] and b = x[j + span] (j < span) become a + b*w[j] and
+// a - b*w[j], scaled down by `shift`. Each returns the OR of magnitude_mask() of its outputs.
+// -----------------------------------------------------------------------------------------------------------------
+
+// Q15. `twiddles` is the stage's table: `span` pairs (w.re, -w.im), then `span` pairs (w.im, w.re), so
+// `pmaddwd` (b.re*w.re - b.im*w.im, b.re*w.im + b.im*w.re) gives b*w's real and imaginary parts, 32 bits each.
+static uint32_t radix2_pass_q15(fixed_complex_q15_t * data, size_t size, size_t span, const int16_t * twiddles,
+                                bool inverse, unsigned shift)
+{
+    const int16_t * w_re = twiddles;
+    const int16_t * w_im = twiddles + 2 * span;
+    uint32_t mask = 0;
+#if defined(__AVX2__)
+    // (Inverse: w.im's sign flips, so negate the 2nd of each (w.re, -w.im) pair, and the 1st of each (w.im, w.re).)
+    const __m256i NEGATE_RE = _mm256_set1_epi32(inverse ? (int32_t)0xFFFF0000 : 0);
+    const __m256i NEGATE_IM = _mm256_set1_epi32(inverse ? 0x0000FFFF : 0);
+    const __m256i ROUND = _mm256_set1_epi32(1 << 14);
+    const __m256i HALF = _mm256_set1_epi32(shift == 0 ? 0 : 1 << (shift - 1));
+    const __m128i SHIFT = _mm_cvtsi32_si128((int)shift);
+    const __m256i LOW_HALVES = _mm256_set1_epi32(0xFFFF);
+    __m256i mask8 = _mm256_setzero_si256();
+#endif
+#if defined(__SSE2__)
+    const __m128i NEGATE_RE4 = _mm_set1_epi32(inverse ? (int32_t)0xFFFF0000 : 0);
+    const __m128i NEGATE_IM4 = _mm_set1_epi32(inverse ? 0x0000FFFF : 0);
+    const __m128i ROUND4 = _mm_set1_epi32(1 << 14);
+    const __m128i HALF4 = _mm_set1_epi32(shift == 0 ? 0 : 1 << (shift - 1));
+    const __m128i SHIFT4 = _mm_cvtsi32_si128((int)shift);
+    const __m128i LOW_HALVES4 = _mm_set1_epi32(0xFFFF);
+    __m128i mask4 = _mm_setzero_si128();
+#endif
+    for (size_t group = 0; group < size; group += 2 * span)
+    {
+        fixed_complex_q15_t * a = data + group;
+        fixed_complex_q15_t * b = a + span;
+        size_t j = 0;
+#if defined(__AVX2__)
+        for (; j + 8 <= span; j += 8)
+        {
+            __m256i va = _mm256_loadu_si256((const __m256i *)(a + j));
+            __m256i vb = _mm256_loadu_si256((const __m256i *)(b + j));
+            __m256i wr = _mm256_loadu_si256((const __m256i *)(w_re + 2 * j));
+            __m256i wi = _mm256_loadu_si256((const __m256i *)(w_im + 2 * j));
+            wr = _mm256_sub_epi16(_mm256_xor_si256(wr, NEGATE_RE), NEGATE_RE);
+            wi = _mm256_sub_epi16(_mm256_xor_si256(wi, NEGATE_IM), NEGATE_IM);
+            __m256i t_re = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(vb, wr), ROUND), 15);
+            __m256i t_im = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(vb, wi), ROUND), 15);
+            __m256i a_re = _mm256_srai_epi32(_mm256_slli_epi32(va, 16), 16);
+            __m256i a_im = _mm256_srai_epi32(va, 16);
+            __m256i sum_re = _mm256_sra_epi32(_mm256_add_epi32(_mm256_add_epi32(a_re, t_re), HALF), SHIFT);
+            __m256i sum_im = _mm256_sra_epi32(_mm256_add_epi32(_mm256_add_epi32(a_im, t_im), HALF), SHIFT);
+            __m256i diff_re = _mm256_sra_epi32(_mm256_add_epi32(_mm256_sub_epi32(a_re, t_re), HALF), SHIFT);
+            __m256i diff_im = _mm256_sra_epi32(_mm256_add_epi32(_mm256_sub_epi32(a_im, t_im), HALF), SHIFT);
+            __m256i sum = _mm256_or_si256(_mm256_and_si256(sum_re, LOW_HALVES), _mm256_slli_epi32(sum_im, 16));
+            __m256i diff = _mm256_or_si256(_mm256_and_si256(diff_re, LOW_HALVES), _mm256_slli_epi32(diff_im, 16));
+            _mm256_storeu_si256((__m256i *)(a + j), sum);
+            _mm256_storeu_si256((__m256i *)(b + j), diff);
+            mask8 = _mm256_or_si256(mask8, _mm256_xor_si256(sum_re, _mm256_srai_epi32(sum_re, 31)));
+            mask8 = _mm256_or_si256(mask8, _mm256_xor_si256(sum_im, _mm256_srai_epi32(sum_im, 31)));
+            mask8 = _mm256_or_si256(mask8, _mm256_xor_si256(diff_re, _mm256_srai_epi32(diff_re, 31)));
+            mask8 = _mm256_or_si256(mask8, _mm256_xor_si256(diff_im, _mm256_srai_epi32(diff_im, 31)));
+        }
+#endif
+#if defined(__SSE2__)
+        // (With AVX2 too, for the 4-value groups of the first radix-2 stage.)
+        for (; j + 4 <= span; j += 4)
+        {
+            __m128i va = _mm_loadu_si128((const __m128i *)(a + j));
+            __m128i vb = _mm_loadu_si128((const __m128i *)(b + j));
+            __m128i wr = _mm_loadu_si128((const __m128i *)(w_re + 2 * j));
+            __m128i wi = _mm_loadu_si128((const __m128i *)(w_im + 2 * j));
+            wr = _mm_sub_epi16(_mm_xor_si128(wr, NEGATE_RE4), NEGATE_RE4);
+            wi = _mm_sub_epi16(_mm_xor_si128(wi, NEGATE_IM4), NEGATE_IM4);
+            __m128i t_re = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(vb, wr), ROUND4), 15);
+            __m128i t_im = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(vb, wi), ROUND4), 15);
+            __m128i a_re = _mm_srai_epi32(_mm_slli_epi32(va, 16), 16);
+            __m128i a_im = _mm_srai_epi32(va, 16);
+            __m128i sum_re = _mm_sra_epi32(_mm_add_epi32(_mm_add_epi32(a_re, t_re), HALF4), SHIFT4);
+            __m128i sum_im = _mm_sra_epi32(_mm_add_epi32(_mm_add_epi32(a_im, t_im), HALF4), SHIFT4);
+            __m128i diff_re = _mm_sra_epi32(_mm_add_epi32(_mm_sub_epi32(a_re, t_re), HALF4), SHIFT4);
+            __m128i diff_im = _mm_sra_epi32(_mm_add_epi32(_mm_sub_epi32(a_im, t_im), HALF4), SHIFT4);
+            __m128i sum = _mm_or_si128(_mm_and_si128(sum_re, LOW_HALVES4), _mm_slli_epi32(sum_im, 16));
+            __m128i diff = _mm_or_si128(_mm_and_si128(diff_re, LOW_HALVES4), _mm_slli_epi32(diff_im, 16));
+            _mm_storeu_si128((__m128i *)(a + j), sum);
+            _mm_storeu_si128((__m128i *)(b + j), diff);
+            mask4 = _mm_or_si128(mask4, _mm_xor_si128(sum_re, _mm_srai_epi32(sum_re, 31)));
+            mask4 = _mm_or_si128(mask4, _mm_xor_si128(sum_im, _mm_srai_epi32(sum_im, 31)));
+            mask4 = _mm_or_si128(mask4, _mm_xor_si128(diff_re, _mm_srai_epi32(diff_re, 31)));
+            mask4 = _mm_or_si128(mask4, _mm_xor_si128(diff_im, _mm_srai_epi32(diff_im, 31)));
+        }
+#endif
+        for (; j < span; j++)
+        {
+            int32_t wr = w_re[2 * j];
+            int32_t wi = inverse ? -w_im[2 * j] : w_im[2 * j];
+            // The rounding of fixed_q15_mul_round(), on a sum of 2 products (which fits: |w| < 1).
+            int32_t t_re = fixed_q15_floor_shift((int32_t)b[j].re * wr - (int32_t)b[j].im * wi + (1 << 14));
+            int32_t t_im = fixed_q15_floor_shift((int32_t)b[j].re * wi + (int32_t)b[j].im * wr + (1 << 14));
+            int32_t a_re = a[j].re;
+            int32_t a_im = a[j].im;
+            a[j].re = (fixed_q15_t)scale_down(a_re + t_re, shift);
+            a[j].im = (fixed_q15_t)scale_down(a_im + t_im, shift);
+            b[j].re = (fixed_q15_t)scale_down(a_re - t_re, shift);
+            b[j].im = (fixed_q15_t)scale_down(a_im - t_im, shift);
+            mask |= magnitude_mask(a[j].re) | magnitude_mask(a[j].im) | magnitude_mask(b[j].re)
+                    | magnitude_mask(b[j].im);
+        }
+    }
+#if defined(__AVX2__)
+    mask4 = _mm_or_si128(mask4, _mm_or_si128(_mm256_castsi256_si128(mask8), _mm256_extracti128_si256(mask8, 1)));
+#endif
+#if defined(__SSE2__)
+    mask4 = _mm_or_si128(mask4, _mm_shuffle_epi32(mask4, _MM_SHUFFLE(1, 0, 3, 2)));
+    mask4 = _mm_or_si128(mask4, _mm_shuffle_epi32(mask4, _MM_SHUFFLE(2, 3, 0, 1)));
+    mask |= (uint32_t)_mm_cvtsi128_si32(mask4);
+#endif
+    return mask;
+}
+
+#if defined(__AVX2__)
+
+// `floor((x + 2^(shift - 1)) / 2^shift)` for 4 int64_t, with shift 0 to 31: AVX2 has no 64-bit arithmetic shift, so
+// biased to be non-negative, then shifted logically, like scale_down_64(). SIGN is 2^63 (or 0 if shift is 0), and
+// OFFSET 2^(63 - shift) (or 0).
+static __m256i round_shift_epi64(__m256i x, __m256i sign, __m256i half, __m128i shift, __m256i offset)
+{
+    return _mm256_sub_epi64(_mm256_srl_epi64(_mm256_add_epi64(_mm256_xor_si256(x, sign), half), shift), offset);
+}
+
+#endif
+
+// Q31. `twiddles` is the stage's table: `span` pairs (w.re, w.im).
+static uint32_t radix2_pass_q31(fixed_complex_q31_t * data, size_t size, size_t span, const int32_t * twiddles,
+                                bool inverse, unsigned shift)
+{
+    uint32_t mask = 0;
+#if defined(__AVX2__)
+    const __m256i NEGATE_IM = _mm256_set1_epi64x(inverse ? -((int64_t)1 << 32) : 0);
+    const __m256i ONE = _mm256_set1_epi64x(1);
+    const __m256i SIGN = _mm256_set1_epi64x(INT64_MIN);
+    const __m256i ROUND = _mm256_set1_epi64x((int64_t)1 << 30);
+    const __m128i ROUND_SHIFT = _mm_cvtsi32_si128(31);
+    const __m256i ROUND_OFFSET = _mm256_set1_epi64x((int64_t)1 << 32);
+    const __m256i SCALE_SIGN = _mm256_set1_epi64x(shift == 0 ? 0 : INT64_MIN);
+    const __m256i SCALE_HALF = _mm256_set1_epi64x(shift == 0 ? 0 : (int64_t)1 << (shift - 1));
+    const __m128i SCALE_SHIFT = _mm_cvtsi32_si128((int)shift);
+    const __m256i SCALE_OFFSET = _mm256_set1_epi64x(shift == 0 ? 0 : (int64_t)1 << (63 - shift));
+    __m256i mask8 = _mm256_setzero_si256();
+#endif
+    for (size_t group = 0; group < size; group += 2 * span)
+    {
+        fixed_complex_q31_t * a = data + group;
+        fixed_complex_q31_t * b = a + span;
+        size_t j = 0;
+#if defined(__AVX2__)
+        for (; j + 4 <= span; j += 4)
+        {
+            // `vpmuldq` multiplies the low halves of 64-bit lanes: each complex number's real part. Shifting a lane
+            // right by 32 brings down its imaginary part.
+            __m256i va = _mm256_loadu_si256((const __m256i *)(a + j));
+            __m256i vb = _mm256_loadu_si256((const __m256i *)(b + j));
+            __m256i w = _mm256_loadu_si256((const __m256i *)(twiddles + 2 * j));
+            w = _mm256_sub_epi32(_mm256_xor_si256(w, NEGATE_IM), NEGATE_IM);
+            __m256i b_im = _mm256_srli_epi64(vb, 32);
+            __m256i w_im = _mm256_srli_epi64(w, 32);
+            __m256i t_re = _mm256_sub_epi64(_mm256_mul_epi32(vb, w), _mm256_mul_epi32(b_im, w_im));
+            __m256i t_im = _mm256_add_epi64(_mm256_mul_epi32(vb, w_im), _mm256_mul_epi32(b_im, w));
+            t_re = round_shift_epi64(t_re, SIGN, ROUND, ROUND_SHIFT, ROUND_OFFSET);
+            t_im = round_shift_epi64(t_im, SIGN, ROUND, ROUND_SHIFT, ROUND_OFFSET);
+            // (Sign-extended to 64 bits by multiplying by 1.)
+            __m256i a_re = _mm256_mul_epi32(va, ONE);
+            __m256i a_im = _mm256_mul_epi32(_mm256_srli_epi64(va, 32), ONE);
+            __m256i sum_re = round_shift_epi64(_mm256_add_epi64(a_re, t_re), SCALE_SIGN, SCALE_HALF, SCALE_SHIFT,
+                                               SCALE_OFFSET);
+            __m256i sum_im = round_shift_epi64(_mm256_add_epi64(a_im, t_im), SCALE_SIGN, SCALE_HALF, SCALE_SHIFT,
+                                               SCALE_OFFSET);
+            __m256i diff_re = round_shift_epi64(_mm256_sub_epi64(a_re, t_re), SCALE_SIGN, SCALE_HALF, SCALE_SHIFT,
+                                                SCALE_OFFSET);
+            __m256i diff_im = round_shift_epi64(_mm256_sub_epi64(a_im, t_im), SCALE_SIGN, SCALE_HALF, SCALE_SHIFT,
+                                                SCALE_OFFSET);
+            // They fit 32 bits now: the real parts' low halves, with the imaginary parts' in the high halves.
+            __m256i sum = _mm256_blend_epi32(sum_re, _mm256_slli_epi64(sum_im, 32), 0xAA);
+            __m256i diff = _mm256_blend_epi32(diff_re, _mm256_slli_epi64(diff_im, 32), 0xAA);
+            _mm256_storeu_si256((__m256i *)(a + j), sum);
+            _mm256_storeu_si256((__m256i *)(b + j), diff);
+            mask8 = _mm256_or_si256(mask8, _mm256_xor_si256(sum, _mm256_srai_epi32(sum, 31)));
+            mask8 = _mm256_or_si256(mask8, _mm256_xor_si256(diff, _mm256_srai_epi32(diff, 31)));
+        }
+#endif
+        for (; j < span; j++)
+        {
+            int64_t wr = twiddles[2 * j];
+            int64_t wi = inverse ? -(int64_t)twiddles[2 * j + 1] : twiddles[2 * j + 1];
+            // The rounding of fixed_q31_mul_round(), on a sum of 2 products (which fits: |w| < 1).
+            int64_t t_re = fixed_q31_floor_shift(b[j].re * wr - b[j].im * wi + ((int64_t)1 << 30));
+            int64_t t_im = fixed_q31_floor_shift(b[j].re * wi + b[j].im * wr + ((int64_t)1 << 30));
+            int64_t a_re = a[j].re;
+            int64_t a_im = a[j].im;
+            a[j].re = (fixed_q31_t)scale_down_64(a_re + t_re, shift);
+            a[j].im = (fixed_q31_t)scale_down_64(a_im + t_im, shift);
+            b[j].re = (fixed_q31_t)scale_down_64(a_re - t_re, shift);
+            b[j].im = (fixed_q31_t)scale_down_64(a_im - t_im, shift);
+            mask |= magnitude_mask(a[j].re) | magnitude_mask(a[j].im) | magnitude_mask(b[j].re)
+                    | magnitude_mask(b[j].im);
+        }
+    }
+#if defined(__AVX2__)
+    __m128i mask4 = _mm_or_si128(_mm256_castsi256_si128(mask8), _mm256_extracti128_si256(mask8, 1));
+    mask4 = _mm_or_si128(mask4, _mm_shuffle_epi32(mask4, _MM_SHUFFLE(1, 0, 3, 2)));
+    mask4 = _mm_or_si128(mask4, _mm_shuffle_epi32(mask4, _MM_SHUFFLE(2, 3, 0, 1)));
+    mask |= (uint32_t)_mm_cvtsi128_si32(mask4);
+#endif
+    return mask;
+}
+
+// -----------------------------------------------------------------------------------------------------------------
+// Public functions
+// -----------------------------------------------------------------------------------------------------------------
+
+/// @brief      Make a plan for transforms of `size` complex numbers: compute its twiddle tables.
+/// @param[in]  size            A power of 2, from 1 to 2^FIXED_FFT_MAX_LOG2_SIZE.
+/// @param[in]  sample_bits     16 for fixed_fft_q15(), or 32 for fixed_fft_q31().
+/// @param[in]  arena           Where to get the tables from, or NULL to use the heap. Arena-backed plans must not
+///                             outlive the next fixed_arena_reset() of their arena.
+/// @return     false if an argument is out of range, or the tables could not be allocated.
+bool fixed_fft_init(fixed_fft_t * fft, size_t size, unsigned sample_bits, fixed_arena_t * arena)
+{
+    memset(fft, 0, sizeof(*fft));
+    if (size == 0 || (size & (size - 1)) != 0 || size > ((size_t)1 << FIXED_FFT_MAX_LOG2_SIZE)
+        || (sample_bits != 16 && sample_bits != 32))
+    {
+        return false;
+    }
+    fft->size = size;
+    fft->log2_size = (uint8_t)__builtin_ctzll(size);
+    fft->sample_bits = (uint8_t)sample_bits;
+    fft->arena = arena;
+    if (size < 8)
+    {
+        // The radix-4 pass is every stage there is.
+        return true;
+    }
+
+    // A table for each radix-2 stage: spans 4, 8, ..., size/2, so size - 4 twiddle factors in all, 8 bytes each.
+    size_t num_bytes = (size - 4) * 8;
+    void * memory = fixed_arena_alloc_or_heap(arena, num_bytes, FIXED_ARENA_ALIGNMENT);
+    if (memory == NULL)
+    {
+        memset(fft, 0, sizeof(*fft));
+        return false;
+    }
+    fft->twiddles16 = sample_bits == 16 ? (int16_t *)memory : NULL;
+    fft->twiddles32 = sample_bits == 32 ? (int32_t *)memory : NULL;
+
+    for (size_t span = 4; span < size; span *= 2)
+    {
+        // The stage's twiddle factors: e^(-2*pi*i * j / (2*span)), for j < span.
+        int16_t * stage16 = fft->twiddles16 != NULL ? fft->twiddles16 + 4 * (span - 4) : NULL;
+        int32_t * stage32 = fft->twiddles32 != NULL ? fft->twiddles32 + 2 * (span - 4) : NULL;
+        for (size_t j = 0; j < span; j++)
+        {
+            int64_t re;
+            int64_t im;
+            unit_root(j * (size / (2 * span)), fft->log2_size, &re, &im);
+            if (stage16 != NULL)
+            {
+                int16_t w_re = (int16_t)round_q62(re, 15);
+                int16_t w_im = (int16_t)round_q62(im, 15);
+                stage16[2 * j] = w_re;
+                stage16[2 * j + 1] = (int16_t)-w_im;
+                stage16[2 * span + 2 * j] = w_im;
+                stage16[2 * span + 2 * j + 1] = w_re;
+            }
+            else
+            {
+                stage32[2 * j] = round_q62(re, 31);
+                stage32[2 * j + 1] = round_q62(im, 31);
+            }
+        }
+    }
+    return true;
+}
+
+/// @brief      Free a heap-backed plan's tables. Arena-backed tables are given back by resetting the arena.
+void fixed_fft_free(fixed_fft_t * fft)
+{
+    fixed_arena_free_or_heap(fft->arena, fft->twiddles16 != NULL ? (void *)fft->twiddles16 : (void *)fft->twiddles32);
+    memset(fft, 0, sizeof(*fft));
+}
+
+/// @brief      Transform complex Q15 data in place. See fixed_point_fft.h.
+/// @param[out] shift   How many times the outputs were halved to make them fit: the result is `data * 2^shift`.
+bool fixed_fft_q15(const fixed_fft_t * fft, fixed_complex_q15_t * data, bool inverse, unsigned * shift)
+{
+    if (fft->sample_bits != 16)
+    {
+        return false;
+    }
+    *shift = 0;
+    if (fft->size == 1)
+    {
+        return true;
+    }
+    uint32_t mask = bit_reverse_q15(data, fft->size);
+    unsigned stage_shift = pass_shift(mask, 16);
+#if defined(__SSE2__)
+    mask = fft->size == 2 ? first_passes_q15(data, fft->size, inverse, stage_shift)
+                          : radix4_pass_q15(data, fft->size, inverse, stage_shift);
+#else
+    mask = first_passes_q15(data, fft->size, inverse, stage_shift);
+#endif
+    *shift += stage_shift;
+    for (size_t span = 4; span < fft->size; span *= 2)
+    {
+        stage_shift = pass_shift(mask, 16);
+        mask = radix2_pass_q15(data, fft->size, span, fft->twiddles16 + 4 * (span - 4), inverse, stage_shift);
+        *shift += stage_shift;
+    }
+    return true;
+}
+
+/// @brief      Transform complex Q31 data in place. See fixed_point_fft.h.
+/// @param[out] shift   How many times the outputs were halved to make them fit: the result is `data * 2^shift`.
+bool fixed_fft_q31(const fixed_fft_t * fft, fixed_complex_q31_t * data, bool inverse, unsigned * shift)
+{
+    if (fft->sample_bits != 32)
+    {
+        return false;
+    }
+    *shift = 0;
+    if (fft->size == 1)
+    {
+        return true;
+    }
+    uint32_t mask = bit_reverse_q31(data, fft->size);
+    unsigned stage_shift = pass_shift(mask, 32);
+    mask = first_passes_q31(data, fft->size, inverse, stage_shift);
+    *shift += stage_shift;
+    for (size_t span = 4; span < fft->size; span *= 2)
+    {
+        stage_shift = pass_shift(mask, 32);
+        mask = radix2_pass_q31(data, fft->size, span, fft->twiddles32 + 2 * (span - 4), inverse, stage_shift);
+        *shift += stage_shift;
+    }
+    return true;
+}
@@ -0,0 +1,72 @@
+/*
+fixed_point_fft
+- In-place FFTs of complex Q15 (`fixed_q15_t`, see fixed_point_mul.h) and Q31 (`fixed_q31_t`) data, with power-of-2
+  sizes from 1 to 2^20, and no floating point anywhere: not in the transform, and not in the twiddle factors either,
+  which fixed_fft_init() computes with 64-bit integer Taylor series.
+- Decimation in time: the data is put in bit-reversed order, then one radix-4 pass does the first 2 stages (whose
+  twiddle factors are 1 and -i, so they need no multiplies), then one radix-2 pass per remaining stage.
+- Twiddle tables are laid out stage by stage, in the order the butterflies read them, so every pass reads its table
+  front to back. The Q15 table holds each twiddle factor as the 2 pairs `pmaddwd` multiplies a complex number by.
+- Overflow: a radix-2 stage can make a value's real or imaginary part up to 1 + sqrt(2) times bigger (the radix-4
+  pass, 4 times), so a stage that started near full scale would wrap around. Before each pass, the biggest magnitude
+  (found by OR-ing every output of the previous pass, like the leading-zero scan in fixed_point_bfp.h) picks how
+  much to scale that pass's outputs down: by 1/2 or 1/4 only if it has to. Small inputs keep every bit, and big ones
+  can't overflow. The transform returns the total shift, so the true result is `data * 2^shift`: a block floating
+  point exponent for the whole array.
+- Twiddle products are rounded half up, like fixed_q15_mul_round() and fixed_q31_mul_round(), and so are the
+  scaled outputs.
+- Butterflies use AVX2 (Q15: 8 complex numbers at a time with `vpmaddwd`; Q31: 4 at a time with `vpmuldq`), or SSE2
+  for Q15, else plain C. All give bit-identical results.
+*/
+
+#ifndef FIXED_POINT_FFT_H
+#define FIXED_POINT_FFT_H
+
+#include <stddef.h>
+
+#include "fixed_point_arena.h"
+#include "fixed_point_mul.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FIXED_FFT_MAX_LOG2_SIZE 20
+
+typedef struct fixed_complex_q15_s
+{
+    fixed_q15_t re;
+    fixed_q15_t im;
+} fixed_complex_q15_t;
+
+typedef struct fixed_complex_q31_s
+{
+    fixed_q31_t re;
+    fixed_q31_t im;
+} fixed_complex_q31_t;
+
+// A plan: one size and sample width's twiddle tables. Read-only after fixed_fft_init(), so threads can share one.
+typedef struct fixed_fft_s
+{
+    size_t size;
+    uint8_t log2_size;
+    uint8_t sample_bits;   // 16 (for fixed_fft_q15()) or 32 (for fixed_fft_q31())
+    int16_t * twiddles16;  // if `sample_bits` is 16 (else NULL)
+    int32_t * twiddles32;  // if `sample_bits` is 32 (else NULL)
+    fixed_arena_t * arena; // where the tables came from; NULL if from the heap
+} fixed_fft_t;
+
+bool fixed_fft_init(fixed_fft_t * fft, size_t size, unsigned sample_bits, fixed_arena_t * arena);
+void fixed_fft_free(fixed_fft_t * fft);
+
+// Transform `fft->size` complex numbers in place. Forward: X[k] = sum of x[n] * e^(-2*pi*i*k*n/size). Inverse: the
+// same with e^(+2*pi*i*k*n/size), and no 1/size (so a round trip gives x * size). Either way, `data * 2^*shift` is
+// the result. Return false (without changing `data`) if the plan is for the other sample width.
+bool fixed_fft_q15(const fixed_fft_t * fft, fixed_complex_q15_t * data, bool inverse, unsigned * shift);
+bool fixed_fft_q31(const fixed_fft_t * fft, fixed_complex_q31_t * data, bool inverse, unsigned * shift);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIXED_POINT_FFT_H
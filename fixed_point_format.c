@@ -0,0 +1,368 @@
+/*
+fixed_point_format
+- See fixed_point_format.h.
+*/
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "fixed_point_format.h"
+
+// Array of power base 10 values, where the value = 10^index.
+static const uint32_t POW_BASE_10[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+
+#if defined(__cplusplus) && __cplusplus >= 201402L
+// The C++ build checks that parsing and formatting really do work at compile time.
+static_assert(fixed_literal("219.857") == FIXED_FROM_DECIMAL(219, 857, 3), "fixed_parse() isn't constexpr");
+static_assert(fixed_literal("65535.99999") == UINT32_MAX, "fixed_parse() isn't constexpr");
+static_assert(fixed_format_string(FIXED_FROM_DECIMAL(1, 9999, 4), 2).length == 4, "fixed_format() isn't constexpr");
+static_assert(fixed_format_string(FIXED_FROM_DECIMAL(1, 9999, 4), 2).chars[3] == '0', "fixed_format() isn't constexpr");
+#endif
+
+// -----------------------------------------------------------------------------------------------------------------
+// Batch formatting
+// -----------------------------------------------------------------------------------------------------------------
+
+// The batch functions work on this many numbers at a time: one per 16-bit SIMD lane.
+#define BATCH_LANES 8
+
+// Print BATCH_LANES numbers in fixed-width form, with the whole number part *zero*-padded to
+// FIXED_FORMAT_WHOLE_DIGITS digits, one number at a time. Number `lane` goes to `out + lane*stride`.
+static void format_lanes_scalar(const fixed_point_t * values, uint8_t num_digits_after_decimal, char * out,
+                                size_t stride)
+{
+    for (size_t lane = 0; lane < BATCH_LANES; lane++)
+    {
+        char * text = out + lane*stride;
+        uint32_t whole = values[lane] >> FRACTION_BITS;
+        uint32_t fraction = (uint32_t)(((uint64_t)(values[lane] & FRACTION_MASK) * 
+                                        POW_BASE_10[num_digits_after_decimal] + FRACTION_DIVISOR/2) >> FRACTION_BITS);
+        if (fraction == POW_BASE_10[num_digits_after_decimal])
+        {
+            whole++;
+            fraction = 0;
+        }
+        for (size_t i = FIXED_FORMAT_WHOLE_DIGITS; i > 0; i--)
+        {
+            text[i - 1] = (char)('0' + whole % 10);
+            whole /= 10;
+        }
+        if (num_digits_after_decimal > 0)
+        {
+            text[FIXED_FORMAT_WHOLE_DIGITS] = '.';
+            for (size_t i = FIXED_FORMAT_WIDTH(num_digits_after_decimal); i > FIXED_FORMAT_WHOLE_DIGITS + 1; i--)
+            {
+                text[i - 1] = (char)('0' + fraction % 10);
+                fraction /= 10;
+            }
+        }
+    }
+}
+
+#if defined(__SSE2__)
+
+// How the SSE2 version works:
+// 1. Split each number into its whole number part and its fractional part rounded to N decimal digits (carrying
+//    into the whole number part when ex: .9999 rounds up to 1.00).
+// 2. Cut the rounded fraction into 4-digit chunks, each of which fits in 16 bits, so that 8 numbers' digits can be
+//    generated at once, one digit position at a time, in 16-bit lanes. x/10 is done as a multiply-high by 0xCCCD
+//    and a right-shift by 3, which is exact for every 16-bit x.
+// 3. Transpose from "one vector per character position, holding that char of all 8 numbers" to "one vector per
+//    number, holding its 16 chars", and store each number's text with a single 16-byte store.
+
+// 32x32 = 64-bit multiply of all 4 lanes, plus `addend`, then `>> shift`, keeping the low 32 bits of each lane.
+// SSE2's _mm_mul_epu32() only multiplies the even lanes, so do the odd lanes separately and then interleave.
+static __m128i mul_add_shift_epu32(__m128i a, __m128i b, __m128i addend, int shift)
+{
+    const __m128i LOW32 = _mm_set_epi32(0, -1, 0, -1);
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    even = _mm_srli_epi64(_mm_add_epi64(even, addend), shift);
+    odd = _mm_srli_epi64(_mm_add_epi64(odd, addend), shift);
+    return _mm_or_si128(_mm_and_si128(even, LOW32), _mm_slli_epi64(odd, 32));
+}
+
+// Pack two vectors of 4 32-bit values, each < 65536, into one vector of 8 16-bit values. SSE2 can only pack with
+// *signed* saturation, so shift everything down into the signed range first, then back up.
+static __m128i pack_epu32_to_epu16(__m128i lo, __m128i hi)
+{
+    const __m128i BIAS32 = _mm_set1_epi32(0x8000);
+    const __m128i BIAS16 = _mm_set1_epi16((short)0x8000);
+    return _mm_xor_si128(_mm_packs_epi32(_mm_sub_epi32(lo, BIAS32), _mm_sub_epi32(hi, BIAS32)), BIAS16);
+}
+
+// x/10000 for every 32-bit x: multiply by 0xD1B71759 (= 2^45/10000, rounded up), then right-shift by 45.
+static __m128i div_10000_epu32(__m128i x)
+{
+    return mul_add_shift_epu32(x, _mm_set1_epi32((int)0xD1B71759), _mm_setzero_si128(), 45);
+}
+
+// Generate `num_digits` digits of each 16-bit lane of `x`, least-significant first, into `digits[end - 1]`,
+// `digits[end - 2]`, etc.
+static void generate_digits(__m128i x, size_t num_digits, __m128i * digits, size_t end)
+{
+    const __m128i DIV_10 = _mm_set1_epi16((short)0xCCCD);
+    const __m128i TEN = _mm_set1_epi16(10);
+    for (size_t i = 1; i <= num_digits; i++)
+    {
+        __m128i quotient = _mm_srli_epi16(_mm_mulhi_epu16(x, DIV_10), 3);
+        digits[end - i] = _mm_sub_epi16(x, _mm_mullo_epi16(quotient, TEN));
+        x = quotient;
+    }
+}
+
+// Print BATCH_LANES numbers in fixed-width form, with the whole number part *zero*-padded to
+// FIXED_FORMAT_WHOLE_DIGITS digits. Number `lane` goes to `out + lane*stride`. Each number is written as a full
+// FIXED_FORMAT_MAX_LEN chars (the extra chars after it are garbage), so lanes are written in order, each one
+// overwriting the previous one's garbage, and `out` needs `FIXED_FORMAT_MAX_LEN - stride` chars of slack at the end.
+static void format_lanes(const fixed_point_t * values, uint8_t num_digits_after_decimal, char * out, size_t stride)
+{
+    const __m128i FRACTION_MASK_32 = _mm_set1_epi32(FRACTION_MASK);
+    const __m128i MAX_WHOLE_16 = _mm_set1_epi16(-1);
+    const __m128i POW_10_4 = _mm_set1_epi32(10000);
+    const uint32_t POW_10 = POW_BASE_10[num_digits_after_decimal];
+    __m128i digits[FIXED_FORMAT_MAX_LEN];
+    __m128i chunks[3];
+    __m128i whole;
+    __m128i carry;
+
+    __m128i v_lo = _mm_loadu_si128((const __m128i *)values);
+    __m128i v_hi = _mm_loadu_si128((const __m128i *)(values + 4));
+    whole = pack_epu32_to_epu16(_mm_srli_epi32(v_lo, FRACTION_BITS), _mm_srli_epi32(v_hi, FRACTION_BITS));
+
+    if (num_digits_after_decimal <= 4)
+    {
+        // 10^N fits in 16 bits, so the rounding can be done in 16-bit lanes too: the multiply-high is the truncated
+        // (fraction*10^N) >> 16, and the top bit of the multiply-low is the 1/2 that decides the rounding.
+        const __m128i POW_10_16 = _mm_set1_epi16((short)POW_10);
+        __m128i fraction = pack_epu32_to_epu16(_mm_and_si128(v_lo, FRACTION_MASK_32),
+                                               _mm_and_si128(v_hi, FRACTION_MASK_32));
+        chunks[0] = _mm_add_epi16(_mm_mulhi_epu16(fraction, POW_10_16),
+                                  _mm_srli_epi16(_mm_mullo_epi16(fraction, POW_10_16), 15));
+        carry = _mm_cmpeq_epi16(chunks[0], POW_10_16);
+        chunks[0] = _mm_andnot_si128(carry, chunks[0]);
+    }
+    else
+    {
+        // 10^N needs all 32 bits, so round in 32-bit lanes, then cut into 4-digit chunks of up to 9999 each.
+        const __m128i POW_10_32 = _mm_set1_epi32((int)POW_10);
+        const __m128i HALF = _mm_set1_epi64x(FRACTION_DIVISOR/2);
+        const __m128i ZERO = _mm_setzero_si128();
+        __m128i fraction_lo = mul_add_shift_epu32(_mm_and_si128(v_lo, FRACTION_MASK_32), POW_10_32, HALF,
+                                                  FRACTION_BITS);
+        __m128i fraction_hi = mul_add_shift_epu32(_mm_and_si128(v_hi, FRACTION_MASK_32), POW_10_32, HALF,
+                                                  FRACTION_BITS);
+        __m128i carry_lo = _mm_cmpeq_epi32(fraction_lo, POW_10_32);
+        __m128i carry_hi = _mm_cmpeq_epi32(fraction_hi, POW_10_32);
+        fraction_lo = _mm_andnot_si128(carry_lo, fraction_lo);
+        fraction_hi = _mm_andnot_si128(carry_hi, fraction_hi);
+        carry = _mm_packs_epi32(carry_lo, carry_hi);
+
+        for (size_t chunk = 0; chunk < 3; chunk++)
+        {
+            __m128i quotient_lo = div_10000_epu32(fraction_lo);
+            __m128i quotient_hi = div_10000_epu32(fraction_hi);
+            __m128i times_10000_lo = mul_add_shift_epu32(quotient_lo, POW_10_4, ZERO, 0);
+            __m128i times_10000_hi = mul_add_shift_epu32(quotient_hi, POW_10_4, ZERO, 0);
+            chunks[chunk] = pack_epu32_to_epu16(_mm_sub_epi32(fraction_lo, times_10000_lo),
+                                                _mm_sub_epi32(fraction_hi, times_10000_hi));
+            fraction_lo = quotient_lo;
+            fraction_hi = quotient_hi;
+        }
+    }
+
+    // 65535.99999 rounds up to 65536, which doesn't fit in a 16-bit lane. That is rare enough to just do the whole
+    // batch the slow way.
+    if (_mm_movemask_epi8(_mm_and_si128(carry, _mm_cmpeq_epi16(whole, MAX_WHOLE_16))) != 0)
+    {
+        format_lanes_scalar(values, num_digits_after_decimal, out, stride);
+        return;
+    }
+    whole = _mm_sub_epi16(whole, carry); // carry lanes are all 1s, ie: -1
+
+    // One digit vector per character position; positions we don't print stay 0 and are never copied out.
+    for (size_t pos = 0; pos < FIXED_FORMAT_MAX_LEN; pos++)
+    {
+        digits[pos] = _mm_setzero_si128();
+    }
+    generate_digits(whole, FIXED_FORMAT_WHOLE_DIGITS, digits, FIXED_FORMAT_WHOLE_DIGITS);
+    size_t end = FIXED_FORMAT_WIDTH(num_digits_after_decimal);
+    for (size_t chunk = 0; end > FIXED_FORMAT_WHOLE_DIGITS + 1; chunk++)
+    {
+        size_t num_digits = end - (FIXED_FORMAT_WHOLE_DIGITS + 1) < 4 ? end - (FIXED_FORMAT_WHOLE_DIGITS + 1) : 4;
+        generate_digits(chunks[chunk], num_digits, digits, end);
+        end -= num_digits;
+    }
+
+    // Transpose. First narrow pairs of positions to bytes and interleave them, so each 16-bit lane holds one
+    // number's 2 chars for those 2 positions...
+    __m128i pairs[FIXED_FORMAT_MAX_LEN/2];
+    for (size_t k = 0; k < FIXED_FORMAT_MAX_LEN/2; k++)
+    {
+        __m128i bytes = _mm_packus_epi16(digits[2*k], digits[2*k + 1]);
+        pairs[k] = _mm_unpacklo_epi8(bytes, _mm_srli_si128(bytes, 8));
+    }
+    // ...then do a regular 8x8 transpose of those 16-bit lanes.
+    __m128i a0 = _mm_unpacklo_epi16(pairs[0], pairs[1]);
+    __m128i a1 = _mm_unpackhi_epi16(pairs[0], pairs[1]);
+    __m128i a2 = _mm_unpacklo_epi16(pairs[2], pairs[3]);
+    __m128i a3 = _mm_unpackhi_epi16(pairs[2], pairs[3]);
+    __m128i a4 = _mm_unpacklo_epi16(pairs[4], pairs[5]);
+    __m128i a5 = _mm_unpackhi_epi16(pairs[4], pairs[5]);
+    __m128i a6 = _mm_unpacklo_epi16(pairs[6], pairs[7]);
+    __m128i a7 = _mm_unpackhi_epi16(pairs[6], pairs[7]);
+    __m128i b0 = _mm_unpacklo_epi32(a0, a2);
+    __m128i b1 = _mm_unpackhi_epi32(a0, a2);
+    __m128i b2 = _mm_unpacklo_epi32(a1, a3);
+    __m128i b3 = _mm_unpackhi_epi32(a1, a3);
+    __m128i b4 = _mm_unpacklo_epi32(a4, a6);
+    __m128i b5 = _mm_unpackhi_epi32(a4, a6);
+    __m128i b6 = _mm_unpacklo_epi32(a5, a7);
+    __m128i b7 = _mm_unpackhi_epi32(a5, a7);
+    __m128i text[BATCH_LANES];
+    text[0] = _mm_unpacklo_epi64(b0, b4);
+    text[1] = _mm_unpackhi_epi64(b0, b4);
+    text[2] = _mm_unpacklo_epi64(b1, b5);
+    text[3] = _mm_unpackhi_epi64(b1, b5);
+    text[4] = _mm_unpacklo_epi64(b2, b6);
+    text[5] = _mm_unpackhi_epi64(b2, b6);
+    text[6] = _mm_unpacklo_epi64(b3, b7);
+    text[7] = _mm_unpackhi_epi64(b3, b7);
+
+    // Digits --> ASCII. The decimal point's position holds a 0 "digit", so it gets '.' instead of '0' added to it.
+    const __m128i ASCII = _mm_setr_epi8('0', '0', '0', '0', '0', '.', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0');
+    for (size_t lane = 0; lane < BATCH_LANES; lane++)
+    {
+        _mm_storeu_si128((__m128i *)(out + lane*stride), _mm_add_epi8(text[lane], ASCII));
+    }
+}
+
+#else // __SSE2__
+
+// Without SIMD, just do one number at a time. This writes no garbage after each number.
+static void format_lanes(const fixed_point_t * values, uint8_t num_digits_after_decimal, char * out, size_t stride)
+{
+    format_lanes_scalar(values, num_digits_after_decimal, out, stride);
+}
+
+#endif // __SSE2__
+
+// Count the leading zeros of a zero-padded whole number part that can be dropped, always keeping at least 1 digit.
+static size_t count_leading_zeros(const char * text)
+{
+    size_t num_zeros = 0;
+    while (num_zeros < FIXED_FORMAT_WHOLE_DIGITS - 1 && text[num_zeros] == '0')
+    {
+        num_zeros++;
+    }
+    return num_zeros;
+}
+
+/// @brief      Print `n` numbers as "floats" (see fixed_format()), back-to-back, into one contiguous buffer, with
+///             no padding and no separators between them: ex: "219.8571.50065535.000".
+/// @param[in]  values                      The numbers to print.
+/// @param[in]  n                           How many numbers there are.
+/// @param[in]  num_digits_after_decimal    0 to 9; larger values are clamped to 9.
+/// @param[out] out                         At least `n*(FIXED_FORMAT_MAX_LEN - 1)` chars. NOT null-terminated.
+/// @param[out] offsets                     Optional (may be NULL). If given, must hold `n + 1` entries: number `i`
+///                                         is printed at `out[offsets[i]]` through `out[offsets[i + 1] - 1]`.
+/// @return     The total number of chars written.
+size_t fixed_format_batch(const fixed_point_t * values, size_t n, uint8_t num_digits_after_decimal, char * out,
+                          size_t * offsets)
+{
+    // + FIXED_FORMAT_MAX_LEN so the last lane's 16-byte copy below can read past its own text.
+    char lanes_text[(BATCH_LANES + 1)*FIXED_FORMAT_MAX_LEN];
+    fixed_point_t leftovers[BATCH_LANES] = {0};
+    size_t num_chars = 0;
+    const size_t MIN_OUT_SIZE = n*(FIXED_FORMAT_MAX_LEN - 1);
+
+    if (num_digits_after_decimal > FIXED_FORMAT_MAX_DIGITS)
+    {
+        num_digits_after_decimal = FIXED_FORMAT_MAX_DIGITS;
+    }
+    const size_t WIDTH = FIXED_FORMAT_WIDTH(num_digits_after_decimal);
+
+    for (size_t i = 0; i < n; i += BATCH_LANES)
+    {
+        size_t num_lanes = n - i < BATCH_LANES ? n - i : BATCH_LANES;
+        const fixed_point_t * lane_values = values + i;
+        if (num_lanes < BATCH_LANES)
+        {
+            memcpy(leftovers, values + i, num_lanes*sizeof(fixed_point_t));
+            lane_values = leftovers;
+        }
+        format_lanes(lane_values, num_digits_after_decimal, lanes_text, FIXED_FORMAT_MAX_LEN);
+        // Now squeeze out the leading zeros while copying each number into place.
+        for (size_t lane = 0; lane < num_lanes; lane++)
+        {
+            const char * text = lanes_text + lane*FIXED_FORMAT_MAX_LEN;
+            size_t num_zeros = count_leading_zeros(text);
+            if (offsets != NULL)
+            {
+                offsets[i + lane] = num_chars;
+            }
+            // Copying a constant 16 bytes compiles to a single store; only the tail of `out` needs an exact copy.
+            if (num_chars + FIXED_FORMAT_MAX_LEN <= MIN_OUT_SIZE)
+            {
+                memcpy(out + num_chars, text + num_zeros, FIXED_FORMAT_MAX_LEN);
+            }
+            else
+            {
+                memcpy(out + num_chars, text + num_zeros, WIDTH - num_zeros);
+            }
+            num_chars += WIDTH - num_zeros;
+        }
+    }
+    if (offsets != NULL)
+    {
+        offsets[n] = num_chars;
+    }
+    return num_chars;
+}
+
+/// @brief      Print `n` numbers as "floats", each right-aligned in exactly FIXED_FORMAT_WIDTH(N) chars (the whole
+///             number part is space-padded to FIXED_FORMAT_WHOLE_DIGITS digits), back-to-back, into one contiguous
+///             buffer: ex: "  219.857    1.500". Number `i` is always at `out[i*FIXED_FORMAT_WIDTH(N)]`.
+/// @param[in]  num_digits_after_decimal    0 to 9; larger values are clamped to 9.
+/// @param[out] out                         At least `n*FIXED_FORMAT_WIDTH(N)` chars. NOT null-terminated.
+/// @return     The total number of chars written: `n*FIXED_FORMAT_WIDTH(N)`.
+size_t fixed_format_batch_fixed_width(const fixed_point_t * values, size_t n, uint8_t num_digits_after_decimal,
+                                      char * out)
+{
+    char lanes_text[BATCH_LANES*FIXED_FORMAT_MAX_LEN];
+    fixed_point_t leftovers[BATCH_LANES] = {0};
+
+    if (num_digits_after_decimal > FIXED_FORMAT_MAX_DIGITS)
+    {
+        num_digits_after_decimal = FIXED_FORMAT_MAX_DIGITS;
+    }
+    const size_t WIDTH = FIXED_FORMAT_WIDTH(num_digits_after_decimal);
+
+    size_t i = 0;
+    // Whole groups of BATCH_LANES numbers are printed straight into `out`, as long as the next group's space is
+    // there to absorb format_lanes()' extra trailing chars.
+    for (; (i + 2*BATCH_LANES)*WIDTH <= n*WIDTH; i += BATCH_LANES)
+    {
+        format_lanes(values + i, num_digits_after_decimal, out + i*WIDTH, WIDTH);
+    }
+    // The rest go through a scratch buffer so we never write past the end of `out`.
+    for (; i < n; i += BATCH_LANES)
+    {
+        size_t num_lanes = n - i < BATCH_LANES ? n - i : BATCH_LANES;
+        memset(leftovers, 0, sizeof(leftovers));
+        memcpy(leftovers, values + i, num_lanes*sizeof(fixed_point_t));
+        format_lanes(leftovers, num_digits_after_decimal, lanes_text, WIDTH);
+        memcpy(out + i*WIDTH, lanes_text, num_lanes*WIDTH);
+    }
+    // Turn the leading zeros into spaces.
+    for (i = 0; i < n; i++)
+    {
+        char * text = out + i*WIDTH;
+        size_t num_zeros = count_leading_zeros(text);
+        memset(text, ' ', num_zeros);
+    }
+    return n*WIDTH;
+}
@@ -0,0 +1,287 @@
+/*
+fixed_point_format
+- Manual "float"-like printing of fixed-point numbers into character buffers, using integers only, with correct
+  rounding to any number of digits after the decimal (0 to 9).
+- This is the library version of the "price (manual float, N digits after decimal)" printf ladder in
+  fixed_point_math.cpp, minus the printf.
+- The batch functions print many numbers into one contiguous buffer, generating the digits of 8 numbers at once in
+  SIMD registers (SSE2) where available.
+- And the other way: fixed_parse() reads a decimal number (ex: "219.857") into the nearest fixed-point number.
+- The one-number functions are inline and constexpr in C++, so constants can be parsed from their decimal text, and
+  labels preformatted, at compile time: ex: `constexpr fixed_point_t PRICE = fixed_literal("219.857");`, and
+  `constexpr fixed_format_string_t LABEL = fixed_format_string(PRICE, 2);`. In C, FIXED_FROM_DECIMAL() makes
+  constants that can initialize static (read-only) tables.
+*/
+
+#ifndef FIXED_POINT_FORMAT_H
+#define FIXED_POINT_FORMAT_H
+
+#include <stddef.h>
+
+#include "fixed_point.h"
+#include "fixed_point_round.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The most digits after the decimal we support. 10^9 is the max power of 10 that fits in a uint32_t.
+#define FIXED_FORMAT_MAX_DIGITS 9
+// The most characters one formatted number can take, *including* the terminating null: 5 whole number digits
+// ("65536", since 65535.99999 can round up), the '.', 9 digits after the decimal, and the '\0'.
+#define FIXED_FORMAT_MAX_LEN 16
+// In fixed-width mode, every number gets this many whole number digits (enough for "65536"), space-padded on the
+// left; ex: "  219.857".
+#define FIXED_FORMAT_WHOLE_DIGITS 5
+// The width of every number printed by fixed_format_batch_fixed_width(). `num_digits_after_decimal` must be 0 to 9.
+#define FIXED_FORMAT_WIDTH(num_digits_after_decimal) \
+    (FIXED_FORMAT_WHOLE_DIGITS + ((num_digits_after_decimal) > 0 ? 1 + (num_digits_after_decimal) : 0))
+
+// 10^n, for n from 0 to 9, as a constant expression (ex: for a static table's initializer in C).
+#define FIXED_POW10(n)                                                                                                 \
+    ((n) == 0 ? 1u : (n) == 1 ? 10u : (n) == 2 ? 100u : (n) == 3 ? 1000u : (n) == 4 ? 10000u : (n) == 5 ? 100000u   \
+     : (n) == 6 ? 1000000u : (n) == 7 ? 10000000u : (n) == 8 ? 100000000u : 1000000000u)
+// The fixed-point number nearest `whole`.`fraction`, where `fraction` has `num_digits` (0 to 9) digits after the
+// decimal, rounded half up, as a constant expression: ex: FIXED_FROM_DECIMAL(219, 857, 3) for 219.857, and
+// FIXED_FROM_DECIMAL(0, 5, 2) for 0.05. (Write `fraction` without leading zeros: in C, 05 would be octal.) The same
+// as fixed_parse() of the same text; `whole` must be at most 65535, and the result must not round up to 65536.0.
+#define FIXED_FROM_DECIMAL(whole, fraction, num_digits)                                                                \
+    ((fixed_point_t)(((uint64_t)(whole) << FRACTION_BITS)                                                              \
+                     + (((uint64_t)(fraction) << FRACTION_BITS) + FIXED_POW10(num_digits)/2)/FIXED_POW10(num_digits)))
+
+// One number printed by fixed_format_string(). Returned by value, so in C++ it can be a constexpr constant.
+typedef struct fixed_format_string_s
+{
+    char chars[FIXED_FORMAT_MAX_LEN]; // null-terminated
+    uint8_t length;                   // not counting the null
+} fixed_format_string_t;
+
+size_t fixed_format_batch(const fixed_point_t * values, size_t n, uint8_t num_digits_after_decimal, char * out,
+                          size_t * offsets);
+size_t fixed_format_batch_fixed_width(const fixed_point_t * values, size_t n, uint8_t num_digits_after_decimal,
+                                      char * out);
+
+// -----------------------------------------------------------------------------------------------------------------
+// One number at a time. Everything here is constexpr in C++, so it can run at compile time.
+// -----------------------------------------------------------------------------------------------------------------
+
+/// @brief      10^n, for n from 0 to 9 (larger n give 10^9).
+static inline FIXED_CONSTEXPR uint32_t fixed_pow10(uint8_t n)
+{
+    switch (n)
+    {
+        case 0:
+            return 1;
+        case 1:
+            return 10;
+        case 2:
+            return 100;
+        case 3:
+            return 1000;
+        case 4:
+            return 10000;
+        case 5:
+            return 100000;
+        case 6:
+            return 1000000;
+        case 7:
+            return 10000000;
+        case 8:
+            return 100000000;
+        default:
+            return 1000000000;
+    }
+}
+
+/// @brief      Round a fixed-point number to `num_digits_after_decimal` decimal digits, exactly.
+/// @details    Unlike the tutorial's truncated addends (ex: FRACTION_DIVISOR/200000 == 0), this does the rounding in
+///             64 bits: `(value*10^N + FRACTION_DIVISOR/2) >> FRACTION_BITS`. The result is the printed number with
+///             the decimal point removed; ex: 218.571 at 2 digits --> 21857.
+/// @param[in]  num_digits_after_decimal    0 to 9; larger values are clamped to 9.
+static inline FIXED_CONSTEXPR uint64_t fixed_round_to_decimal(fixed_point_t value, uint8_t num_digits_after_decimal)
+{
+    return ((uint64_t)value * fixed_pow10(num_digits_after_decimal) + FRACTION_DIVISOR/2) >> FRACTION_BITS;
+}
+
+/// @brief      fixed_round_to_decimal(), truncated instead: the tutorial's first "manual float" ladder, which prints
+///             `value >> FRACTION_BITS`, then `(value & FRACTION_MASK) * 10^N / FRACTION_DIVISOR` after the decimal.
+/// @param[in]  num_digits_after_decimal    0 to 9; larger values are clamped to 9.
+static inline FIXED_CONSTEXPR uint64_t fixed_truncate_to_decimal(fixed_point_t value,
+                                                                 uint8_t num_digits_after_decimal)
+{
+    return ((uint64_t)value * fixed_pow10(num_digits_after_decimal)) >> FRACTION_BITS;
+}
+
+/// @brief      The tutorial's rounding addend for N digits after the decimal: half of 1/10^N, in units of
+///             1/FRACTION_DIVISOR, truncated (so 0 from 5 digits on, where fixed_round_to_decimal() is still right).
+/// @param[in]  num_digits_after_decimal    0 to 9; larger values are clamped to 9.
+static inline FIXED_CONSTEXPR fixed_point_t fixed_round_addend(uint8_t num_digits_after_decimal)
+{
+    return (fixed_point_t)(FRACTION_DIVISOR / (2 * (uint64_t)fixed_pow10(num_digits_after_decimal)));
+}
+
+/// @brief      How many digits after the decimal the fixed-point resolution (1/FRACTION_DIVISOR) is at least as fine
+///             as: 4 for 16 fraction bits. From the next digit on, decimal error creeps in (see
+///             print_if_error_introduced() in fixed_point_math.cpp).
+static inline FIXED_CONSTEXPR uint8_t fixed_resolution_digits(void)
+{
+    uint8_t num_digits = 0;
+    while (num_digits < FIXED_FORMAT_MAX_DIGITS && fixed_pow10((uint8_t)(num_digits + 1)) <= FRACTION_DIVISOR)
+    {
+        num_digits++;
+    }
+    return num_digits;
+}
+
+/// @brief      Print a fixed-point number as a "float", rounded to `num_digits_after_decimal` digits.
+/// @details    Ex: price = 14408557 (219.857131...) --> "219.857" at 3 digits, or "220" at 0 digits.
+/// @param[in]  value                       The fixed-point number to print.
+/// @param[in]  num_digits_after_decimal    0 to 9; larger values are clamped to 9. 0 prints no decimal point.
+/// @param[out] out                         At least FIXED_FORMAT_MAX_LEN chars. Gets null-terminated.
+/// @return     The number of chars written, not counting the terminating null.
+static inline FIXED_CONSTEXPR size_t fixed_format(fixed_point_t value, uint8_t num_digits_after_decimal, char * out)
+{
+    if (num_digits_after_decimal > FIXED_FORMAT_MAX_DIGITS)
+    {
+        num_digits_after_decimal = FIXED_FORMAT_MAX_DIGITS;
+    }
+
+    // Round first, *then* split into whole and fractional parts, so that ex: 1.9999 at 2 digits carries all the
+    // way up into "2.00" instead of printing "1.100".
+    uint64_t rounded = fixed_round_to_decimal(value, num_digits_after_decimal);
+    uint32_t whole = (uint32_t)(rounded / fixed_pow10(num_digits_after_decimal));
+    uint32_t fraction = (uint32_t)(rounded % fixed_pow10(num_digits_after_decimal));
+
+    // Count the whole number digits, then generate all the digits backwards, least-significant first, straight into
+    // place. The fractional part always gets exactly `num_digits_after_decimal` digits, which is the "%03lu"-style
+    // zero padding from the tutorial.
+    size_t num_chars = 1 + (num_digits_after_decimal > 0 ? 1u + num_digits_after_decimal : 0u);
+    for (uint32_t rest = whole; rest >= 10; rest /= 10)
+    {
+        num_chars++;
+    }
+    size_t i = num_chars;
+    out[i] = '\0';
+    for (uint8_t d = 0; d < num_digits_after_decimal; d++)
+    {
+        out[--i] = (char)('0' + fraction % 10);
+        fraction /= 10;
+    }
+    if (num_digits_after_decimal > 0)
+    {
+        out[--i] = '.';
+    }
+    do
+    {
+        out[--i] = (char)('0' + whole % 10);
+        whole /= 10;
+    } while (i > 0);
+    return num_chars;
+}
+
+/// @brief      fixed_format(), returning the text by value instead of writing it into a buffer.
+static inline FIXED_CONSTEXPR fixed_format_string_t fixed_format_string(fixed_point_t value,
+                                                                        uint8_t num_digits_after_decimal)
+{
+    fixed_format_string_t text = {{0}, 0};
+    text.length = (uint8_t)fixed_format(value, num_digits_after_decimal, text.chars);
+    return text;
+}
+
+// The most digits after the decimal fixed_parse() looks at. 10^19 is the max power of 10 that fits in a uint64_t.
+// The ones after it can't change the result: see fixed_parse().
+#define FIXED_PARSE_MAX_DIGITS 19
+
+/// @brief      Read a decimal number (ex: "219.857") into the nearest fixed-point number, rounded half up. This is the
+///             inverse of fixed_format(): parsing its output gives back the number it printed, whenever that many
+///             digits after the decimal can tell fixed-point numbers apart (5 or more).
+/// @details    The digits after the decimal, as the fraction F/10^k, become round(F*2^16/10^k) = round(F*2^16 /
+///             (2^k*5^k)): the 2s cancel, so the numerator and denominator both fit in 64 bits. Only the first
+///             FIXED_PARSE_MAX_DIGITS digits count: the rest add less than 1 to F, which can only break an exact tie
+///             upward, and a tie rounds up anyway.
+/// @param[in]  text        Digits, then optionally a '.' and more digits, with at least 1 digit in all (ex: "7",
+///                         "0.5", ".5", "7."). No sign, spaces, or exponent. Needn't be null-terminated.
+/// @param[in]  length      The number of chars in `text`.
+/// @param[out] out         Gets the number. Left alone on failure.
+/// @return     true on success; false if `text` isn't such a number, or if it rounds to 65536.0 or more.
+static inline FIXED_CONSTEXPR bool fixed_parse(const char * text, size_t length, fixed_point_t * out)
+{
+    size_t i = 0;
+    size_t num_digits = 0;
+    uint32_t whole = 0;
+    for (; i < length && text[i] >= '0' && text[i] <= '9'; i++, num_digits++)
+    {
+        whole = whole*10 + (uint32_t)(text[i] - '0');
+        if (whole > (UINT32_MAX >> FRACTION_BITS))
+        {
+            return false;
+        }
+    }
+    uint64_t fraction = 0;
+    uint8_t num_fraction_digits = 0;
+    if (i < length && text[i] == '.')
+    {
+        for (i++; i < length && text[i] >= '0' && text[i] <= '9'; i++, num_digits++)
+        {
+            if (num_fraction_digits < FIXED_PARSE_MAX_DIGITS)
+            {
+                fraction = fraction*10 + (uint64_t)(text[i] - '0');
+                num_fraction_digits++;
+            }
+        }
+    }
+    if (i != length || num_digits == 0)
+    {
+        return false;
+    }
+
+    uint64_t pow5 = 1;
+    for (uint8_t k = 0; k < num_fraction_digits; k++)
+    {
+        pow5 *= 5;
+    }
+    uint64_t numerator = fraction;
+    uint64_t denominator = pow5;
+    if (num_fraction_digits <= FRACTION_BITS)
+    {
+        // F < 10^k, so F*2^(16 - k) < 5^k*2^16 <= 5^16*2^16: it fits.
+        numerator <<= FRACTION_BITS - num_fraction_digits;
+    }
+    else
+    {
+        denominator <<= num_fraction_digits - FRACTION_BITS;
+    }
+    uint64_t result = ((uint64_t)whole << FRACTION_BITS)
+        + fixed_div_round_u64(numerator, denominator, FIXED_ROUND_HALF_UP);
+    if (result > UINT32_MAX)
+    {
+        return false;
+    }
+    *out = (fixed_point_t)result;
+    return true;
+}
+
+#ifdef __cplusplus
+}
+
+#if __cplusplus >= 201402L
+// Only for fixed_literal(): calling it (something not constexpr) is what makes a bad literal fail to compile.
+inline fixed_point_t fixed_literal_is_not_a_number_from_0_to_65535(void)
+{
+    return 0;
+}
+
+/// @brief      A fixed-point constant from its decimal text, with fixed_parse(): ex:
+///             `constexpr fixed_point_t PRICE = fixed_literal("219.857");`. Text fixed_parse() rejects doesn't compile
+///             in a constant expression (and gives 0 at run time).
+template <size_t N>
+constexpr fixed_point_t fixed_literal(const char (&text)[N])
+{
+    fixed_point_t value = 0;
+    return fixed_parse(text, N - 1, &value) ? value : fixed_literal_is_not_a_number_from_0_to_65535();
+}
+#endif
+
+#endif
+
+#endif // FIXED_POINT_FORMAT_H
@@ -0,0 +1,200 @@
+/*
+fixed_point_interval
+- See fixed_point_interval.h.
+*/
+
+#include "fixed_point_interval.h"
+
+// Clamp a 64-bit intermediate result back into a fixed_point_t, marking the interval as overflowed if it doesn't fit.
+static fixed_point_t clamp_to_fixed(uint64_t value, bool * overflow)
+{
+    if (value > UINT32_MAX)
+    {
+        *overflow = true;
+        return UINT32_MAX;
+    }
+    return (fixed_point_t)value;
+}
+
+// Integer division that rounds *up* instead of truncating, so upper bounds never shrink below the true value.
+static uint64_t div_round_up(uint64_t dividend, uint64_t divisor)
+{
+    return dividend/divisor + (dividend % divisor != 0);
+}
+
+/// @brief      Make an interval that holds exactly one, exactly-known value (ie: zero error).
+fixed_interval_t fixed_interval_exact(fixed_point_t value)
+{
+    fixed_interval_t a;
+    a.lo = value;
+    a.hi = value;
+    a.overflow = false;
+    return a;
+}
+
+/// @brief      Make the tightest interval that contains the true value of `numerator/denominator`.
+/// @details    Ex: 1/3 can't be represented exactly with FRACTION_BITS of fraction, so the result is
+///             [21845/65536, 21846/65536].
+fixed_interval_t fixed_interval_from_ratio(uint32_t numerator, uint32_t denominator)
+{
+    fixed_interval_t a = fixed_interval_exact(0);
+    if (denominator == 0)
+    {
+        a.overflow = true;
+        a.hi = UINT32_MAX;
+        return a;
+    }
+    a.lo = clamp_to_fixed(((uint64_t)numerator << FRACTION_BITS) / denominator, &a.overflow);
+    a.hi = clamp_to_fixed(div_round_up((uint64_t)numerator << FRACTION_BITS, denominator), &a.overflow);
+    return a;
+}
+
+fixed_interval_t fixed_interval_add(fixed_interval_t a, fixed_interval_t b)
+{
+    fixed_interval_t result;
+    result.overflow = a.overflow || b.overflow;
+    result.lo = clamp_to_fixed((uint64_t)a.lo + b.lo, &result.overflow);
+    result.hi = clamp_to_fixed((uint64_t)a.hi + b.hi, &result.overflow);
+    return result;
+}
+
+fixed_interval_t fixed_interval_sub(fixed_interval_t a, fixed_interval_t b)
+{
+    fixed_interval_t result;
+    result.overflow = a.overflow || b.overflow;
+    // The smallest possible difference is the smallest `a` minus the largest `b`, and vice versa. We are unsigned, so
+    // going below zero is an overflow just like going above UINT32_MAX is.
+    if (b.hi > a.lo)
+    {
+        result.overflow = true;
+        result.lo = 0;
+    }
+    else
+    {
+        result.lo = a.lo - b.hi;
+    }
+    if (b.lo > a.hi)
+    {
+        result.overflow = true;
+        result.hi = 0;
+    }
+    else
+    {
+        result.hi = a.hi - b.lo;
+    }
+    return result;
+}
+
+/// @brief      Multiply two fixed-point intervals. The 32x32 = 64-bit product has 2*FRACTION_BITS of fraction, so we
+///             right-shift by FRACTION_BITS, truncating the low bound and rounding the high bound up.
+fixed_interval_t fixed_interval_mul(fixed_interval_t a, fixed_interval_t b)
+{
+    fixed_interval_t result;
+    result.overflow = a.overflow || b.overflow;
+    result.lo = clamp_to_fixed(((uint64_t)a.lo * b.lo) >> FRACTION_BITS, &result.overflow);
+    result.hi = clamp_to_fixed(div_round_up((uint64_t)a.hi * b.hi, FRACTION_DIVISOR), &result.overflow);
+    return result;
+}
+
+/// @brief      Multiply a fixed-point interval by a plain (exact) integer, ie: `price *= 3`.
+fixed_interval_t fixed_interval_mul_int(fixed_interval_t a, uint32_t times)
+{
+    fixed_interval_t result;
+    result.overflow = a.overflow;
+    result.lo = clamp_to_fixed((uint64_t)a.lo * times, &result.overflow);
+    result.hi = clamp_to_fixed((uint64_t)a.hi * times, &result.overflow);
+    return result;
+}
+
+/// @brief      Divide two fixed-point intervals: `(a << FRACTION_BITS)/b`. Dividing by an interval that contains
+///             zero is reported as an overflow.
+fixed_interval_t fixed_interval_div(fixed_interval_t a, fixed_interval_t b)
+{
+    fixed_interval_t result;
+    result.overflow = a.overflow || b.overflow;
+    if (b.lo == 0)
+    {
+        result.overflow = true;
+        result.lo = 0;
+        result.hi = UINT32_MAX;
+        return result;
+    }
+    // Smallest quotient: smallest dividend over the largest divisor, and vice versa.
+    result.lo = clamp_to_fixed(((uint64_t)a.lo << FRACTION_BITS) / b.hi, &result.overflow);
+    result.hi = clamp_to_fixed(div_round_up((uint64_t)a.hi << FRACTION_BITS, b.lo), &result.overflow);
+    return result;
+}
+
+/// @brief      Divide a fixed-point interval by a plain (exact) integer, ie: `price /= 7`.
+fixed_interval_t fixed_interval_div_int(fixed_interval_t a, uint32_t divide)
+{
+    fixed_interval_t result;
+    result.overflow = a.overflow;
+    if (divide == 0)
+    {
+        result.overflow = true;
+        result.lo = 0;
+        result.hi = UINT32_MAX;
+        return result;
+    }
+    result.lo = a.lo / divide;
+    result.hi = (fixed_point_t)div_round_up(a.hi, divide);
+    return result;
+}
+
+/// @brief      Round both bounds to the nearest whole number, using the tutorial's "add FRACTION_DIVISOR/2, then
+///             truncate" rule. Rounding never reorders values, so the result still contains the rounded true value.
+fixed_interval_t fixed_interval_round_whole(fixed_interval_t a)
+{
+    fixed_interval_t result;
+    result.overflow = a.overflow;
+    result.lo = clamp_to_fixed(((uint64_t)a.lo + FRACTION_DIVISOR/2) & ~(uint64_t)FRACTION_MASK, &result.overflow);
+    result.hi = clamp_to_fixed(((uint64_t)a.hi + FRACTION_DIVISOR/2) & ~(uint64_t)FRACTION_MASK, &result.overflow);
+    return result;
+}
+
+/// @brief      Grow an interval just enough to also contain `value`.
+fixed_interval_t fixed_interval_hull(fixed_interval_t a, fixed_point_t value)
+{
+    if (value < a.lo)
+    {
+        a.lo = value;
+    }
+    if (value > a.hi)
+    {
+        a.hi = value;
+    }
+    return a;
+}
+
+/// @brief      Find how many digits after the decimal are guaranteed correct when this interval is printed rounded.
+/// @details    The true answer and our computed answer both lie somewhere in [lo, hi], so if lo and hi round to the
+///             same N-digit decimal, then so does everything in between (rounding is monotonic), and the printed
+///             N digits are exact.
+///             Note that fixed_tracked_certify() only asks about one specific digit count, so in the rare case noted
+///             below it may certify a digit count larger than this function reports.
+/// @param[in]  max_digits_after_decimal    The most digits you care about (0 to 9).
+/// @return     The largest N <= max_digits_after_decimal that is certified exact. 0 if not even the whole number
+///             part is certain (check `fixed_round_to_decimal(lo, 0) == fixed_round_to_decimal(hi, 0)` to tell
+///             "0 digits certified" apart from "nothing certified"), or if the interval overflowed.
+uint8_t fixed_interval_certain_digits(fixed_interval_t a, uint8_t max_digits_after_decimal)
+{
+    uint8_t num_digits = 0;
+
+    if (a.overflow)
+    {
+        return 0;
+    }
+    if (max_digits_after_decimal > FIXED_FORMAT_MAX_DIGITS)
+    {
+        max_digits_after_decimal = FIXED_FORMAT_MAX_DIGITS;
+    }
+    // Stop at the first mismatch, even though a later digit count can occasionally agree again (ex: 0.149 and 0.151
+    // differ at 1 digit but both print 0.15 at 2). Reporting only the unbroken run keeps the answer conservative.
+    while (num_digits < max_digits_after_decimal &&
+           fixed_round_to_decimal(a.lo, num_digits + 1) == fixed_round_to_decimal(a.hi, num_digits + 1))
+    {
+        num_digits++;
+    }
+    return num_digits;
+}
@@ -0,0 +1,212 @@
+/*
+fixed_point_interval
+- Interval ("error-bound") tracking for fixed-point expressions.
+- Every value carries a [lo, hi] range that is guaranteed to contain both the *true* (infinitely precise) answer and
+  the answer our truncating fixed-point math actually produces. Each operation rounds `lo` down and `hi` up, so the
+  bounds can only ever grow, never lie.
+- Once the interval is narrow enough that every value inside it rounds to the same N-digit decimal, the output is
+  certified exact to N digits after the decimal, with no double-precision cross-check needed. This is the precise
+  version of the estimate `print_if_error_introduced()` makes in fixed_point_math.cpp.
+
+Usage:
+- Write your pipeline once in terms of `fixed_tracked_t` and the `fixed_tracked_*()` functions below.
+- Compile with `-DFIXED_POINT_TRACK_ERROR` to run the analysis build: each value then carries its bounds, and
+  `fixed_tracked_certify()` really checks them.
+- Compile without it for production: `fixed_tracked_t` is then just `fixed_point_t`, every `fixed_tracked_*()` call
+  is a plain inline integer operation, and all of the tracking is removed.
+*/
+
+#ifndef FIXED_POINT_INTERVAL_H
+#define FIXED_POINT_INTERVAL_H
+
+#include "fixed_point.h"
+#include "fixed_point_format.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A closed range [lo, hi] of fixed-point numbers.
+typedef struct fixed_interval_s
+{
+    fixed_point_t lo;
+    fixed_point_t hi;
+    // Set (and kept set forever after) once any operation on this range overflowed or divided by zero. An
+    // overflowed interval can never be certified.
+    bool overflow;
+} fixed_interval_t;
+
+fixed_interval_t fixed_interval_exact(fixed_point_t value);
+fixed_interval_t fixed_interval_from_ratio(uint32_t numerator, uint32_t denominator);
+fixed_interval_t fixed_interval_add(fixed_interval_t a, fixed_interval_t b);
+fixed_interval_t fixed_interval_sub(fixed_interval_t a, fixed_interval_t b);
+fixed_interval_t fixed_interval_mul(fixed_interval_t a, fixed_interval_t b);
+fixed_interval_t fixed_interval_mul_int(fixed_interval_t a, uint32_t times);
+fixed_interval_t fixed_interval_div(fixed_interval_t a, fixed_interval_t b);
+fixed_interval_t fixed_interval_div_int(fixed_interval_t a, uint32_t divide);
+fixed_interval_t fixed_interval_round_whole(fixed_interval_t a);
+fixed_interval_t fixed_interval_hull(fixed_interval_t a, fixed_point_t value);
+uint8_t fixed_interval_certain_digits(fixed_interval_t a, uint8_t max_digits_after_decimal);
+
+// -----------------------------------------------------------------------------------------------------------------
+// Tracked values: the same pipeline code compiles either with bounds (analysis) or without them (production).
+// -----------------------------------------------------------------------------------------------------------------
+
+#ifdef FIXED_POINT_TRACK_ERROR
+
+// Analysis build: the value production would compute, plus the bounds around the true answer.
+typedef struct fixed_tracked_s
+{
+    fixed_point_t value;
+    fixed_interval_t bounds;
+} fixed_tracked_t;
+
+// Make a tracked value from one whose bounds are already known. `value` must lie inside `bounds`.
+static inline fixed_tracked_t fixed_tracked_make(fixed_point_t value, fixed_interval_t bounds)
+{
+    fixed_tracked_t t;
+    t.value = value;
+    // Production's own wrap-around is what makes `value` fall outside the range; keep it visible.
+    t.bounds = fixed_interval_hull(bounds, value);
+    return t;
+}
+
+static inline fixed_tracked_t fixed_tracked_from_fixed(fixed_point_t value)
+{
+    return fixed_tracked_make(value, fixed_interval_exact(value));
+}
+
+static inline fixed_tracked_t fixed_tracked_from_ratio(uint32_t numerator, uint32_t denominator)
+{
+    fixed_interval_t bounds = fixed_interval_from_ratio(numerator, denominator);
+    return fixed_tracked_make(bounds.lo, bounds);
+}
+
+static inline fixed_point_t fixed_tracked_value(fixed_tracked_t a)
+{
+    return a.value;
+}
+
+static inline fixed_tracked_t fixed_tracked_add(fixed_tracked_t a, fixed_tracked_t b)
+{
+    return fixed_tracked_make(a.value + b.value, fixed_interval_add(a.bounds, b.bounds));
+}
+
+static inline fixed_tracked_t fixed_tracked_sub(fixed_tracked_t a, fixed_tracked_t b)
+{
+    return fixed_tracked_make(a.value - b.value, fixed_interval_sub(a.bounds, b.bounds));
+}
+
+static inline fixed_tracked_t fixed_tracked_mul(fixed_tracked_t a, fixed_tracked_t b)
+{
+    return fixed_tracked_make((fixed_point_t)(((uint64_t)a.value * b.value) >> FRACTION_BITS),
+                              fixed_interval_mul(a.bounds, b.bounds));
+}
+
+static inline fixed_tracked_t fixed_tracked_mul_int(fixed_tracked_t a, uint32_t times)
+{
+    return fixed_tracked_make(a.value * times, fixed_interval_mul_int(a.bounds, times));
+}
+
+static inline fixed_tracked_t fixed_tracked_div(fixed_tracked_t a, fixed_tracked_t b)
+{
+    fixed_point_t value = b.value == 0 ? 0 : (fixed_point_t)(((uint64_t)a.value << FRACTION_BITS) / b.value);
+    return fixed_tracked_make(value, fixed_interval_div(a.bounds, b.bounds));
+}
+
+static inline fixed_tracked_t fixed_tracked_div_int(fixed_tracked_t a, uint32_t divide)
+{
+    fixed_point_t value = divide == 0 ? 0 : a.value / divide;
+    return fixed_tracked_make(value, fixed_interval_div_int(a.bounds, divide));
+}
+
+static inline fixed_tracked_t fixed_tracked_round_whole(fixed_tracked_t a)
+{
+    return fixed_tracked_make((a.value + FRACTION_DIVISOR/2) & ~(fixed_point_t)FRACTION_MASK,
+                              fixed_interval_round_whole(a.bounds));
+}
+
+/// @brief      Check that `a`, printed rounded to `num_digits_after_decimal` digits, is guaranteed to show the same
+///             digits as the true answer would.
+/// @return     true if certified; false if error may be visible at that many digits (or if anything overflowed).
+static inline bool fixed_tracked_certify(fixed_tracked_t a, uint8_t num_digits_after_decimal)
+{
+    return !a.bounds.overflow && fixed_round_to_decimal(a.bounds.lo, num_digits_after_decimal) ==
+                                 fixed_round_to_decimal(a.bounds.hi, num_digits_after_decimal);
+}
+
+#else // FIXED_POINT_TRACK_ERROR
+
+// Production build: no bounds, no overhead. These must stay operation-for-operation identical to the `value` math in
+// the analysis build above, or the certification means nothing.
+typedef fixed_point_t fixed_tracked_t;
+
+static inline FIXED_CONSTEXPR fixed_tracked_t fixed_tracked_from_fixed(fixed_point_t value)
+{
+    return value;
+}
+
+// Like fixed_interval_from_ratio()'s `lo`: 0 for a zero denominator, and clamped to UINT32_MAX past the largest value.
+static inline FIXED_CONSTEXPR fixed_tracked_t fixed_tracked_from_ratio(uint32_t numerator, uint32_t denominator)
+{
+    return denominator == 0 ? 0
+           : ((uint64_t)numerator << FRACTION_BITS) / denominator > UINT32_MAX
+               ? UINT32_MAX
+               : (fixed_point_t)(((uint64_t)numerator << FRACTION_BITS) / denominator);
+}
+
+static inline FIXED_CONSTEXPR fixed_point_t fixed_tracked_value(fixed_tracked_t a)
+{
+    return a;
+}
+
+static inline FIXED_CONSTEXPR fixed_tracked_t fixed_tracked_add(fixed_tracked_t a, fixed_tracked_t b)
+{
+    return a + b;
+}
+
+static inline FIXED_CONSTEXPR fixed_tracked_t fixed_tracked_sub(fixed_tracked_t a, fixed_tracked_t b)
+{
+    return a - b;
+}
+
+static inline FIXED_CONSTEXPR fixed_tracked_t fixed_tracked_mul(fixed_tracked_t a, fixed_tracked_t b)
+{
+    return (fixed_point_t)(((uint64_t)a * b) >> FRACTION_BITS);
+}
+
+static inline FIXED_CONSTEXPR fixed_tracked_t fixed_tracked_mul_int(fixed_tracked_t a, uint32_t times)
+{
+    return a * times;
+}
+
+static inline FIXED_CONSTEXPR fixed_tracked_t fixed_tracked_div(fixed_tracked_t a, fixed_tracked_t b)
+{
+    return b == 0 ? 0 : (fixed_point_t)(((uint64_t)a << FRACTION_BITS) / b);
+}
+
+static inline FIXED_CONSTEXPR fixed_tracked_t fixed_tracked_div_int(fixed_tracked_t a, uint32_t divide)
+{
+    return divide == 0 ? 0 : a / divide;
+}
+
+static inline FIXED_CONSTEXPR fixed_tracked_t fixed_tracked_round_whole(fixed_tracked_t a)
+{
+    return (a + FRACTION_DIVISOR/2) & ~(fixed_point_t)FRACTION_MASK;
+}
+
+// Certification is done by the analysis build; production trusts it.
+static inline FIXED_CONSTEXPR bool fixed_tracked_certify(fixed_tracked_t a, uint8_t num_digits_after_decimal)
+{
+    (void)a;
+    (void)num_digits_after_decimal;
+    return true;
+}
+
+#endif // FIXED_POINT_TRACK_ERROR
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIXED_POINT_INTERVAL_H
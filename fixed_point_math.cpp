@@ -13,12 +13,20 @@ References:
 - https://stackoverflow.com/questions/10067510/fixed-point-arithmetic-in-c-programming
 
 Commands to Compile & Run:
-As a C program (the file must NOT have a C++ file extension or it will be automatically compiled as C++, so we will
-make a copy of it and change the file extension to .c first):
-See here: https://stackoverflow.com/a/3206195/4561887. 
-    cp fixed_point_math.cpp fixed_point_math_copy.c && gcc -Wall -std=c99 -o ./bin/fixed_point_math_c fixed_point_math_copy.c && ./bin/fixed_point_math_c
-As a C++ program:
-    g++ -Wall -o ./bin/fixed_point_math_cpp fixed_point_math.cpp && ./bin/fixed_point_math_cpp
+With CMake (see CMakeLists.txt), which builds this one file both as a C99 program and as a C++17 program:
+    cmake -S . -B build && cmake --build build -j && ./build/fixed_point_math_c && ./build/fixed_point_math_cpp
+Or by hand. First, list the helper modules this tutorial uses:
+    FIXED_POINT_MODULES="fixed_point_arena.c fixed_point_bfp.c fixed_point_big.c fixed_point_codec.c
+        fixed_point_column.c fixed_point_div.c fixed_point_fft.c fixed_point_format.c fixed_point_interval.c
+        fixed_point_mul.c fixed_point_pipeline.c fixed_point_poly.c fixed_point_qformat.c fixed_point_quantize.c
+        fixed_point_ratio.c fixed_point_requantize.c fixed_point_sort.c fixed_point_stats.c fixed_point_time.c
+        fixed_point_tune.c"
+As a C program (gcc would otherwise compile a file with a C++ file extension as C++, so use `-x c` to force C for this
+file, then `-x none` to go back to picking the language by file extension for the rest):
+See here: https://stackoverflow.com/a/3206195/4561887.
+    gcc -Wall -std=c99 -pthread -o fixed_point_math_c -x c fixed_point_math.cpp -x none $FIXED_POINT_MODULES -lm && ./fixed_point_math_c
+As a C++ program (g++ compiles the .c helper modules as C++ too):
+    g++ -Wall -pthread -o fixed_point_math_cpp fixed_point_math.cpp $FIXED_POINT_MODULES && ./fixed_point_math_cpp
 
 */
 
@@ -26,14 +34,14 @@ As a C++ program:
 #include <stdio.h>
 #include <stdint.h>
 
-// Define our fixed point type.
-typedef uint32_t fixed_point_t;
-
-#define BITS_PER_BYTE 8
-
-#define FRACTION_BITS 16 // 1 << 16 = 2^16 = 65536
-#define FRACTION_DIVISOR (1 << FRACTION_BITS)
-#define FRACTION_MASK (FRACTION_DIVISOR - 1) // 65535 (all LSB set, all MSB clear)
+// Our fixed point type (`fixed_point_t`), FRACTION_BITS, FRACTION_DIVISOR, and FRACTION_MASK are defined here.
+// The tutorial's basic operations (fixed_from_int(), fixed_mul_int(), etc.) too.
+#include "fixed_point.h"
+#include "fixed_point_format.h"
+#include "fixed_point_interval.h"
+#include "fixed_point_ratio.h"
+#include "fixed_point_round.h"
+#include "fixed_point_time.h"
 
 // // Conversions [NEVERMIND, LET'S DO THIS MANUALLY INSTEAD OF USING THESE MACROS TO HELP ENGRAIN IT IN US BETTER]:
 // #define INT_2_FIXED_PT_NUM(num)     (num << FRACTION_BITS)      // Regular integer number to fixed point number
@@ -47,25 +55,24 @@ int main(int argc, char * argv[])
     printf("Begin.\n");
 
     // We know how many bits we will use for the fraction, but how many bits are remaining for the whole number, 
-    // and what's the whole number's max range? Let's calculate it.
-    const uint8_t WHOLE_NUM_BITS = sizeof(fixed_point_t)*BITS_PER_BYTE - FRACTION_BITS;
-    const fixed_point_t MAX_WHOLE_NUM = (1 << WHOLE_NUM_BITS) - 1;
+    // and what's the whole number's max range? "fixed_point.h" calculates it: WHOLE_NUM_BITS and MAX_WHOLE_NUM.
     printf("fraction bits = %u.\n", FRACTION_BITS);
     printf("whole number bits = %u.\n", WHOLE_NUM_BITS);
     printf("max whole number = %u.\n\n", MAX_WHOLE_NUM);
 
     // Create a variable called `price`, and let's do some fixed point math on it.
     const fixed_point_t PRICE_ORIGINAL = 503;
-    fixed_point_t price = PRICE_ORIGINAL << FRACTION_BITS;
-    price += 10 << FRACTION_BITS;
-    price *= 3;
-    price /= 7; // now our price is ((500 + 10)*3/7) = 218.571428571.
+    // (fixed_from_int(x) is `x << FRACTION_BITS`, fixed_mul_int() is `*`, and fixed_div_int_truncate() is `/`.)
+    fixed_point_t price = fixed_from_int(PRICE_ORIGINAL);
+    price += fixed_from_int(10);
+    price = fixed_mul_int(price, 3);
+    price = fixed_div_int_truncate(price, 7); // now our price is ((500 + 10)*3/7) = 218.571428571.
 
     printf("price as a true double is %3.9f.\n", ((double)PRICE_ORIGINAL + 10)*3/7);
-    printf("price as integer is %u.\n", price >> FRACTION_BITS);
-    printf("price fractional part is %u (of %u).\n", price & FRACTION_MASK, FRACTION_DIVISOR);
-    printf("price fractional part as decimal is %f (%u/%u).\n", (double)(price & FRACTION_MASK) / FRACTION_DIVISOR,
-           price & FRACTION_MASK, FRACTION_DIVISOR);
+    printf("price as integer is %u.\n", fixed_to_int(price));
+    printf("price fractional part is %u (of %u).\n", fixed_fraction(price), FRACTION_DIVISOR);
+    printf("price fractional part as decimal is %f (%u/%u).\n", (double)fixed_fraction(price) / FRACTION_DIVISOR,
+           fixed_fraction(price), FRACTION_DIVISOR);
 
     // Now, if you don't have float support (neither in hardware via a Floating Point Unit [FPU], nor in software
     // via built-in floating point math libraries as part of your processor's C implementation), then you may have
@@ -80,34 +87,22 @@ int main(int argc, char * argv[])
     //     5 digits: * 10^5 ==> * 100000    <== 5 zeros
     // - 2) Be sure to use the proper printf format statement to enforce the proper number of leading zeros in front of
     //   the fractional part of the number. ie: refer to the "%01", "%02", "%03", etc. below.
+    // fixed_truncate_to_decimal() (see "fixed_point_format.h") does both at once: it gives the number times 10^N,
+    // truncated, so the whole number part is that / 10^N, and the digits after the decimal are that % 10^N, printed
+    // with N leading zeros ("%0*llu", with N for the `*`).
     // Manual "floats":
-    // 0 digits after the decimal
-    printf("price (manual float, 0 digits after decimal) is %u.", 
-           price >> FRACTION_BITS); print_if_error_introduced(0);
-    // 1 digit after the decimal
-    printf("price (manual float, 1 digit  after decimal) is %u.%01lu.", 
-           price >> FRACTION_BITS, (uint64_t)(price & FRACTION_MASK) * 10 / FRACTION_DIVISOR); 
-    print_if_error_introduced(1);
-    // 2 digits after decimal
-    printf("price (manual float, 2 digits after decimal) is %u.%02lu.", 
-           price >> FRACTION_BITS, (uint64_t)(price & FRACTION_MASK) * 100 / FRACTION_DIVISOR); 
-    print_if_error_introduced(2);
-    // 3 digits after decimal
-    printf("price (manual float, 3 digits after decimal) is %u.%03lu.", 
-           price >> FRACTION_BITS, (uint64_t)(price & FRACTION_MASK) * 1000 / FRACTION_DIVISOR); 
-    print_if_error_introduced(3);
-    // 4 digits after decimal
-    printf("price (manual float, 4 digits after decimal) is %u.%04lu.", 
-           price >> FRACTION_BITS, (uint64_t)(price & FRACTION_MASK) * 10000 / FRACTION_DIVISOR); 
-    print_if_error_introduced(4);
-    // 5 digits after decimal
-    printf("price (manual float, 5 digits after decimal) is %u.%05lu.", 
-           price >> FRACTION_BITS, (uint64_t)(price & FRACTION_MASK) * 100000 / FRACTION_DIVISOR); 
-    print_if_error_introduced(5);
-    // 6 digits after decimal
-    printf("price (manual float, 6 digits after decimal) is %u.%06lu.", 
-           price >> FRACTION_BITS, (uint64_t)(price & FRACTION_MASK) * 1000000 / FRACTION_DIVISOR); 
-    print_if_error_introduced(6);
+    for (uint8_t num_digits = 0; num_digits <= 6; num_digits++)
+    {
+        uint64_t digits = fixed_truncate_to_decimal(price, num_digits);
+        printf("price (manual float, %u digit%s after decimal) is %llu", num_digits, num_digits == 1 ? " " : "s",
+               (unsigned long long)(digits / fixed_pow10(num_digits)));
+        if (num_digits > 0)
+        {
+            printf(".%0*llu", (int)num_digits, (unsigned long long)(digits % fixed_pow10(num_digits)));
+        }
+        printf(".");
+        print_if_error_introduced(num_digits);
+    }
     printf("\n");
 
 
@@ -152,43 +147,52 @@ int main(int argc, char * argv[])
 
     printf("WITH MANUAL INTEGER-BASED ROUNDING:\n");
 
-    // Calculate addends used for rounding (see definition of "addend" above).
-    fixed_point_t addend0 = FRACTION_DIVISOR/2;
-    fixed_point_t addend1 = FRACTION_DIVISOR/20;
-    fixed_point_t addend2 = FRACTION_DIVISOR/200;
-    fixed_point_t addend3 = FRACTION_DIVISOR/2000;
-    fixed_point_t addend4 = FRACTION_DIVISOR/20000;
-    fixed_point_t addend5 = FRACTION_DIVISOR/200000;
-
-    // Print addends used for rounding.
-    printf("addend0 = %u.\n", addend0);
-    printf("addend1 = %u.\n", addend1);
-    printf("addend2 = %u.\n", addend2);
-    printf("addend3 = %u.\n", addend3);
-    printf("addend4 = %u.\n", addend4);
-    printf("addend5 = %u.\n", addend5);
-
-    // Calculate rounded prices
-    fixed_point_t price_rounded0 = price + addend0; // round to 0 decimal digits
-    fixed_point_t price_rounded1 = price + addend1; // round to 1 decimal digits
-    fixed_point_t price_rounded2 = price + addend2; // round to 2 decimal digits
-    fixed_point_t price_rounded3 = price + addend3; // round to 3 decimal digits
-    fixed_point_t price_rounded4 = price + addend4; // round to 4 decimal digits
-    fixed_point_t price_rounded5 = price + addend5; // round to 5 decimal digits
-
-    // Print manually rounded prices of manually-printed fixed point integers as though they were "floats".
-    printf("rounded price (manual float, rounded to 0 digits after decimal) is %u.\n", 
-           price_rounded0 >> FRACTION_BITS); 
-    printf("rounded price (manual float, rounded to 1 digit  after decimal) is %u.%01lu.\n", 
-           price_rounded1 >> FRACTION_BITS, (uint64_t)(price_rounded1 & FRACTION_MASK) * 10 / FRACTION_DIVISOR); 
-    printf("rounded price (manual float, rounded to 2 digits after decimal) is %u.%02lu.\n", 
-           price_rounded2 >> FRACTION_BITS, (uint64_t)(price_rounded2 & FRACTION_MASK) * 100 / FRACTION_DIVISOR); 
-    printf("rounded price (manual float, rounded to 3 digits after decimal) is %u.%03lu.\n", 
-           price_rounded3 >> FRACTION_BITS, (uint64_t)(price_rounded3 & FRACTION_MASK) * 1000 / FRACTION_DIVISOR); 
-    printf("rounded price (manual float, rounded to 4 digits after decimal) is %u.%04lu.\n", 
-           price_rounded4 >> FRACTION_BITS, (uint64_t)(price_rounded4 & FRACTION_MASK) * 10000 / FRACTION_DIVISOR); 
-    printf("rounded price (manual float, rounded to 5 digits after decimal) is %u.%05lu.\n", 
-           price_rounded5 >> FRACTION_BITS, (uint64_t)(price_rounded5 & FRACTION_MASK) * 100000 / FRACTION_DIVISOR); 
+    // Calculate addends used for rounding (see definition of "addend" above): fixed_round_addend(N) is
+    // FRACTION_DIVISOR/(2*10^N). Then print each rounded price like the manual "floats" above.
+    for (uint8_t num_digits = 0; num_digits <= 5; num_digits++)
+    {
+        printf("addend%u = %u.\n", num_digits, fixed_round_addend(num_digits));
+    }
+    for (uint8_t num_digits = 0; num_digits <= 5; num_digits++)
+    {
+        fixed_point_t price_rounded = price + fixed_round_addend(num_digits);
+        uint64_t digits = fixed_truncate_to_decimal(price_rounded, num_digits);
+        printf("rounded price (manual float, rounded to %u digit%s after decimal) is %llu", num_digits,
+               num_digits == 1 ? " " : "s", (unsigned long long)(digits / fixed_pow10(num_digits)));
+        if (num_digits > 0)
+        {
+            printf(".%0*llu", (int)num_digits, (unsigned long long)(digits % fixed_pow10(num_digits)));
+        }
+        printf(".\n");
+    }
+
+
+    // =================================================================================================================
+
+    printf("\nERROR-BOUND TRACKING:\n");
+
+    // Instead of comparing against the "true answer" double, let's have the fixed-point math itself tell us how wrong
+    // it could possibly be. Redo the exact same `price` math from above, but on an interval [lo, hi] which is 
+    // guaranteed to contain the true answer. Each operation rounds lo down and hi up. See "fixed_point_interval.h".
+    fixed_interval_t price_bounds = fixed_interval_exact(fixed_from_int(PRICE_ORIGINAL));
+    price_bounds = fixed_interval_add(price_bounds, fixed_interval_exact(fixed_from_int(10)));
+    price_bounds = fixed_interval_mul_int(price_bounds, 3);
+    price_bounds = fixed_interval_div_int(price_bounds, 7);
+    printf("price (multiply then divide) is in [%u/%u, %u/%u] (max error = %u/%u).\n", 
+           price_bounds.lo, FRACTION_DIVISOR, price_bounds.hi, FRACTION_DIVISOR, 
+           price_bounds.hi - price_bounds.lo, FRACTION_DIVISOR);
+    printf("  Certified exact to %u digits after the decimal (compare with where print_if_error_introduced() "
+           "says error starts).\n", fixed_interval_certain_digits(price_bounds, 9));
+
+    // Now divide *first*, then multiply. The error from the divide gets multiplied by 3 too.
+    price_bounds = fixed_interval_exact(fixed_from_int(PRICE_ORIGINAL));
+    price_bounds = fixed_interval_add(price_bounds, fixed_interval_exact(fixed_from_int(10)));
+    price_bounds = fixed_interval_div_int(price_bounds, 7);
+    price_bounds = fixed_interval_mul_int(price_bounds, 3);
+    printf("price (divide then multiply) is in [%u/%u, %u/%u] (max error = %u/%u).\n", 
+           price_bounds.lo, FRACTION_DIVISOR, price_bounds.hi, FRACTION_DIVISOR, 
+           price_bounds.hi - price_bounds.lo, FRACTION_DIVISOR);
+    printf("  Certified exact to %u digits after the decimal.\n", fixed_interval_certain_digits(price_bounds, 9));
 
 
     // =================================================================================================================
@@ -203,7 +207,8 @@ int main(int argc, char * argv[])
     // - These concepts are especially useful when you hit the limits of your architecture's integer types: ex: 
     //   if you have a uint64_t nanosecond timestamp that is really large, and you need to multiply it by a fraction
     //   to convert it, but you don't have uint128_t types available to you to multiply by the numerator before 
-    //   dividing by the denominator. What do you do?
+    //   dividing by the denominator. What do you do? ("fixed_point_time.h" puts the answer to work; see the
+    //   "TIMESTAMPS" section at the end of main().)
     // - We can use fixed-point math to achieve desired results. Let's look at various approaches.
     // - Let's say my goal is to multiply a number by a fraction < 1 withOUT it ever growing into a larger type.
     // - Essentially we want to multiply some really large number (near its range limit for its integer type)
@@ -535,6 +540,9 @@ int main(int argc, char * argv[])
     perfectly!  The only problem is that 1/2 is not a valid integer (it truncates to 0), so you must instead do it in
     the order of (a + b/2)/b, in order to make it all work out!
     */
+    // NB: it turns out (a + b/2)/b rounds correctly for odd b too, since a/b can only ever land *exactly* on .5
+    // when b is even. Its real limits are overflow of `a + b/2` and always rounding ties up. See the end of main()
+    // and "fixed_point_round.h".
 
     // - Looking at the rounding formula above, the highest *times* value I can use is calculated as follows:
     // max_num*times + divide/2 < 2^16
@@ -586,6 +594,64 @@ int main(int argc, char * argv[])
     printf("  num16_result = %u. <== Loses the fewest possible bits that right-shift out during the divide, \n"
            "  & has better accuracy due to rounding during the divide.\n", num16_result);
 
+    // The library version (see "fixed_point_ratio.h"): exact and rounded, for any times, divide, and width, with the
+    // setup done once into a plan on the stack.
+    fixed_ratio_plan_t ratio_plan;
+    fixed_ratio_plan_init(&ratio_plan, times, divide, 16);
+    printf("fixed_ratio_apply(): %u <== Exact, rounded to the nearest.\n",
+           (unsigned)fixed_ratio_apply(&ratio_plan, num16));
+
+    // =================================================================================================================
+
+    printf("\nROUNDING DIVISION, REVISITED (see \"fixed_point_round.h\"):\n");
+
+    // 1. Check the (a + b/2)/b rule against exact, remainder-based round-half-up, for odd AND even b.
+    uint32_t num_mismatches = 0;
+    for (uint32_t b = 1; b <= 255; b++)
+    {
+        for (uint32_t a = 0; a <= 65535; a++)
+        {
+            if ((a + b/2)/b != fixed_div_round_u32(a, b, FIXED_ROUND_HALF_UP))
+            {
+                num_mismatches++;
+            }
+        }
+    }
+    printf("(a + b/2)/b vs. exact round-half-up for all 16-bit a and all 8-bit b: %u mismatches.\n", num_mismatches);
+
+    // 2. But (a + b/2) can overflow.
+    uint32_t big_num = UINT32_MAX - 2;
+    printf("(a + b/2)/b with a = %u, b = 10: %u <== Wrong! a + b/2 overflowed.\n", big_num, (big_num + 10/2)/10);
+    printf("fixed_div_round_half_up_fast_u32(a, b): %u <== Right.\n", fixed_div_round_half_up_fast_u32(big_num, 10));
+
+    // 3. And ties always round up, whereas round-half-even splits them evenly between up and down.
+    printf("25/10 and 35/10 rounded half-up:   %u and %u.\n",
+           fixed_div_round_u32(25, 10, FIXED_ROUND_HALF_UP), fixed_div_round_u32(35, 10, FIXED_ROUND_HALF_UP));
+    printf("25/10 and 35/10 rounded half-even: %u and %u.\n",
+           fixed_div_round_u32(25, 10, FIXED_ROUND_HALF_EVEN), fixed_div_round_u32(35, 10, FIXED_ROUND_HALF_EVEN));
+
+    // =================================================================================================================
+
+    printf("\nTIMESTAMPS: SCALING A LARGE uint64_t NANOSECOND TIMESTAMP (see \"fixed_point_time.h\"):\n");
+
+    // Convert a nanosecond timestamp from around late 2023 to the ticks of a 19.2 MHz timer.
+    uint64_t timestamp_ns = 1700000000123456789ull;
+    fixed_clock_scaler_t ns_to_timer;
+    fixed_clock_scaler_init(&ns_to_timer, FIXED_TIME_NS_PER_SECOND, 19200000);
+    printf("timestamp: %llu ns\n", (unsigned long long)timestamp_ns);
+    printf("ns*19200000/1000000000:  %llu ticks <== Wrong! ns*19200000 overflowed.\n",
+           (unsigned long long)(timestamp_ns*19200000/FIXED_TIME_NS_PER_SECOND));
+    printf("ns/1000000000*19200000:  %llu ticks <== Wrong! Resolution was lost dividing first.\n",
+           (unsigned long long)(timestamp_ns/FIXED_TIME_NS_PER_SECOND*19200000));
+    printf("fixed_clock_scale():     %llu ticks <== Right, rounded to the nearest tick.\n",
+           (unsigned long long)fixed_clock_scale(&ns_to_timer, timestamp_ns));
+
+    // And as Q32.32 seconds, and back.
+    fixed_time_t timestamp = fixed_time_from_ns(timestamp_ns);
+    printf("as Q32.32 seconds: %llu + %llu/2^32 s; back to ns: %llu\n",
+           (unsigned long long)(timestamp >> FIXED_TIME_FRACTION_BITS),
+           (unsigned long long)(timestamp & FIXED_TIME_FRACTION_MASK), (unsigned long long)fixed_time_to_ns(timestamp));
+
     return 0;
 } // main
 
@@ -593,46 +659,21 @@ int main(int argc, char * argv[])
 
 /// @brief A function to help identify at what decimal digit error is introduced, based on how many bits you are using
 ///        to represent the fractional portion of the number in your fixed-point number system.
-/// @details    Note: this function relies on an internal static bool to keep track of if it has already
-///             identified at what decimal digit error is introduced, so once it prints this fact once, it will never 
-///             print again. This is by design just to simplify usage in this demo.
+/// @details    It prints its note only at the first digit with error: the one after fixed_resolution_digits() (see
+///             "fixed_point_format.h"). That takes no state to remember whether it already printed it, so it is safe
+///             to call from any thread, in any order.
 /// @param[in]  num_digits_after_decimal    The number of decimal digits we are printing after the decimal 
 ///             (0, 1, 2, 3, etc)
 /// @return     None
 static void print_if_error_introduced(uint8_t num_digits_after_decimal)
 {
-    static bool already_found = false;
-
-    // Array of power base 10 values, where the value = 10^index:
-    const uint32_t POW_BASE_10[] = 
+    if (num_digits_after_decimal == fixed_resolution_digits() + 1)
     {
-        1, // index 0 (10^0)
-        10, 
-        100, 
-        1000, 
-        10000, 
-        100000,
-        1000000,
-        10000000,
-        100000000,
-        1000000000, // index 9 (10^9); 1 Billion: the max power of 10 that can be stored in a uint32_t
-    };
-
-    if (already_found == true)
-    {
-        goto done;
-    }
-
-    if (POW_BASE_10[num_digits_after_decimal] > FRACTION_DIVISOR)
-    {
-        already_found = true;
         printf(" <== Fixed-point math decimal error first\n"
                "    starts to get introduced here since the fixed point resolution (1/%u) now has lower resolution\n"
                "    than the base-10 resolution (which is 1/%u) at this decimal place. Decimal error may not show\n"
                "    up at this decimal location, per say, but definitely will for all decimal places hereafter.", 
-               FRACTION_DIVISOR, POW_BASE_10[num_digits_after_decimal]);
+               FRACTION_DIVISOR, fixed_pow10(num_digits_after_decimal));
     }
-
-done:
     printf("\n");
 }
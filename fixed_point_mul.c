@@ -0,0 +1,358 @@
+/*
+fixed_point_mul
+- See fixed_point_mul.h.
+*/
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "fixed_point_mul.h"
+
+// Which fused operation a kernel does. The kernels are inlined into each public function with a constant `op`, so the
+// switches compile away.
+typedef enum mul_op_e
+{
+    MUL_ROUND,     // round(a*b)
+    MUL_ADD_ROUND, // round(c + a*b)
+    MUL_SUB_ROUND, // round(c - a*b)
+} mul_op_t;
+
+// -----------------------------------------------------------------------------------------------------------------
+// Q16.16
+// -----------------------------------------------------------------------------------------------------------------
+
+#if defined(__AVX2__)
+
+// 32x32 = 64-bit multiply of all 8 lanes, plus `addend`, then `>> FRACTION_BITS`, keeping the low 32 bits of each.
+// _mm256_mul_epu32() only multiplies the even lanes, so do the odd lanes separately and then blend them together.
+static __m256i mul_shift_epu32_x8(__m256i a, __m256i b, __m256i addend)
+{
+    __m256i even = _mm256_mul_epu32(a, b);
+    __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+    even = _mm256_srli_epi64(_mm256_add_epi64(even, addend), FRACTION_BITS);
+    // Shifting left by `32 - FRACTION_BITS` puts bits FRACTION_BITS and up in the high (odd) lane.
+    odd = _mm256_slli_epi64(_mm256_add_epi64(odd, addend), 32 - FRACTION_BITS);
+    return _mm256_blend_epi32(even, odd, 0xAA);
+}
+
+#elif defined(__SSE2__)
+
+// The SSE2 version of mul_shift_epu32_x8(): 4 lanes, and no blend instruction.
+static __m128i mul_shift_epu32_x4(__m128i a, __m128i b, __m128i addend)
+{
+    const __m128i LOW32 = _mm_set_epi32(0, -1, 0, -1);
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    even = _mm_srli_epi64(_mm_add_epi64(even, addend), FRACTION_BITS);
+    odd = _mm_slli_epi64(_mm_add_epi64(odd, addend), 32 - FRACTION_BITS);
+    return _mm_or_si128(_mm_and_si128(even, LOW32), _mm_andnot_si128(LOW32, odd));
+}
+
+#endif
+
+static inline void mul_batch(fixed_point_t * out, const fixed_point_t * a, const fixed_point_t * b,
+                             const fixed_point_t * c, size_t n, mul_op_t op)
+{
+    size_t i = 0;
+#if defined(__AVX2__)
+    // Rounding `c - a*b` half up is subtracting `a*b` rounded half down (see fixed_mul_sub_round()).
+    const __m256i ADDEND = _mm256_set1_epi64x(op == MUL_SUB_ROUND ? FRACTION_DIVISOR/2 - 1 : FRACTION_DIVISOR/2);
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i va = _mm256_loadu_si256((const __m256i *)(a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i *)(b + i));
+        __m256i product = mul_shift_epu32_x8(va, vb, ADDEND);
+        if (op != MUL_ROUND)
+        {
+            __m256i vc = _mm256_loadu_si256((const __m256i *)(c + i));
+            product = op == MUL_ADD_ROUND ? _mm256_add_epi32(vc, product) : _mm256_sub_epi32(vc, product);
+        }
+        _mm256_storeu_si256((__m256i *)(out + i), product);
+    }
+#elif defined(__SSE2__)
+    const __m128i ADDEND = _mm_set1_epi64x(op == MUL_SUB_ROUND ? FRACTION_DIVISOR/2 - 1 : FRACTION_DIVISOR/2);
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+        __m128i product = mul_shift_epu32_x4(va, vb, ADDEND);
+        if (op != MUL_ROUND)
+        {
+            __m128i vc = _mm_loadu_si128((const __m128i *)(c + i));
+            product = op == MUL_ADD_ROUND ? _mm_add_epi32(vc, product) : _mm_sub_epi32(vc, product);
+        }
+        _mm_storeu_si128((__m128i *)(out + i), product);
+    }
+#endif
+    for (; i < n; i++)
+    {
+        switch (op)
+        {
+            case MUL_ROUND:
+                out[i] = fixed_mul_round(a[i], b[i]);
+                break;
+            case MUL_ADD_ROUND:
+                out[i] = fixed_mul_add_round(a[i], b[i], c[i]);
+                break;
+            case MUL_SUB_ROUND:
+                out[i] = fixed_mul_sub_round(a[i], b[i], c[i]);
+                break;
+        }
+    }
+}
+
+void fixed_mul_round_batch(fixed_point_t * out, const fixed_point_t * a, const fixed_point_t * b, size_t n)
+{
+    mul_batch(out, a, b, NULL, n, MUL_ROUND);
+}
+
+void fixed_mul_add_round_batch(fixed_point_t * out, const fixed_point_t * a, const fixed_point_t * b,
+                               const fixed_point_t * c, size_t n)
+{
+    mul_batch(out, a, b, c, n, MUL_ADD_ROUND);
+}
+
+void fixed_mul_sub_round_batch(fixed_point_t * out, const fixed_point_t * a, const fixed_point_t * b,
+                               const fixed_point_t * c, size_t n)
+{
+    mul_batch(out, a, b, c, n, MUL_SUB_ROUND);
+}
+
+// -----------------------------------------------------------------------------------------------------------------
+// Q15
+//
+// `pmulhrsw` computes `(a*b + 2^14) >> 15`: the rounded product, in one instruction. The only product that doesn't
+// fit is -1 * -1 = +1, which comes out as INT16_MIN; no other product can round to INT16_MIN, so wherever the result
+// is INT16_MIN, it overflowed. The fused add and subtract then add or subtract the full +1 (as INT16_MAX, then 1 more)
+// with saturation.
+// -----------------------------------------------------------------------------------------------------------------
+
+#if defined(__AVX2__)
+
+static __m256i q15_op_x16(__m256i a, __m256i b, __m256i c, mul_op_t op)
+{
+    const __m256i MIN = _mm256_set1_epi16(INT16_MIN);
+    __m256i product = _mm256_mulhrs_epi16(a, b);
+    __m256i overflowed = _mm256_cmpeq_epi16(product, MIN);
+    // INT16_MIN ^ all bits set = INT16_MAX.
+    product = _mm256_xor_si256(product, overflowed);
+    switch (op)
+    {
+        case MUL_ROUND:
+        default:
+            return product;
+        case MUL_ADD_ROUND:
+            // `overflowed` is -1 where the product was really INT16_MAX + 1.
+            return _mm256_subs_epi16(_mm256_adds_epi16(c, product), overflowed);
+        case MUL_SUB_ROUND:
+        {
+            // Round the product half down instead: 1 less wherever it was exactly a tie (low 15 bits = 0x4000).
+            const __m256i LOW15 = _mm256_set1_epi16(0x7FFF);
+            const __m256i TIE = _mm256_set1_epi16(0x4000);
+            __m256i tie = _mm256_cmpeq_epi16(_mm256_and_si256(_mm256_mullo_epi16(a, b), LOW15), TIE);
+            product = _mm256_add_epi16(product, tie);
+            return _mm256_adds_epi16(_mm256_subs_epi16(c, product), overflowed);
+        }
+    }
+}
+
+#endif
+
+#if defined(__SSE2__)
+
+// `pmulhrsw`, emulated with 2 multiplies if it's not available (it's SSSE3): the low 16 bits of `floor(a*b/2^15)`,
+// plus bit 14 of a*b (the rounding bit).
+static __m128i mulhrs_epi16(__m128i a, __m128i b)
+{
+#if defined(__SSSE3__)
+    return _mm_mulhrs_epi16(a, b);
+#else
+    const __m128i ONE = _mm_set1_epi16(1);
+    __m128i low = _mm_mullo_epi16(a, b);
+    __m128i high = _mm_mulhi_epi16(a, b);
+    __m128i floor = _mm_or_si128(_mm_slli_epi16(high, 1), _mm_srli_epi16(low, 15));
+    return _mm_add_epi16(floor, _mm_and_si128(_mm_srli_epi16(low, 14), ONE));
+#endif
+}
+
+// The 8-lane version of q15_op_x16().
+static __m128i q15_op_x8(__m128i a, __m128i b, __m128i c, mul_op_t op)
+{
+    const __m128i MIN = _mm_set1_epi16(INT16_MIN);
+    __m128i product = mulhrs_epi16(a, b);
+    __m128i overflowed = _mm_cmpeq_epi16(product, MIN);
+    product = _mm_xor_si128(product, overflowed);
+    switch (op)
+    {
+        case MUL_ROUND:
+        default:
+            return product;
+        case MUL_ADD_ROUND:
+            return _mm_subs_epi16(_mm_adds_epi16(c, product), overflowed);
+        case MUL_SUB_ROUND:
+        {
+            const __m128i LOW15 = _mm_set1_epi16(0x7FFF);
+            const __m128i TIE = _mm_set1_epi16(0x4000);
+            __m128i tie = _mm_cmpeq_epi16(_mm_and_si128(_mm_mullo_epi16(a, b), LOW15), TIE);
+            product = _mm_add_epi16(product, tie);
+            return _mm_adds_epi16(_mm_subs_epi16(c, product), overflowed);
+        }
+    }
+}
+
+#endif
+
+static inline void q15_batch(fixed_q15_t * out, const fixed_q15_t * a, const fixed_q15_t * b, const fixed_q15_t * c,
+                             size_t n, mul_op_t op)
+{
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 16 <= n; i += 16)
+    {
+        __m256i va = _mm256_loadu_si256((const __m256i *)(a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i *)(b + i));
+        __m256i vc = op == MUL_ROUND ? _mm256_setzero_si256() : _mm256_loadu_si256((const __m256i *)(c + i));
+        _mm256_storeu_si256((__m256i *)(out + i), q15_op_x16(va, vb, vc, op));
+    }
+#endif
+#if defined(__SSE2__)
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+        __m128i vc = op == MUL_ROUND ? _mm_setzero_si128() : _mm_loadu_si128((const __m128i *)(c + i));
+        _mm_storeu_si128((__m128i *)(out + i), q15_op_x8(va, vb, vc, op));
+    }
+#endif
+    for (; i < n; i++)
+    {
+        switch (op)
+        {
+            case MUL_ROUND:
+                out[i] = fixed_q15_mul_round(a[i], b[i]);
+                break;
+            case MUL_ADD_ROUND:
+                out[i] = fixed_q15_mul_add_round(a[i], b[i], c[i]);
+                break;
+            case MUL_SUB_ROUND:
+                out[i] = fixed_q15_mul_sub_round(a[i], b[i], c[i]);
+                break;
+        }
+    }
+}
+
+void fixed_q15_mul_round_batch(fixed_q15_t * out, const fixed_q15_t * a, const fixed_q15_t * b, size_t n)
+{
+    q15_batch(out, a, b, NULL, n, MUL_ROUND);
+}
+
+void fixed_q15_mul_add_round_batch(fixed_q15_t * out, const fixed_q15_t * a, const fixed_q15_t * b,
+                                   const fixed_q15_t * c, size_t n)
+{
+    q15_batch(out, a, b, c, n, MUL_ADD_ROUND);
+}
+
+void fixed_q15_mul_sub_round_batch(fixed_q15_t * out, const fixed_q15_t * a, const fixed_q15_t * b,
+                                   const fixed_q15_t * c, size_t n)
+{
+    q15_batch(out, a, b, c, n, MUL_SUB_ROUND);
+}
+
+// -----------------------------------------------------------------------------------------------------------------
+// Q31
+//
+// Needs a signed 32x32 = 64-bit multiply, which SSE2 doesn't have, so only AVX2 gets a SIMD version. Every 64-bit sum
+// (`c*2^31 +- a*b + 2^30`) fits in an int64_t, and its `>> 31` fits in 32 bits exactly when its top 2 bits are equal.
+// -----------------------------------------------------------------------------------------------------------------
+
+#if defined(__AVX2__)
+
+// `c*2^31`, as 64 bits, from the 32-bit numbers in the even lanes of `c`. _mm256_mul_epi32() sign-extends them.
+static __m256i q31_widen_x4(__m256i c)
+{
+    return _mm256_slli_epi64(_mm256_mul_epi32(c, _mm256_set1_epi32(1)), FIXED_Q31_FRACTION_BITS);
+}
+
+static __m256i q31_sum_x4(__m256i a, __m256i b, __m256i c, mul_op_t op)
+{
+    const __m256i HALF = _mm256_set1_epi64x((int64_t)1 << 30);
+    __m256i product = _mm256_mul_epi32(a, b);
+    switch (op)
+    {
+        case MUL_ROUND:
+        default:
+            return _mm256_add_epi64(product, HALF);
+        case MUL_ADD_ROUND:
+            return _mm256_add_epi64(_mm256_add_epi64(q31_widen_x4(c), product), HALF);
+        case MUL_SUB_ROUND:
+            return _mm256_add_epi64(_mm256_sub_epi64(q31_widen_x4(c), product), HALF);
+    }
+}
+
+static __m256i q31_op_x8(__m256i a, __m256i b, __m256i c, mul_op_t op)
+{
+    const __m256i MAX = _mm256_set1_epi32(INT32_MAX);
+    __m256i even = q31_sum_x4(a, b, c, op);
+    __m256i odd = q31_sum_x4(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32), _mm256_srli_epi64(c, 32), op);
+    // Bits 31 to 62 of each sum: the result, if it fits.
+    __m256i result = _mm256_blend_epi32(_mm256_srli_epi64(even, 31), _mm256_slli_epi64(odd, 1), 0xAA);
+    // The high 32 bits of each sum. It fits if bits 63 and 62 are equal; if not, saturate toward bit 63's sign.
+    __m256i high = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+    __m256i overflowed = _mm256_srai_epi32(_mm256_xor_si256(high, _mm256_slli_epi32(high, 1)), 31);
+    __m256i saturated = _mm256_xor_si256(_mm256_srai_epi32(high, 31), MAX);
+    return _mm256_blendv_epi8(result, saturated, overflowed);
+}
+
+#endif
+
+static inline void q31_batch(fixed_q31_t * out, const fixed_q31_t * a, const fixed_q31_t * b, const fixed_q31_t * c,
+                             size_t n, mul_op_t op)
+{
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i va = _mm256_loadu_si256((const __m256i *)(a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i *)(b + i));
+        __m256i vc = op == MUL_ROUND ? _mm256_setzero_si256() : _mm256_loadu_si256((const __m256i *)(c + i));
+        _mm256_storeu_si256((__m256i *)(out + i), q31_op_x8(va, vb, vc, op));
+    }
+#endif
+    for (; i < n; i++)
+    {
+        switch (op)
+        {
+            case MUL_ROUND:
+                out[i] = fixed_q31_mul_round(a[i], b[i]);
+                break;
+            case MUL_ADD_ROUND:
+                out[i] = fixed_q31_mul_add_round(a[i], b[i], c[i]);
+                break;
+            case MUL_SUB_ROUND:
+                out[i] = fixed_q31_mul_sub_round(a[i], b[i], c[i]);
+                break;
+        }
+    }
+}
+
+void fixed_q31_mul_round_batch(fixed_q31_t * out, const fixed_q31_t * a, const fixed_q31_t * b, size_t n)
+{
+    q31_batch(out, a, b, NULL, n, MUL_ROUND);
+}
+
+void fixed_q31_mul_add_round_batch(fixed_q31_t * out, const fixed_q31_t * a, const fixed_q31_t * b,
+                                   const fixed_q31_t * c, size_t n)
+{
+    q31_batch(out, a, b, c, n, MUL_ADD_ROUND);
+}
+
+void fixed_q31_mul_sub_round_batch(fixed_q31_t * out, const fixed_q31_t * a, const fixed_q31_t * b,
+                                   const fixed_q31_t * c, size_t n)
+{
+    q31_batch(out, a, b, c, n, MUL_SUB_ROUND);
+}
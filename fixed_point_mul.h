@@ -0,0 +1,160 @@
+/*
+fixed_point_mul
+- Fused multiply-round operations for filter-style inner loops: `round(a*b)`, `round(c + a*b)`, and `round(c - a*b)`,
+  each widened, multiplied, rounded, and shifted back down in one step, so the sum or difference is only rounded once.
+  Done as separate C expressions, the compiler doesn't fuse them (and it can't round just once).
+- 3 formats:
+  - `fixed_point_t` (unsigned Q16.16, the tutorial's format): `(a*b + FRACTION_DIVISOR/2) >> FRACTION_BITS`. Like the
+    tutorial (and fixed_column_mul()), results that don't fit keep their low 32 bits.
+  - `fixed_q15_t` (signed Q1.15, 16 bits, in [-1, 1)) and `fixed_q31_t` (signed Q1.31, 32 bits, in [-1, 1)): the usual
+    DSP formats. Results *saturate* instead: ex: -1 * -1 = 1 doesn't fit, so it gives the largest number instead.
+- All of them round half up (toward +infinity), like the tutorial, and like the x86 `pmulhrsw` instruction.
+- The scalar functions are inline, below. The `_batch()` functions do whole arrays with SIMD when the compiler may use
+  it (ex: `-march=native`, or the FIXED_POINT_NATIVE CMake option):
+  - Q15: 16 numbers at a time with AVX2 (`vpmulhrsw`), or 8 with SSSE3 (`pmulhrsw`) or plain SSE2 (emulated).
+  - Q31: 8 at a time with AVX2 (`vpmuldq`).
+  - Q16.16: 8 at a time with AVX2, or 4 with SSE2 (`pmuludq`).
+- The scalar and batch versions give bit-identical results for every input. The scalar ones use no implementation-
+  defined behavior (no right-shifts of negative numbers), so they give the same results on every platform too.
+*/
+
+#ifndef FIXED_POINT_MUL_H
+#define FIXED_POINT_MUL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "fixed_point.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Signed Q1.15: `value / 2^15`, in [-1, 1).
+typedef int16_t fixed_q15_t;
+// Signed Q1.31: `value / 2^31`, in [-1, 1).
+typedef int32_t fixed_q31_t;
+
+#define FIXED_Q15_FRACTION_BITS 15
+#define FIXED_Q31_FRACTION_BITS 31
+
+// -----------------------------------------------------------------------------------------------------------------
+// Q16.16 (`fixed_point_t`). Results that don't fit keep their low 32 bits.
+// -----------------------------------------------------------------------------------------------------------------
+
+/// @brief      `a*b`, rounded half up to the nearest 1/FRACTION_DIVISOR.
+static inline FIXED_CONSTEXPR fixed_point_t fixed_mul_round(fixed_point_t a, fixed_point_t b)
+{
+    return (fixed_point_t)(((uint64_t)a * b + FRACTION_DIVISOR/2) >> FRACTION_BITS);
+}
+
+/// @brief      `c + a*b`, rounded half up. The same as `c + fixed_mul_round(a, b)`, since `c` needs no rounding.
+static inline FIXED_CONSTEXPR fixed_point_t fixed_mul_add_round(fixed_point_t a, fixed_point_t b, fixed_point_t c)
+{
+    return c + fixed_mul_round(a, b);
+}
+
+/// @brief      `c - a*b`, rounded half up, with just one rounding.
+/// @details    Rounding `c - a*b` half up is rounding `a*b` half *down* and then subtracting, so this differs from
+///             `c - fixed_mul_round(a, b)` when `a*b` lands exactly halfway between 2 fixed-point numbers.
+static inline FIXED_CONSTEXPR fixed_point_t fixed_mul_sub_round(fixed_point_t a, fixed_point_t b, fixed_point_t c)
+{
+    return c - (fixed_point_t)(((uint64_t)a * b + FRACTION_DIVISOR/2 - 1) >> FRACTION_BITS);
+}
+
+// -----------------------------------------------------------------------------------------------------------------
+// Q15. Results saturate to [INT16_MIN, INT16_MAX].
+// -----------------------------------------------------------------------------------------------------------------
+
+// `floor(x / 2^15)` for a rounded signed product (|x| <= 2^30 + 2^14). Biased to be non-negative first, since
+// right-shifting a negative number is implementation-defined in C.
+static inline FIXED_CONSTEXPR int32_t fixed_q15_floor_shift(int32_t x)
+{
+    return (int32_t)(((uint32_t)x + ((uint32_t)1 << 31)) >> FIXED_Q15_FRACTION_BITS) - (1 << (31 - 15));
+}
+
+static inline FIXED_CONSTEXPR fixed_q15_t fixed_q15_saturate(int32_t x)
+{
+    return (fixed_q15_t)(x > INT16_MAX ? INT16_MAX : x < INT16_MIN ? INT16_MIN : x);
+}
+
+/// @brief      `a*b`, rounded half up: exactly what `pmulhrsw` computes, except that -1 * -1 saturates to INT16_MAX.
+static inline FIXED_CONSTEXPR fixed_q15_t fixed_q15_mul_round(fixed_q15_t a, fixed_q15_t b)
+{
+    return fixed_q15_saturate(fixed_q15_floor_shift((int32_t)a * b + (1 << 14)));
+}
+
+/// @brief      `c + a*b`, rounded half up once, then saturated.
+static inline FIXED_CONSTEXPR fixed_q15_t fixed_q15_mul_add_round(fixed_q15_t a, fixed_q15_t b, fixed_q15_t c)
+{
+    return fixed_q15_saturate(c + fixed_q15_floor_shift((int32_t)a * b + (1 << 14)));
+}
+
+/// @brief      `c - a*b`, rounded half up once, then saturated.
+static inline FIXED_CONSTEXPR fixed_q15_t fixed_q15_mul_sub_round(fixed_q15_t a, fixed_q15_t b, fixed_q15_t c)
+{
+    return fixed_q15_saturate(c - fixed_q15_floor_shift((int32_t)a * b + (1 << 14) - 1));
+}
+
+// -----------------------------------------------------------------------------------------------------------------
+// Q31. Results saturate to [INT32_MIN, INT32_MAX].
+// -----------------------------------------------------------------------------------------------------------------
+
+// `floor(x / 2^31)` for a signed 64-bit product (at most 2^62 in magnitude), as a 64-bit number. Biased to be
+// non-negative first, like fixed_q15_floor_shift().
+static inline FIXED_CONSTEXPR int64_t fixed_q31_floor_shift(int64_t x)
+{
+    return (int64_t)(((uint64_t)x + ((uint64_t)1 << 63)) >> FIXED_Q31_FRACTION_BITS) - ((int64_t)1 << (63 - 31));
+}
+
+static inline FIXED_CONSTEXPR fixed_q31_t fixed_q31_saturate(int64_t x)
+{
+    return (fixed_q31_t)(x > INT32_MAX ? INT32_MAX : x < INT32_MIN ? INT32_MIN : x);
+}
+
+/// @brief      `a*b`, rounded half up, with -1 * -1 saturating to INT32_MAX. (ARM's `sqrdmulh`, but rounding half up.)
+static inline FIXED_CONSTEXPR fixed_q31_t fixed_q31_mul_round(fixed_q31_t a, fixed_q31_t b)
+{
+    return fixed_q31_saturate(fixed_q31_floor_shift((int64_t)a * b + ((int64_t)1 << 30)));
+}
+
+/// @brief      `c + a*b`, rounded half up once, then saturated.
+static inline FIXED_CONSTEXPR fixed_q31_t fixed_q31_mul_add_round(fixed_q31_t a, fixed_q31_t b, fixed_q31_t c)
+{
+    return fixed_q31_saturate(c + fixed_q31_floor_shift((int64_t)a * b + ((int64_t)1 << 30)));
+}
+
+/// @brief      `c - a*b`, rounded half up once, then saturated.
+static inline FIXED_CONSTEXPR fixed_q31_t fixed_q31_mul_sub_round(fixed_q31_t a, fixed_q31_t b, fixed_q31_t c)
+{
+    return fixed_q31_saturate(c - fixed_q31_floor_shift((int64_t)a * b + ((int64_t)1 << 30) - 1));
+}
+
+// -----------------------------------------------------------------------------------------------------------------
+// Batch versions: out[i] = the scalar function of a[i], b[i] (and c[i]), for i < n. No alignment is needed, and
+// `out` may be the same array as any input (ex: `acc` in `acc[i] += x[i]*h[i]`).
+// -----------------------------------------------------------------------------------------------------------------
+
+void fixed_mul_round_batch(fixed_point_t * out, const fixed_point_t * a, const fixed_point_t * b, size_t n);
+void fixed_mul_add_round_batch(fixed_point_t * out, const fixed_point_t * a, const fixed_point_t * b,
+                               const fixed_point_t * c, size_t n);
+void fixed_mul_sub_round_batch(fixed_point_t * out, const fixed_point_t * a, const fixed_point_t * b,
+                               const fixed_point_t * c, size_t n);
+
+void fixed_q15_mul_round_batch(fixed_q15_t * out, const fixed_q15_t * a, const fixed_q15_t * b, size_t n);
+void fixed_q15_mul_add_round_batch(fixed_q15_t * out, const fixed_q15_t * a, const fixed_q15_t * b,
+                                   const fixed_q15_t * c, size_t n);
+void fixed_q15_mul_sub_round_batch(fixed_q15_t * out, const fixed_q15_t * a, const fixed_q15_t * b,
+                                   const fixed_q15_t * c, size_t n);
+
+void fixed_q31_mul_round_batch(fixed_q31_t * out, const fixed_q31_t * a, const fixed_q31_t * b, size_t n);
+void fixed_q31_mul_add_round_batch(fixed_q31_t * out, const fixed_q31_t * a, const fixed_q31_t * b,
+                                   const fixed_q31_t * c, size_t n);
+void fixed_q31_mul_sub_round_batch(fixed_q31_t * out, const fixed_q31_t * a, const fixed_q31_t * b,
+                                   const fixed_q31_t * c, size_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIXED_POINT_MUL_H
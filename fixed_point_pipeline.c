@@ -0,0 +1,453 @@
+/*
+fixed_point_pipeline
+- See fixed_point_pipeline.h.
+- Every handoff between stages goes through one mutex and one condition variable. That is one lock per chunk per
+  stage, which is nothing next to converting (or reading, or writing) a whole chunk.
+*/
+
+// For pthreads, read()/write(), pipe(), and poll() when compiling with -std=c99.
+#define _POSIX_C_SOURCE 200112L
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "fixed_point_arena.h"
+#include "fixed_point_pipeline.h"
+
+#define DEFAULT_CHUNK_SIZE ((size_t)1 << 20)
+#define DEFAULT_QUEUE_DEPTH 4
+
+// One chunk's buffers. Chunk number `c` always goes in slot `c % queue_depth`.
+typedef struct pipeline_slot_s
+{
+    uint8_t * in;
+    size_t in_size;
+    uint8_t * out;
+    size_t out_size;
+    bool converted;
+} pipeline_slot_t;
+
+typedef struct pipeline_s
+{
+    const fixed_pipeline_config_t * config;
+    int in_fd;
+    int out_fd;
+    int wake_fds[2];        // a pipe: written to once on failure, to wake the reader if it's waiting for input
+    pipeline_slot_t * slots;
+
+    pthread_mutex_t lock;
+    pthread_cond_t changed; // broadcast whenever anything below changes
+    // Chunks read so far, taken by a worker so far, and written so far. A slot is free for the reader once the chunk
+    // before it in the slot has been written: ie: while num_read < num_written + queue_depth.
+    uint64_t num_read;
+    uint64_t num_claimed;
+    uint64_t num_written;
+    bool done_reading;
+    bool failed;
+    int error;              // the errno of the first failure, if it came with one
+    fixed_pipeline_stats_t stats;
+} pipeline_t;
+
+/// @brief      Fill in the defaults (see fixed_pipeline_config_t) for a `convert` function.
+void fixed_pipeline_config_init(fixed_pipeline_config_t * config, fixed_pipeline_convert_fn convert, void * context)
+{
+    config->convert = convert;
+    config->context = context;
+    config->chunk_size = DEFAULT_CHUNK_SIZE;
+    config->out_chunk_size = DEFAULT_CHUNK_SIZE;
+    config->record_size = 1;
+    config->delimiter = -1;
+    config->num_workers = 1;
+    config->queue_depth = DEFAULT_QUEUE_DEPTH;
+}
+
+// Stop every stage. The caller holds the lock.
+static void fail(pipeline_t * pipeline, int error)
+{
+    if (!pipeline->failed)
+    {
+        pipeline->failed = true;
+        pipeline->error = error;
+        // (The pipe is empty, so this can't block. If it fails anyway, the reader stops after its next read().)
+        const uint8_t wake = 1;
+        ssize_t ignored = write(pipeline->wake_fds[1], &wake, 1);
+        (void)ignored;
+    }
+    pthread_cond_broadcast(&pipeline->changed);
+}
+
+// read_once()'s result when it was only to check for input, and there is none yet.
+#define NOTHING_READY (SIZE_MAX - 1)
+
+// Read once, up to `size` bytes, after waiting for input (if `wait`; else only if some is ready right now). Returns
+// the number of bytes read: 0 at the end of the input, NOTHING_READY, or SIZE_MAX on error (with errno ECANCELED if
+// the pipeline failed first). Waits for the input with poll() rather than in read(), so that a pipe or socket with
+// nothing to read can't keep it from seeing the pipeline fail.
+static size_t read_once(const pipeline_t * pipeline, uint8_t * buffer, size_t size, bool wait)
+{
+    for (;;)
+    {
+        struct pollfd fds[2];
+        fds[0].fd = pipeline->in_fd;
+        fds[0].events = POLLIN;
+        fds[1].fd = pipeline->wake_fds[0];
+        fds[1].events = POLLIN;
+        int ready = poll(fds, 2, wait ? -1 : 0);
+        if (ready < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (ready < 0)
+        {
+            return SIZE_MAX;
+        }
+        if (fds[1].revents != 0)
+        {
+            errno = ECANCELED;
+            return SIZE_MAX;
+        }
+        if (ready == 0)
+        {
+            return NOTHING_READY;
+        }
+        ssize_t result = read(pipeline->in_fd, buffer, size);
+        if (result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        return result < 0 ? SIZE_MAX : (size_t)result;
+    }
+}
+
+static bool write_fully(int fd, const uint8_t * buffer, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t result = write(fd, buffer, size);
+        if (result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (result <= 0)
+        {
+            return false;
+        }
+        buffer += result;
+        size -= (size_t)result;
+    }
+    return true;
+}
+
+// Where a chunk of `size` bytes must end so that it holds only whole records. Returns 0 if there is no record
+// boundary in it yet (for a full chunk: a record longer than a chunk).
+static size_t record_boundary(const fixed_pipeline_config_t * config, const uint8_t * chunk, size_t size)
+{
+    if (config->delimiter >= 0)
+    {
+        for (size_t end = size; end > 0; end--)
+        {
+            if (chunk[end - 1] == (uint8_t)config->delimiter)
+            {
+                return end;
+            }
+        }
+        return 0;
+    }
+    return size - size % config->record_size;
+}
+
+// The reader stage. A chunk's partial last record is carried over into the start of the next chunk.
+static void * reader_main(void * arg)
+{
+    pipeline_t * pipeline = (pipeline_t *)arg;
+    const fixed_pipeline_config_t * config = pipeline->config;
+    uint8_t * carry = pipeline->slots[config->queue_depth].in;
+    size_t carry_size = 0;
+    bool at_end = false;
+
+    pthread_mutex_lock(&pipeline->lock);
+    while (!pipeline->failed && !at_end)
+    {
+        if (pipeline->num_read >= pipeline->num_written + config->queue_depth)
+        {
+            pipeline->stats.reader_stalls++;
+            while (!pipeline->failed && pipeline->num_read >= pipeline->num_written + config->queue_depth)
+            {
+                pthread_cond_wait(&pipeline->changed, &pipeline->lock);
+            }
+            continue;
+        }
+        pipeline_slot_t * slot = &pipeline->slots[pipeline->num_read % config->queue_depth];
+        pthread_mutex_unlock(&pipeline->lock);
+
+        // Fill the chunk until it's full or the input ends, but once it holds a whole record, only while there's
+        // more input to read right away: a pipe or socket that goes quiet mid-chunk gets what it sent converted now.
+        memcpy(slot->in, carry, carry_size);
+        size_t size = carry_size;
+        size_t end = 0; // where the chunk's last whole record ends (0: none yet)
+        size_t num_bytes = 0;
+        bool read_failed = false;
+        int error = 0;
+        while (size < config->chunk_size)
+        {
+            size_t result = read_once(pipeline, slot->in + size, config->chunk_size - size, end == 0);
+            if (result == NOTHING_READY)
+            {
+                break;
+            }
+            if (result == SIZE_MAX)
+            {
+                read_failed = true;
+                error = errno;
+                break;
+            }
+            if (result == 0)
+            {
+                at_end = true;
+                break;
+            }
+            size += result;
+            num_bytes += result;
+            end = record_boundary(config, slot->in, size);
+        }
+        if (!read_failed)
+        {
+            // At the end of the input, whatever is left is the last chunk, partial record and all.
+            slot->in_size = at_end ? size : end;
+            carry_size = size - slot->in_size;
+            memcpy(carry, slot->in + slot->in_size, carry_size);
+        }
+
+        pthread_mutex_lock(&pipeline->lock);
+        if (read_failed)
+        {
+            fail(pipeline, error);
+        }
+        else if (slot->in_size == 0 && !at_end)
+        {
+            fail(pipeline, EINVAL);
+        }
+        else if (slot->in_size > 0)
+        {
+            pipeline->stats.bytes_read += num_bytes;
+            pipeline->num_read++;
+            pthread_cond_broadcast(&pipeline->changed);
+        }
+    }
+    pipeline->done_reading = true;
+    pthread_cond_broadcast(&pipeline->changed);
+    pthread_mutex_unlock(&pipeline->lock);
+    return NULL;
+}
+
+// The converting stage: take the oldest chunk no other worker has taken yet.
+static void * worker_main(void * arg)
+{
+    pipeline_t * pipeline = (pipeline_t *)arg;
+    const fixed_pipeline_config_t * config = pipeline->config;
+
+    pthread_mutex_lock(&pipeline->lock);
+    for (;;)
+    {
+        if (!pipeline->failed && pipeline->num_claimed == pipeline->num_read && !pipeline->done_reading)
+        {
+            pipeline->stats.worker_stalls++;
+            while (!pipeline->failed && pipeline->num_claimed == pipeline->num_read && !pipeline->done_reading)
+            {
+                pthread_cond_wait(&pipeline->changed, &pipeline->lock);
+            }
+        }
+        if (pipeline->failed || pipeline->num_claimed == pipeline->num_read)
+        {
+            break;
+        }
+        pipeline_slot_t * slot = &pipeline->slots[pipeline->num_claimed++ % config->queue_depth];
+        pthread_mutex_unlock(&pipeline->lock);
+
+        size_t out_size = config->convert(config->context, slot->in, slot->in_size, slot->out, config->out_chunk_size);
+
+        pthread_mutex_lock(&pipeline->lock);
+        if (out_size > config->out_chunk_size)
+        {
+            fail(pipeline, ECANCELED);
+            break;
+        }
+        slot->out_size = out_size;
+        slot->converted = true;
+        pthread_cond_broadcast(&pipeline->changed);
+    }
+    pthread_mutex_unlock(&pipeline->lock);
+    return NULL;
+}
+
+// Whether the writer has something to do: write the next chunk, or stop. The caller holds the lock.
+static bool writer_can_go(const pipeline_t * pipeline)
+{
+    const pipeline_slot_t * slot = &pipeline->slots[pipeline->num_written % pipeline->config->queue_depth];
+    return pipeline->failed || (pipeline->done_reading && pipeline->num_written == pipeline->num_read)
+        || (pipeline->num_written < pipeline->num_read && slot->converted);
+}
+
+// The writing stage, which runs on the calling thread: write each chunk once it's converted, in order.
+static void run_writer(pipeline_t * pipeline)
+{
+    const fixed_pipeline_config_t * config = pipeline->config;
+
+    pthread_mutex_lock(&pipeline->lock);
+    for (;;)
+    {
+        if (!writer_can_go(pipeline))
+        {
+            pipeline->stats.writer_stalls++;
+            while (!writer_can_go(pipeline))
+            {
+                pthread_cond_wait(&pipeline->changed, &pipeline->lock);
+            }
+        }
+        if (pipeline->failed || pipeline->num_written == pipeline->num_read)
+        {
+            break;
+        }
+        pipeline_slot_t * slot = &pipeline->slots[pipeline->num_written % config->queue_depth];
+        pthread_mutex_unlock(&pipeline->lock);
+
+        bool written = write_fully(pipeline->out_fd, slot->out, slot->out_size);
+        int error = errno;
+
+        pthread_mutex_lock(&pipeline->lock);
+        if (!written)
+        {
+            fail(pipeline, error);
+            break;
+        }
+        pipeline->stats.bytes_written += slot->out_size;
+        pipeline->stats.num_chunks++;
+        slot->converted = false;
+        pipeline->num_written++;
+        pthread_cond_broadcast(&pipeline->changed);
+    }
+    pthread_mutex_unlock(&pipeline->lock);
+}
+
+/// @brief      Convert everything from `in_fd` (until it ends) into `out_fd`, chunk by chunk, with reading,
+///             converting, and writing overlapped.
+/// @param[out] stats   Optional (may be NULL). Filled in whether or not it succeeds.
+/// @return     false if the config is invalid, memory or threads couldn't be had, reading or writing failed (errno
+///             says why), a record was longer than a chunk (errno is EINVAL), or `convert` returned SIZE_MAX (errno is
+///             ECANCELED).
+bool fixed_pipeline_run(const fixed_pipeline_config_t * config, int in_fd, int out_fd, fixed_pipeline_stats_t * stats)
+{
+    if (stats != NULL)
+    {
+        memset(stats, 0, sizeof(*stats));
+    }
+    if (config->convert == NULL || config->chunk_size == 0 || config->out_chunk_size == 0
+        || config->record_size == 0 || config->record_size > config->chunk_size || config->delimiter > 255
+        || config->num_workers == 0 || config->num_workers > FIXED_PIPELINE_MAX_WORKERS || config->queue_depth == 0)
+    {
+        errno = EINVAL;
+        return false;
+    }
+
+    // One allocation for everything: the slots, then each slot's buffers, plus one more input buffer (the last
+    // "slot") for the reader to carry partial records over in.
+    size_t num_slots = config->queue_depth + 1;
+    size_t slots_size = num_slots*sizeof(pipeline_slot_t);
+    size_t buffer_size = config->chunk_size + FIXED_ARENA_ALIGNMENT + config->out_chunk_size + FIXED_ARENA_ALIGNMENT;
+    if (buffer_size < config->chunk_size || (SIZE_MAX - slots_size - FIXED_ARENA_ALIGNMENT) / num_slots < buffer_size)
+    {
+        errno = ENOMEM;
+        return false;
+    }
+    fixed_arena_t arena;
+    if (!fixed_arena_init(&arena, slots_size + FIXED_ARENA_ALIGNMENT + num_slots*buffer_size))
+    {
+        errno = ENOMEM;
+        return false;
+    }
+
+    pipeline_t pipeline;
+    memset(&pipeline, 0, sizeof(pipeline));
+    pipeline.config = config;
+    pipeline.in_fd = in_fd;
+    pipeline.out_fd = out_fd;
+    pipeline.slots = (pipeline_slot_t *)fixed_arena_alloc(&arena, slots_size, 0);
+    for (size_t i = 0; i < num_slots; i++)
+    {
+        pipeline.slots[i].in = (uint8_t *)fixed_arena_alloc(&arena, config->chunk_size, 0);
+        pipeline.slots[i].out = (uint8_t *)fixed_arena_alloc(&arena, config->out_chunk_size, 0);
+        pipeline.slots[i].converted = false;
+    }
+    if (pipe(pipeline.wake_fds) != 0)
+    {
+        fixed_arena_free(&arena);
+        return false;
+    }
+    if (pthread_mutex_init(&pipeline.lock, NULL) != 0)
+    {
+        close(pipeline.wake_fds[0]);
+        close(pipeline.wake_fds[1]);
+        fixed_arena_free(&arena);
+        errno = ENOMEM;
+        return false;
+    }
+    if (pthread_cond_init(&pipeline.changed, NULL) != 0)
+    {
+        pthread_mutex_destroy(&pipeline.lock);
+        close(pipeline.wake_fds[0]);
+        close(pipeline.wake_fds[1]);
+        fixed_arena_free(&arena);
+        errno = ENOMEM;
+        return false;
+    }
+
+    // If a thread can't be started, stop the ones that were, so they can all be joined.
+    pthread_t reader;
+    pthread_t workers[FIXED_PIPELINE_MAX_WORKERS];
+    unsigned num_workers = 0;
+    int error = pthread_create(&reader, NULL, reader_main, &pipeline);
+    bool reader_started = error == 0;
+    while (error == 0 && num_workers < config->num_workers)
+    {
+        error = pthread_create(&workers[num_workers], NULL, worker_main, &pipeline);
+        num_workers += error == 0;
+    }
+    if (error != 0)
+    {
+        pthread_mutex_lock(&pipeline.lock);
+        fail(&pipeline, error);
+        pthread_mutex_unlock(&pipeline.lock);
+    }
+    else
+    {
+        run_writer(&pipeline);
+    }
+
+    if (reader_started)
+    {
+        pthread_join(reader, NULL);
+    }
+    for (unsigned i = 0; i < num_workers; i++)
+    {
+        pthread_join(workers[i], NULL);
+    }
+    pthread_cond_destroy(&pipeline.changed);
+    pthread_mutex_destroy(&pipeline.lock);
+    close(pipeline.wake_fds[0]);
+    close(pipeline.wake_fds[1]);
+    fixed_arena_free(&arena);
+
+    if (stats != NULL)
+    {
+        *stats = pipeline.stats;
+    }
+    if (pipeline.failed)
+    {
+        errno = pipeline.error;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,76 @@
+/*
+fixed_point_pipeline
+- Bulk, file-to-file conversion jobs (ex: formatting a column of `fixed_point_t` to text, parsing it back, or
+  rescaling it) as a 3-stage pipeline, so reading, converting, and writing all happen at the same time instead of
+  taking turns:
+  - a reader thread fills chunk buffers from the input file descriptor,
+  - 1 or more worker threads run your conversion function on whole chunks (each into its own output buffer), and
+  - the calling thread writes the converted chunks to the output file descriptor, in their original order.
+- The queue between the stages is bounded: `queue_depth` chunks in flight, each with a fixed-size input and output
+  buffer, allocated once up front. When the writer (or the disk) falls behind, the reader blocks instead of reading
+  further ahead (backpressure), so memory use is fixed no matter how big the files are.
+- Chunks always end on a record boundary (a multiple of `record_size` bytes, or just after a `delimiter` byte, ex:
+  '\n' for one number per line), so every chunk can be converted on its own, by any worker.
+- Plain blocking read() and write() calls, one thread per file descriptor, so it works for files, pipes, and sockets
+  alike. The reader waits for input in poll(), along with a wakeup pipe, so if converting or writing fails, the run
+  stops right away even while the input is a pipe or socket with nothing to read.
+- A chunk is handed on when it's full, at the end of the input, or as soon as the input has nothing more to read
+  right now and the chunk holds at least one whole record: a pipe or socket that sends a few records and goes quiet
+  gets them converted and written then, not when a whole chunk has built up.
+*/
+
+#ifndef FIXED_POINT_PIPELINE_H
+#define FIXED_POINT_PIPELINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "fixed_point.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FIXED_PIPELINE_MAX_WORKERS 64
+
+/// @brief      Convert one chunk. Called from the worker threads, possibly for several chunks at once, so it must be
+///             thread-safe.
+/// @param[in]  in          `in_size` bytes of whole records. Only the last chunk of the input can end in a partial
+///                         record (if the input itself does).
+/// @param[out] out         Room for `out_capacity` bytes (the config's `out_chunk_size`).
+/// @return     The number of bytes written to `out`, or SIZE_MAX to stop the pipeline with an error.
+typedef size_t (*fixed_pipeline_convert_fn)(void * context, const uint8_t * in, size_t in_size, uint8_t * out,
+                                            size_t out_capacity);
+
+// Set up with fixed_pipeline_config_init(), then change what you need.
+typedef struct fixed_pipeline_config_s
+{
+    fixed_pipeline_convert_fn convert;
+    void * context;            // passed to `convert`
+    size_t chunk_size;         // the most input bytes per chunk (default 1 MiB)
+    size_t out_chunk_size;     // the most output bytes `convert` may write per chunk (default: chunk_size)
+    size_t record_size;        // chunks hold a whole number of records this size (default 1: any size)
+    int delimiter;             // or, if 0 to 255: records end in this byte, and chunks end just after one (default -1)
+    unsigned num_workers;      // converting threads, 1 to FIXED_PIPELINE_MAX_WORKERS (default 1)
+    unsigned queue_depth;      // chunks in flight (default 4). Memory used: queue_depth*(chunk_size + out_chunk_size)
+} fixed_pipeline_config_t;
+
+// Where the time went, to tell which stage is the bottleneck.
+typedef struct fixed_pipeline_stats_s
+{
+    uint64_t bytes_read;
+    uint64_t bytes_written;
+    uint64_t num_chunks;
+    uint64_t reader_stalls;    // times the reader waited for a free buffer: the workers or the writer are slower
+    uint64_t worker_stalls;    // times a worker waited for a chunk to convert: the reader is slower
+    uint64_t writer_stalls;    // times the writer waited for the next chunk to be converted
+} fixed_pipeline_stats_t;
+
+void fixed_pipeline_config_init(fixed_pipeline_config_t * config, fixed_pipeline_convert_fn convert, void * context);
+bool fixed_pipeline_run(const fixed_pipeline_config_t * config, int in_fd, int out_fd, fixed_pipeline_stats_t * stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIXED_POINT_PIPELINE_H
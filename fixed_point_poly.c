@@ -0,0 +1,74 @@
+/*
+fixed_point_poly
+- See fixed_point_poly.h.
+*/
+
+#include "fixed_point_poly.h"
+
+/// @brief      Plan a polynomial at run time; see fixed_poly_plan().
+/// @return     false if it can't be planned (`poly->valid` is then false too, and fixed_poly_eval() returns 0).
+bool fixed_poly_init(fixed_poly_t * poly, const double * coefficients, uint8_t degree, fixed_point_t x_max,
+                     int8_t out_fraction_bits, fixed_poly_scheme_t scheme)
+{
+    *poly = fixed_poly_plan(coefficients, degree, x_max, out_fraction_bits, scheme);
+    return poly->valid;
+}
+
+// One Horner step, `coefficient + fixed_poly_round_shift(acc*x, shift)`, with the shift's rounding constants worked
+// out ahead of time: the rounded shift is `(biased >> shift) - offset`, plus 1 if `biased & half`, where `biased` is
+// the product with its sign bit flipped. (The shift must be less than 64.)
+static inline int64_t horner_step(int64_t acc, fixed_point_t x, int64_t coefficient, uint8_t shift, uint64_t half,
+                                  uint64_t offset)
+{
+    // |acc| < 2^31 and x < 2^32, so the product fits.
+    uint64_t biased = (uint64_t)(acc * (int64_t)x) ^ ((uint64_t)1 << 63);
+    return coefficient + (int64_t)((biased >> shift) - offset + ((biased & half) != 0));
+}
+
+/// @brief      Evaluate a planned polynomial at `n` points: out[i] = fixed_poly_eval(poly, x[i]).
+/// @details    Each Horner evaluation is one long chain of dependent multiplies, so on its own it leaves the CPU idle
+///             while each multiply finishes. Here 4 values' chains run side by side, so their multiplies overlap, and
+///             each step's rounding constants are worked out once per call instead of once per value. (Estrin order
+///             already has that overlap within a single value.)
+void fixed_poly_eval_batch(const fixed_poly_t * poly, const fixed_point_t * x, int32_t * out, size_t n)
+{
+    size_t i = 0;
+    bool batch = poly->valid && poly->scheme == FIXED_POLY_HORNER;
+    uint64_t halves[FIXED_POLY_MAX_DEGREE];
+    uint64_t offsets[FIXED_POLY_MAX_DEGREE];
+    for (int k = 0; batch && k < poly->degree; k++)
+    {
+        uint8_t shift = poly->product_shifts[k];
+        // Shifts of 64 (everything rounds to 0) are rare enough to leave to fixed_poly_eval().
+        batch = shift < 64;
+        halves[k] = shift == 0 ? 0 : (uint64_t)1 << (shift - 1);
+        offsets[k] = (uint64_t)1 << (63 - shift % 64);
+    }
+    if (batch)
+    {
+        for (; i + 4 <= n; i += 4)
+        {
+            int64_t acc0 = poly->coefficients[poly->degree];
+            int64_t acc1 = acc0;
+            int64_t acc2 = acc0;
+            int64_t acc3 = acc0;
+            for (int k = poly->degree - 1; k >= 0; k--)
+            {
+                int64_t coefficient = poly->coefficients[k];
+                uint8_t shift = poly->product_shifts[k];
+                acc0 = horner_step(acc0, x[i], coefficient, shift, halves[k], offsets[k]);
+                acc1 = horner_step(acc1, x[i + 1], coefficient, shift, halves[k], offsets[k]);
+                acc2 = horner_step(acc2, x[i + 2], coefficient, shift, halves[k], offsets[k]);
+                acc3 = horner_step(acc3, x[i + 3], coefficient, shift, halves[k], offsets[k]);
+            }
+            out[i] = fixed_poly_finish(poly, acc0);
+            out[i + 1] = fixed_poly_finish(poly, acc1);
+            out[i + 2] = fixed_poly_finish(poly, acc2);
+            out[i + 3] = fixed_poly_finish(poly, acc3);
+        }
+    }
+    for (; i < n; i++)
+    {
+        out[i] = fixed_poly_eval(poly, x[i]);
+    }
+}
@@ -0,0 +1,472 @@
+/*
+fixed_point_poly
+- Fixed-point polynomial evaluation (ex: an ADC calibration curve, c0 + c1*x + c2*x^2 + ...) from floating-point
+  coefficients, with every shift picked automatically instead of by hand.
+- Planning (`fixed_poly_plan()`) quantizes each coefficient, and picks a Q format for every intermediate result: as
+  many fraction bits as it can have without its worst case (over every x in [0, x_max]) overflowing 32 bits. This is
+  the range-vs-resolution trade-off from the tutorial, made separately for each stage instead of once for the whole
+  calculation. It also computes a bound on the total rounding error.
+- Evaluating is then just 32x32 = 64-bit multiplies, adds, and rounding shifts (each with the tutorial's `+ 1/2`
+  rounding addend), either in Horner order (fewest operations) or Estrin order (the same work split into independent
+  halves, so a CPU can overlap them). fixed_poly_eval_batch() evaluates a whole array, running 4 values' Horner chains
+  side by side for the same overlap.
+- In C++, fixed_poly_plan() is constexpr, so the coefficients are quantized and the shifts picked at compile time;
+  and (in C++17 and later) `fixed_poly_eval_static<plan>(x)` compiles to a fully unrolled evaluator with the
+  coefficients and shifts as immediate constants.
+- x is an (unsigned) fixed_point_t. Results are signed, in a Q format of the caller's choosing, and saturate to the
+  int32_t range.
+*/
+
+#ifndef FIXED_POINT_POLY_H
+#define FIXED_POINT_POLY_H
+
+#include <stddef.h>
+
+#include "fixed_point.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FIXED_POLY_MAX_DEGREE 7
+// The range of fraction bits an intermediate result may be given. Negative means the value is stored divided by a
+// power of 2 (ex: x^4 for large x); many means it is tiny (ex: the x^7 coefficient for x up to 4095).
+#define FIXED_POLY_MIN_FRACTION_BITS (-31)
+#define FIXED_POLY_MAX_FRACTION_BITS 96
+
+typedef enum fixed_poly_scheme_e
+{
+    // ((c3*x + c2)*x + c1)*x + c0: one multiply-add per degree, each waiting on the one before.
+    FIXED_POLY_HORNER = 0,
+    // (c0 + c1*x) + (c2 + c3*x)*x^2: the pairs are independent, so they can run at the same time.
+    FIXED_POLY_ESTRIN,
+} fixed_poly_scheme_t;
+
+// A planned polynomial. Fill it in with fixed_poly_plan() or fixed_poly_init().
+typedef struct fixed_poly_s
+{
+    bool valid;                // false if planning failed (see fixed_poly_plan())
+    uint8_t degree;
+    uint8_t scheme;            // a fixed_poly_scheme_t
+    uint8_t num_levels;        // Estrin only: the number of pairing levels (0 to 3)
+    int8_t out_fraction_bits;
+    int8_t result_shift;       // from the last step's format to the output's: > 0 shifts right, < 0 left
+    // The coefficients, each quantized to the format of the step it is used in. Estrin pads them with zeros to a
+    // power of 2.
+    int32_t coefficients[FIXED_POLY_MAX_DEGREE + 1];
+    // Per step: how far to shift the product right, and (Estrin) the addend.
+    // Horner: step k is `acc = coefficients[k] + (acc*x >> product_shifts[k])`, for k from degree - 1 down to 0.
+    // Estrin: all of level 0's pairs, then level 1's, etc. Level 0's are
+    // `coefficients[2i] + (coefficients[2i + 1]*x >> product_shifts[i])`, and later levels add pairs of the previous
+    // level's results the same way, using x^2, x^4, ... (`power = power*power >> power_shifts[level - 1]`).
+    uint8_t product_shifts[FIXED_POLY_MAX_DEGREE];
+    uint8_t addend_shifts[FIXED_POLY_MAX_DEGREE];
+    uint8_t power_shifts[2];
+    // The most the result can differ from the exact polynomial (of the unquantized coefficients) over [0, x_max],
+    // in units of the output's last bit, not counting the final rounding to the output format.
+    double error_bound;
+} fixed_poly_t;
+
+bool fixed_poly_init(fixed_poly_t * poly, const double * coefficients, uint8_t degree, fixed_point_t x_max,
+                     int8_t out_fraction_bits, fixed_poly_scheme_t scheme);
+void fixed_poly_eval_batch(const fixed_poly_t * poly, const fixed_point_t * x, int32_t * out, size_t n);
+
+// -----------------------------------------------------------------------------------------------------------------
+// Planning. Every function here is constexpr in C++, so only uses what constexpr allows (no library calls, and every
+// variable initialized).
+// -----------------------------------------------------------------------------------------------------------------
+
+// One value's worst case while planning: |value| <= bound, |computed - exact| <= error, stored with fraction_bits.
+typedef struct fixed_poly_range_s
+{
+    double bound;
+    double error;
+    int fraction_bits;
+} fixed_poly_range_t;
+
+static inline FIXED_CONSTEXPR double fixed_poly_pow2(int exponent)
+{
+    double result = 1.0;
+    for (; exponent > 0; exponent--)
+    {
+        result *= 2.0;
+    }
+    for (; exponent < 0; exponent++)
+    {
+        result *= 0.5;
+    }
+    return result;
+}
+
+static inline FIXED_CONSTEXPR double fixed_poly_abs(double value)
+{
+    return value < 0 ? -value : value;
+}
+
+/// @brief      The most fraction bits (up to `max_bits`) that a value of up to `magnitude` can be stored with, as an
+///             integer whose magnitude stays under `limit` (2^31 for signed, 2^32 for unsigned), with a little room
+///             left for the rounding done while computing it.
+/// @return     The fraction bits, or FIXED_POLY_MIN_FRACTION_BITS - 1 if not even the fewest fit.
+static inline FIXED_CONSTEXPR int fixed_poly_fraction_bits(double magnitude, int max_bits, double limit)
+{
+    int bits = max_bits < FIXED_POLY_MAX_FRACTION_BITS ? max_bits : FIXED_POLY_MAX_FRACTION_BITS;
+    double scaled = magnitude * fixed_poly_pow2(bits);
+    while (bits >= FIXED_POLY_MIN_FRACTION_BITS && scaled + 2.0 >= limit)
+    {
+        bits--;
+        scaled *= 0.5;
+    }
+    return bits;
+}
+
+/// @brief      round(value * 2^fraction_bits), with ties away from zero. `value * 2^fraction_bits` must be under
+///             2^31 in magnitude (fixed_poly_fraction_bits() makes sure of that).
+static inline FIXED_CONSTEXPR int32_t fixed_poly_quantize(double value, int fraction_bits)
+{
+    double scaled = fixed_poly_abs(value) * fixed_poly_pow2(fraction_bits);
+    int64_t truncated = (int64_t)scaled;
+    // Exact, since `scaled` < 2^31 has its integer part in `truncated`.
+    truncated += scaled - (double)truncated >= 0.5;
+    return (int32_t)(value < 0 ? -truncated : truncated);
+}
+
+/// @brief      Plan one multiply-add step, `addend + a*b`, where `addend` is a coefficient quantized to this step's
+///             format if `addend_is_coefficient`, or else an earlier step's result.
+/// @return     The result's range; its fraction_bits are below FIXED_POLY_MIN_FRACTION_BITS if it can't be planned.
+static inline FIXED_CONSTEXPR fixed_poly_range_t fixed_poly_plan_step(fixed_poly_range_t a, fixed_poly_range_t b,
+                                                                      fixed_poly_range_t addend,
+                                                                      bool addend_is_coefficient,
+                                                                      uint8_t * product_shift, uint8_t * addend_shift)
+{
+    fixed_poly_range_t result = {0.0, 0.0, 0};
+    result.bound = addend.bound + a.bound * b.bound;
+    // Errors carried in from the inputs; this step's own rounding is added below, once its format is known.
+    double carried = a.error * b.bound + a.bound * b.error + a.error * b.error;
+    int max_bits = a.fraction_bits + b.fraction_bits;
+    if (!addend_is_coefficient)
+    {
+        carried += addend.error;
+        // More fraction bits than the addend has would not add any precision.
+        max_bits = addend.fraction_bits < max_bits ? addend.fraction_bits : max_bits;
+    }
+    result.fraction_bits = fixed_poly_fraction_bits(result.bound + carried, max_bits, 2147483648.0);
+    // Rounding the product, and either quantizing the coefficient or rounding the addend: up to 1/2 unit each.
+    result.error = carried + fixed_poly_pow2(-result.fraction_bits);
+    // A shift of 64 or more (ex: a tiny term next to a big one) always rounds to 0, so they all become 64.
+    int shift = a.fraction_bits + b.fraction_bits - result.fraction_bits;
+    *product_shift = (uint8_t)(shift < 64 ? shift : 64);
+    shift = addend_is_coefficient ? 0 : addend.fraction_bits - result.fraction_bits;
+    *addend_shift = (uint8_t)(shift < 64 ? shift : 64);
+    return result;
+}
+
+/// @brief      The range of a coefficient quantized with as many fraction bits as fit.
+static inline FIXED_CONSTEXPR fixed_poly_range_t fixed_poly_coefficient_range(double coefficient)
+{
+    fixed_poly_range_t range = {0.0, 0.0, 0};
+    range.bound = fixed_poly_abs(coefficient);
+    range.fraction_bits = fixed_poly_fraction_bits(range.bound, FIXED_POLY_MAX_FRACTION_BITS, 2147483648.0);
+    range.error = coefficient == 0 ? 0.0 : 0.5 * fixed_poly_pow2(-range.fraction_bits);
+    return range;
+}
+
+/// @brief      Plan the evaluation of `coefficients[0] + coefficients[1]*x + ... + coefficients[degree]*x^degree`
+///             for every x from 0 to `x_max`, with a result in Q(32 - out_fraction_bits).(out_fraction_bits).
+/// @details    The plan is invalid (`valid` false) if the degree is over FIXED_POLY_MAX_DEGREE, or if some
+///             intermediate result can't fit in 32 bits even with FIXED_POLY_MIN_FRACTION_BITS (ex: huge
+///             coefficients, or a high-degree Estrin power of a large x_max). Results that don't fit the output
+///             format saturate, and don't make the plan invalid.
+static inline FIXED_CONSTEXPR fixed_poly_t fixed_poly_plan(const double * coefficients, uint8_t degree,
+                                                           fixed_point_t x_max, int8_t out_fraction_bits,
+                                                           fixed_poly_scheme_t scheme)
+{
+    fixed_poly_t poly = {false, 0, 0, 0, 0, 0, {0}, {0}, {0}, {0}, 0.0};
+    poly.degree = degree;
+    poly.scheme = (uint8_t)scheme;
+    poly.out_fraction_bits = out_fraction_bits;
+    if (degree > FIXED_POLY_MAX_DEGREE)
+    {
+        return poly;
+    }
+    for (int k = 0; k <= degree; k++)
+    {
+        // Also catches infinities and NaNs.
+        if (!(fixed_poly_abs(coefficients[k]) <= 1e300))
+        {
+            return poly;
+        }
+    }
+    fixed_poly_range_t x = {(double)x_max / FRACTION_DIVISOR, 0.0, FRACTION_BITS};
+    fixed_poly_range_t result = fixed_poly_coefficient_range(coefficients[degree]);
+    bool valid = true;
+
+    if (scheme == FIXED_POLY_HORNER)
+    {
+        poly.coefficients[degree] = fixed_poly_quantize(coefficients[degree], result.fraction_bits);
+        for (int k = degree - 1; k >= 0; k--)
+        {
+            fixed_poly_range_t addend = {fixed_poly_abs(coefficients[k]), 0.0, 0};
+            uint8_t unused_shift = 0;
+            result = fixed_poly_plan_step(result, x, addend, true, &poly.product_shifts[k], &unused_shift);
+            valid = valid && result.fraction_bits >= FIXED_POLY_MIN_FRACTION_BITS;
+            poly.coefficients[k] = valid ? fixed_poly_quantize(coefficients[k], result.fraction_bits) : 0;
+        }
+    }
+    else
+    {
+        int num_terms = 1;
+        while (num_terms < degree + 1)
+        {
+            num_terms *= 2;
+            poly.num_levels++;
+        }
+        fixed_poly_range_t nodes[FIXED_POLY_MAX_DEGREE + 1] = {{0.0, 0.0, 0}};
+        fixed_poly_range_t power = x;
+        int step = 0;
+        for (int level = 0; level < poly.num_levels; level++)
+        {
+            if (level > 0)
+            {
+                // power = power^2, unsigned.
+                fixed_poly_range_t squared = {power.bound * power.bound, 2.0 * power.bound * power.error
+                                              + power.error * power.error, 0};
+                squared.fraction_bits = fixed_poly_fraction_bits(squared.bound + squared.error,
+                                                                 2 * power.fraction_bits, 4294967296.0);
+                valid = valid && squared.fraction_bits >= FIXED_POLY_MIN_FRACTION_BITS
+                    && 2 * power.fraction_bits - squared.fraction_bits <= 63;
+                squared.error += 0.5 * fixed_poly_pow2(-squared.fraction_bits);
+                poly.power_shifts[level - 1] = (uint8_t)(valid ? 2 * power.fraction_bits - squared.fraction_bits : 0);
+                power = squared;
+            }
+            for (int pair = 0; pair < num_terms >> (level + 1); pair++, step++)
+            {
+                if (level == 0)
+                {
+                    double odd = 2 * pair + 1 <= degree ? coefficients[2 * pair + 1] : 0.0;
+                    double even = 2 * pair <= degree ? coefficients[2 * pair] : 0.0;
+                    fixed_poly_range_t times = fixed_poly_coefficient_range(odd);
+                    fixed_poly_range_t addend = {fixed_poly_abs(even), 0.0, 0};
+                    fixed_poly_range_t node = fixed_poly_plan_step(times, power, addend, true,
+                                                                   &poly.product_shifts[step],
+                                                                   &poly.addend_shifts[step]);
+                    valid = valid && node.fraction_bits >= FIXED_POLY_MIN_FRACTION_BITS;
+                    poly.coefficients[2 * pair + 1] = valid ? fixed_poly_quantize(odd, times.fraction_bits) : 0;
+                    poly.coefficients[2 * pair] = valid ? fixed_poly_quantize(even, node.fraction_bits) : 0;
+                    nodes[pair] = node;
+                }
+                else
+                {
+                    nodes[pair] = fixed_poly_plan_step(nodes[2 * pair + 1], power, nodes[2 * pair], false,
+                                                       &poly.product_shifts[step], &poly.addend_shifts[step]);
+                    valid = valid && nodes[pair].fraction_bits >= FIXED_POLY_MIN_FRACTION_BITS;
+                }
+            }
+        }
+        if (poly.num_levels == 0)
+        {
+            poly.coefficients[0] = fixed_poly_quantize(coefficients[0], result.fraction_bits);
+        }
+        else
+        {
+            result = nodes[0];
+        }
+    }
+
+    // Past 64 either way, the result always rounds to 0 or saturates.
+    int result_shift = result.fraction_bits - out_fraction_bits;
+    poly.result_shift = (int8_t)(result_shift > 64 ? 64 : result_shift < -64 ? -64 : result_shift);
+    poly.error_bound = result.error * fixed_poly_pow2(out_fraction_bits);
+    poly.valid = valid;
+    return poly;
+}
+
+// -----------------------------------------------------------------------------------------------------------------
+// Evaluation.
+// -----------------------------------------------------------------------------------------------------------------
+
+/// @brief      value / 2^shift, rounded half up (the tutorial's `+ 1/2` rounding addend), for any int64_t other than
+///             INT64_MIN, without right-shifting a negative number (which is implementation-defined in C) and without
+///             overflow.
+static inline FIXED_CONSTEXPR int64_t fixed_poly_round_shift(int64_t value, uint8_t shift)
+{
+    if (shift == 0)
+    {
+        return value;
+    }
+    if (shift >= 64)
+    {
+        // |value| < 2^63, so |value/2^shift| < 1/2.
+        return 0;
+    }
+    // Flipping the sign bit adds 2^63 (mod 2^64), making the value unsigned without changing its low `shift` bits.
+    uint64_t biased = (uint64_t)value ^ ((uint64_t)1 << 63);
+    int64_t floor = (int64_t)(biased >> shift) - ((int64_t)1 << (63 - shift));
+    // The rounding addend: bump it if the bits shifted out were at least one half.
+    return floor + (int64_t)((biased >> (shift - 1)) & 1);
+}
+
+/// @brief      Shift the last step's result to the output format, and saturate it to the int32_t range.
+static inline FIXED_CONSTEXPR int32_t fixed_poly_finish(const fixed_poly_t * poly, int64_t result)
+{
+    if (poly->result_shift >= 0)
+    {
+        result = fixed_poly_round_shift(result, (uint8_t)poly->result_shift);
+    }
+    else
+    {
+        // |result| < 2^31 going in, so shifting left by up to 32 can't overflow; past that, it saturates either way.
+        int shift = -poly->result_shift;
+        result = shift > 32 ? (result > 0 ? INT64_MAX : result < 0 ? INT64_MIN : 0) : result * ((int64_t)1 << shift);
+    }
+    return result > INT32_MAX ? INT32_MAX : result < INT32_MIN ? INT32_MIN : (int32_t)result;
+}
+
+/// @brief      Evaluate a polynomial planned with FIXED_POLY_HORNER.
+static inline FIXED_CONSTEXPR int32_t fixed_poly_eval_horner(const fixed_poly_t * poly, fixed_point_t x)
+{
+    int64_t acc = poly->coefficients[poly->degree];
+    for (int k = poly->degree - 1; k >= 0; k--)
+    {
+        // |acc| < 2^31 and x < 2^32, so the product fits.
+        acc = poly->coefficients[k] + fixed_poly_round_shift(acc * (int64_t)x, poly->product_shifts[k]);
+    }
+    return fixed_poly_finish(poly, acc);
+}
+
+/// @brief      Evaluate a polynomial planned with FIXED_POLY_ESTRIN.
+static inline FIXED_CONSTEXPR int32_t fixed_poly_eval_estrin(const fixed_poly_t * poly, fixed_point_t x)
+{
+    int64_t nodes[(FIXED_POLY_MAX_DEGREE + 1) / 2] = {0};
+    int num_pairs = (1 << poly->num_levels) >> 1;
+    for (int pair = 0; pair < num_pairs; pair++)
+    {
+        nodes[pair] = poly->coefficients[2 * pair]
+            + fixed_poly_round_shift(poly->coefficients[2 * pair + 1] * (int64_t)x, poly->product_shifts[pair]);
+    }
+    uint64_t power = x;
+    int step = num_pairs;
+    for (int level = 1; level < poly->num_levels; level++)
+    {
+        // Unsigned, so a plain shift rounds it; the planner made sure the result fits in 32 bits.
+        uint8_t shift = poly->power_shifts[level - 1];
+        uint64_t squared = power * power;
+        power = shift == 0 ? squared : (squared >> shift) + ((squared >> (shift - 1)) & 1);
+        num_pairs >>= 1;
+        for (int pair = 0; pair < num_pairs; pair++, step++)
+        {
+            nodes[pair] = fixed_poly_round_shift(nodes[2 * pair], poly->addend_shifts[step])
+                + fixed_poly_round_shift(nodes[2 * pair + 1] * (int64_t)power, poly->product_shifts[step]);
+        }
+    }
+    return fixed_poly_finish(poly, poly->num_levels == 0 ? poly->coefficients[0] : nodes[0]);
+}
+
+/// @brief      Evaluate a planned polynomial at x.
+/// @return     The result in the plan's output format, saturated to the int32_t range; or 0 if the plan is invalid.
+static inline FIXED_CONSTEXPR int32_t fixed_poly_eval(const fixed_poly_t * poly, fixed_point_t x)
+{
+    if (!poly->valid)
+    {
+        return 0;
+    }
+    return poly->scheme == FIXED_POLY_ESTRIN ? fixed_poly_eval_estrin(poly, x) : fixed_poly_eval_horner(poly, x);
+}
+
+#ifdef __cplusplus
+}
+
+#if __cplusplus >= 201703L
+// The compile-time evaluators (C++17, for `if constexpr`): the same math as fixed_poly_eval_horner() and
+// fixed_poly_eval_estrin(), with each loop written out by template recursion, so every coefficient and shift is a
+// constant in the generated code.
+
+/// @brief      Horner steps K, K - 1, ..., 0.
+template <const fixed_poly_t & Plan, int K>
+inline int64_t fixed_poly_horner_unrolled(int64_t acc, fixed_point_t x)
+{
+    if constexpr (K < 0)
+    {
+        return acc;
+    }
+    else
+    {
+        return fixed_poly_horner_unrolled<Plan, K - 1>(
+            Plan.coefficients[K] + fixed_poly_round_shift(acc * (int64_t)x, Plan.product_shifts[K]), x);
+    }
+}
+
+/// @brief      Estrin pairs Pair, Pair + 1, ..., NumPairs - 1 of a level whose first step is `First`. At level 0 they
+///             pair up the coefficients, and above it, the previous level's results in `nodes`.
+template <const fixed_poly_t & Plan, int Level, int First, int Pair, int NumPairs>
+inline void fixed_poly_estrin_pairs(int64_t * nodes, uint64_t power)
+{
+    if constexpr (Pair < NumPairs)
+    {
+        constexpr int step = First + Pair;
+        if constexpr (Level == 0)
+        {
+            nodes[Pair] = Plan.coefficients[2 * Pair]
+                + fixed_poly_round_shift(Plan.coefficients[2 * Pair + 1] * (int64_t)power, Plan.product_shifts[step]);
+        }
+        else
+        {
+            nodes[Pair] = fixed_poly_round_shift(nodes[2 * Pair], Plan.addend_shifts[step])
+                + fixed_poly_round_shift(nodes[2 * Pair + 1] * (int64_t)power, Plan.product_shifts[step]);
+        }
+        // Pair i overwrites nodes[i] after reading nodes[2i] and nodes[2i + 1], so this has to go from pair 0 up.
+        fixed_poly_estrin_pairs<Plan, Level, First, Pair + 1, NumPairs>(nodes, power);
+    }
+}
+
+/// @brief      Estrin levels Level, Level + 1, ..., where `First` is Level's first step.
+template <const fixed_poly_t & Plan, int Level, int First>
+inline void fixed_poly_estrin_levels(int64_t * nodes, uint64_t power)
+{
+    if constexpr (Level < Plan.num_levels)
+    {
+        if constexpr (Level > 0)
+        {
+            constexpr uint8_t shift = Plan.power_shifts[Level - 1];
+            power *= power;
+            if constexpr (shift > 0)
+            {
+                power = (power >> shift) + ((power >> (shift - 1)) & 1);
+            }
+        }
+        constexpr int num_pairs = (1 << Plan.num_levels) >> (Level + 1);
+        fixed_poly_estrin_pairs<Plan, Level, First, 0, num_pairs>(nodes, power);
+        fixed_poly_estrin_levels<Plan, Level + 1, First + num_pairs>(nodes, power);
+    }
+}
+
+/// @brief      Evaluate a polynomial planned at compile time: with `constexpr fixed_poly_t plan = fixed_poly_plan(...)`
+///             at namespace scope, `fixed_poly_eval_static<plan>(x)`. Identical to fixed_poly_eval(&plan, x), but
+///             compiles to straight-line code with the coefficients and shifts built into the instructions.
+template <const fixed_poly_t & Plan>
+inline int32_t fixed_poly_eval_static(fixed_point_t x)
+{
+    static_assert(Plan.valid, "fixed_poly_plan() could not plan this polynomial");
+    if constexpr (Plan.scheme == FIXED_POLY_ESTRIN)
+    {
+        if constexpr (Plan.num_levels == 0)
+        {
+            return fixed_poly_finish(&Plan, Plan.coefficients[0]);
+        }
+        else
+        {
+            int64_t nodes[(FIXED_POLY_MAX_DEGREE + 1) / 2] = {0};
+            fixed_poly_estrin_levels<Plan, 0, 0>(nodes, x);
+            return fixed_poly_finish(&Plan, nodes[0]);
+        }
+    }
+    else
+    {
+        return fixed_poly_finish(&Plan, fixed_poly_horner_unrolled<Plan, Plan.degree - 1>(
+            Plan.coefficients[Plan.degree], x));
+    }
+}
+#endif // __cplusplus >= 201703L
+
+#endif
+
+#endif // FIXED_POINT_POLY_H
@@ -0,0 +1,347 @@
+/*
+fixed_point_qformat
+- See fixed_point_qformat.h.
+*/
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <string.h>
+
+#include "fixed_point_mul.h"
+#include "fixed_point_qformat.h"
+
+#define SIGN_BIT 0x80000000u
+
+// One format's batch kernels. `bits` is the format's number of fraction bits; the specialized kernels ignore it,
+// since theirs is compiled in.
+typedef struct fixed_qformat_kernels_s
+{
+    void (*mul_round)(int32_t * out, const int32_t * a, const int32_t * b, size_t n, unsigned bits);
+    void (*to_fixed)(int32_t * out, const int32_t * in, size_t n, unsigned bits);
+    void (*from_fixed)(int32_t * out, const int32_t * in, size_t n, unsigned bits);
+} fixed_qformat_kernels_t;
+
+// Always inline the kernels below, so that each copy with a constant number of bits gets compiled for just that.
+#if defined(__GNUC__)
+#define QFORMAT_KERNEL static inline __attribute__((always_inline))
+#else
+#define QFORMAT_KERNEL static inline
+#endif
+
+// -----------------------------------------------------------------------------------------------------------------
+// Scalar
+// -----------------------------------------------------------------------------------------------------------------
+
+// A uint32_t's bits as an int32_t, without the implementation-defined conversion of values over INT32_MAX.
+static int32_t to_signed(uint32_t x)
+{
+    return x <= INT32_MAX ? (int32_t)x : -(int32_t)(~x) - 1;
+}
+
+// `x / 2^shift` (shift 1 to 31), rounded half up: the floor, plus the highest bit shifted out. Can't overflow, unlike
+// adding 1/2 first. The floor is biased to be non-negative first, since right-shifting a negative number is
+// implementation-defined in C.
+QFORMAT_KERNEL int32_t shift_right_round_one(int32_t x, unsigned shift)
+{
+    int32_t floored = (int32_t)(((uint32_t)x ^ SIGN_BIT) >> shift) - (int32_t)(SIGN_BIT >> shift);
+    return floored + (int32_t)(((uint32_t)x >> (shift - 1)) & 1);
+}
+
+// `x * 2^shift` (shift 1 to 31), saturated to [INT32_MIN, INT32_MAX].
+QFORMAT_KERNEL int32_t shift_left_saturate_one(int32_t x, unsigned shift)
+{
+    int32_t limit = (int32_t)(SIGN_BIT >> shift);
+    return x >= limit ? INT32_MAX : x < -limit ? INT32_MIN : to_signed((uint32_t)x << shift);
+}
+
+// `a*b / 2^bits`, rounded half up, then saturated.
+QFORMAT_KERNEL int32_t mul_round_one(int32_t a, int32_t b, unsigned bits)
+{
+    if (bits == 0)
+    {
+        return fixed_q31_saturate((int64_t)a * b);
+    }
+    int64_t sum = (int64_t)a * b + ((int64_t)1 << (bits - 1));
+    // Biased, like shift_right_round_one().
+    return fixed_q31_saturate((int64_t)(((uint64_t)sum + ((uint64_t)1 << 63)) >> bits) - ((int64_t)1 << (63 - bits)));
+}
+
+// -----------------------------------------------------------------------------------------------------------------
+// SIMD
+// -----------------------------------------------------------------------------------------------------------------
+
+#if defined(__AVX2__)
+
+QFORMAT_KERNEL __m256i shift_right_round_x8(__m256i x, unsigned shift)
+{
+    __m256i floored = _mm256_sra_epi32(x, _mm_cvtsi32_si128((int)shift));
+    __m256i half = _mm256_and_si256(_mm256_srl_epi32(x, _mm_cvtsi32_si128((int)shift - 1)), _mm256_set1_epi32(1));
+    return _mm256_add_epi32(floored, half);
+}
+
+QFORMAT_KERNEL __m256i shift_left_saturate_x8(__m256i x, unsigned shift)
+{
+    const __m256i LIMIT = _mm256_set1_epi32((int32_t)(SIGN_BIT >> shift));
+    __m256i too_high = _mm256_cmpgt_epi32(x, _mm256_sub_epi32(LIMIT, _mm256_set1_epi32(1)));
+    __m256i too_low = _mm256_cmpgt_epi32(_mm256_sub_epi32(_mm256_setzero_si256(), LIMIT), x);
+    __m256i y = _mm256_sll_epi32(x, _mm_cvtsi32_si128((int)shift));
+    y = _mm256_blendv_epi8(y, _mm256_set1_epi32(INT32_MAX), too_high);
+    return _mm256_blendv_epi8(y, _mm256_set1_epi32(INT32_MIN), too_low);
+}
+
+// The rounded sums `a*b + 1/2` of the 4 64-bit products of the even lanes of `a` and `b`.
+QFORMAT_KERNEL __m256i mul_sum_x4(__m256i a, __m256i b, unsigned bits)
+{
+    return _mm256_add_epi64(_mm256_mul_epi32(a, b), _mm256_set1_epi64x(bits == 0 ? 0 : (int64_t)1 << (bits - 1)));
+}
+
+// Whether each of 4 sums `>> bits` fits in 32 bits: adding 2^(bits + 31) maps the ones that do to [0, 2^(bits + 32)).
+// All ones if so, in both 32-bit halves.
+QFORMAT_KERNEL __m256i mul_fits_x4(__m256i sum, unsigned bits)
+{
+    __m256i biased = _mm256_add_epi64(sum, _mm256_set1_epi64x((int64_t)1 << (bits + 31)));
+    return _mm256_cmpeq_epi64(_mm256_srl_epi64(biased, _mm_cvtsi32_si128((int)bits + 32)), _mm256_setzero_si256());
+}
+
+// Like fixed_q31_mul_round_batch()'s AVX2 kernel, for any number of bits: the low 32 bits of each `sum >> bits` are
+// the same for a logical shift as for an arithmetic one (which AVX2 doesn't have for 64 bits), so only the sums that
+// don't fit need their sign.
+QFORMAT_KERNEL __m256i mul_round_x8(__m256i a, __m256i b, unsigned bits)
+{
+    const __m128i SHIFT = _mm_cvtsi32_si128((int)bits);
+    __m256i even = mul_sum_x4(a, b, bits);
+    __m256i odd = mul_sum_x4(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32), bits);
+    __m256i result = _mm256_blend_epi32(_mm256_srl_epi64(even, SHIFT),
+                                        _mm256_slli_epi64(_mm256_srl_epi64(odd, SHIFT), 32), 0xAA);
+    __m256i fits = _mm256_blend_epi32(mul_fits_x4(even, bits), mul_fits_x4(odd, bits), 0xAA);
+    // The high 32 bits of each sum, for its sign.
+    __m256i high = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+    __m256i saturated = _mm256_xor_si256(_mm256_srai_epi32(high, 31), _mm256_set1_epi32(INT32_MAX));
+    return _mm256_blendv_epi8(saturated, result, fits);
+}
+
+#endif
+
+#if defined(__SSE2__)
+
+// The 4-lane SSE2 versions of the shifts. (Multiplying needs SSE4.1's signed 32x32 = 64-bit multiply, so it only gets
+// an AVX2 version, like fixed_q31_mul_round_batch().)
+QFORMAT_KERNEL __m128i shift_right_round_x4(__m128i x, unsigned shift)
+{
+    __m128i floored = _mm_sra_epi32(x, _mm_cvtsi32_si128((int)shift));
+    __m128i half = _mm_and_si128(_mm_srl_epi32(x, _mm_cvtsi32_si128((int)shift - 1)), _mm_set1_epi32(1));
+    return _mm_add_epi32(floored, half);
+}
+
+QFORMAT_KERNEL __m128i shift_left_saturate_x4(__m128i x, unsigned shift)
+{
+    const __m128i LIMIT = _mm_set1_epi32((int32_t)(SIGN_BIT >> shift));
+    __m128i too_high = _mm_cmpgt_epi32(x, _mm_sub_epi32(LIMIT, _mm_set1_epi32(1)));
+    __m128i too_low = _mm_cmplt_epi32(x, _mm_sub_epi32(_mm_setzero_si128(), LIMIT));
+    __m128i y = _mm_sll_epi32(x, _mm_cvtsi32_si128((int)shift));
+    // No blend instruction in SSE2, so clear the out-of-range lanes and OR in their limits.
+    y = _mm_andnot_si128(_mm_or_si128(too_high, too_low), y);
+    y = _mm_or_si128(y, _mm_and_si128(too_high, _mm_set1_epi32(INT32_MAX)));
+    return _mm_or_si128(y, _mm_and_si128(too_low, _mm_set1_epi32(INT32_MIN)));
+}
+
+#endif
+
+// -----------------------------------------------------------------------------------------------------------------
+// Kernels
+// -----------------------------------------------------------------------------------------------------------------
+
+QFORMAT_KERNEL void shift_right_round(int32_t * out, const int32_t * in, size_t n, unsigned shift)
+{
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(in + i));
+        _mm256_storeu_si256((__m256i *)(out + i), shift_right_round_x8(x, shift));
+    }
+#endif
+#if defined(__SSE2__)
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *)(in + i));
+        _mm_storeu_si128((__m128i *)(out + i), shift_right_round_x4(x, shift));
+    }
+#endif
+    for (; i < n; i++)
+    {
+        out[i] = shift_right_round_one(in[i], shift);
+    }
+}
+
+QFORMAT_KERNEL void shift_left_saturate(int32_t * out, const int32_t * in, size_t n, unsigned shift)
+{
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(in + i));
+        _mm256_storeu_si256((__m256i *)(out + i), shift_left_saturate_x8(x, shift));
+    }
+#endif
+#if defined(__SSE2__)
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *)(in + i));
+        _mm_storeu_si128((__m128i *)(out + i), shift_left_saturate_x4(x, shift));
+    }
+#endif
+    for (; i < n; i++)
+    {
+        out[i] = shift_left_saturate_one(in[i], shift);
+    }
+}
+
+// Change `n` numbers from `from` fraction bits to `to`. Which way to shift is decided once per batch (and, with
+// constant bits, at compile time).
+QFORMAT_KERNEL void convert(int32_t * out, const int32_t * in, size_t n, unsigned from, unsigned to)
+{
+    if (from > to)
+    {
+        shift_right_round(out, in, n, from - to);
+    }
+    else if (from < to)
+    {
+        shift_left_saturate(out, in, n, to - from);
+    }
+    else if (out != in)
+    {
+        memmove(out, in, n * sizeof(int32_t));
+    }
+}
+
+QFORMAT_KERNEL void mul_round_kernel(int32_t * out, const int32_t * a, const int32_t * b, size_t n, unsigned bits)
+{
+    if (bits == FIXED_Q31_FRACTION_BITS)
+    {
+        fixed_q31_mul_round_batch(out, a, b, n);
+        return;
+    }
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i va = _mm256_loadu_si256((const __m256i *)(a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i *)(b + i));
+        _mm256_storeu_si256((__m256i *)(out + i), mul_round_x8(va, vb, bits));
+    }
+#endif
+    for (; i < n; i++)
+    {
+        out[i] = mul_round_one(a[i], b[i], bits);
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------
+// Kernel tables
+// -----------------------------------------------------------------------------------------------------------------
+
+// One format's kernels, compiled with its number of fraction bits as a constant: C's version of instantiating a
+// template.
+#define QFORMAT_KERNELS(BITS)                                                                                       \
+    static void mul_round_q##BITS(int32_t * out, const int32_t * a, const int32_t * b, size_t n, unsigned bits)     \
+    {                                                                                                               \
+        (void)bits;                                                                                                 \
+        mul_round_kernel(out, a, b, n, BITS);                                                                       \
+    }                                                                                                               \
+    static void to_fixed_q##BITS(int32_t * out, const int32_t * in, size_t n, unsigned bits)                        \
+    {                                                                                                               \
+        (void)bits;                                                                                                 \
+        convert(out, in, n, BITS, FRACTION_BITS);                                                                   \
+    }                                                                                                               \
+    static void from_fixed_q##BITS(int32_t * out, const int32_t * in, size_t n, unsigned bits)                      \
+    {                                                                                                               \
+        (void)bits;                                                                                                 \
+        convert(out, in, n, FRACTION_BITS, BITS);                                                                   \
+    }                                                                                                               \
+    static const fixed_qformat_kernels_t KERNELS_Q##BITS = {mul_round_q##BITS, to_fixed_q##BITS, from_fixed_q##BITS};
+
+QFORMAT_KERNELS(8)
+QFORMAT_KERNELS(12)
+QFORMAT_KERNELS(15)
+QFORMAT_KERNELS(16)
+QFORMAT_KERNELS(24)
+QFORMAT_KERNELS(31)
+
+// Every other format: the same kernels, shifting by variable amounts.
+static void mul_round_generic(int32_t * out, const int32_t * a, const int32_t * b, size_t n, unsigned bits)
+{
+    mul_round_kernel(out, a, b, n, bits);
+}
+
+static void to_fixed_generic(int32_t * out, const int32_t * in, size_t n, unsigned bits)
+{
+    convert(out, in, n, bits, FRACTION_BITS);
+}
+
+static void from_fixed_generic(int32_t * out, const int32_t * in, size_t n, unsigned bits)
+{
+    convert(out, in, n, FRACTION_BITS, bits);
+}
+
+static const fixed_qformat_kernels_t KERNELS_GENERIC = {mul_round_generic, to_fixed_generic, from_fixed_generic};
+
+// -----------------------------------------------------------------------------------------------------------------
+// Public functions
+// -----------------------------------------------------------------------------------------------------------------
+
+/// @brief      Set up a format with `fraction_bits` fraction bits, picking its kernels.
+/// @return     false if `fraction_bits` is over FIXED_QFORMAT_MAX_FRACTION_BITS.
+bool fixed_qformat_init(fixed_qformat_t * format, unsigned fraction_bits)
+{
+    static const struct
+    {
+        unsigned fraction_bits;
+        const fixed_qformat_kernels_t * kernels;
+    } SPECIALIZED[] =
+    {
+        {8, &KERNELS_Q8}, {12, &KERNELS_Q12}, {15, &KERNELS_Q15}, {16, &KERNELS_Q16}, {24, &KERNELS_Q24},
+        {31, &KERNELS_Q31},
+    };
+
+    if (fraction_bits > FIXED_QFORMAT_MAX_FRACTION_BITS)
+    {
+        return false;
+    }
+    format->fraction_bits = (uint8_t)fraction_bits;
+    format->specialized = false;
+    format->kernels = &KERNELS_GENERIC;
+    for (size_t i = 0; i < sizeof(SPECIALIZED)/sizeof(SPECIALIZED[0]); i++)
+    {
+        if (SPECIALIZED[i].fraction_bits == fraction_bits)
+        {
+            format->specialized = true;
+            format->kernels = SPECIALIZED[i].kernels;
+        }
+    }
+    return true;
+}
+
+/// @brief      `a*b`, rounded half up, saturated to [INT32_MIN, INT32_MAX].
+void fixed_qformat_mul_round(const fixed_qformat_t * format, int32_t * out, const int32_t * a, const int32_t * b,
+                             size_t n)
+{
+    format->kernels->mul_round(out, a, b, n, format->fraction_bits);
+}
+
+/// @brief      Convert numbers in `format` to FRACTION_BITS fraction bits (a signed Q15.16 `int32_t`): rounded half up
+///             if `format` has more fraction bits, saturated if it has fewer.
+void fixed_qformat_to_fixed(const fixed_qformat_t * format, int32_t * out, const int32_t * in, size_t n)
+{
+    format->kernels->to_fixed(out, in, n, format->fraction_bits);
+}
+
+/// @brief      Convert numbers with FRACTION_BITS fraction bits to `format`: the reverse of fixed_qformat_to_fixed().
+void fixed_qformat_from_fixed(const fixed_qformat_t * format, int32_t * out, const int32_t * in, size_t n)
+{
+    format->kernels->from_fixed(out, in, n, format->fraction_bits);
+}
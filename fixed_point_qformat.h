@@ -0,0 +1,54 @@
+/*
+fixed_point_qformat
+- Fixed-point numbers whose format is only known at run time (ex: from a file's metadata), instead of at compile time
+  like `#define FRACTION_BITS 16`: signed numbers in an `int32_t` with 0 to 31 fraction bits, described by a
+  `fixed_qformat_t`.
+- Doing every number's shifts by a variable amount, and checking which way to shift for every number, is much slower
+  than the tutorial's compile-time `>> FRACTION_BITS`. Instead, fixed_qformat_init() picks a table of batch kernels
+  once per format, and each batch function does one indirect call per *array*:
+  - The common formats (8, 12, 15, 16, 24, and 31 fraction bits) get kernels compiled for that exact number of bits,
+    like template instances: every shift count, rounding constant, and saturation limit is a constant, and the
+    checks for which way to shift are gone (ex: converting 16 fraction bits to 16 is just a copy).
+  - Any other number of bits gets the same kernels with the number of bits as a variable.
+  - Both use SIMD (AVX2 8 numbers at a time, else SSE2 4 at a time, where the operation has an SSE2 version), and
+    give bit-identical results.
+- Multiplying rounds half up (like the tutorial, and like fixed_point_mul.h) and saturates. Converting to and from
+  the library's `FRACTION_BITS` (a signed Q15.16 `int32_t`) rounds half up when dropping bits, and saturates when
+  adding them.
+*/
+
+#ifndef FIXED_POINT_QFORMAT_H
+#define FIXED_POINT_QFORMAT_H
+
+#include <stddef.h>
+
+#include "fixed_point.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FIXED_QFORMAT_MAX_FRACTION_BITS 31
+
+// A runtime Q format. Set up with fixed_qformat_init(); it's read-only after that, so threads can share one.
+typedef struct fixed_qformat_s
+{
+    uint8_t fraction_bits;
+    bool specialized;                               // whether `kernels` were compiled for exactly this format
+    const struct fixed_qformat_kernels_s * kernels; // picked by fixed_qformat_init()
+} fixed_qformat_t;
+
+bool fixed_qformat_init(fixed_qformat_t * format, unsigned fraction_bits);
+
+// Batch operations: out[i] = the operation on in[i] (or a[i] and b[i]), for i < n. No alignment is needed, and `out`
+// may be the same array as any input.
+void fixed_qformat_mul_round(const fixed_qformat_t * format, int32_t * out, const int32_t * a, const int32_t * b,
+                             size_t n);
+void fixed_qformat_to_fixed(const fixed_qformat_t * format, int32_t * out, const int32_t * in, size_t n);
+void fixed_qformat_from_fixed(const fixed_qformat_t * format, int32_t * out, const int32_t * in, size_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIXED_POINT_QFORMAT_H
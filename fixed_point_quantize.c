@@ -0,0 +1,488 @@
+/*
+fixed_point_quantize
+- See fixed_point_quantize.h.
+*/
+
+#include <math.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "fixed_point_quantize.h"
+
+#define TWO_POW_31 2147483648.0
+#define TWO_POW_32 4294967296.0
+
+// How a call rounds and clips, worked out once per call instead of per value.
+typedef struct quantize_params_s
+{
+    fixed_round_mode_t mode;
+    bool saturate;
+    // A scaled value at or below `low_limit` (or under it, if `low_inclusive` is false) rounds to below 0.
+    double low_limit;
+    bool low_inclusive;
+    // A scaled value at or above this rounds to above UINT32_MAX.
+    double high_limit;
+} quantize_params_t;
+
+static quantize_params_t make_params(fixed_round_mode_t mode, bool saturate)
+{
+    quantize_params_t params;
+    params.mode = mode;
+    params.saturate = saturate;
+    switch (mode)
+    {
+        case FIXED_ROUND_HALF_UP:
+            // -0.5 rounds away from zero, to -1.
+            params.low_limit = -0.5;
+            params.low_inclusive = true;
+            params.high_limit = TWO_POW_32 - 0.5;
+            break;
+        case FIXED_ROUND_HALF_EVEN:
+            // -0.5 rounds to 0, but UINT32_MAX + 0.5 rounds to 2^32, since UINT32_MAX is odd.
+            params.low_limit = -0.5;
+            params.low_inclusive = false;
+            params.high_limit = TWO_POW_32 - 0.5;
+            break;
+        case FIXED_ROUND_TRUNCATE:
+        default:
+            params.mode = FIXED_ROUND_TRUNCATE;
+            params.low_limit = -1.0;
+            params.low_inclusive = true;
+            params.high_limit = TWO_POW_32;
+            break;
+    }
+    return params;
+}
+
+static void stats_init(fixed_quantize_stats_t * stats, size_t count)
+{
+    stats->min = INFINITY;
+    stats->max = -INFINITY;
+    stats->count = (uint32_t)count;
+    stats->clipped_low = 0;
+    stats->clipped_high = 0;
+    stats->best_fraction_bits = 32;
+}
+
+/// @brief      The most fraction bits that `max` can be quantized with (rounded half up) without clipping: the
+///             block's best scale, if it were stored with a scale of its own.
+static uint8_t best_fraction_bits(double max)
+{
+    uint8_t bits = 32;
+    // max*2^bits, which is exact until it overflows to infinity, and then it still compares right.
+    double scaled = max * TWO_POW_32;
+    while (bits > 0 && scaled >= TWO_POW_32 - 0.5)
+    {
+        bits--;
+        scaled *= 0.5;
+    }
+    return bits;
+}
+
+/// @brief      Quantize one value that has already been scaled by FRACTION_DIVISOR. The SIMD kernels compute exactly
+///             the same thing, 4 values at a time.
+static fixed_point_t quantize_one(double scaled, const quantize_params_t * params, fixed_quantize_stats_t * stats)
+{
+    // Written so NaNs count as too low.
+    bool too_low = params->low_inclusive ? !(scaled > params->low_limit) : !(scaled >= params->low_limit);
+    bool too_high = scaled >= params->high_limit;
+    if (scaled < stats->min)
+    {
+        stats->min = scaled;
+    }
+    if (scaled > stats->max)
+    {
+        stats->max = scaled;
+    }
+    stats->clipped_low += too_low;
+    stats->clipped_high += too_high;
+    if (too_high)
+    {
+        return params->saturate ? UINT32_MAX : 0;
+    }
+    if (too_low && (params->saturate || !(scaled > -TWO_POW_31 - 1.0)))
+    {
+        return 0;
+    }
+
+    // Values of 2^31 and up don't fit in an int32_t (which is all SIMD can convert to), so shift them down by 2^31
+    // first, and add it back at the end. The subtraction is exact, and since 2^31 is even, so is the rounding.
+    double shift = scaled >= TWO_POW_31 ? TWO_POW_31 : 0.0;
+    double shifted = scaled - shift;
+    int64_t truncated = (int64_t)shifted;
+    // Exact: `truncated` is `shifted` with its fraction bits cleared.
+    double fraction = shifted - (double)truncated;
+    switch (params->mode)
+    {
+        case FIXED_ROUND_HALF_UP:
+            truncated += (fraction >= 0.5) - (fraction <= -0.5);
+            break;
+        case FIXED_ROUND_HALF_EVEN:
+        {
+            bool odd = truncated & 1;
+            truncated += (fraction > 0.5 || (fraction == 0.5 && odd)) - (fraction < -0.5 || (fraction == -0.5 && odd));
+            break;
+        }
+        case FIXED_ROUND_TRUNCATE:
+        default:
+            break;
+    }
+    // Negative results wrap around to two's complement, like fixed_point_t subtraction does.
+    return (fixed_point_t)((uint64_t)truncated + (uint64_t)shift);
+}
+
+static void finish_stats(fixed_quantize_stats_t * stats)
+{
+    // The scaled values were tracked, to save a multiply per value.
+    stats->min /= FRACTION_DIVISOR;
+    stats->max /= FRACTION_DIVISOR;
+    stats->best_fraction_bits = best_fraction_bits(stats->max);
+}
+
+#if defined(__SSE2__)
+
+// Always inline the kernels below: `mode` is always a constant, so each copy gets compiled with only the work its mode
+// needs.
+#if defined(__GNUC__)
+#define QUANTIZE_KERNEL static inline __attribute__((always_inline))
+#else
+#define QUANTIZE_KERNEL static inline
+#endif
+
+// Round 4 truncated values per `mode`, given 2*(the fraction that was truncated off), which is exact and in (-2, 2).
+// Truncating that again gives -1, 0, or 1: exactly the round-half-away-from-zero adjustment (FIXED_ROUND_HALF_UP),
+// with no compares. For FIXED_ROUND_HALF_EVEN, exact ties (+-1.0) don't adjust even values.
+QUANTIZE_KERNEL __m128i round_4(__m128i truncated, __m128i adjust, __m128i tie, fixed_round_mode_t mode)
+{
+    switch (mode)
+    {
+        case FIXED_ROUND_HALF_UP:
+            return _mm_add_epi32(truncated, adjust);
+        case FIXED_ROUND_HALF_EVEN:
+        {
+            const __m128i ONE = _mm_set1_epi32(1);
+            __m128i odd = _mm_cmpeq_epi32(_mm_and_si128(truncated, ONE), ONE);
+            return _mm_add_epi32(truncated, _mm_andnot_si128(_mm_andnot_si128(odd, tie), adjust));
+        }
+        case FIXED_ROUND_TRUNCATE:
+        default:
+            return truncated;
+    }
+}
+
+// Add back the 2^31 taken off values of 2^31 and up, then saturate, for 4 values.
+QUANTIZE_KERNEL __m128i clip_4(__m128i rounded, __m128i is_high_half, __m128i too_low, __m128i too_high,
+                             __m128i saturate)
+{
+    const __m128i SIGN = _mm_set1_epi32((int)0x80000000);
+    rounded = _mm_add_epi32(rounded, _mm_and_si128(is_high_half, SIGN));
+    // Like quantize_one(): too-high values are all ones when saturating, and otherwise 0.
+    rounded = _mm_andnot_si128(_mm_or_si128(_mm_and_si128(too_low, saturate), too_high), rounded);
+    return _mm_or_si128(rounded, _mm_and_si128(too_high, saturate));
+}
+
+QUANTIZE_KERNEL void quantize_block_f32_mode(const float * in, fixed_point_t * out, size_t n,
+                                           const quantize_params_t * params, fixed_quantize_stats_t * stats,
+                                           fixed_round_mode_t mode)
+{
+    const __m128 SCALE = _mm_set1_ps((float)FRACTION_DIVISOR);
+    const __m128 LOW_LIMIT = _mm_set1_ps((float)params->low_limit);
+    // No float lies between 2^32 - 0.5 and 2^32, so 2^32 works as the limit for every rounding mode.
+    const __m128 HIGH_LIMIT = _mm_set1_ps((float)TWO_POW_32);
+    const __m128 HIGH_HALF = _mm_set1_ps((float)TWO_POW_31);
+    const __m128 SIGN_BIT = _mm_set1_ps(-0.0f);
+    const __m128 ONE = _mm_set1_ps(1.0f);
+    const __m128i SATURATE = _mm_set1_epi32(params->saturate ? -1 : 0);
+    __m128 min = _mm_set1_ps(INFINITY);
+    __m128 max = _mm_set1_ps(-INFINITY);
+    __m128i clipped_low = _mm_setzero_si128();
+    __m128i clipped_high = _mm_setzero_si128();
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 value = _mm_loadu_ps(in + i);
+        __m128 scaled = _mm_mul_ps(value, SCALE);
+        // _mm_min_ps() and _mm_max_ps() return their 2nd argument if either is NaN, so NaNs are skipped. These track
+        // the unscaled values: scaled in float, the biggest ones would overflow to infinity, where the scalar tail's
+        // doubles don't.
+        min = _mm_min_ps(value, min);
+        max = _mm_max_ps(value, max);
+        // The "not" compares are true for NaN.
+        __m128i too_low = _mm_castps_si128(mode == FIXED_ROUND_HALF_EVEN ? _mm_cmpnge_ps(scaled, LOW_LIMIT)
+                                                                         : _mm_cmpngt_ps(scaled, LOW_LIMIT));
+        __m128i too_high = _mm_castps_si128(_mm_cmpge_ps(scaled, HIGH_LIMIT));
+        __m128 is_high_half = _mm_cmpge_ps(scaled, HIGH_HALF);
+        __m128 shifted = _mm_sub_ps(scaled, _mm_and_ps(is_high_half, HIGH_HALF));
+        __m128i truncated = _mm_cvttps_epi32(shifted);
+        __m128 fraction = _mm_sub_ps(shifted, _mm_cvtepi32_ps(truncated));
+        __m128 twice_fraction = _mm_add_ps(fraction, fraction);
+        __m128i rounded = round_4(truncated, _mm_cvttps_epi32(twice_fraction),
+                                  _mm_castps_si128(_mm_cmpeq_ps(_mm_andnot_ps(SIGN_BIT, twice_fraction), ONE)), mode);
+        _mm_storeu_si128((__m128i *)(out + i),
+                         clip_4(rounded, _mm_castps_si128(is_high_half), too_low, too_high, SATURATE));
+        clipped_low = _mm_sub_epi32(clipped_low, too_low);
+        clipped_high = _mm_sub_epi32(clipped_high, too_high);
+    }
+
+    // (Scaling by a power of 2 in double is exact, so this is what quantize_one() would have tracked.)
+    float lanes[4];
+    _mm_storeu_ps(lanes, min);
+    for (int lane = 0; lane < 4; lane++)
+    {
+        double scaled = (double)lanes[lane] * FRACTION_DIVISOR;
+        stats->min = scaled < stats->min ? scaled : stats->min;
+    }
+    _mm_storeu_ps(lanes, max);
+    for (int lane = 0; lane < 4; lane++)
+    {
+        double scaled = (double)lanes[lane] * FRACTION_DIVISOR;
+        stats->max = scaled > stats->max ? scaled : stats->max;
+    }
+    uint32_t counts[4];
+    _mm_storeu_si128((__m128i *)counts, clipped_low);
+    stats->clipped_low += counts[0] + counts[1] + counts[2] + counts[3];
+    _mm_storeu_si128((__m128i *)counts, clipped_high);
+    stats->clipped_high += counts[0] + counts[1] + counts[2] + counts[3];
+
+    for (; i < n; i++)
+    {
+        out[i] = quantize_one((double)in[i] * FRACTION_DIVISOR, params, stats);
+    }
+}
+
+// The low 32 bits of each of the 2 64-bit lanes of `a`, in the low 2 lanes.
+QUANTIZE_KERNEL __m128i narrow_64(__m128d a)
+{
+    return _mm_shuffle_epi32(_mm_castpd_si128(a), _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+QUANTIZE_KERNEL void quantize_block_f64_mode(const double * in, fixed_point_t * out, size_t n,
+                                           const quantize_params_t * params, fixed_quantize_stats_t * stats,
+                                           fixed_round_mode_t mode)
+{
+    const __m128d SCALE = _mm_set1_pd((double)FRACTION_DIVISOR);
+    const __m128d LOW_LIMIT = _mm_set1_pd(params->low_limit);
+    const __m128d HIGH_LIMIT = _mm_set1_pd(params->high_limit);
+    const __m128d HIGH_HALF = _mm_set1_pd(TWO_POW_31);
+    const __m128d SIGN_BIT = _mm_set1_pd(-0.0);
+    const __m128d ONE = _mm_set1_pd(1.0);
+    const __m128i SATURATE = _mm_set1_epi32(params->saturate ? -1 : 0);
+    __m128d min = _mm_set1_pd(INFINITY);
+    __m128d max = _mm_set1_pd(-INFINITY);
+    // 64-bit counts, one per double lane.
+    __m128i clipped_low = _mm_setzero_si128();
+    __m128i clipped_high = _mm_setzero_si128();
+
+    // SSE2 only holds 2 doubles per register, so this is quantize_block_f32_mode() 2 values at a time, with the
+    // integer work done in the low 2 lanes.
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        __m128d scaled = _mm_mul_pd(_mm_loadu_pd(in + i), SCALE);
+        min = _mm_min_pd(scaled, min);
+        max = _mm_max_pd(scaled, max);
+        __m128d too_low = mode == FIXED_ROUND_HALF_EVEN ? _mm_cmpnge_pd(scaled, LOW_LIMIT)
+                                                        : _mm_cmpngt_pd(scaled, LOW_LIMIT);
+        __m128d too_high = _mm_cmpge_pd(scaled, HIGH_LIMIT);
+        __m128d is_high_half = _mm_cmpge_pd(scaled, HIGH_HALF);
+        __m128d shifted = _mm_sub_pd(scaled, _mm_and_pd(is_high_half, HIGH_HALF));
+        // _mm_cvttpd_epi32() leaves its 2 results in the low 2 lanes.
+        __m128i truncated = _mm_cvttpd_epi32(shifted);
+        __m128d fraction = _mm_sub_pd(shifted, _mm_cvtepi32_pd(truncated));
+        __m128d twice_fraction = _mm_add_pd(fraction, fraction);
+        __m128i rounded = round_4(truncated, _mm_cvttpd_epi32(twice_fraction),
+                                  narrow_64(_mm_cmpeq_pd(_mm_andnot_pd(SIGN_BIT, twice_fraction), ONE)), mode);
+        _mm_storel_epi64((__m128i *)(out + i),
+                         clip_4(rounded, narrow_64(is_high_half), narrow_64(too_low), narrow_64(too_high), SATURATE));
+        clipped_low = _mm_sub_epi64(clipped_low, _mm_castpd_si128(too_low));
+        clipped_high = _mm_sub_epi64(clipped_high, _mm_castpd_si128(too_high));
+    }
+
+    double lanes[2];
+    _mm_storeu_pd(lanes, min);
+    stats->min = lanes[0] < stats->min ? lanes[0] : stats->min;
+    stats->min = lanes[1] < stats->min ? lanes[1] : stats->min;
+    _mm_storeu_pd(lanes, max);
+    stats->max = lanes[0] > stats->max ? lanes[0] : stats->max;
+    stats->max = lanes[1] > stats->max ? lanes[1] : stats->max;
+    uint64_t counts[2];
+    _mm_storeu_si128((__m128i *)counts, clipped_low);
+    stats->clipped_low += (uint32_t)(counts[0] + counts[1]);
+    _mm_storeu_si128((__m128i *)counts, clipped_high);
+    stats->clipped_high += (uint32_t)(counts[0] + counts[1]);
+
+    for (; i < n; i++)
+    {
+        out[i] = quantize_one(in[i] * FRACTION_DIVISOR, params, stats);
+    }
+}
+
+// Pass the mode as a constant, so each call gets its own copy of the kernel with only that mode's work in it.
+static void quantize_block_f32(const float * in, fixed_point_t * out, size_t n, const quantize_params_t * params,
+                               fixed_quantize_stats_t * stats)
+{
+    switch (params->mode)
+    {
+        case FIXED_ROUND_HALF_UP:
+            quantize_block_f32_mode(in, out, n, params, stats, FIXED_ROUND_HALF_UP);
+            break;
+        case FIXED_ROUND_HALF_EVEN:
+            quantize_block_f32_mode(in, out, n, params, stats, FIXED_ROUND_HALF_EVEN);
+            break;
+        case FIXED_ROUND_TRUNCATE:
+        default:
+            quantize_block_f32_mode(in, out, n, params, stats, FIXED_ROUND_TRUNCATE);
+            break;
+    }
+}
+
+static void quantize_block_f64(const double * in, fixed_point_t * out, size_t n, const quantize_params_t * params,
+                               fixed_quantize_stats_t * stats)
+{
+    switch (params->mode)
+    {
+        case FIXED_ROUND_HALF_UP:
+            quantize_block_f64_mode(in, out, n, params, stats, FIXED_ROUND_HALF_UP);
+            break;
+        case FIXED_ROUND_HALF_EVEN:
+            quantize_block_f64_mode(in, out, n, params, stats, FIXED_ROUND_HALF_EVEN);
+            break;
+        case FIXED_ROUND_TRUNCATE:
+        default:
+            quantize_block_f64_mode(in, out, n, params, stats, FIXED_ROUND_TRUNCATE);
+            break;
+    }
+}
+
+#else // __SSE2__
+
+static void quantize_block_f32(const float * in, fixed_point_t * out, size_t n, const quantize_params_t * params,
+                               fixed_quantize_stats_t * stats)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        out[i] = quantize_one((double)in[i] * FRACTION_DIVISOR, params, stats);
+    }
+}
+
+static void quantize_block_f64(const double * in, fixed_point_t * out, size_t n, const quantize_params_t * params,
+                               fixed_quantize_stats_t * stats)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        out[i] = quantize_one(in[i] * FRACTION_DIVISOR, params, stats);
+    }
+}
+
+#endif // __SSE2__
+
+/// @brief      Quantize `n` floats to fixed-point: `in[i] * FRACTION_DIVISOR`, rounded per `mode`.
+/// @details    With `saturate`, results below 0 (and NaNs) become 0, and results above UINT32_MAX become UINT32_MAX.
+///             Without it, nothing is checked: negative results down to -32768.0 wrap around to two's complement,
+///             like fixed_point_t subtraction does, and anything else out of range gives an unspecified value.
+///             Values are counted in the statistics as clipped either way.
+/// @param[out] stats   Gets the statistics of each block of FIXED_QUANTIZE_BLOCK_VALUES values (the last one may
+///                     be partial): room for FIXED_QUANTIZE_NUM_BLOCKS(n) of them. May be NULL.
+void fixed_quantize_f32(const float * in, fixed_point_t * out, size_t n, fixed_round_mode_t mode, bool saturate,
+                        fixed_quantize_stats_t * stats)
+{
+    quantize_params_t params = make_params(mode, saturate);
+    for (size_t start = 0; start < n; start += FIXED_QUANTIZE_BLOCK_VALUES)
+    {
+        size_t count = n - start < FIXED_QUANTIZE_BLOCK_VALUES ? n - start : FIXED_QUANTIZE_BLOCK_VALUES;
+        fixed_quantize_stats_t block;
+        stats_init(&block, count);
+        quantize_block_f32(in + start, out + start, count, &params, &block);
+        if (stats != NULL)
+        {
+            finish_stats(&block);
+            stats[start / FIXED_QUANTIZE_BLOCK_VALUES] = block;
+        }
+    }
+}
+
+/// @brief      Quantize `n` doubles to fixed-point. Otherwise identical to fixed_quantize_f32().
+void fixed_quantize_f64(const double * in, fixed_point_t * out, size_t n, fixed_round_mode_t mode, bool saturate,
+                        fixed_quantize_stats_t * stats)
+{
+    quantize_params_t params = make_params(mode, saturate);
+    for (size_t start = 0; start < n; start += FIXED_QUANTIZE_BLOCK_VALUES)
+    {
+        size_t count = n - start < FIXED_QUANTIZE_BLOCK_VALUES ? n - start : FIXED_QUANTIZE_BLOCK_VALUES;
+        fixed_quantize_stats_t block;
+        stats_init(&block, count);
+        quantize_block_f64(in + start, out + start, count, &params, &block);
+        if (stats != NULL)
+        {
+            finish_stats(&block);
+            stats[start / FIXED_QUANTIZE_BLOCK_VALUES] = block;
+        }
+    }
+}
+
+/// @brief      Convert `n` fixed-point numbers to floats, rounded to the nearest float (only values of 256.0 and up
+///             can need rounding, since a float has 24 bits of precision).
+void fixed_dequantize_f32(const fixed_point_t * in, float * out, size_t n)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    // SSE2 only converts *signed* integers, so convert the top and bottom 16 bits separately. Each part converts and
+    // scales exactly, so adding them is the only rounding, just like the scalar `(float)in[i] / FRACTION_DIVISOR`.
+    const __m128i LOW16 = _mm_set1_epi32(0xFFFF);
+    const __m128 HIGH_SCALE = _mm_set1_ps(65536.0f / FRACTION_DIVISOR);
+    const __m128 LOW_SCALE = _mm_set1_ps(1.0f / FRACTION_DIVISOR);
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128i values = _mm_loadu_si128((const __m128i *)(in + i));
+        __m128 high = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(values, 16)), HIGH_SCALE);
+        __m128 low = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(values, LOW16)), LOW_SCALE);
+        _mm_storeu_ps(out + i, _mm_add_ps(high, low));
+    }
+#endif // __SSE2__
+    for (; i < n; i++)
+    {
+        out[i] = (float)in[i] / FRACTION_DIVISOR;
+    }
+}
+
+/// @brief      Convert `n` fixed-point numbers to doubles. Always exact.
+void fixed_dequantize_f64(const fixed_point_t * in, double * out, size_t n)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128d SIGN_FIX = _mm_set1_pd(TWO_POW_32 / FRACTION_DIVISOR);
+    const __m128d SCALE = _mm_set1_pd(1.0 / FRACTION_DIVISOR);
+    for (; i + 2 <= n; i += 2)
+    {
+        // Convert as signed, then add 2^32 back to the values that came out negative.
+        __m128d values = _mm_mul_pd(_mm_cvtepi32_pd(_mm_loadl_epi64((const __m128i *)(in + i))), SCALE);
+        __m128d negative = _mm_cmplt_pd(values, _mm_setzero_pd());
+        _mm_storeu_pd(out + i, _mm_add_pd(values, _mm_and_pd(negative, SIGN_FIX)));
+    }
+#endif // __SSE2__
+    for (; i < n; i++)
+    {
+        out[i] = (double)in[i] / FRACTION_DIVISOR;
+    }
+}
+
+/// @brief      Add the statistics of one block into a running total (ex: to get statistics for a whole array). The
+///             total should start out as a block with a count of 0, or as a copy of the first block.
+void fixed_quantize_stats_merge(fixed_quantize_stats_t * total, const fixed_quantize_stats_t * block)
+{
+    if (total->count == 0)
+    {
+        *total = *block;
+        return;
+    }
+    total->min = block->min < total->min ? block->min : total->min;
+    total->max = block->max > total->max ? block->max : total->max;
+    total->count += block->count;
+    total->clipped_low += block->clipped_low;
+    total->clipped_high += block->clipped_high;
+    total->best_fraction_bits = block->best_fraction_bits < total->best_fraction_bits ? block->best_fraction_bits
+                                                                                     : total->best_fraction_bits;
+}
@@ -0,0 +1,54 @@
+/*
+fixed_point_quantize
+- Batch conversion of float and double arrays to `fixed_point_t` (quantizing: `x * FRACTION_DIVISOR`, rounded) and
+  back (dequantizing), 4 values per instruction with SSE2's float <-> int conversions (cvttps2dq, cvtdq2ps, ...).
+- Rounding is done exactly, per fixed_round_mode_t, with no dependence on the CPU's current floating-point rounding
+  mode, so the SIMD path and the scalar path (used for the last few values, and without SSE2) always agree.
+- Scaling by FRACTION_DIVISOR is exact in floating point (it's a power of 2), so the only rounding is the final
+  conversion to an integer.
+- Per-block statistics (min, max, how many values clipped, and the best scale for the block) come out of the same
+  pass over the data, so gathering them doesn't cost a second trip through memory.
+*/
+
+#ifndef FIXED_POINT_QUANTIZE_H
+#define FIXED_POINT_QUANTIZE_H
+
+#include <stddef.h>
+
+#include "fixed_point.h"
+#include "fixed_point_round.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Statistics are gathered per block of this many values.
+#define FIXED_QUANTIZE_BLOCK_VALUES 256
+// The number of fixed_quantize_stats_t a call with `num_values` values fills in.
+#define FIXED_QUANTIZE_NUM_BLOCKS(num_values) \
+    (((num_values) + FIXED_QUANTIZE_BLOCK_VALUES - 1) / FIXED_QUANTIZE_BLOCK_VALUES)
+
+// What one block of input looked like.
+typedef struct fixed_quantize_stats_s
+{
+    double min;                // the smallest input value, ignoring NaNs; +infinity if there were none
+    double max;                // the largest input value, ignoring NaNs; -infinity if there were none
+    uint32_t count;            // number of values in the block
+    uint32_t clipped_low;      // values that rounded to below 0, plus NaNs
+    uint32_t clipped_high;     // values that rounded to above UINT32_MAX (ie: to 65536.0 or more)
+    uint8_t best_fraction_bits; // the most fraction bits (0 to 32) that would hold `max` without clipping
+} fixed_quantize_stats_t;
+
+void fixed_quantize_f32(const float * in, fixed_point_t * out, size_t n, fixed_round_mode_t mode, bool saturate,
+                        fixed_quantize_stats_t * stats);
+void fixed_quantize_f64(const double * in, fixed_point_t * out, size_t n, fixed_round_mode_t mode, bool saturate,
+                        fixed_quantize_stats_t * stats);
+void fixed_dequantize_f32(const fixed_point_t * in, float * out, size_t n);
+void fixed_dequantize_f64(const fixed_point_t * in, double * out, size_t n);
+void fixed_quantize_stats_merge(fixed_quantize_stats_t * total, const fixed_quantize_stats_t * block);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIXED_POINT_QUANTIZE_H
@@ -0,0 +1,530 @@
+/*
+fixed_point_ratio
+- See fixed_point_ratio.h.
+- Uses the GCC/Clang `__atomic` builtins and `__thread`, plus pthreads, so that it compiles identically as C99 and as
+  C++.
+*/
+
+// For posix_memalign() and pthreads when compiling with -std=c99.
+#define _POSIX_C_SOURCE 200112L
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "fixed_point_ratio.h"
+#include "fixed_point_round.h"
+
+// -----------------------------------------------------------------------------------------------------------------
+// Plans
+// -----------------------------------------------------------------------------------------------------------------
+
+static uint32_t greatest_common_divisor(uint32_t a, uint32_t b)
+{
+    while (b != 0)
+    {
+        uint32_t remainder = a % b;
+        a = b;
+        b = remainder;
+    }
+    return a;
+}
+
+// The number of bits needed to hold `value`; ex: 0 for 0, 1 for 1, 3 for 5.
+static uint8_t bit_length(uint64_t value)
+{
+    uint8_t num_bits = 0;
+    while (value != 0)
+    {
+        value >>= 1;
+        num_bits++;
+    }
+    return num_bits;
+}
+
+/// @brief      Work out how to scale `width`-bit values by times/divide: reduce the ratio to lowest terms, pick the
+///             cheapest exact method, and precompute the reciprocal of `divide` if it's needed.
+/// @param[in]  width       The most significant bits the values to be scaled can have, 1 to 64. Ex: 32 for a
+///                         `fixed_point_t`.
+/// @return     true on success; false if `divide` is 0 or `width` isn't 1 to 64.
+bool fixed_ratio_plan_init(fixed_ratio_plan_t * plan, uint32_t times, uint32_t divide, uint8_t width)
+{
+    plan->times = times;
+    plan->divide = divide;
+    plan->width = width;
+    if (divide == 0 || width == 0 || width > 64)
+    {
+        return false;
+    }
+
+    // gcd(0, divide) == divide, so times == 0 reduces to 0/1: FIXED_RATIO_MULTIPLY by 0.
+    uint32_t gcd = greatest_common_divisor(times, divide);
+    plan->reduced_times = times / gcd;
+    plan->reduced_divide = divide / gcd;
+    plan->shift = 0;
+    plan->split = false;
+    fixed_recip_init(&plan->recip, plan->reduced_divide);
+
+    if (plan->reduced_times == plan->reduced_divide)
+    {
+        plan->method = FIXED_RATIO_IDENTITY;
+    }
+    else if (plan->reduced_divide == 1)
+    {
+        plan->method = FIXED_RATIO_MULTIPLY;
+    }
+    else if ((plan->reduced_divide & (plan->reduced_divide - 1)) == 0)
+    {
+        plan->method = FIXED_RATIO_SHIFT;
+        plan->shift = (uint8_t)(bit_length(plan->reduced_divide) - 1);
+    }
+    else
+    {
+        plan->method = FIXED_RATIO_RECIPROCAL;
+    }
+
+    // A multiply or a divide can make the result grow, so check whether the product can overflow 64 bits.
+    plan->split = plan->method != FIXED_RATIO_IDENTITY && width + bit_length(plan->reduced_times) > 64;
+    // Dividing here, once, keeps a 64-bit divide instruction out of every fixed_ratio_apply().
+    plan->split_limit = plan->split ? UINT64_MAX / plan->reduced_times : UINT64_MAX;
+    return true;
+}
+
+// numerator/reduced_divide and numerator%reduced_divide, for any 64-bit numerator.
+static uint64_t plan_divmod(const fixed_ratio_plan_t * plan, uint64_t numerator, uint32_t * remainder)
+{
+    switch (plan->method)
+    {
+        case FIXED_RATIO_IDENTITY:
+        case FIXED_RATIO_MULTIPLY:
+            *remainder = 0;
+            return numerator;
+        case FIXED_RATIO_SHIFT:
+            *remainder = (uint32_t)(numerator & (plan->reduced_divide - 1));
+            return numerator >> plan->shift;
+        case FIXED_RATIO_RECIPROCAL:
+        default:
+            return fixed_recip_divmod_u64(numerator, &plan->recip, remainder);
+    }
+}
+
+/// @brief      round(value*times/divide), rounded half up, exactly. `value` must fit in `plan->width` bits.
+///             Results that don't fit in 64 bits saturate to UINT64_MAX.
+/// @details    When `value*times` can't overflow 64 bits, this is just a multiply and a divide. When it can, the
+///             value is split first, into q = value/divide and r = value%divide, since then
+///             value*times/divide = q*times + r*times/divide, where r*times < divide*times always fits in 64 bits.
+///             Either way the rounding is decided from the final remainder, so nothing is rounded twice.
+uint64_t fixed_ratio_apply(const fixed_ratio_plan_t * plan, uint64_t value)
+{
+    uint32_t remainder;
+    uint64_t quotient;
+    uint64_t whole = 0;
+
+    if (plan->method == FIXED_RATIO_IDENTITY)
+    {
+        return value;
+    }
+    if (plan->split)
+    {
+        uint64_t q = plan_divmod(plan, value, &remainder);
+        // q*times overflows only if q > UINT64_MAX/times.
+        if (q > plan->split_limit)
+        {
+            return UINT64_MAX;
+        }
+        whole = q * plan->reduced_times;
+        value = remainder;
+    }
+    else if (plan->method == FIXED_RATIO_MULTIPLY)
+    {
+        return value * plan->reduced_times;
+    }
+
+    quotient = plan_divmod(plan, value * plan->reduced_times, &remainder);
+    quotient += (uint64_t)fixed_round_up_needed((int)(quotient & 1), remainder, plan->reduced_divide - remainder,
+                                                FIXED_ROUND_HALF_UP);
+    return whole > UINT64_MAX - quotient ? UINT64_MAX : whole + quotient;
+}
+
+/// @brief      out[i] = round(values[i]*times/divide) for n fixed-point numbers, saturating at UINT32_MAX. Same as
+///             fixed_ratio_apply32() on each. `out` may be the same as `values`.
+void fixed_ratio_apply_batch(const fixed_ratio_plan_t * plan, fixed_point_t * out, const fixed_point_t * values,
+                             size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        out[i] = fixed_ratio_apply32(plan, values[i]);
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------
+// Reader slots
+// -----------------------------------------------------------------------------------------------------------------
+
+// Each thread that does lock-free lookups claims a reader slot index, 0 to FIXED_RATIO_CACHE_MAX_READERS - 1, the
+// first time it does one; it's the same index in every cache. It's given back by a pthread key destructor when the
+// thread exits. This bitmap tracks which indexes are taken.
+#define READER_WORD_BITS 64
+static uint64_t reader_indexes_taken[FIXED_RATIO_CACHE_MAX_READERS / READER_WORD_BITS];
+static __thread int reader_index = -1;
+static pthread_key_t reader_index_key;
+static pthread_once_t reader_index_key_once = PTHREAD_ONCE_INIT;
+
+static void release_reader_index(void * index_plus_1)
+{
+    size_t index = (size_t)(uintptr_t)index_plus_1 - 1;
+    __atomic_fetch_and(&reader_indexes_taken[index / READER_WORD_BITS],
+                       ~((uint64_t)1 << (index % READER_WORD_BITS)), __ATOMIC_RELEASE);
+}
+
+static void create_reader_index_key(void)
+{
+    pthread_key_create(&reader_index_key, release_reader_index);
+}
+
+// This thread's reader slot index, claiming one if it doesn't have one yet; or -1 if they're all taken.
+static int get_reader_index(void)
+{
+    if (reader_index >= 0)
+    {
+        return reader_index;
+    }
+
+    pthread_once(&reader_index_key_once, create_reader_index_key);
+    for (size_t word = 0; word < FIXED_RATIO_CACHE_MAX_READERS / READER_WORD_BITS; word++)
+    {
+        uint64_t taken = __atomic_load_n(&reader_indexes_taken[word], __ATOMIC_RELAXED);
+        while (taken != UINT64_MAX)
+        {
+            // Claim the lowest free bit.
+            int bit = 0;
+            while (taken & ((uint64_t)1 << bit))
+            {
+                bit++;
+            }
+            if (__atomic_compare_exchange_n(&reader_indexes_taken[word], &taken, taken | ((uint64_t)1 << bit),
+                                            false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            {
+                int index = (int)(word * READER_WORD_BITS) + bit;
+                if (pthread_setspecific(reader_index_key, (void *)(uintptr_t)(index + 1)) != 0)
+                {
+                    // Without the destructor the index would never be given back, so don't keep it.
+                    release_reader_index((void *)(uintptr_t)(index + 1));
+                    return -1;
+                }
+                reader_index = index;
+                return index;
+            }
+            // Lost a race for it; `taken` now holds the latest bits, so try again.
+        }
+    }
+    return -1;
+}
+
+// -----------------------------------------------------------------------------------------------------------------
+// Cache
+// -----------------------------------------------------------------------------------------------------------------
+
+// An open-addressing hash table of plan pointers, with linear probing. A NULL slot is empty. Slots only ever go from
+// NULL to a plan, never back, which is what lets readers probe without a lock.
+typedef struct ratio_table_s
+{
+    size_t capacity; // always a power of 2
+    const fixed_ratio_plan_t ** slots;
+    struct ratio_table_s * next_retired; // for the cache's list of retired tables
+    uint64_t retired_epoch;              // the epoch the table was retired in
+} ratio_table_t;
+
+// One reader's announcement of the epoch it's reading in (0 when it's not reading), on its own cache line so that
+// readers don't slow each other down.
+typedef struct ratio_reader_s
+{
+    uint64_t epoch;
+    uint8_t padding[64 - sizeof(uint64_t)];
+} ratio_reader_t;
+
+struct fixed_ratio_cache_s
+{
+    ratio_reader_t readers[FIXED_RATIO_CACHE_MAX_READERS];
+    ratio_table_t * table;   // the current table; swapped atomically
+    uint64_t epoch;          // starts at 1 and only goes up; bumped every time a table is retired
+
+    // Everything below is only touched with `write_lock` held.
+    pthread_mutex_t write_lock;
+    size_t count;            // the number of plans in `table`
+    ratio_table_t * retired; // tables that have been replaced, but that readers might still be using
+};
+
+static uint32_t hash_key(uint32_t times, uint32_t divide, uint8_t width)
+{
+    // Mix the key, then finish with the MurmurHash3 32-bit finalizer so every input bit affects every output bit.
+    uint32_t hash = times * 0x9E3779B1u ^ (divide + 0x7F4A7C15u) * 0x85EBCA77u ^ width * 0xC2B2AE3Du;
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6Bu;
+    hash ^= hash >> 13;
+    hash *= 0xC2B2AE35u;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+static ratio_table_t * table_create(size_t capacity)
+{
+    ratio_table_t * table = (ratio_table_t *)malloc(sizeof(ratio_table_t));
+    if (table == NULL)
+    {
+        return NULL;
+    }
+    table->slots = (const fixed_ratio_plan_t **)calloc(capacity, sizeof(table->slots[0]));
+    if (table->slots == NULL)
+    {
+        free(table);
+        return NULL;
+    }
+    table->capacity = capacity;
+    table->next_retired = NULL;
+    table->retired_epoch = 0;
+    return table;
+}
+
+static void table_free(ratio_table_t * table)
+{
+    free(table->slots);
+    free(table);
+}
+
+// Look up a plan in `table` without a lock. Takes at most `capacity` probes, and since the table is never more than
+// half full, usually just 1 or 2.
+static const fixed_ratio_plan_t * table_find(const ratio_table_t * table, uint32_t times, uint32_t divide,
+                                             uint8_t width)
+{
+    size_t mask = table->capacity - 1;
+    size_t i = hash_key(times, divide, width) & mask;
+    for (size_t num_probes = 0; num_probes < table->capacity; num_probes++)
+    {
+        // Acquire, so that if we see the plan pointer, we see the plan's contents too.
+        const fixed_ratio_plan_t * plan = __atomic_load_n(&table->slots[i], __ATOMIC_ACQUIRE);
+        if (plan == NULL)
+        {
+            return NULL;
+        }
+        if (plan->times == times && plan->divide == divide && plan->width == width)
+        {
+            return plan;
+        }
+        i = (i + 1) & mask;
+    }
+    return NULL;
+}
+
+// Put a plan into the first empty slot for it. The caller holds the write lock.
+static void table_insert(ratio_table_t * table, const fixed_ratio_plan_t * plan)
+{
+    size_t mask = table->capacity - 1;
+    size_t i = hash_key(plan->times, plan->divide, plan->width) & mask;
+    while (table->slots[i] != NULL)
+    {
+        i = (i + 1) & mask;
+    }
+    // Release, so that readers who see the pointer see a fully-built plan.
+    __atomic_store_n(&table->slots[i], plan, __ATOMIC_RELEASE);
+}
+
+/// @brief      Create an empty plan cache.
+/// @param[in]  initial_capacity    Roughly how many distinct ratios you expect. It grows as needed either way.
+/// @return     The cache, or NULL if out of memory.
+fixed_ratio_cache_t * fixed_ratio_cache_create(size_t initial_capacity)
+{
+    void * memory = NULL;
+    if (posix_memalign(&memory, sizeof(ratio_reader_t), sizeof(fixed_ratio_cache_t)) != 0)
+    {
+        return NULL;
+    }
+    fixed_ratio_cache_t * cache = (fixed_ratio_cache_t *)memory;
+
+    // Keep the table at most half full, so probe sequences stay short.
+    size_t capacity = 16;
+    while (capacity < 2*initial_capacity)
+    {
+        capacity *= 2;
+    }
+    cache->table = table_create(capacity);
+    if (cache->table == NULL || pthread_mutex_init(&cache->write_lock, NULL) != 0)
+    {
+        if (cache->table != NULL)
+        {
+            table_free(cache->table);
+        }
+        free(cache);
+        return NULL;
+    }
+    for (size_t i = 0; i < FIXED_RATIO_CACHE_MAX_READERS; i++)
+    {
+        cache->readers[i].epoch = 0;
+    }
+    cache->epoch = 1;
+    cache->count = 0;
+    cache->retired = NULL;
+    return cache;
+}
+
+/// @brief      Free a cache, its tables, and all of its plans. No other thread may be using it, or any plan from it.
+void fixed_ratio_cache_destroy(fixed_ratio_cache_t * cache)
+{
+    if (cache == NULL)
+    {
+        return;
+    }
+    // Every plan is in the current table exactly once (retired tables only hold copies of the same pointers).
+    for (size_t i = 0; i < cache->table->capacity; i++)
+    {
+        free((void *)cache->table->slots[i]);
+    }
+    table_free(cache->table);
+    while (cache->retired != NULL)
+    {
+        ratio_table_t * next = cache->retired->next_retired;
+        table_free(cache->retired);
+        cache->retired = next;
+    }
+    pthread_mutex_destroy(&cache->write_lock);
+    free(cache);
+}
+
+// Free every retired table that no reader can still be using. The caller holds the write lock.
+static void reclaim_retired_tables(fixed_ratio_cache_t * cache)
+{
+    // A reader that announced an epoch older than a table's retirement may still be probing that table. A reader that
+    // announced the retirement epoch or a later one loaded the table pointer after the swap, so it has the new table.
+    uint64_t oldest_reader_epoch = UINT64_MAX;
+    for (size_t i = 0; i < FIXED_RATIO_CACHE_MAX_READERS; i++)
+    {
+        uint64_t epoch = __atomic_load_n(&cache->readers[i].epoch, __ATOMIC_SEQ_CST);
+        if (epoch != 0 && epoch < oldest_reader_epoch)
+        {
+            oldest_reader_epoch = epoch;
+        }
+    }
+
+    ratio_table_t ** link = &cache->retired;
+    while (*link != NULL)
+    {
+        ratio_table_t * table = *link;
+        if (table->retired_epoch <= oldest_reader_epoch)
+        {
+            *link = table->next_retired;
+            table_free(table);
+        }
+        else
+        {
+            link = &table->next_retired;
+        }
+    }
+}
+
+// Replace the table with one twice the size, retiring the old one. The caller holds the write lock.
+static bool grow_table(fixed_ratio_cache_t * cache)
+{
+    ratio_table_t * old_table = cache->table;
+    ratio_table_t * new_table = table_create(2*old_table->capacity);
+    if (new_table == NULL)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < old_table->capacity; i++)
+    {
+        if (old_table->slots[i] != NULL)
+        {
+            table_insert(new_table, old_table->slots[i]);
+        }
+    }
+
+    // Publish the new table, *then* start a new epoch; readers who see the new epoch are sure to see the new table.
+    __atomic_store_n(&cache->table, new_table, __ATOMIC_SEQ_CST);
+    old_table->retired_epoch = __atomic_add_fetch(&cache->epoch, 1, __ATOMIC_SEQ_CST);
+    old_table->next_retired = cache->retired;
+    cache->retired = old_table;
+    return true;
+}
+
+// The slow path: find or add a plan with the write lock held.
+static const fixed_ratio_plan_t * find_or_add(fixed_ratio_cache_t * cache, uint32_t times, uint32_t divide,
+                                              uint8_t width)
+{
+    pthread_mutex_lock(&cache->write_lock);
+
+    // Another thread may have added it since our lock-free lookup missed.
+    const fixed_ratio_plan_t * found = table_find(cache->table, times, divide, width);
+    if (found != NULL)
+    {
+        pthread_mutex_unlock(&cache->write_lock);
+        return found;
+    }
+
+    fixed_ratio_plan_t * plan = (fixed_ratio_plan_t *)malloc(sizeof(fixed_ratio_plan_t));
+    if (plan == NULL || !fixed_ratio_plan_init(plan, times, divide, width)
+        || (2*(cache->count + 1) > cache->table->capacity && !grow_table(cache)))
+    {
+        free(plan);
+        pthread_mutex_unlock(&cache->write_lock);
+        return NULL;
+    }
+    table_insert(cache->table, plan);
+    cache->count++;
+    reclaim_retired_tables(cache);
+
+    pthread_mutex_unlock(&cache->write_lock);
+    return plan;
+}
+
+/// @brief      Get the plan for scaling `width`-bit values by times/divide, making and caching it if this is the
+///             first time it's been asked for. Safe to call from any number of threads at once.
+/// @details    When the plan is already cached (ie: almost always), this never locks or waits: it announces which
+///             epoch it's reading in, probes the table, and clears its announcement.
+/// @return     The plan, valid until the cache is destroyed; or NULL if `divide` is 0, `width` isn't 1 to 64, or
+///             out of memory.
+const fixed_ratio_plan_t * fixed_ratio_cache_get(fixed_ratio_cache_t * cache, uint32_t times, uint32_t divide,
+                                                 uint8_t width)
+{
+    int reader = get_reader_index();
+    if (reader >= 0)
+    {
+        uint64_t * announcement = &cache->readers[reader].epoch;
+        // Sequentially-consistent announcement, so that it's visible to a writer scanning the announcements before we
+        // load the table pointer below.
+        __atomic_store_n(announcement, __atomic_load_n(&cache->epoch, __ATOMIC_SEQ_CST), __ATOMIC_SEQ_CST);
+        const ratio_table_t * table = __atomic_load_n(&cache->table, __ATOMIC_SEQ_CST);
+        const fixed_ratio_plan_t * plan = table_find(table, times, divide, width);
+        __atomic_store_n(announcement, 0, __ATOMIC_RELEASE);
+        if (plan != NULL)
+        {
+            return plan;
+        }
+    }
+    return find_or_add(cache, times, divide, width);
+}
+
+// The process-wide default cache, made on first use and never destroyed.
+static fixed_ratio_cache_t * default_cache = NULL;
+static pthread_once_t default_cache_once = PTHREAD_ONCE_INIT;
+
+static void create_default_cache(void)
+{
+    __atomic_store_n(&default_cache, fixed_ratio_cache_create(64), __ATOMIC_RELEASE);
+}
+
+/// @brief      fixed_ratio_cache_get() on the process-wide default cache.
+const fixed_ratio_plan_t * fixed_ratio_plan_get(uint32_t times, uint32_t divide, uint8_t width)
+{
+    // Skip pthread_once() (a function call) once the cache exists.
+    fixed_ratio_cache_t * cache = __atomic_load_n(&default_cache, __ATOMIC_ACQUIRE);
+    if (cache == NULL)
+    {
+        pthread_once(&default_cache_once, create_default_cache);
+        cache = __atomic_load_n(&default_cache, __ATOMIC_ACQUIRE);
+        if (cache == NULL)
+        {
+            return NULL;
+        }
+    }
+    return fixed_ratio_cache_get(cache, times, divide, width);
+}
@@ -0,0 +1,108 @@
+/*
+fixed_point_ratio
+- Scaling by a runtime ratio, `value*times/divide`, rounded half up: the operation that approaches 1 through 8 in
+  fixed_point_math.cpp work out by hand for `price`, done exactly for any `times`, `divide`, and value width.
+- Scaling by the same ratio over and over should not redo the same setup work every time (reducing the fraction,
+  picking a method, computing the reciprocal of `divide`), so that work is done once into a `fixed_ratio_plan_t`,
+  which is then applied to as many values as you like.
+- Plans are cached in a `fixed_ratio_cache_t`: a process-wide (or per-instance), read-mostly hash table keyed on
+  (times, divide, width), safe to share between any number of threads:
+  - Looking a plan up never takes a lock and never waits on another thread (wait-free): it's a few atomic loads plus
+    a linear probe of an open-addressing table.
+  - Adding a plan that isn't cached yet takes a mutex. Those are rare: once per distinct ratio.
+  - When the table fills up, it's copied into one twice the size, and the new one is swapped in with a single atomic
+    store. Readers still probing the old table are tracked with epochs (epoch-based reclamation, an RCU-style
+    scheme), and the old table is freed only once no reader can still be using it.
+  - Plans are never moved or freed while the cache exists, so the plan pointers returned stay valid until the cache
+    is destroyed.
+*/
+
+#ifndef FIXED_POINT_RATIO_H
+#define FIXED_POINT_RATIO_H
+
+#include <stddef.h>
+
+#include "fixed_point.h"
+#include "fixed_point_div.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The most threads that can use a cache's lock-free lookups at once. Beyond this, lookups are still correct but take
+// the mutex. A thread's reader slot is given back when the thread exits.
+#define FIXED_RATIO_CACHE_MAX_READERS 256
+
+typedef enum fixed_ratio_method_e
+{
+    // times == divide: the value is unchanged.
+    FIXED_RATIO_IDENTITY = 0,
+    // divide == 1 (once the ratio is reduced to lowest terms): just multiply.
+    FIXED_RATIO_MULTIPLY,
+    // divide == 2^shift: multiply, then round and shift right.
+    FIXED_RATIO_SHIFT,
+    // Anything else: multiply, then divide by multiplying by divide's precomputed reciprocal (see fixed_point_div.h).
+    FIXED_RATIO_RECIPROCAL,
+} fixed_ratio_method_t;
+
+// How to compute round(value*times/divide) for one (times, divide, width). Fill it in with fixed_ratio_plan_init(),
+// or get a shared, cached one from fixed_ratio_cache_get() or fixed_ratio_plan_get().
+typedef struct fixed_ratio_plan_s
+{
+    // The key this plan was made for. `width` is the most significant bits the values to be scaled can have, 1 to 64.
+    uint32_t times;
+    uint32_t divide;
+    uint8_t width;
+
+    // times/divide reduced to lowest terms, and how to apply it.
+    uint32_t reduced_times;
+    uint32_t reduced_divide;
+    fixed_ratio_method_t method;
+    uint8_t shift;        // for FIXED_RATIO_SHIFT: reduced_divide == 1 << shift
+    // Whether a `width`-bit value times `reduced_times` can overflow 64 bits, in which case values are first split
+    // into value/divide and value%divide (see fixed_ratio_apply()).
+    bool split;
+    uint64_t split_limit; // for split plans: UINT64_MAX/reduced_times, the largest value/divide that can't overflow
+    fixed_recip_t recip;  // for FIXED_RATIO_RECIPROCAL: the reciprocal of reduced_divide
+} fixed_ratio_plan_t;
+
+typedef struct fixed_ratio_cache_s fixed_ratio_cache_t;
+
+bool fixed_ratio_plan_init(fixed_ratio_plan_t * plan, uint32_t times, uint32_t divide, uint8_t width);
+uint64_t fixed_ratio_apply(const fixed_ratio_plan_t * plan, uint64_t value);
+void fixed_ratio_apply_batch(const fixed_ratio_plan_t * plan, fixed_point_t * out, const fixed_point_t * values,
+                             size_t n);
+
+fixed_ratio_cache_t * fixed_ratio_cache_create(size_t initial_capacity);
+void fixed_ratio_cache_destroy(fixed_ratio_cache_t * cache);
+const fixed_ratio_plan_t * fixed_ratio_cache_get(fixed_ratio_cache_t * cache, uint32_t times, uint32_t divide,
+                                                 uint8_t width);
+const fixed_ratio_plan_t * fixed_ratio_plan_get(uint32_t times, uint32_t divide, uint8_t width);
+
+/// @brief      round(value*times/divide) for a 32-bit value (ex: a `fixed_point_t`), rounded half up, exactly.
+///             Results that don't fit in 32 bits saturate to UINT32_MAX.
+static inline FIXED_CONSTEXPR uint32_t fixed_ratio_apply32(const fixed_ratio_plan_t * plan, uint32_t value)
+{
+    // A 32-bit value times a 32-bit `times` always fits in 64 bits, so there is never any need to split here.
+    uint64_t product = (uint64_t)value * plan->reduced_times;
+    switch (plan->method)
+    {
+        case FIXED_RATIO_IDENTITY:
+            return value;
+        case FIXED_RATIO_MULTIPLY:
+            return product > UINT32_MAX ? UINT32_MAX : (uint32_t)product;
+        case FIXED_RATIO_SHIFT:
+            // (product + divide/2) can't overflow: product <= (2^32 - 1)^2, and divide/2 < 2^31.
+            product = (product + (plan->reduced_divide >> 1)) >> plan->shift;
+            return product > UINT32_MAX ? UINT32_MAX : (uint32_t)product;
+        case FIXED_RATIO_RECIPROCAL:
+        default:
+            return fixed_recip_div_round(product, &plan->recip);
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIXED_POINT_RATIO_H
@@ -0,0 +1,443 @@
+/*
+fixed_point_requantize
+- See fixed_point_requantize.h.
+*/
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE4_1__)
+#include <smmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "fixed_point_requantize.h"
+
+// XORed into unsigned input, this flips the sign bit, which subtracts 2^31 and makes it a valid int32_t.
+#define SIGN_BIT 0x80000000u
+// The i16 version converts this many samples at a time through a buffer on the stack.
+#define I16_BUFFER_SAMPLES 256
+
+// What the public functions differ in: the input's type, and the output's range.
+typedef struct requantize_range_s
+{
+    uint32_t flip;  // XORed into every input: SIGN_BIT for unsigned input, else 0
+    int32_t offset; // added to every output: 2^(31 - shift) for unsigned input (adding the 2^31 back), else 0
+    int32_t lo;     // the output's range
+    int32_t hi;
+} requantize_range_t;
+
+// -----------------------------------------------------------------------------------------------------------------
+// Random bits for stochastic rounding
+// -----------------------------------------------------------------------------------------------------------------
+
+// A 32-bit integer hash with good avalanche (Chris Wellons' "lowbias32"): every input bit affects every output bit.
+// Only 32-bit multiplies, so SIMD can do it too.
+static uint32_t mix32(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7FEB352Du;
+    x ^= x >> 15;
+    x *= 0x846CA68Bu;
+    x ^= x >> 16;
+    return x;
+}
+
+// Sample `position`'s random bits are mix32(low 32 bits of position ^ window key), where the window key depends on
+// the seed and the position's high 32 bits. So the stream is a pure function of (seed, position).
+static uint32_t window_key(uint64_t key, uint64_t position)
+{
+    return mix32((uint32_t)(key >> 32) ^ mix32((uint32_t)key + (uint32_t)(position >> 32)));
+}
+
+// -----------------------------------------------------------------------------------------------------------------
+// Scalar
+// -----------------------------------------------------------------------------------------------------------------
+
+// A uint32_t's bits as an int32_t, without the implementation-defined conversion of values over INT32_MAX.
+static int32_t to_signed(uint32_t x)
+{
+    return x <= INT32_MAX ? (int32_t)x : -(int32_t)(~x) - 1;
+}
+
+// `floor(x / 2^shift)`. Biased to be non-negative first, since right-shifting a negative number is
+// implementation-defined in C.
+static int32_t floor_shift(int32_t x, uint8_t shift)
+{
+    return (int32_t)(((uint32_t)x ^ SIGN_BIT) >> shift) - (int32_t)(SIGN_BIT >> shift);
+}
+
+// `floored + up`, saturated to the range. `floored` is already in range, except for the i16 version's low end.
+// (Checking for INT32_MAX first keeps the add from overflowing: the unsigned output of a 1-bit shift goes that high.)
+static int32_t round_up_and_clamp(int32_t floored, uint32_t up, const requantize_range_t * range)
+{
+    int32_t y = floored + (int32_t)(up & (floored != INT32_MAX));
+    return y < range->lo ? range->lo : y > range->hi ? range->hi : y;
+}
+
+static int32_t half_even_one(int32_t x, uint8_t shift, const requantize_range_t * range)
+{
+    int32_t floored = floor_shift(x, shift) + range->offset;
+    uint32_t fraction = (uint32_t)x & ((1u << shift) - 1);
+    uint32_t half = 1u << (shift - 1);
+    return round_up_and_clamp(floored, fraction > half || (fraction == half && (floored & 1)), range);
+}
+
+static int32_t stochastic_one(int32_t x, uint8_t shift, uint32_t random, const requantize_range_t * range)
+{
+    int32_t floored = floor_shift(x, shift) + range->offset;
+    uint32_t fraction = (uint32_t)x & ((1u << shift) - 1);
+    // Up if the dropped bits plus a uniform random number in [0, 2^shift) carry into the next bit. Can't overflow:
+    // both are < 2^shift <= 2^31.
+    return round_up_and_clamp(floored, (fraction + (random >> (32 - shift))) >> shift, range);
+}
+
+static int32_t clamp64(int64_t y, const requantize_range_t * range)
+{
+    return y < range->lo ? range->lo : y > range->hi ? range->hi : (int32_t)y;
+}
+
+// -----------------------------------------------------------------------------------------------------------------
+// SIMD
+// -----------------------------------------------------------------------------------------------------------------
+
+#if defined(__AVX2__)
+
+static __m256i mix32_x8(__m256i x)
+{
+    x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+    x = _mm256_mullo_epi32(x, _mm256_set1_epi32(0x7FEB352D));
+    x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 15));
+    x = _mm256_mullo_epi32(x, _mm256_set1_epi32((int)0x846CA68Bu));
+    return _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+}
+
+// round_up_and_clamp() for 8 lanes. `up` is 0 or 1 in each lane.
+static __m256i round_up_and_clamp_x8(__m256i floored, __m256i up, const requantize_range_t * range)
+{
+    up = _mm256_andnot_si256(_mm256_cmpeq_epi32(floored, _mm256_set1_epi32(INT32_MAX)), up);
+    __m256i y = _mm256_add_epi32(floored, up);
+    y = _mm256_max_epi32(y, _mm256_set1_epi32(range->lo));
+    return _mm256_min_epi32(y, _mm256_set1_epi32(range->hi));
+}
+
+static __m256i half_even_x8(__m256i x, uint8_t shift, const requantize_range_t * range)
+{
+    const __m128i SHIFT = _mm_cvtsi32_si128(shift);
+    const __m256i ONE = _mm256_set1_epi32(1);
+    const __m256i HALF = _mm256_set1_epi32((int)(1u << (shift - 1)));
+    __m256i floored = _mm256_add_epi32(_mm256_sra_epi32(x, SHIFT), _mm256_set1_epi32(range->offset));
+    __m256i fraction = _mm256_and_si256(x, _mm256_set1_epi32((int)((1u << shift) - 1)));
+    // Both are non-negative and < 2^31, so the signed compares work.
+    __m256i above = _mm256_cmpgt_epi32(fraction, HALF);
+    __m256i tie_odd = _mm256_and_si256(_mm256_cmpeq_epi32(fraction, HALF), _mm256_slli_epi32(floored, 31));
+    __m256i up = _mm256_and_si256(_mm256_or_si256(above, _mm256_srai_epi32(tie_odd, 31)), ONE);
+    return round_up_and_clamp_x8(floored, up, range);
+}
+
+static __m256i stochastic_x8(__m256i x, __m256i random, uint8_t shift, const requantize_range_t * range)
+{
+    const __m128i SHIFT = _mm_cvtsi32_si128(shift);
+    __m256i floored = _mm256_add_epi32(_mm256_sra_epi32(x, SHIFT), _mm256_set1_epi32(range->offset));
+    __m256i fraction = _mm256_and_si256(x, _mm256_set1_epi32((int)((1u << shift) - 1)));
+    random = _mm256_srl_epi32(random, _mm_cvtsi32_si128(32 - shift));
+    __m256i up = _mm256_srl_epi32(_mm256_add_epi32(fraction, random), SHIFT);
+    return round_up_and_clamp_x8(floored, up, range);
+}
+
+#endif
+
+#if defined(__SSE2__)
+
+static __m128i mullo_epi32(__m128i a, __m128i b)
+{
+#if defined(__SSE4_1__)
+    return _mm_mullo_epi32(a, b);
+#else
+    // 32x32 = 64-bit multiplies of the even lanes and of the odd lanes, then gather up the low halves.
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+#endif
+}
+
+static __m128i clamp_epi32(__m128i y, int32_t lo, int32_t hi)
+{
+#if defined(__SSE4_1__)
+    return _mm_min_epi32(_mm_max_epi32(y, _mm_set1_epi32(lo)), _mm_set1_epi32(hi));
+#else
+    __m128i low = _mm_cmplt_epi32(y, _mm_set1_epi32(lo));
+    y = _mm_or_si128(_mm_andnot_si128(low, y), _mm_and_si128(low, _mm_set1_epi32(lo)));
+    __m128i high = _mm_cmpgt_epi32(y, _mm_set1_epi32(hi));
+    return _mm_or_si128(_mm_andnot_si128(high, y), _mm_and_si128(high, _mm_set1_epi32(hi)));
+#endif
+}
+
+static __m128i mix32_x4(__m128i x)
+{
+    x = _mm_xor_si128(x, _mm_srli_epi32(x, 16));
+    x = mullo_epi32(x, _mm_set1_epi32(0x7FEB352D));
+    x = _mm_xor_si128(x, _mm_srli_epi32(x, 15));
+    x = mullo_epi32(x, _mm_set1_epi32((int)0x846CA68Bu));
+    return _mm_xor_si128(x, _mm_srli_epi32(x, 16));
+}
+
+// The 4-lane versions of the AVX2 kernels above.
+static __m128i round_up_and_clamp_x4(__m128i floored, __m128i up, const requantize_range_t * range)
+{
+    up = _mm_andnot_si128(_mm_cmpeq_epi32(floored, _mm_set1_epi32(INT32_MAX)), up);
+    return clamp_epi32(_mm_add_epi32(floored, up), range->lo, range->hi);
+}
+
+static __m128i half_even_x4(__m128i x, uint8_t shift, const requantize_range_t * range)
+{
+    const __m128i SHIFT = _mm_cvtsi32_si128(shift);
+    const __m128i ONE = _mm_set1_epi32(1);
+    const __m128i HALF = _mm_set1_epi32((int)(1u << (shift - 1)));
+    __m128i floored = _mm_add_epi32(_mm_sra_epi32(x, SHIFT), _mm_set1_epi32(range->offset));
+    __m128i fraction = _mm_and_si128(x, _mm_set1_epi32((int)((1u << shift) - 1)));
+    __m128i above = _mm_cmpgt_epi32(fraction, HALF);
+    __m128i tie_odd = _mm_and_si128(_mm_cmpeq_epi32(fraction, HALF), _mm_slli_epi32(floored, 31));
+    __m128i up = _mm_and_si128(_mm_or_si128(above, _mm_srai_epi32(tie_odd, 31)), ONE);
+    return round_up_and_clamp_x4(floored, up, range);
+}
+
+static __m128i stochastic_x4(__m128i x, __m128i random, uint8_t shift, const requantize_range_t * range)
+{
+    const __m128i SHIFT = _mm_cvtsi32_si128(shift);
+    __m128i floored = _mm_add_epi32(_mm_sra_epi32(x, SHIFT), _mm_set1_epi32(range->offset));
+    __m128i fraction = _mm_and_si128(x, _mm_set1_epi32((int)((1u << shift) - 1)));
+    random = _mm_srl_epi32(random, _mm_cvtsi32_si128(32 - shift));
+    __m128i up = _mm_srl_epi32(_mm_add_epi32(fraction, random), SHIFT);
+    return round_up_and_clamp_x4(floored, up, range);
+}
+
+#endif
+
+// -----------------------------------------------------------------------------------------------------------------
+// Modes
+// -----------------------------------------------------------------------------------------------------------------
+
+static void half_even(const int32_t * in, int32_t * out, size_t n, uint8_t shift, const requantize_range_t * range)
+{
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256i FLIP = _mm256_set1_epi32((int)range->flip);
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i x = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(in + i)), FLIP);
+        _mm256_storeu_si256((__m256i *)(out + i), half_even_x8(x, shift, range));
+    }
+#endif
+#if defined(__SSE2__)
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128i x = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(in + i)), _mm_set1_epi32((int)range->flip));
+        _mm_storeu_si128((__m128i *)(out + i), half_even_x4(x, shift, range));
+    }
+#endif
+    for (; i < n; i++)
+    {
+        out[i] = half_even_one(to_signed((uint32_t)in[i] ^ range->flip), shift, range);
+    }
+}
+
+// Stochastic rounding of samples `position` to `position + n - 1`, which must all have the same high 32 bits.
+static void stochastic_window(const int32_t * in, int32_t * out, size_t n, uint8_t shift, uint64_t key,
+                              uint64_t position, const requantize_range_t * range)
+{
+    uint32_t wkey = window_key(key, position);
+    uint32_t counter = (uint32_t)position;
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256i FLIP = _mm256_set1_epi32((int)range->flip);
+    __m256i counters = _mm256_add_epi32(_mm256_set1_epi32((int)counter), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i x = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(in + i)), FLIP);
+        __m256i random = mix32_x8(_mm256_xor_si256(counters, _mm256_set1_epi32((int)wkey)));
+        _mm256_storeu_si256((__m256i *)(out + i), stochastic_x8(x, random, shift, range));
+        counters = _mm256_add_epi32(counters, _mm256_set1_epi32(8));
+    }
+#endif
+#if defined(__SSE2__)
+    __m128i counters4 = _mm_add_epi32(_mm_set1_epi32((int)(counter + (uint32_t)i)), _mm_setr_epi32(0, 1, 2, 3));
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128i x = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(in + i)), _mm_set1_epi32((int)range->flip));
+        __m128i random = mix32_x4(_mm_xor_si128(counters4, _mm_set1_epi32((int)wkey)));
+        _mm_storeu_si128((__m128i *)(out + i), stochastic_x4(x, random, shift, range));
+        counters4 = _mm_add_epi32(counters4, _mm_set1_epi32(4));
+    }
+#endif
+    for (; i < n; i++)
+    {
+        uint32_t random = mix32((counter + (uint32_t)i) ^ wkey);
+        out[i] = stochastic_one(to_signed((uint32_t)in[i] ^ range->flip), shift, random, range);
+    }
+}
+
+static void stochastic(fixed_requantize_t * requantize, const int32_t * in, int32_t * out, size_t n,
+                       const requantize_range_t * range)
+{
+    while (n > 0)
+    {
+        // Split where the position's high 32 bits change.
+        uint64_t window_left = ((uint64_t)1 << 32) - (uint32_t)requantize->position;
+        size_t count = n < window_left ? n : (size_t)window_left;
+        stochastic_window(in, out, count, requantize->shift, requantize->key, requantize->position, range);
+        requantize->position += count;
+        in += count;
+        out += count;
+        n -= count;
+    }
+}
+
+// First-order error feedback, from a running sum: see fixed_point_requantize.h. Output n is
+// floor(sum to n / 2^shift) - floor(sum to n - 1 / 2^shift), where the sum starts at 1/2 an output step (so each
+// output is rounded to nearest). The sum wraps mod 2^64, which shifts both floors by the same multiple of
+// 2^(64 - shift); the difference is an int32_t, so only its low 32 bits are needed, and those don't change.
+static void error_feedback(fixed_requantize_t * requantize, const int32_t * in, int32_t * out, size_t n,
+                           const requantize_range_t * range)
+{
+    uint8_t shift = requantize->shift;
+    uint64_t sum = requantize->sums[0];
+    uint64_t previous = requantize->floors[0];
+    for (size_t i = 0; i < n; i++)
+    {
+        sum += (uint64_t)(int64_t)to_signed((uint32_t)in[i] ^ range->flip);
+        uint64_t floored = sum >> shift;
+        out[i] = clamp64((int64_t)to_signed((uint32_t)(floored - previous)) + range->offset, range);
+        previous = floored;
+    }
+    requantize->sums[0] = sum;
+    requantize->floors[0] = previous;
+}
+
+// Second-order noise shaping: the same, with output n the second difference of the floored running sum of running
+// sums.
+static void noise_shape_2(fixed_requantize_t * requantize, const int32_t * in, int32_t * out, size_t n,
+                          const requantize_range_t * range)
+{
+    uint8_t shift = requantize->shift;
+    uint64_t sum = requantize->sums[0];
+    uint64_t sum_of_sums = requantize->sums[1];
+    uint64_t previous = requantize->floors[0];
+    uint64_t before_previous = requantize->floors[1];
+    for (size_t i = 0; i < n; i++)
+    {
+        sum += (uint64_t)(int64_t)to_signed((uint32_t)in[i] ^ range->flip);
+        sum_of_sums += sum;
+        uint64_t floored = sum_of_sums >> shift;
+        uint32_t y = (uint32_t)(floored - 2*previous + before_previous);
+        out[i] = clamp64((int64_t)to_signed(y) + range->offset, range);
+        before_previous = previous;
+        previous = floored;
+    }
+    requantize->sums[0] = sum;
+    requantize->sums[1] = sum_of_sums;
+    requantize->floors[0] = previous;
+    requantize->floors[1] = before_previous;
+}
+
+static void requantize_block(fixed_requantize_t * requantize, const int32_t * in, int32_t * out, size_t n,
+                             const requantize_range_t * range)
+{
+    switch (requantize->mode)
+    {
+        case FIXED_REQUANTIZE_STOCHASTIC:
+            // Advances the position itself.
+            stochastic(requantize, in, out, n, range);
+            return;
+        case FIXED_REQUANTIZE_ERROR_FEEDBACK:
+            error_feedback(requantize, in, out, n, range);
+            break;
+        case FIXED_REQUANTIZE_NOISE_SHAPE_2:
+            noise_shape_2(requantize, in, out, n, range);
+            break;
+        case FIXED_REQUANTIZE_HALF_EVEN:
+        default:
+            half_even(in, out, n, requantize->shift, range);
+            break;
+    }
+    requantize->position += n;
+}
+
+static requantize_range_t signed_range(uint8_t shift)
+{
+    requantize_range_t range = {0, 0, -(int32_t)(SIGN_BIT >> shift), (int32_t)((SIGN_BIT >> shift) - 1)};
+    return range;
+}
+
+// -----------------------------------------------------------------------------------------------------------------
+// Public functions
+// -----------------------------------------------------------------------------------------------------------------
+
+/// @brief      Set up a requantizer for one stream of samples.
+/// @param[in]  shift   The number of fraction bits to drop: 1 to 31. Ex: 8 for Q16.16 to Q16.8, or 16 for Q1.31 to
+///                     Q1.15.
+/// @param[in]  seed    For FIXED_REQUANTIZE_STOCHASTIC: which random stream to use. The same seed always gives the
+///                     same results.
+/// @return     false if `shift` or `mode` is out of range.
+bool fixed_requantize_init(fixed_requantize_t * requantize, uint8_t shift, fixed_requantize_mode_t mode,
+                           uint64_t seed)
+{
+    if (shift < 1 || shift > 31 || (unsigned)mode > FIXED_REQUANTIZE_NOISE_SHAPE_2)
+    {
+        return false;
+    }
+    requantize->key = ((uint64_t)mix32((uint32_t)(seed >> 32) ^ 0x9E3779B9u) << 32) | mix32((uint32_t)seed);
+    requantize->position = 0;
+    // Starting the (last) running sum half an output step up makes error feedback round to nearest instead of down.
+    requantize->sums[0] = mode == FIXED_REQUANTIZE_NOISE_SHAPE_2 ? 0 : (uint64_t)1 << (shift - 1);
+    requantize->sums[1] = (uint64_t)1 << (shift - 1);
+    requantize->floors[0] = 0;
+    requantize->floors[1] = 0;
+    requantize->shift = shift;
+    requantize->mode = (uint8_t)mode;
+    return true;
+}
+
+/// @brief      Requantize `n` signed samples, dropping `shift` fraction bits: out[i] is in[i] / 2^shift, rounded per
+///             the mode and saturated to a (32 - shift)-bit signed range. `out` may be the same array as `in`.
+void fixed_requantize_i32(fixed_requantize_t * requantize, int32_t * out, const int32_t * in, size_t n)
+{
+    requantize_range_t range = signed_range(requantize->shift);
+    requantize_block(requantize, in, out, n, &range);
+}
+
+/// @brief      fixed_requantize_i32(), saturated to 16 bits: ex: Q1.31 audio to Q1.15 with a shift of 16.
+/// @details    With error feedback, the errors fed back are the ones before saturating, so a clipped sample doesn't
+///             make the following ones overshoot too.
+void fixed_requantize_i16(fixed_requantize_t * requantize, int16_t * out, const int32_t * in, size_t n)
+{
+    requantize_range_t range = signed_range(requantize->shift);
+    range.lo = range.lo < INT16_MIN ? INT16_MIN : range.lo;
+    range.hi = range.hi > INT16_MAX ? INT16_MAX : range.hi;
+    int32_t buffer[I16_BUFFER_SAMPLES];
+    while (n > 0)
+    {
+        size_t count = n < I16_BUFFER_SAMPLES ? n : I16_BUFFER_SAMPLES;
+        requantize_block(requantize, in, buffer, count, &range);
+        for (size_t i = 0; i < count; i++)
+        {
+            out[i] = (int16_t)buffer[i];
+        }
+        in += count;
+        out += count;
+        n -= count;
+    }
+}
+
+/// @brief      Requantize `n` unsigned Q16.16 numbers (or any unsigned format in 32 bits), dropping `shift` fraction
+///             bits: ex: a shift of 8 gives Q16.8 (in the low 24 bits). Saturates to [0, 2^(32 - shift) - 1].
+///             `out` may be the same array as `in`.
+void fixed_requantize_u32(fixed_requantize_t * requantize, uint32_t * out, const fixed_point_t * in, size_t n)
+{
+    // Subtracting 2^31 from every input subtracts exactly 2^(31 - shift) from every output (it's a whole number of
+    // output steps), whatever the mode, so signed samples can do all the work.
+    requantize_range_t range = {SIGN_BIT, (int32_t)(SIGN_BIT >> requantize->shift), 0,
+                                (int32_t)((UINT32_MAX >> requantize->shift))};
+    requantize_block(requantize, (const int32_t *)in, (int32_t *)out, n, &range);
+}
@@ -0,0 +1,70 @@
+/*
+fixed_point_requantize
+- Requantizing: converting fixed-point samples to a format with fewer fraction bits (ex: Q16.16 to Q16.8, or Q1.31 to
+  Q1.15), by dropping the low `shift` bits. Done with a plain `>> shift` (which always rounds down) or with the
+  tutorial's `+ 1/2` addend (which always rounds ties up), the result is biased: a stage that requantizes every
+  sample drifts, and the error shows up in audio as a DC offset and as distortion correlated with the signal.
+- 4 modes, all exact integer math:
+  - Round half to even: round to nearest, with exact ties going to whichever neighbor is even. Unbiased for ties.
+  - Stochastic: round down or up at random, up with probability (dropped bits)/2^shift, so every sample is unbiased
+    *on average*, and the error is noise instead of distortion. The random bits come from a counter-based generator:
+    sample number `i` of a stream always gets hash(seed, i), so the results are the same whether the stream is
+    converted in one call or many, and with or without SIMD.
+  - Error feedback (first-order noise shaping): each sample's rounding error is added to the next sample before it's
+    rounded, so the errors cancel out over time: their sum stays within 1 output step, and their spectrum is pushed
+    up toward high frequencies (noise transfer function 1 - z^-1).
+  - Second-order noise shaping: the same, with the error filtered by (1 - z^-1)^2, which pushes the noise further up.
+- Error feedback is a loop: every sample needs the previous sample's error. Done directly, that's several dependent
+  operations per sample. Instead, this computes the same outputs from running sums of the inputs: with first-order
+  feedback, the outputs up to sample n add up to exactly the rounded sum of the inputs up to n, so output n is
+  `round(sum to n) - round(sum to n - 1)`, and the only thing each sample waits on is one add. (Second order is the
+  same with a running sum of running sums.) The sums are kept mod 2^64, which is all that's needed for exact
+  outputs, however long the stream.
+- Batch kernels: 8 samples at a time with AVX2, or 4 with SSE2 (faster with SSE4.1), for rounding half to even and
+  stochastic rounding. Every path gives bit-identical results.
+- Input is signed 32-bit (any Q format in an `int32_t`, ex: `fixed_q31_t`) or unsigned Q16.16 (`fixed_point_t`).
+  Output saturates to the narrower format's range: `32 - shift` bits, or 16 bits for the `_i16` version.
+*/
+
+#ifndef FIXED_POINT_REQUANTIZE_H
+#define FIXED_POINT_REQUANTIZE_H
+
+#include <stddef.h>
+
+#include "fixed_point.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum fixed_requantize_mode_e
+{
+    FIXED_REQUANTIZE_HALF_EVEN = 0,
+    FIXED_REQUANTIZE_STOCHASTIC,
+    FIXED_REQUANTIZE_ERROR_FEEDBACK,
+    FIXED_REQUANTIZE_NOISE_SHAPE_2,
+} fixed_requantize_mode_t;
+
+// One stream's requantizer. Set up with fixed_requantize_init(); it then carries the stream's state (the position
+// for stochastic rounding, and the running sums for error feedback) from one call to the next. Use one per channel.
+typedef struct fixed_requantize_s
+{
+    uint64_t key;       // the seed, mixed (stochastic rounding)
+    uint64_t position;  // the number of samples converted so far
+    uint64_t sums[2];   // error feedback: the running sum of the inputs, and (second order) of those sums; mod 2^64
+    uint64_t floors[2]; // error feedback: the last 2 running sums, shifted right (second order)
+    uint8_t shift;      // the number of fraction bits dropped: 1 to 31
+    uint8_t mode;       // a fixed_requantize_mode_t
+} fixed_requantize_t;
+
+bool fixed_requantize_init(fixed_requantize_t * requantize, uint8_t shift, fixed_requantize_mode_t mode,
+                           uint64_t seed);
+void fixed_requantize_i32(fixed_requantize_t * requantize, int32_t * out, const int32_t * in, size_t n);
+void fixed_requantize_i16(fixed_requantize_t * requantize, int16_t * out, const int32_t * in, size_t n);
+void fixed_requantize_u32(fixed_requantize_t * requantize, uint32_t * out, const fixed_point_t * in, size_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIXED_POINT_REQUANTIZE_H
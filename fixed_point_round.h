@@ -0,0 +1,154 @@
+/*
+fixed_point_round
+- Integer division with exact, fully-specified rounding: round-half-up (the tutorial's `(a + b/2)/b` rule),
+  round-half-even ("banker's rounding"), and truncation, for unsigned and signed 32-bit and 64-bit integers.
+- All of it is constexpr in C++ (see FIXED_CONSTEXPR), so it can compute constants and tables at compile time too.
+- These give bit-identical results on every platform (x86-64, AArch64, 32-bit ARM, etc.) and every compiler: they use
+  only integer math, and nothing with undefined or implementation-defined behavior (no signed overflow, no
+  right-shifts of negative numbers, no floating point).
+
+Notes on the tutorial's `(a + b/2)/b` rule (see the 8th approach in fixed_point_math.cpp):
+- It rounds correctly for odd b too. The tutorial's concern is that b/2 truncates, but an exact tie
+  (a/b ending in exactly .5) can only happen when b is even, so for odd b truncating b/2 changes nothing.
+- Its real problems are that (1) `a + b/2` can overflow when a is near the top of its type's range, and (2) it
+  always rounds ties *up*, which biases sums of many rounded values upward.
+- The `fixed_div_round_*()` functions below fix both by rounding from the remainder instead, which never overflows.
+  The `*_fast()` variants use `(a + b/2)/b` directly whenever it can't overflow, and are guaranteed to return the same
+  answer as the remainder-based versions.
+*/
+
+#ifndef FIXED_POINT_ROUND_H
+#define FIXED_POINT_ROUND_H
+
+#include <stdint.h>
+
+#include "fixed_point.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum fixed_round_mode_e
+{
+    // Round to nearest; exact ties (x.5) round up (for negative numbers: away from zero). The tutorial's rule.
+    FIXED_ROUND_HALF_UP = 0,
+    // Round to nearest; exact ties round to whichever neighbor is even. Unbiased.
+    FIXED_ROUND_HALF_EVEN,
+    // Round toward zero (truncate), like plain C integer division.
+    FIXED_ROUND_TRUNCATE,
+} fixed_round_mode_t;
+
+/// @brief      Decide whether a truncated quotient must be bumped one step away from zero.
+/// @param[in]  quotient_is_odd     Whether the truncated quotient is odd (only used for FIXED_ROUND_HALF_EVEN).
+/// @param[in]  remainder           The magnitude of the remainder of the division.
+/// @param[in]  rest                The magnitude of the divisor, minus `remainder`; ie: how far the next quotient is.
+///                                 Comparing `remainder` to `rest` instead of `2*remainder` to the divisor is what
+///                                 keeps this from ever overflowing.
+static inline FIXED_CONSTEXPR int fixed_round_up_needed(int quotient_is_odd, uint64_t remainder, uint64_t rest,
+                                                        fixed_round_mode_t mode)
+{
+    switch (mode)
+    {
+        case FIXED_ROUND_HALF_UP:
+            return remainder >= rest;
+        case FIXED_ROUND_HALF_EVEN:
+            return remainder > rest || (remainder == rest && quotient_is_odd);
+        case FIXED_ROUND_TRUNCATE:
+        default:
+            return 0;
+    }
+}
+
+/// @brief      Unsigned `a/b`, rounded per `mode`. Never overflows. `b` must not be 0.
+static inline FIXED_CONSTEXPR uint32_t fixed_div_round_u32(uint32_t a, uint32_t b, fixed_round_mode_t mode)
+{
+    uint32_t quotient = a / b;
+    uint32_t remainder = a % b;
+    return quotient + (uint32_t)fixed_round_up_needed(quotient & 1, remainder, b - remainder, mode);
+}
+
+/// @brief      Unsigned `a/b`, rounded per `mode`. Never overflows. `b` must not be 0.
+static inline FIXED_CONSTEXPR uint64_t fixed_div_round_u64(uint64_t a, uint64_t b, fixed_round_mode_t mode)
+{
+    uint64_t quotient = a / b;
+    uint64_t remainder = a % b;
+    return quotient + (uint64_t)fixed_round_up_needed((int)(quotient & 1), remainder, b - remainder, mode);
+}
+
+// Magnitude of a signed number, as unsigned, without overflowing on INT64_MIN.
+static inline FIXED_CONSTEXPR uint64_t fixed_abs_u64(int64_t x)
+{
+    return x < 0 ? (uint64_t)0 - (uint64_t)x : (uint64_t)x;
+}
+
+/// @brief      Signed `a/b`, rounded per `mode`: FIXED_ROUND_HALF_UP rounds ties away from zero, and
+///             FIXED_ROUND_TRUNCATE rounds toward zero. `b` must not be 0. The one result that doesn't fit,
+///             INT32_MIN/-1, saturates to INT32_MAX.
+static inline FIXED_CONSTEXPR int32_t fixed_div_round_i32(int32_t a, int32_t b, fixed_round_mode_t mode)
+{
+    // Do it all with magnitudes in 64 bits, where every intermediate value fits.
+    uint64_t magnitude_a = fixed_abs_u64(a);
+    uint64_t magnitude_b = fixed_abs_u64(b);
+    uint64_t quotient = magnitude_a / magnitude_b;
+    uint64_t remainder = magnitude_a % magnitude_b;
+    quotient += (uint64_t)fixed_round_up_needed((int)(quotient & 1), remainder, magnitude_b - remainder, mode);
+    if ((a < 0) != (b < 0))
+    {
+        return (int32_t)(-(int64_t)quotient);
+    }
+    return quotient > INT32_MAX ? INT32_MAX : (int32_t)quotient;
+}
+
+/// @brief      Signed 64-bit version of fixed_div_round_i32(). INT64_MIN/-1 saturates to INT64_MAX.
+static inline FIXED_CONSTEXPR int64_t fixed_div_round_i64(int64_t a, int64_t b, fixed_round_mode_t mode)
+{
+    uint64_t magnitude_a = fixed_abs_u64(a);
+    uint64_t magnitude_b = fixed_abs_u64(b);
+    uint64_t quotient = magnitude_a / magnitude_b;
+    uint64_t remainder = magnitude_a % magnitude_b;
+    quotient += (uint64_t)fixed_round_up_needed((int)(quotient & 1), remainder, magnitude_b - remainder, mode);
+    if ((a < 0) != (b < 0))
+    {
+        // The magnitude of a negative result can be up to 2^63, which only fits once negated, so negate in unsigned.
+        return quotient == (uint64_t)INT64_MAX + 1 ? INT64_MIN : -(int64_t)quotient;
+    }
+    return quotient > (uint64_t)INT64_MAX ? INT64_MAX : (int64_t)quotient;
+}
+
+/// @brief      The tutorial's `(a + b/2)/b` round-half-up division, used directly whenever `a + b/2` can't overflow,
+///             and falling back to fixed_div_round_u32() when it can. Always identical to
+///             `fixed_div_round_u32(a, b, FIXED_ROUND_HALF_UP)`. `b` must not be 0.
+static inline FIXED_CONSTEXPR uint32_t fixed_div_round_half_up_fast_u32(uint32_t a, uint32_t b)
+{
+    if (a <= UINT32_MAX - b/2)
+    {
+        return (a + b/2)/b;
+    }
+    return fixed_div_round_u32(a, b, FIXED_ROUND_HALF_UP);
+}
+
+/// @brief      64-bit version of fixed_div_round_half_up_fast_u32().
+static inline FIXED_CONSTEXPR uint64_t fixed_div_round_half_up_fast_u64(uint64_t a, uint64_t b)
+{
+    if (a <= UINT64_MAX - b/2)
+    {
+        return (a + b/2)/b;
+    }
+    return fixed_div_round_u64(a, b, FIXED_ROUND_HALF_UP);
+}
+
+/// @brief      `a*b/c`, rounded per `mode`, for a rescale by a ratio (ex: a price times 3/7, or a reading times a
+///             calibration gain): the product is kept in 64 bits, so only the final result is rounded. Results that
+///             don't fit in 32 bits saturate to UINT32_MAX. `c` must not be 0.
+static inline FIXED_CONSTEXPR uint32_t fixed_mul_div_round_u32(uint32_t a, uint32_t b, uint32_t c,
+                                                               fixed_round_mode_t mode)
+{
+    uint64_t quotient = fixed_div_round_u64((uint64_t)a * b, c, mode);
+    return quotient > UINT32_MAX ? UINT32_MAX : (uint32_t)quotient;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIXED_POINT_ROUND_H
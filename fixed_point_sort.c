@@ -0,0 +1,391 @@
+/*
+fixed_point_sort
+- See fixed_point_sort.h.
+*/
+
+// For pthreads when compiling with -std=c99.
+#define _POSIX_C_SOURCE 200112L
+
+#include <pthread.h>
+#include <string.h>
+
+#include "fixed_point_sort.h"
+
+#define DIGIT_BITS 8
+#define NUM_DIGITS (32 / DIGIT_BITS)
+#define NUM_BUCKETS (1 << DIGIT_BITS)
+// XORed into the top digit of signed keys: flips the sign bit.
+#define SIGN_FLIP (NUM_BUCKETS / 2)
+
+// -----------------------------------------------------------------------------------------------------------------
+// Radix sort
+// -----------------------------------------------------------------------------------------------------------------
+
+static uint32_t digit_of(uint32_t key, unsigned digit, uint32_t flip)
+{
+    return ((key >> (digit*DIGIT_BITS)) & (NUM_BUCKETS - 1)) ^ flip;
+}
+
+// Count the `digit`th digit of `n` keys into `counts`, which must be zeroed.
+static void count_digit(const uint32_t * keys, size_t n, unsigned digit, uint32_t flip, size_t counts[NUM_BUCKETS])
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        counts[digit_of(keys[i], digit, flip)]++;
+    }
+}
+
+// Move `n` keys (and payloads, if not NULL) to their buckets' next positions in `offsets`, which get advanced.
+static void scatter(const uint32_t * keys, const uint32_t * payloads, size_t n, uint32_t * keys_out,
+                    uint32_t * payloads_out, unsigned digit, uint32_t flip, size_t offsets[NUM_BUCKETS])
+{
+    if (payloads == NULL)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            keys_out[offsets[digit_of(keys[i], digit, flip)]++] = keys[i];
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            size_t position = offsets[digit_of(keys[i], digit, flip)]++;
+            keys_out[position] = keys[i];
+            payloads_out[position] = payloads[i];
+        }
+    }
+}
+
+// The arrays one pass reads from and writes to. They swap every pass.
+typedef struct sort_buffers_s
+{
+    uint32_t * keys;
+    uint32_t * payloads; // NULL for a plain sort
+    uint32_t * keys_out;
+    uint32_t * payloads_out;
+} sort_buffers_t;
+
+static void swap_buffers(sort_buffers_t * buffers)
+{
+    uint32_t * keys = buffers->keys;
+    uint32_t * payloads = buffers->payloads;
+    buffers->keys = buffers->keys_out;
+    buffers->payloads = payloads == NULL ? NULL : buffers->payloads_out;
+    buffers->keys_out = keys;
+    buffers->payloads_out = payloads;
+}
+
+// Whether all `n` keys fall in one bucket, so the pass would change nothing.
+static bool is_trivial(const size_t counts[NUM_BUCKETS], size_t n)
+{
+    for (size_t bucket = 0; bucket < NUM_BUCKETS; bucket++)
+    {
+        if (counts[bucket] != 0)
+        {
+            return counts[bucket] == n;
+        }
+    }
+    return true;
+}
+
+// Turn counts into starting positions, in place.
+static void counts_to_offsets(size_t counts[NUM_BUCKETS])
+{
+    size_t total = 0;
+    for (size_t bucket = 0; bucket < NUM_BUCKETS; bucket++)
+    {
+        size_t count = counts[bucket];
+        counts[bucket] = total;
+        total += count;
+    }
+}
+
+// On one thread, the counts for every pass can be taken up front, in one read of the keys: they don't depend on the
+// order the keys are in.
+static void sort_serial(sort_buffers_t * buffers, size_t n, uint32_t top_flip)
+{
+    size_t counts[NUM_DIGITS][NUM_BUCKETS];
+    memset(counts, 0, sizeof(counts));
+    for (size_t i = 0; i < n; i++)
+    {
+        uint32_t key = buffers->keys[i];
+        for (unsigned digit = 0; digit < NUM_DIGITS; digit++)
+        {
+            counts[digit][digit_of(key, digit, digit == NUM_DIGITS - 1 ? top_flip : 0)]++;
+        }
+    }
+    for (unsigned digit = 0; digit < NUM_DIGITS; digit++)
+    {
+        if (is_trivial(counts[digit], n))
+        {
+            continue;
+        }
+        counts_to_offsets(counts[digit]);
+        scatter(buffers->keys, buffers->payloads, n, buffers->keys_out, buffers->payloads_out, digit,
+                digit == NUM_DIGITS - 1 ? top_flip : 0, counts[digit]);
+        swap_buffers(buffers);
+    }
+}
+
+// One thread's share of one pass.
+typedef struct sort_job_s
+{
+    const sort_buffers_t * buffers;
+    size_t start;
+    size_t n;
+    unsigned digit;
+    uint32_t flip;
+    bool scatter;              // false: count this share's digits, true: move them to `counts`' positions
+    size_t counts[NUM_BUCKETS]; // this share's counts, then where its keys in each bucket go
+} sort_job_t;
+
+static void * sort_job_main(void * arg)
+{
+    sort_job_t * job = (sort_job_t *)arg;
+    const sort_buffers_t * buffers = job->buffers;
+    if (!job->scatter)
+    {
+        memset(job->counts, 0, sizeof(job->counts));
+        count_digit(buffers->keys + job->start, job->n, job->digit, job->flip, job->counts);
+    }
+    else
+    {
+        scatter(buffers->keys + job->start, buffers->payloads == NULL ? NULL : buffers->payloads + job->start, job->n,
+                buffers->keys_out, buffers->payloads_out, job->digit, job->flip, job->counts);
+    }
+    return NULL;
+}
+
+// Run `sort_job_main()` on all the jobs: all but the first on new threads, and the first on this one. If a thread
+// can't be started, its job runs on this thread instead.
+static void run_jobs(sort_job_t * jobs, unsigned num_jobs)
+{
+    pthread_t threads[FIXED_SORT_MAX_THREADS];
+    bool started[FIXED_SORT_MAX_THREADS];
+    for (unsigned i = 1; i < num_jobs; i++)
+    {
+        started[i] = pthread_create(&threads[i], NULL, sort_job_main, &jobs[i]) == 0;
+    }
+    sort_job_main(&jobs[0]);
+    for (unsigned i = 1; i < num_jobs; i++)
+    {
+        if (started[i])
+        {
+            pthread_join(threads[i], NULL);
+        }
+        else
+        {
+            sort_job_main(&jobs[i]);
+        }
+    }
+}
+
+// Every pass: each thread counts its share, then each thread's keys in bucket b go after all the keys in buckets
+// before b, and after the keys in bucket b of the threads before it (which keeps the sort stable), then each thread
+// moves its share.
+static void sort_parallel(sort_buffers_t * buffers, size_t n, uint32_t top_flip, unsigned num_threads)
+{
+    sort_job_t jobs[FIXED_SORT_MAX_THREADS];
+    size_t share = n / num_threads;
+    size_t extra = n % num_threads;
+    for (unsigned i = 0; i < num_threads; i++)
+    {
+        jobs[i].buffers = buffers;
+        jobs[i].start = i*share + (i < extra ? i : extra);
+        jobs[i].n = share + (i < extra);
+    }
+    for (unsigned digit = 0; digit < NUM_DIGITS; digit++)
+    {
+        for (unsigned i = 0; i < num_threads; i++)
+        {
+            jobs[i].digit = digit;
+            jobs[i].flip = digit == NUM_DIGITS - 1 ? top_flip : 0;
+            jobs[i].scatter = false;
+        }
+        run_jobs(jobs, num_threads);
+
+        size_t totals[NUM_BUCKETS];
+        memset(totals, 0, sizeof(totals));
+        for (unsigned i = 0; i < num_threads; i++)
+        {
+            for (size_t bucket = 0; bucket < NUM_BUCKETS; bucket++)
+            {
+                totals[bucket] += jobs[i].counts[bucket];
+            }
+        }
+        if (is_trivial(totals, n))
+        {
+            continue;
+        }
+        size_t position = 0;
+        for (size_t bucket = 0; bucket < NUM_BUCKETS; bucket++)
+        {
+            for (unsigned i = 0; i < num_threads; i++)
+            {
+                size_t count = jobs[i].counts[bucket];
+                jobs[i].counts[bucket] = position;
+                position += count;
+            }
+        }
+        for (unsigned i = 0; i < num_threads; i++)
+        {
+            jobs[i].scatter = true;
+        }
+        run_jobs(jobs, num_threads);
+        swap_buffers(buffers);
+    }
+}
+
+static bool radix_sort(uint32_t * keys, uint32_t * payloads, size_t n, uint32_t top_flip, unsigned num_threads,
+                       fixed_arena_t * arena)
+{
+    if (num_threads == 0 || num_threads > FIXED_SORT_MAX_THREADS)
+    {
+        return false;
+    }
+    if (n <= 1)
+    {
+        return true;
+    }
+    size_t arrays = payloads == NULL ? 1 : 2;
+    if (n > SIZE_MAX / (arrays * sizeof(uint32_t)))
+    {
+        return false;
+    }
+    fixed_scratch_t memory;
+    uint32_t * scratch = (uint32_t *)fixed_scratch_begin(&memory, arena, n * arrays * sizeof(uint32_t));
+    if (scratch == NULL)
+    {
+        return false;
+    }
+    sort_buffers_t buffers = {keys, payloads, scratch, payloads == NULL ? NULL : scratch + n};
+    if (num_threads == 1)
+    {
+        sort_serial(&buffers, n, top_flip);
+    }
+    else
+    {
+        sort_parallel(&buffers, n, top_flip, num_threads);
+    }
+    // After an odd number of passes, the sorted keys are in the scratch buffer.
+    if (buffers.keys != keys)
+    {
+        memcpy(keys, buffers.keys, n * sizeof(uint32_t));
+        if (payloads != NULL)
+        {
+            memcpy(payloads, buffers.payloads, n * sizeof(uint32_t));
+        }
+    }
+    fixed_scratch_end(&memory);
+    return true;
+}
+
+/// @brief      Sort `n` fixed-point numbers in place, in ascending order. See fixed_point_sort.h.
+bool fixed_sort(fixed_point_t * values, size_t n, unsigned num_threads, fixed_arena_t * scratch)
+{
+    return radix_sort(values, NULL, n, 0, num_threads, scratch);
+}
+
+/// @brief      fixed_sort() for signed fixed-point numbers (any Q format in an `int32_t`).
+bool fixed_sort_signed(int32_t * values, size_t n, unsigned num_threads, fixed_arena_t * scratch)
+{
+    return radix_sort((uint32_t *)values, NULL, n, SIGN_FLIP, num_threads, scratch);
+}
+
+/// @brief      Sort `n` keys in place, in ascending order, moving `payloads[i]` along with `keys[i]`. Stable.
+bool fixed_sort_pairs(fixed_point_t * keys, uint32_t * payloads, size_t n, unsigned num_threads,
+                      fixed_arena_t * scratch)
+{
+    return radix_sort(keys, payloads, n, 0, num_threads, scratch);
+}
+
+/// @brief      fixed_sort_pairs() for signed keys.
+bool fixed_sort_pairs_signed(int32_t * keys, uint32_t * payloads, size_t n, unsigned num_threads,
+                             fixed_arena_t * scratch)
+{
+    return radix_sort((uint32_t *)keys, payloads, n, SIGN_FLIP, num_threads, scratch);
+}
+
+// -----------------------------------------------------------------------------------------------------------------
+// Searching
+// -----------------------------------------------------------------------------------------------------------------
+
+/// @brief      The index of the first of `n` sorted numbers that is >= `key` (like std::lower_bound()), or `n` if
+///             they're all less than it.
+/// @details    Halves the range every step with a conditional move instead of a branch, so there is nothing to
+///             mispredict; the last few steps are a plain branch-free count.
+size_t fixed_lower_bound(const fixed_point_t * sorted, size_t n, fixed_point_t key)
+{
+    const fixed_point_t * base = sorted;
+    size_t size = n;
+    while (size > 8)
+    {
+        size_t half = size / 2;
+        base = base[half - 1] < key ? base + half : base;
+        size -= half;
+    }
+    size_t index = (size_t)(base - sorted);
+    for (size_t i = 0; i < size; i++)
+    {
+        index += base[i] < key;
+    }
+    return index;
+}
+
+static size_t eytzinger_fill(fixed_point_t * tree, size_t * ranks, const fixed_point_t * sorted, size_t n,
+                             size_t rank, size_t node)
+{
+    if (node <= n)
+    {
+        rank = eytzinger_fill(tree, ranks, sorted, n, rank, 2*node);
+        tree[node] = sorted[rank];
+        if (ranks != NULL)
+        {
+            ranks[node] = rank;
+        }
+        rank = eytzinger_fill(tree, ranks, sorted, n, rank + 1, 2*node + 1);
+    }
+    return rank;
+}
+
+/// @brief      Lay `n` sorted numbers out in Eytzinger order, for fixed_eytzinger_lower_bound().
+/// @param[out] tree        n + 1 numbers: the root is tree[1], and node k's children are tree[2k] and tree[2k + 1].
+///                         tree[0] isn't used.
+/// @param[out] ranks       If not NULL, n + 1 indexes: ranks[k] is where tree[k] was in `sorted`. (Or keep any other
+///                         per-number data in Eytzinger order too, using these.)
+void fixed_eytzinger_build(fixed_point_t * tree, size_t * ranks, const fixed_point_t * sorted, size_t n)
+{
+    tree[0] = 0;
+    if (ranks != NULL)
+    {
+        ranks[0] = n;
+    }
+    eytzinger_fill(tree, ranks, sorted, n, 0, 1);
+}
+
+/// @brief      Search a tree from fixed_eytzinger_build() for the first number >= `key`.
+/// @return     Its index in `tree` (1 to n; ranks[] gives its index in the sorted array), or 0 if every number is less
+///             than `key` (and ranks[0] is n, like fixed_lower_bound()).
+size_t fixed_eytzinger_lower_bound(const fixed_point_t * tree, size_t n, fixed_point_t key)
+{
+    size_t node = 1;
+    while (node <= n)
+    {
+#if defined(__GNUC__)
+        // Node k's descendants 4 levels down are tree[16k] to tree[16k + 15]: one 64-byte cache line.
+        if (16*node <= n)
+        {
+            __builtin_prefetch(tree + 16*node);
+        }
+#endif
+        node = 2*node + (tree[node] < key);
+    }
+    // `node` walked off the bottom of the tree. The answer is where it last went left: undo the right turns (trailing
+    // 1 bits) since then, and that left turn.
+    while (node & 1)
+    {
+        node >>= 1;
+    }
+    return node >> 1;
+}
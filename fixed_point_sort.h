@@ -0,0 +1,56 @@
+/*
+fixed_point_sort
+- Sorting and searching arrays of fixed-point numbers by their raw integers: a Q16.16 `fixed_point_t` sorts exactly
+  like the `uint32_t` it is, so there's no need to decode anything, or to compare at all.
+- Sorting is an LSD (least significant digit first) radix sort: 4 passes of 8 bits each, each one a stable counting
+  sort into a scratch buffer. That's O(n), and much faster than a comparison sort for big arrays.
+  - Signed formats (ex: Q15.16 in an `int32_t`) sort the same way, except that the top byte's sign bit is flipped
+    when picking its bucket, so negative numbers (sign bit set) come before positive ones.
+  - Passes where every number has the same digit (ex: the top byte, when all prices are under 256.0) are skipped.
+  - The `_pairs` versions move a 32-bit payload (ex: an index into your records) along with each key. Since the sort is
+    stable, equal keys keep their payloads' original order.
+  - With more than 1 thread, each pass is split: every thread counts its share's digits, then writes its share to the
+    positions worked out from everyone's counts. The result is the same for any number of threads.
+- Searching a sorted array, `fixed_lower_bound()` is a branch-free binary search: each step is a conditional move,
+  never a mispredicted branch.
+- For many searches of the same sorted array, `fixed_eytzinger_build()` re-lays it out in Eytzinger (breadth-first
+  binary heap) order: the root, then its 2 children, then their 4, and so on. The first several steps of every search
+  then touch the same few cache lines, and the next ones can be prefetched, since a node's descendants 4 levels down
+  are next to each other.
+*/
+
+#ifndef FIXED_POINT_SORT_H
+#define FIXED_POINT_SORT_H
+
+#include <stddef.h>
+
+#include "fixed_point.h"
+#include "fixed_point_arena.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FIXED_SORT_MAX_THREADS 64
+
+// All of these sort in place, in ascending order, on 1 to FIXED_SORT_MAX_THREADS threads (including this one), with
+// a scratch buffer the size of the arrays from `scratch` (ex: this thread's scratch arena, fixed_arena_thread(), so
+// they don't allocate; or NULL for the heap), given back before they return. They return false if `num_threads` is
+// out of range or there isn't enough memory (and then the arrays are unchanged).
+bool fixed_sort(fixed_point_t * values, size_t n, unsigned num_threads, fixed_arena_t * scratch);
+bool fixed_sort_signed(int32_t * values, size_t n, unsigned num_threads, fixed_arena_t * scratch);
+bool fixed_sort_pairs(fixed_point_t * keys, uint32_t * payloads, size_t n, unsigned num_threads,
+                      fixed_arena_t * scratch);
+bool fixed_sort_pairs_signed(int32_t * keys, uint32_t * payloads, size_t n, unsigned num_threads,
+                             fixed_arena_t * scratch);
+
+size_t fixed_lower_bound(const fixed_point_t * sorted, size_t n, fixed_point_t key);
+
+void fixed_eytzinger_build(fixed_point_t * tree, size_t * ranks, const fixed_point_t * sorted, size_t n);
+size_t fixed_eytzinger_lower_bound(const fixed_point_t * tree, size_t n, fixed_point_t key);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIXED_POINT_SORT_H
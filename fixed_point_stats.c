@@ -0,0 +1,598 @@
+/*
+fixed_point_stats
+- See fixed_point_stats.h.
+- The 128-bit sums are divided (and square-rooted) with fixed_point_big's multi-limb integers, since the numerator
+  of the variance needs up to 194 bits.
+*/
+
+// For pthreads when compiling with -std=c99.
+#define _POSIX_C_SOURCE 200112L
+
+#include <pthread.h>
+#include <string.h>
+
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "fixed_point_big.h"
+#include "fixed_point_stats.h"
+
+// fixed_stats_add() sums at most this many readings in 64-bit lanes before folding them into the 128-bit sums, so
+// the lanes (each at most BLOCK_SIZE numbers below 2^32) can't overflow.
+#define BLOCK_SIZE ((size_t)1 << 30)
+
+// Radix select: the top 11 bits, then the next 11, then the last 10.
+#define TOP_BITS 11
+#define MID_BITS 11
+#define LOW_BITS 10
+#define TOP_BUCKETS (1 << TOP_BITS)
+#define MID_BUCKETS (1 << MID_BITS)
+#define LOW_BUCKETS (1 << LOW_BITS)
+
+// 100%, as a Q16.16 percent.
+#define ONE_HUNDRED_PERCENT ((uint64_t)100 << FRACTION_BITS)
+
+// -----------------------------------------------------------------------------------------------------------------
+// Moments
+// -----------------------------------------------------------------------------------------------------------------
+
+// (high, low) += value, as 128 bits.
+static void add_128(uint64_t sum[2], uint64_t low, uint64_t high)
+{
+    sum[0] += low;
+    sum[1] += high + (sum[0] < low);
+}
+
+// Sum up to BLOCK_SIZE readings into `stats`. The squares are summed as their low and high 32-bit halves separately,
+// which keeps every partial sum within 64 bits.
+static void add_block(fixed_stats_t * stats, const fixed_point_t * values, size_t n)
+{
+    uint64_t sum = 0;
+    uint64_t squares_low = 0;
+    uint64_t squares_high = 0;
+    fixed_point_t min = stats->min;
+    fixed_point_t max = stats->max;
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128i ZERO = _mm_setzero_si128();
+    const __m128i LOW32 = _mm_set_epi32(0, -1, 0, -1);
+    __m128i sum_x2 = ZERO;
+    __m128i squares_low_x2 = ZERO;
+    __m128i squares_high_x2 = ZERO;
+#if defined(__SSE4_1__)
+    __m128i min_x4 = _mm_set1_epi32((int)min);
+    __m128i max_x4 = _mm_set1_epi32((int)max);
+#else
+    // SSE2 only has *signed* compares, so track the min and max with the sign bits flipped.
+    const __m128i SIGN = _mm_set1_epi32((int)0x80000000);
+    __m128i min_x4 = _mm_set1_epi32((int)(min ^ 0x80000000));
+    __m128i max_x4 = _mm_set1_epi32((int)(max ^ 0x80000000));
+#endif
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(values + i));
+        sum_x2 = _mm_add_epi64(sum_x2, _mm_add_epi64(_mm_unpacklo_epi32(v, ZERO), _mm_unpackhi_epi32(v, ZERO)));
+        __m128i even = _mm_mul_epu32(v, v);
+        __m128i odd_v = _mm_srli_epi64(v, 32);
+        __m128i odd = _mm_mul_epu32(odd_v, odd_v);
+        squares_low_x2 = _mm_add_epi64(squares_low_x2,
+                                       _mm_add_epi64(_mm_and_si128(even, LOW32), _mm_and_si128(odd, LOW32)));
+        squares_high_x2 = _mm_add_epi64(squares_high_x2, _mm_add_epi64(_mm_srli_epi64(even, 32),
+                                                                       _mm_srli_epi64(odd, 32)));
+#if defined(__SSE4_1__)
+        min_x4 = _mm_min_epu32(min_x4, v);
+        max_x4 = _mm_max_epu32(max_x4, v);
+#else
+        __m128i biased = _mm_xor_si128(v, SIGN);
+        __m128i less = _mm_cmplt_epi32(biased, min_x4);
+        __m128i greater = _mm_cmpgt_epi32(biased, max_x4);
+        min_x4 = _mm_or_si128(_mm_and_si128(less, biased), _mm_andnot_si128(less, min_x4));
+        max_x4 = _mm_or_si128(_mm_and_si128(greater, biased), _mm_andnot_si128(greater, max_x4));
+#endif
+    }
+    uint64_t lanes[2];
+    uint32_t min_lanes[4];
+    uint32_t max_lanes[4];
+    _mm_storeu_si128((__m128i *)lanes, sum_x2);
+    sum = lanes[0] + lanes[1];
+    _mm_storeu_si128((__m128i *)lanes, squares_low_x2);
+    squares_low = lanes[0] + lanes[1];
+    _mm_storeu_si128((__m128i *)lanes, squares_high_x2);
+    squares_high = lanes[0] + lanes[1];
+    _mm_storeu_si128((__m128i *)min_lanes, min_x4);
+    _mm_storeu_si128((__m128i *)max_lanes, max_x4);
+    for (int lane = 0; lane < 4; lane++)
+    {
+#if !defined(__SSE4_1__)
+        min_lanes[lane] ^= 0x80000000;
+        max_lanes[lane] ^= 0x80000000;
+#endif
+        min = min_lanes[lane] < min ? min_lanes[lane] : min;
+        max = max_lanes[lane] > max ? max_lanes[lane] : max;
+    }
+#endif // __SSE2__
+
+    for (; i < n; i++)
+    {
+        uint64_t square = (uint64_t)values[i] * values[i];
+        sum += values[i];
+        squares_low += (uint32_t)square;
+        squares_high += square >> 32;
+        min = values[i] < min ? values[i] : min;
+        max = values[i] > max ? values[i] : max;
+    }
+
+    stats->count += n;
+    add_128(stats->sum, sum, 0);
+    add_128(stats->sum_squares, squares_high << 32, squares_high >> 32);
+    add_128(stats->sum_squares, squares_low, 0);
+    stats->min = min;
+    stats->max = max;
+}
+
+void fixed_stats_init(fixed_stats_t * stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->min = UINT32_MAX;
+}
+
+/// @brief      Add `n` readings to `stats`, in one pass.
+void fixed_stats_add(fixed_stats_t * stats, const fixed_point_t * values, size_t n)
+{
+    while (n > 0)
+    {
+        size_t block_size = n < BLOCK_SIZE ? n : BLOCK_SIZE;
+        add_block(stats, values, block_size);
+        values += block_size;
+        n -= block_size;
+    }
+}
+
+/// @brief      Add the readings in `other` to `stats`, exactly, as if they had all been added to `stats`.
+void fixed_stats_merge(fixed_stats_t * stats, const fixed_stats_t * other)
+{
+    stats->count += other->count;
+    add_128(stats->sum, other->sum[0], other->sum[1]);
+    add_128(stats->sum_squares, other->sum_squares[0], other->sum_squares[1]);
+    stats->min = other->min < stats->min ? other->min : stats->min;
+    stats->max = other->max > stats->max ? other->max : stats->max;
+}
+
+// Put a 128-bit number into the low 4 limbs of a fixed_point_big number, and zero the rest.
+static void set_limbs_128(uint32_t * limbs, size_t num_limbs, const uint64_t value[2])
+{
+    memset(limbs, 0, num_limbs * sizeof(uint32_t));
+    limbs[0] = (uint32_t)value[0];
+    limbs[1] = (uint32_t)(value[0] >> 32);
+    limbs[2] = (uint32_t)value[1];
+    limbs[3] = (uint32_t)(value[1] >> 32);
+}
+
+static uint64_t get_limbs_64(const uint32_t * limbs)
+{
+    return ((uint64_t)limbs[1] << 32) | limbs[0];
+}
+
+/// @brief      The mean of the readings, rounded half up (the tutorial's `(a + b/2)/b`). 0 if there are none.
+fixed_point_t fixed_stats_mean(const fixed_stats_t * stats)
+{
+    if (stats->count == 0)
+    {
+        return 0;
+    }
+    uint32_t sum[4];
+    uint32_t count[4];
+    uint64_t count_128[2] = {stats->count, 0};
+    set_limbs_128(sum, 4, stats->sum);
+    set_limbs_128(count, 4, count_128);
+    // The mean is at most the max, so it fits.
+    fixed_big_div(sum, sum, count, 4, 0, FIXED_ROUND_HALF_UP);
+    return sum[0];
+}
+
+// The variance's numerator and denominator, with `n` readings, their sums `s1` and `s2`, and `d` = n (or n - 1 for the
+// sample variance): in Q32.32, the variance is
+//     (n*s2 - s1^2) / (n*d)
+// This returns `(numerator << numerator_shift) / (denominator << denominator_shift)`, rounded per `mode`, in 8 limbs
+// (n*s2 needs up to 192 bits).
+#define VARIANCE_LIMBS 8
+static void variance_quotient(const fixed_stats_t * stats, bool sample, unsigned numerator_shift,
+                              unsigned denominator_shift, fixed_round_mode_t mode, uint32_t quotient[VARIANCE_LIMBS])
+{
+    uint64_t d = stats->count - sample;
+    uint64_t count_128[2] = {stats->count, 0};
+    // d < 2^64, so shifting it into 128 bits can't lose anything for the shifts used here (< 64).
+    uint64_t shifted_d_128[2] = {d << denominator_shift, denominator_shift == 0 ? 0 : d >> (64 - denominator_shift)};
+    uint32_t count[VARIANCE_LIMBS / 2];
+    uint32_t shifted_d[VARIANCE_LIMBS / 2];
+    uint32_t sum[VARIANCE_LIMBS / 2];
+    uint32_t sum_squares[VARIANCE_LIMBS / 2];
+    uint32_t numerator[VARIANCE_LIMBS];
+    uint32_t sum_squared[VARIANCE_LIMBS];
+    uint32_t denominator[VARIANCE_LIMBS];
+    set_limbs_128(count, VARIANCE_LIMBS / 2, count_128);
+    set_limbs_128(shifted_d, VARIANCE_LIMBS / 2, shifted_d_128);
+    set_limbs_128(sum, VARIANCE_LIMBS / 2, stats->sum);
+    set_limbs_128(sum_squares, VARIANCE_LIMBS / 2, stats->sum_squares);
+
+    // n*s2 >= s1^2 always (Cauchy-Schwarz), so this can't go negative.
+    fixed_big_mul_wide(numerator, count, sum_squares, VARIANCE_LIMBS / 2);
+    fixed_big_mul_wide(sum_squared, sum, sum, VARIANCE_LIMBS / 2);
+    fixed_big_sub(numerator, numerator, sum_squared, VARIANCE_LIMBS);
+    fixed_big_mul_wide(denominator, count, shifted_d, VARIANCE_LIMBS / 2);
+    // fixed_big_div()'s `fraction_bits` shifts the numerator left.
+    fixed_big_div(quotient, numerator, denominator, VARIANCE_LIMBS, numerator_shift, mode);
+}
+
+/// @brief      The variance of the readings, rounded half up, in Q48.16: the same fraction bits as `fixed_point_t`,
+///             with room for the bigger whole number part (a variance is in squared units: up to 2^31).
+/// @param[in]  sample      true for the sample variance (divided by count - 1), false for the population variance
+///                         (divided by count).
+/// @return     0 if there are too few readings (none, or 1 for the sample variance).
+uint64_t fixed_stats_variance(const fixed_stats_t * stats, bool sample)
+{
+    if (stats->count <= (uint64_t)sample)
+    {
+        return 0;
+    }
+    // Q32.32 --> Q48.16: 16 more bits of denominator.
+    uint32_t quotient[VARIANCE_LIMBS];
+    variance_quotient(stats, sample, 0, FRACTION_BITS, FIXED_ROUND_HALF_UP, quotient);
+    return get_limbs_64(quotient);
+}
+
+// floor(sqrt(x)), one bit at a time.
+static uint64_t isqrt_u64(uint64_t x)
+{
+    uint64_t root = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+    while (bit > x)
+    {
+        bit >>= 2;
+    }
+    while (bit != 0)
+    {
+        if (x >= root + bit)
+        {
+            x -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+/// @brief      The standard deviation of the readings, exactly rounded half up (not the square root of the rounded
+///             variance). See fixed_stats_variance() for `sample`.
+fixed_point_t fixed_stats_stddev(const fixed_stats_t * stats, bool sample)
+{
+    if (stats->count <= (uint64_t)sample)
+    {
+        return 0;
+    }
+    // The Q16.16 standard deviation is the square root of the Q32.32 variance, x. With r = floor(sqrt(x)), it rounds up
+    // to r + 1 when x >= (r + 1/2)^2, ie: when 4x >= 4r^2 + 4r + 1. Both sides of that are integers if x is
+    // replaced by floor(4x), so get floor(4x) (at most 2^65), and compare.
+    uint32_t quotient[VARIANCE_LIMBS];
+    variance_quotient(stats, sample, 2, 0, FIXED_ROUND_TRUNCATE, quotient);
+    uint64_t x = ((uint64_t)quotient[2] << 62) | (get_limbs_64(quotient) >> 2);
+    uint32_t quarters = quotient[0] & 3;
+    uint64_t root = isqrt_u64(x);
+    uint64_t halfway = root*root + root;
+    return (fixed_point_t)(root + (x > halfway || (x == halfway && quarters > 0)));
+}
+
+// -----------------------------------------------------------------------------------------------------------------
+// Threads
+// -----------------------------------------------------------------------------------------------------------------
+
+// The part of `n` values thread `thread` of `num_threads` gets: as equal as possible, in order.
+static void thread_share(size_t n, unsigned thread, unsigned num_threads, size_t * start, size_t * size)
+{
+    size_t share = n / num_threads;
+    size_t extra = n % num_threads;
+    *start = thread*share + (thread < extra ? thread : extra);
+    *size = share + (thread < extra);
+}
+
+// Run `job_main` on each of `num_jobs` jobs, `job_size` bytes apart: all but the first on new threads, and the first
+// on this one. If a thread can't be started, its job runs on this thread instead, so every job always runs.
+static void run_jobs(void * (*job_main)(void *), void * jobs, size_t job_size, unsigned num_jobs)
+{
+    pthread_t threads[FIXED_STATS_MAX_THREADS];
+    bool started[FIXED_STATS_MAX_THREADS];
+    for (unsigned i = 1; i < num_jobs; i++)
+    {
+        started[i] = pthread_create(&threads[i], NULL, job_main, (char *)jobs + i*job_size) == 0;
+    }
+    job_main(jobs);
+    for (unsigned i = 1; i < num_jobs; i++)
+    {
+        if (started[i])
+        {
+            pthread_join(threads[i], NULL);
+        }
+        else
+        {
+            job_main((char *)jobs + i*job_size);
+        }
+    }
+}
+
+typedef struct stats_job_s
+{
+    const fixed_point_t * values;
+    size_t n;
+    fixed_stats_t stats;
+} stats_job_t;
+
+static void * stats_job_main(void * arg)
+{
+    stats_job_t * job = (stats_job_t *)arg;
+    fixed_stats_init(&job->stats);
+    fixed_stats_add(&job->stats, job->values, job->n);
+    return NULL;
+}
+
+/// @brief      fixed_stats_add(), split over `num_threads` threads (1 to FIXED_STATS_MAX_THREADS), including this
+///             one. The result is exactly the same as fixed_stats_add()'s.
+/// @return     false if `num_threads` is out of range.
+bool fixed_stats_add_parallel(fixed_stats_t * stats, const fixed_point_t * values, size_t n, unsigned num_threads)
+{
+    if (num_threads == 0 || num_threads > FIXED_STATS_MAX_THREADS)
+    {
+        return false;
+    }
+    stats_job_t jobs[FIXED_STATS_MAX_THREADS];
+    for (unsigned i = 0; i < num_threads; i++)
+    {
+        size_t start;
+        thread_share(n, i, num_threads, &start, &jobs[i].n);
+        jobs[i].values = values + start;
+    }
+    run_jobs(stats_job_main, jobs, sizeof(jobs[0]), num_threads);
+    for (unsigned i = 0; i < num_threads; i++)
+    {
+        fixed_stats_merge(stats, &jobs[i].stats);
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------------
+// Percentiles
+// -----------------------------------------------------------------------------------------------------------------
+
+// Pass 1 counts into this many interleaved copies of its histogram, summed at the end. Readings tend to be clustered
+// (ex: all within a few top buckets), and incrementing the same counter back-to-back has to wait for the previous
+// increment every time; 4 copies let 4 increments run at once.
+#define TOP_COPIES 4
+
+// One thread's share of one radix select pass.
+//
+// Passes 2 and 3 only count the readings in the buckets found by the pass before. To do that without a branch per
+// reading, every other reading is counted too, into one extra "discard" histogram (after the real ones) that is never
+// looked at: `top_slots` maps every top bucket, and `mid_slots` every (pass 2 histogram, mid bucket) pair, to the
+// histogram to count it into.
+typedef struct histogram_job_s
+{
+    const fixed_point_t * values;
+    size_t n;
+    int pass;                   // 1, 2, or 3
+    const uint16_t * top_slots; // for passes 2 and 3: which pass 2 histogram each top bucket counts into
+    const uint16_t * mid_slots; // for pass 3: per pass 2 histogram, which pass 3 histogram each mid bucket counts into
+    uint64_t * counts;          // the histograms, zeroed beforehand
+} histogram_job_t;
+
+static void * histogram_job_main(void * arg)
+{
+    const histogram_job_t * job = (const histogram_job_t *)arg;
+    const fixed_point_t * values = job->values;
+    const uint16_t * top_slots = job->top_slots;
+    const uint16_t * mid_slots = job->mid_slots;
+    uint64_t * counts = job->counts;
+    size_t n = job->n;
+    size_t i = 0;
+    switch (job->pass)
+    {
+        case 1:
+            for (; i + TOP_COPIES <= n; i += TOP_COPIES)
+            {
+                for (int copy = 0; copy < TOP_COPIES; copy++)
+                {
+                    counts[copy*TOP_BUCKETS + (values[i + copy] >> (MID_BITS + LOW_BITS))]++;
+                }
+            }
+            for (; i < n; i++)
+            {
+                counts[values[i] >> (MID_BITS + LOW_BITS)]++;
+            }
+            for (int copy = 1; copy < TOP_COPIES; copy++)
+            {
+                for (size_t bucket = 0; bucket < TOP_BUCKETS; bucket++)
+                {
+                    counts[bucket] += counts[copy*TOP_BUCKETS + bucket];
+                }
+            }
+            break;
+        case 2:
+            for (; i < n; i++)
+            {
+                size_t top_slot = top_slots[values[i] >> (MID_BITS + LOW_BITS)];
+                counts[top_slot*MID_BUCKETS + ((values[i] >> LOW_BITS) & (MID_BUCKETS - 1))]++;
+            }
+            break;
+        case 3:
+        default:
+            for (; i < n; i++)
+            {
+                size_t top_slot = top_slots[values[i] >> (MID_BITS + LOW_BITS)];
+                size_t mid_slot = mid_slots[top_slot*MID_BUCKETS + ((values[i] >> LOW_BITS) & (MID_BUCKETS - 1))];
+                counts[mid_slot*LOW_BUCKETS + (values[i] & (LOW_BUCKETS - 1))]++;
+            }
+            break;
+    }
+    return NULL;
+}
+
+// Run one pass on every thread, then add all the threads' histograms into the first thread's. `num_counts` is the
+// number of counters in use, and `num_zeroed` how many to zero beforehand.
+static void run_pass(histogram_job_t * jobs, unsigned num_threads, int pass, size_t num_counts, size_t num_zeroed)
+{
+    for (unsigned i = 0; i < num_threads; i++)
+    {
+        jobs[i].pass = pass;
+        memset(jobs[i].counts, 0, num_zeroed * sizeof(uint64_t));
+    }
+    run_jobs(histogram_job_main, jobs, sizeof(jobs[0]), num_threads);
+    for (unsigned i = 1; i < num_threads; i++)
+    {
+        for (size_t j = 0; j < num_counts; j++)
+        {
+            jobs[0].counts[j] += jobs[i].counts[j];
+        }
+    }
+}
+
+// Find the bucket the value of `*rank` (0 = the smallest) is in, and make `*rank` its rank within that bucket.
+static uint32_t find_bucket(const uint64_t * counts, uint64_t * rank)
+{
+    uint32_t bucket = 0;
+    while (*rank >= counts[bucket])
+    {
+        *rank -= counts[bucket];
+        bucket++;
+    }
+    return bucket;
+}
+
+// The 0-based rank of the `percent` (Q16.16, 0 to 100) percentile of `n` readings, by the nearest-rank method:
+// ceil(percent/100 * n) - 1, but at least 0. Computed as n = q*100% + r, so nothing overflows.
+static uint64_t nearest_rank(uint64_t n, fixed_point_t percent)
+{
+    uint64_t q = n / ONE_HUNDRED_PERCENT;
+    uint64_t r = n % ONE_HUNDRED_PERCENT;
+    uint64_t rank = percent*q + (percent*r + ONE_HUNDRED_PERCENT - 1) / ONE_HUNDRED_PERCENT;
+    return rank == 0 ? 0 : rank - 1;
+}
+
+/// @brief      Find percentiles of `n` readings (nearest-rank method), with 3 passes of radix select.
+/// @param[in]  percents        `num_percents` (at most FIXED_STATS_MAX_PERCENTILES) percents, each a Q16.16 number
+///                             from 0 to 100: ex: 99.9% is `(fixed_point_t)(99.9*FRACTION_DIVISOR)`. 0 gives the
+///                             smallest reading, and 100 the largest.
+/// @param[out] out             The percentiles, in the same order.
+/// @param[in]  num_threads     1 to FIXED_STATS_MAX_THREADS threads (including this one) to split each pass over.
+/// @param[in]  scratch         Where to get the histograms' memory (given back before returning): ex:
+///                             fixed_arena_thread(), so it doesn't allocate; or NULL for the heap.
+/// @return     false if `n` is 0, a percent is over 100, an argument is out of range, or out of memory.
+bool fixed_stats_percentiles(const fixed_point_t * values, size_t n, const fixed_point_t * percents,
+                             size_t num_percents, fixed_point_t * out, unsigned num_threads, fixed_arena_t * scratch)
+{
+    if (n == 0 || num_percents > FIXED_STATS_MAX_PERCENTILES || num_threads == 0
+        || num_threads > FIXED_STATS_MAX_THREADS)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < num_percents; i++)
+    {
+        if (percents[i] > ONE_HUNDRED_PERCENT)
+        {
+            return false;
+        }
+    }
+    if (num_percents == 0)
+    {
+        return true;
+    }
+
+    // Per thread: room for the biggest pass's histograms (at most one per percentile, plus the discard one). Then
+    // the slot tables, with room for the discard histogram's row in `mid_slots` too.
+    size_t max_slots = num_percents + 1;
+    size_t counts_per_thread = max_slots*MID_BUCKETS > TOP_COPIES*TOP_BUCKETS ? max_slots*MID_BUCKETS
+                                                                               : TOP_COPIES*TOP_BUCKETS;
+    size_t counts_bytes = (size_t)num_threads*counts_per_thread*sizeof(uint64_t);
+    size_t slots_bytes = (TOP_BUCKETS + max_slots*MID_BUCKETS)*sizeof(uint16_t);
+    fixed_scratch_t scratch_memory;
+    uint8_t * memory = (uint8_t *)fixed_scratch_begin(&scratch_memory, scratch, counts_bytes + slots_bytes);
+    if (memory == NULL)
+    {
+        return false;
+    }
+    uint16_t * top_slots = (uint16_t *)(memory + counts_bytes);
+    uint16_t * mid_slots = top_slots + TOP_BUCKETS;
+    const uint16_t UNUSED = UINT16_MAX;
+    memset(top_slots, 0xFF, slots_bytes); // all UNUSED
+
+    histogram_job_t jobs[FIXED_STATS_MAX_THREADS];
+    for (unsigned i = 0; i < num_threads; i++)
+    {
+        size_t start;
+        thread_share(n, i, num_threads, &start, &jobs[i].n);
+        jobs[i].values = values + start;
+        jobs[i].top_slots = top_slots;
+        jobs[i].mid_slots = mid_slots;
+        jobs[i].counts = (uint64_t *)memory + i*counts_per_thread;
+    }
+    const uint64_t * counts = jobs[0].counts;
+
+    uint64_t ranks[FIXED_STATS_MAX_PERCENTILES];
+    uint32_t prefixes[FIXED_STATS_MAX_PERCENTILES];
+    uint16_t slots[FIXED_STATS_MAX_PERCENTILES];
+
+    // Pass 1: which top bucket each percentile is in. Percentiles in the same one share a pass 2 histogram, and the
+    // rest of the top buckets all go to the discard histogram.
+    run_pass(jobs, num_threads, 1, TOP_BUCKETS, TOP_COPIES*TOP_BUCKETS);
+    uint16_t num_slots = 0;
+    for (size_t i = 0; i < num_percents; i++)
+    {
+        ranks[i] = nearest_rank(n, percents[i]);
+        prefixes[i] = find_bucket(counts, &ranks[i]);
+        if (top_slots[prefixes[i]] == UNUSED)
+        {
+            top_slots[prefixes[i]] = num_slots++;
+        }
+        slots[i] = top_slots[prefixes[i]];
+    }
+    uint16_t num_top_slots = num_slots;
+    for (size_t bucket = 0; bucket < TOP_BUCKETS; bucket++)
+    {
+        top_slots[bucket] = top_slots[bucket] == UNUSED ? num_top_slots : top_slots[bucket];
+    }
+
+    // Pass 2: which mid bucket (within its top bucket) each one is in.
+    run_pass(jobs, num_threads, 2, (size_t)num_top_slots*MID_BUCKETS, ((size_t)num_top_slots + 1)*MID_BUCKETS);
+    num_slots = 0;
+    for (size_t i = 0; i < num_percents; i++)
+    {
+        size_t mid_index = (size_t)slots[i]*MID_BUCKETS;
+        uint32_t mid = find_bucket(counts + mid_index, &ranks[i]);
+        prefixes[i] = (prefixes[i] << MID_BITS) | mid;
+        if (mid_slots[mid_index + mid] == UNUSED)
+        {
+            mid_slots[mid_index + mid] = num_slots++;
+        }
+        slots[i] = mid_slots[mid_index + mid];
+    }
+    // (Including the discard histogram's row.)
+    for (size_t j = 0; j < ((size_t)num_top_slots + 1)*MID_BUCKETS; j++)
+    {
+        mid_slots[j] = mid_slots[j] == UNUSED ? num_slots : mid_slots[j];
+    }
+
+    // Pass 3: the low bits.
+    run_pass(jobs, num_threads, 3, (size_t)num_slots*LOW_BUCKETS, ((size_t)num_slots + 1)*LOW_BUCKETS);
+    for (size_t i = 0; i < num_percents; i++)
+    {
+        uint32_t low = find_bucket(counts + (size_t)slots[i]*LOW_BUCKETS, &ranks[i]);
+        out[i] = (prefixes[i] << LOW_BITS) | low;
+    }
+    fixed_scratch_end(&scratch_memory);
+    return true;
+}
@@ -0,0 +1,65 @@
+/*
+fixed_point_stats
+- Statistics over big arrays of `fixed_point_t` readings, all in integers, with no conversion to double:
+  - count, min, max, mean, variance, and standard deviation, from one pass over the data (SSE2),
+  - and any percentiles (ex: p50, p99, p99.9), from 3 more passes of radix select.
+- The moments are kept as *exact* sums (of the values and of their squares, each in 128 bits), not as running
+  floating-point averages, so:
+  - nothing drifts, no matter how many billions of readings go in,
+  - accumulators can be merged (ex: per-thread, per-shard, or per-minute ones into hourly ones) without losing
+    anything, and the result doesn't depend on how the data was split or in what order it was added, and
+  - the mean, variance, and standard deviation are computed from the sums only at the end, each rounded just once,
+    with the tutorial's round-half-up `(a + b/2)/b` rule (done from the remainder, so nothing can overflow).
+- Percentiles use the nearest-rank method: the p-th percentile is the smallest reading that at least p% of all
+  readings are less than or equal to. It's always one of the readings. It's found by radix select on the readings'
+  bits: a histogram of their top 11 bits finds which of 2048 ranges it's in, a histogram of the next 11 bits of just
+  the readings in that range narrows it down further, and one of the last 10 bits finds it exactly. The readings are
+  only read, never copied, sorted, or changed, and all the requested percentiles are found in the same 3 passes.
+- Both the moments and the percentile histograms can be computed on several threads (pthreads), each taking an
+  equal share of the array, and then merged. The results are bit-identical for any number of threads.
+*/
+
+#ifndef FIXED_POINT_STATS_H
+#define FIXED_POINT_STATS_H
+
+#include <stddef.h>
+
+#include "fixed_point.h"
+#include "fixed_point_arena.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FIXED_STATS_MAX_THREADS 64
+// The most percentiles one call to fixed_stats_percentiles() can find.
+#define FIXED_STATS_MAX_PERCENTILES 64
+
+// Exact running sums of a set of readings. Set up with fixed_stats_init(), add readings with fixed_stats_add(), and
+// combine 2 sets with fixed_stats_merge().
+typedef struct fixed_stats_s
+{
+    uint64_t count;
+    uint64_t sum[2];         // the sum of the readings (Q16.16), as 128 bits, low half first
+    uint64_t sum_squares[2]; // the sum of their squares (Q32.32), as 128 bits, low half first
+    fixed_point_t min;       // UINT32_MAX while there are no readings
+    fixed_point_t max;       // 0 while there are no readings
+} fixed_stats_t;
+
+void fixed_stats_init(fixed_stats_t * stats);
+void fixed_stats_add(fixed_stats_t * stats, const fixed_point_t * values, size_t n);
+bool fixed_stats_add_parallel(fixed_stats_t * stats, const fixed_point_t * values, size_t n, unsigned num_threads);
+void fixed_stats_merge(fixed_stats_t * stats, const fixed_stats_t * other);
+
+fixed_point_t fixed_stats_mean(const fixed_stats_t * stats);
+uint64_t fixed_stats_variance(const fixed_stats_t * stats, bool sample);
+fixed_point_t fixed_stats_stddev(const fixed_stats_t * stats, bool sample);
+
+bool fixed_stats_percentiles(const fixed_point_t * values, size_t n, const fixed_point_t * percents,
+                             size_t num_percents, fixed_point_t * out, unsigned num_threads, fixed_arena_t * scratch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIXED_POINT_STATS_H
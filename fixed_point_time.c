@@ -0,0 +1,115 @@
+/*
+fixed_point_time
+- See fixed_point_time.h.
+*/
+
+// For clock_gettime() when compiling with -std=c99.
+#define _POSIX_C_SOURCE 200112L
+
+#include <time.h>
+
+#include "fixed_point_time.h"
+
+// What fixed_tick_rate_init(rate, 10^9) computes: 2^32/10^9 == 4 + 5441186219426131129/2^64 (rounded down), and the
+// largest tick count under 2^32 seconds is 10^9*2^32 - 1.
+const fixed_tick_rate_t FIXED_TICK_RATE_NS =
+{
+    FIXED_TIME_NS_PER_SECOND,
+    {FIXED_TIME_NS_PER_SECOND, FIXED_TIME_ONE_SECOND, FIXED_TIME_ONE_SECOND, FIXED_TIME_NS_PER_SECOND, 4,
+     5441186219426131129ull, 4294967295999999999ull},
+};
+
+static uint64_t greatest_common_divisor(uint64_t a, uint64_t b)
+{
+    while (b != 0)
+    {
+        uint64_t remainder = a % b;
+        a = b;
+        b = remainder;
+    }
+    return a;
+}
+
+/// @brief      Fill in the fixed-point form of an already reduced times/divide, for fixed_clock_scale().
+static void scaler_init_reduced(fixed_clock_scaler_t * scaler, uint64_t times, uint32_t divide)
+{
+    scaler->times = times;
+    scaler->divide = divide;
+
+    // Each step below is long division by hand, 32 bits at a time, like in fixed_recip_divmod_u64(), but with the
+    // divide instruction since this is done once.
+    // fraction = floor(2^64*(times % divide)/divide).
+    uint64_t remainder = times % divide;
+    scaler->whole = times / divide;
+    uint64_t fraction_hi = (remainder << 32) / divide;
+    remainder = (remainder << 32) % divide;
+    scaler->fraction = (fraction_hi << 32) | ((remainder << 32) / divide);
+
+    // Only a ratio above 1 can overflow. round(ticks*times/divide) fits in 64 bits only if
+    // ticks*times + divide/2 < 2^64*divide, so max_ticks = floor((2^64*divide - divide/2 - 1)/times).
+    // That numerator is (divide - 1)*2^64 + (UINT64_MAX - divide/2), and since divide < times, each step's quotient
+    // fits in 32 bits.
+    scaler->max_ticks = UINT64_MAX;
+    if (times > divide)
+    {
+        uint64_t low = UINT64_MAX - divide / 2;
+        uint64_t numerator = ((uint64_t)(divide - 1) << 32) | (low >> 32);
+        uint64_t max_ticks_hi = numerator / times;
+        numerator = ((numerator % times) << 32) | (uint32_t)low;
+        scaler->max_ticks = (max_ticks_hi << 32) | (numerator / times);
+    }
+}
+
+/// @brief      Set up a conversion from ticks of a `from_hz` clock to ticks of a `to_hz` clock.
+/// @details    The rates may be up to 64 bits, as long as to_hz/from_hz reduced to lowest terms fits in 32 bits on
+///             top and bottom; ex: 3 GHz to 1 GHz (3/1), or 19.2 MHz to 1 GHz (625/12).
+/// @return     false if either rate is 0, or the reduced ratio doesn't fit.
+bool fixed_clock_scaler_init(fixed_clock_scaler_t * scaler, uint64_t from_hz, uint64_t to_hz)
+{
+    scaler->from_hz = from_hz;
+    scaler->to_hz = to_hz;
+    if (from_hz == 0 || to_hz == 0)
+    {
+        return false;
+    }
+    uint64_t gcd = greatest_common_divisor(to_hz, from_hz);
+    uint64_t times = to_hz / gcd;
+    uint64_t divide = from_hz / gcd;
+    if (times > UINT32_MAX || divide > UINT32_MAX)
+    {
+        return false;
+    }
+    scaler_init_reduced(scaler, times, (uint32_t)divide);
+    return true;
+}
+
+/// @brief      Set up a tick rate of `hz` ticks per second for fixed_time_from_ticks() and fixed_time_to_ticks().
+/// @return     false if `hz` is 0.
+bool fixed_tick_rate_init(fixed_tick_rate_t * rate, uint32_t hz)
+{
+    rate->hz = hz;
+    rate->to_time.from_hz = hz;
+    rate->to_time.to_hz = FIXED_TIME_ONE_SECOND;
+    if (hz == 0)
+    {
+        return false;
+    }
+    // 2^32/hz doesn't need reducing: fixed_clock_scale() is exact either way, as long as `divide` fits in 32 bits.
+    scaler_init_reduced(&rate->to_time, FIXED_TIME_ONE_SECOND, hz);
+    return true;
+}
+
+/// @brief      The current time of the system's monotonic clock (CLOCK_MONOTONIC), as Q32.32 seconds.
+fixed_time_t fixed_time_monotonic(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if ((uint64_t)now.tv_sec > UINT32_MAX)
+    {
+        return FIXED_TIME_MAX;
+    }
+    // The seconds are already split out, so only the nanoseconds need converting (see fixed_time_from_ns()).
+    return ((uint64_t)now.tv_sec << FIXED_TIME_FRACTION_BITS)
+        + (((uint64_t)now.tv_nsec << FIXED_TIME_FRACTION_BITS) + FIXED_TIME_NS_PER_SECOND / 2)
+        / FIXED_TIME_NS_PER_SECOND;
+}
@@ -0,0 +1,156 @@
+/*
+fixed_point_time
+- Fixed-point time: timestamps and durations as 64-bit Q32.32 seconds (`fixed_time_t`), plus exact conversions between
+  them, nanoseconds, and any other tick rate (ex: a 19.2 MHz timer, or a CPU cycle counter).
+- This is the "uint64_t nanosecond timestamp that is really large, and you need to multiply it by a fraction" case
+  from the large-integer math section of fixed_point_math.cpp, done for real: every conversion is rounded half up,
+  exactly, over the whole uint64_t range, with no 128-bit type needed and no divide instructions.
+- Q32.32 seconds covers ~136 years at ~0.23 ns resolution. Times beyond that saturate to FIXED_TIME_MAX.
+- `fixed_clock_scaler_t` converts ticks of one clock to ticks of another (ex: for a tracer's clock-domain
+  conversion). Since it rounds the exact result, it is monotonic: a later tick never converts to an earlier one.
+*/
+
+#ifndef FIXED_POINT_TIME_H
+#define FIXED_POINT_TIME_H
+
+#include "fixed_point.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Q32.32 seconds.
+typedef uint64_t fixed_time_t;
+
+#define FIXED_TIME_FRACTION_BITS 32
+#define FIXED_TIME_FRACTION_MASK (((fixed_time_t)1 << FIXED_TIME_FRACTION_BITS) - 1)
+#define FIXED_TIME_ONE_SECOND ((fixed_time_t)1 << FIXED_TIME_FRACTION_BITS)
+#define FIXED_TIME_MAX UINT64_MAX
+#define FIXED_TIME_NS_PER_SECOND 1000000000u
+
+// Converts ticks of one clock to ticks of another. Fill it in with fixed_clock_scaler_init().
+typedef struct fixed_clock_scaler_s
+{
+    uint64_t from_hz;
+    uint64_t to_hz;
+    // to_hz/from_hz reduced to lowest terms.
+    uint64_t times;
+    uint32_t divide;
+    // times/divide as a 64.64 fixed-point number, rounded down: whole + fraction/2^64.
+    uint64_t whole;
+    uint64_t fraction;
+    // The largest tick count whose result still fits in 64 bits.
+    uint64_t max_ticks;
+} fixed_clock_scaler_t;
+
+// A tick rate, in ticks per second. Fill it in with fixed_tick_rate_init().
+typedef struct fixed_tick_rate_s
+{
+    uint32_t hz;
+    // Scales ticks by 2^32/hz, to Q32.32 seconds.
+    fixed_clock_scaler_t to_time;
+} fixed_tick_rate_t;
+
+// Nanoseconds, precomputed.
+extern const fixed_tick_rate_t FIXED_TICK_RATE_NS;
+
+bool fixed_clock_scaler_init(fixed_clock_scaler_t * scaler, uint64_t from_hz, uint64_t to_hz);
+bool fixed_tick_rate_init(fixed_tick_rate_t * rate, uint32_t hz);
+fixed_time_t fixed_time_monotonic(void);
+
+/// @brief      The high 64 bits of the 128-bit product a*b, from 32-bit halves, so no 128-bit type is needed. Where
+///             the compiler has one anyway (ex: gcc and clang on 64-bit targets), it's used for its single multiply.
+static inline FIXED_CONSTEXPR uint64_t fixed_time_mul_hi_u64(uint64_t a, uint64_t b)
+{
+#if defined(__SIZEOF_INT128__)
+    __extension__ typedef unsigned __int128 uint128_type;
+    return (uint64_t)(((uint128_type)a * b) >> 64);
+#else
+    uint64_t a_lo = (uint32_t)a;
+    uint64_t a_hi = a >> 32;
+    uint64_t b_lo = (uint32_t)b;
+    uint64_t b_hi = b >> 32;
+    uint64_t lo_lo = a_lo * b_lo;
+    uint64_t hi_lo = a_hi * b_lo;
+    uint64_t lo_hi = a_lo * b_hi;
+    // None of these sums can overflow: each is at most (2^32 - 1)^2 + 2*(2^32 - 1) == 2^64 - 1.
+    uint64_t middle = (lo_lo >> 32) + (uint32_t)hi_lo + (uint32_t)lo_hi;
+    return a_hi * b_hi + (hi_lo >> 32) + (lo_hi >> 32) + (middle >> 32);
+#endif
+}
+
+/// @brief      Convert ticks of the `from_hz` clock to ticks of the `to_hz` clock: round(ticks*to_hz/from_hz),
+///             rounded half up, exactly, for any 64-bit `ticks`. Results that don't fit in 64 bits saturate to
+///             UINT64_MAX.
+/// @details    The quotient is first estimated by multiplying by times/divide as a 64.64 fixed-point number, which
+///             is at most 1 too small. Then the exact remainder is `ticks*times + divide/2 - estimate*divide`: the
+///             true value is small (< 3*divide), so computing it mod 2^64, overflow and all, still gives it exactly.
+///             Checking it against `divide` fixes the estimate and does the rounding at the same time.
+static inline FIXED_CONSTEXPR uint64_t fixed_clock_scale(const fixed_clock_scaler_t * scaler, uint64_t ticks)
+{
+    if (ticks > scaler->max_ticks)
+    {
+        return UINT64_MAX;
+    }
+    uint64_t quotient = ticks * scaler->whole + fixed_time_mul_hi_u64(ticks, scaler->fraction);
+    uint64_t remainder = ticks * scaler->times + (scaler->divide >> 1) - quotient * scaler->divide;
+    // The rounded result is the truncated quotient or 1 more, and the estimate is at most 1 below the truncated
+    // quotient, so at most 2 corrections are needed.
+    uint64_t too_small = remainder >= scaler->divide;
+    quotient += too_small;
+    remainder -= (0 - too_small) & scaler->divide;
+    quotient += remainder >= scaler->divide;
+    return quotient;
+}
+
+/// @brief      Convert a count of ticks at `rate` to Q32.32 seconds, rounded to the nearest 2^-32 s.
+/// @return     The time, or FIXED_TIME_MAX if it is 2^32 seconds (~136 years) or more.
+static inline FIXED_CONSTEXPR fixed_time_t fixed_time_from_ticks(uint64_t ticks, const fixed_tick_rate_t * rate)
+{
+    return fixed_clock_scale(&rate->to_time, ticks);
+}
+
+/// @brief      Convert Q32.32 seconds to a count of ticks at `rate`, rounded half up. Never overflows.
+static inline FIXED_CONSTEXPR uint64_t fixed_time_to_ticks(fixed_time_t time, const fixed_tick_rate_t * rate)
+{
+    // Both products are < 2^32 * 2^32, so they fit, and so does their sum: whole seconds*hz is at most
+    // (2^32 - 1)*hz, and the rounded fractional part is at most hz.
+    uint64_t whole_ticks = (time >> FIXED_TIME_FRACTION_BITS) * rate->hz;
+    uint64_t fraction_ticks = ((time & FIXED_TIME_FRACTION_MASK) * rate->hz + (FIXED_TIME_ONE_SECOND >> 1))
+        >> FIXED_TIME_FRACTION_BITS;
+    return whole_ticks + fraction_ticks;
+}
+
+/// @brief      Nanoseconds to Q32.32 seconds, rounded. Saturates to FIXED_TIME_MAX at 2^32 seconds (~136 years).
+///             Identical to fixed_time_from_ticks(ns, &FIXED_TICK_RATE_NS).
+static inline FIXED_CONSTEXPR fixed_time_t fixed_time_from_ns(uint64_t ns)
+{
+    // Split into whole seconds and leftover nanoseconds, so that nothing is ever multiplied up past 64 bits. 10^9
+    // is a compile-time constant here, and compilers already turn division by a constant into a multiply by its
+    // reciprocal (with no divide instruction), which is a little less work than fixed_clock_scale().
+    uint64_t seconds = ns / FIXED_TIME_NS_PER_SECOND;
+    if (seconds > UINT32_MAX)
+    {
+        return FIXED_TIME_MAX;
+    }
+    // remainder < 10^9, so the rounded fraction can't reach 2^32.
+    uint64_t remainder = ns - seconds * FIXED_TIME_NS_PER_SECOND;
+    return (seconds << FIXED_TIME_FRACTION_BITS)
+        + ((remainder << FIXED_TIME_FRACTION_BITS) + FIXED_TIME_NS_PER_SECOND / 2) / FIXED_TIME_NS_PER_SECOND;
+}
+
+/// @brief      Q32.32 seconds to nanoseconds, rounded. Identical to fixed_time_to_ticks(time, &FIXED_TICK_RATE_NS).
+static inline FIXED_CONSTEXPR uint64_t fixed_time_to_ns(fixed_time_t time)
+{
+    // fixed_time_to_ticks()' math, with the rate written out, so it doesn't need FIXED_TICK_RATE_NS (which isn't a
+    // compile-time constant).
+    return (time >> FIXED_TIME_FRACTION_BITS) * FIXED_TIME_NS_PER_SECOND
+        + (((time & FIXED_TIME_FRACTION_MASK) * FIXED_TIME_NS_PER_SECOND + (FIXED_TIME_ONE_SECOND >> 1))
+           >> FIXED_TIME_FRACTION_BITS);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIXED_POINT_TIME_H
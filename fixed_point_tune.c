@@ -0,0 +1,832 @@
+/*
+fixed_point_tune
+- See fixed_point_tune.h.
+*/
+
+// For mkstemp(), fdopen(), fchmod(), and pthreads when compiling with -std=c99.
+#define _POSIX_C_SOURCE 200809L
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "fixed_point_time.h"
+#include "fixed_point_tune.h"
+
+#if defined(__SIZEOF_INT128__)
+// (`__extension__` keeps -pedantic from warning that ISO C has no 128-bit type.)
+__extension__ typedef unsigned __int128 uint128_type;
+#endif
+
+// 2^52: below it, doubles hold every integer, with room to spare for a correctly rounded quotient (see
+// fixed_scale_strategy_exact()).
+#define DOUBLE_EXACT_LIMIT ((uint64_t)1 << 52)
+
+// -----------------------------------------------------------------------------------------------------------------
+// Strategies
+// -----------------------------------------------------------------------------------------------------------------
+
+static const char * const STRATEGY_NAMES[FIXED_SCALE_NUM_STRATEGIES] = {"plan", "divide", "lut", "double", "int128"};
+
+static uint64_t max_value(uint8_t width)
+{
+    return width >= 64 ? UINT64_MAX : ((uint64_t)1 << width) - 1;
+}
+
+/// @brief      The strategy's name, as in the tuner's cache file (ex: "lut"), or NULL if there's no such strategy.
+const char * fixed_scale_strategy_name(fixed_scale_strategy_t strategy)
+{
+    return (unsigned)strategy < FIXED_SCALE_NUM_STRATEGIES ? STRATEGY_NAMES[strategy] : NULL;
+}
+
+/// @brief      Whether `strategy` is compiled in and gives exactly fixed_ratio_apply()'s results for every
+///             `plan->width`-bit value, for the plan's ratio.
+/// @details    DOUBLE: with N = value*times + divide/2 under 2^52, N is exact in a double (as are the product and the
+///             sum), and N/divide, rounded to the nearest double, is off by less than half a unit in the last place:
+///             under (N/divide)*2^-53 < 1/(2*divide). The true quotient's fraction is a multiple of 1/divide, so that
+///             can't carry it across an integer, and rounding down (floor) gives the exact result.
+bool fixed_scale_strategy_exact(fixed_scale_strategy_t strategy, const fixed_ratio_plan_t * plan)
+{
+    uint64_t max = max_value(plan->width);
+    uint64_t times = plan->reduced_times;
+    uint64_t half = plan->reduced_divide / 2;
+    switch (strategy)
+    {
+        case FIXED_SCALE_PLAN:
+            return true;
+        case FIXED_SCALE_DIVIDE:
+            return times == 0 || max <= (UINT64_MAX - half) / times;
+        case FIXED_SCALE_LUT:
+            return plan->width <= 32;
+        case FIXED_SCALE_DOUBLE:
+#if defined(__SSE2__)
+            return plan->width <= 32 && (times == 0 || max <= (DOUBLE_EXACT_LIMIT - 1 - half) / times);
+#else
+            return false;
+#endif
+        case FIXED_SCALE_INT128:
+#if defined(__SIZEOF_INT128__)
+            return plan->width > 32;
+#else
+            return false;
+#endif
+        default:
+            return false;
+    }
+}
+
+/// @brief      Set up scaling `width`-bit values by times/divide with `strategy`.
+/// @param[in]  arena       Where to get the LUT strategy's tables (16 KB for 32-bit values) from, or NULL to use the
+///                         heap. Arena-backed scalers must not outlive the next fixed_arena_reset() of their arena.
+/// @return     false if fixed_ratio_plan_init() fails, `strategy` isn't exact for the ratio (see
+///             fixed_scale_strategy_exact()), or the tables could not be allocated.
+bool fixed_scaler_init(fixed_scaler_t * scaler, uint32_t times, uint32_t divide, uint8_t width,
+                       fixed_scale_strategy_t strategy, fixed_arena_t * arena)
+{
+    memset(scaler, 0, sizeof(*scaler));
+    if (!fixed_ratio_plan_init(&scaler->plan, times, divide, width)
+        || !fixed_scale_strategy_exact(strategy, &scaler->plan))
+    {
+        return false;
+    }
+    scaler->strategy = strategy;
+    scaler->half = scaler->plan.reduced_divide / 2;
+    scaler->arena = arena;
+    if (strategy != FIXED_SCALE_LUT)
+    {
+        return true;
+    }
+
+    scaler->num_lut_bytes = (uint8_t)((width + 7) / 8);
+    size_t num_bytes = (size_t)scaler->num_lut_bytes * 256 * sizeof(fixed_scale_lut_entry_t);
+    void * memory = fixed_arena_alloc_or_heap(arena, num_bytes, FIXED_ARENA_ALIGNMENT);
+    if (memory == NULL)
+    {
+        return false;
+    }
+    scaler->lut = (fixed_scale_lut_entry_t *)memory;
+    // (byte << 8*k) < 2^32, so times that fits 64 bits.
+    for (unsigned k = 0; k < scaler->num_lut_bytes; k++)
+    {
+        for (uint64_t byte = 0; byte < 256; byte++)
+        {
+            uint64_t product = (byte << (8 * k)) * scaler->plan.reduced_times;
+            scaler->lut[k * 256 + byte].quotient = product / scaler->plan.reduced_divide;
+            scaler->lut[k * 256 + byte].remainder = product % scaler->plan.reduced_divide;
+        }
+    }
+    return true;
+}
+
+/// @brief      Free a heap-backed scaler's tables. Arena-backed ones are given back by resetting the arena.
+void fixed_scaler_free(fixed_scaler_t * scaler)
+{
+    fixed_arena_free_or_heap(scaler->arena, scaler->lut);
+    memset(scaler, 0, sizeof(*scaler));
+}
+
+// DIVIDE: only used where the sum can't overflow (see fixed_scale_strategy_exact()).
+static uint64_t scale_divide(const fixed_scaler_t * scaler, uint64_t value)
+{
+    return (value * scaler->plan.reduced_times + scaler->half) / scaler->plan.reduced_divide;
+}
+
+// LUT: the quotients add up to the result, give or take the remainders, which add up to less than 4*divide. Adding
+// divide/2 to them too, each multiple of divide they reach carries 1 more, and then the rest rounds away.
+static uint64_t scale_lut(const fixed_scaler_t * scaler, uint64_t value)
+{
+    const fixed_scale_lut_entry_t * table = scaler->lut;
+    uint64_t quotient = 0;
+    uint64_t remainder = scaler->half;
+    for (unsigned k = 0; k < scaler->num_lut_bytes; k++, table += 256)
+    {
+        const fixed_scale_lut_entry_t * entry = table + ((value >> (8 * k)) & 0xFF);
+        quotient += entry->quotient;
+        remainder += entry->remainder;
+    }
+    uint64_t divide = scaler->plan.reduced_divide;
+    return quotient + (remainder >= divide) + (remainder >= 2 * divide) + (remainder >= 3 * divide)
+           + (remainder >= 4 * divide);
+}
+
+#if defined(__SIZEOF_INT128__)
+
+static uint64_t scale_int128(const fixed_scaler_t * scaler, uint64_t value)
+{
+    uint128_type quotient = ((uint128_type)value * scaler->plan.reduced_times + scaler->half)
+                            / scaler->plan.reduced_divide;
+    return quotient > UINT64_MAX ? UINT64_MAX : (uint64_t)quotient;
+}
+
+#endif
+
+#if defined(__SSE2__)
+
+// DOUBLE. Unsigned 32-bit integers go in and out of the signed conversions offset by 2^31 (flipping the sign bit
+// subtracts it), and the quotient is rounded down, then capped at UINT32_MAX (as fixed_ratio_apply32() saturates).
+// Returns how many values it did; the caller does the rest.
+static size_t scale_double_batch(const fixed_scaler_t * scaler, fixed_point_t * out, const fixed_point_t * values,
+                                 size_t n)
+{
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m128i SIGN = _mm_set1_epi32(INT32_MIN);
+    const __m256d OFFSET = _mm256_set1_pd(2147483648.0);
+    const __m256d TIMES = _mm256_set1_pd((double)scaler->plan.reduced_times);
+    const __m256d HALF = _mm256_set1_pd((double)scaler->half);
+    const __m256d DIVIDE = _mm256_set1_pd((double)scaler->plan.reduced_divide);
+    const __m256d MAX = _mm256_set1_pd(4294967295.0);
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(values + i));
+        __m256d x = _mm256_add_pd(_mm256_cvtepi32_pd(_mm_xor_si128(v, SIGN)), OFFSET);
+        __m256d q = _mm256_floor_pd(_mm256_div_pd(_mm256_add_pd(_mm256_mul_pd(x, TIMES), HALF), DIVIDE));
+        q = _mm256_min_pd(q, MAX);
+        _mm_storeu_si128((__m128i *)(out + i), _mm_xor_si128(_mm256_cvttpd_epi32(_mm256_sub_pd(q, OFFSET)), SIGN));
+    }
+#else
+    // SSE2 has no floor, so round to the nearest integer by adding and subtracting 2^52, then take 1 back off if that
+    // rounded up.
+    const __m128i SIGN = _mm_set1_epi32(INT32_MIN);
+    const __m128d OFFSET = _mm_set1_pd(2147483648.0);
+    const __m128d TIMES = _mm_set1_pd((double)scaler->plan.reduced_times);
+    const __m128d HALF = _mm_set1_pd((double)scaler->half);
+    const __m128d DIVIDE = _mm_set1_pd((double)scaler->plan.reduced_divide);
+    const __m128d MAX = _mm_set1_pd(4294967295.0);
+    const __m128d TWO_52 = _mm_set1_pd((double)DOUBLE_EXACT_LIMIT);
+    const __m128d ONE = _mm_set1_pd(1.0);
+    for (; i + 2 <= n; i += 2)
+    {
+        __m128i v = _mm_loadl_epi64((const __m128i *)(values + i));
+        __m128d x = _mm_add_pd(_mm_cvtepi32_pd(_mm_xor_si128(v, SIGN)), OFFSET);
+        __m128d q = _mm_div_pd(_mm_add_pd(_mm_mul_pd(x, TIMES), HALF), DIVIDE);
+        __m128d rounded = _mm_sub_pd(_mm_add_pd(q, TWO_52), TWO_52);
+        q = _mm_sub_pd(rounded, _mm_and_pd(_mm_cmpgt_pd(rounded, q), ONE));
+        q = _mm_min_pd(q, MAX);
+        _mm_storel_epi64((__m128i *)(out + i), _mm_xor_si128(_mm_cvttpd_epi32(_mm_sub_pd(q, OFFSET)), SIGN));
+    }
+#endif
+    return i;
+}
+
+#endif
+
+/// @brief      out[i] = round(values[i]*times/divide) for n fixed-point numbers (or any values of up to 32 bits),
+///             saturating at UINT32_MAX: the same results as fixed_ratio_apply_batch(), with the scaler's strategy.
+///             `out` may be the same as `values`.
+void fixed_scaler_apply_batch(const fixed_scaler_t * scaler, fixed_point_t * out, const fixed_point_t * values,
+                              size_t n)
+{
+    size_t i = 0;
+    switch (scaler->strategy)
+    {
+        case FIXED_SCALE_DIVIDE:
+            for (; i < n; i++)
+            {
+                uint64_t result = scale_divide(scaler, values[i]);
+                out[i] = result > UINT32_MAX ? UINT32_MAX : (fixed_point_t)result;
+            }
+            break;
+        case FIXED_SCALE_LUT:
+            for (; i < n; i++)
+            {
+                uint64_t result = scale_lut(scaler, values[i]);
+                out[i] = result > UINT32_MAX ? UINT32_MAX : (fixed_point_t)result;
+            }
+            break;
+        case FIXED_SCALE_DOUBLE:
+#if defined(__SSE2__)
+            i = scale_double_batch(scaler, out, values, n);
+#endif
+            // The rest, exactly as the doubles would have done them.
+            for (; i < n; i++)
+            {
+                uint64_t result = scale_divide(scaler, values[i]);
+                out[i] = result > UINT32_MAX ? UINT32_MAX : (fixed_point_t)result;
+            }
+            break;
+        case FIXED_SCALE_PLAN:
+        case FIXED_SCALE_INT128:
+        default:
+            fixed_ratio_apply_batch(&scaler->plan, out, values, n);
+            break;
+    }
+}
+
+/// @brief      out[i] = round(values[i]*times/divide) for n values of up to `width` bits, saturating at UINT64_MAX: the
+///             same results as fixed_ratio_apply(), with the scaler's strategy. `out` may be the same as `values`.
+void fixed_scaler_apply_batch64(const fixed_scaler_t * scaler, uint64_t * out, const uint64_t * values, size_t n)
+{
+    switch (scaler->strategy)
+    {
+        case FIXED_SCALE_DIVIDE:
+        case FIXED_SCALE_DOUBLE:
+            // (DOUBLE is only for values of up to 32 bits, where its results are the same as DIVIDE's.)
+            for (size_t i = 0; i < n; i++)
+            {
+                out[i] = scale_divide(scaler, values[i]);
+            }
+            break;
+        case FIXED_SCALE_LUT:
+            for (size_t i = 0; i < n; i++)
+            {
+                out[i] = scale_lut(scaler, values[i]);
+            }
+            break;
+#if defined(__SIZEOF_INT128__)
+        case FIXED_SCALE_INT128:
+            for (size_t i = 0; i < n; i++)
+            {
+                out[i] = scale_int128(scaler, values[i]);
+            }
+            break;
+#endif
+        case FIXED_SCALE_PLAN:
+        default:
+            for (size_t i = 0; i < n; i++)
+            {
+                out[i] = fixed_ratio_apply(&scaler->plan, values[i]);
+            }
+            break;
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------
+// Tuner
+// -----------------------------------------------------------------------------------------------------------------
+
+#define CPU_MODEL_SIZE 64
+#define SIMD_LEVEL_SIZE 8
+#define CACHE_FILE_LINE_SIZE 512
+#define CACHE_HEADER "# fixed_point_tune cache: cpu model, simd, width, batch size, strategies (fastest first)"
+// Batch sizes over this are timed on this many values (the key still has the real size, rounded up to a power of 2).
+#define MAX_TIMED_BATCH ((size_t)1 << 20)
+// Each timing run scales at least this many values (repeating small batches), and each strategy gets the best of
+// TIMING_RUNS runs.
+#define MIN_TIMED_VALUES ((size_t)1 << 16)
+#define TIMING_RUNS 5
+
+// One key's ranking.
+typedef struct tune_entry_s
+{
+    char cpu_model[CPU_MODEL_SIZE];
+    char simd[SIMD_LEVEL_SIZE];
+    uint8_t width;
+    uint64_t batch_size;
+    uint8_t num_strategies;
+    uint8_t strategies[FIXED_SCALE_NUM_STRATEGIES]; // fastest first
+} tune_entry_t;
+
+struct fixed_tuner_s
+{
+    pthread_mutex_t lock;
+    char * cache_path; // NULL if not persisted
+    char cpu_model[CPU_MODEL_SIZE];
+    tune_entry_t * entries;
+    size_t num_entries;
+    size_t capacity;
+};
+
+static const char * simd_level(void)
+{
+#if defined(__AVX2__)
+    return "avx2";
+#elif defined(__SSE2__)
+    return "sse2";
+#else
+    return "none";
+#endif
+}
+
+// Trim `text` in place, and turn tabs and newlines (the cache file's separators) into spaces.
+static void clean_cpu_model(char * text)
+{
+    size_t start = 0;
+    while (text[start] == ' ')
+    {
+        start++;
+    }
+    size_t length = strlen(text + start);
+    memmove(text, text + start, length + 1);
+    while (length > 0 && (text[length - 1] == ' ' || text[length - 1] == '\n' || text[length - 1] == '\t'))
+    {
+        text[--length] = '\0';
+    }
+    for (size_t i = 0; i < length; i++)
+    {
+        text[i] = text[i] == '\t' || text[i] == '\n' || text[i] == '\r' ? ' ' : text[i];
+    }
+}
+
+// The processor's brand string: from `cpuid` on x86, else /proc/cpuinfo's "model name" (or, on some ARM kernels,
+// "Hardware") line. "unknown" if neither has one.
+static void read_cpu_model(char * model)
+{
+    model[0] = '\0';
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned int registers[13] = {0};
+    if (__get_cpuid(0x80000000, &registers[0], &registers[1], &registers[2], &registers[3])
+        && registers[0] >= 0x80000004)
+    {
+        for (unsigned i = 0; i < 3; i++)
+        {
+            __get_cpuid(0x80000002 + i, &registers[4 * i], &registers[4 * i + 1], &registers[4 * i + 2],
+                        &registers[4 * i + 3]);
+        }
+        registers[12] = 0;
+        memcpy(model, registers, 48);
+        model[48] = '\0';
+    }
+#endif
+    FILE * file = model[0] == '\0' ? fopen("/proc/cpuinfo", "r") : NULL;
+    if (file != NULL)
+    {
+        char line[CACHE_FILE_LINE_SIZE];
+        while (fgets(line, sizeof(line), file) != NULL)
+        {
+            char * colon = strchr(line, ':');
+            if (colon != NULL && (strncmp(line, "model name", 10) == 0 || strncmp(line, "Hardware", 8) == 0))
+            {
+                snprintf(model, CPU_MODEL_SIZE, "%s", colon + 1);
+                break;
+            }
+        }
+        fclose(file);
+    }
+    clean_cpu_model(model);
+    if (model[0] == '\0')
+    {
+        snprintf(model, CPU_MODEL_SIZE, "unknown");
+    }
+}
+
+static size_t round_up_batch_size(size_t batch_size)
+{
+    size_t rounded = 1;
+    while (rounded < batch_size && rounded < ((size_t)1 << 62))
+    {
+        rounded *= 2;
+    }
+    return rounded;
+}
+
+static tune_entry_t * find_entry(fixed_tuner_t * tuner, const char * cpu_model, const char * simd, uint8_t width,
+                                 uint64_t batch_size)
+{
+    for (size_t i = 0; i < tuner->num_entries; i++)
+    {
+        tune_entry_t * entry = &tuner->entries[i];
+        if (entry->width == width && entry->batch_size == batch_size && strcmp(entry->simd, simd) == 0
+            && strcmp(entry->cpu_model, cpu_model) == 0)
+        {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+// Add `entry`, or replace the one with the same key. Returns the stored copy, or NULL if out of memory.
+static tune_entry_t * store_entry(fixed_tuner_t * tuner, const tune_entry_t * entry)
+{
+    tune_entry_t * existing = find_entry(tuner, entry->cpu_model, entry->simd, entry->width, entry->batch_size);
+    if (existing != NULL)
+    {
+        *existing = *entry;
+        return existing;
+    }
+    if (tuner->num_entries == tuner->capacity)
+    {
+        size_t capacity = tuner->capacity == 0 ? 16 : 2 * tuner->capacity;
+        tune_entry_t * entries = (tune_entry_t *)realloc(tuner->entries, capacity * sizeof(tune_entry_t));
+        if (entries == NULL)
+        {
+            return NULL;
+        }
+        tuner->entries = entries;
+        tuner->capacity = capacity;
+    }
+    tuner->entries[tuner->num_entries] = *entry;
+    return &tuner->entries[tuner->num_entries++];
+}
+
+// Parse one cache file line ("cpu model\tsimd\twidth\tbatch size\tname,name,..."). false if it isn't one.
+static bool parse_entry(char * line, tune_entry_t * entry)
+{
+    char * fields[5];
+    fields[0] = line;
+    for (unsigned i = 1; i < 5; i++)
+    {
+        char * tab = strchr(fields[i - 1], '\t');
+        if (tab == NULL)
+        {
+            return false;
+        }
+        *tab = '\0';
+        fields[i] = tab + 1;
+    }
+    fields[4][strcspn(fields[4], "\r\n")] = '\0';
+
+    memset(entry, 0, sizeof(*entry));
+    char * end;
+    unsigned long width = strtoul(fields[2], &end, 10);
+    unsigned long long batch_size = strtoull(fields[3], &end, 10);
+    if (strlen(fields[0]) >= CPU_MODEL_SIZE || strlen(fields[1]) >= SIMD_LEVEL_SIZE || width == 0 || width > 64
+        || batch_size == 0 || (batch_size & (batch_size - 1)) != 0)
+    {
+        return false;
+    }
+    snprintf(entry->cpu_model, CPU_MODEL_SIZE, "%s", fields[0]);
+    snprintf(entry->simd, SIMD_LEVEL_SIZE, "%s", fields[1]);
+    entry->width = (uint8_t)width;
+    entry->batch_size = batch_size;
+
+    // Unknown names (ex: from a newer version) are skipped, and so are repeats.
+    for (char * name = fields[4]; *name != '\0';)
+    {
+        size_t length = strcspn(name, ",");
+        for (unsigned s = 0; s < FIXED_SCALE_NUM_STRATEGIES; s++)
+        {
+            bool listed = false;
+            for (unsigned j = 0; j < entry->num_strategies; j++)
+            {
+                listed = listed || entry->strategies[j] == s;
+            }
+            if (!listed && strlen(STRATEGY_NAMES[s]) == length && strncmp(name, STRATEGY_NAMES[s], length) == 0)
+            {
+                entry->strategies[entry->num_strategies++] = (uint8_t)s;
+            }
+        }
+        name += length + (name[length] == ',');
+    }
+    return entry->num_strategies > 0;
+}
+
+// Read the cache file's entries into the tuner, except keys the tuner already has (its own are newer). A missing
+// file is an empty one.
+static void load_cache(fixed_tuner_t * tuner)
+{
+    FILE * file = fopen(tuner->cache_path, "r");
+    if (file == NULL)
+    {
+        return;
+    }
+    char line[CACHE_FILE_LINE_SIZE];
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        tune_entry_t entry;
+        if (line[0] != '#' && parse_entry(line, &entry)
+            && find_entry(tuner, entry.cpu_model, entry.simd, entry.width, entry.batch_size) == NULL)
+        {
+            store_entry(tuner, &entry);
+        }
+    }
+    fclose(file);
+}
+
+// Write every entry to a new temporary file next to the cache file (mkstemp() makes its name unique, even between
+// tuners in one process), then rename it over the cache file. The caller holds the lock.
+static bool save_cache(fixed_tuner_t * tuner)
+{
+    // Keep what other processes (and tuners) saved since this one loaded the file.
+    load_cache(tuner);
+
+    size_t path_size = strlen(tuner->cache_path) + sizeof(".XXXXXX");
+    char * temporary_path = (char *)malloc(path_size);
+    if (temporary_path == NULL)
+    {
+        return false;
+    }
+    snprintf(temporary_path, path_size, "%s.XXXXXX", tuner->cache_path);
+    int fd = mkstemp(temporary_path);
+    // (mkstemp() makes it readable only by its owner; the cache is for anyone to share.)
+    FILE * file = fd < 0 ? NULL : fchmod(fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH) == 0 ? fdopen(fd, "w") : NULL;
+    if (fd >= 0 && file == NULL)
+    {
+        close(fd);
+        remove(temporary_path);
+    }
+    bool ok = file != NULL;
+    if (ok)
+    {
+        ok = fprintf(file, "%s\n", CACHE_HEADER) > 0;
+        for (size_t i = 0; ok && i < tuner->num_entries; i++)
+        {
+            const tune_entry_t * entry = &tuner->entries[i];
+            ok = fprintf(file, "%s\t%s\t%u\t%llu\t", entry->cpu_model, entry->simd, entry->width,
+                         (unsigned long long)entry->batch_size) > 0;
+            for (unsigned j = 0; ok && j < entry->num_strategies; j++)
+            {
+                ok = fprintf(file, "%s%s", j == 0 ? "" : ",", STRATEGY_NAMES[entry->strategies[j]]) > 0;
+            }
+            ok = ok && fputc('\n', file) != EOF;
+        }
+        ok = fclose(file) == 0 && ok;
+        ok = ok && rename(temporary_path, tuner->cache_path) == 0;
+        if (!ok)
+        {
+            remove(temporary_path);
+        }
+    }
+    free(temporary_path);
+    return ok;
+}
+
+// A splitmix64 step: the test values are pseudo-random, but the same every run.
+static uint64_t next_random(uint64_t * state)
+{
+    uint64_t z = (*state += UINT64_C(0x9E3779B97F4A7C15));
+    z = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+    z = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+    return z ^ (z >> 31);
+}
+
+// Scale `values` (n of them) with `scaler` into `out`: 32-bit values if the width is 32 or less, else 64-bit ones.
+static void run_scaler(const fixed_scaler_t * scaler, void * out, const void * values, size_t n)
+{
+    if (scaler->plan.width <= 32)
+    {
+        fixed_scaler_apply_batch(scaler, (fixed_point_t *)out, (const fixed_point_t *)values, n);
+    }
+    else
+    {
+        fixed_scaler_apply_batch64(scaler, (uint64_t *)out, (const uint64_t *)values, n);
+    }
+}
+
+// Whether the scaler's results match fixed_ratio_apply()'s (saturated to 32 bits for 32-bit values).
+static bool results_match(const fixed_scaler_t * scaler, const void * out, const void * values, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        if (scaler->plan.width <= 32)
+        {
+            uint64_t expected = fixed_ratio_apply(&scaler->plan, ((const fixed_point_t *)values)[i]);
+            if (((const fixed_point_t *)out)[i] != (expected > UINT32_MAX ? UINT32_MAX : expected))
+            {
+                return false;
+            }
+        }
+        else if (((const uint64_t *)out)[i] != fixed_ratio_apply(&scaler->plan, ((const uint64_t *)values)[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Time every strategy compiled in for `width`-bit values, on `batch_size` of them, and return their ranking. Each one
+// scales by times/divide if it's exact for that, and otherwise by 1/1 (where every strategy is exact for the widths
+// it handles): none of them but PLAN runs any faster or slower for a particular ratio, so this ranks all of them, and
+// the ranking serves later ratios that rule out different ones.
+static bool tune(tune_entry_t * entry, uint32_t times, uint32_t divide, uint8_t width, size_t batch_size)
+{
+    size_t n = batch_size < MAX_TIMED_BATCH ? batch_size : MAX_TIMED_BATCH;
+    size_t value_size = width <= 32 ? sizeof(fixed_point_t) : sizeof(uint64_t);
+    uint8_t * values = (uint8_t *)malloc(n * value_size);
+    uint8_t * out = (uint8_t *)malloc(n * value_size);
+    if (values == NULL || out == NULL)
+    {
+        free(values);
+        free(out);
+        return false;
+    }
+    // Random values of the whole width, except the smallest and biggest, first.
+    uint64_t state = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        uint64_t value = i == 0 ? 0 : i == 1 ? max_value(width) : next_random(&state) & max_value(width);
+        if (width <= 32)
+        {
+            ((fixed_point_t *)values)[i] = (fixed_point_t)value;
+        }
+        else
+        {
+            ((uint64_t *)values)[i] = value;
+        }
+    }
+
+    uint64_t ns_per_value_x1000[FIXED_SCALE_NUM_STRATEGIES];
+    entry->num_strategies = 0;
+    size_t repeats = MIN_TIMED_VALUES / n + 1;
+    for (unsigned s = 0; s < FIXED_SCALE_NUM_STRATEGIES; s++)
+    {
+        fixed_scaler_t scaler;
+        if (!fixed_scaler_init(&scaler, times, divide, width, (fixed_scale_strategy_t)s, NULL)
+            && !fixed_scaler_init(&scaler, 1, 1, width, (fixed_scale_strategy_t)s, NULL))
+        {
+            continue;
+        }
+        run_scaler(&scaler, out, values, n);
+        if (!results_match(&scaler, out, values, n))
+        {
+            fixed_scaler_free(&scaler);
+            continue;
+        }
+        uint64_t best_ns = UINT64_MAX;
+        for (unsigned run = 0; run < TIMING_RUNS; run++)
+        {
+            fixed_time_t start = fixed_time_monotonic();
+            for (size_t r = 0; r < repeats; r++)
+            {
+                run_scaler(&scaler, out, values, n);
+            }
+            uint64_t ns = fixed_time_to_ns(fixed_time_monotonic() - start);
+            best_ns = ns < best_ns ? ns : best_ns;
+        }
+        fixed_scaler_free(&scaler);
+
+        // Insert it into the ranking, fastest first.
+        uint64_t score = best_ns * 1000 / (repeats * n);
+        unsigned position = entry->num_strategies;
+        while (position > 0 && ns_per_value_x1000[position - 1] > score)
+        {
+            ns_per_value_x1000[position] = ns_per_value_x1000[position - 1];
+            entry->strategies[position] = entry->strategies[position - 1];
+            position--;
+        }
+        ns_per_value_x1000[position] = score;
+        entry->strategies[position] = (uint8_t)s;
+        entry->num_strategies++;
+    }
+    free(values);
+    free(out);
+    return entry->num_strategies > 0;
+}
+
+/// @brief      Create a tuner, loading the rankings already in `cache_path`, if any.
+/// @param[in]  cache_path  The cache file (ex: "/var/tmp/fixed_point_tune"; it needn't exist yet), or NULL to keep
+///                         the rankings only in memory.
+/// @return     The tuner, or NULL if out of memory.
+fixed_tuner_t * fixed_tuner_open(const char * cache_path)
+{
+    fixed_tuner_t * tuner = (fixed_tuner_t *)calloc(1, sizeof(fixed_tuner_t));
+    if (tuner == NULL)
+    {
+        return NULL;
+    }
+    if (cache_path != NULL)
+    {
+        tuner->cache_path = (char *)malloc(strlen(cache_path) + 1);
+        if (tuner->cache_path == NULL)
+        {
+            free(tuner);
+            return NULL;
+        }
+        strcpy(tuner->cache_path, cache_path);
+    }
+    if (pthread_mutex_init(&tuner->lock, NULL) != 0)
+    {
+        free(tuner->cache_path);
+        free(tuner);
+        return NULL;
+    }
+    read_cpu_model(tuner->cpu_model);
+    if (tuner->cache_path != NULL)
+    {
+        load_cache(tuner);
+    }
+    return tuner;
+}
+
+/// @brief      Free a tuner. (Rankings it tuned were already saved, if it has a cache file.)
+void fixed_tuner_close(fixed_tuner_t * tuner)
+{
+    if (tuner == NULL)
+    {
+        return;
+    }
+    pthread_mutex_destroy(&tuner->lock);
+    free(tuner->entries);
+    free(tuner->cache_path);
+    free(tuner);
+}
+
+/// @brief      The CPU model the tuner keys its rankings on (ex: "Intel(R) Core(TM) i7-8700 CPU @ 3.20GHz").
+const char * fixed_tuner_cpu_model(const fixed_tuner_t * tuner)
+{
+    return tuner->cpu_model;
+}
+
+/// @brief      Pick the fastest exact strategy for scaling batches of about `batch_size` `width`-bit values by
+///             times/divide on this machine, timing the strategies first if this (CPU model, width, batch size)
+///             has no ranking yet (then saving it to the cache file, if there is one).
+/// @return     The strategy; FIXED_SCALE_PLAN (always exact) if the ratio or width is invalid, or tuning failed.
+fixed_scale_strategy_t fixed_tuner_pick(fixed_tuner_t * tuner, uint32_t times, uint32_t divide, uint8_t width,
+                                        size_t batch_size)
+{
+    fixed_ratio_plan_t plan;
+    if (!fixed_ratio_plan_init(&plan, times, divide, width))
+    {
+        return FIXED_SCALE_PLAN;
+    }
+    uint64_t rounded_batch_size = round_up_batch_size(batch_size);
+
+    pthread_mutex_lock(&tuner->lock);
+    const tune_entry_t * entry = find_entry(tuner, tuner->cpu_model, simd_level(), width, rounded_batch_size);
+    if (entry == NULL)
+    {
+        tune_entry_t tuned;
+        memset(&tuned, 0, sizeof(tuned));
+        snprintf(tuned.cpu_model, CPU_MODEL_SIZE, "%s", tuner->cpu_model);
+        snprintf(tuned.simd, SIMD_LEVEL_SIZE, "%s", simd_level());
+        tuned.width = width;
+        tuned.batch_size = rounded_batch_size;
+        if (tune(&tuned, times, divide, width, (size_t)rounded_batch_size))
+        {
+            entry = store_entry(tuner, &tuned);
+            if (entry != NULL && tuner->cache_path != NULL)
+            {
+                save_cache(tuner);
+                // (Saving can reload entries, moving them, so find it again.)
+                entry = find_entry(tuner, tuner->cpu_model, simd_level(), width, rounded_batch_size);
+            }
+        }
+    }
+    fixed_scale_strategy_t strategy = FIXED_SCALE_PLAN;
+    for (unsigned i = 0; entry != NULL && i < entry->num_strategies; i++)
+    {
+        if (fixed_scale_strategy_exact((fixed_scale_strategy_t)entry->strategies[i], &plan))
+        {
+            strategy = (fixed_scale_strategy_t)entry->strategies[i];
+            break;
+        }
+    }
+    pthread_mutex_unlock(&tuner->lock);
+    return strategy;
+}
+
+/// @brief      Save the tuner's rankings to its cache file now (fixed_tuner_pick() already does after tuning).
+/// @return     false if the tuner has no cache file, or it could not be written.
+bool fixed_tuner_save(fixed_tuner_t * tuner)
+{
+    if (tuner->cache_path == NULL)
+    {
+        return false;
+    }
+    pthread_mutex_lock(&tuner->lock);
+    bool ok = save_cache(tuner);
+    pthread_mutex_unlock(&tuner->lock);
+    return ok;
+}
+
+/// @brief      fixed_scaler_init() with the strategy fixed_tuner_pick() picks (or FIXED_SCALE_PLAN, if the picked
+///             one's tables could not be allocated).
+bool fixed_tuner_scaler_init(fixed_tuner_t * tuner, fixed_scaler_t * scaler, uint32_t times, uint32_t divide,
+                             uint8_t width, size_t batch_size, fixed_arena_t * arena)
+{
+    fixed_scale_strategy_t strategy = fixed_tuner_pick(tuner, times, divide, width, batch_size);
+    return fixed_scaler_init(scaler, times, divide, width, strategy, arena)
+           || fixed_scaler_init(scaler, times, divide, width, FIXED_SCALE_PLAN, arena);
+}
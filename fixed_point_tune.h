@@ -0,0 +1,96 @@
+/*
+fixed_point_tune
+- Auto-tuned batch scaling by a ratio, `round(value*times/divide)` (rounded half up, like fixed_point_ratio.h): there
+  are several exact ways to do it, and which is fastest depends on the CPU, the value width, and the batch size.
+- The strategies (`fixed_scale_strategy_t`):
+  - PLAN: fixed_ratio_apply32() / fixed_ratio_apply(), the ratio plan's own method (a shift, or a multiply by the
+    precomputed reciprocal of `divide`; see fixed_point_div.h).
+  - DIVIDE: `(value*times + divide/2) / divide` with the CPU's divide instruction, when the sum can't overflow 64 bits.
+  - LUT: the tutorial's "split the number into sub-numbers" approaches, done exactly: a table per byte of the value
+    holds each byte's `byte*times/divide` as a quotient and a remainder, so scaling a value is 1 to 4 table lookups and
+    adds, then 4 compares to carry the remainders. Values up to 32 bits.
+  - DOUBLE: SIMD doubles (2 values at a time with SSE2, 4 with AVX2). Exact only while `value*times + divide/2` is
+    under 2^52 (see fixed_scale_strategy_exact()). Values up to 32 bits, in SSE2 builds.
+  - INT128: `unsigned __int128` products and divides. Values over 32 bits, on compilers that have the type.
+- A `fixed_scaler_t` applies one ratio with one strategy. fixed_scale_strategy_exact() says which strategies are exact
+  for a ratio and width; the others are never used for it.
+- A `fixed_tuner_t` picks the strategy: the first time it's asked about a (CPU model, width, batch size) it doesn't
+  know, it times every strategy compiled in for that width (after checking each one's results against
+  fixed_ratio_apply()), on that many values, and ranks them, fastest first. Strategies that aren't exact for the ratio
+  it was asked about are timed scaling by 1/1 instead, so the ranking covers them too. Then, for any ratio with the
+  same key, it picks the fastest one in that ranking that's exact for the ratio.
+- The rankings persist in a text cache file, one line per key, so later runs (and other processes) skip the timing.
+  The key's CPU model is the processor's brand string (plus the SIMD level this library was compiled for), so
+  machines of different generations can share one file, each using its own lines. The cache is written to a
+  temporary file first, then renamed over the old one, so readers never see half a file. To tune offline, run
+  bench_tune with the cache file's path: it tunes a grid of widths and batch sizes and saves them.
+- Batch sizes are rounded up to a power of 2 for the key, so nearby sizes share a ranking.
+- A tuner is safe to share between threads: picking takes its mutex (for the whole tuning run, the first time).
+*/
+
+#ifndef FIXED_POINT_TUNE_H
+#define FIXED_POINT_TUNE_H
+
+#include <stddef.h>
+
+#include "fixed_point.h"
+#include "fixed_point_arena.h"
+#include "fixed_point_ratio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum fixed_scale_strategy_e
+{
+    FIXED_SCALE_PLAN = 0,
+    FIXED_SCALE_DIVIDE,
+    FIXED_SCALE_LUT,
+    FIXED_SCALE_DOUBLE,
+    FIXED_SCALE_INT128,
+    FIXED_SCALE_NUM_STRATEGIES,
+} fixed_scale_strategy_t;
+
+// A LUT table entry: `byte << (8*k)` times `times`, divided by `divide` (both reduced).
+typedef struct fixed_scale_lut_entry_s
+{
+    uint64_t quotient;
+    uint64_t remainder;
+} fixed_scale_lut_entry_t;
+
+typedef struct fixed_scaler_s
+{
+    fixed_ratio_plan_t plan;
+    fixed_scale_strategy_t strategy;
+    uint64_t half;                  // reduced_divide/2 (rounded down): adding it makes a truncating divide round
+    uint8_t num_lut_bytes;          // for FIXED_SCALE_LUT: the number of 256-entry tables (1 per byte of width)
+    fixed_scale_lut_entry_t * lut;  // for FIXED_SCALE_LUT (else NULL)
+    fixed_arena_t * arena;          // where `lut` came from; NULL if from the heap
+} fixed_scaler_t;
+
+typedef struct fixed_tuner_s fixed_tuner_t;
+
+const char * fixed_scale_strategy_name(fixed_scale_strategy_t strategy);
+bool fixed_scale_strategy_exact(fixed_scale_strategy_t strategy, const fixed_ratio_plan_t * plan);
+
+bool fixed_scaler_init(fixed_scaler_t * scaler, uint32_t times, uint32_t divide, uint8_t width,
+                       fixed_scale_strategy_t strategy, fixed_arena_t * arena);
+void fixed_scaler_free(fixed_scaler_t * scaler);
+void fixed_scaler_apply_batch(const fixed_scaler_t * scaler, fixed_point_t * out, const fixed_point_t * values,
+                              size_t n);
+void fixed_scaler_apply_batch64(const fixed_scaler_t * scaler, uint64_t * out, const uint64_t * values, size_t n);
+
+fixed_tuner_t * fixed_tuner_open(const char * cache_path);
+void fixed_tuner_close(fixed_tuner_t * tuner);
+const char * fixed_tuner_cpu_model(const fixed_tuner_t * tuner);
+fixed_scale_strategy_t fixed_tuner_pick(fixed_tuner_t * tuner, uint32_t times, uint32_t divide, uint8_t width,
+                                        size_t batch_size);
+bool fixed_tuner_save(fixed_tuner_t * tuner);
+bool fixed_tuner_scaler_init(fixed_tuner_t * tuner, fixed_scaler_t * scaler, uint32_t times, uint32_t divide,
+                             uint8_t width, size_t batch_size, fixed_arena_t * arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIXED_POINT_TUNE_H
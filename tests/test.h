@@ -0,0 +1,89 @@
+/*
+test
+- What every tests/test_<name>.c program shares. CHECK() and CHECK_EQ() count and report a failure without stopping,
+  so one run shows every failure, and test_finish() turns the count into the exit status that ctest looks at.
+- Each test program is a single source file, so these are all `static` (and `inline`, so unused ones don't warn).
+  The failure count is atomic, so a test can check from several threads (see test_exhaustive.c).
+- Like the library, each test compiles as both C99 and C++17 (see CMakeLists.txt).
+*/
+
+#ifndef FIXED_POINT_TEST_H
+#define FIXED_POINT_TEST_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Only the first this many failures are printed: an exhaustive test that's wrong everywhere would print billions.
+#define TEST_MAX_PRINTED_FAILURES 20
+
+static uint64_t test_failures = 0;
+
+static inline void test_fail(const char * file, int line, const char * what)
+{
+    if (__atomic_fetch_add(&test_failures, 1, __ATOMIC_RELAXED) < TEST_MAX_PRINTED_FAILURES)
+    {
+        fprintf(stderr, "%s:%d: FAILED: %s\n", file, line, what);
+    }
+}
+
+static inline void test_fail_eq(const char * file, int line, const char * what, uint64_t actual, uint64_t expected)
+{
+    if (__atomic_fetch_add(&test_failures, 1, __ATOMIC_RELAXED) < TEST_MAX_PRINTED_FAILURES)
+    {
+        fprintf(stderr, "%s:%d: FAILED: %s: got %llu (0x%llx), expected %llu (0x%llx)\n", file, line, what,
+                (unsigned long long)actual, (unsigned long long)actual, (unsigned long long)expected,
+                (unsigned long long)expected);
+    }
+}
+
+// Check that `condition` is true.
+#define CHECK(condition) ((condition) ? (void)0 : test_fail(__FILE__, __LINE__, #condition))
+
+// Check that two integers (of any type that fits in 64 bits; signed ones are printed as their bits) are equal.
+#define CHECK_EQ(actual, expected)                                                                                     \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        uint64_t check_actual_ = (uint64_t)(actual);                                                                   \
+        uint64_t check_expected_ = (uint64_t)(expected);                                                               \
+        if (check_actual_ != check_expected_)                                                                          \
+        {                                                                                                              \
+            test_fail_eq(__FILE__, __LINE__, #actual " == " #expected, check_actual_, check_expected_);                \
+        }                                                                                                              \
+    } while (0)
+
+// A failed check's count, for a test to stop early (ex: before using a result it just found to be NULL).
+static inline uint64_t test_failure_count(void)
+{
+    return __atomic_load_n(&test_failures, __ATOMIC_RELAXED);
+}
+
+// Print the verdict and return main()'s exit status: 0 if every check passed.
+static inline int test_finish(const char * name)
+{
+    uint64_t failures = test_failure_count();
+    if (failures == 0)
+    {
+        printf("%s: all checks passed\n", name);
+        return 0;
+    }
+    fprintf(stderr, "%s: %llu check(s) FAILED\n", name, (unsigned long long)failures);
+    return 1;
+}
+
+// A deterministic xorshift64 sequence, for random-looking inputs that are the same on every run and every machine.
+static inline uint64_t test_random(uint64_t * state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+// A test_random() number with a pseudo-random number of bits, so small numbers (and exact ties) come up often too.
+static inline uint64_t test_random_bits(uint64_t * state)
+{
+    uint64_t x = test_random(state);
+    return x >> (test_random(state) % 64);
+}
+
+#endif // FIXED_POINT_TEST_H
@@ -0,0 +1,296 @@
+/*
+test_arena
+- Checks that once warmed up, a loop of fixed_sort() and fixed_stats_percentiles() batches with fixed_arena_thread()
+  as their scratch arena makes no heap allocations at all (fixed_arena_heap_allocations() stays the same), on 1 and
+  on several threads.
+- Checks fixed_scratch_begin() / fixed_scratch_end() nested inside a caller's own use of the thread's arena: the
+  inner call falls back to the heap when the arena can't grow, and each gives back exactly what it took.
+- Checks fixed_arena_alloc()'s alignment and bounds, fixed_arena_mark() / fixed_arena_release() /
+  fixed_arena_reserve(), zero-byte allocations (which never use or grow an arena), and threads that exit owning a
+  scratch arena (which must free it: run under ASan or valgrind to see a leak).
+- Checks that fixed_arena_alloc_or_heap() takes from the arena when there is one, and otherwise from the heap (aligned,
+  and counted by fixed_arena_heap_allocations()), as columns do.
+*/
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fixed_point_arena.h"
+#include "fixed_point_column.h"
+#include "fixed_point_sort.h"
+#include "fixed_point_stats.h"
+#include "test.h"
+
+#define MAX_N 20000
+#define NUM_BATCHES 50
+#define NUM_EXITING_THREADS 8
+
+static bool is_aligned(const void * pointer, size_t alignment)
+{
+    return (uintptr_t)pointer % alignment == 0;
+}
+
+// One pass over batches of pseudo-random sizes (the same sizes every pass, for the same `seed`).
+static void run_batches(uint64_t seed, unsigned num_threads, uint64_t * state)
+{
+    static fixed_point_t values[MAX_N];
+    static const fixed_point_t PERCENTS[] = {0, 50 << 16, 99 << 16, 100 << 16};
+    fixed_point_t out[4];
+    for (int b = 0; b < NUM_BATCHES; b++)
+    {
+        size_t n = 1 + (size_t)(test_random(&seed) % MAX_N);
+        for (size_t i = 0; i < n; i++)
+        {
+            values[i] = (fixed_point_t)test_random(state);
+        }
+        CHECK(fixed_stats_percentiles(values, n, PERCENTS, 4, out, num_threads, fixed_arena_thread()));
+        CHECK(fixed_sort(values, n, num_threads, fixed_arena_thread()));
+        for (size_t i = 1; i < n; i++)
+        {
+            CHECK(values[i - 1] <= values[i]);
+        }
+        CHECK_EQ(out[0], values[0]);
+        CHECK_EQ(out[3], values[n - 1]);
+        // Nothing is left allocated.
+        CHECK_EQ(fixed_arena_mark(fixed_arena_thread()), 0);
+    }
+}
+
+static void check_warmed_up_loop(uint64_t * state)
+{
+    static const unsigned THREADS[] = {1, 4};
+    for (size_t t = 0; t < sizeof THREADS/sizeof THREADS[0]; t++)
+    {
+        run_batches(0x9E3779B97F4A7C15ULL, THREADS[t], state);
+        uint64_t warmed_up = fixed_arena_heap_allocations();
+        run_batches(0x9E3779B97F4A7C15ULL, THREADS[t], state);
+        run_batches(0xD1B54A32D192ED03ULL, THREADS[t], state);
+        CHECK_EQ(fixed_arena_heap_allocations(), warmed_up);
+    }
+}
+
+static void check_nested_scratch(void)
+{
+    fixed_arena_t * arena = fixed_arena_thread();
+    CHECK(fixed_arena_reserve(arena, 4096));
+    const size_t capacity = arena->capacity;
+    uint64_t heap_allocations = fixed_arena_heap_allocations();
+
+    // The caller's own allocation, then a kernel's scratch that fits, then one that doesn't (the arena isn't empty,
+    // so it can't grow: the heap, instead).
+    size_t outer_mark = fixed_arena_mark(arena);
+    uint8_t * own = (uint8_t *)fixed_arena_alloc(arena, 100, 0);
+    CHECK(own != NULL);
+    memset(own, 0x5A, 100);
+    size_t own_mark = fixed_arena_mark(arena);
+    fixed_scratch_t outer;
+    void * fits = fixed_scratch_begin(&outer, arena, 1000);
+    CHECK(fits != NULL && outer.heap == NULL && is_aligned(fits, FIXED_ARENA_ALIGNMENT));
+    fixed_scratch_t inner;
+    void * too_big = fixed_scratch_begin(&inner, arena, capacity);
+    CHECK(too_big != NULL && inner.heap == too_big && is_aligned(too_big, FIXED_ARENA_ALIGNMENT));
+    CHECK_EQ(fixed_arena_heap_allocations(), heap_allocations + 1);
+    CHECK_EQ(arena->capacity, capacity);
+    memset(too_big, 0xA5, capacity);
+    fixed_scratch_end(&inner);
+    CHECK(inner.heap == NULL);
+    fixed_scratch_end(&outer);
+    CHECK_EQ(fixed_arena_mark(arena), own_mark);
+    CHECK(own[0] == 0x5A && own[99] == 0x5A);
+    fixed_arena_release(arena, outer_mark);
+    CHECK_EQ(fixed_arena_mark(arena), outer_mark);
+
+    // NULL means the heap; an arena of your own that's too small fails (no fallback).
+    fixed_scratch_t scratch;
+    void * heap = fixed_scratch_begin(&scratch, NULL, 0);
+    CHECK(heap != NULL && scratch.heap == heap);
+    fixed_scratch_end(&scratch);
+    CHECK_EQ(fixed_arena_heap_allocations(), heap_allocations + 2);
+    static uint8_t buffer[256];
+    fixed_arena_t small;
+    fixed_arena_init_buffer(&small, buffer, sizeof buffer);
+    CHECK(fixed_scratch_begin(&scratch, &small, 1000) == NULL && scratch.heap == NULL);
+    fixed_scratch_end(&scratch);
+    CHECK_EQ(fixed_arena_mark(&small), 0);
+    CHECK_EQ(fixed_arena_heap_allocations(), heap_allocations + 2);
+}
+
+static void check_mark_release_reserve(void)
+{
+    // One byte past a 64-byte boundary, so the arena has to align the addresses, not just the offsets.
+    static uint8_t buffer[1024 + FIXED_ARENA_ALIGNMENT + 1];
+    uint8_t * start = buffer + (FIXED_ARENA_ALIGNMENT - (uintptr_t)buffer % FIXED_ARENA_ALIGNMENT) + 1;
+    fixed_arena_t arena;
+    fixed_arena_init_buffer(&arena, start, 1024);
+    void * a = fixed_arena_alloc(&arena, 10, 0);
+    CHECK(a != NULL && is_aligned(a, FIXED_ARENA_ALIGNMENT));
+    void * b = fixed_arena_alloc(&arena, 3, 1);
+    CHECK(b == (uint8_t *)a + 10);
+    size_t mark = fixed_arena_mark(&arena);
+    void * c = fixed_arena_alloc(&arena, 8, 8);
+    CHECK(c != NULL && is_aligned(c, 8) && (uint8_t *)c >= (uint8_t *)b + 3);
+    fixed_arena_release(&arena, mark);
+    CHECK_EQ(fixed_arena_mark(&arena), mark);
+    CHECK(fixed_arena_alloc(&arena, 8, 8) == c);
+    // Releasing to a later mark frees nothing.
+    fixed_arena_release(&arena, 1000);
+    CHECK(fixed_arena_mark(&arena) > mark && fixed_arena_mark(&arena) < 1000);
+    // Exactly full, then over.
+    size_t left = (size_t)(start + 1024 - ((uint8_t *)c + 8));
+    CHECK(fixed_arena_alloc(&arena, left + 1, 1) == NULL);
+    CHECK(fixed_arena_alloc(&arena, left, 1) == (uint8_t *)c + 8);
+    CHECK_EQ(fixed_arena_mark(&arena), 1024);
+    CHECK(fixed_arena_alloc(&arena, 1, 1) == NULL);
+    fixed_arena_reset(&arena);
+    CHECK_EQ(fixed_arena_mark(&arena), 0);
+    // Arenas that don't grow only "reserve" what they have.
+    CHECK(fixed_arena_reserve(&arena, 1024));
+    CHECK(!fixed_arena_reserve(&arena, 1025));
+    fixed_arena_free(&arena);
+
+    fixed_arena_t heap_arena;
+    uint64_t heap_allocations = fixed_arena_heap_allocations();
+    CHECK(fixed_arena_init(&heap_arena, 4096));
+    CHECK_EQ(fixed_arena_heap_allocations(), heap_allocations + 1);
+    CHECK(is_aligned(heap_arena.buffer, FIXED_ARENA_ALIGNMENT));
+    CHECK(fixed_arena_alloc(&heap_arena, 4097, 0) == NULL);
+    CHECK(!fixed_arena_reserve(&heap_arena, 8192));
+    fixed_arena_free(&heap_arena);
+    CHECK(fixed_arena_alloc(&heap_arena, 1, 0) == NULL);
+    CHECK(!fixed_arena_init(&heap_arena, 0));
+
+    // The thread's arena only grows while it's empty.
+    fixed_arena_t * thread = fixed_arena_thread();
+    CHECK(fixed_arena_reserve(thread, 1000));
+    size_t capacity = thread->capacity;
+    size_t thread_mark = fixed_arena_mark(thread);
+    CHECK(fixed_arena_alloc(thread, 1, 0) != NULL);
+    CHECK(!fixed_arena_reserve(thread, 2 * capacity));
+    CHECK(fixed_arena_alloc(thread, capacity, 0) == NULL);
+    fixed_arena_release(thread, thread_mark);
+    heap_allocations = fixed_arena_heap_allocations();
+    CHECK(fixed_arena_reserve(thread, 2 * capacity + 1));
+    CHECK(thread->capacity >= 2 * capacity + 1);
+    CHECK_EQ(fixed_arena_heap_allocations(), heap_allocations + 1);
+    // Freeing it gives the memory back, and it grows again when next needed.
+    fixed_arena_free(thread);
+    CHECK_EQ(thread->capacity, 0);
+    void * grown = fixed_arena_alloc(thread, 100, 0);
+    CHECK(grown != NULL && thread->capacity >= FIXED_ARENA_THREAD_MIN_CAPACITY);
+    CHECK_EQ(fixed_arena_heap_allocations(), heap_allocations + 2);
+    fixed_arena_release(thread, thread_mark);
+}
+
+static void check_zero_byte_allocs(void)
+{
+    uint64_t heap_allocations = fixed_arena_heap_allocations();
+    // An empty arena, with no buffer at all.
+    fixed_arena_t empty;
+    fixed_arena_init_buffer(&empty, NULL, 0);
+    void * zero = fixed_arena_alloc(&empty, 0, 0);
+    CHECK(zero != NULL && is_aligned(zero, FIXED_ARENA_ALIGNMENT));
+    CHECK(is_aligned(fixed_arena_alloc(&empty, 0, 16), 16));
+    CHECK(fixed_arena_alloc(&empty, 0, 2 * FIXED_ARENA_ALIGNMENT) == NULL);
+    CHECK_EQ(fixed_arena_mark(&empty), 0);
+
+    // A full one: still no room used.
+    static uint8_t buffer[64];
+    fixed_arena_t full;
+    fixed_arena_init_buffer(&full, buffer, sizeof buffer);
+    CHECK(fixed_arena_alloc(&full, sizeof buffer, 1) == buffer);
+    zero = fixed_arena_alloc(&full, 0, 1);
+    CHECK(zero != NULL);
+    CHECK_EQ(fixed_arena_mark(&full), sizeof buffer);
+
+    // A thread's arena that has nothing yet doesn't grow for one.
+    fixed_arena_t * thread = fixed_arena_thread();
+    fixed_arena_free(thread);
+    CHECK(fixed_arena_alloc(thread, 0, 0) != NULL);
+    CHECK_EQ(thread->capacity, 0);
+    CHECK_EQ(fixed_arena_heap_allocations(), heap_allocations);
+}
+
+static void check_alloc_or_heap(void)
+{
+    static uint8_t buffer[1024];
+    fixed_arena_t arena;
+    fixed_arena_init_buffer(&arena, buffer, sizeof buffer);
+    uint64_t heap_allocations = fixed_arena_heap_allocations();
+
+    // From the arena: nothing from the heap, and "freeing" leaves it for the next reset.
+    void * memory = fixed_arena_alloc_or_heap(&arena, 100, 0);
+    CHECK(memory != NULL && is_aligned(memory, FIXED_ARENA_ALIGNMENT));
+    size_t mark = fixed_arena_mark(&arena);
+    CHECK(mark >= 100);
+    fixed_arena_free_or_heap(&arena, memory);
+    CHECK_EQ(fixed_arena_mark(&arena), mark);
+    CHECK(fixed_arena_alloc_or_heap(&arena, sizeof buffer, 0) == NULL);
+    CHECK_EQ(fixed_arena_heap_allocations(), heap_allocations);
+
+    // From the heap, at any alignment, even for 0 bytes; each block counts.
+    static const size_t ALIGNMENTS[] = {0, 1, 16, FIXED_ARENA_ALIGNMENT, 4096};
+    for (size_t i = 0; i < sizeof ALIGNMENTS/sizeof ALIGNMENTS[0]; i++)
+    {
+        memory = fixed_arena_alloc_or_heap(NULL, i, ALIGNMENTS[i]);
+        CHECK(memory != NULL && is_aligned(memory, ALIGNMENTS[i] == 0 ? FIXED_ARENA_ALIGNMENT : ALIGNMENTS[i]));
+        fixed_arena_free_or_heap(NULL, memory);
+        CHECK_EQ(fixed_arena_heap_allocations(), heap_allocations + i + 1);
+    }
+
+    // A column's storage goes the same way.
+    heap_allocations = fixed_arena_heap_allocations();
+    fixed_column_t column;
+    CHECK(fixed_column_init(&column, 100, &arena));
+    fixed_column_free(&column);
+    CHECK_EQ(fixed_arena_heap_allocations(), heap_allocations);
+    CHECK(fixed_column_init(&column, 100, NULL));
+    fixed_column_free(&column);
+    CHECK_EQ(fixed_arena_heap_allocations(), heap_allocations + 1);
+}
+
+static void * exiting_thread_main(void * argument)
+{
+    fixed_arena_t * arena = fixed_arena_thread();
+    void * memory = fixed_arena_alloc(arena, 100000, 0);
+    *(bool *)argument = memory != NULL && arena != NULL && arena->capacity >= 100000;
+    if (memory != NULL)
+    {
+        memset(memory, 0x5A, 100000);
+    }
+    // Exits with the memory still allocated: the arena's destructor frees it all.
+    return NULL;
+}
+
+static void check_exiting_threads(void)
+{
+    fixed_arena_t * mine = fixed_arena_thread();
+    CHECK(fixed_arena_reserve(mine, 1000));
+    const uint8_t * buffer = mine->buffer;
+    const size_t capacity = mine->capacity;
+    uint64_t heap_allocations = fixed_arena_heap_allocations();
+    for (int i = 0; i < NUM_EXITING_THREADS; i++)
+    {
+        pthread_t thread;
+        bool ok = false;
+        CHECK(pthread_create(&thread, NULL, exiting_thread_main, &ok) == 0);
+        pthread_join(thread, NULL);
+        CHECK(ok);
+    }
+    // Each had its own arena (1 block each), and this thread's wasn't touched.
+    CHECK_EQ(fixed_arena_heap_allocations(), heap_allocations + NUM_EXITING_THREADS);
+    CHECK(mine == fixed_arena_thread() && mine->buffer == buffer && mine->capacity == capacity);
+}
+
+int main(void)
+{
+    uint64_t state = 0x3C6EF372FE94F82BULL;
+    check_warmed_up_loop(&state);
+    check_nested_scratch();
+    check_mark_release_reserve();
+    check_zero_byte_allocs();
+    check_alloc_or_heap();
+    check_exiting_threads();
+    fixed_arena_free(fixed_arena_thread());
+    return test_finish("test_arena");
+}
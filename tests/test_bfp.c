@@ -0,0 +1,409 @@
+/*
+test_bfp
+- Checks fixed_point_bfp.h's block floating point arrays block by block, against the exact values they stand for:
+  every block must be normalized (its biggest mantissa using exactly all but the top 2 bits, or all zeros with
+  FIXED_BFP_ZERO_EXPONENT), and its mantissas must be the exact result rounded half up once to the block's exponent.
+  The exact results come from plain 64-bit integer math: the input itself when converting, the aligned sums for
+  adding and subtracting, and the 64-bit products for multiplying.
+- Checks converting back to integers and doubles, renormalizing mantissas that were changed directly, saturating
+  and underflowing exponents, arrays from an arena, and shape mismatches.
+- For every block size, both mantissa widths, and sizes that do and don't fill the last block.
+*/
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fixed_point_bfp.h"
+#include "test.h"
+
+#define MAX_SIZE 1000
+
+// floor(x / 2^shift), for negative x too, without right-shifting a negative number.
+static int64_t floor_div_pow2(int64_t x, int shift)
+{
+    int64_t divisor = (int64_t)1 << shift;
+    return x >= 0 ? x / divisor : -((-x + divisor - 1) / divisor);
+}
+
+// x * 2^shift, rounded half up (floor(x + 1/2)) when shift is negative, for |x| < 2^62. Saturates past 2^63, which
+// only 32-bit numbers shifted up by more than 32 bits can reach.
+static int64_t scale(int64_t x, int64_t shift)
+{
+    if (shift >= 0)
+    {
+        return shift <= 32 ? x * ((int64_t)1 << shift) : x > 0 ? INT64_MAX : x < 0 ? INT64_MIN : 0;
+    }
+    return shift < -62 ? 0 : floor_div_pow2(x + ((int64_t)1 << (-shift - 1)), (int)-shift);
+}
+
+// A double rounded half up to an integer, without adding 1/2 (which can round, for doubles with bits below 2^-1).
+static int64_t round_double(double x)
+{
+    double floored = floor(x);
+    return (int64_t)floored + (x - floored >= 0.5);
+}
+
+static int32_t mantissa(const fixed_bfp_t * bfp, size_t i)
+{
+    return bfp->mantissa_bits == 32 ? bfp->mantissas32[i] : bfp->mantissas16[i];
+}
+
+static void set_mantissa(fixed_bfp_t * bfp, size_t i, int32_t x)
+{
+    if (bfp->mantissa_bits == 32)
+    {
+        bfp->mantissas32[i] = x;
+    }
+    else
+    {
+        bfp->mantissas16[i] = (int16_t)x;
+    }
+}
+
+// Check that block number `block` is normalized, or all zeros, and return whether it's all zeros.
+static bool check_normalized(const fixed_bfp_t * bfp, size_t block)
+{
+    const size_t start = block * bfp->block_size;
+    const int32_t top = (int32_t)((1u << (bfp->mantissa_bits - 2)) - 1);
+    uint32_t magnitudes = 0;
+    bool nonzero = false;
+    bool has_negative_power = false;
+    for (size_t i = start; i < start + bfp->block_size; i++)
+    {
+        int32_t m = mantissa(bfp, i);
+        CHECK(m >= -top - 1 && m <= top);
+        // (The padding at the end of the last block stays 0.)
+        CHECK(i < bfp->size || m == 0);
+        magnitudes |= m < 0 ? ~(uint32_t)m : (uint32_t)m;
+        nonzero |= m != 0;
+        has_negative_power |= m == -(int32_t)(1u << (bfp->mantissa_bits - 3));
+    }
+    int32_t exponent = bfp->exponents[block];
+    if (!nonzero)
+    {
+        CHECK_EQ(exponent, FIXED_BFP_ZERO_EXPONENT);
+        return true;
+    }
+    CHECK(exponent >= FIXED_BFP_MIN_EXPONENT && exponent <= FIXED_BFP_MAX_EXPONENT);
+    // The biggest one has the top bit below the sign bit and the spare bit, unless the exponent had to stop at the
+    // smallest one, or the biggest one is a negative tie that rounded up to -2^(bits - 3) (ex: -16385/2 for 16 bits,
+    // which doesn't fit one bit finer).
+    CHECK(magnitudes >> (bfp->mantissa_bits - 3) == 1 || exponent == FIXED_BFP_MIN_EXPONENT
+          || (magnitudes == (1u << (bfp->mantissa_bits - 3)) - 1 && has_negative_power));
+    return false;
+}
+
+// Check block number `block` against the exact values `exact[i] * 2^exponent`. (Mantissas that round to nothing at
+// the block's exponent are fine; a block of only those isn't, unless the exact values are all 0.)
+static void check_block(const fixed_bfp_t * bfp, size_t block, const int64_t * exact, int64_t exponent)
+{
+    const size_t start = block * bfp->block_size;
+    bool exact_zero = true;
+    for (size_t i = 0; i < bfp->block_size; i++)
+    {
+        exact_zero &= exact[i] == 0;
+    }
+    bool zero = check_normalized(bfp, block);
+    CHECK(zero == exact_zero);
+    if (zero)
+    {
+        return;
+    }
+    for (size_t i = 0; i < bfp->block_size && start + i < bfp->size; i++)
+    {
+        CHECK_EQ(mantissa(bfp, start + i), scale(exact[i], exponent - bfp->exponents[block]));
+    }
+}
+
+static void check_from_int32(const fixed_bfp_t * bfp, const int32_t * in, unsigned fraction_bits)
+{
+    int64_t exact[FIXED_BFP_MAX_BLOCK_SIZE];
+    for (size_t block = 0; block < bfp->num_blocks; block++)
+    {
+        for (size_t i = 0; i < bfp->block_size; i++)
+        {
+            size_t j = block * bfp->block_size + i;
+            exact[i] = j < bfp->size ? in[j] : 0;
+        }
+        check_block(bfp, block, exact, -(int64_t)fraction_bits);
+    }
+}
+
+static void check_to_int32(const fixed_bfp_t * bfp, unsigned fraction_bits)
+{
+    static int32_t out[MAX_SIZE];
+    fixed_bfp_to_int32(bfp, out, fraction_bits);
+    for (size_t i = 0; i < bfp->size; i++)
+    {
+        int32_t exponent = bfp->exponents[i / bfp->block_size];
+        int64_t y = exponent == FIXED_BFP_ZERO_EXPONENT ? 0
+                                                        : scale(mantissa(bfp, i), exponent + (int64_t)fraction_bits);
+        CHECK_EQ(out[i], y < INT32_MIN ? INT32_MIN : y > INT32_MAX ? INT32_MAX : y);
+    }
+}
+
+static void check_doubles(fixed_bfp_t * bfp, const double * in)
+{
+    static double out[MAX_SIZE];
+    fixed_bfp_from_double(bfp, in);
+    fixed_bfp_to_double(bfp, out);
+    for (size_t block = 0; block < bfp->num_blocks; block++)
+    {
+        bool zero = check_normalized(bfp, block);
+        for (size_t i = block * bfp->block_size; i < bfp->size && i < (block + 1) * bfp->block_size; i++)
+        {
+            int32_t exponent = bfp->exponents[block];
+            CHECK(!zero || in[i] == 0);
+            if (!zero)
+            {
+                CHECK_EQ(mantissa(bfp, i), round_double(ldexp(in[i], -exponent)));
+            }
+            CHECK(out[i] == (zero ? 0 : ldexp(mantissa(bfp, i), exponent)));
+        }
+    }
+}
+
+// out = a + b, a - b, or a * b (operation 0, 1, 2), as exact values for each block, from the inputs' mantissas.
+static void check_arithmetic(const fixed_bfp_t * out, const fixed_bfp_t * a, const fixed_bfp_t * b, int operation)
+{
+    int64_t exact[FIXED_BFP_MAX_BLOCK_SIZE];
+    for (size_t block = 0; block < out->num_blocks; block++)
+    {
+        int64_t exponent_a = a->exponents[block];
+        int64_t exponent_b = b->exponents[block];
+        int64_t exponent = exponent_a > exponent_b ? exponent_a : exponent_b;
+        for (size_t i = 0; i < out->block_size; i++)
+        {
+            int64_t x = mantissa(a, block * out->block_size + i);
+            int64_t y = mantissa(b, block * out->block_size + i);
+            if (operation == 2)
+            {
+                exact[i] = x * y;
+            }
+            else
+            {
+                // Both aligned (rounded half up) to the bigger exponent first.
+                x = scale(x, exponent_a - exponent);
+                y = scale(y, exponent_b - exponent);
+                exact[i] = operation == 0 ? x + y : x - y;
+            }
+        }
+        check_block(out, block, exact, operation == 2 ? exponent_a + exponent_b : exponent);
+    }
+}
+
+// Pseudo-random values, with each block's magnitude picked separately (sometimes all zeros), so neighboring blocks
+// have very different exponents.
+static void fill_int32(int32_t * values, size_t n, uint64_t * state)
+{
+    for (size_t start = 0; start < n; start += FIXED_BFP_MIN_BLOCK_SIZE)
+    {
+        int bits = (int)(test_random(state) % 33) - 1; // -1 for all zeros
+        for (size_t i = start; i < n && i < start + FIXED_BFP_MIN_BLOCK_SIZE; i++)
+        {
+            uint32_t x = bits <= 0 ? 0 : (uint32_t)test_random(state) >> (32 - bits) >> (test_random(state) % 3);
+            values[i] = test_random(state) % 2 == 0 ? (int32_t)x : -(int32_t)(x >> 1) - 1;
+        }
+    }
+}
+
+static void fill_double(double * values, size_t n, uint64_t * state)
+{
+    for (size_t start = 0; start < n; start += FIXED_BFP_MIN_BLOCK_SIZE)
+    {
+        int exponent = (int)(test_random(state) % 200) - 100;
+        bool zeros = test_random(state) % 8 == 0;
+        for (size_t i = start; i < n && i < start + FIXED_BFP_MIN_BLOCK_SIZE; i++)
+        {
+            double x = ldexp((double)(int64_t)(test_random(state) >> 11), exponent - (int)(test_random(state) % 20));
+            values[i] = zeros ? 0 : test_random(state) % 2 == 0 ? x : -x;
+        }
+    }
+}
+
+static bool make(fixed_bfp_t * bfp, size_t size, unsigned block_size, unsigned mantissa_bits, fixed_arena_t * arena)
+{
+    bool ok = fixed_bfp_init(bfp, size, block_size, mantissa_bits, arena);
+    CHECK(ok);
+    return ok;
+}
+
+static void check_shape(size_t size, unsigned block_size, unsigned mantissa_bits, fixed_arena_t * arena,
+                        uint64_t * state)
+{
+    static int32_t in_a[MAX_SIZE];
+    static int32_t in_b[MAX_SIZE];
+    static double in_double[MAX_SIZE];
+    fixed_bfp_t a;
+    fixed_bfp_t b;
+    fixed_bfp_t out;
+    fixed_bfp_t in_place;
+    if (!make(&a, size, block_size, mantissa_bits, arena) || !make(&b, size, block_size, mantissa_bits, arena)
+        || !make(&out, size, block_size, mantissa_bits, arena)
+        || !make(&in_place, size, block_size, mantissa_bits, arena))
+    {
+        return;
+    }
+    CHECK_EQ(a.num_blocks, (size + block_size - 1) / block_size);
+    CHECK((a.mantissas32 != NULL) == (mantissa_bits == 32) && (a.mantissas16 != NULL) == (mantissa_bits == 16));
+    for (size_t block = 0; block < a.num_blocks; block++)
+    {
+        CHECK(check_normalized(&a, block));
+    }
+
+    unsigned fraction_a = (unsigned)(test_random(state) % 32);
+    unsigned fraction_b = (unsigned)(test_random(state) % 32);
+    fill_int32(in_a, size, state);
+    fill_int32(in_b, size, state);
+    fixed_bfp_from_int32(&a, in_a, fraction_a);
+    fixed_bfp_from_int32(&b, in_b, fraction_b);
+    check_from_int32(&a, in_a, fraction_a);
+    check_from_int32(&b, in_b, fraction_b);
+    check_to_int32(&a, fraction_a);
+    check_to_int32(&a, (unsigned)(test_random(state) % 32));
+
+    for (int operation = 0; operation < 3; operation++)
+    {
+        bool (*function)(fixed_bfp_t *, const fixed_bfp_t *, const fixed_bfp_t *) =
+            operation == 0 ? fixed_bfp_add : operation == 1 ? fixed_bfp_sub : fixed_bfp_mul;
+        CHECK(function(&out, &a, &b));
+        check_arithmetic(&out, &a, &b, operation);
+        // In place, as `a` and as both.
+        fixed_bfp_from_int32(&in_place, in_a, fraction_a);
+        CHECK(function(&in_place, &in_place, &b));
+        CHECK(memcmp(in_place.exponents, out.exponents, a.num_blocks * sizeof(int16_t)) == 0);
+        for (size_t i = 0; i < size; i++)
+        {
+            CHECK_EQ(mantissa(&in_place, i), mantissa(&out, i));
+        }
+        CHECK(function(&out, &a, &a));
+        fixed_bfp_from_int32(&in_place, in_a, fraction_a);
+        CHECK(function(&in_place, &in_place, &in_place));
+        CHECK(memcmp(in_place.exponents, out.exponents, a.num_blocks * sizeof(int16_t)) == 0);
+    }
+
+    fill_double(in_double, size, state);
+    check_doubles(&a, in_double);
+
+    // Renormalizing mantissas that were changed directly: any values at all, even all -1s. (A block left with
+    // FIXED_BFP_ZERO_EXPONENT counts as having the smallest exponent.)
+    static int64_t exact[MAX_SIZE + FIXED_BFP_MAX_BLOCK_SIZE];
+    static int32_t exponents[MAX_SIZE/FIXED_BFP_MIN_BLOCK_SIZE + 1];
+    for (size_t block = 0; block < b.num_blocks; block++)
+    {
+        int32_t exponent = (int32_t)(test_random(state) % 1000) - 500;
+        b.exponents[block] = test_random(state) % 4 == 0 ? FIXED_BFP_ZERO_EXPONENT : (int16_t)exponent;
+        exponents[block] = b.exponents[block] == FIXED_BFP_ZERO_EXPONENT ? FIXED_BFP_MIN_EXPONENT : exponent;
+        for (size_t j = block * block_size; j < (block + 1) * block_size; j++)
+        {
+            int32_t x = (int32_t)test_random_bits(state);
+            x = mantissa_bits == 16 ? (int16_t)x : x;
+            x = j >= size ? 0 : block % 5 == 1 ? -1 : x;
+            set_mantissa(&b, j, x);
+            exact[j] = x;
+        }
+    }
+    fixed_bfp_normalize(&b);
+    for (size_t block = 0; block < b.num_blocks; block++)
+    {
+        check_block(&b, block, exact + block * block_size, exponents[block]);
+    }
+
+    if (arena == NULL)
+    {
+        fixed_bfp_free(&a);
+        fixed_bfp_free(&b);
+        fixed_bfp_free(&out);
+        fixed_bfp_free(&in_place);
+    }
+}
+
+// Squaring a block again and again runs its exponent past the top (saturating) or the bottom (underflowing to 0).
+static void check_range(unsigned mantissa_bits)
+{
+    int32_t in[FIXED_BFP_MIN_BLOCK_SIZE] = {INT32_MAX, 3, -7};
+    int32_t in_small[FIXED_BFP_MIN_BLOCK_SIZE] = {1, -1};
+    fixed_bfp_t big;
+    fixed_bfp_t small;
+    if (!make(&big, FIXED_BFP_MIN_BLOCK_SIZE, FIXED_BFP_MIN_BLOCK_SIZE, mantissa_bits, NULL))
+    {
+        return;
+    }
+    if (!make(&small, FIXED_BFP_MIN_BLOCK_SIZE, FIXED_BFP_MIN_BLOCK_SIZE, mantissa_bits, NULL))
+    {
+        fixed_bfp_free(&big);
+        return;
+    }
+    fixed_bfp_from_int32(&big, in, 0);
+    fixed_bfp_from_int32(&small, in_small, 31);
+    for (int i = 0; i < 20; i++)
+    {
+        CHECK(fixed_bfp_mul(&big, &big, &big));
+        CHECK(fixed_bfp_mul(&small, &small, &small));
+        check_normalized(&big, 0);
+        check_normalized(&small, 0);
+    }
+    CHECK_EQ(big.exponents[0], FIXED_BFP_MAX_EXPONENT);
+    CHECK_EQ(mantissa(&big, 0), (1u << (mantissa_bits - 2)) - 1);
+    CHECK_EQ(small.exponents[0], FIXED_BFP_ZERO_EXPONENT);
+    int32_t out[FIXED_BFP_MIN_BLOCK_SIZE];
+    fixed_bfp_to_int32(&big, out, 16);
+    CHECK_EQ(out[0], INT32_MAX);
+    fixed_bfp_to_int32(&small, out, 31);
+    CHECK_EQ(out[0], 0);
+    fixed_bfp_free(&big);
+    fixed_bfp_free(&small);
+}
+
+int main(void)
+{
+    static const size_t SIZES[] = {0, 1, 15, 16, 17, 100, MAX_SIZE};
+    static const unsigned BLOCK_SIZES[] = {16, 24, 32, 64};
+    uint64_t state = 0x6A09E667F3BCC909ULL;
+    fixed_arena_t arena;
+    CHECK(fixed_arena_init(&arena, 1 << 20));
+    for (size_t s = 0; s < sizeof SIZES/sizeof SIZES[0]; s++)
+    {
+        for (size_t k = 0; k < sizeof BLOCK_SIZES/sizeof BLOCK_SIZES[0]; k++)
+        {
+            for (unsigned mantissa_bits = 16; mantissa_bits <= 32; mantissa_bits += 16)
+            {
+                for (int round = 0; round < 10; round++)
+                {
+                    check_shape(SIZES[s], BLOCK_SIZES[k], mantissa_bits, round % 2 == 0 ? NULL : &arena, &state);
+                    fixed_arena_reset(&arena);
+                }
+            }
+        }
+    }
+    check_range(16);
+    check_range(32);
+
+    // A block whose biggest value rounds up to a power of 2 is scaled down one more bit, and its other values must
+    // be rounded once, at that scale (2.5 is a tie at the first scale, but 1.25 isn't at the second).
+    double carry[FIXED_BFP_MIN_BLOCK_SIZE] = {(1 << 30) - 0.25, 2.5, -2.5, 1.5};
+    fixed_bfp_t bfp;
+    if (make(&bfp, FIXED_BFP_MIN_BLOCK_SIZE, FIXED_BFP_MIN_BLOCK_SIZE, 32, NULL))
+    {
+        check_doubles(&bfp, carry);
+        fixed_bfp_free(&bfp);
+    }
+
+    // Bad arguments, and arrays of different shapes.
+    CHECK(!fixed_bfp_init(&bfp, 100, 8, 32, NULL));
+    CHECK(!fixed_bfp_init(&bfp, 100, 20, 32, NULL));
+    CHECK(!fixed_bfp_init(&bfp, 100, FIXED_BFP_MAX_BLOCK_SIZE + 8, 32, NULL));
+    CHECK(!fixed_bfp_init(&bfp, 100, 16, 8, NULL));
+    CHECK(!fixed_bfp_init(&bfp, SIZE_MAX, 16, 32, NULL));
+    fixed_bfp_t a;
+    fixed_bfp_t b;
+    if (make(&a, 100, 16, 32, &arena) && make(&b, 100, 16, 16, &arena) && make(&bfp, 99, 16, 32, &arena))
+    {
+        CHECK(!fixed_bfp_add(&a, &a, &b));
+        CHECK(!fixed_bfp_sub(&a, &bfp, &a));
+        CHECK(!fixed_bfp_mul(&bfp, &a, &a));
+    }
+    fixed_arena_free(&arena);
+    return test_finish("test_bfp");
+}
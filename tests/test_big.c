@@ -0,0 +1,411 @@
+/*
+test_big
+- Checks fixed_big_mul_karatsuba() against fixed_big_mul_schoolbook() directly, for every size from 4 to
+  FIXED_BIG_MAX_LIMBS limbs: on random numbers, and on runs of all-1 and all-0 limbs (which make the carries out of
+  Karatsuba's half sums).
+- Checks fixed_big_mul() and fixed_big_div() in all 3 rounding modes against slow references here: a product summed
+  one limb product at a time, and bit-at-a-time long division, each rounded by looking at the bits or the remainder
+  it drops. That covers exact ties, results that saturate (before and after rounding), and division by zero.
+- Checks fixed_big_format() against exact digit strings (from Python's integers), and 1-limb numbers against a
+  uint64_t reference.
+*/
+
+// For snprintf() when compiling with -std=c99.
+#define _POSIX_C_SOURCE 200112L
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "fixed_point_big.h"
+#include "test.h"
+
+#define NUM_RANDOM 3000
+// Room for a double-width product plus a limb.
+#define WIDE_LIMBS (2*FIXED_BIG_MAX_LIMBS + 2)
+
+static const fixed_round_mode_t MODES[] = {FIXED_ROUND_HALF_UP, FIXED_ROUND_HALF_EVEN, FIXED_ROUND_TRUNCATE};
+
+static int get_bit(const uint32_t * a, size_t num_limbs, size_t bit)
+{
+    return bit / 32 < num_limbs && (a[bit / 32] >> (bit % 32)) & 1;
+}
+
+// a += value << (32*at), carrying as far as it goes.
+static void add_at(uint32_t * a, size_t num_limbs, size_t at, uint32_t value)
+{
+    for (; value != 0 && at < num_limbs; at++)
+    {
+        uint32_t sum = a[at] + value;
+        value = sum < value;
+        a[at] = sum;
+    }
+}
+
+// A random number, with random leading zero limbs, and some limbs all 0, all 1, or just the top bit.
+static void random_number(uint32_t * out, size_t num_limbs, uint64_t * state)
+{
+    size_t used = 1 + (size_t)(test_random(state) % num_limbs);
+    for (size_t i = 0; i < num_limbs; i++)
+    {
+        uint64_t x = test_random(state);
+        switch (x % 8)
+        {
+            case 0:
+                out[i] = 0;
+                break;
+            case 1:
+                out[i] = UINT32_MAX;
+                break;
+            case 2:
+                out[i] = 0x80000000u;
+                break;
+            default:
+                out[i] = (uint32_t)(x >> 32);
+                break;
+        }
+        out[i] = i < used ? out[i] : 0;
+    }
+}
+
+// The exact 2*num_limbs-limb product, one 32x32-bit product at a time.
+static void reference_product(uint32_t * out, const uint32_t * a, const uint32_t * b, size_t num_limbs)
+{
+    memset(out, 0, 2*num_limbs*sizeof(uint32_t));
+    for (size_t i = 0; i < num_limbs; i++)
+    {
+        for (size_t j = 0; j < num_limbs; j++)
+        {
+            uint64_t product = (uint64_t)a[i] * b[j];
+            add_at(out, 2*num_limbs, i + j, (uint32_t)product);
+            add_at(out, 2*num_limbs, i + j + 1, (uint32_t)(product >> 32));
+        }
+    }
+}
+
+// out = the truncated quotient, plus one if `mode` rounds it up (given the dropped part's comparison with one half),
+// saturated if it doesn't fit in `num_limbs` limbs. `quotient` has `quotient_limbs` limbs, with room for one more.
+static bool reference_finish(uint32_t * out, size_t num_limbs, uint32_t * quotient, size_t quotient_limbs,
+                             int half_comparison, fixed_round_mode_t mode)
+{
+    bool round_up = mode == FIXED_ROUND_HALF_UP ? half_comparison >= 0 :
+                    mode == FIXED_ROUND_HALF_EVEN ? half_comparison > 0 || (half_comparison == 0 && quotient[0] & 1) :
+                    false;
+    quotient[quotient_limbs] = 0;
+    if (round_up)
+    {
+        add_at(quotient, quotient_limbs + 1, 0, 1);
+    }
+    for (size_t i = num_limbs; i <= quotient_limbs; i++)
+    {
+        if (quotient[i] != 0)
+        {
+            memset(out, 0xff, num_limbs*sizeof(uint32_t));
+            return false;
+        }
+    }
+    memcpy(out, quotient, num_limbs*sizeof(uint32_t));
+    return true;
+}
+
+static bool reference_mul(uint32_t * out, const uint32_t * a, const uint32_t * b, size_t num_limbs,
+                          unsigned fraction_bits, fixed_round_mode_t mode)
+{
+    uint32_t product[WIDE_LIMBS];
+    reference_product(product, a, b, num_limbs);
+    size_t product_limbs = 2*num_limbs;
+    uint32_t shifted[WIDE_LIMBS] = {0};
+    for (size_t bit = fraction_bits; bit < 32*product_limbs; bit++)
+    {
+        size_t to = bit - fraction_bits;
+        shifted[to / 32] |= (uint32_t)get_bit(product, product_limbs, bit) << (to % 32);
+    }
+    int half_comparison = -1;
+    if (fraction_bits > 0 && get_bit(product, product_limbs, fraction_bits - 1))
+    {
+        half_comparison = 0;
+        for (size_t bit = 0; bit + 1 < fraction_bits; bit++)
+        {
+            half_comparison = get_bit(product, product_limbs, bit) ? 1 : half_comparison;
+        }
+    }
+    return reference_finish(out, num_limbs, shifted, product_limbs, half_comparison, mode);
+}
+
+// Compare 2 numbers of `num_limbs` limbs.
+static int reference_cmp(const uint32_t * a, const uint32_t * b, size_t num_limbs)
+{
+    for (size_t i = num_limbs; i-- > 0;)
+    {
+        if (a[i] != b[i])
+        {
+            return a[i] < b[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+static void reference_sub(uint32_t * a, const uint32_t * b, size_t num_limbs)
+{
+    uint32_t borrow = 0;
+    for (size_t i = 0; i < num_limbs; i++)
+    {
+        uint32_t difference = a[i] - b[i] - borrow;
+        borrow = a[i] < b[i] || (a[i] == b[i] && borrow);
+        a[i] = difference;
+    }
+}
+
+// a = 2*a + bit.
+static void reference_shift_in(uint32_t * a, size_t num_limbs, uint32_t bit)
+{
+    for (size_t i = 0; i < num_limbs; i++)
+    {
+        uint32_t top = a[i] >> 31;
+        a[i] = a[i] << 1 | bit;
+        bit = top;
+    }
+}
+
+// (a << fraction_bits) / b by restoring division, one quotient bit at a time.
+static bool reference_div(uint32_t * out, const uint32_t * a, const uint32_t * b, size_t num_limbs,
+                          unsigned fraction_bits, fixed_round_mode_t mode)
+{
+    bool b_is_zero = true;
+    for (size_t i = 0; i < num_limbs; i++)
+    {
+        b_is_zero = b_is_zero && b[i] == 0;
+    }
+    if (b_is_zero)
+    {
+        memset(out, 0xff, num_limbs*sizeof(uint32_t));
+        return false;
+    }
+    // The remainder is less than b, so twice it (plus one) fits in one more limb.
+    uint32_t divisor[FIXED_BIG_MAX_LIMBS + 1] = {0};
+    uint32_t remainder[FIXED_BIG_MAX_LIMBS + 1] = {0};
+    memcpy(divisor, b, num_limbs*sizeof(uint32_t));
+    uint32_t quotient[WIDE_LIMBS] = {0};
+    size_t numerator_bits = 32*num_limbs + fraction_bits;
+    for (size_t bit = numerator_bits; bit-- > 0;)
+    {
+        uint32_t numerator_bit = bit >= fraction_bits ? (uint32_t)get_bit(a, num_limbs, bit - fraction_bits) : 0;
+        reference_shift_in(remainder, num_limbs + 1, numerator_bit);
+        if (reference_cmp(remainder, divisor, num_limbs + 1) >= 0)
+        {
+            reference_sub(remainder, divisor, num_limbs + 1);
+            quotient[bit / 32] |= (uint32_t)1 << (bit % 32);
+        }
+    }
+    reference_shift_in(remainder, num_limbs + 1, 0);
+    return reference_finish(out, num_limbs, quotient, (numerator_bits + 31) / 32,
+                            reference_cmp(remainder, divisor, num_limbs + 1), mode);
+}
+
+static void check_karatsuba(uint64_t * state)
+{
+    uint32_t a[FIXED_BIG_MAX_LIMBS];
+    uint32_t b[FIXED_BIG_MAX_LIMBS];
+    uint32_t schoolbook[2*FIXED_BIG_MAX_LIMBS];
+    uint32_t karatsuba[2*FIXED_BIG_MAX_LIMBS + 1];
+    uint32_t reference[2*FIXED_BIG_MAX_LIMBS];
+    for (size_t num_limbs = 4; num_limbs <= FIXED_BIG_MAX_LIMBS; num_limbs++)
+    {
+        for (int i = 0; i < 60; i++)
+        {
+            if (i < 4)
+            {
+                // All 1s times all 1s, and halves of all 1s and all 0s.
+                for (size_t j = 0; j < num_limbs; j++)
+                {
+                    a[j] = i == 0 || (i == 1 && j < num_limbs / 2) || (i >= 2 && j >= num_limbs / 2) ? UINT32_MAX : 0;
+                    b[j] = i == 0 || (i == 1 && j >= num_limbs / 2) || (i == 3 && j < num_limbs / 2) ? UINT32_MAX : 0;
+                }
+            }
+            else
+            {
+                random_number(a, num_limbs, state);
+                random_number(b, num_limbs, state);
+            }
+            fixed_big_mul_schoolbook(schoolbook, a, b, num_limbs);
+            karatsuba[2*num_limbs] = 0xA5A5A5A5;
+            fixed_big_mul_karatsuba(karatsuba, a, b, num_limbs);
+            CHECK(memcmp(karatsuba, schoolbook, 2*num_limbs*sizeof(uint32_t)) == 0);
+            CHECK_EQ(karatsuba[2*num_limbs], 0xA5A5A5A5);
+            reference_product(reference, a, b, num_limbs);
+            CHECK(memcmp(schoolbook, reference, 2*num_limbs*sizeof(uint32_t)) == 0);
+        }
+    }
+}
+
+// fixed_big_mul() and fixed_big_div() against the references, in every mode, out of place and in place.
+static void check_mul_div(const uint32_t * a, const uint32_t * b, size_t num_limbs, unsigned fraction_bits,
+                          uint64_t * saturated)
+{
+    uint32_t out[FIXED_BIG_MAX_LIMBS + 1];
+    uint32_t in_place[FIXED_BIG_MAX_LIMBS];
+    uint32_t expected[FIXED_BIG_MAX_LIMBS];
+    for (size_t m = 0; m < sizeof MODES/sizeof MODES[0]; m++)
+    {
+        bool fits = reference_mul(expected, a, b, num_limbs, fraction_bits, MODES[m]);
+        *saturated += !fits;
+        out[num_limbs] = 0xA5A5A5A5;
+        CHECK_EQ(fixed_big_mul(out, a, b, num_limbs, fraction_bits, MODES[m]), fits);
+        CHECK(memcmp(out, expected, num_limbs*sizeof(uint32_t)) == 0);
+        CHECK_EQ(out[num_limbs], 0xA5A5A5A5);
+        memcpy(in_place, a, num_limbs*sizeof(uint32_t));
+        CHECK_EQ(fixed_big_mul(in_place, in_place, b, num_limbs, fraction_bits, MODES[m]), fits);
+        CHECK(memcmp(in_place, expected, num_limbs*sizeof(uint32_t)) == 0);
+
+        fits = reference_div(expected, a, b, num_limbs, fraction_bits, MODES[m]);
+        *saturated += !fits;
+        CHECK_EQ(fixed_big_div(out, a, b, num_limbs, fraction_bits, MODES[m]), fits);
+        CHECK(memcmp(out, expected, num_limbs*sizeof(uint32_t)) == 0);
+        CHECK_EQ(out[num_limbs], 0xA5A5A5A5);
+        memcpy(in_place, b, num_limbs*sizeof(uint32_t));
+        CHECK_EQ(fixed_big_div(in_place, a, in_place, num_limbs, fraction_bits, MODES[m]), fits);
+        CHECK(memcmp(in_place, expected, num_limbs*sizeof(uint32_t)) == 0);
+    }
+}
+
+static void check_rounding(uint64_t * state)
+{
+    uint32_t a[FIXED_BIG_MAX_LIMBS];
+    uint32_t b[FIXED_BIG_MAX_LIMBS];
+    uint64_t saturated = 0;
+    for (int i = 0; i < NUM_RANDOM; i++)
+    {
+        size_t num_limbs = 1 + (size_t)(test_random(state) % FIXED_BIG_MAX_LIMBS);
+        // Mostly small sizes: the references are slow.
+        num_limbs = i % 4 == 0 ? num_limbs : 1 + num_limbs % 4;
+        unsigned fraction_bits = (unsigned)(test_random(state) % (32*num_limbs));
+        random_number(a, num_limbs, state);
+        random_number(b, num_limbs, state);
+        switch (i % 4)
+        {
+            case 1:
+                // b = 1/2 (times a is a/2) or 2 (a over it is a/2): an exact tie whenever a is odd.
+                memset(b, 0, num_limbs*sizeof(uint32_t));
+                fraction_bits = 1 + fraction_bits % (32*(unsigned)num_limbs - 2);
+                b[(fraction_bits - 1) / 32] = (uint32_t)1 << ((fraction_bits - 1) % 32);
+                check_mul_div(a, b, num_limbs, fraction_bits, &saturated);
+                memset(b, 0, num_limbs*sizeof(uint32_t));
+                b[(fraction_bits + 1) / 32] = (uint32_t)1 << ((fraction_bits + 1) % 32);
+                break;
+            case 2:
+                // Division by zero.
+                memset(b, 0, num_limbs*sizeof(uint32_t));
+                break;
+            default:
+                break;
+        }
+        check_mul_div(a, b, num_limbs, fraction_bits, &saturated);
+    }
+    CHECK(saturated > 0);
+
+    // 7 * 0x49249249 = 2^33 - 1: with 1 fraction bit, 0xFFFFFFFF and an exact tie, so rounding up overflows.
+    a[0] = 7;
+    b[0] = 0x49249249;
+    uint32_t out[1];
+    CHECK(!fixed_big_mul(out, a, b, 1, 1, FIXED_ROUND_HALF_UP) && out[0] == UINT32_MAX);
+    CHECK(!fixed_big_mul(out, a, b, 1, 1, FIXED_ROUND_HALF_EVEN) && out[0] == UINT32_MAX);
+    CHECK(fixed_big_mul(out, a, b, 1, 1, FIXED_ROUND_TRUNCATE) && out[0] == UINT32_MAX);
+    b[0] = 0;
+    CHECK(!fixed_big_div(out, a, b, 1, 0, FIXED_ROUND_TRUNCATE) && out[0] == UINT32_MAX);
+}
+
+static void check_format_string(const uint32_t * a, size_t num_limbs, unsigned fraction_bits, uint8_t digits,
+                                const char * expected)
+{
+    char out[FIXED_BIG_FORMAT_LEN(FIXED_BIG_MAX_LIMBS, FIXED_BIG_MAX_DIGITS) + 1];
+    uint8_t used_digits = digits < FIXED_BIG_MAX_DIGITS ? digits : FIXED_BIG_MAX_DIGITS;
+    size_t len = FIXED_BIG_FORMAT_LEN(num_limbs, used_digits);
+    out[len] = (char)0xA5;
+    CHECK_EQ(fixed_big_format(a, num_limbs, fraction_bits, digits, out), strlen(expected));
+    CHECK(strcmp(out, expected) == 0);
+    CHECK_EQ((uint8_t)out[len], 0xA5);
+    if (strcmp(out, expected) != 0)
+    {
+        printf("    got %s\n    expected %s\n", out, expected);
+    }
+}
+
+static void check_format(uint64_t * state)
+{
+    uint32_t a[FIXED_BIG_MAX_LIMBS] = {0};
+    check_format_string(a, 1, 0, 0, "0");
+    check_format_string(a, 1, 0, 3, "0.000");
+    a[0] = UINT32_MAX;
+    check_format_string(a, 1, 0, 0, "4294967295");
+    // Rounding carries into the whole number part.
+    check_format_string(a, 1, 32, 9, "1.000000000");
+    a[0] = 1;
+    // 0.5, rounded half up.
+    check_format_string(a, 1, 1, 0, "1");
+    check_format_string(a, 1, 1, 1, "0.5");
+    a[0] = 3;
+    check_format_string(a, 1, 1, 0, "2");
+    a[0] = 0x243F6A88;
+    a[1] = 3;
+    check_format_string(a, 2, 32, 10, "3.1415926535");
+
+    // 2^-128 and 2^-127, which have exactly 128 and 127 digits.
+    memset(a, 0, sizeof a);
+    a[0] = 1;
+    check_format_string(a, 5, 128, 128,
+                        "0.0000000000000000000000000000000000000029387358770557187699218413430556141945466638919302"
+                        "1880377187926569604314863681793212890625");
+    check_format_string(a, 4, 127, 128,
+                        "0.0000000000000000000000000000000000000058774717541114375398436826861112283890933277838604"
+                        "3760754375853139208629727363586425781250");
+    // More than FIXED_BIG_MAX_DIGITS digits prints FIXED_BIG_MAX_DIGITS.
+    check_format_string(a, 4, 127, 200,
+                        "0.0000000000000000000000000000000000000058774717541114375398436826861112283890933277838604"
+                        "3760754375853139208629727363586425781250");
+
+    // The largest number: 2^1024 - 1, and (2^1024 - 1)/2^1023 = 2 - 2^-1023.
+    memset(a, 0xff, sizeof a);
+    check_format_string(a, FIXED_BIG_MAX_LIMBS, 0, 0,
+                        "179769313486231590772930519078902473361797697894230657273430081157732675805500963132708477"
+                        "322407536021120113879871393357658789768814416622492847430639474124377767893424865485276302"
+                        "219601246094119453082952085005768838150682342462881473913110540827237163350510684586298239"
+                        "947245938479716304835356329624224137215");
+    check_format_string(a, FIXED_BIG_MAX_LIMBS, 32*FIXED_BIG_MAX_LIMBS - 1, FIXED_BIG_MAX_DIGITS,
+                        "2.0000000000000000000000000000000000000000000000000000000000000000000000000000000000000000"
+                        "0000000000000000000000000000000000000000");
+
+    // 1-limb numbers, against 64-bit math: (value*10^digits), rounded half up, with the '.' put in.
+    for (int i = 0; i < NUM_RANDOM; i++)
+    {
+        uint32_t value = (uint32_t)test_random(state);
+        unsigned fraction_bits = (unsigned)(test_random(state) % 32);
+        uint8_t digits = (uint8_t)(test_random(state) % 10);
+        uint64_t power = 1;
+        for (uint8_t d = 0; d < digits; d++)
+        {
+            power *= 10;
+        }
+        uint64_t scaled = (uint64_t)value * power;
+        scaled = fraction_bits == 0 ? scaled : (scaled + ((uint64_t)1 << (fraction_bits - 1))) >> fraction_bits;
+        char expected[32];
+        if (digits == 0)
+        {
+            snprintf(expected, sizeof expected, "%" PRIu64, scaled);
+        }
+        else
+        {
+            snprintf(expected, sizeof expected, "%" PRIu64 ".%0*" PRIu64, scaled / power, (int)digits, scaled % power);
+        }
+        a[0] = value;
+        check_format_string(a, 1, fraction_bits, digits, expected);
+    }
+}
+
+int main(void)
+{
+    uint64_t state = 0x1F83D9ABFB41BD6BULL;
+    check_karatsuba(&state);
+    check_rounding(&state);
+    check_format(&state);
+    return test_finish("test_big");
+}
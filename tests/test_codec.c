@@ -0,0 +1,288 @@
+/*
+test_codec
+- Checks that fixed_point_codec.h round-trips streams of every kind it's made for (random, linear ramps, random
+  walks, ramps with outliers, walks with level shifts, all 0, all UINT32_MAX), for lengths around the block size and
+  longer; that together they use all 4 block encodings (bit-packed and varints, deltas and delta-of-deltas); and
+  that any block decodes on its own (random access) without writing past the stream's end.
+- Checks that fixed_codec_encode() returns 0 when `out` is even one byte short (and writes nothing past it), and
+  that the header's version, magic, block size, and fraction bits are checked or reported.
+- Checks every truncation and every single-bit flip of an encoded stream: the decoder must reject it, or decode it
+  without reading or writing out of bounds. (Every buffer is malloc()ed at its exact size, so run under ASan or
+  valgrind to see an out-of-bounds access.)
+- Built twice on x86 (see CMakeLists.txt): with SSE2, and as test_codec_scalar without it, since each has its own
+  decoder.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "fixed_point_codec.h"
+#include "test.h"
+
+#define NUM_KINDS 7
+#define MAX_COUNT 10000
+
+// Block encoding bits, as in fixed_point_codec.h's format description.
+#define ENCODING_PACKED 1
+#define ENCODING_DELTA_OF_DELTA 2
+
+// How many blocks used each of the 4 encodings, over every stream encoded.
+static uint64_t encodings_seen[4];
+
+// `count` values of stream `kind`.
+static void fill(fixed_point_t * values, size_t count, int kind, uint64_t * state)
+{
+    uint32_t value = (uint32_t)test_random(state);
+    uint32_t step = (uint32_t)(test_random(state) % 2001) - 1000;
+    for (size_t i = 0; i < count; i++)
+    {
+        uint64_t x = test_random(state);
+        switch (kind)
+        {
+            case 0:
+                value = (uint32_t)x;
+                break;
+            case 1:
+                // A steady trend: every delta-of-delta is 0.
+                value += step;
+                break;
+            case 2:
+                value += (uint32_t)(x % 7) - 3;
+                break;
+            case 3:
+                // A trend, with an outlier every so often (which makes every bit-packed slot wide).
+                value += step;
+                values[i] = x % 40 == 0 ? value ^ (uint32_t)(x >> 32) : value;
+                continue;
+            case 4:
+                // A random walk with a rare jump to a new level.
+                value += x % 50 == 0 ? (uint32_t)(x >> 32) : (uint32_t)(x % 5) - 2;
+                break;
+            case 5:
+                value = 0;
+                break;
+            default:
+                value = UINT32_MAX;
+                break;
+        }
+        values[i] = value;
+    }
+}
+
+// Encode into a buffer of exactly fixed_codec_max_encoded_size() bytes. Returns it (malloc()ed), and its used size.
+static uint8_t * encode(const fixed_point_t * values, size_t count, size_t * size)
+{
+    size_t max_size = fixed_codec_max_encoded_size(count);
+    uint8_t * encoded = (uint8_t *)malloc(max_size);
+    if (encoded == NULL)
+    {
+        test_fail(__FILE__, __LINE__, "malloc()");
+        return NULL;
+    }
+    *size = fixed_codec_encode(values, count, encoded, max_size);
+    CHECK(*size >= FIXED_CODEC_HEADER_SIZE && *size <= max_size);
+    return encoded;
+}
+
+static void check_round_trip(const fixed_point_t * values, size_t count, uint64_t * state)
+{
+    size_t size = 0;
+    uint8_t * encoded = encode(values, count, &size);
+    fixed_point_t * decoded = (fixed_point_t *)malloc((count + 1) * sizeof(fixed_point_t));
+    if (encoded == NULL || decoded == NULL)
+    {
+        free(encoded);
+        free(decoded);
+        return;
+    }
+    fixed_codec_reader_t reader;
+    CHECK(fixed_codec_open(&reader, encoded, size));
+    CHECK_EQ(reader.num_values, count);
+    CHECK_EQ(reader.num_blocks, (count + FIXED_CODEC_BLOCK_VALUES - 1) / FIXED_CODEC_BLOCK_VALUES);
+    CHECK_EQ(reader.fraction_bits, FRACTION_BITS);
+    // Nothing past the end may be written.
+    decoded[count] = 0xA5A5A5A5;
+    CHECK(fixed_codec_decode(&reader, decoded));
+    CHECK(memcmp(decoded, values, count * sizeof(fixed_point_t)) == 0);
+    CHECK_EQ(decoded[count], 0xA5A5A5A5);
+
+    // Which encoding each block used: its first byte, at the offset in the block index.
+    for (uint32_t b = 0; b < reader.num_blocks; b++)
+    {
+        size_t start = 0;
+        for (int i = 7; i >= 0; i--)
+        {
+            start = start << 8 | encoded[FIXED_CODEC_HEADER_SIZE + 8*b + (size_t)i];
+        }
+        CHECK(start < size);
+        encodings_seen[encoded[start] & 3]++;
+    }
+
+    // Random access, in a pseudo-random order.
+    fixed_point_t block[FIXED_CODEC_BLOCK_VALUES + 1];
+    for (uint32_t i = 0; i < reader.num_blocks; i++)
+    {
+        uint32_t b = (uint32_t)(test_random(state) % reader.num_blocks);
+        size_t first = (size_t)b * FIXED_CODEC_BLOCK_VALUES;
+        size_t n = count - first < FIXED_CODEC_BLOCK_VALUES ? count - first : FIXED_CODEC_BLOCK_VALUES;
+        memset(block, 0xA5, sizeof block);
+        CHECK_EQ(fixed_codec_decode_block(&reader, b, block), n);
+        CHECK(memcmp(block, values + first, n * sizeof(fixed_point_t)) == 0);
+        CHECK_EQ(block[n], 0xA5A5A5A5);
+    }
+    CHECK_EQ(fixed_codec_decode_block(&reader, reader.num_blocks, block), 0);
+
+    // One byte short fails (writing nothing past the end: the buffer is exactly that size); exactly enough works.
+    if (size > 0)
+    {
+        uint8_t * short_buffer = (uint8_t *)malloc(size - 1);
+        if (short_buffer != NULL)
+        {
+            CHECK_EQ(fixed_codec_encode(values, count, short_buffer, size - 1), 0);
+            free(short_buffer);
+        }
+    }
+    uint8_t * exact = (uint8_t *)malloc(size);
+    if (exact != NULL)
+    {
+        CHECK_EQ(fixed_codec_encode(values, count, exact, size), size);
+        CHECK(memcmp(exact, encoded, size) == 0);
+        free(exact);
+    }
+    free(encoded);
+    free(decoded);
+}
+
+// Decode a corrupt stream: any result is fine, as long as nothing out of bounds is touched (the buffers are exact).
+static void decode_corrupt(const uint8_t * bytes, size_t size, bool * accepted)
+{
+    *accepted = false;
+    uint8_t * data = (uint8_t *)malloc(size == 0 ? 1 : size);
+    if (data == NULL)
+    {
+        return;
+    }
+    memcpy(data, bytes, size);
+    fixed_codec_reader_t reader;
+    // (A corrupt count can claim more values than fit in memory; those are out of scope here.)
+    if (fixed_codec_open(&reader, data, size) && reader.num_values <= 2 * MAX_COUNT)
+    {
+        fixed_point_t * out = (fixed_point_t *)malloc((size_t)reader.num_values * sizeof(fixed_point_t) + 1);
+        if (out != NULL)
+        {
+            *accepted = fixed_codec_decode(&reader, out);
+            fixed_point_t block[FIXED_CODEC_BLOCK_VALUES];
+            for (uint32_t b = 0; b < reader.num_blocks; b++)
+            {
+                fixed_codec_decode_block(&reader, b, block);
+            }
+            free(out);
+        }
+    }
+    free(data);
+}
+
+static void check_corruption(uint64_t * state)
+{
+    // 3 blocks, one each of a few encodings, the last one short.
+    fixed_point_t values[300];
+    fill(values, 128, 1, state);
+    fill(values + 128, 128, 3, state);
+    fill(values + 256, 44, 2, state);
+    size_t size = 0;
+    uint8_t * encoded = encode(values, 300, &size);
+    if (encoded == NULL)
+    {
+        return;
+    }
+    // Cut short anywhere: always rejected, since every byte up to the end is needed.
+    for (size_t length = 0; length < size; length++)
+    {
+        bool accepted;
+        decode_corrupt(encoded, length, &accepted);
+        CHECK(!accepted);
+    }
+    // Any one bit flipped.
+    uint8_t * flipped = (uint8_t *)malloc(size);
+    for (size_t bit = 0; flipped != NULL && bit < 8 * size; bit++)
+    {
+        memcpy(flipped, encoded, size);
+        flipped[bit / 8] ^= (uint8_t)(1u << (bit % 8));
+        bool accepted;
+        decode_corrupt(flipped, size, &accepted);
+    }
+    // Random garbage after a valid header.
+    for (int i = 0; flipped != NULL && i < 1000; i++)
+    {
+        memcpy(flipped, encoded, size);
+        for (size_t j = FIXED_CODEC_HEADER_SIZE; j < size; j++)
+        {
+            flipped[j] = test_random(state) % 4 == 0 ? (uint8_t)test_random(state) : flipped[j];
+        }
+        bool accepted;
+        decode_corrupt(flipped, size, &accepted);
+    }
+    free(flipped);
+    free(encoded);
+}
+
+static void check_header(void)
+{
+    fixed_point_t values[3] = {1, 2, 3};
+    uint8_t encoded[FIXED_CODEC_HEADER_SIZE + 8 + 64];
+    size_t size = fixed_codec_encode(values, 3, encoded, sizeof encoded);
+    CHECK(size > 0);
+    CHECK(memcmp(encoded, "FXPC", 4) == 0);
+    CHECK_EQ(encoded[4], FIXED_CODEC_VERSION);
+    CHECK_EQ(encoded[5], FRACTION_BITS);
+    fixed_codec_reader_t reader;
+    CHECK(fixed_codec_open(&reader, encoded, size));
+
+    // Another fraction bits is reported (for the reader to convert from), not rejected.
+    encoded[5] = 8;
+    CHECK(fixed_codec_open(&reader, encoded, size) && reader.fraction_bits == 8);
+    encoded[5] = FRACTION_BITS;
+    // Another version, magic, or block size is rejected.
+    encoded[4] = FIXED_CODEC_VERSION + 1;
+    CHECK(!fixed_codec_open(&reader, encoded, size));
+    encoded[4] = FIXED_CODEC_VERSION;
+    encoded[0] = 'X';
+    CHECK(!fixed_codec_open(&reader, encoded, size));
+    encoded[0] = 'F';
+    encoded[6] = 64;
+    CHECK(!fixed_codec_open(&reader, encoded, size));
+    encoded[6] = FIXED_CODEC_BLOCK_VALUES;
+    // A block count that doesn't match the value count.
+    encoded[16] = 2;
+    CHECK(!fixed_codec_open(&reader, encoded, size));
+    encoded[16] = 1;
+    CHECK(fixed_codec_open(&reader, encoded, size));
+
+    // Too small for even the header and index.
+    CHECK_EQ(fixed_codec_encode(values, 3, encoded, FIXED_CODEC_HEADER_SIZE + 7), 0);
+    CHECK_EQ(fixed_codec_encode(values, 0, encoded, FIXED_CODEC_HEADER_SIZE - 1), 0);
+    CHECK_EQ(fixed_codec_encode(values, 0, encoded, FIXED_CODEC_HEADER_SIZE), FIXED_CODEC_HEADER_SIZE);
+}
+
+int main(void)
+{
+    static const size_t COUNTS[] = {0, 1, 2, 3, 127, 128, 129, 255, 256, 257, 1000, MAX_COUNT};
+    static fixed_point_t values[MAX_COUNT];
+    uint64_t state = 0x510E527FADE682D1ULL;
+    for (size_t c = 0; c < sizeof COUNTS/sizeof COUNTS[0]; c++)
+    {
+        for (int kind = 0; kind < NUM_KINDS; kind++)
+        {
+            fill(values, COUNTS[c], kind, &state);
+            check_round_trip(values, COUNTS[c], &state);
+        }
+    }
+    CHECK(encodings_seen[ENCODING_PACKED] > 0);
+    CHECK(encodings_seen[ENCODING_PACKED | ENCODING_DELTA_OF_DELTA] > 0);
+    CHECK(encodings_seen[0] > 0);
+    CHECK(encodings_seen[ENCODING_DELTA_OF_DELTA] > 0);
+
+    check_header();
+    check_corruption(&state);
+    return test_finish("test_codec");
+}
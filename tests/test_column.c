@@ -0,0 +1,365 @@
+/*
+test_column
+- Checks every bulk operator in fixed_point_column.h against plain scalar math on each number, for every column size
+  up to 70 and a few bigger ones, with heap-backed and arena-backed columns: out of place (into a column that was
+  bigger, so it shrinks), and in place with `out` the same column as `a`, as `b`, and as both.
+- Checks after every operation, resize, and push that the storage is FIXED_COLUMN_ALIGNMENT-aligned and that the
+  padding past `size` is still zero (which the SIMD kernels rely on), and that mismatched sizes, dividing by 0, and an
+  arena that's full fail without changing anything.
+- Checks fixed_column_format() against the numbers formatted one at a time, and that it returns 0 (writing nothing
+  past the end) when the buffer is even one char too small.
+- Built twice on x86 (see CMakeLists.txt): with SSE2, and as test_column_scalar without it.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "fixed_point_column.h"
+#include "fixed_point_format.h"
+#include "test.h"
+
+#define MAX_BATCH 70
+#define MAX_SIZE 1000
+#define ARENA_SIZE (1024 * 1024)
+
+typedef enum op_e
+{
+    OP_ADD,
+    OP_SUB,
+    OP_MUL,
+    OP_DIV,
+    OP_MUL_INT,
+    OP_DIV_INT,
+    OP_ROUND,
+    NUM_OPS,
+} op_t;
+
+static fixed_point_t random_number(uint64_t * state)
+{
+    static const fixed_point_t SPECIAL[] = {0, 1, FRACTION_DIVISOR/2 - 1, FRACTION_DIVISOR/2, FRACTION_DIVISOR,
+                                            0x7FFFFFFF, 0x80000000, 0xFFFF8000, UINT32_MAX - 1, UINT32_MAX};
+    uint64_t x = test_random(state);
+    switch (x % 4)
+    {
+        case 0:
+            return SPECIAL[(x >> 8) % (sizeof SPECIAL/sizeof SPECIAL[0])];
+        case 1:
+            // Small numbers, so products and quotients don't all overflow.
+            return (fixed_point_t)(x >> 40);
+        default:
+            return (fixed_point_t)(x >> 32);
+    }
+}
+
+// One number of `op`'s result, computed on its own.
+static fixed_point_t reference(op_t op, fixed_point_t a, fixed_point_t b, uint32_t scalar)
+{
+    uint64_t result;
+    switch (op)
+    {
+        case OP_ADD:
+            return a + b;
+        case OP_SUB:
+            return a - b;
+        case OP_MUL:
+            return (fixed_point_t)(((uint64_t)a * b + FRACTION_DIVISOR/2) >> FRACTION_BITS);
+        case OP_DIV:
+            result = b == 0 ? UINT32_MAX : (((uint64_t)a << FRACTION_BITS) + b/2) / b;
+            return result > UINT32_MAX ? UINT32_MAX : (fixed_point_t)result;
+        case OP_MUL_INT:
+            return a * scalar;
+        case OP_DIV_INT:
+            return (fixed_point_t)(((uint64_t)a + scalar/2) / scalar);
+        case OP_ROUND:
+        default:
+        {
+            // Round to `scalar` decimal digits, then back to the nearest fixed-point number.
+            uint64_t pow10 = 1;
+            for (uint32_t i = 0; i < scalar; i++)
+            {
+                pow10 *= 10;
+            }
+            uint64_t decimal = ((uint64_t)a * pow10 + FRACTION_DIVISOR/2) >> FRACTION_BITS;
+            result = ((decimal << FRACTION_BITS) + pow10/2) / pow10;
+            return result > UINT32_MAX ? UINT32_MAX : (fixed_point_t)result;
+        }
+    }
+}
+
+static bool run_op(op_t op, fixed_column_t * out, const fixed_column_t * a, const fixed_column_t * b, uint32_t scalar)
+{
+    switch (op)
+    {
+        case OP_ADD:
+            return fixed_column_add(out, a, b);
+        case OP_SUB:
+            return fixed_column_sub(out, a, b);
+        case OP_MUL:
+            return fixed_column_mul(out, a, b);
+        case OP_DIV:
+            return fixed_column_div(out, a, b);
+        case OP_MUL_INT:
+            return fixed_column_mul_int(out, a, scalar);
+        case OP_DIV_INT:
+            return fixed_column_div_int(out, a, scalar);
+        case OP_ROUND:
+        default:
+            return fixed_column_round(out, a, (uint8_t)scalar);
+    }
+}
+
+// Aligned, with room for `size`, and all zero past it.
+static void check_storage(const fixed_column_t * column)
+{
+    CHECK(column->data != NULL && (uintptr_t)column->data % FIXED_COLUMN_ALIGNMENT == 0);
+    CHECK(column->capacity % FIXED_COLUMN_PAD == 0 && column->size <= column->capacity);
+    for (size_t i = column->size; column->data != NULL && i < column->capacity; i++)
+    {
+        if (column->data[i] != 0)
+        {
+            test_fail(__FILE__, __LINE__, "the padding is zero");
+            break;
+        }
+    }
+}
+
+// A column of `size` numbers, from the heap or from `arena`.
+static bool make_column(fixed_column_t * column, const fixed_point_t * numbers, size_t size, fixed_arena_t * arena)
+{
+    if (!fixed_column_init(column, size, arena) || !fixed_column_resize(column, size))
+    {
+        test_fail(__FILE__, __LINE__, "fixed_column_init()");
+        return false;
+    }
+    if (size > 0)
+    {
+        memcpy(column->data, numbers, size * sizeof(fixed_point_t));
+    }
+    check_storage(column);
+    return true;
+}
+
+static void check_result(op_t op, const fixed_column_t * out, const fixed_point_t * a, const fixed_point_t * b,
+                         size_t size, uint32_t scalar)
+{
+    CHECK_EQ(out->size, size);
+    check_storage(out);
+    for (size_t i = 0; i < size; i++)
+    {
+        fixed_point_t expected = reference(op, a[i], b[i], scalar);
+        if (out->data[i] != expected)
+        {
+            test_fail_eq(__FILE__, __LINE__, "out->data[i] == reference()", out->data[i], expected);
+            break;
+        }
+    }
+}
+
+// Every operator on columns of `size` numbers, out of place and in place.
+static void check_ops(size_t size, fixed_arena_t * arena, uint64_t * state)
+{
+    static fixed_point_t a_numbers[MAX_SIZE];
+    static fixed_point_t b_numbers[MAX_SIZE];
+    static fixed_point_t stale[MAX_SIZE + MAX_BATCH];
+    for (size_t i = 0; i < size; i++)
+    {
+        a_numbers[i] = random_number(state);
+        b_numbers[i] = random_number(state);
+    }
+    for (size_t i = 0; i < size + MAX_BATCH; i++)
+    {
+        stale[i] = (fixed_point_t)test_random(state) | 1;
+    }
+    for (int op = 0; op < NUM_OPS; op++)
+    {
+        uint32_t scalar = 0;
+        if (op == OP_MUL_INT || op == OP_DIV_INT)
+        {
+            // Small or any 32 bits (but not 0).
+            uint64_t x = test_random(state);
+            scalar = x % 2 == 0 ? 1 + (uint32_t)((x >> 8) % 100) : (uint32_t)(x >> 32) | 1;
+        }
+        else if (op == OP_ROUND)
+        {
+            scalar = (uint32_t)(test_random(state) % (FIXED_FORMAT_MAX_DIGITS + 1));
+        }
+        // Each column from the heap or the arena, at random.
+        fixed_arena_t * a_arena = test_random(state) % 2 == 0 ? arena : NULL;
+        fixed_arena_t * b_arena = test_random(state) % 2 == 0 ? arena : NULL;
+        fixed_arena_t * out_arena = test_random(state) % 2 == 0 ? arena : NULL;
+        fixed_column_t a;
+        fixed_column_t b;
+        fixed_column_t out;
+        if (!make_column(&a, a_numbers, size, a_arena) || !make_column(&b, b_numbers, size, b_arena)
+            || !make_column(&out, stale, size + 1 + (size_t)(test_random(state) % MAX_BATCH), out_arena))
+        {
+            return;
+        }
+
+        // Out of place, into a bigger column (which shrinks); the inputs don't change.
+        CHECK(run_op((op_t)op, &out, &a, &b, scalar));
+        check_result((op_t)op, &out, a_numbers, b_numbers, size, scalar);
+        CHECK(size == 0 || memcmp(a.data, a_numbers, size * sizeof(fixed_point_t)) == 0);
+        CHECK(size == 0 || memcmp(b.data, b_numbers, size * sizeof(fixed_point_t)) == 0);
+
+        // In place: out == a, and for the 2-input operators, out == b and out == a == b.
+        CHECK(run_op((op_t)op, &a, &a, &b, scalar));
+        check_result((op_t)op, &a, a_numbers, b_numbers, size, scalar);
+        if (op <= OP_DIV)
+        {
+            memcpy(a.data, a_numbers, size * sizeof(fixed_point_t));
+            CHECK(run_op((op_t)op, &b, &a, &b, scalar));
+            check_result((op_t)op, &b, a_numbers, b_numbers, size, scalar);
+            memcpy(a.data, a_numbers, size * sizeof(fixed_point_t));
+            CHECK(run_op((op_t)op, &a, &a, &a, scalar));
+            check_result((op_t)op, &a, a_numbers, a_numbers, size, scalar);
+
+            // Mismatched sizes fail, leaving `out` alone.
+            CHECK(fixed_column_push(&b, 1));
+            check_storage(&b);
+            memcpy(out.data, stale, size * sizeof(fixed_point_t));
+            CHECK(!run_op((op_t)op, &out, &a, &b, scalar));
+            CHECK_EQ(out.size, size);
+            CHECK(size == 0 || memcmp(out.data, stale, size * sizeof(fixed_point_t)) == 0);
+        }
+        fixed_column_free(&a);
+        fixed_column_free(&b);
+        fixed_column_free(&out);
+    }
+
+    fixed_column_t a;
+    fixed_column_t out;
+    if (make_column(&a, a_numbers, size, NULL) && make_column(&out, stale, size, NULL))
+    {
+        CHECK(!fixed_column_div_int(&out, &a, 0));
+        CHECK(size == 0 || memcmp(out.data, stale, size * sizeof(fixed_point_t)) == 0);
+        fixed_column_free(&a);
+        fixed_column_free(&out);
+    }
+}
+
+// Resizing and pushing keep the storage aligned and the padding zero; a full arena fails without changing anything.
+static void check_resize_push(uint64_t * state)
+{
+    static uint8_t buffer[1024 + FIXED_ARENA_ALIGNMENT];
+    fixed_arena_t arena;
+    fixed_arena_init_buffer(&arena, buffer, sizeof buffer);
+    fixed_column_t columns[2];
+    CHECK(fixed_column_init(&columns[0], 0, NULL));
+    CHECK(fixed_column_init(&columns[1], 0, &arena));
+    for (int c = 0; c < 2; c++)
+    {
+        fixed_column_t * column = &columns[c];
+        check_storage(column);
+        for (int i = 0; i < 2000; i++)
+        {
+            size_t size = column->size;
+            fixed_point_t last = size > 0 ? column->data[size - 1] : 0;
+            uint64_t x = test_random(state);
+            bool ok;
+            if (x % 3 == 0)
+            {
+                size_t new_size = (size_t)(x >> 8) % (2 * MAX_BATCH);
+                ok = fixed_column_resize(column, new_size);
+                CHECK(!ok || column->size == new_size);
+                for (size_t j = size; ok && j < new_size; j++)
+                {
+                    CHECK_EQ(column->data[j], 0);
+                }
+            }
+            else
+            {
+                fixed_point_t value = (fixed_point_t)(x >> 32) | 1;
+                ok = fixed_column_push(column, value);
+                CHECK(!ok || (column->size == size + 1 && column->data[size] == value));
+            }
+            // Only the arena can run out; then nothing changes.
+            CHECK(ok || c == 1);
+            if (!ok)
+            {
+                CHECK_EQ(column->size, size);
+                CHECK(size == 0 || column->data[size - 1] == last);
+                fixed_arena_reset(&arena);
+                CHECK(fixed_column_init(column, 0, &arena));
+            }
+            check_storage(column);
+        }
+    }
+    fixed_column_free(&columns[0]);
+}
+
+static void check_format(uint64_t * state)
+{
+    static char out[MAX_BATCH * FIXED_FORMAT_MAX_LEN + 1];
+    static char expected[MAX_BATCH * FIXED_FORMAT_MAX_LEN];
+    fixed_column_t column;
+    CHECK(fixed_column_init(&column, 0, NULL));
+    // Hand-checked: 1.5, 0, and the largest number, which rounds up to 65536.
+    CHECK(fixed_column_push(&column, 3 << (FRACTION_BITS - 1)));
+    CHECK(fixed_column_push(&column, 0));
+    CHECK(fixed_column_push(&column, UINT32_MAX));
+    CHECK_EQ(fixed_column_format(&column, 2, ',', out, sizeof out), 18);
+    CHECK(strcmp(out, "1.50,0.00,65536.00") == 0);
+    CHECK_EQ(fixed_column_format(&column, 0, '\n', out, sizeof out), 9);
+    CHECK(strcmp(out, "2\n0\n65536") == 0);
+
+    for (size_t size = 0; size <= MAX_BATCH; size++)
+    {
+        CHECK(fixed_column_resize(&column, size));
+        for (size_t i = 0; i < size; i++)
+        {
+            column.data[i] = random_number(state);
+        }
+        uint8_t digits = (uint8_t)(test_random(state) % (FIXED_FORMAT_MAX_DIGITS + 2));
+        size_t len = 0;
+        for (size_t i = 0; i < size; i++)
+        {
+            len += fixed_format(column.data[i], digits, expected + len);
+            expected[len++] = ',';
+        }
+        len -= len > 0;
+        expected[len] = '\0';
+
+        // Exactly enough room, then one char less: 0, and nothing written past the end.
+        memset(out, 0x5A, sizeof out);
+        CHECK_EQ(fixed_column_format(&column, digits, ',', out, len + 1), len);
+        CHECK(strcmp(out, expected) == 0);
+        CHECK_EQ((uint8_t)out[len + 1], 0x5A);
+        if (size > 0)
+        {
+            memset(out, 0x5A, sizeof out);
+            CHECK_EQ(fixed_column_format(&column, digits, ',', out, len), 0);
+            CHECK_EQ((uint8_t)out[len], 0x5A);
+        }
+    }
+    CHECK(fixed_column_resize(&column, 0));
+    CHECK_EQ(fixed_column_format(&column, 2, ',', out, 0), 0);
+    fixed_column_free(&column);
+}
+
+int main(void)
+{
+    uint64_t state = 0xA54FF53A5F1D36F1ULL;
+    fixed_arena_t arena;
+    if (!fixed_arena_init(&arena, ARENA_SIZE))
+    {
+        test_fail(__FILE__, __LINE__, "fixed_arena_init()");
+        return test_finish("test_column");
+    }
+    for (size_t size = 0; size <= MAX_BATCH; size++)
+    {
+        check_ops(size, &arena, &state);
+        fixed_arena_reset(&arena);
+    }
+    static const size_t BIG_SIZES[] = {255, 256, 257, MAX_SIZE};
+    for (size_t i = 0; i < sizeof BIG_SIZES/sizeof BIG_SIZES[0]; i++)
+    {
+        check_ops(BIG_SIZES[i], &arena, &state);
+        fixed_arena_reset(&arena);
+    }
+    fixed_arena_free(&arena);
+
+    check_resize_push(&state);
+    check_format(&state);
+    return test_finish("test_column");
+}
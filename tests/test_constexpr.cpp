@@ -0,0 +1,279 @@
+/*
+test_constexpr
+- Checks with static_assert that the FIXED_CONSTEXPR functions really are constant expressions in C++14 (the oldest
+  C++ they're constexpr in), on values worked out by hand: the rounding divisions (fixed_div_round_*(),
+  fixed_mul_div_round_u32()), fixed_div() and fixed_div_recip(), the Q15 and Q31 multiply-rounds, the time
+  conversions, fixed_ratio_apply32() with every method, a polynomial planned and evaluated at compile time, the
+  production build's fixed_tracked_*() functions, and parsing and formatting.
+- So most of it is checked by compiling it (see CMakeLists.txt: it's built as C++14, and on its own, since it isn't a
+  tests/test_*.c file). Running it checks that the plans built by hand here match the ones the library builds at run
+  time, so that the static_asserts on them are testing real plans.
+*/
+
+#include <string.h>
+
+#include "fixed_point_div.h"
+#include "fixed_point_format.h"
+#include "fixed_point_interval.h"
+#include "fixed_point_mul.h"
+#include "fixed_point_poly.h"
+#include "fixed_point_ratio.h"
+#include "fixed_point_round.h"
+#include "fixed_point_time.h"
+#include "test.h"
+
+#if !defined(__cplusplus) || __cplusplus < 201402L
+#error "test_constexpr needs C++14 or later"
+#endif
+
+#ifdef FIXED_POINT_TRACK_ERROR
+#error "test_constexpr checks the production build's fixed_tracked_t"
+#endif
+
+// -----------------------------------------------------------------------------------------------------------------
+// Rounding division
+// -----------------------------------------------------------------------------------------------------------------
+
+static_assert(fixed_div_round_u32(7, 2, FIXED_ROUND_HALF_UP) == 4, "fixed_div_round_u32() isn't constexpr");
+static_assert(fixed_div_round_u32(5, 2, FIXED_ROUND_HALF_EVEN) == 2, "fixed_div_round_u32() isn't constexpr");
+static_assert(fixed_div_round_u32(7, 2, FIXED_ROUND_TRUNCATE) == 3, "fixed_div_round_u32() isn't constexpr");
+static_assert(fixed_div_round_u64(UINT64_MAX, 2, FIXED_ROUND_HALF_UP) == (uint64_t)1 << 63,
+              "fixed_div_round_u64() isn't constexpr");
+static_assert(fixed_div_round_u64(UINT64_MAX, 2, FIXED_ROUND_TRUNCATE) == ((uint64_t)1 << 63) - 1,
+              "fixed_div_round_u64() isn't constexpr");
+static_assert(fixed_div_round_i32(-7, 2, FIXED_ROUND_HALF_UP) == -4, "fixed_div_round_i32() isn't constexpr");
+static_assert(fixed_div_round_i32(-5, 2, FIXED_ROUND_HALF_EVEN) == -2, "fixed_div_round_i32() isn't constexpr");
+static_assert(fixed_div_round_i32(-7, 2, FIXED_ROUND_TRUNCATE) == -3, "fixed_div_round_i32() isn't constexpr");
+static_assert(fixed_div_round_i32(INT32_MIN, -1, FIXED_ROUND_TRUNCATE) == INT32_MAX,
+              "fixed_div_round_i32() isn't constexpr");
+static_assert(fixed_div_round_i64(-9, 2, FIXED_ROUND_HALF_UP) == -5, "fixed_div_round_i64() isn't constexpr");
+static_assert(fixed_div_round_i64(INT64_MIN, 1, FIXED_ROUND_HALF_UP) == INT64_MIN,
+              "fixed_div_round_i64() isn't constexpr");
+static_assert(fixed_div_round_i64(INT64_MIN, -1, FIXED_ROUND_HALF_UP) == INT64_MAX,
+              "fixed_div_round_i64() isn't constexpr");
+static_assert(fixed_div_round_half_up_fast_u32(UINT32_MAX, 2) == (uint32_t)1 << 31,
+              "fixed_div_round_half_up_fast_u32() isn't constexpr");
+static_assert(fixed_div_round_half_up_fast_u64(7, 2) == 4, "fixed_div_round_half_up_fast_u64() isn't constexpr");
+
+// 10*3/7 = 4.29; 7*1/2 = 3.5, a tie; and a product that doesn't fit.
+static_assert(fixed_mul_div_round_u32(10, 3, 7, FIXED_ROUND_HALF_UP) == 4, "fixed_mul_div_round_u32() isn't constexpr");
+static_assert(fixed_mul_div_round_u32(7, 1, 2, FIXED_ROUND_HALF_UP) == 4, "fixed_mul_div_round_u32() isn't constexpr");
+static_assert(fixed_mul_div_round_u32(5, 1, 2, FIXED_ROUND_HALF_EVEN) == 2,
+              "fixed_mul_div_round_u32() isn't constexpr");
+static_assert(fixed_mul_div_round_u32(7, 1, 2, FIXED_ROUND_TRUNCATE) == 3, "fixed_mul_div_round_u32() isn't constexpr");
+static_assert(fixed_mul_div_round_u32(UINT32_MAX, UINT32_MAX, 1, FIXED_ROUND_HALF_UP) == UINT32_MAX,
+              "fixed_mul_div_round_u32() isn't constexpr");
+
+// -----------------------------------------------------------------------------------------------------------------
+// Fixed-point division, and division by a reciprocal
+// -----------------------------------------------------------------------------------------------------------------
+
+// A divisor's reciprocal, as fixed_recip_init() computes it (without its table and Newton steps).
+static constexpr fixed_recip_t make_recip(uint32_t divisor)
+{
+    fixed_recip_t recip = {divisor, divisor, 0, 0};
+    while ((recip.normalized & 0x80000000) == 0)
+    {
+        recip.normalized <<= 1;
+        recip.shift++;
+    }
+    recip.reciprocal = (uint32_t)(UINT64_MAX / recip.normalized - ((uint64_t)1 << 32));
+    return recip;
+}
+
+static constexpr fixed_point_t ONE = fixed_from_int(1);
+static constexpr fixed_point_t TWO = fixed_from_int(2);
+static constexpr fixed_point_t THREE = fixed_from_int(3);
+static constexpr fixed_recip_t RECIP_THREE = make_recip(THREE);
+static constexpr fixed_recip_t RECIP_SEVEN = make_recip(7);
+
+// 3/2 = 1.5 exactly; 1/3 = 21845.33/65536 rounds down, and 2/3 = 43690.67/65536 up.
+static_assert(fixed_div(THREE, TWO) == ONE + ONE/2, "fixed_div() isn't constexpr");
+static_assert(fixed_div(ONE, THREE) == 21845, "fixed_div() isn't constexpr");
+static_assert(fixed_div(TWO, THREE) == 43691, "fixed_div() isn't constexpr");
+static_assert(fixed_div(ONE, 0) == UINT32_MAX, "fixed_div() isn't constexpr");
+static_assert(fixed_div(fixed_from_int(MAX_WHOLE_NUM), ONE/2) == UINT32_MAX, "fixed_div() isn't constexpr");
+static_assert(fixed_div_recip(TWO, &RECIP_THREE) == fixed_div(TWO, THREE), "fixed_div_recip() isn't constexpr");
+static_assert(fixed_div_recip(ONE, &RECIP_THREE) == fixed_div(ONE, THREE), "fixed_div_recip() isn't constexpr");
+static_assert(fixed_recip_div_round(3 * 7000, &RECIP_SEVEN) == 3000, "fixed_recip_div_round() isn't constexpr");
+
+// -----------------------------------------------------------------------------------------------------------------
+// Multiply-round
+// -----------------------------------------------------------------------------------------------------------------
+
+static_assert(fixed_mul_round(THREE, ONE/2) == ONE + ONE/2, "fixed_mul_round() isn't constexpr");
+static_assert(fixed_mul_add_round(THREE, ONE/2, ONE) == TWO + ONE/2, "fixed_mul_add_round() isn't constexpr");
+// 1/2 of the last bit rounds up, from c + a*b and from c - a*b alike.
+static_assert(fixed_mul_round(1, ONE/2) == 1, "fixed_mul_round() isn't constexpr");
+static_assert(fixed_mul_sub_round(1, ONE/2, 5) == 5, "fixed_mul_sub_round() isn't constexpr");
+
+// 0.5*0.5 = 0.25; -1*-1 saturates; and half of the last bit rounds up (toward +infinity).
+static_assert(fixed_q15_mul_round(16384, 16384) == 8192, "fixed_q15_mul_round() isn't constexpr");
+static_assert(fixed_q15_mul_round(-16384, 16384) == -8192, "fixed_q15_mul_round() isn't constexpr");
+static_assert(fixed_q15_mul_round(INT16_MIN, INT16_MIN) == INT16_MAX, "fixed_q15_mul_round() isn't constexpr");
+static_assert(fixed_q15_mul_round(1, 16384) == 1, "fixed_q15_mul_round() isn't constexpr");
+static_assert(fixed_q15_mul_round(-1, 16384) == 0, "fixed_q15_mul_round() isn't constexpr");
+static_assert(fixed_q15_mul_add_round(16384, 16384, 100) == 8292, "fixed_q15_mul_add_round() isn't constexpr");
+static_assert(fixed_q15_mul_add_round(INT16_MAX, INT16_MAX, INT16_MAX) == INT16_MAX,
+              "fixed_q15_mul_add_round() isn't constexpr");
+static_assert(fixed_q15_mul_sub_round(1, 16384, 0) == 0, "fixed_q15_mul_sub_round() isn't constexpr");
+
+static_assert(fixed_q31_mul_round(1 << 30, 1 << 30) == 1 << 29, "fixed_q31_mul_round() isn't constexpr");
+static_assert(fixed_q31_mul_round(-(1 << 30), 1 << 30) == -(1 << 29), "fixed_q31_mul_round() isn't constexpr");
+static_assert(fixed_q31_mul_round(INT32_MIN, INT32_MIN) == INT32_MAX, "fixed_q31_mul_round() isn't constexpr");
+static_assert(fixed_q31_mul_round(1, 1 << 30) == 1, "fixed_q31_mul_round() isn't constexpr");
+static_assert(fixed_q31_mul_round(-1, 1 << 30) == 0, "fixed_q31_mul_round() isn't constexpr");
+static_assert(fixed_q31_mul_add_round(1 << 30, 1 << 30, 100) == (1 << 29) + 100,
+              "fixed_q31_mul_add_round() isn't constexpr");
+static_assert(fixed_q31_mul_sub_round(INT32_MIN, INT32_MAX, INT32_MAX) == INT32_MAX,
+              "fixed_q31_mul_sub_round() isn't constexpr");
+
+// -----------------------------------------------------------------------------------------------------------------
+// Time
+// -----------------------------------------------------------------------------------------------------------------
+
+// 1 ns is 4.29 units of 2^-32 s, and 1 unit is 0.23 ns.
+static_assert(fixed_time_from_ns(FIXED_TIME_NS_PER_SECOND) == FIXED_TIME_ONE_SECOND,
+              "fixed_time_from_ns() isn't constexpr");
+static_assert(fixed_time_from_ns(FIXED_TIME_NS_PER_SECOND / 2) == FIXED_TIME_ONE_SECOND / 2,
+              "fixed_time_from_ns() isn't constexpr");
+static_assert(fixed_time_from_ns(1) == 4, "fixed_time_from_ns() isn't constexpr");
+static_assert(fixed_time_from_ns(4294967296000000000ull) == FIXED_TIME_MAX, "fixed_time_from_ns() isn't constexpr");
+static_assert(fixed_time_to_ns(FIXED_TIME_ONE_SECOND) == FIXED_TIME_NS_PER_SECOND,
+              "fixed_time_to_ns() isn't constexpr");
+static_assert(fixed_time_to_ns(FIXED_TIME_ONE_SECOND / 2 + 3 * FIXED_TIME_ONE_SECOND) == 3500000000u,
+              "fixed_time_to_ns() isn't constexpr");
+static_assert(fixed_time_to_ns(1) == 0, "fixed_time_to_ns() isn't constexpr");
+static_assert(fixed_time_to_ns(fixed_time_from_ns(123456789)) == 123456789, "fixed_time_to_ns() isn't constexpr");
+static_assert(fixed_time_mul_hi_u64(UINT64_MAX, UINT64_MAX) == UINT64_MAX - 1,
+              "fixed_time_mul_hi_u64() isn't constexpr");
+
+// -----------------------------------------------------------------------------------------------------------------
+// Ratios
+// -----------------------------------------------------------------------------------------------------------------
+
+// A 32-bit plan for times/divide (already in lowest terms), as fixed_ratio_plan_init() makes it.
+static constexpr fixed_ratio_plan_t make_ratio_plan(uint32_t times, uint32_t divide)
+{
+    fixed_ratio_plan_t plan = {times, divide, 32, times, divide, FIXED_RATIO_RECIPROCAL, 0, false, 0,
+                               make_recip(divide)};
+    plan.method = times == divide ? FIXED_RATIO_IDENTITY : divide == 1 ? FIXED_RATIO_MULTIPLY
+                  : (divide & (divide - 1)) == 0 ? FIXED_RATIO_SHIFT : FIXED_RATIO_RECIPROCAL;
+    while (plan.method == FIXED_RATIO_SHIFT && (1u << plan.shift) != divide)
+    {
+        plan.shift++;
+    }
+    return plan;
+}
+
+static constexpr fixed_ratio_plan_t RATIO_ONE = make_ratio_plan(1, 1);
+static constexpr fixed_ratio_plan_t RATIO_THREE = make_ratio_plan(3, 1);
+static constexpr fixed_ratio_plan_t RATIO_THREE_QUARTERS = make_ratio_plan(3, 4);
+static constexpr fixed_ratio_plan_t RATIO_THREE_SEVENTHS = make_ratio_plan(3, 7);
+
+static_assert(fixed_ratio_apply32(&RATIO_ONE, UINT32_MAX) == UINT32_MAX, "fixed_ratio_apply32() isn't constexpr");
+static_assert(fixed_ratio_apply32(&RATIO_THREE, 5) == 15, "fixed_ratio_apply32() isn't constexpr");
+static_assert(fixed_ratio_apply32(&RATIO_THREE, UINT32_MAX / 2) == UINT32_MAX, "fixed_ratio_apply32() isn't constexpr");
+// 3.75 and 4.5 (a tie) both round up.
+static_assert(fixed_ratio_apply32(&RATIO_THREE_QUARTERS, 5) == 4, "fixed_ratio_apply32() isn't constexpr");
+static_assert(fixed_ratio_apply32(&RATIO_THREE_QUARTERS, 6) == 5, "fixed_ratio_apply32() isn't constexpr");
+// 30/7 = 4.29, and (2^32 - 1)*3/7 = 1840700269.29.
+static_assert(fixed_ratio_apply32(&RATIO_THREE_SEVENTHS, 7000) == 3000, "fixed_ratio_apply32() isn't constexpr");
+static_assert(fixed_ratio_apply32(&RATIO_THREE_SEVENTHS, 10) == 4, "fixed_ratio_apply32() isn't constexpr");
+static_assert(fixed_ratio_apply32(&RATIO_THREE_SEVENTHS, UINT32_MAX) == 1840700269u,
+              "fixed_ratio_apply32() isn't constexpr");
+
+// -----------------------------------------------------------------------------------------------------------------
+// Polynomials
+// -----------------------------------------------------------------------------------------------------------------
+
+// 1 + 2x + x^2/2 for x up to 4.0, with 8 fraction bits out: every coefficient and result here is exact.
+static constexpr double POLY_COEFFICIENTS[] = {1.0, 2.0, 0.5};
+static constexpr fixed_poly_t POLY_HORNER = fixed_poly_plan(POLY_COEFFICIENTS, 2, fixed_from_int(4), 8,
+                                                            FIXED_POLY_HORNER);
+static constexpr fixed_poly_t POLY_ESTRIN = fixed_poly_plan(POLY_COEFFICIENTS, 2, fixed_from_int(4), 8,
+                                                            FIXED_POLY_ESTRIN);
+// A degree past FIXED_POLY_MAX_DEGREE can't be planned.
+static constexpr fixed_poly_t POLY_INVALID = fixed_poly_plan(POLY_COEFFICIENTS, FIXED_POLY_MAX_DEGREE + 1,
+                                                             fixed_from_int(4), 8, FIXED_POLY_HORNER);
+
+static_assert(POLY_HORNER.valid && POLY_ESTRIN.valid && !POLY_INVALID.valid, "fixed_poly_plan() isn't constexpr");
+static_assert(fixed_poly_eval(&POLY_HORNER, 0) == 1 << 8, "fixed_poly_eval() isn't constexpr");
+static_assert(fixed_poly_eval(&POLY_HORNER, TWO) == 7 << 8, "fixed_poly_eval() isn't constexpr");
+static_assert(fixed_poly_eval(&POLY_HORNER, fixed_from_int(4)) == 17 << 8, "fixed_poly_eval() isn't constexpr");
+// 2.125 and 11.5.
+static_assert(fixed_poly_eval(&POLY_ESTRIN, ONE/2) == 544, "fixed_poly_eval() isn't constexpr");
+static_assert(fixed_poly_eval(&POLY_ESTRIN, THREE) == 2944, "fixed_poly_eval() isn't constexpr");
+static_assert(fixed_poly_eval(&POLY_INVALID, ONE) == 0, "fixed_poly_eval() isn't constexpr");
+
+// -----------------------------------------------------------------------------------------------------------------
+// Error tracking (production build)
+// -----------------------------------------------------------------------------------------------------------------
+
+static constexpr fixed_tracked_t TRACKED_THIRD = fixed_tracked_from_ratio(1, 3);
+static constexpr fixed_tracked_t TRACKED_PRICE = fixed_tracked_from_fixed(fixed_literal("219.857"));
+
+static_assert(TRACKED_THIRD == 21845 && fixed_tracked_from_ratio(1, 0) == 0,
+              "fixed_tracked_from_ratio() isn't constexpr");
+static_assert(fixed_tracked_from_ratio(UINT32_MAX, 1) == UINT32_MAX, "fixed_tracked_from_ratio() isn't constexpr");
+static_assert(fixed_tracked_value(fixed_tracked_add(TRACKED_THIRD, TRACKED_THIRD)) == 2 * 21845,
+              "fixed_tracked_add() isn't constexpr");
+static_assert(fixed_tracked_sub(TRACKED_PRICE, TRACKED_PRICE) == 0, "fixed_tracked_sub() isn't constexpr");
+// The production math truncates, like the tutorial's: 1/3*3 is 65535/65536, and times 3 is 196605/65536.
+static_assert(fixed_tracked_mul(fixed_tracked_mul_int(TRACKED_THIRD, 3), THREE) == 196605,
+              "fixed_tracked_mul() isn't constexpr");
+static_assert(fixed_tracked_div(ONE, THREE) == 21845 && fixed_tracked_div(ONE, 0) == 0,
+              "fixed_tracked_div() isn't constexpr");
+static_assert(fixed_tracked_div_int(TWO, 3) == 43690 && fixed_tracked_div_int(TWO, 0) == 0,
+              "fixed_tracked_div_int() isn't constexpr");
+static_assert(fixed_tracked_round_whole(TRACKED_PRICE) == fixed_from_int(220),
+              "fixed_tracked_round_whole() isn't constexpr");
+static_assert(fixed_tracked_certify(TRACKED_PRICE, 9), "fixed_tracked_certify() isn't constexpr");
+
+// -----------------------------------------------------------------------------------------------------------------
+// Parsing and formatting
+// -----------------------------------------------------------------------------------------------------------------
+
+static_assert(fixed_literal("1.5") == ONE + ONE/2, "fixed_parse() isn't constexpr");
+static_assert(fixed_literal("0.00001") == 1, "fixed_parse() isn't constexpr");
+static_assert(fixed_format_string(fixed_literal("219.857"), 1).length == 5, "fixed_format() isn't constexpr");
+static_assert(fixed_format_string(fixed_literal("219.857"), 1).chars[4] == '9', "fixed_format() isn't constexpr");
+static_assert(fixed_round_to_decimal(UINT32_MAX, 0) == 65536, "fixed_round_to_decimal() isn't constexpr");
+
+// The hand-made reciprocals and plans are the library's own.
+static void check_plans(void)
+{
+    const fixed_recip_t * recips[] = {&RECIP_THREE, &RECIP_SEVEN};
+    for (size_t i = 0; i < sizeof recips/sizeof recips[0]; i++)
+    {
+        fixed_recip_t recip;
+        CHECK(fixed_recip_init(&recip, recips[i]->divisor));
+        CHECK_EQ(recip.normalized, recips[i]->normalized);
+        CHECK_EQ(recip.reciprocal, recips[i]->reciprocal);
+        CHECK_EQ(recip.shift, recips[i]->shift);
+    }
+
+    const fixed_ratio_plan_t * plans[] = {&RATIO_ONE, &RATIO_THREE, &RATIO_THREE_QUARTERS, &RATIO_THREE_SEVENTHS};
+    for (size_t i = 0; i < sizeof plans/sizeof plans[0]; i++)
+    {
+        fixed_ratio_plan_t plan;
+        CHECK(fixed_ratio_plan_init(&plan, plans[i]->times, plans[i]->divide, 32));
+        CHECK_EQ(plan.reduced_times, plans[i]->reduced_times);
+        CHECK_EQ(plan.reduced_divide, plans[i]->reduced_divide);
+        CHECK_EQ(plan.method, plans[i]->method);
+        CHECK_EQ(plan.shift, plans[i]->shift);
+        CHECK_EQ(plan.split, plans[i]->split);
+        CHECK(plan.method != FIXED_RATIO_RECIPROCAL || plan.recip.reciprocal == plans[i]->recip.reciprocal);
+    }
+
+    fixed_poly_t poly;
+    CHECK(fixed_poly_init(&poly, POLY_COEFFICIENTS, 2, fixed_from_int(4), 8, FIXED_POLY_ESTRIN));
+    CHECK(memcmp(poly.coefficients, POLY_ESTRIN.coefficients, sizeof poly.coefficients) == 0);
+    CHECK(poly.error_bound == POLY_ESTRIN.error_bound);
+}
+
+int main(void)
+{
+    check_plans();
+    return test_finish("test_constexpr");
+}
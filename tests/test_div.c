@@ -0,0 +1,123 @@
+/*
+test_div
+- Checks fixed_point_div.h's reciprocal division against plain hardware division: the reciprocal itself, the exact
+  quotient and remainder for 64-bit numerators, and the rounded fixed-point and integer divisions, for edge-case and
+  pseudo-random divisors.
+- Checks the batch versions (SIMD, where available) against the scalar ones, for every length up to a few SIMD
+  widths (so every tail is covered), unaligned, and in place.
+- (test_exhaustive checks a few divisors against every dividend.)
+*/
+
+#include <string.h>
+
+#include "fixed_point_div.h"
+#include "test.h"
+
+#define NUM_DIVISORS 2000
+#define NUM_DIVIDENDS 200
+#define MAX_BATCH 67
+
+static void check_divisor(uint32_t divisor, uint64_t * state)
+{
+    fixed_recip_t recip;
+    CHECK(fixed_recip_init(&recip, divisor) == (divisor != 0));
+    CHECK_EQ(recip.divisor, divisor);
+    if (divisor != 0)
+    {
+        // The normalized divisor has its top bit set, and the reciprocal is exactly
+        // floor((2^64 - 1)/normalized) - 2^32.
+        CHECK_EQ(recip.normalized, divisor << recip.shift);
+        CHECK(recip.normalized >> 31 == 1);
+        CHECK_EQ(recip.reciprocal, (UINT64_MAX / recip.normalized) - ((uint64_t)1 << 32));
+    }
+
+    for (int i = 0; i < NUM_DIVIDENDS; i++)
+    {
+        uint64_t numerator = test_random_bits(state);
+        fixed_point_t a = (fixed_point_t)numerator;
+        if (divisor != 0)
+        {
+            uint32_t remainder = 0;
+            CHECK_EQ(fixed_recip_divmod_u64(numerator, &recip, &remainder), numerator / divisor);
+            CHECK_EQ(remainder, numerator % divisor);
+            if ((numerator >> 32) < divisor)
+            {
+                CHECK_EQ(fixed_recip_divmod(numerator, &recip, &remainder), numerator / divisor);
+                CHECK_EQ(remainder, numerator % divisor);
+            }
+        }
+
+        // Rounded half up from the remainder, saturating; and everything saturates when dividing by 0.
+        uint64_t numerator_fixed = (uint64_t)a << FRACTION_BITS;
+        uint64_t quotient = divisor == 0 ? UINT32_MAX : numerator_fixed / divisor;
+        quotient += divisor != 0 && 2 * (numerator_fixed % divisor) >= divisor;
+        CHECK_EQ(fixed_div(a, divisor), quotient > UINT32_MAX ? UINT32_MAX : quotient);
+        CHECK_EQ(fixed_div_recip(a, &recip), fixed_div(a, divisor));
+        uint64_t int_quotient = divisor == 0 ? UINT32_MAX : ((uint64_t)a + divisor/2) / divisor;
+        CHECK_EQ(fixed_div_int_recip(a, &recip), int_quotient);
+    }
+}
+
+static void check_batches(uint32_t divisor, uint64_t * state)
+{
+    // One element more than the longest batch, so batches can start unaligned.
+    fixed_point_t values[MAX_BATCH + 1];
+    fixed_point_t out[MAX_BATCH + 1];
+    fixed_point_t in_place[MAX_BATCH + 1];
+    fixed_recip_t recip;
+    fixed_recip_init(&recip, divisor);
+    for (size_t i = 0; i <= MAX_BATCH; i++)
+    {
+        values[i] = (fixed_point_t)test_random_bits(state);
+    }
+    for (size_t offset = 0; offset < 2; offset++)
+    {
+        for (size_t n = 0; n + offset <= MAX_BATCH; n++)
+        {
+            // Nothing past the end may be written.
+            memset(out, 0xA5, sizeof out);
+            fixed_div_batch(out + offset, values + offset, n, divisor);
+            for (size_t i = 0; i < n; i++)
+            {
+                CHECK_EQ(out[offset + i], fixed_div_recip(values[offset + i], &recip));
+            }
+            CHECK_EQ(out[offset + n], 0xA5A5A5A5);
+
+            memcpy(in_place, values, sizeof values);
+            fixed_div_int_batch(in_place + offset, in_place + offset, n, divisor);
+            for (size_t i = 0; i < n; i++)
+            {
+                CHECK_EQ(in_place[offset + i], fixed_div_int_recip(values[offset + i], &recip));
+            }
+        }
+    }
+}
+
+int main(void)
+{
+    static const uint32_t EDGE_DIVISORS[] = {0, 1, 2, 3, 7, 10, 0xFFFF, 0x10000, 0x10001, 0x18000, 0x30000,
+                                             0x7FFFFFFF, 0x80000000, 0x80000001, UINT32_MAX - 1, UINT32_MAX};
+    uint64_t state = 0xD1B54A32D192ED03ULL;
+    for (size_t d = 0; d < sizeof EDGE_DIVISORS/sizeof EDGE_DIVISORS[0]; d++)
+    {
+        check_divisor(EDGE_DIVISORS[d], &state);
+        check_batches(EDGE_DIVISORS[d], &state);
+    }
+    // Every power of 2, and its neighbors, are where the reciprocal's seed table and corrections are at their edges.
+    for (int shift = 0; shift < 32; shift++)
+    {
+        check_divisor((uint32_t)1 << shift, &state);
+        check_divisor(((uint32_t)1 << shift) - 1, &state);
+        check_divisor(((uint32_t)1 << shift) + 1, &state);
+    }
+    for (int i = 0; i < NUM_DIVISORS; i++)
+    {
+        uint32_t divisor = (uint32_t)test_random_bits(&state);
+        check_divisor(divisor, &state);
+        if (i % 100 == 0)
+        {
+            check_batches(divisor, &state);
+        }
+    }
+    return test_finish("test_div");
+}
@@ -0,0 +1,204 @@
+/*
+test_exhaustive
+- Checks formatting, parsing, division, and rounding for every one of the 2^32 Q16.16 numbers:
+  - fixed_parse(fixed_format(x, 5)) == x: 5 digits after the decimal always tell Q16.16 numbers apart.
+  - fixed_format_batch() and fixed_format_batch_fixed_width() (SIMD, where available) print exactly what
+    fixed_format() does.
+  - fixed_div_round_u32() in every mode, and fixed_div_round_half_up_fast_u32(), by odd and even divisors, match a
+    reference written the obvious way here (comparing twice the remainder to the divisor, in 64 bits).
+  - fixed_div(), fixed_div_recip(), and fixed_div_batch() by several fixed-point divisors, and fixed_div_int_recip()
+    and fixed_div_int_batch() by several integers, match the same reference, saturation included.
+- Takes a few minutes on one core, so the numbers are split among every CPU.
+*/
+
+// For pthreads and sysconf() when compiling with -std=c99.
+#define _POSIX_C_SOURCE 200112L
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "fixed_point_div.h"
+#include "fixed_point_format.h"
+#include "fixed_point_round.h"
+#include "test.h"
+
+#define BLOCK_SIZE 4096
+#define NUM_BLOCKS (((uint64_t)1 << 32) / BLOCK_SIZE)
+#define MAX_THREADS 64
+#define DIGITS 5
+
+static const uint32_t ROUND_DIVISORS[] = {2, 3, 10, 65535};
+// 0.75 (so results from 49152 up saturate), 1.0, 3.0, and the largest number.
+static const fixed_point_t FIXED_DIVISORS[] = {0xC000, 1 << FRACTION_BITS, 3 << FRACTION_BITS, UINT32_MAX};
+static const uint32_t INT_DIVISORS[] = {3, 10, 65537};
+
+#define NUM_ELEMENTS(array) (sizeof(array)/sizeof((array)[0]))
+
+// Everything one thread needs for one block of numbers.
+typedef struct block_s
+{
+    fixed_point_t values[BLOCK_SIZE];
+    fixed_point_t quotients[BLOCK_SIZE];
+    char text[BLOCK_SIZE*(FIXED_FORMAT_MAX_LEN - 1)];
+    size_t offsets[BLOCK_SIZE + 1];
+    char fixed_width_text[BLOCK_SIZE*FIXED_FORMAT_WIDTH(DIGITS)];
+} block_t;
+
+typedef struct worker_s
+{
+    pthread_t thread;
+    unsigned index;
+    unsigned num_workers;
+} worker_t;
+
+// a/b rounded per `mode`, the obvious way: with 2*remainder, which can't overflow in 64 bits for 32-bit divisors.
+static uint64_t reference_div_round(uint64_t a, uint32_t b, fixed_round_mode_t mode)
+{
+    uint64_t quotient = a / b;
+    uint64_t twice_remainder = 2 * (a % b);
+    switch (mode)
+    {
+        case FIXED_ROUND_HALF_UP:
+            return quotient + (twice_remainder >= b);
+        case FIXED_ROUND_HALF_EVEN:
+            return quotient + (twice_remainder > b || (twice_remainder == b && quotient % 2 == 1));
+        default:
+            return quotient;
+    }
+}
+
+static fixed_point_t saturate(uint64_t x)
+{
+    return x > UINT32_MAX ? UINT32_MAX : (fixed_point_t)x;
+}
+
+static void check_format(block_t * block)
+{
+    fixed_format_batch(block->values, BLOCK_SIZE, DIGITS, block->text, block->offsets);
+    fixed_format_batch_fixed_width(block->values, BLOCK_SIZE, DIGITS, block->fixed_width_text);
+    for (size_t i = 0; i < BLOCK_SIZE; i++)
+    {
+        char text[FIXED_FORMAT_MAX_LEN];
+        size_t length = fixed_format(block->values[i], DIGITS, text);
+        fixed_point_t parsed = 0;
+        CHECK(fixed_parse(text, length, &parsed));
+        CHECK_EQ(parsed, block->values[i]);
+
+        CHECK_EQ(block->offsets[i + 1] - block->offsets[i], length);
+        CHECK(memcmp(block->text + block->offsets[i], text, length) == 0);
+
+        const char * padded = block->fixed_width_text + i*FIXED_FORMAT_WIDTH(DIGITS);
+        size_t padding = FIXED_FORMAT_WIDTH(DIGITS) - length;
+        CHECK(strspn(padded, " ") >= padding && memcmp(padded + padding, text, length) == 0);
+    }
+}
+
+static void check_round(const block_t * block)
+{
+    for (size_t d = 0; d < NUM_ELEMENTS(ROUND_DIVISORS); d++)
+    {
+        uint32_t b = ROUND_DIVISORS[d];
+        for (size_t i = 0; i < BLOCK_SIZE; i++)
+        {
+            uint32_t a = block->values[i];
+            CHECK_EQ(fixed_div_round_u32(a, b, FIXED_ROUND_HALF_UP),
+                     reference_div_round(a, b, FIXED_ROUND_HALF_UP));
+            CHECK_EQ(fixed_div_round_u32(a, b, FIXED_ROUND_HALF_EVEN),
+                     reference_div_round(a, b, FIXED_ROUND_HALF_EVEN));
+            CHECK_EQ(fixed_div_round_u32(a, b, FIXED_ROUND_TRUNCATE), a / b);
+            CHECK_EQ(fixed_div_round_half_up_fast_u32(a, b), reference_div_round(a, b, FIXED_ROUND_HALF_UP));
+        }
+    }
+}
+
+static void check_div(block_t * block)
+{
+    for (size_t d = 0; d < NUM_ELEMENTS(FIXED_DIVISORS); d++)
+    {
+        fixed_point_t b = FIXED_DIVISORS[d];
+        fixed_recip_t recip;
+        fixed_recip_init(&recip, b);
+        fixed_div_batch(block->quotients, block->values, BLOCK_SIZE, b);
+        for (size_t i = 0; i < BLOCK_SIZE; i++)
+        {
+            fixed_point_t a = block->values[i];
+            fixed_point_t expected = saturate(reference_div_round((uint64_t)a << FRACTION_BITS, b,
+                                                                  FIXED_ROUND_HALF_UP));
+            CHECK_EQ(fixed_div(a, b), expected);
+            CHECK_EQ(fixed_div_recip(a, &recip), expected);
+            CHECK_EQ(block->quotients[i], expected);
+        }
+    }
+    for (size_t d = 0; d < NUM_ELEMENTS(INT_DIVISORS); d++)
+    {
+        uint32_t divide = INT_DIVISORS[d];
+        fixed_recip_t recip;
+        fixed_recip_init(&recip, divide);
+        fixed_div_int_batch(block->quotients, block->values, BLOCK_SIZE, divide);
+        for (size_t i = 0; i < BLOCK_SIZE; i++)
+        {
+            fixed_point_t a = block->values[i];
+            fixed_point_t expected = (fixed_point_t)reference_div_round(a, divide, FIXED_ROUND_HALF_UP);
+            CHECK_EQ(fixed_div_int_recip(a, &recip), expected);
+            CHECK_EQ(block->quotients[i], expected);
+        }
+    }
+}
+
+// Check every `num_workers`th block, starting from block `index`.
+static void * run_worker(void * arg)
+{
+    const worker_t * worker = (const worker_t *)arg;
+    block_t * block = (block_t *)malloc(sizeof(block_t));
+    if (block == NULL)
+    {
+        test_fail(__FILE__, __LINE__, "malloc(sizeof(block_t))");
+        return NULL;
+    }
+    for (uint64_t b = worker->index; b < NUM_BLOCKS; b += worker->num_workers)
+    {
+        for (size_t i = 0; i < BLOCK_SIZE; i++)
+        {
+            block->values[i] = (fixed_point_t)(b*BLOCK_SIZE + i);
+        }
+        check_format(block);
+        check_round(block);
+        check_div(block);
+    }
+    free(block);
+    return NULL;
+}
+
+int main(void)
+{
+    long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned num_workers = num_cpus < 1 ? 1 : num_cpus > MAX_THREADS ? MAX_THREADS : (unsigned)num_cpus;
+    static worker_t workers[MAX_THREADS];
+    static bool started[MAX_THREADS];
+    printf("test_exhaustive: checking all 2^32 numbers on %u thread(s)\n", num_workers);
+    for (unsigned w = 0; w < num_workers; w++)
+    {
+        workers[w].index = w;
+        workers[w].num_workers = num_workers;
+        // Worker 0 runs on this thread, once the others have started.
+        started[w] = w > 0 && pthread_create(&workers[w].thread, NULL, run_worker, &workers[w]) == 0;
+    }
+    for (unsigned w = 0; w < num_workers; w++)
+    {
+        // (Including any worker whose thread couldn't be started.)
+        if (!started[w])
+        {
+            run_worker(&workers[w]);
+        }
+    }
+    for (unsigned w = 0; w < num_workers; w++)
+    {
+        if (started[w])
+        {
+            pthread_join(workers[w].thread, NULL);
+        }
+    }
+    return test_finish("test_exhaustive");
+}
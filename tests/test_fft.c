@@ -0,0 +1,264 @@
+/*
+test_fft
+- Checks fixed_point_fft.h's Q15 and Q31 transforms, both directions, for every size up to 2^10, against a plain
+  O(n^2) DFT in double precision (with libm's sin() and cos(), not the library's integer twiddle factors): `data *
+  2^shift` must be within about sqrt(size) output steps of the exact result, for full-scale noise, small numbers
+  (which must not be scaled down at all), and pure tones.
+- Checks that a forward and an inverse transform of up to 2^20 numbers give back the input times the size.
+- Then every output and shift above (but the tones') is hashed into one checksum, which must equal GOLDEN_CHECKSUM
+  with or without SIMD and on every platform: the transforms are integer-only, so they must be bit-identical.
+*/
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fixed_point_fft.h"
+#include "test.h"
+
+// The FNV-1a hash of every result below, in order. It only changes if the inputs or functions checked change.
+#define GOLDEN_CHECKSUM 0xFF234441634B8204ULL
+
+#define MAX_LOG2_DFT 10
+#define MAX_DFT (1 << MAX_LOG2_DFT)
+#define PI 3.14159265358979323846
+
+static uint64_t checksum = 0xCBF29CE484222325ULL; // the FNV-1a offset basis
+
+// Hash all 8 bytes of `x`, least-significant first (so the checksum doesn't depend on the platform's byte order).
+static void hash(uint64_t x)
+{
+    for (int i = 0; i < 8; i++)
+    {
+        checksum ^= (x >> (8*i)) & 0xFF;
+        checksum *= 0x100000001B3ULL; // the FNV-1a prime
+    }
+}
+
+typedef struct complex_s
+{
+    double re;
+    double im;
+} complex_t;
+
+// X[k] = sum of x[n] * e^(-+2*pi*i*k*n/size).
+static void reference_dft(const complex_t * x, complex_t * out, size_t size, bool inverse)
+{
+    static complex_t roots[MAX_DFT];
+    for (size_t k = 0; k < size; k++)
+    {
+        roots[k].re = cos(2*PI*(double)k/(double)size);
+        roots[k].im = (inverse ? 1 : -1) * sin(2*PI*(double)k/(double)size);
+    }
+    for (size_t k = 0; k < size; k++)
+    {
+        complex_t sum = {0, 0};
+        for (size_t n = 0; n < size; n++)
+        {
+            complex_t w = roots[(k*n) % size];
+            sum.re += x[n].re*w.re - x[n].im*w.im;
+            sum.im += x[n].re*w.im + x[n].im*w.re;
+        }
+        out[k] = sum;
+    }
+}
+
+// The biggest difference between `data * 2^shift` and the exact result, in output steps (units of 2^shift).
+static double max_error(const complex_t * exact, const int64_t * re, const int64_t * im, size_t size, unsigned shift)
+{
+    double error = 0;
+    for (size_t k = 0; k < size; k++)
+    {
+        double d_re = fabs(ldexp((double)re[k], (int)shift) - exact[k].re);
+        double d_im = fabs(ldexp((double)im[k], (int)shift) - exact[k].im);
+        error = d_re > error ? d_re : error;
+        error = d_im > error ? d_im : error;
+    }
+    return ldexp(error, -(int)shift);
+}
+
+// Input number `n` of signal `kind`: full-scale noise, small noise, or a pure tone at a pseudo-random bin.
+static void signal(complex_t * x, size_t size, int kind, double full_scale, uint64_t * state)
+{
+    size_t bin = (size_t)(test_random(state) % size);
+    for (size_t n = 0; n < size; n++)
+    {
+        switch (kind)
+        {
+            case 0:
+                x[n].re = (double)(int64_t)(test_random(state) % (uint64_t)(2*full_scale + 1)) - full_scale;
+                x[n].im = (double)(int64_t)(test_random(state) % (uint64_t)(2*full_scale + 1)) - full_scale;
+                break;
+            case 1:
+                x[n].re = (double)(int64_t)(test_random(state) % 5) - 2;
+                x[n].im = (double)(int64_t)(test_random(state) % 5) - 2;
+                break;
+            default:
+                x[n].re = floor(full_scale/2 * cos(2*PI*(double)(bin*n % size)/(double)size) + 0.5);
+                x[n].im = floor(full_scale/2 * sin(2*PI*(double)(bin*n % size)/(double)size) + 0.5);
+                break;
+        }
+    }
+}
+
+static void check_dft(unsigned log2_size, unsigned sample_bits, fixed_arena_t * arena, uint64_t * state)
+{
+    static complex_t x[MAX_DFT];
+    static complex_t exact[MAX_DFT];
+    static fixed_complex_q15_t data15[MAX_DFT];
+    static fixed_complex_q31_t data31[MAX_DFT];
+    static int64_t re[MAX_DFT];
+    static int64_t im[MAX_DFT];
+    const size_t size = (size_t)1 << log2_size;
+    const double full_scale = sample_bits == 16 ? INT16_MAX : INT32_MAX;
+    fixed_fft_t fft;
+    CHECK(fixed_fft_init(&fft, size, sample_bits, arena));
+    if (test_failure_count() != 0)
+    {
+        return;
+    }
+    for (int kind = 0; kind < 3; kind++)
+    {
+        for (int inverse = 0; inverse <= 1; inverse++)
+        {
+            signal(x, size, kind, full_scale, state);
+            reference_dft(x, exact, size, inverse);
+            unsigned shift = 99;
+            for (size_t n = 0; n < size; n++)
+            {
+                data15[n].re = (fixed_q15_t)x[n].re;
+                data15[n].im = (fixed_q15_t)x[n].im;
+                data31[n].re = (fixed_q31_t)x[n].re;
+                data31[n].im = (fixed_q31_t)x[n].im;
+            }
+            CHECK(sample_bits == 16 ? fixed_fft_q15(&fft, data15, inverse, &shift)
+                                    : fixed_fft_q31(&fft, data31, inverse, &shift));
+            for (size_t k = 0; k < size; k++)
+            {
+                re[k] = sample_bits == 16 ? data15[k].re : data31[k].re;
+                im[k] = sample_bits == 16 ? data15[k].im : data31[k].im;
+            }
+            // (Not the tones: their inputs come from libm, which needn't round the same everywhere.)
+            for (size_t k = 0; k < size && kind != 2; k++)
+            {
+                hash((uint64_t)re[k]);
+                hash((uint64_t)im[k]);
+            }
+            hash(shift);
+            // Every pass rounds, and the errors add up like a random walk: about sqrt(size) output steps at most.
+            CHECK(max_error(exact, re, im, size, shift) <= 1 + sqrt((double)size));
+            if (kind == 1)
+            {
+                // Small enough that no pass needs scaling down.
+                CHECK_EQ(shift, 0);
+            }
+            // A shift is at most 2 bits per pass, for at most log2_size passes.
+            CHECK(shift <= 2*log2_size);
+        }
+    }
+    // The other width's transform leaves the data alone.
+    memset(data15, 0x5A, sizeof data15[0]);
+    memset(data31, 0x5A, sizeof data31[0]);
+    unsigned shift = 0;
+    CHECK(sample_bits == 16 ? !fixed_fft_q31(&fft, data31, false, &shift)
+                            : !fixed_fft_q15(&fft, data15, false, &shift));
+    CHECK(data15[0].re == 0x5A5A && data31[0].re == 0x5A5A5A5A);
+    if (arena == NULL)
+    {
+        fixed_fft_free(&fft);
+    }
+}
+
+// Forward then inverse: `data * 2^(both shifts)` must be the input times the size, give or take the rounding.
+static void check_round_trip(unsigned log2_size, unsigned sample_bits, uint64_t * state)
+{
+    const size_t size = (size_t)1 << log2_size;
+    fixed_fft_t fft;
+    CHECK(fixed_fft_init(&fft, size, sample_bits, NULL));
+    int32_t * x = (int32_t *)malloc(2 * size * sizeof(int32_t));
+    void * data = malloc(2 * size * sizeof(int32_t));
+    if (test_failure_count() != 0 || x == NULL || data == NULL)
+    {
+        test_fail(__FILE__, __LINE__, "fixed_fft_init() or malloc()");
+        free(x);
+        free(data);
+        return;
+    }
+    fixed_complex_q15_t * data15 = (fixed_complex_q15_t *)data;
+    fixed_complex_q31_t * data31 = (fixed_complex_q31_t *)data;
+    for (size_t n = 0; n < size; n++)
+    {
+        x[2*n] = sample_bits == 16 ? (int16_t)test_random(state) : (int32_t)test_random(state);
+        x[2*n + 1] = sample_bits == 16 ? (int16_t)test_random(state) : (int32_t)test_random(state);
+        if (sample_bits == 16)
+        {
+            data15[n].re = (fixed_q15_t)x[2*n];
+            data15[n].im = (fixed_q15_t)x[2*n + 1];
+        }
+        else
+        {
+            data31[n].re = x[2*n];
+            data31[n].im = x[2*n + 1];
+        }
+    }
+    unsigned forward_shift = 0;
+    unsigned inverse_shift = 0;
+    CHECK(sample_bits == 16 ? fixed_fft_q15(&fft, data15, false, &forward_shift)
+                            : fixed_fft_q31(&fft, data31, false, &forward_shift));
+    CHECK(sample_bits == 16 ? fixed_fft_q15(&fft, data15, true, &inverse_shift)
+                            : fixed_fft_q31(&fft, data31, true, &inverse_shift));
+    int shift = (int)(forward_shift + inverse_shift) - (int)log2_size;
+    double error = 0;
+    for (size_t n = 0; n < size; n++)
+    {
+        double re = sample_bits == 16 ? data15[n].re : data31[n].re;
+        double im = sample_bits == 16 ? data15[n].im : data31[n].im;
+        double d_re = fabs(ldexp(re, shift) - x[2*n]);
+        double d_im = fabs(ldexp(im, shift) - x[2*n + 1]);
+        error = d_re > error ? d_re : error;
+        error = d_im > error ? d_im : error;
+        hash((uint64_t)(int64_t)re);
+        hash((uint64_t)(int64_t)im);
+    }
+    hash(forward_shift);
+    hash(inverse_shift);
+    // In output steps (2^shift): the errors of 2 transforms, each like check_dft()'s.
+    CHECK(ldexp(error, -shift) <= 3 * sqrt((double)size));
+    fixed_fft_free(&fft);
+    free(x);
+    free(data);
+}
+
+int main(void)
+{
+    uint64_t state = 0xBB67AE8584CAA73BULL;
+    fixed_arena_t arena;
+    CHECK(fixed_arena_init(&arena, 1 << 20));
+    for (unsigned log2_size = 0; log2_size <= MAX_LOG2_DFT; log2_size++)
+    {
+        check_dft(log2_size, 16, log2_size % 2 == 0 ? NULL : &arena, &state);
+        check_dft(log2_size, 32, log2_size % 2 == 0 ? NULL : &arena, &state);
+        fixed_arena_reset(&arena);
+    }
+    fixed_arena_free(&arena);
+    for (unsigned log2_size = 11; log2_size <= FIXED_FFT_MAX_LOG2_SIZE; log2_size += 3)
+    {
+        check_round_trip(log2_size, 16, &state);
+        check_round_trip(log2_size, 32, &state);
+    }
+
+    // Bad arguments.
+    fixed_fft_t fft;
+    CHECK(!fixed_fft_init(&fft, 0, 16, NULL));
+    CHECK(!fixed_fft_init(&fft, 3, 16, NULL));
+    CHECK(!fixed_fft_init(&fft, (size_t)2 << FIXED_FFT_MAX_LOG2_SIZE, 32, NULL));
+    CHECK(!fixed_fft_init(&fft, 64, 8, NULL));
+
+    if (checksum != GOLDEN_CHECKSUM)
+    {
+        fprintf(stderr, "test_fft: checksum %016llx, expected %016llx: the transforms aren't bit-identical\n",
+                (unsigned long long)checksum, (unsigned long long)GOLDEN_CHECKSUM);
+        test_fail(__FILE__, __LINE__, "checksum == GOLDEN_CHECKSUM");
+    }
+    return test_finish("test_fft");
+}
@@ -0,0 +1,118 @@
+/*
+test_interval
+- Checks that fixed_point_interval.h's intervals always contain the exact answer (with exact integer math, so no
+  floating point), and that the tracked values compute what production computes.
+- CMakeLists.txt also builds this as `test_interval_tracked`, with FIXED_POINT_TRACK_ERROR defined: the values must
+  be identical in both builds, and only the analysis build certifies anything.
+*/
+
+#include "fixed_point_interval.h"
+#include "test.h"
+
+#define NUM_RANDOM 100000
+
+// Check that `a` contains numerator/denominator (a rational number, in units of 1/FRACTION_DIVISOR), exactly.
+static void check_contains(fixed_interval_t a, uint64_t numerator, uint64_t denominator)
+{
+    // lo <= numerator/denominator <= hi, multiplied through by the denominator. Every product fits in 64 bits here.
+    CHECK((uint64_t)a.lo * denominator <= numerator);
+    CHECK(numerator <= (uint64_t)a.hi * denominator);
+}
+
+static void check_intervals(void)
+{
+    // 1/3 can't be represented exactly, so it's bracketed by the 2 nearest numbers.
+    fixed_interval_t third = fixed_interval_from_ratio(1, 3);
+    CHECK_EQ(third.lo, 21845);
+    CHECK_EQ(third.hi, 21846);
+    CHECK(!third.overflow);
+    CHECK_EQ(fixed_interval_certain_digits(third, 9), 4);
+    CHECK_EQ(fixed_interval_certain_digits(fixed_interval_exact(3 << FRACTION_BITS), 9), 9);
+
+    // Overflow is sticky, and an overflowed interval is never certified.
+    CHECK(fixed_interval_from_ratio(1, 0).overflow);
+    CHECK(fixed_interval_from_ratio(UINT32_MAX, 1).overflow);
+    CHECK(fixed_interval_sub(fixed_interval_exact(1), fixed_interval_exact(2)).overflow);
+    CHECK(fixed_interval_div(fixed_interval_exact(1), fixed_interval_exact(0)).overflow);
+    CHECK(fixed_interval_div_int(fixed_interval_exact(1), 0).overflow);
+    fixed_interval_t overflowed = fixed_interval_add(fixed_interval_exact(UINT32_MAX), fixed_interval_exact(1));
+    CHECK(overflowed.overflow);
+    CHECK(fixed_interval_sub(overflowed, fixed_interval_exact(1)).overflow);
+    CHECK_EQ(fixed_interval_certain_digits(overflowed, 9), 0);
+
+    uint64_t state = 0x0123456789ABCDEFULL;
+    for (int i = 0; i < NUM_RANDOM; i++)
+    {
+        // Values and ratios up to 256.0, and divisors of at least 1/256, so nothing overflows.
+        fixed_point_t a = (fixed_point_t)(test_random(&state) % ((uint64_t)256 << FRACTION_BITS));
+        fixed_point_t b = (fixed_point_t)(test_random(&state) % ((uint64_t)256 << FRACTION_BITS)) + 256;
+        uint32_t d = (uint32_t)(test_random(&state) % 1000000) + 1;
+        uint32_t n = (uint32_t)(test_random(&state) % ((uint64_t)256 * d));
+        fixed_interval_t exact_a = fixed_interval_exact(a);
+        fixed_interval_t exact_b = fixed_interval_exact(b);
+
+        fixed_interval_t ratio = fixed_interval_from_ratio(n, d);
+        check_contains(ratio, (uint64_t)n << FRACTION_BITS, d);
+        CHECK(ratio.hi - ratio.lo <= 1);
+        check_contains(fixed_interval_add(exact_a, exact_b), (uint64_t)a + b, 1);
+        check_contains(fixed_interval_mul(exact_a, exact_b), (uint64_t)a * b, FRACTION_DIVISOR);
+        check_contains(fixed_interval_mul_int(exact_a, 7), (uint64_t)a * 7, 1);
+        check_contains(fixed_interval_div(exact_a, exact_b), (uint64_t)a << FRACTION_BITS, b);
+        check_contains(fixed_interval_div_int(exact_a, d), a, d);
+
+        // An interval that is already wide only gets wider.
+        fixed_interval_t product = fixed_interval_mul(ratio, exact_b);
+        CHECK(!product.overflow);
+        CHECK(product.lo <= ((uint64_t)ratio.lo * b) >> FRACTION_BITS);
+        CHECK((uint64_t)product.hi * FRACTION_DIVISOR >= (uint64_t)ratio.hi * b);
+    }
+}
+
+// The tutorial's price pipeline, written once: (219.857 * 3) / 7.
+static fixed_tracked_t price_pipeline(void)
+{
+    fixed_tracked_t price = fixed_tracked_from_ratio(219857, 1000);
+    price = fixed_tracked_mul(price, fixed_tracked_from_fixed(3 << FRACTION_BITS));
+    return fixed_tracked_div_int(price, 7);
+}
+
+static void check_tracked(void)
+{
+    // The same values production computes, with the same truncating math, in both builds.
+    fixed_point_t price = (fixed_point_t)(((uint64_t)219857 << FRACTION_BITS) / 1000);
+    price = (fixed_point_t)(((uint64_t)price * (3 << FRACTION_BITS)) >> FRACTION_BITS) / 7;
+    fixed_tracked_t tracked = price_pipeline();
+    CHECK_EQ(fixed_tracked_value(tracked), price);
+    CHECK_EQ(fixed_tracked_value(fixed_tracked_round_whole(tracked)),
+             (price + FRACTION_DIVISOR/2) & ~(fixed_point_t)FRACTION_MASK);
+    CHECK_EQ(fixed_tracked_value(fixed_tracked_div(tracked, fixed_tracked_from_fixed(0))), 0);
+    CHECK_EQ(fixed_tracked_value(fixed_tracked_div_int(tracked, 0)), 0);
+    // Out-of-range ratios: 0 for a zero denominator, and clamped past the largest number.
+    CHECK_EQ(fixed_tracked_value(fixed_tracked_from_ratio(5, 0)), 0);
+    CHECK_EQ(fixed_tracked_value(fixed_tracked_from_ratio(UINT32_MAX, 1)), UINT32_MAX);
+    CHECK_EQ(fixed_tracked_value(fixed_tracked_from_ratio(1, 3)), 21845);
+
+#ifdef FIXED_POINT_TRACK_ERROR
+    // 94.22443 (3*219.857/7 = 94.224428...): the error so far is far below 0.005, but not below 0.0000005.
+    CHECK(fixed_tracked_certify(tracked, 2));
+    CHECK(!fixed_tracked_certify(tracked, 6));
+    CHECK(tracked.bounds.lo <= tracked.value && tracked.value <= tracked.bounds.hi);
+    // 3*219857 / (7*1000), exactly.
+    check_contains(tracked.bounds, (uint64_t)3*219857 << FRACTION_BITS, 7*1000);
+    CHECK(!fixed_tracked_certify(fixed_tracked_from_ratio(5, 0), 0));
+#else
+    // Production trusts the analysis build.
+    CHECK(fixed_tracked_certify(tracked, 9));
+#endif
+}
+
+int main(void)
+{
+    check_intervals();
+    check_tracked();
+#ifdef FIXED_POINT_TRACK_ERROR
+    return test_finish("test_interval (FIXED_POINT_TRACK_ERROR)");
+#else
+    return test_finish("test_interval");
+#endif
+}
@@ -0,0 +1,192 @@
+/*
+test_mul
+- Checks fixed_point_mul.h's fused multiply-round operations, in all 3 formats, against reference versions that compute
+  the exact product and round it with plain integer division (rounding `c - a*b` as `c + (1/2 - a*b)`, rather than
+  the library's half-down trick), for edge cases (ties, -1 * -1, saturation, wrap-around) and pseudo-random inputs.
+- Checks every batch version (SIMD, where available) against the scalar one, for every length up to a few SIMD widths,
+  unaligned, and in place.
+*/
+
+#include <string.h>
+
+#include "fixed_point_mul.h"
+#include "test.h"
+
+#define NUM_RANDOM 300000
+#define MAX_BATCH 70
+
+// floor(x / 2^shift), for negative x too, without right-shifting a negative number.
+static int64_t floor_div_pow2(int64_t x, int shift)
+{
+    int64_t divisor = (int64_t)1 << shift;
+    return x >= 0 ? x / divisor : -((-x + divisor - 1) / divisor);
+}
+
+static int64_t saturate(int64_t x, int64_t lo, int64_t hi)
+{
+    return x < lo ? lo : x > hi ? hi : x;
+}
+
+// Q16.16: the product has 2*FRACTION_BITS of fraction. Results keep their low 32 bits.
+static fixed_point_t reference_mul(fixed_point_t a, fixed_point_t b, fixed_point_t c, int sign)
+{
+    uint64_t product = (uint64_t)a * b;
+    uint64_t quotient = product >> FRACTION_BITS;
+    uint64_t remainder = product & FRACTION_MASK;
+    if (sign >= 0)
+    {
+        // c + a*b rounded half up: bump for a remainder of at least a half.
+        return (fixed_point_t)(c + quotient + (remainder >= FRACTION_DIVISOR/2));
+    }
+    // c - a*b rounded half up is c minus a*b rounded half *down*: bump only for more than a half.
+    return (fixed_point_t)(c - (quotient + (remainder > FRACTION_DIVISOR/2)));
+}
+
+// Q15 and Q31: c + sign*a*b, rounded half up (floor(x + 1/2)) once, then saturated.
+static int64_t reference_signed(int64_t a, int64_t b, int64_t c, int sign, int fraction_bits, int64_t lo, int64_t hi)
+{
+    int64_t half = (int64_t)1 << (fraction_bits - 1);
+    int64_t product = a * b;
+    return saturate(c + floor_div_pow2(half + sign * product, fraction_bits), lo, hi);
+}
+
+static void check_scalar(fixed_point_t a, fixed_point_t b, fixed_point_t c)
+{
+    CHECK_EQ(fixed_mul_round(a, b), reference_mul(a, b, 0, 1));
+    CHECK_EQ(fixed_mul_add_round(a, b, c), reference_mul(a, b, c, 1));
+    CHECK_EQ(fixed_mul_sub_round(a, b, c), reference_mul(a, b, c, -1));
+
+    fixed_q15_t a15 = (fixed_q15_t)a;
+    fixed_q15_t b15 = (fixed_q15_t)b;
+    fixed_q15_t c15 = (fixed_q15_t)c;
+    CHECK_EQ(fixed_q15_mul_round(a15, b15), reference_signed(a15, b15, 0, 1, 15, INT16_MIN, INT16_MAX));
+    CHECK_EQ(fixed_q15_mul_add_round(a15, b15, c15), reference_signed(a15, b15, c15, 1, 15, INT16_MIN, INT16_MAX));
+    CHECK_EQ(fixed_q15_mul_sub_round(a15, b15, c15), reference_signed(a15, b15, c15, -1, 15, INT16_MIN, INT16_MAX));
+
+    fixed_q31_t a31 = (fixed_q31_t)a;
+    fixed_q31_t b31 = (fixed_q31_t)b;
+    fixed_q31_t c31 = (fixed_q31_t)c;
+    CHECK_EQ(fixed_q31_mul_round(a31, b31), reference_signed(a31, b31, 0, 1, 31, INT32_MIN, INT32_MAX));
+    CHECK_EQ(fixed_q31_mul_add_round(a31, b31, c31), reference_signed(a31, b31, c31, 1, 31, INT32_MIN, INT32_MAX));
+    CHECK_EQ(fixed_q31_mul_sub_round(a31, b31, c31), reference_signed(a31, b31, c31, -1, 31, INT32_MIN, INT32_MAX));
+}
+
+static void check_batches(uint64_t * state)
+{
+    // One element more than the longest batch, so batches can start unaligned.
+    static fixed_point_t a[MAX_BATCH + 1], b[MAX_BATCH + 1], c[MAX_BATCH + 1], out[MAX_BATCH + 1];
+    static fixed_q15_t a15[MAX_BATCH + 1], b15[MAX_BATCH + 1], c15[MAX_BATCH + 1], out15[MAX_BATCH + 1];
+    static fixed_q31_t a31[MAX_BATCH + 1], b31[MAX_BATCH + 1], c31[MAX_BATCH + 1], out31[MAX_BATCH + 1];
+    for (size_t i = 0; i <= MAX_BATCH; i++)
+    {
+        a[i] = (fixed_point_t)test_random_bits(state);
+        b[i] = (fixed_point_t)test_random_bits(state);
+        c[i] = (fixed_point_t)test_random(state);
+        a15[i] = (fixed_q15_t)test_random(state);
+        b15[i] = (fixed_q15_t)test_random(state);
+        c15[i] = (fixed_q15_t)test_random(state);
+        a31[i] = (fixed_q31_t)test_random(state);
+        b31[i] = (fixed_q31_t)test_random(state);
+        c31[i] = (fixed_q31_t)test_random(state);
+    }
+    // (Include the -1 * -1 that saturates.)
+    a15[3] = b15[3] = INT16_MIN;
+    a31[5] = b31[5] = INT32_MIN;
+
+    for (size_t offset = 0; offset < 2; offset++)
+    {
+        for (size_t n = 0; n + offset <= MAX_BATCH; n++)
+        {
+            const size_t o = offset;
+            fixed_mul_round_batch(out + o, a + o, b + o, n);
+            for (size_t i = o; i < o + n; i++)
+            {
+                CHECK_EQ(out[i], fixed_mul_round(a[i], b[i]));
+            }
+            fixed_mul_add_round_batch(out + o, a + o, b + o, c + o, n);
+            for (size_t i = o; i < o + n; i++)
+            {
+                CHECK_EQ(out[i], fixed_mul_add_round(a[i], b[i], c[i]));
+            }
+            // In place: out is c, as in `acc[i] -= x[i]*h[i]`.
+            memcpy(out, c, sizeof out);
+            fixed_mul_sub_round_batch(out + o, a + o, b + o, out + o, n);
+            for (size_t i = o; i < o + n; i++)
+            {
+                CHECK_EQ(out[i], fixed_mul_sub_round(a[i], b[i], c[i]));
+            }
+
+            fixed_q15_mul_round_batch(out15 + o, a15 + o, b15 + o, n);
+            for (size_t i = o; i < o + n; i++)
+            {
+                CHECK_EQ(out15[i], fixed_q15_mul_round(a15[i], b15[i]));
+            }
+            fixed_q15_mul_add_round_batch(out15 + o, a15 + o, b15 + o, c15 + o, n);
+            for (size_t i = o; i < o + n; i++)
+            {
+                CHECK_EQ(out15[i], fixed_q15_mul_add_round(a15[i], b15[i], c15[i]));
+            }
+            memcpy(out15, c15, sizeof out15);
+            fixed_q15_mul_sub_round_batch(out15 + o, a15 + o, b15 + o, out15 + o, n);
+            for (size_t i = o; i < o + n; i++)
+            {
+                CHECK_EQ(out15[i], fixed_q15_mul_sub_round(a15[i], b15[i], c15[i]));
+            }
+
+            fixed_q31_mul_round_batch(out31 + o, a31 + o, b31 + o, n);
+            for (size_t i = o; i < o + n; i++)
+            {
+                CHECK_EQ(out31[i], fixed_q31_mul_round(a31[i], b31[i]));
+            }
+            fixed_q31_mul_add_round_batch(out31 + o, a31 + o, b31 + o, c31 + o, n);
+            for (size_t i = o; i < o + n; i++)
+            {
+                CHECK_EQ(out31[i], fixed_q31_mul_add_round(a31[i], b31[i], c31[i]));
+            }
+            memcpy(out31, c31, sizeof out31);
+            fixed_q31_mul_sub_round_batch(out31 + o, a31 + o, b31 + o, out31 + o, n);
+            for (size_t i = o; i < o + n; i++)
+            {
+                CHECK_EQ(out31[i], fixed_q31_mul_sub_round(a31[i], b31[i], c31[i]));
+            }
+        }
+    }
+}
+
+int main(void)
+{
+    // Exact ties: 0.5 * 1/65536 rounds up for +, and (being c - a tie) also up, ie: toward c, for -.
+    CHECK_EQ(fixed_mul_round(1 << (FRACTION_BITS - 1), 1), 1);
+    CHECK_EQ(fixed_mul_sub_round(1 << (FRACTION_BITS - 1), 1, 10), 10);
+    CHECK_EQ(fixed_q15_mul_round(INT16_MIN, INT16_MIN), INT16_MAX);
+    CHECK_EQ(fixed_q15_mul_round(INT16_MIN, INT16_MAX), -INT16_MAX);
+    CHECK_EQ(fixed_q15_mul_add_round(INT16_MAX, INT16_MAX, INT16_MAX), INT16_MAX);
+    CHECK_EQ(fixed_q15_mul_sub_round(INT16_MAX, INT16_MAX, INT16_MIN), INT16_MIN);
+    CHECK_EQ(fixed_q31_mul_round(INT32_MIN, INT32_MIN), INT32_MAX);
+    CHECK_EQ(fixed_q31_mul_sub_round(INT32_MIN, INT32_MAX, INT32_MAX), INT32_MAX);
+
+    static const uint32_t EDGE[] = {0, 1, 0x4000, 0x7FFF, 0x8000, 0x8001, 0xFFFF, 0x10000, 0x10001, 0x7FFFFFFF,
+                                    0x80000000, 0x80000001, 0xFFFF8000, UINT32_MAX};
+    for (size_t i = 0; i < sizeof EDGE/sizeof EDGE[0]; i++)
+    {
+        for (size_t j = 0; j < sizeof EDGE/sizeof EDGE[0]; j++)
+        {
+            for (size_t k = 0; k < sizeof EDGE/sizeof EDGE[0]; k++)
+            {
+                check_scalar(EDGE[i], EDGE[j], EDGE[k]);
+            }
+        }
+    }
+    uint64_t state = 0xA0761D6478BD642FULL;
+    for (int i = 0; i < NUM_RANDOM; i++)
+    {
+        fixed_point_t a = (fixed_point_t)test_random_bits(&state);
+        fixed_point_t b = (fixed_point_t)test_random_bits(&state);
+        check_scalar(a, b, (fixed_point_t)test_random(&state));
+    }
+    for (int i = 0; i < 20; i++)
+    {
+        check_batches(&state);
+    }
+    return test_finish("test_mul");
+}
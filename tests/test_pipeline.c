@@ -0,0 +1,365 @@
+/*
+test_pipeline
+- Checks fixed_point_pipeline.h's output against converting the whole input in one call, for records ending in a
+  delimiter and for fixed-size records (with a partial last record, too), from files and from pipes written in
+  pieces of random sizes, with random chunk sizes, queue depths, and numbers of workers.
+- Checks that records a pipe sends before going quiet are converted and written without waiting for a whole chunk
+  or the end of the input; that a record longer than a chunk fails with EINVAL; and that a failing `convert` stops
+  the run with ECANCELED even while the reader is waiting on a quiet pipe.
+*/
+
+// For pipe(), poll(), fileno(), and nanosleep() when compiling with -std=c99.
+#define _POSIX_C_SOURCE 200112L
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "fixed_point_pipeline.h"
+#include "test.h"
+
+#define NUM_RUNS 60
+#define MAX_INPUT_SIZE 200000
+#define MAX_RECORD_SIZE 40
+// How long to wait for a pipeline that should be done by now, before calling it stuck.
+#define TIMEOUT_MS 10000
+
+typedef struct format_s
+{
+    size_t record_size;
+    int delimiter;
+} format_t;
+
+// Reverse each record's bytes (but a delimiter stays at its record's end). A partial last record is reversed too.
+static size_t reverse_records(void * context, const uint8_t * in, size_t in_size, uint8_t * out, size_t out_capacity)
+{
+    const format_t * format = (const format_t *)context;
+    if (in_size > out_capacity)
+    {
+        return SIZE_MAX;
+    }
+    for (size_t start = 0; start < in_size;)
+    {
+        size_t end = start;
+        size_t length;
+        if (format->delimiter >= 0)
+        {
+            while (end < in_size && in[end] != (uint8_t)format->delimiter)
+            {
+                end++;
+            }
+            length = end - start;
+            end += end < in_size;
+        }
+        else
+        {
+            end = in_size - start < format->record_size ? in_size : start + format->record_size;
+            length = end - start;
+        }
+        for (size_t i = 0; i < length; i++)
+        {
+            out[start + i] = in[start + length - 1 - i];
+        }
+        if (end - start > length)
+        {
+            out[end - 1] = in[end - 1];
+        }
+        start = end;
+    }
+    return in_size;
+}
+
+static size_t always_fail(void * context, const uint8_t * in, size_t in_size, uint8_t * out, size_t out_capacity)
+{
+    (void)context;
+    (void)in;
+    (void)in_size;
+    (void)out;
+    (void)out_capacity;
+    return SIZE_MAX;
+}
+
+// Writes `size` bytes into a pipe in pieces of random sizes, now and then pausing, then closes it.
+typedef struct feeder_s
+{
+    int fd;
+    const uint8_t * data;
+    size_t size;
+    uint64_t state;
+} feeder_t;
+
+static void * feeder_main(void * argument)
+{
+    feeder_t * feeder = (feeder_t *)argument;
+    for (size_t done = 0; done < feeder->size;)
+    {
+        size_t piece = 1 + (size_t)(test_random(&feeder->state) % 5000);
+        piece = piece < feeder->size - done ? piece : feeder->size - done;
+        ssize_t written = write(feeder->fd, feeder->data + done, piece);
+        if (written <= 0)
+        {
+            break;
+        }
+        done += (size_t)written;
+        if (test_random(&feeder->state) % 16 == 0)
+        {
+            struct timespec pause = {0, 20000};
+            nanosleep(&pause, NULL);
+        }
+    }
+    close(feeder->fd);
+    return NULL;
+}
+
+// Random records: lines of up to MAX_RECORD_SIZE bytes (delimiter included), or any bytes for fixed-size records.
+static void fill(uint8_t * data, size_t size, const format_t * format, uint64_t * state)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        data[i] = (uint8_t)('a' + test_random(state) % 26);
+        if (format->delimiter >= 0 && test_random(state) % (MAX_RECORD_SIZE / 2) == 0)
+        {
+            data[i] = (uint8_t)format->delimiter;
+        }
+    }
+    // No line longer than MAX_RECORD_SIZE.
+    for (size_t i = 0, length = 0; format->delimiter >= 0 && i < size; i++)
+    {
+        length = data[i] == (uint8_t)format->delimiter ? 0 : length + 1;
+        if (length == MAX_RECORD_SIZE)
+        {
+            data[i] = (uint8_t)format->delimiter;
+            length = 0;
+        }
+    }
+}
+
+// The whole contents of the file `fd` refers to.
+static size_t read_back(FILE * file, uint8_t * out, size_t capacity)
+{
+    fflush(file);
+    rewind(file);
+    return fread(out, 1, capacity, file);
+}
+
+static void check_run(uint64_t * state)
+{
+    static uint8_t input[MAX_INPUT_SIZE];
+    static uint8_t expected[MAX_INPUT_SIZE];
+    static uint8_t output[MAX_INPUT_SIZE + 1];
+    format_t format;
+    bool delimited = test_random(state) % 2 == 0;
+    format.delimiter = delimited ? '\n' : -1;
+    format.record_size = delimited ? 1 : 1 + (size_t)(test_random(state) % MAX_RECORD_SIZE);
+    size_t size = (size_t)(test_random(state) % MAX_INPUT_SIZE);
+    fill(input, size, &format, state);
+    CHECK_EQ(reverse_records(&format, input, size, expected, size), size);
+
+    fixed_pipeline_config_t config;
+    fixed_pipeline_config_init(&config, reverse_records, &format);
+    config.chunk_size = MAX_RECORD_SIZE + (size_t)(test_random(state) % 5000);
+    config.out_chunk_size = config.chunk_size;
+    config.record_size = format.record_size;
+    config.delimiter = format.delimiter;
+    config.num_workers = 1 + (unsigned)(test_random(state) % 8);
+    config.queue_depth = 1 + (unsigned)(test_random(state) % 6);
+
+    FILE * out_file = tmpfile();
+    FILE * in_file = NULL;
+    CHECK(out_file != NULL);
+    if (out_file == NULL)
+    {
+        return;
+    }
+    bool from_pipe = test_random(state) % 2 == 0;
+    int in_fd = -1;
+    pthread_t feeder_thread;
+    feeder_t feeder;
+    int fds[2];
+    if (from_pipe && pipe(fds) == 0)
+    {
+        feeder.fd = fds[1];
+        feeder.data = input;
+        feeder.size = size;
+        feeder.state = test_random(state) | 1;
+        in_fd = fds[0];
+        if (pthread_create(&feeder_thread, NULL, feeder_main, &feeder) != 0)
+        {
+            close(fds[0]);
+            close(fds[1]);
+            in_fd = -1;
+        }
+    }
+    else if (!from_pipe)
+    {
+        in_file = tmpfile();
+        if (in_file != NULL && fwrite(input, 1, size, in_file) == size && fflush(in_file) == 0)
+        {
+            rewind(in_file);
+            in_fd = fileno(in_file);
+        }
+    }
+    CHECK(in_fd >= 0);
+    if (in_fd < 0)
+    {
+        fclose(out_file);
+        if (in_file != NULL)
+        {
+            fclose(in_file);
+        }
+        return;
+    }
+
+    fixed_pipeline_stats_t stats;
+    CHECK(fixed_pipeline_run(&config, in_fd, fileno(out_file), &stats));
+    if (from_pipe)
+    {
+        pthread_join(feeder_thread, NULL);
+        close(in_fd);
+    }
+    else
+    {
+        fclose(in_file);
+    }
+    size_t output_size = read_back(out_file, output, sizeof output);
+    fclose(out_file);
+    CHECK_EQ(output_size, size);
+    CHECK(memcmp(output, expected, size) == 0);
+    CHECK_EQ(stats.bytes_read, size);
+    CHECK_EQ(stats.bytes_written, size);
+    CHECK(size == 0 || stats.num_chunks >= (size + config.chunk_size - 1) / config.chunk_size);
+}
+
+// fixed_pipeline_run() on a thread of its own, so a test can wait for it with a timeout.
+typedef struct background_run_s
+{
+    fixed_pipeline_config_t config;
+    int in_fd;
+    int out_fd;
+    int done_fds[2]; // written to when the run returns
+    bool result;
+    int error;
+} background_run_t;
+
+static void * background_run_main(void * argument)
+{
+    background_run_t * run = (background_run_t *)argument;
+    run->result = fixed_pipeline_run(&run->config, run->in_fd, run->out_fd, NULL);
+    run->error = errno;
+    const uint8_t done = 1;
+    ssize_t ignored = write(run->done_fds[1], &done, 1);
+    (void)ignored;
+    return NULL;
+}
+
+// Whether `fd` becomes readable within TIMEOUT_MS.
+static bool wait_readable(int fd)
+{
+    struct pollfd poll_fd;
+    poll_fd.fd = fd;
+    poll_fd.events = POLLIN;
+    return poll(&poll_fd, 1, TIMEOUT_MS) == 1;
+}
+
+// A pipe that sends one line and then goes quiet (but stays open): the line must come out now, and a failing
+// `convert` must stop the run now.
+static void check_quiet_pipe(bool converting_fails)
+{
+    format_t format = {1, '\n'};
+    background_run_t run;
+    fixed_pipeline_config_init(&run.config, converting_fails ? always_fail : reverse_records, &format);
+    run.config.delimiter = '\n';
+    int in_fds[2];
+    int out_fds[2];
+    if (pipe(in_fds) != 0 || pipe(out_fds) != 0 || pipe(run.done_fds) != 0)
+    {
+        test_fail(__FILE__, __LINE__, "pipe()");
+        return;
+    }
+    run.in_fd = in_fds[0];
+    run.out_fd = out_fds[1];
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, background_run_main, &run) != 0)
+    {
+        test_fail(__FILE__, __LINE__, "pthread_create()");
+        return;
+    }
+    CHECK(write(in_fds[1], "abc\n", 4) == 4);
+    if (converting_fails)
+    {
+        CHECK(wait_readable(run.done_fds[0]));
+    }
+    else
+    {
+        char line[8] = {0};
+        CHECK(wait_readable(out_fds[0]) && read(out_fds[0], line, sizeof line) == 4 && memcmp(line, "cba\n", 4) == 0);
+    }
+    // (Ending the input also ends a run that got stuck, so the thread can always be joined.)
+    close(in_fds[1]);
+    pthread_join(thread, NULL);
+    if (converting_fails)
+    {
+        CHECK(!run.result);
+        CHECK_EQ(run.error, ECANCELED);
+    }
+    else
+    {
+        CHECK(run.result);
+    }
+    close(in_fds[0]);
+    close(out_fds[0]);
+    close(out_fds[1]);
+    close(run.done_fds[0]);
+    close(run.done_fds[1]);
+}
+
+static void check_record_too_long(void)
+{
+    format_t format = {1, '\n'};
+    fixed_pipeline_config_t config;
+    fixed_pipeline_config_init(&config, reverse_records, &format);
+    config.delimiter = '\n';
+    config.chunk_size = 16;
+    FILE * in_file = tmpfile();
+    FILE * out_file = tmpfile();
+    if (in_file == NULL || out_file == NULL)
+    {
+        test_fail(__FILE__, __LINE__, "tmpfile()");
+        return;
+    }
+    fputs("short\nthis line is longer than a chunk\n", in_file);
+    fflush(in_file);
+    rewind(in_file);
+    errno = 0;
+    CHECK(!fixed_pipeline_run(&config, fileno(in_file), fileno(out_file), NULL));
+    CHECK_EQ(errno, EINVAL);
+    fclose(in_file);
+    fclose(out_file);
+
+    // Bad configs.
+    fixed_pipeline_config_init(&config, reverse_records, &format);
+    config.record_size = config.chunk_size + 1;
+    errno = 0;
+    CHECK(!fixed_pipeline_run(&config, 0, 1, NULL) && errno == EINVAL);
+    fixed_pipeline_config_init(&config, reverse_records, &format);
+    config.num_workers = FIXED_PIPELINE_MAX_WORKERS + 1;
+    errno = 0;
+    CHECK(!fixed_pipeline_run(&config, 0, 1, NULL) && errno == EINVAL);
+}
+
+int main(void)
+{
+    uint64_t state = 0x9B05688C2B3E6C1FULL;
+    for (int run = 0; run < NUM_RUNS; run++)
+    {
+        check_run(&state);
+    }
+    check_quiet_pipe(false);
+    check_quiet_pipe(true);
+    check_record_too_long();
+    return test_finish("test_pipeline");
+}
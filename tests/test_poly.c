@@ -0,0 +1,241 @@
+/*
+test_poly
+- Checks fixed_poly_eval() against the exact polynomial (of the unquantized coefficients, in long double) for random
+  plans of every degree from 0 to FIXED_POLY_MAX_DEGREE, in Horner and Estrin order, at 0, x_max, and random x in
+  between: an unsaturated result must be within the plan's error_bound (plus the final rounding's 1/2) of it, and a
+  saturated one must be where the exact value is at least that close to the limit. Horner and Estrin results must
+  agree within their two bounds.
+- Checks that fixed_poly_eval_batch() gives exactly fixed_poly_eval()'s results, for every length up to 70.
+- In C++17, checks that fixed_poly_plan() at compile time gives fixed_poly_init()'s plan, and that
+  fixed_poly_eval_static() gives exactly fixed_poly_eval()'s results, for every degree and both orders.
+*/
+
+#include <math.h>
+#include <string.h>
+
+#include "fixed_point_poly.h"
+#include "test.h"
+
+#define MAX_BATCH 70
+#define NUM_PLANS 3000
+
+static const fixed_poly_scheme_t SCHEMES[] = {FIXED_POLY_HORNER, FIXED_POLY_ESTRIN};
+
+// The exact value of the polynomial at x, in units of the output's last bit.
+static long double exact_value(const double * coefficients, uint8_t degree, fixed_point_t x, int8_t out_fraction_bits)
+{
+    long double x_value = (long double)x / FRACTION_DIVISOR;
+    long double value = 0.0L;
+    for (int k = degree; k >= 0; k--)
+    {
+        value = value * x_value + coefficients[k];
+    }
+    return value * ldexpl(1.0L, out_fraction_bits);
+}
+
+// Check a result against the exact value, allowing for the plan's error bound and the final rounding.
+static void check_result(const fixed_poly_t * poly, int32_t result, long double exact)
+{
+    long double tolerance = (long double)poly->error_bound + 0.5L;
+    if (result == INT32_MAX)
+    {
+        CHECK(exact + tolerance >= (long double)INT32_MAX);
+    }
+    else if (result == INT32_MIN)
+    {
+        CHECK(exact - tolerance <= (long double)INT32_MIN);
+    }
+    else if (!(fabsl((long double)result - exact) <= tolerance))
+    {
+        test_fail(__FILE__, __LINE__, "|result - exact| <= error_bound + 0.5");
+    }
+}
+
+// A coefficient scaled for x up to about `x_max`, so the terms are about the same size, or sometimes 0.
+static double random_coefficient(int k, double x_max, uint64_t * state)
+{
+    uint64_t x = test_random(state);
+    if (x % 8 == 0)
+    {
+        return 0.0;
+    }
+    double mantissa = (double)(x >> 11) * 0x1p-52 - 1.0;
+    int exponent = (int)((x >> 3) % 24) - 12;
+    return ldexp(mantissa, exponent) / pow(x_max > 1.0 ? x_max : 1.0, k);
+}
+
+static void check_plans(uint64_t * state)
+{
+    double coefficients[FIXED_POLY_MAX_DEGREE + 1];
+    fixed_point_t points[MAX_BATCH + 1];
+    int32_t expected[MAX_BATCH];
+    int32_t batch[MAX_BATCH + 2];
+    fixed_poly_t plans[2];
+    uint64_t num_valid = 0;
+    uint64_t num_saturated = 0;
+    for (int p = 0; p < NUM_PLANS; p++)
+    {
+        uint8_t degree = (uint8_t)(p % (FIXED_POLY_MAX_DEGREE + 1));
+        uint64_t x = test_random(state);
+        fixed_point_t x_max = x % 16 == 0 ? UINT32_MAX : x % 16 == 1 ? 0 : (fixed_point_t)(x >> 32) >> (x % 32);
+        int8_t out_fraction_bits = (int8_t)((int)(test_random(state) % 36) - 4);
+        for (int k = 0; k <= degree; k++)
+        {
+            coefficients[k] = random_coefficient(k, (double)x_max / FRACTION_DIVISOR, state);
+        }
+        points[0] = 0;
+        points[1] = x_max;
+        for (int i = 2; i < MAX_BATCH; i++)
+        {
+            points[i] = (fixed_point_t)(test_random(state) % ((uint64_t)x_max + 1));
+        }
+
+        for (size_t s = 0; s < 2; s++)
+        {
+            fixed_poly_t * poly = &plans[s];
+            bool valid = fixed_poly_init(poly, coefficients, degree, x_max, out_fraction_bits, SCHEMES[s]);
+            CHECK_EQ(poly->valid, valid);
+            num_valid += valid;
+            for (int i = 0; i < MAX_BATCH; i++)
+            {
+                expected[i] = fixed_poly_eval(poly, points[i]);
+                if (!valid)
+                {
+                    CHECK_EQ(expected[i], 0);
+                    continue;
+                }
+                check_result(poly, expected[i], exact_value(coefficients, degree, points[i], out_fraction_bits));
+                num_saturated += expected[i] == INT32_MAX || expected[i] == INT32_MIN;
+            }
+
+            // The batch, at every length on some plans, and in one go on the rest.
+            size_t first_length = p % 50 == 0 ? 0 : MAX_BATCH;
+            for (size_t n = first_length; n <= MAX_BATCH; n++)
+            {
+                for (size_t offset = 0; offset < 2; offset++)
+                {
+                    batch[offset + n] = (int32_t)0xA5A5A5A5;
+                    fixed_poly_eval_batch(poly, points, batch + offset, n);
+                    CHECK(n == 0 || memcmp(batch + offset, expected, n * sizeof(int32_t)) == 0);
+                    CHECK_EQ((uint32_t)batch[offset + n], 0xA5A5A5A5);
+                }
+            }
+        }
+
+        // Horner and Estrin both round the same exact value.
+        if (plans[0].valid && plans[1].valid)
+        {
+            double tolerance = plans[0].error_bound + plans[1].error_bound + 1.0;
+            for (int i = 0; i < MAX_BATCH; i++)
+            {
+                int32_t horner = fixed_poly_eval(&plans[0], points[i]);
+                int32_t estrin = fixed_poly_eval(&plans[1], points[i]);
+                bool saturated = horner == INT32_MAX || horner == INT32_MIN || estrin == INT32_MAX
+                    || estrin == INT32_MIN;
+                CHECK(saturated || fabs((double)horner - (double)estrin) <= tolerance);
+            }
+        }
+    }
+    // Most plans work, and some results saturate.
+    CHECK(num_valid > NUM_PLANS);
+    CHECK(num_saturated > 0);
+}
+
+static void check_invalid(void)
+{
+    double coefficients[FIXED_POLY_MAX_DEGREE + 2] = {1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0};
+    fixed_poly_t poly;
+    fixed_point_t x = 1 << FRACTION_BITS;
+    int32_t out[3] = {1, 1, 1};
+    CHECK(!fixed_poly_init(&poly, coefficients, FIXED_POLY_MAX_DEGREE + 1, x, 0, FIXED_POLY_HORNER));
+    CHECK_EQ(fixed_poly_eval(&poly, x), 0);
+    coefficients[2] = NAN;
+    CHECK(!fixed_poly_init(&poly, coefficients, 3, x, 0, FIXED_POLY_ESTRIN));
+    coefficients[2] = INFINITY;
+    CHECK(!fixed_poly_init(&poly, coefficients, 3, x, 0, FIXED_POLY_HORNER));
+    fixed_poly_eval_batch(&poly, &x, out, 1);
+    CHECK_EQ(out[0], 0);
+    CHECK_EQ(out[1], 1);
+    // Coefficients so big that even x^0's term can't be stored.
+    coefficients[2] = 3.0;
+    coefficients[0] = 1e200;
+    CHECK(!fixed_poly_init(&poly, coefficients, 3, x, 0, FIXED_POLY_HORNER));
+}
+
+#if defined(__cplusplus) && __cplusplus >= 201703L
+
+// Plans made at compile time, for x up to 4.0, one per degree and order (a template argument has to name an object
+// of its own).
+static constexpr double STATIC_COEFFICIENTS[FIXED_POLY_MAX_DEGREE + 1] = {-3.25, 1.5, -0.125, 0.0625, -0.0078125,
+                                                                          3e-4, -2e-5, 1e-6};
+static constexpr fixed_point_t STATIC_X_MAX = 4u << FRACTION_BITS;
+#define STATIC_PLANS(degree)                                                                                           \
+    static constexpr fixed_poly_t HORNER_##degree = fixed_poly_plan(STATIC_COEFFICIENTS, degree, STATIC_X_MAX, 12,    \
+                                                                    FIXED_POLY_HORNER);                                \
+    static constexpr fixed_poly_t ESTRIN_##degree = fixed_poly_plan(STATIC_COEFFICIENTS, degree, STATIC_X_MAX, 12,    \
+                                                                    FIXED_POLY_ESTRIN);
+STATIC_PLANS(0)
+STATIC_PLANS(1)
+STATIC_PLANS(2)
+STATIC_PLANS(3)
+STATIC_PLANS(4)
+STATIC_PLANS(5)
+STATIC_PLANS(6)
+STATIC_PLANS(7)
+
+template <const fixed_poly_t & Plan>
+static void check_static(uint64_t * state)
+{
+    fixed_poly_t runtime;
+    CHECK(fixed_poly_init(&runtime, STATIC_COEFFICIENTS, Plan.degree, STATIC_X_MAX, Plan.out_fraction_bits,
+                          (fixed_poly_scheme_t)Plan.scheme));
+    CHECK(memcmp(runtime.coefficients, Plan.coefficients, sizeof Plan.coefficients) == 0);
+    CHECK(memcmp(runtime.product_shifts, Plan.product_shifts, sizeof Plan.product_shifts) == 0);
+    CHECK(memcmp(runtime.addend_shifts, Plan.addend_shifts, sizeof Plan.addend_shifts) == 0);
+    CHECK(memcmp(runtime.power_shifts, Plan.power_shifts, sizeof Plan.power_shifts) == 0);
+    CHECK_EQ(runtime.num_levels, Plan.num_levels);
+    CHECK_EQ(runtime.result_shift, Plan.result_shift);
+    CHECK(runtime.error_bound == Plan.error_bound);
+    CHECK_EQ(fixed_poly_eval_static<Plan>(0), fixed_poly_eval(&Plan, 0));
+    CHECK_EQ(fixed_poly_eval_static<Plan>(STATIC_X_MAX), fixed_poly_eval(&Plan, STATIC_X_MAX));
+    for (int i = 0; i < 1000; i++)
+    {
+        fixed_point_t x = (fixed_point_t)(test_random(state) % ((uint64_t)STATIC_X_MAX + 1));
+        int32_t result = fixed_poly_eval_static<Plan>(x);
+        CHECK_EQ(result, fixed_poly_eval(&Plan, x));
+        check_result(&Plan, result, exact_value(STATIC_COEFFICIENTS, Plan.degree, x, Plan.out_fraction_bits));
+    }
+}
+
+static void check_static_plans(uint64_t * state)
+{
+    check_static<HORNER_0>(state);
+    check_static<ESTRIN_0>(state);
+    check_static<HORNER_1>(state);
+    check_static<ESTRIN_1>(state);
+    check_static<HORNER_2>(state);
+    check_static<ESTRIN_2>(state);
+    check_static<HORNER_3>(state);
+    check_static<ESTRIN_3>(state);
+    check_static<HORNER_4>(state);
+    check_static<ESTRIN_4>(state);
+    check_static<HORNER_5>(state);
+    check_static<ESTRIN_5>(state);
+    check_static<HORNER_6>(state);
+    check_static<ESTRIN_6>(state);
+    check_static<HORNER_7>(state);
+    check_static<ESTRIN_7>(state);
+}
+
+#endif // __cplusplus >= 201703L
+
+int main(void)
+{
+    uint64_t state = 0x3C6EF372FE94F82BULL;
+    check_plans(&state);
+    check_invalid();
+#if defined(__cplusplus) && __cplusplus >= 201703L
+    check_static_plans(&state);
+#endif
+    return test_finish("test_poly");
+}
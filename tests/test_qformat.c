@@ -0,0 +1,166 @@
+/*
+test_qformat
+- Checks fixed_point_qformat.h's batch operations, for every number of fraction bits (0 to 31, both the formats with
+  kernels of their own and the generic ones), against reference versions with 64-bit math and division: multiplying
+  rounded half up and saturated, and converting to and from FRACTION_BITS, rounded half up or saturated.
+- Every length up to a few SIMD widths (so every tail is covered), unaligned, and in place, for edge-case and
+  pseudo-random numbers.
+*/
+
+#include <string.h>
+
+#include "fixed_point_qformat.h"
+#include "test.h"
+
+#define MAX_BATCH 70
+#define NUM_ROUNDS 20
+
+// floor(x / 2^shift), for negative x too, without right-shifting a negative number.
+static int64_t floor_div_pow2(int64_t x, int shift)
+{
+    int64_t divisor = (int64_t)1 << shift;
+    return x >= 0 ? x / divisor : -((-x + divisor - 1) / divisor);
+}
+
+static int32_t saturate(int64_t x)
+{
+    return (int32_t)(x < INT32_MIN ? INT32_MIN : x > INT32_MAX ? INT32_MAX : x);
+}
+
+// x with `from` fraction bits, to `to` fraction bits: rounded half up (floor(x + 1/2)), or saturated.
+static int32_t reference_convert(int32_t x, int from, int to)
+{
+    if (from > to)
+    {
+        return (int32_t)floor_div_pow2((int64_t)x + ((int64_t)1 << (from - to - 1)), from - to);
+    }
+    return saturate((int64_t)x * ((int64_t)1 << (to - from)));
+}
+
+static int32_t reference_mul(int32_t a, int32_t b, int bits)
+{
+    int64_t product = (int64_t)a * b;
+    return saturate(bits == 0 ? product : floor_div_pow2(product + ((int64_t)1 << (bits - 1)), bits));
+}
+
+static void check_format(unsigned bits, uint64_t * state)
+{
+    fixed_qformat_t format;
+    CHECK(fixed_qformat_init(&format, bits));
+    CHECK_EQ(format.fraction_bits, bits);
+    CHECK(format.specialized == (bits == 8 || bits == 12 || bits == 15 || bits == 16 || bits == 24 || bits == 31));
+
+    // One element more than the longest batch, so batches can start unaligned.
+    int32_t a[MAX_BATCH + 1];
+    int32_t b[MAX_BATCH + 1];
+    int32_t out[MAX_BATCH + 1];
+    for (int round = 0; round < NUM_ROUNDS; round++)
+    {
+        for (size_t i = 0; i <= MAX_BATCH; i++)
+        {
+            uint64_t x = test_random_bits(state);
+            uint64_t y = test_random_bits(state);
+            // Negative numbers, exact ties, and the extremes too.
+            a[i] = (int32_t)(test_random(state) % 2 == 0 ? x : ~x);
+            b[i] = (int32_t)(test_random(state) % 2 == 0 ? y : ~y);
+            switch (i % 11)
+            {
+                case 1:
+                    a[i] = INT32_MIN;
+                    break;
+                case 2:
+                    a[i] = INT32_MAX;
+                    break;
+                case 3:
+                    // A tie when dropping 16 bits.
+                    a[i] = (int32_t)(((uint32_t)x & ~0xFFFFu) | 0x8000);
+                    break;
+                default:
+                    break;
+            }
+        }
+        for (size_t offset = 0; offset < 2; offset++)
+        {
+            for (size_t n = 0; n + offset <= MAX_BATCH; n++)
+            {
+                const size_t o = offset;
+                // Nothing past the end may be written.
+                memset(out, 0xA5, sizeof out);
+                fixed_qformat_mul_round(&format, out + o, a + o, b + o, n);
+                for (size_t i = o; i < o + n; i++)
+                {
+                    CHECK_EQ(out[i], reference_mul(a[i], b[i], (int)bits));
+                }
+                CHECK_EQ((uint32_t)out[o + n], 0xA5A5A5A5);
+                fixed_qformat_to_fixed(&format, out + o, a + o, n);
+                for (size_t i = o; i < o + n; i++)
+                {
+                    CHECK_EQ(out[i], reference_convert(a[i], (int)bits, FRACTION_BITS));
+                }
+                fixed_qformat_from_fixed(&format, out + o, a + o, n);
+                for (size_t i = o; i < o + n; i++)
+                {
+                    CHECK_EQ(out[i], reference_convert(a[i], FRACTION_BITS, (int)bits));
+                }
+            }
+        }
+
+        // In place, each output overwriting its (first) input.
+        int32_t in_place[MAX_BATCH + 1];
+        memcpy(in_place, a, sizeof a);
+        fixed_qformat_mul_round(&format, in_place, in_place, b, MAX_BATCH);
+        for (size_t i = 0; i < MAX_BATCH; i++)
+        {
+            CHECK_EQ(in_place[i], reference_mul(a[i], b[i], (int)bits));
+        }
+        memcpy(in_place, a, sizeof a);
+        fixed_qformat_to_fixed(&format, in_place, in_place, MAX_BATCH);
+        for (size_t i = 0; i < MAX_BATCH; i++)
+        {
+            CHECK_EQ(in_place[i], reference_convert(a[i], (int)bits, FRACTION_BITS));
+        }
+        memcpy(in_place, a, sizeof a);
+        fixed_qformat_from_fixed(&format, in_place, in_place, MAX_BATCH);
+        for (size_t i = 0; i < MAX_BATCH; i++)
+        {
+            CHECK_EQ(in_place[i], reference_convert(a[i], FRACTION_BITS, (int)bits));
+        }
+    }
+}
+
+int main(void)
+{
+    // A few by hand: ties round up (toward +infinity, also for negative numbers), and saturation.
+    fixed_qformat_t q8;
+    CHECK(fixed_qformat_init(&q8, 8));
+    int32_t a[] = {1, -1, 3, INT32_MIN, INT32_MAX};
+    int32_t b[] = {128, 128, 128, INT32_MIN, 256};
+    int32_t product[5];
+    fixed_qformat_mul_round(&q8, product, a, b, 5);
+    CHECK_EQ(product[0], 1);
+    CHECK_EQ(product[1], 0);
+    CHECK_EQ(product[2], 2);
+    CHECK_EQ(product[3], INT32_MAX);
+    CHECK_EQ(product[4], INT32_MAX);
+    int32_t converted[5];
+    fixed_qformat_from_fixed(&q8, converted, a, 5);
+    CHECK_EQ(converted[0], 0);
+    CHECK_EQ(converted[1], 0);
+    CHECK_EQ(converted[2], 0);
+    CHECK_EQ(converted[3], -(1 << 23));
+    CHECK_EQ(converted[4], 1 << 23);
+    fixed_qformat_to_fixed(&q8, converted, a, 5);
+    CHECK_EQ(converted[0], 256);
+    CHECK_EQ(converted[3], INT32_MIN);
+    CHECK_EQ(converted[4], INT32_MAX);
+
+    uint64_t state = 0x2545F4914F6CDD1DULL;
+    for (unsigned bits = 0; bits <= FIXED_QFORMAT_MAX_FRACTION_BITS; bits++)
+    {
+        check_format(bits, &state);
+    }
+
+    fixed_qformat_t format;
+    CHECK(!fixed_qformat_init(&format, FIXED_QFORMAT_MAX_FRACTION_BITS + 1));
+    return test_finish("test_qformat");
+}
@@ -0,0 +1,275 @@
+/*
+test_quantize
+- Checks fixed_quantize_f32() and fixed_quantize_f64(), in all 3 rounding modes, saturating and not, against a
+  reference that rounds from the exact floor and fraction of each scaled value: on exact ties, +-0, NaN, +-infinity,
+  values around 65536.0 (where results start to clip high), 32768.0 (where the SIMD kernels shift values down by
+  2^31), and -32768.0 (the lowest value that wraps around without saturating), and on random values, for every length
+  up to 70 (so every SIMD tail length) and several blocks' worth.
+- Checks each block's statistics against the same values: min and max compared by value (a SIMD kernel can give
+  -0.0 where the scalar code gives +0.0), the clip counts, and the best fraction bits; and that merging the blocks
+  gives the whole array's.
+- Checks fixed_dequantize_f32() (rounded to the nearest float) and fixed_dequantize_f64() (exact).
+- Built twice on x86 (see CMakeLists.txt): with SSE2, and as test_quantize_scalar without it, since the header
+  promises both give the same results.
+*/
+
+#include <math.h>
+#include <string.h>
+
+#include "fixed_point_quantize.h"
+#include "test.h"
+
+#define MAX_BATCH 70
+#define MAX_VALUES 700
+
+static const fixed_round_mode_t MODES[] = {FIXED_ROUND_HALF_UP, FIXED_ROUND_HALF_EVEN, FIXED_ROUND_TRUNCATE};
+
+// Every edge: ties (a scaled value ending in exactly .5 is a multiple of 2^-17), the edges of clipping high at 65536
+// and low below 0 (and -32768), the 2^31 that the SIMD kernels shift by, and values too big or small for a float.
+static const double SPECIAL[] = {
+    0.0, -0.0, NAN, -NAN, INFINITY, -INFINITY,
+    0x1p-17, 0x3p-17, 0x1p-16, 0x1p-18, -0x1p-17, -0x3p-17, -0x1p-16, -0x1p-18, 0.75, -0.75, 1.5, 2.5, -1.5, -2.5,
+    65536.0, 65536.0 - 0x1p-17, 65536.0 - 0x1p-16, 65536.0 - 0x3p-17, 65536.0 - 0x1p-18, 65536.0 + 0x1p-17, 65537.0,
+    32768.0, 32768.0 - 0x1p-17, 32768.0 + 0x1p-17, 32768.0 - 0x1p-16, 32768.0 + 0x3p-17,
+    -32768.0, -32768.0 + 0x1p-17, -32768.0 - 0x1p-17, -32768.0 + 0x3p-17, -32768.0 - 0x1p-16, -32769.0,
+    1e30, -1e30, 1e-30, -1e-30, 1e300, -1e300, 1e-300,
+};
+
+// A special value, an exact tie, or a random value with more fraction bits than fit.
+static double random_value(uint64_t * state)
+{
+    uint64_t x = test_random(state);
+    switch (x % 4)
+    {
+        case 0:
+            return SPECIAL[(x >> 8) % (sizeof SPECIAL/sizeof SPECIAL[0])];
+        case 1:
+            // (k + 0.5)/65536, for k from -40000*65536 up.
+            return ((double)((int64_t)(x >> 31) - ((int64_t)40000 << 16)) * 2 + 1) * 0x1p-17;
+        case 2:
+            return (double)((int64_t)(x >> 19) - ((int64_t)1 << 43)) * 0x1p-27;
+        default:
+            return (double)(uint32_t)(x >> 32) * 0x1p-16 + (double)((x >> 2) & 0xFF) * 0x1p-24;
+    }
+}
+
+// x*FRACTION_DIVISOR, rounded per `mode` from its exact floor and fraction. NaN and +-infinity stay as they are.
+static double reference_round(double x, fixed_round_mode_t mode)
+{
+    double scaled = x * FRACTION_DIVISOR;
+    if (isnan(scaled) || isinf(scaled))
+    {
+        return scaled;
+    }
+    double whole = floor(scaled);
+    // Exact, and in [0, 1).
+    double fraction = scaled - whole;
+    bool odd = fmod(whole, 2.0) != 0.0;
+    switch (mode)
+    {
+        case FIXED_ROUND_HALF_UP:
+            // Ties away from zero.
+            return whole + (fraction > 0.5 || (fraction == 0.5 && scaled > 0.0));
+        case FIXED_ROUND_HALF_EVEN:
+            return whole + (fraction > 0.5 || (fraction == 0.5 && odd));
+        case FIXED_ROUND_TRUNCATE:
+        default:
+            return whole + (scaled < 0.0 && fraction > 0.0);
+    }
+}
+
+// Check one quantized value, and count whether it clipped low or high, for the statistics.
+static void check_value(double x, fixed_point_t actual, fixed_round_mode_t mode, bool saturate, uint32_t * clipped_low,
+                        uint32_t * clipped_high)
+{
+    double rounded = reference_round(x, mode);
+    bool too_low = isnan(rounded) || rounded < 0.0;
+    bool too_high = rounded > (double)UINT32_MAX;
+    *clipped_low += too_low;
+    *clipped_high += too_high;
+    if (saturate)
+    {
+        CHECK_EQ(actual, too_low ? 0 : too_high ? UINT32_MAX : (fixed_point_t)rounded);
+    }
+    else if (!too_high && !isnan(x) && x >= -32768.0)
+    {
+        // Negative results wrap around.
+        CHECK_EQ(actual, (fixed_point_t)(uint64_t)(int64_t)rounded);
+    }
+}
+
+// The statistics of `n` values (already converted from float, for f32).
+static void check_stats(const double * values, size_t n, const fixed_quantize_stats_t * stats, uint32_t clipped_low,
+                        uint32_t clipped_high)
+{
+    double min = INFINITY;
+    double max = -INFINITY;
+    for (size_t i = 0; i < n; i++)
+    {
+        min = values[i] < min ? values[i] : min;
+        max = values[i] > max ? values[i] : max;
+    }
+    // The most fraction bits that hold `max` (rounded half up) without clipping.
+    unsigned best_fraction_bits = 32;
+    while (best_fraction_bits > 0 && ldexp(max, (int)best_fraction_bits) >= (double)UINT32_MAX + 0.5)
+    {
+        best_fraction_bits--;
+    }
+    CHECK_EQ(stats->count, n);
+    CHECK(stats->min == min);
+    CHECK(stats->max == max);
+    CHECK_EQ(stats->clipped_low, clipped_low);
+    CHECK_EQ(stats->clipped_high, clipped_high);
+    CHECK_EQ(stats->best_fraction_bits, best_fraction_bits);
+}
+
+// Quantize `n` values as doubles and as floats, in every mode, and check the results and each block's statistics.
+static void check_quantize(const double * values, size_t n)
+{
+    static float floats[MAX_VALUES];
+    static double float_values[MAX_VALUES];
+    static fixed_point_t out[MAX_VALUES + 1];
+    static fixed_quantize_stats_t stats[FIXED_QUANTIZE_NUM_BLOCKS(MAX_VALUES) + 1];
+    for (size_t i = 0; i < n; i++)
+    {
+        floats[i] = (float)values[i];
+        float_values[i] = floats[i];
+    }
+    size_t num_blocks = FIXED_QUANTIZE_NUM_BLOCKS(n);
+    for (size_t m = 0; m < sizeof MODES/sizeof MODES[0]; m++)
+    {
+        for (int saturate = 0; saturate < 2; saturate++)
+        {
+            for (int is_f32 = 0; is_f32 < 2; is_f32++)
+            {
+                const double * in = is_f32 ? float_values : values;
+                out[n] = 0xA5A5A5A5;
+                stats[num_blocks].count = 0xA5A5A5A5;
+                if (is_f32)
+                {
+                    fixed_quantize_f32(floats, out, n, MODES[m], saturate, stats);
+                }
+                else
+                {
+                    fixed_quantize_f64(values, out, n, MODES[m], saturate, stats);
+                }
+                CHECK_EQ(out[n], 0xA5A5A5A5);
+                CHECK_EQ(stats[num_blocks].count, 0xA5A5A5A5);
+
+                fixed_quantize_stats_t total;
+                total.count = 0;
+                uint32_t total_clipped_low = 0;
+                uint32_t total_clipped_high = 0;
+                for (size_t b = 0; b < num_blocks; b++)
+                {
+                    size_t start = b * FIXED_QUANTIZE_BLOCK_VALUES;
+                    size_t count = n - start < FIXED_QUANTIZE_BLOCK_VALUES ? n - start : FIXED_QUANTIZE_BLOCK_VALUES;
+                    uint32_t clipped_low = 0;
+                    uint32_t clipped_high = 0;
+                    for (size_t i = start; i < start + count; i++)
+                    {
+                        check_value(in[i], out[i], MODES[m], saturate, &clipped_low, &clipped_high);
+                    }
+                    check_stats(in + start, count, &stats[b], clipped_low, clipped_high);
+                    fixed_quantize_stats_merge(&total, &stats[b]);
+                    total_clipped_low += clipped_low;
+                    total_clipped_high += clipped_high;
+                }
+                if (n > 0)
+                {
+                    check_stats(in, n, &total, total_clipped_low, total_clipped_high);
+                }
+
+                // Without statistics, the same results.
+                static fixed_point_t again[MAX_VALUES];
+                if (is_f32)
+                {
+                    fixed_quantize_f32(floats, again, n, MODES[m], saturate, NULL);
+                }
+                else
+                {
+                    fixed_quantize_f64(values, again, n, MODES[m], saturate, NULL);
+                }
+                CHECK(n == 0 || memcmp(again, out, n * sizeof(fixed_point_t)) == 0);
+            }
+        }
+    }
+}
+
+static void check_dequantize(uint64_t * state)
+{
+    static const fixed_point_t SPECIAL_FIXED[] = {0, 1, 0x7FFF, 0x8000, 0xFFFF, 0x10000, 0x7FFFFFFF, 0x80000000,
+                                                  0x80000001, 0xFFFFFF7F, 0xFFFFFF80, 0xFFFFFF81, UINT32_MAX};
+    fixed_point_t in[MAX_BATCH + 1];
+    float out_f32[MAX_BATCH + 2];
+    double out_f64[MAX_BATCH + 2];
+    for (size_t n = 0; n <= MAX_BATCH; n++)
+    {
+        for (size_t offset = 0; offset < 2; offset++)
+        {
+            for (size_t i = 0; i < n; i++)
+            {
+                uint64_t x = test_random(state);
+                in[i] = x % 3 == 0 ? SPECIAL_FIXED[(x >> 8) % (sizeof SPECIAL_FIXED/sizeof SPECIAL_FIXED[0])]
+                                   : (fixed_point_t)(x >> 32);
+            }
+            out_f32[offset + n] = 12345.0f;
+            out_f64[offset + n] = 12345.0;
+            fixed_dequantize_f32(in, out_f32 + offset, n);
+            fixed_dequantize_f64(in, out_f64 + offset, n);
+            for (size_t i = 0; i < n; i++)
+            {
+                // Dividing by 2^16 in double is exact, so rounding that to float is the nearest float.
+                double exact = (double)in[i] / FRACTION_DIVISOR;
+                CHECK(out_f64[offset + i] == exact);
+                CHECK(out_f32[offset + i] == (float)exact);
+            }
+            CHECK(out_f32[offset + n] == 12345.0f);
+            CHECK(out_f64[offset + n] == 12345.0);
+        }
+    }
+}
+
+int main(void)
+{
+    static double values[MAX_VALUES];
+    uint64_t state = 0xBB67AE8584CAA73BULL;
+
+    // Every special value, in every lane and in the tail.
+    size_t num_special = sizeof SPECIAL/sizeof SPECIAL[0];
+    for (size_t start = 0; start < 8; start++)
+    {
+        for (size_t i = 0; i < num_special + 8; i++)
+        {
+            values[i] = i < start ? 1.0 : SPECIAL[(i - start) % num_special];
+        }
+        check_quantize(values, num_special + start);
+    }
+    // Every length up to MAX_BATCH, then several blocks (the last one partial).
+    for (size_t n = 0; n <= MAX_BATCH; n++)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            values[i] = random_value(&state);
+        }
+        check_quantize(values, n);
+    }
+    static const size_t LONG_LENGTHS[] = {255, 256, 257, 511, 513, MAX_VALUES};
+    for (size_t l = 0; l < sizeof LONG_LENGTHS/sizeof LONG_LENGTHS[0]; l++)
+    {
+        for (size_t i = 0; i < LONG_LENGTHS[l]; i++)
+        {
+            values[i] = random_value(&state);
+        }
+        check_quantize(values, LONG_LENGTHS[l]);
+    }
+    // A block with nothing but NaNs: no min or max.
+    for (size_t i = 0; i < 9; i++)
+    {
+        values[i] = NAN;
+    }
+    check_quantize(values, 9);
+
+    check_dequantize(&state);
+    return test_finish("test_quantize");
+}
@@ -0,0 +1,262 @@
+/*
+test_ratio
+- Checks fixed_point_ratio.h's plans against a reference that computes (value*times + divide/2)/divide in 128 bits
+  (96 are enough), for every width from 1 to 64 and ratios that pick every method: identity, multiply, shift,
+  reciprocal, split plans (whose products can overflow 64 bits), and results that saturate. fixed_ratio_apply32() and
+  fixed_ratio_apply_batch() (every length up to 70, and in place) are checked for 32-bit values too.
+- Checks the plan cache from several threads at once: a cache made for 4 plans, so it grows again and again while
+  the other threads keep looking plans up (lock-free, in tables that are being retired). Every lookup of a key must
+  give the same plan pointer, with the right contents, and every pointer must still be valid (same pointer, same
+  contents) until the cache is destroyed. Run under ASan or TSan to also catch use-after-free and data races.
+*/
+
+#include <pthread.h>
+#include <string.h>
+
+#include "fixed_point_ratio.h"
+#include "test.h"
+
+#define MAX_BATCH 70
+#define NUM_RANDOM_RATIOS 40
+#define NUM_THREADS 4
+#define NUM_KEYS 3000
+#define NUM_HOT_KEYS 16
+
+// (value*times + divide/2)/divide, saturated at `max`. (That's round(value*times/divide) rounded half up, also for an
+// odd `divide`, whose exact quotient can't end in exactly .5.)
+static uint64_t reference_apply(uint64_t value, uint32_t times, uint32_t divide, uint64_t max)
+{
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 result = ((unsigned __int128)value * times + divide/2) / divide;
+    return result > max ? max : (uint64_t)result;
+#else
+    // The 96-bit numerator as 3 32-bit digits, most significant first, then long division by `divide`.
+    uint64_t low = (value & 0xFFFFFFFFu) * times + divide/2;
+    uint64_t high = (value >> 32) * times + (low >> 32);
+    uint64_t digits[3] = {high >> 32, high & 0xFFFFFFFFu, low & 0xFFFFFFFFu};
+    uint64_t quotient[3];
+    uint64_t remainder = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        uint64_t current = remainder << 32 | digits[i];
+        quotient[i] = current / divide;
+        remainder = current % divide;
+    }
+    uint64_t result = quotient[1] << 32 | quotient[2];
+    return quotient[0] != 0 || result > max ? max : result;
+#endif
+}
+
+static void check_plan(uint32_t times, uint32_t divide, uint8_t width, uint64_t * state)
+{
+    fixed_ratio_plan_t plan;
+    CHECK(fixed_ratio_plan_init(&plan, times, divide, width));
+    CHECK(plan.times == times && plan.divide == divide && plan.width == width);
+    // Reduced to lowest terms, with the method to match.
+    CHECK_EQ((uint64_t)plan.reduced_times * divide, (uint64_t)times * plan.reduced_divide);
+    uint32_t a = plan.reduced_times;
+    uint32_t b = plan.reduced_divide;
+    while (b != 0)
+    {
+        uint32_t r = a % b;
+        a = b;
+        b = r;
+    }
+    CHECK_EQ(a, 1);
+    fixed_ratio_method_t method = plan.reduced_times == plan.reduced_divide ? FIXED_RATIO_IDENTITY
+                                  : plan.reduced_divide == 1 ? FIXED_RATIO_MULTIPLY
+                                  : (plan.reduced_divide & (plan.reduced_divide - 1)) == 0 ? FIXED_RATIO_SHIFT
+                                  : FIXED_RATIO_RECIPROCAL;
+    CHECK_EQ(plan.method, method);
+
+    const uint64_t max = width >= 64 ? UINT64_MAX : ((uint64_t)1 << width) - 1;
+    for (int i = 0; i < 200; i++)
+    {
+        uint64_t x = test_random_bits(state);
+        // The extremes, random values, and values near multiples of `divide` (so exact ties come up).
+        uint64_t value = i == 0 ? 0 : i == 1 ? max : i == 2 ? max - 1 : i % 2 == 0 ? x & max
+                       : ((x / divide) * divide + divide/2 + (uint64_t)(i % 3) - 1) & max;
+        CHECK_EQ(fixed_ratio_apply(&plan, value), reference_apply(value, times, divide, UINT64_MAX));
+        if (width <= 32)
+        {
+            CHECK_EQ(fixed_ratio_apply32(&plan, (uint32_t)value),
+                     reference_apply(value, times, divide, UINT32_MAX));
+        }
+    }
+}
+
+static void check_batches(uint32_t times, uint32_t divide, uint64_t * state)
+{
+    fixed_ratio_plan_t plan;
+    CHECK(fixed_ratio_plan_init(&plan, times, divide, 32));
+    // One element more than the longest batch, so batches can start unaligned.
+    fixed_point_t values[MAX_BATCH + 1];
+    fixed_point_t out[MAX_BATCH + 1];
+    for (size_t i = 0; i <= MAX_BATCH; i++)
+    {
+        values[i] = i % 13 == 0 ? UINT32_MAX : (fixed_point_t)test_random_bits(state);
+    }
+    for (size_t offset = 0; offset < 2; offset++)
+    {
+        for (size_t n = 0; n + offset <= MAX_BATCH; n++)
+        {
+            const size_t o = offset;
+            // Nothing past the end may be written.
+            memset(out, 0xA5, sizeof out);
+            fixed_ratio_apply_batch(&plan, out + o, values + o, n);
+            for (size_t i = o; i < o + n; i++)
+            {
+                CHECK_EQ(out[i], reference_apply(values[i], times, divide, UINT32_MAX));
+            }
+            CHECK_EQ(out[o + n], 0xA5A5A5A5);
+        }
+    }
+    fixed_point_t in_place[MAX_BATCH + 1];
+    memcpy(in_place, values, sizeof values);
+    fixed_ratio_apply_batch(&plan, in_place, in_place, MAX_BATCH);
+    for (size_t i = 0; i < MAX_BATCH; i++)
+    {
+        CHECK_EQ(in_place[i], reference_apply(values[i], times, divide, UINT32_MAX));
+    }
+}
+
+// The cache stress test's keys, and the plan pointer each thread got for each one (the first to get one stores it).
+typedef struct cache_key_s
+{
+    uint32_t times;
+    uint32_t divide;
+    uint8_t width;
+} cache_key_t;
+
+static cache_key_t keys[NUM_KEYS];
+static const fixed_ratio_plan_t * plans[NUM_KEYS];
+static fixed_ratio_cache_t * shared_cache;
+
+// The plan must be for `key`, scale like the reference, and be the one every other lookup of `key` got.
+static void check_lookup(size_t k, const fixed_ratio_plan_t * plan)
+{
+    const cache_key_t * key = &keys[k];
+    if (plan == NULL || plan->times != key->times || plan->divide != key->divide || plan->width != key->width)
+    {
+        test_fail(__FILE__, __LINE__, "fixed_ratio_cache_get() gave the key's plan");
+        return;
+    }
+    const uint64_t max = key->width >= 64 ? UINT64_MAX : ((uint64_t)1 << key->width) - 1;
+    CHECK_EQ(fixed_ratio_apply(plan, max), reference_apply(max, key->times, key->divide, UINT64_MAX));
+    const fixed_ratio_plan_t * expected = NULL;
+    if (!__atomic_compare_exchange_n(&plans[k], &expected, plan, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+    {
+        CHECK(expected == plan);
+    }
+}
+
+static void * lookup_thread_main(void * argument)
+{
+    const size_t id = (size_t)(uintptr_t)argument;
+    uint64_t state = 0x6A09E667F3BCC909ULL + id;
+    for (size_t i = 0; i < NUM_KEYS; i++)
+    {
+        // Each thread adds the keys in its own order (so they race to add the same ones), and looks the hot keys
+        // (added first, so they're in every table since) up over and over as the table grows.
+        size_t k = NUM_HOT_KEYS + (i * (2*id + 1) + id * NUM_KEYS / NUM_THREADS) % (NUM_KEYS - NUM_HOT_KEYS);
+        if (i < NUM_KEYS - NUM_HOT_KEYS)
+        {
+            check_lookup(k, fixed_ratio_cache_get(shared_cache, keys[k].times, keys[k].divide, keys[k].width));
+        }
+        size_t hot = (size_t)(test_random(&state) % NUM_HOT_KEYS);
+        check_lookup(hot, fixed_ratio_cache_get(shared_cache, keys[hot].times, keys[hot].divide, keys[hot].width));
+    }
+    return NULL;
+}
+
+static void check_cache(uint64_t * state)
+{
+    for (size_t k = 0; k < NUM_KEYS; k++)
+    {
+        // Distinct keys: the index is in `divide` (and random bits above it).
+        keys[k].times = (uint32_t)test_random_bits(state);
+        keys[k].divide = (uint32_t)(k + 1) | (uint32_t)(test_random(state) << 12);
+        keys[k].width = (uint8_t)(1 + test_random(state) % 64);
+        plans[k] = NULL;
+    }
+    shared_cache = fixed_ratio_cache_create(4);
+    CHECK(shared_cache != NULL);
+    if (shared_cache == NULL)
+    {
+        return;
+    }
+    // The hot keys first, and a copy of one plan, to compare after all the growing.
+    for (size_t k = 0; k < NUM_HOT_KEYS; k++)
+    {
+        check_lookup(k, fixed_ratio_cache_get(shared_cache, keys[k].times, keys[k].divide, keys[k].width));
+    }
+    fixed_ratio_plan_t first;
+    memcpy(&first, plans[0], sizeof first);
+
+    pthread_t threads[NUM_THREADS];
+    bool started[NUM_THREADS];
+    for (size_t t = 0; t < NUM_THREADS; t++)
+    {
+        started[t] = pthread_create(&threads[t], NULL, lookup_thread_main, (void *)(uintptr_t)t) == 0;
+        CHECK(started[t]);
+    }
+    for (size_t t = 0; t < NUM_THREADS; t++)
+    {
+        if (started[t])
+        {
+            pthread_join(threads[t], NULL);
+        }
+    }
+
+    // Every pointer handed out is still the key's plan, unchanged, and is what a lookup gives now.
+    for (size_t k = 0; k < NUM_KEYS; k++)
+    {
+        const fixed_ratio_plan_t * plan = fixed_ratio_cache_get(shared_cache, keys[k].times, keys[k].divide,
+                                                                keys[k].width);
+        CHECK(plans[k] == NULL || plan == plans[k]);
+        check_lookup(k, plan);
+    }
+    const fixed_ratio_plan_t * plan = plans[0];
+    CHECK(plan->reduced_times == first.reduced_times && plan->reduced_divide == first.reduced_divide);
+    CHECK(plan->method == first.method && plan->shift == first.shift && plan->split == first.split);
+    CHECK(plan->split_limit == first.split_limit);
+    CHECK(fixed_ratio_cache_get(shared_cache, 1, 0, 32) == NULL);
+    CHECK(fixed_ratio_cache_get(shared_cache, 1, 1, 65) == NULL);
+    fixed_ratio_cache_destroy(shared_cache);
+}
+
+int main(void)
+{
+    // Every method, splitting, and saturating.
+    static const uint32_t RATIOS[][2] = {
+        {1, 1}, {7, 7}, {0, 3}, {5, 1}, {UINT32_MAX, 1}, {1, 2}, {3, 4}, {5, 1u << 31}, {2, 3}, {1, 3}, {10, 7},
+        {1000, 999}, {999, 1000}, {UINT32_MAX, 3}, {UINT32_MAX, UINT32_MAX - 1}, {UINT32_MAX - 1, UINT32_MAX},
+        {1, UINT32_MAX}, {6, 4}, {1u << 31, 3}, {3, 1u << 31},
+    };
+    uint64_t state = 0xA54FF53A5F1D36F1ULL;
+    for (size_t r = 0; r < sizeof RATIOS/sizeof RATIOS[0] + NUM_RANDOM_RATIOS; r++)
+    {
+        uint32_t times = r < sizeof RATIOS/sizeof RATIOS[0] ? RATIOS[r][0] : (uint32_t)test_random_bits(&state);
+        uint32_t divide = r < sizeof RATIOS/sizeof RATIOS[0] ? RATIOS[r][1] : (uint32_t)test_random_bits(&state);
+        divide = divide == 0 ? 1 : divide;
+        for (uint8_t width = 1; width <= 64; width++)
+        {
+            check_plan(times, divide, width, &state);
+        }
+        check_batches(times, divide, &state);
+    }
+
+    // Bad arguments.
+    fixed_ratio_plan_t plan;
+    CHECK(!fixed_ratio_plan_init(&plan, 1, 0, 32));
+    CHECK(!fixed_ratio_plan_init(&plan, 1, 1, 0));
+    CHECK(!fixed_ratio_plan_init(&plan, 1, 1, 65));
+
+    check_cache(&state);
+
+    // The process-wide cache.
+    const fixed_ratio_plan_t * shared = fixed_ratio_plan_get(3, 7, 32);
+    CHECK(shared != NULL && shared == fixed_ratio_plan_get(3, 7, 32));
+    CHECK(fixed_ratio_plan_get(3, 0, 32) == NULL);
+    return test_finish("test_ratio");
+}
@@ -0,0 +1,310 @@
+/*
+test_requantize
+- Checks fixed_point_requantize.h's round half to even, and its first- and second-order error feedback, against
+  reference versions: plain rounding with 64-bit division, and error feedback done the textbook way (each sample's
+  rounding error fed into the next ones directly, instead of the library's running sums), for every shift, for
+  signed, 16-bit and unsigned output, with saturation.
+- Checks stochastic rounding by what it promises: every output is the input rounded down or up, whole numbers are
+  kept, a constant fraction rounds up about that fraction of the time, and the same seed gives the same stream.
+- Checks that, in every mode, a stream gives the same results in one call as in many calls of any length (which also
+  checks the SIMD kernels against the scalar code), in place too, and across the stochastic generator's 2^32-sample
+  windows.
+*/
+
+#include <string.h>
+
+#include "fixed_point_requantize.h"
+#include "test.h"
+
+#define NUM_SAMPLES 1000
+#define NUM_STREAMS 20
+#define NUM_CONSTANT 65536
+
+typedef enum output_e
+{
+    OUTPUT_I32,
+    OUTPUT_I16,
+    OUTPUT_U32,
+} output_t;
+
+// floor(x / 2^shift), for negative x too, without right-shifting a negative number.
+static int64_t floor_div_pow2(int64_t x, int shift)
+{
+    int64_t divisor = (int64_t)1 << shift;
+    return x >= 0 ? x / divisor : -((-x + divisor - 1) / divisor);
+}
+
+// The input as a number: signed, or (for OUTPUT_U32) unsigned.
+static int64_t input_value(uint32_t bits, output_t output)
+{
+    return output == OUTPUT_U32 ? (int64_t)bits : (int64_t)(int32_t)bits;
+}
+
+static int64_t saturate(int64_t y, int shift, output_t output)
+{
+    int64_t lo = output == OUTPUT_U32 ? 0 : -((int64_t)1 << (31 - shift));
+    int64_t hi = output == OUTPUT_U32 ? ((int64_t)1 << (32 - shift)) - 1 : ((int64_t)1 << (31 - shift)) - 1;
+    if (output == OUTPUT_I16)
+    {
+        lo = lo < INT16_MIN ? INT16_MIN : lo;
+        hi = hi > INT16_MAX ? INT16_MAX : hi;
+    }
+    return y < lo ? lo : y > hi ? hi : y;
+}
+
+// Round half to even, and the error-feedback modes as loops that carry the rounding errors (before saturating) from
+// sample to sample. An error is `rounded * 2^shift - value`, in (-1/2, 1/2] of an output step.
+static void reference(fixed_requantize_mode_t mode, int shift, output_t output, const uint32_t * in, int64_t * out,
+                      size_t n)
+{
+    const int64_t half = (int64_t)1 << (shift - 1);
+    int64_t errors[2] = {0, 0}; // the last sample's error, and the one before it
+    for (size_t i = 0; i < n; i++)
+    {
+        int64_t x = input_value(in[i], output);
+        int64_t y = 0;
+        if (mode == FIXED_REQUANTIZE_HALF_EVEN)
+        {
+            y = floor_div_pow2(x, shift);
+            int64_t fraction = x - y * 2 * half;
+            y += fraction > half || (fraction == half && (y & 1) != 0);
+        }
+        else
+        {
+            // The error filtered by 1 - z^-1, or by (1 - z^-1)^2 = 1 - 2z^-1 + z^-2, is added to the output: so the
+            // past errors are taken away from the input.
+            int64_t v = mode == FIXED_REQUANTIZE_ERROR_FEEDBACK ? x - errors[0] : x - 2*errors[0] + errors[1];
+            y = floor_div_pow2(v + half, shift);
+            errors[1] = errors[0];
+            errors[0] = y * 2 * half - v;
+        }
+        out[i] = saturate(y, shift, output);
+    }
+}
+
+// Requantize `n` samples in one call, for any output.
+static void requantize(fixed_requantize_t * requantize, output_t output, const uint32_t * in, int64_t * out, size_t n)
+{
+    static int32_t out32[NUM_SAMPLES];
+    static int16_t out16[NUM_SAMPLES];
+    switch (output)
+    {
+        case OUTPUT_I32:
+            fixed_requantize_i32(requantize, out32, (const int32_t *)in, n);
+            break;
+        case OUTPUT_I16:
+            fixed_requantize_i16(requantize, out16, (const int32_t *)in, n);
+            break;
+        case OUTPUT_U32:
+            fixed_requantize_u32(requantize, (uint32_t *)out32, in, n);
+            break;
+    }
+    for (size_t i = 0; i < n; i++)
+    {
+        out[i] = output == OUTPUT_I16 ? out16[i] : output == OUTPUT_U32 ? (int64_t)(uint32_t)out32[i] : out32[i];
+    }
+}
+
+static void fill(uint32_t * in, size_t n, int shift, uint64_t * state)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        uint32_t x = (uint32_t)test_random_bits(state);
+        // Some of everything: negative numbers, exact ties, whole numbers, and the extremes.
+        switch (test_random(state) % 8)
+        {
+            case 0:
+                x = ~x;
+                break;
+            case 1:
+                x = (x & ~((1u << shift) - 1)) | (1u << (shift - 1));
+                break;
+            case 2:
+                x &= ~((1u << shift) - 1);
+                break;
+            case 3:
+                x = test_random(state) % 2 == 0 ? 0x80000000u : 0x7FFFFFFFu;
+                break;
+            default:
+                break;
+        }
+        in[i] = x;
+    }
+}
+
+static void check_stream(fixed_requantize_mode_t mode, int shift, output_t output, uint64_t * state)
+{
+    static uint32_t in[NUM_SAMPLES];
+    static int64_t expected[NUM_SAMPLES];
+    static int64_t whole[NUM_SAMPLES];
+    static int64_t pieces[NUM_SAMPLES];
+    fill(in, NUM_SAMPLES, shift, state);
+    uint64_t seed = test_random(state);
+
+    fixed_requantize_t one_call;
+    CHECK(fixed_requantize_init(&one_call, (uint8_t)shift, mode, seed));
+    requantize(&one_call, output, in, whole, NUM_SAMPLES);
+    CHECK_EQ(one_call.position, NUM_SAMPLES);
+    if (mode != FIXED_REQUANTIZE_STOCHASTIC)
+    {
+        reference(mode, shift, output, in, expected, NUM_SAMPLES);
+        for (size_t i = 0; i < NUM_SAMPLES; i++)
+        {
+            CHECK_EQ(whole[i], expected[i]);
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < NUM_SAMPLES; i++)
+        {
+            int64_t x = input_value(in[i], output);
+            int64_t floored = floor_div_pow2(x, shift);
+            bool is_whole = floored * ((int64_t)1 << shift) == x;
+            CHECK(whole[i] == saturate(floored, shift, output)
+                  || (!is_whole && whole[i] == saturate(floored + 1, shift, output)));
+        }
+    }
+
+    // The same stream, in pieces of pseudo-random lengths (some long enough for SIMD, many not).
+    fixed_requantize_t many_calls;
+    CHECK(fixed_requantize_init(&many_calls, (uint8_t)shift, mode, seed));
+    for (size_t start = 0; start < NUM_SAMPLES;)
+    {
+        size_t count = (size_t)(test_random(state) % (test_random(state) % 2 == 0 ? 4 : 40));
+        count = start + count > NUM_SAMPLES ? NUM_SAMPLES - start : count;
+        requantize(&many_calls, output, in + start, pieces + start, count);
+        start += count;
+    }
+    CHECK(memcmp(pieces, whole, sizeof whole) == 0);
+    CHECK_EQ(many_calls.position, one_call.position);
+    CHECK(memcmp(many_calls.sums, one_call.sums, sizeof one_call.sums) == 0);
+    CHECK(memcmp(many_calls.floors, one_call.floors, sizeof one_call.floors) == 0);
+}
+
+// In place, as the header allows.
+static void check_in_place(fixed_requantize_mode_t mode, int shift, uint64_t * state)
+{
+    static uint32_t in[NUM_SAMPLES];
+    static uint32_t out[NUM_SAMPLES];
+    fill(in, NUM_SAMPLES, shift, state);
+    fixed_requantize_t separate;
+    fixed_requantize_t in_place;
+    CHECK(fixed_requantize_init(&separate, (uint8_t)shift, mode, 1));
+    CHECK(fixed_requantize_init(&in_place, (uint8_t)shift, mode, 1));
+    fixed_requantize_u32(&separate, out, in, NUM_SAMPLES);
+    fixed_requantize_u32(&in_place, in, in, NUM_SAMPLES);
+    CHECK(memcmp(in, out, sizeof out) == 0);
+}
+
+// A constant fraction f rounds up with probability f; over NUM_CONSTANT samples, that's within a few standard
+// deviations (at most 128) of f * NUM_CONSTANT. The stream is deterministic, so this can't fail by chance from run to
+// run: only if the random bits are biased.
+static void check_stochastic_bias(int shift, uint64_t * state)
+{
+    static int32_t in[NUM_CONSTANT];
+    static int32_t out[NUM_CONSTANT];
+    uint32_t fraction = (uint32_t)test_random(state) & ((1u << shift) - 1);
+    // Away from the top of the range, so rounding up never saturates.
+    int32_t lo = -(int32_t)(0x80000000u >> shift);
+    int32_t floored = (int32_t)(test_random(state) % 2001) - 1000;
+    floored = floored < lo ? lo : floored > -lo - 2 ? -lo - 2 : floored;
+    int32_t x = (int32_t)((uint32_t)floored << shift | fraction);
+    for (size_t i = 0; i < NUM_CONSTANT; i++)
+    {
+        in[i] = x;
+    }
+    fixed_requantize_t requantize;
+    CHECK(fixed_requantize_init(&requantize, (uint8_t)shift, FIXED_REQUANTIZE_STOCHASTIC, test_random(state)));
+    fixed_requantize_i32(&requantize, out, in, NUM_CONSTANT);
+    int64_t ups = 0;
+    for (size_t i = 0; i < NUM_CONSTANT; i++)
+    {
+        ups += out[i] - floored;
+    }
+    int64_t expected = (int64_t)(((uint64_t)fraction * NUM_CONSTANT) >> shift);
+    CHECK(ups >= expected - 1000 && ups <= expected + 1000);
+}
+
+// Converting across a 2^32-sample window (where the generator's key changes) one sample at a time must match a single
+// call that's split there internally.
+static void check_stochastic_window(void)
+{
+    int32_t in[64];
+    int32_t whole[64];
+    int32_t pieces[64];
+    for (int i = 0; i < 64; i++)
+    {
+        in[i] = i * 0x01234567;
+    }
+    fixed_requantize_t one_call;
+    fixed_requantize_t many_calls;
+    CHECK(fixed_requantize_init(&one_call, 12, FIXED_REQUANTIZE_STOCHASTIC, 42));
+    CHECK(fixed_requantize_init(&many_calls, 12, FIXED_REQUANTIZE_STOCHASTIC, 42));
+    one_call.position = many_calls.position = ((uint64_t)3 << 32) - 21;
+    fixed_requantize_i32(&one_call, whole, in, 64);
+    for (int i = 0; i < 64; i++)
+    {
+        fixed_requantize_i32(&many_calls, pieces + i, in + i, 1);
+    }
+    CHECK(memcmp(whole, pieces, sizeof whole) == 0);
+    CHECK_EQ(one_call.position, ((uint64_t)3 << 32) + 43);
+}
+
+int main(void)
+{
+    // Ties go to even, both ways.
+    fixed_requantize_t requantize;
+    static const int32_t TIES[] = {1 << 7, 3 << 7, -(1 << 7), -(3 << 7), 5 << 7, 0x7FFFFF80};
+    static const int32_t HALF_EVEN[] = {0, 2, 0, -2, 2, 0x7FFFFF};
+    int32_t out[sizeof TIES/sizeof TIES[0]];
+    CHECK(fixed_requantize_init(&requantize, 8, FIXED_REQUANTIZE_HALF_EVEN, 0));
+    fixed_requantize_i32(&requantize, out, TIES, sizeof TIES/sizeof TIES[0]);
+    for (size_t i = 0; i < sizeof TIES/sizeof TIES[0]; i++)
+    {
+        CHECK_EQ(out[i], HALF_EVEN[i]);
+    }
+
+    uint64_t state = 0xE7037ED1A0B428DBULL;
+    static const fixed_requantize_mode_t MODES[] = {FIXED_REQUANTIZE_HALF_EVEN, FIXED_REQUANTIZE_STOCHASTIC,
+                                                    FIXED_REQUANTIZE_ERROR_FEEDBACK, FIXED_REQUANTIZE_NOISE_SHAPE_2};
+    for (size_t m = 0; m < sizeof MODES/sizeof MODES[0]; m++)
+    {
+        for (int shift = 1; shift <= 31; shift++)
+        {
+            for (int stream = 0; stream < NUM_STREAMS; stream++)
+            {
+                check_stream(MODES[m], shift, (output_t)(stream % 3), &state);
+            }
+            check_in_place(MODES[m], shift, &state);
+        }
+    }
+    for (int shift = 1; shift <= 31; shift++)
+    {
+        check_stochastic_bias(shift, &state);
+    }
+    check_stochastic_window();
+
+    // The same seed gives the same stream, and another seed another one.
+    static int32_t in[NUM_SAMPLES];
+    static int32_t first[NUM_SAMPLES];
+    static int32_t again[NUM_SAMPLES];
+    for (size_t i = 0; i < NUM_SAMPLES; i++)
+    {
+        in[i] = (int32_t)(i * 0x9E3779B9u);
+    }
+    for (uint64_t seed = 1; seed <= 2; seed++)
+    {
+        CHECK(fixed_requantize_init(&requantize, 16, FIXED_REQUANTIZE_STOCHASTIC, seed));
+        fixed_requantize_i32(&requantize, seed == 2 ? again : first, in, NUM_SAMPLES);
+    }
+    CHECK(memcmp(first, again, sizeof first) != 0);
+    CHECK(fixed_requantize_init(&requantize, 16, FIXED_REQUANTIZE_STOCHASTIC, 2));
+    fixed_requantize_i32(&requantize, first, in, NUM_SAMPLES);
+    CHECK(memcmp(first, again, sizeof first) == 0);
+
+    // Bad arguments.
+    CHECK(!fixed_requantize_init(&requantize, 0, FIXED_REQUANTIZE_HALF_EVEN, 0));
+    CHECK(!fixed_requantize_init(&requantize, 32, FIXED_REQUANTIZE_HALF_EVEN, 0));
+    CHECK(!fixed_requantize_init(&requantize, 8, (fixed_requantize_mode_t)4, 0));
+    return test_finish("test_requantize");
+}
@@ -0,0 +1,285 @@
+/*
+test_round
+- Checks every rounding division in fixed_point_round.h, and the reciprocal division in fixed_point_div.h, against
+  portable reference versions written here from the definitions (plain `/` and `%`, and no `(a + b/2)/b` shortcut),
+  for edge cases (0, 1, ties, the largest and most negative numbers, INT32_MIN/-1) and for pseudo-random inputs.
+- The fast paths (fixed_div_round_half_up_fast_*(), the reciprocal division, and fixed_div_batch()'s SIMD) must give
+  exactly the same results as the reference versions.
+- Then all the results are hashed into one checksum, which must equal GOLDEN_CHECKSUM on every platform: that's what
+  proves x86-64, AArch64, and 32-bit ARM all round identically. To check another architecture without its hardware,
+  cross-compile with a toolchain file from cmake/toolchains/, and ctest runs this under QEMU user mode.
+*/
+
+#include <stdlib.h>
+
+#include "fixed_point_div.h"
+#include "fixed_point_round.h"
+#include "test.h"
+
+// The FNV-1a hash of every result below, in order. It only changes if the inputs or functions checked change.
+#define GOLDEN_CHECKSUM 0x310040C8E6B57A0BULL
+
+#define NUM_RANDOM 200000
+#define BATCH_SIZE 1000
+
+#define NUM_ELEMENTS(array) (sizeof(array)/sizeof((array)[0]))
+
+static const fixed_round_mode_t MODES[] = {FIXED_ROUND_HALF_UP, FIXED_ROUND_HALF_EVEN, FIXED_ROUND_TRUNCATE};
+
+static uint64_t checksum = 0xCBF29CE484222325ULL; // the FNV-1a offset basis
+
+// Hash all 8 bytes of `x`, least-significant first (so the checksum doesn't depend on the platform's byte order).
+static void hash(uint64_t x)
+{
+    for (int i = 0; i < 8; i++)
+    {
+        checksum ^= (x >> (8*i)) & 0xFF;
+        checksum *= 0x100000001B3ULL; // the FNV-1a prime
+    }
+}
+
+// a/b rounded per `mode`, from the definitions: above half of b rounds up, exactly half of b is a tie (only
+// possible for even b), and below half rounds down.
+static uint64_t reference_div_round_u64(uint64_t a, uint64_t b, fixed_round_mode_t mode)
+{
+    uint64_t quotient = a / b;
+    uint64_t remainder = a % b;
+    int above_half = remainder > b/2;
+    int tie = b % 2 == 0 && remainder == b/2;
+    switch (mode)
+    {
+        case FIXED_ROUND_HALF_UP:
+            return quotient + (above_half || tie);
+        case FIXED_ROUND_HALF_EVEN:
+            return quotient + (above_half || (tie && quotient % 2 == 1));
+        default:
+            return quotient;
+    }
+}
+
+// The signed version: round the magnitudes, then apply the sign. Results that don't fit saturate.
+static int64_t reference_div_round_i64(int64_t a, int64_t b, fixed_round_mode_t mode)
+{
+    uint64_t magnitude_a = a < 0 ? 0 - (uint64_t)a : (uint64_t)a;
+    uint64_t magnitude_b = b < 0 ? 0 - (uint64_t)b : (uint64_t)b;
+    uint64_t magnitude = reference_div_round_u64(magnitude_a, magnitude_b, mode);
+    if ((a < 0) != (b < 0))
+    {
+        return magnitude > (uint64_t)INT64_MAX ? INT64_MIN : -(int64_t)magnitude;
+    }
+    return magnitude > (uint64_t)INT64_MAX ? INT64_MAX : (int64_t)magnitude;
+}
+
+static void check_u32(uint32_t a, uint32_t b)
+{
+    for (size_t m = 0; m < NUM_ELEMENTS(MODES); m++)
+    {
+        uint32_t result = fixed_div_round_u32(a, b, MODES[m]);
+        CHECK_EQ(result, reference_div_round_u64(a, b, MODES[m]));
+        hash(result);
+    }
+    uint32_t fast = fixed_div_round_half_up_fast_u32(a, b);
+    CHECK_EQ(fast, reference_div_round_u64(a, b, FIXED_ROUND_HALF_UP));
+    hash(fast);
+}
+
+static void check_u64(uint64_t a, uint64_t b)
+{
+    for (size_t m = 0; m < NUM_ELEMENTS(MODES); m++)
+    {
+        uint64_t result = fixed_div_round_u64(a, b, MODES[m]);
+        CHECK_EQ(result, reference_div_round_u64(a, b, MODES[m]));
+        hash(result);
+    }
+    uint64_t fast = fixed_div_round_half_up_fast_u64(a, b);
+    CHECK_EQ(fast, reference_div_round_u64(a, b, FIXED_ROUND_HALF_UP));
+    hash(fast);
+}
+
+static void check_i32(int32_t a, int32_t b)
+{
+    for (size_t m = 0; m < NUM_ELEMENTS(MODES); m++)
+    {
+        int32_t result = fixed_div_round_i32(a, b, MODES[m]);
+        int64_t expected = reference_div_round_i64(a, b, MODES[m]);
+        CHECK_EQ(result, expected > INT32_MAX ? INT32_MAX : expected);
+        hash((uint64_t)(int64_t)result);
+    }
+}
+
+static void check_i64(int64_t a, int64_t b)
+{
+    for (size_t m = 0; m < NUM_ELEMENTS(MODES); m++)
+    {
+        int64_t result = fixed_div_round_i64(a, b, MODES[m]);
+        CHECK_EQ(result, reference_div_round_i64(a, b, MODES[m]));
+        hash((uint64_t)result);
+    }
+}
+
+static void check_mul_div(uint32_t a, uint32_t b, uint32_t c)
+{
+    for (size_t m = 0; m < NUM_ELEMENTS(MODES); m++)
+    {
+        uint32_t result = fixed_mul_div_round_u32(a, b, c, MODES[m]);
+        uint64_t expected = reference_div_round_u64((uint64_t)a * b, c, MODES[m]);
+        CHECK_EQ(result, expected > UINT32_MAX ? UINT32_MAX : expected);
+        hash(result);
+    }
+}
+
+// fixed_div() and the reciprocal division, by a fixed-point `b`; and by `b` as a plain integer.
+static void check_recip(fixed_point_t a, fixed_point_t b)
+{
+    fixed_recip_t recip;
+    fixed_recip_init(&recip, b);
+    uint64_t expected = b == 0 ? UINT32_MAX
+                        : reference_div_round_u64((uint64_t)a << FRACTION_BITS, b, FIXED_ROUND_HALF_UP);
+    fixed_point_t result = fixed_div_recip(a, &recip);
+    CHECK_EQ(result, expected > UINT32_MAX ? UINT32_MAX : expected);
+    CHECK_EQ(fixed_div(a, b), result);
+    hash(result);
+
+    result = fixed_div_int_recip(a, &recip);
+    CHECK_EQ(result, b == 0 ? UINT32_MAX : reference_div_round_u64(a, b, FIXED_ROUND_HALF_UP));
+    hash(result);
+}
+
+// The batch versions (SIMD, where available), against the scalar ones.
+static void check_batches(const fixed_point_t * values, fixed_point_t * out, fixed_point_t b)
+{
+    fixed_recip_t recip;
+    fixed_recip_init(&recip, b);
+    fixed_div_batch(out, values, BATCH_SIZE, b);
+    for (size_t i = 0; i < BATCH_SIZE; i++)
+    {
+        CHECK_EQ(out[i], fixed_div_recip(values[i], &recip));
+        hash(out[i]);
+    }
+    fixed_div_int_batch(out, values, BATCH_SIZE, b);
+    for (size_t i = 0; i < BATCH_SIZE; i++)
+    {
+        CHECK_EQ(out[i], fixed_div_int_recip(values[i], &recip));
+        hash(out[i]);
+    }
+}
+
+int main(void)
+{
+    static const uint32_t EDGE_U32[] = {0, 1, 2, 3, 4, 5, 6, 7, 10, 0xFFFF, 0x10000, 0x7FFFFFFF, 0x80000000,
+                                        0x80000001, UINT32_MAX - 2, UINT32_MAX - 1, UINT32_MAX};
+    static const int32_t EDGE_I32[] = {0, 1, -1, 2, -2, 3, -3, 5, -5, 7, -7, INT32_MAX, INT32_MAX - 1,
+                                       INT32_MIN + 1, INT32_MIN};
+    static const uint64_t EDGE_U64[] = {0, 1, 2, 3, 7, UINT32_MAX, (uint64_t)UINT32_MAX + 1, INT64_MAX,
+                                        (uint64_t)INT64_MAX + 1, UINT64_MAX - 2, UINT64_MAX - 1, UINT64_MAX};
+    static const int64_t EDGE_I64[] = {0, 1, -1, 2, -2, 3, -3, 7, -7, INT32_MIN, INT64_MAX, INT64_MAX - 1,
+                                       INT64_MIN + 1, INT64_MIN};
+
+    for (size_t i = 0; i < NUM_ELEMENTS(EDGE_U32); i++)
+    {
+        for (size_t j = 0; j < NUM_ELEMENTS(EDGE_U32); j++)
+        {
+            if (EDGE_U32[j] != 0)
+            {
+                check_u32(EDGE_U32[i], EDGE_U32[j]);
+                check_mul_div(EDGE_U32[i], EDGE_U32[i], EDGE_U32[j]);
+            }
+            check_recip(EDGE_U32[i], EDGE_U32[j]);
+        }
+    }
+    for (size_t i = 0; i < NUM_ELEMENTS(EDGE_I32); i++)
+    {
+        for (size_t j = 0; j < NUM_ELEMENTS(EDGE_I32); j++)
+        {
+            if (EDGE_I32[j] != 0)
+            {
+                check_i32(EDGE_I32[i], EDGE_I32[j]);
+            }
+        }
+    }
+    for (size_t i = 0; i < NUM_ELEMENTS(EDGE_U64); i++)
+    {
+        for (size_t j = 0; j < NUM_ELEMENTS(EDGE_U64); j++)
+        {
+            if (EDGE_U64[j] != 0)
+            {
+                check_u64(EDGE_U64[i], EDGE_U64[j]);
+            }
+        }
+    }
+    for (size_t i = 0; i < NUM_ELEMENTS(EDGE_I64); i++)
+    {
+        for (size_t j = 0; j < NUM_ELEMENTS(EDGE_I64); j++)
+        {
+            if (EDGE_I64[j] != 0)
+            {
+                check_i64(EDGE_I64[i], EDGE_I64[j]);
+            }
+        }
+    }
+    // The most negative numbers divided by -1 are the only results that don't fit, and must saturate.
+    CHECK_EQ(fixed_div_round_i32(INT32_MIN, -1, FIXED_ROUND_HALF_EVEN), INT32_MAX);
+    CHECK_EQ(fixed_div_round_i64(INT64_MIN, -1, FIXED_ROUND_TRUNCATE), INT64_MAX);
+    // Exact ties, by odd and even divisors: 7.5 --> 8 either way, 6.5 --> 7 or 6, and -6.5 --> -7 or -6.
+    CHECK_EQ(fixed_div_round_u32(15, 2, FIXED_ROUND_HALF_UP), 8);
+    CHECK_EQ(fixed_div_round_u32(15, 2, FIXED_ROUND_HALF_EVEN), 8);
+    CHECK_EQ(fixed_div_round_u32(13, 2, FIXED_ROUND_HALF_EVEN), 6);
+    CHECK_EQ(fixed_div_round_i32(-13, 2, FIXED_ROUND_HALF_UP), -7);
+    CHECK_EQ(fixed_div_round_i32(-13, 2, FIXED_ROUND_HALF_EVEN), -6);
+    // 1/3 and 2/3 by an odd divisor, where the tutorial's truncated b/2 was suspected of rounding wrong.
+    CHECK_EQ(fixed_div_round_u32(10, 3, FIXED_ROUND_HALF_UP), 3);
+    CHECK_EQ(fixed_div_round_u32(11, 3, FIXED_ROUND_HALF_UP), 4);
+    // Right at the edge of the fast path: a + b/2 would overflow.
+    CHECK_EQ(fixed_div_round_half_up_fast_u32(UINT32_MAX, 2), 0x80000000);
+    CHECK_EQ(fixed_div_round_half_up_fast_u64(UINT64_MAX, UINT64_MAX - 1), 1);
+
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+    for (int i = 0; i < NUM_RANDOM; i++)
+    {
+        uint64_t a = test_random_bits(&state);
+        uint64_t b = test_random_bits(&state);
+        uint64_t c = test_random_bits(&state);
+        if ((uint32_t)b != 0)
+        {
+            check_u32((uint32_t)a, (uint32_t)b);
+            check_i32((int32_t)(uint32_t)a, (int32_t)(uint32_t)b);
+        }
+        if ((uint32_t)c != 0)
+        {
+            check_mul_div((uint32_t)a, (uint32_t)b, (uint32_t)c);
+        }
+        if (b != 0)
+        {
+            check_u64(a, b);
+            check_i64((int64_t)a, (int64_t)b);
+        }
+        check_recip((fixed_point_t)a, (fixed_point_t)b);
+    }
+
+    fixed_point_t * values = (fixed_point_t *)malloc(BATCH_SIZE * sizeof(fixed_point_t));
+    fixed_point_t * out = (fixed_point_t *)malloc(BATCH_SIZE * sizeof(fixed_point_t));
+    CHECK(values != NULL && out != NULL);
+    if (values != NULL && out != NULL)
+    {
+        for (size_t i = 0; i < BATCH_SIZE; i++)
+        {
+            values[i] = (fixed_point_t)test_random_bits(&state);
+        }
+        static const fixed_point_t DIVISORS[] = {0, 1, 3, 7, 10, 0x8000, 0x10000, 0x18000, 0x30000, 0x7FFFFFFF,
+                                                 UINT32_MAX};
+        for (size_t d = 0; d < NUM_ELEMENTS(DIVISORS); d++)
+        {
+            check_batches(values, out, DIVISORS[d]);
+        }
+    }
+    free(values);
+    free(out);
+
+    if (checksum != GOLDEN_CHECKSUM)
+    {
+        fprintf(stderr, "test_round: checksum %016llx, expected %016llx: this platform rounds differently\n",
+                (unsigned long long)checksum, (unsigned long long)GOLDEN_CHECKSUM);
+        test_fail(__FILE__, __LINE__, "checksum == GOLDEN_CHECKSUM");
+    }
+    return test_finish("test_round");
+}
@@ -0,0 +1,169 @@
+/*
+test_sort
+- Checks fixed_point_sort.h's radix sorts against qsort(): unsigned and signed keys, with and without payloads (whose
+  order among equal keys must be kept: the sorts are stable), on 1 to 8 threads, with the heap and a thread's scratch
+  arena for scratch memory, for sizes from 0 up and for data that makes passes get skipped.
+- Checks fixed_lower_bound() and the Eytzinger search against a textbook binary search, for keys in, between, and
+  outside the sorted numbers.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "fixed_point_sort.h"
+#include "test.h"
+
+#define MAX_N 100000
+
+// A key and its original index, for a reference stable sort with qsort() (which isn't stable itself).
+typedef struct keyed_s
+{
+    int64_t key;
+    uint32_t index;
+} keyed_t;
+
+static int compare_keyed(const void * a, const void * b)
+{
+    const keyed_t * x = (const keyed_t *)a;
+    const keyed_t * y = (const keyed_t *)b;
+    if (x->key != y->key)
+    {
+        return x->key < y->key ? -1 : 1;
+    }
+    return (x->index > y->index) - (x->index < y->index);
+}
+
+static keyed_t reference[MAX_N];
+static fixed_point_t keys[MAX_N];
+static int32_t signed_keys[MAX_N];
+static uint32_t payloads[MAX_N];
+
+// Fill `original` with `n` numbers of the given kind: full-range, few distinct (many equal keys), or small (so the
+// top bytes are all the same, and those passes are skipped).
+static void fill(uint32_t * original, size_t n, int kind, uint64_t * state)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        uint32_t x = (uint32_t)test_random(state);
+        original[i] = kind == 0 ? x : kind == 1 ? x % 7 * 0x01010101u : x & 0xFFFF;
+    }
+}
+
+static void check_sorts(const uint32_t * original, size_t n, unsigned num_threads, fixed_arena_t * scratch)
+{
+    // (Unsigned last, so `keys` is left sorted for check_searches().)
+    for (int is_signed = 1; is_signed >= 0; is_signed--)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            reference[i].key = is_signed ? (int64_t)(int32_t)original[i] : (int64_t)original[i];
+            reference[i].index = (uint32_t)i;
+        }
+        qsort(reference, n, sizeof(keyed_t), compare_keyed);
+
+        for (int with_payloads = 0; with_payloads <= 1; with_payloads++)
+        {
+            for (size_t i = 0; i < n; i++)
+            {
+                keys[i] = original[i];
+                signed_keys[i] = (int32_t)original[i];
+                payloads[i] = (uint32_t)i;
+            }
+            bool ok = is_signed
+                ? with_payloads ? fixed_sort_pairs_signed(signed_keys, payloads, n, num_threads, scratch)
+                                : fixed_sort_signed(signed_keys, n, num_threads, scratch)
+                : with_payloads ? fixed_sort_pairs(keys, payloads, n, num_threads, scratch)
+                                : fixed_sort(keys, n, num_threads, scratch);
+            CHECK(ok);
+            for (size_t i = 0; i < n; i++)
+            {
+                if (is_signed)
+                {
+                    CHECK_EQ(signed_keys[i], reference[i].key);
+                }
+                else
+                {
+                    CHECK_EQ(keys[i], reference[i].key);
+                }
+                if (with_payloads)
+                {
+                    CHECK_EQ(payloads[i], reference[i].index);
+                }
+            }
+        }
+    }
+}
+
+static void check_searches(const fixed_point_t * sorted, size_t n, uint64_t * state)
+{
+    fixed_point_t * tree = (fixed_point_t *)malloc((n + 1) * sizeof(fixed_point_t));
+    size_t * ranks = (size_t *)malloc((n + 1) * sizeof(size_t));
+    if (tree == NULL || ranks == NULL)
+    {
+        test_fail(__FILE__, __LINE__, "malloc()");
+        free(tree);
+        free(ranks);
+        return;
+    }
+    fixed_eytzinger_build(tree, ranks, sorted, n);
+    for (int i = 0; i < 2000; i++)
+    {
+        // Keys that are in the array, just around them, or anywhere at all.
+        fixed_point_t key = (fixed_point_t)test_random(state);
+        if (n > 0 && i % 2 == 0)
+        {
+            key = sorted[test_random(state) % n] + (fixed_point_t)(i % 3) - 1;
+        }
+        key = i == 0 ? 0 : i == 1 ? UINT32_MAX : key;
+        // A textbook binary search.
+        size_t expected = 0;
+        size_t end = n;
+        while (expected < end)
+        {
+            size_t middle = expected + (end - expected)/2;
+            if (sorted[middle] < key)
+            {
+                expected = middle + 1;
+            }
+            else
+            {
+                end = middle;
+            }
+        }
+        CHECK_EQ(fixed_lower_bound(sorted, n, key), expected);
+        size_t node = fixed_eytzinger_lower_bound(tree, n, key);
+        CHECK_EQ(ranks[node], expected);
+        CHECK(node == 0 || tree[node] == sorted[expected]);
+    }
+    free(tree);
+    free(ranks);
+}
+
+int main(void)
+{
+    static uint32_t original[MAX_N];
+    static const size_t SIZES[] = {0, 1, 2, 3, 15, 16, 17, 255, 256, 1000, 4099, MAX_N};
+    static const unsigned THREADS[] = {1, 2, 3, 8};
+    uint64_t state = 0xBF58476D1CE4E5B9ULL;
+    for (size_t s = 0; s < sizeof SIZES/sizeof SIZES[0]; s++)
+    {
+        for (int kind = 0; kind < 3; kind++)
+        {
+            fill(original, SIZES[s], kind, &state);
+            for (size_t t = 0; t < sizeof THREADS/sizeof THREADS[0]; t++)
+            {
+                check_sorts(original, SIZES[s], THREADS[t], t % 2 == 0 ? NULL : fixed_arena_thread());
+            }
+            // `keys` is now sorted, unsigned.
+            check_searches(keys, SIZES[s], &state);
+        }
+    }
+
+    // Bad thread counts leave the array alone.
+    fill(original, 100, 0, &state);
+    memcpy(keys, original, 100 * sizeof(uint32_t));
+    CHECK(!fixed_sort(keys, 100, 0, NULL));
+    CHECK(!fixed_sort(keys, 100, FIXED_SORT_MAX_THREADS + 1, NULL));
+    CHECK(memcmp(keys, original, 100 * sizeof(uint32_t)) == 0);
+    return test_finish("test_sort");
+}
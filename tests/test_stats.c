@@ -0,0 +1,182 @@
+/*
+test_stats
+- Checks fixed_point_stats.h's moments against plain 64-bit integer math (on readings small enough for that to be
+  exact): the mean and variance must be exactly rounded half up, and the standard deviation must be the exactly
+  rounded square root of the exact variance.
+- Checks that merging and threads change nothing: adding readings in one call, in pieces that are then merged, and
+  with 1 to 8 threads must give bit-identical sums.
+- Checks the percentiles (nearest-rank) against a sorted copy, with 1 and several threads, and with the heap and a
+  thread's scratch arena for scratch memory.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "fixed_point_stats.h"
+#include "test.h"
+
+#define NUM_SMALL_SETS 300
+#define MAX_SMALL_SET 1000
+#define BIG_SET (1 << 20)
+
+static int compare_fixed(const void * a, const void * b)
+{
+    fixed_point_t x = *(const fixed_point_t *)a;
+    fixed_point_t y = *(const fixed_point_t *)b;
+    return (x > y) - (x < y);
+}
+
+static bool stats_equal(const fixed_stats_t * a, const fixed_stats_t * b)
+{
+    return a->count == b->count && a->sum[0] == b->sum[0] && a->sum[1] == b->sum[1]
+        && a->sum_squares[0] == b->sum_squares[0] && a->sum_squares[1] == b->sum_squares[1] && a->min == b->min
+        && a->max == b->max;
+}
+
+// Readings under 2^20, at most 1000 of them, so every sum and product below fits in 64 bits.
+static void check_moments(const fixed_point_t * values, uint64_t n)
+{
+    fixed_stats_t stats;
+    fixed_stats_init(&stats);
+    fixed_stats_add(&stats, values, n);
+    uint64_t s1 = 0;
+    uint64_t s2 = 0;
+    fixed_point_t min = UINT32_MAX;
+    fixed_point_t max = 0;
+    for (uint64_t i = 0; i < n; i++)
+    {
+        s1 += values[i];
+        s2 += (uint64_t)values[i] * values[i];
+        min = values[i] < min ? values[i] : min;
+        max = values[i] > max ? values[i] : max;
+    }
+    CHECK_EQ(stats.count, n);
+    CHECK_EQ(stats.sum[0], s1);
+    CHECK_EQ(stats.sum_squares[0], s2);
+    CHECK_EQ(stats.sum[1] | stats.sum_squares[1], 0);
+    CHECK_EQ(stats.min, min);
+    CHECK_EQ(stats.max, max);
+    CHECK_EQ(fixed_stats_mean(&stats), n == 0 ? 0 : (s1 + n/2) / n);
+
+    for (int sample = 0; sample <= 1; sample++)
+    {
+        if (n <= (uint64_t)sample)
+        {
+            CHECK_EQ(fixed_stats_variance(&stats, sample), 0);
+            CHECK_EQ(fixed_stats_stddev(&stats, sample), 0);
+            continue;
+        }
+        // In Q32.32, variance = numerator/denominator.
+        uint64_t numerator = n*s2 - s1*s1;
+        uint64_t denominator = n*(n - (uint64_t)sample);
+        // Q48.16, rounded half up.
+        uint64_t shifted = denominator << FRACTION_BITS;
+        CHECK_EQ(fixed_stats_variance(&stats, sample), (numerator + shifted/2) / shifted);
+        // The Q16.16 standard deviation s is sqrt(variance) rounded half up, so (s - 1/2)^2 <= variance < (s + 1/2)^2:
+        // times 4*denominator, (2s - 1)^2 * denominator <= 4*numerator < (2s + 1)^2 * denominator.
+        uint64_t s = fixed_stats_stddev(&stats, sample);
+        CHECK(s == 0 || (2*s - 1)*(2*s - 1)*denominator <= 4*numerator);
+        CHECK(4*numerator < (2*s + 1)*(2*s + 1)*denominator);
+    }
+}
+
+static void check_percentiles(const fixed_point_t * values, size_t n, fixed_point_t * sorted)
+{
+    static const fixed_point_t PERCENTS[] = {0, 1 << FRACTION_BITS, 25 << FRACTION_BITS, 50 << FRACTION_BITS,
+                                             (fixed_point_t)(99.9 * FRACTION_DIVISOR), 99 << FRACTION_BITS,
+                                             100u << FRACTION_BITS};
+    const size_t num_percents = sizeof PERCENTS/sizeof PERCENTS[0];
+    memcpy(sorted, values, n * sizeof(fixed_point_t));
+    qsort(sorted, n, sizeof(fixed_point_t), compare_fixed);
+
+    static const unsigned THREADS[] = {1, 3, 8};
+    for (size_t t = 0; t < sizeof THREADS/sizeof THREADS[0]; t++)
+    {
+        for (int use_arena = 0; use_arena <= 1; use_arena++)
+        {
+            fixed_point_t out[sizeof PERCENTS/sizeof PERCENTS[0]];
+            CHECK(fixed_stats_percentiles(values, n, PERCENTS, num_percents, out, THREADS[t],
+                                          use_arena ? fixed_arena_thread() : NULL));
+            for (size_t p = 0; p < num_percents; p++)
+            {
+                // Nearest rank: ceil(percent/100 * n), 1-based, but at least 1.
+                uint64_t rank = ((uint64_t)PERCENTS[p] * n + (100u << FRACTION_BITS) - 1) / (100u << FRACTION_BITS);
+                CHECK_EQ(out[p], sorted[rank == 0 ? 0 : rank - 1]);
+            }
+        }
+    }
+}
+
+int main(void)
+{
+    fixed_point_t * values = (fixed_point_t *)malloc(BIG_SET * sizeof(fixed_point_t));
+    fixed_point_t * sorted = (fixed_point_t *)malloc(BIG_SET * sizeof(fixed_point_t));
+    if (values == NULL || sorted == NULL)
+    {
+        test_fail(__FILE__, __LINE__, "malloc()");
+        free(values);
+        free(sorted);
+        return test_finish("test_stats");
+    }
+
+    uint64_t state = 0x94D049BB133111EBULL;
+    for (int set = 0; set < NUM_SMALL_SETS; set++)
+    {
+        size_t n = (size_t)(test_random(&state) % (MAX_SMALL_SET + 1));
+        // Some sets of nearly equal readings, where the variance is tiny and rounding matters most.
+        uint32_t mask = set % 3 == 0 ? 0x3 : (1u << 20) - 1;
+        uint32_t base = (uint32_t)test_random(&state) & ((1u << 19) - 1);
+        for (size_t i = 0; i < n; i++)
+        {
+            values[i] = (base + ((uint32_t)test_random(&state) & mask)) & ((1u << 20) - 1);
+        }
+        check_moments(values, n);
+        if (n > 0)
+        {
+            check_percentiles(values, n, sorted);
+        }
+    }
+
+    // Full-range readings: one call, merged pieces, and threads must all agree exactly.
+    for (size_t i = 0; i < BIG_SET; i++)
+    {
+        values[i] = (fixed_point_t)test_random_bits(&state);
+    }
+    fixed_stats_t whole;
+    fixed_stats_init(&whole);
+    fixed_stats_add(&whole, values, BIG_SET);
+    fixed_stats_t pieces;
+    fixed_stats_init(&pieces);
+    for (size_t start = 0; start < BIG_SET; start += 12345)
+    {
+        fixed_stats_t piece;
+        fixed_stats_init(&piece);
+        fixed_stats_add(&piece, values + start, start + 12345 <= BIG_SET ? 12345 : BIG_SET - start);
+        fixed_stats_merge(&pieces, &piece);
+    }
+    CHECK(stats_equal(&pieces, &whole));
+    for (unsigned threads = 1; threads <= 8; threads++)
+    {
+        fixed_stats_t parallel;
+        fixed_stats_init(&parallel);
+        CHECK(fixed_stats_add_parallel(&parallel, values, BIG_SET, threads));
+        CHECK(stats_equal(&parallel, &whole));
+    }
+    check_percentiles(values, BIG_SET, sorted);
+
+    // Bad arguments.
+    fixed_point_t percent = 50 << FRACTION_BITS;
+    fixed_point_t out = 0;
+    fixed_stats_t unused;
+    fixed_stats_init(&unused);
+    CHECK(!fixed_stats_add_parallel(&unused, values, BIG_SET, 0));
+    CHECK(!fixed_stats_add_parallel(&unused, values, BIG_SET, FIXED_STATS_MAX_THREADS + 1));
+    CHECK(!fixed_stats_percentiles(values, 0, &percent, 1, &out, 1, NULL));
+    CHECK(!fixed_stats_percentiles(values, BIG_SET, &percent, 1, &out, 0, NULL));
+    percent = (100u << FRACTION_BITS) + 1;
+    CHECK(!fixed_stats_percentiles(values, BIG_SET, &percent, 1, &out, 1, NULL));
+
+    free(values);
+    free(sorted);
+    return test_finish("test_stats");
+}
@@ -0,0 +1,222 @@
+/*
+test_time
+- Checks fixed_clock_scale() against a reference that computes round(ticks*to_hz/from_hz) exactly in 128 bits (an
+  `unsigned __int128` where the compiler has one, else long division by hand), for clock pairs that reduce to every
+  kind of ratio: at random tick counts, at max_ticks (which must fit), at max_ticks + 1 (which must not), and at
+  UINT64_MAX. fixed_time_from_ticks() and fixed_time_to_ticks() are checked the same way at random rates.
+- Checks that fixed_tick_rate_init(rate, 10^9) gives FIXED_TICK_RATE_NS, field for field, and that
+  fixed_time_from_ns() and fixed_time_to_ns() give the same results as the generic conversions with it.
+- Built again as test_time_no_int128 (see CMakeLists.txt), where fixed_time_mul_hi_u64() (and the reference) can't
+  use a 128-bit type.
+*/
+
+#include "fixed_point_time.h"
+#include "test.h"
+
+#define NUM_RANDOM 20000
+
+// round(ticks*times/divide), rounded half up, for `times` and `divide` up to 2^32. Returns false (and UINT64_MAX) if
+// that doesn't fit in 64 bits.
+static bool reference_scale(uint64_t ticks, uint64_t times, uint64_t divide, uint64_t * result)
+{
+#if defined(__SIZEOF_INT128__)
+    __extension__ typedef unsigned __int128 uint128_type;
+    uint128_type exact = ((uint128_type)ticks * times + divide / 2) / divide;
+    *result = exact >> 64 != 0 ? UINT64_MAX : (uint64_t)exact;
+    return exact >> 64 == 0;
+#else
+    // The product as 4 32-bit digits, least significant first, from the 4 products of 32-bit halves.
+    uint64_t digits[5] = {0};
+    uint64_t halves_a[2] = {ticks & 0xFFFFFFFFu, ticks >> 32};
+    uint64_t halves_b[2] = {times & 0xFFFFFFFFu, times >> 32};
+    for (int i = 0; i < 2; i++)
+    {
+        for (int j = 0; j < 2; j++)
+        {
+            uint64_t product = halves_a[i] * halves_b[j];
+            digits[i + j] += product & 0xFFFFFFFFu;
+            digits[i + j + 1] += product >> 32;
+        }
+    }
+    digits[0] += divide / 2;
+    for (int i = 0; i < 4; i++)
+    {
+        digits[i + 1] += digits[i] >> 32;
+        digits[i] &= 0xFFFFFFFFu;
+    }
+    // Long division, most significant digit first. The remainder is less than `divide`, so under 2^32.
+    uint64_t quotient[4];
+    uint64_t remainder = 0;
+    for (int i = 3; i >= 0; i--)
+    {
+        uint64_t current = remainder << 32 | digits[i];
+        quotient[i] = current / divide;
+        remainder = current % divide;
+    }
+    bool fits = quotient[3] == 0 && quotient[2] == 0;
+    *result = fits ? quotient[1] << 32 | quotient[0] : UINT64_MAX;
+    return fits;
+#endif
+}
+
+static uint64_t greatest_common_divisor(uint64_t a, uint64_t b)
+{
+    while (b != 0)
+    {
+        uint64_t remainder = a % b;
+        a = b;
+        b = remainder;
+    }
+    return a;
+}
+
+// A random number of random bit length, so that small and large counts are both common.
+static uint64_t random_ticks(uint64_t * state)
+{
+    unsigned bits = (unsigned)(test_random(state) % 64);
+    return test_random(state) >> bits;
+}
+
+static void check_scale_at(const fixed_clock_scaler_t * scaler, uint64_t ticks)
+{
+    uint64_t expected;
+    reference_scale(ticks, scaler->times, scaler->divide, &expected);
+    CHECK_EQ(fixed_clock_scale(scaler, ticks), expected);
+}
+
+static void check_scaler(uint64_t from_hz, uint64_t to_hz, uint64_t * state)
+{
+    fixed_clock_scaler_t scaler;
+    uint64_t gcd = greatest_common_divisor(from_hz, to_hz);
+    bool reducible = to_hz / gcd <= UINT32_MAX && from_hz / gcd <= UINT32_MAX;
+    CHECK_EQ(fixed_clock_scaler_init(&scaler, from_hz, to_hz), reducible);
+    if (!reducible)
+    {
+        return;
+    }
+    CHECK_EQ(scaler.times, to_hz / gcd);
+    CHECK_EQ(scaler.divide, from_hz / gcd);
+
+    // max_ticks is the last count whose result fits.
+    uint64_t result;
+    CHECK(reference_scale(scaler.max_ticks, scaler.times, scaler.divide, &result));
+    if (scaler.max_ticks < UINT64_MAX)
+    {
+        CHECK(!reference_scale(scaler.max_ticks + 1, scaler.times, scaler.divide, &result));
+        CHECK_EQ(fixed_clock_scale(&scaler, scaler.max_ticks + 1), UINT64_MAX);
+    }
+    check_scale_at(&scaler, scaler.max_ticks);
+    check_scale_at(&scaler, scaler.max_ticks - 1);
+    check_scale_at(&scaler, UINT64_MAX);
+    check_scale_at(&scaler, 0);
+    check_scale_at(&scaler, 1);
+    for (int i = 0; i < 200; i++)
+    {
+        uint64_t ticks = random_ticks(state);
+        check_scale_at(&scaler, ticks);
+        // Monotonic.
+        CHECK(ticks == UINT64_MAX || fixed_clock_scale(&scaler, ticks) <= fixed_clock_scale(&scaler, ticks + 1));
+    }
+}
+
+static void check_scalers(uint64_t * state)
+{
+    // Common clocks: 1 Hz, a 32.768 kHz crystal, 19.2 and 24 MHz timers, 1 GHz (ns), 3 GHz cycles, 2^32 (Q32.32 s).
+    static const uint64_t CLOCKS[] = {1, 32768, 19200000, 24000000, 1000000000, 3000000000u, (uint64_t)1 << 32};
+    size_t num_clocks = sizeof CLOCKS/sizeof CLOCKS[0];
+    for (size_t from = 0; from < num_clocks; from++)
+    {
+        for (size_t to = 0; to < num_clocks; to++)
+        {
+            check_scaler(CLOCKS[from], CLOCKS[to], state);
+        }
+    }
+    for (int i = 0; i < 100; i++)
+    {
+        // Random 32-bit rates; 64-bit rates with a large common factor (reducible); and plain 64-bit ones (mostly not).
+        uint64_t from_hz = 1 + (uint64_t)(uint32_t)test_random(state);
+        uint64_t to_hz = 1 + (uint64_t)(uint32_t)test_random(state);
+        check_scaler(from_hz, to_hz, state);
+        uint64_t factor = 1 + (uint64_t)(uint32_t)test_random(state);
+        check_scaler((from_hz >> (i % 32 + 1)) * factor + factor, (to_hz >> (i % 32 + 1)) * factor + factor, state);
+        check_scaler(test_random(state) | 1, test_random(state) | 1, state);
+    }
+
+    fixed_clock_scaler_t scaler;
+    CHECK(!fixed_clock_scaler_init(&scaler, 0, 1000));
+    CHECK(!fixed_clock_scaler_init(&scaler, 1000, 0));
+}
+
+static void check_tick_rates(uint64_t * state)
+{
+    fixed_tick_rate_t rate;
+    CHECK(!fixed_tick_rate_init(&rate, 0));
+    for (int i = 0; i < 300; i++)
+    {
+        uint32_t hz = i == 0 ? 1 : i == 1 ? UINT32_MAX : 1 + (uint32_t)(test_random(state) % UINT32_MAX);
+        CHECK(fixed_tick_rate_init(&rate, hz));
+        uint64_t expected;
+        reference_scale(rate.to_time.max_ticks, FIXED_TIME_ONE_SECOND, hz, &expected);
+        CHECK_EQ(fixed_time_from_ticks(rate.to_time.max_ticks, &rate), expected);
+        // (2^32/hz > 1, so some count always saturates.)
+        CHECK_EQ(fixed_time_from_ticks(rate.to_time.max_ticks + 1, &rate), FIXED_TIME_MAX);
+        CHECK_EQ(fixed_time_from_ticks(UINT64_MAX, &rate), FIXED_TIME_MAX);
+        for (int j = 0; j < 50; j++)
+        {
+            uint64_t ticks = random_ticks(state);
+            reference_scale(ticks, FIXED_TIME_ONE_SECOND, hz, &expected);
+            CHECK_EQ(fixed_time_from_ticks(ticks, &rate), expected);
+            fixed_time_t time = random_ticks(state);
+            reference_scale(time, hz, FIXED_TIME_ONE_SECOND, &expected);
+            CHECK_EQ(fixed_time_to_ticks(time, &rate), expected);
+        }
+        reference_scale(FIXED_TIME_MAX, hz, FIXED_TIME_ONE_SECOND, &expected);
+        CHECK_EQ(fixed_time_to_ticks(FIXED_TIME_MAX, &rate), expected);
+    }
+}
+
+static void check_ns(uint64_t * state)
+{
+    fixed_tick_rate_t rate;
+    CHECK(fixed_tick_rate_init(&rate, FIXED_TIME_NS_PER_SECOND));
+    CHECK_EQ(rate.hz, FIXED_TICK_RATE_NS.hz);
+    CHECK_EQ(rate.to_time.from_hz, FIXED_TICK_RATE_NS.to_time.from_hz);
+    CHECK_EQ(rate.to_time.to_hz, FIXED_TICK_RATE_NS.to_time.to_hz);
+    CHECK_EQ(rate.to_time.times, FIXED_TICK_RATE_NS.to_time.times);
+    CHECK_EQ(rate.to_time.divide, FIXED_TICK_RATE_NS.to_time.divide);
+    CHECK_EQ(rate.to_time.whole, FIXED_TICK_RATE_NS.to_time.whole);
+    CHECK_EQ(rate.to_time.fraction, FIXED_TICK_RATE_NS.to_time.fraction);
+    CHECK_EQ(rate.to_time.max_ticks, FIXED_TICK_RATE_NS.to_time.max_ticks);
+
+    // The last ns under 2^32 s, the first at it (which saturates), and the ends of the range.
+    static const uint64_t EDGES[] = {0, 1, 499999999, 500000000, 999999999, 1000000000, 4294967295999999999ull,
+                                     4294967296000000000ull, UINT64_MAX};
+    for (size_t i = 0; i < sizeof EDGES/sizeof EDGES[0]; i++)
+    {
+        CHECK_EQ(fixed_time_from_ns(EDGES[i]), fixed_time_from_ticks(EDGES[i], &FIXED_TICK_RATE_NS));
+        CHECK_EQ(fixed_time_to_ns(EDGES[i]), fixed_time_to_ticks(EDGES[i], &FIXED_TICK_RATE_NS));
+    }
+    CHECK_EQ(fixed_time_from_ns(4294967296000000000ull), FIXED_TIME_MAX);
+    for (int i = 0; i < NUM_RANDOM; i++)
+    {
+        uint64_t ns = random_ticks(state);
+        fixed_time_t time = fixed_time_from_ns(ns);
+        CHECK_EQ(time, fixed_time_from_ticks(ns, &FIXED_TICK_RATE_NS));
+        // A Q32.32 second is finer than a ns, so a time from ns converts back to the same ns.
+        if (time != FIXED_TIME_MAX)
+        {
+            CHECK_EQ(fixed_time_to_ns(time), ns);
+        }
+        time = random_ticks(state);
+        CHECK_EQ(fixed_time_to_ns(time), fixed_time_to_ticks(time, &FIXED_TICK_RATE_NS));
+    }
+}
+
+int main(void)
+{
+    uint64_t state = 0x6A09E667F3BCC908ULL;
+    check_scalers(&state);
+    check_tick_rates(&state);
+    check_ns(&state);
+    return test_finish("test_time");
+}
@@ -0,0 +1,325 @@
+/*
+test_tune
+- Checks fixed_point_tune.h's scalers, for ratios from 0/1 to UINT32_MAX/1 and 1/UINT32_MAX and pseudo-random ones,
+  and widths from 1 to 64 bits: every strategy fixed_scale_strategy_exact() calls exact must set up and give the
+  results of a reference with 96-bit long division (rounded half up, saturated), for every batch length up to a few
+  SIMD widths, unaligned, and in place; every other strategy must fail to set up.
+- Checks that the tuner picks an exact strategy, and FIXED_SCALE_PLAN for invalid ratios.
+- Checks the cache file: lines written by hand (with unknown names, and with bad lines around them) are followed,
+  batch sizes are rounded up to a power of 2, and what one tuner tunes and saves, another one reads.
+*/
+
+// For mkstemp() and close() when compiling with -std=c99.
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "fixed_point_tune.h"
+#include "test.h"
+
+#define MAX_BATCH 70
+#define NUM_RANDOM_RATIOS 20
+
+// The SIMD level this test was compiled for, as fixed_point_tune.c puts it in cache file lines.
+#if defined(__AVX2__)
+#define SIMD_LEVEL "avx2"
+#elif defined(__SSE2__)
+#define SIMD_LEVEL "sse2"
+#else
+#define SIMD_LEVEL "none"
+#endif
+
+// round(value*times/divide), rounded half up, saturated at `max`: the 96-bit product divided 32 bits at a time.
+static uint64_t reference_scale(uint64_t value, uint32_t times, uint32_t divide, uint64_t max)
+{
+    uint64_t low = (value & 0xFFFFFFFFu) * times;
+    uint64_t high = (value >> 32) * times + (low >> 32);
+    uint64_t digits[3] = {high >> 32, high & 0xFFFFFFFFu, low & 0xFFFFFFFFu};
+    uint64_t quotient[3];
+    uint64_t remainder = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        uint64_t current = remainder << 32 | digits[i];
+        quotient[i] = current / divide;
+        remainder = current % divide;
+    }
+    if (quotient[0] != 0)
+    {
+        return max;
+    }
+    uint64_t result = quotient[1] << 32 | quotient[2];
+    if (2 * remainder >= divide)
+    {
+        if (result == UINT64_MAX)
+        {
+            return max;
+        }
+        result++;
+    }
+    return result > max ? max : result;
+}
+
+static void check_scaler(const fixed_scaler_t * scaler, uint32_t times, uint32_t divide, uint8_t width,
+                         uint64_t * state)
+{
+    const uint64_t max = width >= 64 ? UINT64_MAX : ((uint64_t)1 << width) - 1;
+    // One element more than the longest batch, so batches can start unaligned.
+    uint64_t values[MAX_BATCH + 1];
+    uint64_t out[MAX_BATCH + 1];
+    fixed_point_t values32[MAX_BATCH + 1];
+    fixed_point_t out32[MAX_BATCH + 1];
+    for (size_t i = 0; i <= MAX_BATCH; i++)
+    {
+        uint64_t x = i % 3 == 0 ? test_random(state) : test_random_bits(state);
+        values[i] = i % 17 == 0 ? 0 : i % 17 == 1 ? max : i % 17 == 2 ? max - 1 : x & max;
+        values32[i] = (fixed_point_t)values[i];
+    }
+    for (size_t offset = 0; offset < 2; offset++)
+    {
+        for (size_t n = 0; n + offset <= MAX_BATCH; n++)
+        {
+            const size_t o = offset;
+            // Nothing past the end may be written.
+            memset(out, 0xA5, sizeof out);
+            fixed_scaler_apply_batch64(scaler, out + o, values + o, n);
+            for (size_t i = o; i < o + n; i++)
+            {
+                CHECK_EQ(out[i], reference_scale(values[i], times, divide, UINT64_MAX));
+            }
+            CHECK_EQ(out[o + n], 0xA5A5A5A5A5A5A5A5ULL);
+            if (width <= 32)
+            {
+                memset(out32, 0xA5, sizeof out32);
+                fixed_scaler_apply_batch(scaler, out32 + o, values32 + o, n);
+                for (size_t i = o; i < o + n; i++)
+                {
+                    CHECK_EQ(out32[i], reference_scale(values32[i], times, divide, UINT32_MAX));
+                }
+                CHECK_EQ(out32[o + n], 0xA5A5A5A5);
+            }
+        }
+    }
+
+    // In place.
+    uint64_t in_place[MAX_BATCH + 1];
+    memcpy(in_place, values, sizeof values);
+    fixed_scaler_apply_batch64(scaler, in_place, in_place, MAX_BATCH);
+    for (size_t i = 0; i < MAX_BATCH; i++)
+    {
+        CHECK_EQ(in_place[i], reference_scale(values[i], times, divide, UINT64_MAX));
+    }
+    if (width <= 32)
+    {
+        fixed_point_t in_place32[MAX_BATCH + 1];
+        memcpy(in_place32, values32, sizeof values32);
+        fixed_scaler_apply_batch(scaler, in_place32, in_place32, MAX_BATCH);
+        for (size_t i = 0; i < MAX_BATCH; i++)
+        {
+            CHECK_EQ(in_place32[i], reference_scale(values32[i], times, divide, UINT32_MAX));
+        }
+    }
+}
+
+static void check_ratio(uint32_t times, uint32_t divide, fixed_arena_t * arena, uint64_t * state)
+{
+    static const uint8_t WIDTHS[] = {1, 7, 8, 16, 17, 24, 31, 32, 33, 40, 52, 53, 63, 64};
+    for (size_t w = 0; w < sizeof WIDTHS/sizeof WIDTHS[0]; w++)
+    {
+        const uint8_t width = WIDTHS[w];
+        fixed_ratio_plan_t plan;
+        CHECK(fixed_ratio_plan_init(&plan, times, divide, width));
+        for (int s = 0; s < FIXED_SCALE_NUM_STRATEGIES; s++)
+        {
+            const fixed_scale_strategy_t strategy = (fixed_scale_strategy_t)s;
+            const bool exact = fixed_scale_strategy_exact(strategy, &plan);
+            if (strategy == FIXED_SCALE_PLAN || (strategy == FIXED_SCALE_LUT && width <= 32))
+            {
+                CHECK(exact);
+            }
+            if (strategy == FIXED_SCALE_LUT && width > 32)
+            {
+                CHECK(!exact);
+            }
+            fixed_scaler_t scaler;
+            fixed_arena_t * from = s % 2 == 0 ? NULL : arena;
+            bool ok = fixed_scaler_init(&scaler, times, divide, width, strategy, from);
+            CHECK_EQ(ok, exact);
+            if (ok)
+            {
+                CHECK_EQ(scaler.strategy, strategy);
+                check_scaler(&scaler, times, divide, width, state);
+                if (from == NULL)
+                {
+                    fixed_scaler_free(&scaler);
+                }
+            }
+        }
+    }
+    fixed_arena_reset(arena);
+}
+
+// The cache file's line for `width` and `batch_size` (without the newline), or false if it has none.
+static bool find_line(const char * path, const char * cpu_model, unsigned width, unsigned batch_size, char * line,
+                      size_t line_size)
+{
+    char prefix[128];
+    snprintf(prefix, sizeof prefix, "%s\t%s\t%u\t%u\t", cpu_model, SIMD_LEVEL, width, batch_size);
+    FILE * file = fopen(path, "r");
+    bool found = false;
+    while (file != NULL && !found && fgets(line, (int)line_size, file) != NULL)
+    {
+        found = strncmp(line, prefix, strlen(prefix)) == 0;
+    }
+    if (file != NULL)
+    {
+        fclose(file);
+    }
+    if (found)
+    {
+        line[strcspn(line, "\r\n")] = '\0';
+    }
+    return found;
+}
+
+static void check_cache_file(void)
+{
+    char path[] = "/tmp/test_tune.XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0)
+    {
+        test_fail(__FILE__, __LINE__, "mkstemp()");
+        return;
+    }
+    close(fd);
+    fixed_tuner_t * tuner = fixed_tuner_open(path);
+    CHECK(tuner != NULL);
+    if (tuner == NULL)
+    {
+        remove(path);
+        return;
+    }
+    // The rankings for this machine, by hand (then opened again, so the tuner reads them), among lines to skip.
+    const char * model = fixed_tuner_cpu_model(tuner);
+    FILE * file = fopen(path, "w");
+    CHECK(file != NULL);
+    if (file != NULL)
+    {
+        fprintf(file, "# a comment\nnot a cache line\n");
+        fprintf(file, "%s\t%s\t16\t1000\tdivide\n", model, SIMD_LEVEL);
+        fprintf(file, "%s\t%s\t0\t64\tdivide\n", model, SIMD_LEVEL);
+        fprintf(file, "%s\t%s\t16\t64\tnewer,lut,lut,plan\n", model, SIMD_LEVEL);
+        fprintf(file, "%s\t%s\t28\t64\tint128,double,plan\n", model, SIMD_LEVEL);
+        fprintf(file, "%s\t%s\t24\t64\tnewer\n", model, SIMD_LEVEL);
+        fclose(file);
+    }
+    fixed_tuner_close(tuner);
+    tuner = fixed_tuner_open(path);
+    CHECK(tuner != NULL);
+    if (tuner == NULL)
+    {
+        remove(path);
+        return;
+    }
+    // (The old tuner's copy of the model went with it.)
+    model = fixed_tuner_cpu_model(tuner);
+
+    // A batch of 50 rounds up to 64. The first exact one listed wins; INT128 isn't for 28 bits, DOUBLE may not be.
+    CHECK_EQ(fixed_tuner_pick(tuner, 3, 7, 16, 50), FIXED_SCALE_LUT);
+    fixed_ratio_plan_t plan;
+    CHECK(fixed_ratio_plan_init(&plan, 3, 7, 28));
+    CHECK_EQ(fixed_tuner_pick(tuner, 3, 7, 28, 64),
+             fixed_scale_strategy_exact(FIXED_SCALE_DOUBLE, &plan) ? FIXED_SCALE_DOUBLE : FIXED_SCALE_PLAN);
+    CHECK_EQ(fixed_tuner_pick(tuner, UINT32_MAX, 2, 28, 64), FIXED_SCALE_PLAN);
+
+    // The 24-bit line has no known strategies, so this tunes, and saves.
+    fixed_scale_strategy_t tuned = fixed_tuner_pick(tuner, 3, 7, 24, 64);
+    char line[512];
+    CHECK(find_line(path, model, 24, 64, line, sizeof line));
+    // Every strategy exact for 3/7 is listed (all but INT128, which isn't for 24 bits); the pick is the first.
+    const char * names = strrchr(line, '\t') + 1;
+    const char * name = fixed_scale_strategy_name(tuned);
+    CHECK(strncmp(names, name, strlen(name)) == 0 && (names[strlen(name)] == ',' || names[strlen(name)] == '\0'));
+    CHECK(strstr(names, "plan") != NULL && strstr(names, "divide") != NULL && strstr(names, "lut") != NULL);
+    CHECK(strstr(names, "int128") == NULL);
+    // The hand-written lines were kept (cleaned up), and the bad ones dropped.
+    CHECK(find_line(path, model, 16, 64, line, sizeof line) && strcmp(strrchr(line, '\t') + 1, "lut,plan") == 0);
+    CHECK(find_line(path, model, 28, 64, line, sizeof line));
+    CHECK(!find_line(path, model, 16, 1000, line, sizeof line));
+    CHECK(!find_line(path, model, 0, 64, line, sizeof line));
+
+    // Another tuner reads the ranking instead of tuning again.
+    fixed_tuner_t * other = fixed_tuner_open(path);
+    CHECK(other != NULL);
+    if (other != NULL)
+    {
+        CHECK_EQ(fixed_tuner_pick(other, 3, 7, 24, 33), tuned);
+        CHECK_EQ(fixed_tuner_pick(other, 3, 7, 16, 64), FIXED_SCALE_LUT);
+        CHECK(fixed_tuner_save(other));
+        fixed_tuner_close(other);
+    }
+    fixed_tuner_close(tuner);
+    remove(path);
+}
+
+int main(void)
+{
+    // Names, as in the cache file.
+    static const char * const NAMES[] = {"plan", "divide", "lut", "double", "int128"};
+    for (int s = 0; s < FIXED_SCALE_NUM_STRATEGIES; s++)
+    {
+        CHECK(strcmp(fixed_scale_strategy_name((fixed_scale_strategy_t)s), NAMES[s]) == 0);
+    }
+    CHECK(fixed_scale_strategy_name(FIXED_SCALE_NUM_STRATEGIES) == NULL);
+
+    static const uint32_t RATIOS[][2] = {
+        {1, 1}, {0, 5}, {3, 2}, {2, 3}, {7, 10}, {1000, 1}, {1, 1000}, {65536, 1}, {1, 65536}, {1000000007, 3},
+        {UINT32_MAX, 1}, {1, UINT32_MAX}, {UINT32_MAX, UINT32_MAX - 1}, {UINT32_MAX - 1, UINT32_MAX},
+    };
+    uint64_t state = 0x510E527FADE682D1ULL;
+    fixed_arena_t arena;
+    CHECK(fixed_arena_init(&arena, 1 << 20));
+    for (size_t r = 0; r < sizeof RATIOS/sizeof RATIOS[0]; r++)
+    {
+        check_ratio(RATIOS[r][0], RATIOS[r][1], &arena, &state);
+    }
+    for (int r = 0; r < NUM_RANDOM_RATIOS; r++)
+    {
+        uint32_t times = (uint32_t)test_random_bits(&state);
+        uint32_t divide = (uint32_t)test_random_bits(&state);
+        check_ratio(times, divide == 0 ? 1 : divide, &arena, &state);
+    }
+
+    // Bad ratios and widths.
+    fixed_scaler_t scaler;
+    CHECK(!fixed_scaler_init(&scaler, 1, 0, 32, FIXED_SCALE_PLAN, NULL));
+    CHECK(!fixed_scaler_init(&scaler, 1, 1, 0, FIXED_SCALE_PLAN, NULL));
+    CHECK(!fixed_scaler_init(&scaler, 1, 1, 65, FIXED_SCALE_PLAN, NULL));
+    CHECK(!fixed_scaler_init(&scaler, 1, 1, 32, FIXED_SCALE_NUM_STRATEGIES, NULL));
+
+    // A tuner without a cache file.
+    fixed_tuner_t * tuner = fixed_tuner_open(NULL);
+    CHECK(tuner != NULL);
+    if (tuner != NULL)
+    {
+        const char * model = fixed_tuner_cpu_model(tuner);
+        CHECK(model[0] != '\0' && strchr(model, '\t') == NULL);
+        CHECK_EQ(fixed_tuner_pick(tuner, 1, 0, 32, 256), FIXED_SCALE_PLAN);
+        CHECK_EQ(fixed_tuner_pick(tuner, 1, 1, 0, 256), FIXED_SCALE_PLAN);
+        fixed_ratio_plan_t plan;
+        CHECK(fixed_ratio_plan_init(&plan, 3, 7, 32));
+        fixed_scale_strategy_t picked = fixed_tuner_pick(tuner, 3, 7, 32, 256);
+        CHECK(fixed_scale_strategy_exact(picked, &plan));
+        CHECK_EQ(fixed_tuner_pick(tuner, 3, 7, 32, 200), picked);
+        CHECK(!fixed_tuner_save(tuner));
+        CHECK(fixed_tuner_scaler_init(tuner, &scaler, 3, 7, 32, 256, &arena));
+        CHECK_EQ(scaler.strategy, picked);
+        check_scaler(&scaler, 3, 7, 32, &state);
+        fixed_tuner_close(tuner);
+    }
+    fixed_arena_free(&arena);
+
+    check_cache_file();
+    return test_finish("test_tune");
+}